@@ -73,6 +73,9 @@ protected:
     };
 
 public:
+    /// @brief Extension buffer ID in the form of FourCC code available at compile time.
+    static constexpr uint32_t buffer_ID = ID;
+
     /// @brief Default ctor
     template <
         typename check = typename std::enable_if<is_extension_buffer::value, mfxExtBuffer>::type>
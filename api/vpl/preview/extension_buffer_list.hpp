@@ -6,8 +6,11 @@
 
 #pragma once
 
+#include <array>
 #include <exception>
 #include <map>
+#include <tuple>
+#include <utility>
 #include <vector>
 
 #include "vpl/preview/extension_buffer.hpp"
@@ -168,6 +171,11 @@ public:
         ctor_helper();
     }
 
+    /// @brief Compile-time check that all given extension buffer classes are allowed in this list.
+    /// @tparam BuffersT List of extension buffer classes.
+    template <typename... BuffersT>
+    using accepts = AllBuffers<BuffersT*...>;
+
     /// @brief Variadic length ctor.
     /// This ctor accepts list of pointers to the extension buffers of pre-defined type:
     /// ExtDecVideoProcessing,
@@ -243,6 +251,11 @@ public:
         ctor_helper();
     }
 
+    /// @brief Compile-time check that all given extension buffer classes are allowed in this list.
+    /// @tparam BuffersT List of extension buffer classes.
+    template <typename... BuffersT>
+    using accepts = AllBuffers<BuffersT*...>;
+
     /// @brief Variadic length ctor.
     /// This ctor accepts list of pointers to the extension buffers of pre-defined type:
     /// ExtCodingOptionSPSPPS
@@ -304,6 +317,11 @@ public:
         ctor_helper();
     }
 
+    /// @brief Compile-time check that all given extension buffer classes are allowed in this list.
+    /// @tparam BuffersT List of extension buffer classes.
+    template <typename... BuffersT>
+    using accepts = AllBuffers<BuffersT*...>;
+
     /// @brief Variadic length ctor.
     /// This ctor accepts list of pointers to the extension buffers of pre-defined type:
     /// ExtDecodeErrorReport
@@ -391,6 +409,11 @@ public:
         ctor_helper();
     }
 
+    /// @brief Compile-time check that all given extension buffer classes are allowed in this list.
+    /// @tparam BuffersT List of extension buffer classes.
+    template <typename... BuffersT>
+    using accepts = AllBuffers<BuffersT*...>;
+
     /// @brief Variadic length ctor.
     /// This ctor accepts list of pointers to the extension buffers of pre-defined type:
     /// ExtCodingOption,
@@ -544,6 +567,11 @@ public:
         ctor_helper();
     }
 
+    /// @brief Compile-time check that all given extension buffer classes are allowed in this list.
+    /// @tparam BuffersT List of extension buffer classes.
+    template <typename... BuffersT>
+    using accepts = AllBuffers<BuffersT*...>;
+
     /// @brief Variadic length ctor.
     /// This ctor accepts list of pointers to the extension buffers of pre-defined type:
     /// ExtCodingOption,
@@ -696,6 +724,11 @@ public:
         ctor_helper();
     }
 
+    /// @brief Compile-time check that all given extension buffer classes are allowed in this list.
+    /// @tparam BuffersT List of extension buffer classes.
+    template <typename... BuffersT>
+    using accepts = AllBuffers<BuffersT*...>;
+
     /// @brief Variadic length ctor.
     /// This ctor accepts list of pointers to the extension buffers of pre-defined type:
     /// ExtCodingOption2,
@@ -836,6 +869,11 @@ public:
         ctor_helper();
     }
 
+    /// @brief Compile-time check that all given extension buffer classes are allowed in this list.
+    /// @tparam BuffersT List of extension buffer classes.
+    template <typename... BuffersT>
+    using accepts = AllBuffers<BuffersT*...>;
+
     /// @brief Variadic length ctor.
     /// This ctor accepts list of pointers to the extension buffers of pre-defined type:
     /// ExtVPPDoNotUse,
@@ -946,6 +984,11 @@ public:
         ctor_helper();
     }
 
+    /// @brief Compile-time check that all given extension buffer classes are allowed in this list.
+    /// @tparam BuffersT List of extension buffer classes.
+    template <typename... BuffersT>
+    using accepts = AllBuffers<BuffersT*...>;
+
     /// @brief Variadic length ctor.
     /// This ctor accepts list of pointers to the extension buffers of pre-defined type:
     /// ExtVppAuxData,
@@ -993,5 +1036,113 @@ protected:
         ctor_helper(Opts...);
     }
 };
+
+/// @brief Verifies that extension buffer with given ID is not attached to the ExtParam array.
+/// @param[in] ID extension buffer ID in the form of FourCC code.
+/// @return true if buffer with such ID is in the ignore list.
+constexpr bool is_ignored_ID(uint32_t ID) {
+    for (auto ignore_id : ignore_ID_list) {
+        if (ignore_id == ID)
+            return true;
+    }
+    return false;
+}
+
+/// @brief Compile-time list of extension buffers.
+/// Buffer pointers are stored as a tuple and the array of pointers to the raw extension buffers is built once
+/// during construction, so attaching this list to the Init/Reset/process calls doesn't allocate memory.
+/// A single occurance of the same extension buffer is possible. The list doesn't own the buffers.
+/// @tparam BuffersT extension buffer classes.
+template <typename... BuffersT>
+class static_ext_buffer_list {
+    /// @brief Verifies that all buffers in the list have different IDs.
+    /// @return true if all IDs are unique.
+    static constexpr bool unique_IDs() {
+        constexpr uint32_t ids[] = { BuffersT::buffer_ID..., 0 };
+        for (std::size_t i = 0; i < sizeof...(BuffersT); i++) {
+            for (std::size_t j = i + 1; j < sizeof...(BuffersT); j++) {
+                if (ids[i] == ids[j])
+                    return false;
+            }
+        }
+        return true;
+    }
+
+public:
+    /// @brief Number of buffers attached to the ExtParam array. Buffers from the ignore list are excluded.
+    static constexpr std::size_t raw_size =
+        (std::size_t(0) + ... + (is_ignored_ID(BuffersT::buffer_ID) ? 0 : 1));
+
+    /// @brief ctor
+    /// @param[in] buffers List of pointers to the extension buffers
+    explicit static_ext_buffer_list(BuffersT*... buffers) : extBuffers_(buffers...), mfxBuffers_() {
+        static_assert(unique_IDs(), "Extension buffer with the same ID can't be added twice");
+        [[maybe_unused]] std::size_t i = 0;
+        ((is_ignored_ID(BuffersT::buffer_ID) ? void() : void(mfxBuffers_[i++] = buffers->get_base_ptr())),
+         ...);
+    }
+
+    /// @brief Reurns number of extension buffers in the list.
+    /// @return Number of extension buffers in the list.
+    static constexpr std::size_t get_size() {
+        return sizeof...(BuffersT);
+    }
+
+    /// @brief verifies that list contains given extension buffer
+    /// @tparam ID extension buffer ID in the form of FourCC code.
+    /// @return true if buffer exists in the list.
+    template <uint32_t ID>
+    static constexpr bool has_buffer() {
+        return ((BuffersT::buffer_ID == ID) || ...);
+    }
+
+    /// @brief returns extension buffer of given type and ID.
+    /// @tparam T extension buffer C structure.
+    /// @tparam ID extension buffer ID in the form of FourCC code.
+    /// @return pointer to the extension buffer or nullptr if that buffer isn't in the list
+    template <typename T, uint32_t ID>
+    T* get_buffer() {
+        if constexpr (has_buffer<ID>()) {
+            return reinterpret_cast<T*>(std::get<index_of<ID>()>(extBuffers_)->get_base_ptr());
+        }
+        else {
+            return nullptr;
+        }
+    }
+
+    /// @brief returns extension buffer object of given class.
+    /// @tparam T extension buffer class.
+    /// @return pointer to the extension buffer object
+    template <typename T>
+    T* get() {
+        return std::get<T*>(extBuffers_);
+    }
+
+    /// @brief returns pair of array of pointers to the extension buffer and number of buffers
+    /// @return pair of array of pointers to the extension buffer and number of buffers
+    std::pair<mfxExtBuffer**, std::size_t> get_raw_ext_buffers() {
+        return std::pair(raw_size ? mfxBuffers_.data() : nullptr, raw_size);
+    }
+
+protected:
+    /// @brief Returns position of the buffer with given ID in the tuple.
+    /// @tparam ID extension buffer ID in the form of FourCC code.
+    /// @return Index of the buffer or number of buffers if buffer isn't in the list.
+    template <uint32_t ID>
+    static constexpr std::size_t index_of() {
+        constexpr uint32_t ids[] = { BuffersT::buffer_ID..., 0 };
+        for (std::size_t i = 0; i < sizeof...(BuffersT); i++) {
+            if (ids[i] == ID)
+                return i;
+        }
+        return sizeof...(BuffersT);
+    }
+
+    /// Tuple of pointers to the extension buffers.
+    std::tuple<BuffersT*...> extBuffers_;
+    /// Array of pointers to the raw extension buffers.
+    std::array<mfxExtBuffer*, raw_size> mfxBuffers_;
+};
+
 } // namespace vpl
 } // namespace oneapi
@@ -10,6 +10,7 @@
 #include <string>
 #include <utility>
 #include <memory>
+#include <vector>
 
 #include "vpl/mfxstructures.h"
 
@@ -27,7 +28,7 @@ namespace vpl {
 class frame_surface : public std::enable_shared_from_this<frame_surface> {
 public:
     /// @brief Default dtor
-    frame_surface() : surface_(nullptr), lazy_sync_(false) {}
+    frame_surface() : surface_(nullptr), lazy_sync_(false), persistent_map_(false), mapped_flags_(0) {}
 
     /// @brief Creates object on top of mfxFrameSurface1 object.
     /// Increments mfxFrameSurface1 reference counter value.
@@ -36,7 +37,9 @@ public:
     /// @todo Remove flag with API 2.1 support
     explicit frame_surface(mfxFrameSurface1* surface, bool lazy_sync = false)
             : surface_(surface),
-              lazy_sync_(lazy_sync) {
+              lazy_sync_(lazy_sync),
+              persistent_map_(false),
+              mapped_flags_(0) {
         detail::c_api_invoker(detail::default_checker,
                                 surface_->FrameInterface->AddRef,
                                 surface_);
@@ -44,10 +47,13 @@ public:
 
     /// @brief Copy ctor.
     /// Increments mfxFrameSurface1 reference counter value.
+    /// The copy doesn't share the mapping kept by the persistently mapped surface and has persistent mapping disabled.
     /// @param[in] other another object to use as data source
     frame_surface(const frame_surface& other) {
-        surface_   = other.surface_;
-        lazy_sync_ = other.lazy_sync_;
+        surface_        = other.surface_;
+        lazy_sync_      = other.lazy_sync_;
+        persistent_map_ = false;
+        mapped_flags_   = 0;
         detail::c_api_invoker(detail::default_checker,
                                 surface_->FrameInterface->AddRef,
                                 surface_);
@@ -57,17 +63,23 @@ public:
     /// mfxFrameSurface1 reference counter value isn't incremented
     /// @param[in] other another object to use as data source
     frame_surface(frame_surface&& other) {
-        lazy_sync_ = other.lazy_sync_;
-        surface_   = std::move(other.surface_);
+        lazy_sync_      = other.lazy_sync_;
+        persistent_map_ = other.persistent_map_;
+        mapped_flags_   = other.mapped_flags_;
+        surface_        = std::move(other.surface_);
+        other.mapped_flags_ = 0;
     }
 
     /// @brief Copy operator.
     /// Increments mfxFrameSurface1 reference counter value.
+    /// Releases the mapping kept by this object and disables persistent mapping, as the copy ctor does.
     /// @param[in] other another object to use as data source
     /// @returns Reference to this object
     frame_surface& operator=(const frame_surface& other) {
-        surface_   = other.surface_;
-        lazy_sync_ = other.lazy_sync_;
+        flush_mapping();
+        surface_        = other.surface_;
+        lazy_sync_      = other.lazy_sync_;
+        persistent_map_ = false;
         detail::c_api_invoker(detail::default_checker,
                                 surface_->FrameInterface->AddRef,
                                 surface_);
@@ -89,6 +101,7 @@ public:
         }
 
         if (surface_) {
+            flush_mapping();
             detail::c_api_invoker(detail::default_checker,
                                     surface_->FrameInterface->Release,
                                     surface_);
@@ -192,11 +205,7 @@ public:
     /// @param flags Data access flag: read or write.
     /// @return Pair of pointers to the surface info structure and surface data strucuture in the system memory
     auto map(memory_access flags) {
-        wait();
-        detail::c_api_invoker(detail::default_checker,
-                                surface_->FrameInterface->Map,
-                                surface_,
-                                (mfxMemoryFlags)flags);
+        map_impl(flags, true);
         return std::pair(frame_info(surface_->Info), frame_data(surface_->Data));
     }
 
@@ -204,19 +213,55 @@ public:
     /// @param flags Data access flag: read or write.
     /// @return Pointers to the surface data strucuture in the system memory
     auto map_data(memory_access flags) {
-        wait();
-        detail::c_api_invoker(detail::default_checker,
-                                surface_->FrameInterface->Map,
-                                surface_,
-                                (mfxMemoryFlags)flags);
+        map_impl(flags, true);
         return frame_data(surface_->Data);
     }
 
     /// @brief Unmaps data to the system memory.
+    /// For the persistently mapped surface the mapping is kept while the surface is exclusively owned.
     void unmap() {
+        // a mapping made before persistent mapping was enabled isn't recorded and is released at once
+        if (persistent_map_ && mapped_flags_) {
+            if (is_exclusive())
+                return;
+            mapped_flags_ = 0;
+        }
         detail::c_api_invoker(detail::default_checker, surface_->FrameInterface->Unmap, surface_);
     }
 
+    /// @brief Enables or disables persistent mapping. Persistently mapped system memory surface stays mapped after
+    /// unmap() call while this object is the only owner of the surface, so subsequent map() calls with the same or
+    /// narrower access flags skip the Map/Unmap round-trip to the runtime.
+    /// @param[in] persistent Persistent mapping flag.
+    void set_persistent_mapping(bool persistent) {
+        if (!persistent)
+            flush_mapping();
+        persistent_map_ = persistent;
+    }
+
+    /// @brief Returns persistent mapping flag.
+    /// @return True if persistent mapping is enabled.
+    bool is_persistent_mapping() const {
+        return persistent_map_;
+    }
+
+    /// @brief Returns access flags of the mapping kept by the persistently mapped surface.
+    /// @return Access flags or 0 if the surface isn't mapped.
+    uint32_t get_mapped_flags() const {
+        return mapped_flags_;
+    }
+
+    /// @brief Releases the mapping kept by the persistently mapped surface. Must be called before the surface is
+    /// handed over to the runtime.
+    void flush_mapping() {
+        if (mapped_flags_) {
+            mapped_flags_ = 0;
+            detail::c_api_invoker(detail::default_checker,
+                                    surface_->FrameInterface->Unmap,
+                                    surface_);
+        }
+    }
+
     /// @brief Provides native surface handle of the surface.
     /// @return Pair of native surface handle and its type
     auto get_native_handle() {
@@ -287,13 +332,134 @@ public:
     /// @return Reference to the stream.
     friend std::ostream& operator<<(std::ostream& out, const frame_surface& f);
 
+    friend class frame_surface_mapping;
+
 protected:
+    /// @brief Checks that the persistent mapping can be kept: surface is in the system memory and this object is the
+    /// only owner of it.
+    /// @return True if mapping can be kept.
+    bool is_exclusive() {
+        return (surface_->Data.MemType & MFX_MEMTYPE_SYSTEM_MEMORY) && get_ref_counter() == 1;
+    }
+
+    /// @brief Maps data to the system memory or reuses the mapping kept by the persistently mapped surface.
+    /// @param[in] flags Data access flag: read or write.
+    /// @param[in] sync Wait for the operation completion before mapping.
+    void map_impl(memory_access flags, bool sync) {
+        uint32_t access = (uint32_t)flags;
+        if (mapped_flags_) {
+            if ((mapped_flags_ & access) == access && is_exclusive())
+                return;
+            flush_mapping();
+        }
+        if (sync)
+            wait();
+        detail::c_api_invoker(detail::default_checker,
+                                surface_->FrameInterface->Map,
+                                surface_,
+                                (mfxMemoryFlags)flags);
+        if (persistent_map_)
+            mapped_flags_ = access;
+    }
+
     /// @brief Pointer to the mfxFrameSurface1 object.
     mfxFrameSurface1* surface_;
     /// @brief Flag indicating that lazy sync technique must be used.
     bool lazy_sync_;
+    /// @brief Flag indicating that mapping is kept between map/unmap calls.
+    bool persistent_map_;
+    /// @brief Access flags of the mapping kept by the persistently mapped surface.
+    uint32_t mapped_flags_;
+};
+
+/// @brief Scoped mapping of the surface data to the system memory. Surface is mapped during construction and
+/// unmapped during destruction, so single mapping can be used across several operations with the data.
+class frame_surface_mapping {
+public:
+    /// @brief Maps surface data to the system memory.
+    /// @param[in] surface Surface to map.
+    /// @param[in] flags Data access flag: read or write.
+    /// @param[in] sync Wait for the operation completion before mapping.
+    frame_surface_mapping(std::shared_ptr<frame_surface> surface,
+                          memory_access flags,
+                          bool sync = true)
+            : surface_(surface) {
+        surface_->map_impl(flags, sync);
+    }
+
+    /// @brief Move ctor.
+    /// @param[in] other another object to use as data source
+    frame_surface_mapping(frame_surface_mapping&& other) = default;
+
+    /// @brief Move operator.
+    /// @param[in] other another object to use as data source
+    /// @returns Reference to this object
+    frame_surface_mapping& operator=(frame_surface_mapping&& other) {
+        if (&other != this) {
+            release();
+            surface_ = std::move(other.surface_);
+        }
+        return *this;
+    }
+
+    frame_surface_mapping(const frame_surface_mapping& other) = delete;
+    frame_surface_mapping& operator=(const frame_surface_mapping& other) = delete;
+
+    /// @brief Dtor. Unmaps surface data.
+    ~frame_surface_mapping() {
+        release();
+    }
+
+    /// @brief Provide frame information.
+    /// @return Return instance of frame_info class
+    frame_info info() const {
+        return frame_info(surface_->surface_->Info);
+    }
+
+    /// @brief Provide mapped frame data.
+    /// @return Return instance of frame_data class
+    frame_data data() const {
+        return frame_data(surface_->surface_->Data);
+    }
+
+    /// @brief Provides mapped surface.
+    /// @return Shared pointer to the surface.
+    std::shared_ptr<frame_surface> surface() const {
+        return surface_;
+    }
+
+protected:
+    /// @brief Unmaps surface data.
+    void release() {
+        if (surface_) {
+            surface_->unmap();
+            surface_.reset();
+        }
+    }
+
+    /// @brief Mapped surface.
+    std::shared_ptr<frame_surface> surface_;
 };
 
+/// @brief Maps several surfaces to the system memory. All surfaces are synchronized before the first one is mapped.
+/// @param[in] surfaces Surfaces to map.
+/// @param[in] flags Data access flag: read or write.
+/// @return Vector of scoped mappings in the same order as surfaces.
+inline std::vector<frame_surface_mapping> map_all(
+    const std::vector<std::shared_ptr<frame_surface>>& surfaces,
+    memory_access flags) {
+    std::vector<frame_surface_mapping> mappings;
+    mappings.reserve(surfaces.size());
+
+    for (auto& surface : surfaces) {
+        surface->wait();
+    }
+    for (auto& surface : surfaces) {
+        mappings.emplace_back(surface, flags, false);
+    }
+    return mappings;
+}
+
 inline std::ostream& operator<<(std::ostream& out, const frame_surface& f) {
     out << "frame_surface class" << std::endl;
     out << detail::space(detail::INTENT, out, "Lazy sync    = ")
@@ -6,7 +6,12 @@
 
 #pragma once
 
+#include <map>
 #include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <typeinfo>
 #include <utility>
 #include <vector>
 
@@ -19,6 +24,78 @@
 namespace oneapi {
 namespace vpl {
 
+/// @brief Process wide cache of resolved implementations. Keeps loaders alive together with the
+/// index of the implementation chosen for the given selector key, so subsequent sessions are
+/// created without enumerating implementations again. Cache is shared by all selectors and
+/// can be used from several threads.
+class implementation_cache {
+public:
+    /// @brief Resolved implementation.
+    struct entry {
+        /// Loader the implementation was found by.
+        std::shared_ptr<_mfxLoader> loader;
+        /// Index of the implementation in the loader.
+        uint32_t index;
+        /// Serializes session creation on the shared loader.
+        std::shared_ptr<std::mutex> guard;
+    };
+
+    /// @brief Returns the process wide cache instance.
+    /// @return Reference to the cache.
+    static implementation_cache &instance() {
+        static implementation_cache cache;
+        return cache;
+    }
+
+    /// @brief Looks up resolved implementation.
+    /// @param[in] key Selector key.
+    /// @param[out] e Found entry.
+    /// @return True if entry is found.
+    bool find(const std::string &key, entry &e) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(key);
+        if (it == entries_.end())
+            return false;
+        e = it->second;
+        return true;
+    }
+
+    /// @brief Stores resolved implementation.
+    /// @param[in] key Selector key.
+    /// @param[in] e Entry to store.
+    void store(const std::string &key, const entry &e) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries_[key] = e;
+    }
+
+    /// @brief Drops resolved implementation of the given selector key.
+    /// @param[in] key Selector key.
+    void invalidate(const std::string &key) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries_.erase(key);
+    }
+
+    /// @brief Drops all resolved implementations. Loaders are unloaded once the last session
+    /// created from them is closed.
+    void invalidate() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries_.clear();
+    }
+
+    /// @brief Returns number of resolved implementations.
+    /// @return Number of cache entries.
+    size_t size() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return entries_.size();
+    }
+
+protected:
+    /// Protects entries.
+    std::mutex mutex_;
+    /// Resolved implementations by selector key.
+    std::map<std::string, entry> entries_;
+};
+
 /// @brief Selects oneVPL implementation according to the specified properties.
 /// @details This object iterates over the available implementations and selects an appropriate one
 /// based on the @p list of properties. API user can create an instance of that class. If user
@@ -38,18 +115,39 @@ public:
     virtual ~implementation_selector() {}
 
     /// @brief Creates session which has the requested properties. Session class object calls
-    /// this method at the ctor and takes care on deletion of loader and session handles.
+    /// this method at the ctor and takes care on deletion of the session handle. Loader is
+    /// released once the last owner of it is gone.
+    /// @details If the selector provides a cache key, the chosen implementation is remembered in
+    /// the implementation_cache and subsequent calls create session straight from the cached
+    /// loader.
     /// @return Pair of loader handle and associated session handle.
-    auto session() const {
+    std::pair<std::shared_ptr<_mfxLoader>, mfxSession> session() const {
+        std::string key = cache_key();
+        mfxSession s;
+
+        if (!key.empty()) {
+            implementation_cache::entry cached;
+            if (implementation_cache::instance().find(key, cached)) {
+                std::lock_guard<std::mutex> lock(*cached.guard);
+                if (MFXCreateSession(cached.loader.get(), cached.index, &s) == MFX_ERR_NONE)
+                    return std::pair(cached.loader, s);
+                // implementation is gone, resolve it from scratch
+                implementation_cache::instance().invalidate(key);
+            }
+        }
+
         mfxStatus sts;
         implementation_capabilities_factory factory;
-        auto loader = MFXLoad();
+        std::shared_ptr<_mfxLoader> loader(MFXLoad(), [](mfxLoader l) {
+            if (l)
+                MFXUnload(l);
+        });
 
         // convert options to mfxConfig
         auto opts = get_properties();
 
         std::for_each(opts.begin(), opts.end(), [&](auto opt) {
-            auto cfg = MFXCreateConfig(loader);
+            auto cfg = MFXCreateConfig(loader.get());
             [[maybe_unused]] detail::c_api_invoker e(detail::default_checker,
                                     MFXSetConfigFilterProperty,
                                     cfg,
@@ -60,10 +158,10 @@ public:
         uint32_t idx = 0;
         while (true) {
             void *h;
-            sts = MFXEnumImplementations(loader, idx, format_, &h);
+            sts = MFXEnumImplementations(loader.get(), idx, format_, &h);
 
             std::shared_ptr<void> handle(h, [&] (void *p) {
-                MFXDispReleaseImplDescription(loader, p);
+                MFXDispReleaseImplDescription(loader.get(), p);
             });
 
             // break if no idx
@@ -75,16 +173,31 @@ public:
             std::shared_ptr<base_implementation_capabilities> caps = factory.create(format_, h);
 
             if (this->operator()(caps)) {
-                mfxSession s;
-                detail::c_api_invoker e(detail::default_checker, MFXCreateSession, loader, idx, &s);
+                detail::c_api_invoker e(detail::default_checker,
+                                        MFXCreateSession,
+                                        loader.get(),
+                                        idx,
+                                        &s);
+                if (!key.empty()) {
+                    implementation_cache::instance().store(
+                        key,
+                        { loader, idx, std::make_shared<std::mutex>() });
+                }
                 return std::pair(loader, s);
             }
             idx++;
         }
-        MFXUnload(loader);
         throw base_exception(MFX_ERR_NOT_INITIALIZED);
     }
 
+    /// @brief Drops implementation remembered for this selector. Next session is created after
+    /// the full implementation search.
+    void invalidate() const {
+        std::string key = cache_key();
+        if (!key.empty())
+            implementation_cache::instance().invalidate(key);
+    }
+
 protected:
     /// @brief This operator is applyed to any found oneVPL implementation. If operator returns true, a session based
     /// on found implementation is created. Otherwise, search is continued.
@@ -92,6 +205,64 @@ protected:
     /// @return True, if implementation is good to go, false if search must continue.
     virtual bool operator()(std::shared_ptr<base_implementation_capabilities> caps) const = 0;
 
+    /// @brief Returns key to remember the chosen implementation by. Selectors with the same key
+    /// must choose the same implementation. Empty key disables caching, that is the default
+    /// since operator () of the subclass may depend on its state.
+    /// @return Cache key.
+    virtual std::string cache_key() const {
+        return std::string();
+    }
+
+    /// @brief Builds cache key from the selector type and its properties. Properties passed by
+    /// pointer can't be compared by value, so selectors having them aren't cached.
+    /// @return Cache key or empty string.
+    std::string properties_key() const {
+        std::ostringstream key;
+        key << typeid(*this).name() << ':' << format_;
+        for (auto &opt : get_properties()) {
+            mfxVariant v = opt.second.get_variant();
+            if (v.Type == MFX_VARIANT_TYPE_PTR)
+                return std::string();
+            key << ';' << opt.first << '=' << v.Type << ':';
+            // narrower types leave the rest of the union unset, so only the field of the type is used
+            switch (v.Type) {
+                case MFX_VARIANT_TYPE_U8:
+                    key << (uint32_t)v.Data.U8;
+                    break;
+                case MFX_VARIANT_TYPE_I8:
+                    key << (int32_t)v.Data.I8;
+                    break;
+                case MFX_VARIANT_TYPE_U16:
+                    key << v.Data.U16;
+                    break;
+                case MFX_VARIANT_TYPE_I16:
+                    key << v.Data.I16;
+                    break;
+                case MFX_VARIANT_TYPE_U32:
+                    key << v.Data.U32;
+                    break;
+                case MFX_VARIANT_TYPE_I32:
+                    key << v.Data.I32;
+                    break;
+                case MFX_VARIANT_TYPE_U64:
+                    key << v.Data.U64;
+                    break;
+                case MFX_VARIANT_TYPE_I64:
+                    key << v.Data.I64;
+                    break;
+                case MFX_VARIANT_TYPE_F32:
+                    key << std::hexfloat << v.Data.F32 << std::defaultfloat;
+                    break;
+                case MFX_VARIANT_TYPE_F64:
+                    key << std::hexfloat << v.Data.F64 << std::defaultfloat;
+                    break;
+                default:
+                    break;
+            }
+        }
+        return key.str();
+    }
+
     /// @brief Implementation capabilities report format
     /// @todo Replace either with enum or typename
     mfxImplCapsDeliveryFormat format_;
@@ -120,6 +291,13 @@ public:
     }
 
 protected:
+    /// @brief Any implementation matching the properties is accepted, so the choice is
+    /// defined by the properties only.
+    /// @return Cache key.
+    std::string cache_key() const override {
+        return properties_key();
+    }
+
     /// @brief List of properties
     property_collection props_;
 };
@@ -79,7 +79,6 @@ public:
     virtual ~session() {
         c_api_callable_.close(session_);
         MFXClose(session_);
-        MFXUnload(loader_);
         free_accelerator_handle();
     }
 
@@ -111,16 +110,18 @@ public:
     /// @param[in] list List of extension buffers.
     /// @return Status of the initialization.
     status Init(VideoParams *par, InitList list = {}) {
-        if (list.get_size()) {
-            if (auto [buffers, size] = list.get_raw_ext_buffers(); size) {
-                par->set_extension_buffers(buffers, static_cast<uint16_t>(size));
-            }
-        }
-        detail::c_api_invoker e(detail::default_checker,
-                                std::bind(c_api_callable_.init, session_, par->getMfx()));
-        par->clear_extension_buffers();
+        return init_impl(par, list);
+    }
 
-        return mfxstatus_to_onevplstatus(e.sts_);
+    /// @brief Initializes the session by using provided parameters
+    /// @tparam BuffersT Extension buffer classes allowed for the Init stage.
+    /// @param[in] par Init parameters
+    /// @param[in] list Compile-time list of extension buffers.
+    /// @return Status of the initialization.
+    template <typename... BuffersT>
+    status Init(VideoParams *par, static_ext_buffer_list<BuffersT...> &list) {
+        static_assert(InitList::template accepts<BuffersT...>::value, "Invalid buffer type");
+        return init_impl(par, list);
     }
 
     /// @brief Resets the session by using provided parameters
@@ -128,18 +129,18 @@ public:
     /// @param[in] list List of extension buffers.
     /// @return Status of the reset.
     status Reset(VideoParams *par, ResetList list) {
-        if (list.get_size()) {
-            if (auto [buffers, size] = list.get_raw_ext_buffers(); size) {
-                par->set_extension_buffers(buffers, static_cast<uint16_t>(size));
-            }
-        }
+        return reset_impl(par, list);
+    }
 
-        detail::c_api_invoker e(detail::default_checker,
-                                std::bind(c_api_callable_.reset, session_, par->getMfx()),
-                                std::bind(c_api_callable_.init, session_, par->getMfx()));
-        state_ = state::Processing;
-        par->clear_extension_buffers();
-        return mfxstatus_to_onevplstatus(e.sts_);
+    /// @brief Resets the session by using provided parameters
+    /// @tparam BuffersT Extension buffer classes allowed for the Reset stage.
+    /// @param[in] par Reset parameters
+    /// @param[in] list Compile-time list of extension buffers.
+    /// @return Status of the reset.
+    template <typename... BuffersT>
+    status Reset(VideoParams *par, static_ext_buffer_list<BuffersT...> &list) {
+        static_assert(ResetList::template accepts<BuffersT...>::value, "Invalid buffer type");
+        return reset_impl(par, list);
     }
 
     /// @brief Retrieves current session parameters.
@@ -190,6 +191,46 @@ protected:
     /// @brief accelorator file handle
     int fd_;
 
+    /// @brief Initializes the session by using provided parameters
+    /// @tparam List Class with the list of extension buffers
+    /// @param[in] par Init parameters
+    /// @param[in] list List of extension buffers.
+    /// @return Status of the initialization.
+    template <typename List>
+    status init_impl(VideoParams *par, List &list) {
+        if (list.get_size()) {
+            if (auto [buffers, size] = list.get_raw_ext_buffers(); size) {
+                par->set_extension_buffers(buffers, static_cast<uint16_t>(size));
+            }
+        }
+        detail::c_api_invoker e(detail::default_checker,
+                                std::bind(c_api_callable_.init, session_, par->getMfx()));
+        par->clear_extension_buffers();
+
+        return mfxstatus_to_onevplstatus(e.sts_);
+    }
+
+    /// @brief Resets the session by using provided parameters
+    /// @tparam List Class with the list of extension buffers
+    /// @param[in] par Reset parameters
+    /// @param[in] list List of extension buffers.
+    /// @return Status of the reset.
+    template <typename List>
+    status reset_impl(VideoParams *par, List &list) {
+        if (list.get_size()) {
+            if (auto [buffers, size] = list.get_raw_ext_buffers(); size) {
+                par->set_extension_buffers(buffers, static_cast<uint16_t>(size));
+            }
+        }
+
+        detail::c_api_invoker e(detail::default_checker,
+                                std::bind(c_api_callable_.reset, session_, par->getMfx()),
+                                std::bind(c_api_callable_.init, session_, par->getMfx()));
+        state_ = state::Processing;
+        par->clear_extension_buffers();
+        return mfxstatus_to_onevplstatus(e.sts_);
+    }
+
     void init_accelerator_handle() {
         mfxIMPL impl;
         mfxStatus sts = MFXQueryIMPL(session_, &impl);
@@ -270,7 +311,8 @@ protected:
     }
 
 private:
-    mfxLoader loader_;
+    /// Loader of the session. Might be shared with other sessions through implementation cache.
+    std::shared_ptr<_mfxLoader> loader_;
 };
 
 /// @brief Manages decoder's sessions.
@@ -363,6 +405,68 @@ public:
     /// @return Ok or warning
     status decode_frame(std::shared_ptr<frame_surface> out_surface,
                         decoder_process_list list = {}) {
+        return decode_frame_impl(out_surface, list);
+    }
+
+    /// @brief Decodes frame
+    /// @tparam BuffersT Extension buffer classes allowed for the decoder's processing stage.
+    /// @param[out] out_surface Future object with decoded data.
+    /// @param[in] list Compile-time list of extension buffers to attach to bitstream.
+    /// @return Ok or warning
+    template <typename... BuffersT>
+    status decode_frame(std::shared_ptr<frame_surface> out_surface,
+                        static_ext_buffer_list<BuffersT...> &list) {
+        static_assert(decoder_process_list::template accepts<BuffersT...>::value,
+                      "Invalid buffer type");
+        return decode_frame_impl(out_surface, list);
+    }
+
+    /// @brief Decodes frame
+    /// @param[in] list List of extension buffers to attach to bitstream
+    /// @return Future object with decoded data
+    std::shared_ptr<future<std::shared_ptr<frame_surface>>> process(
+        decoder_process_list list = {}) {
+        return process_impl(list);
+    }
+
+    /// @brief Decodes frame
+    /// @tparam BuffersT Extension buffer classes allowed for the decoder's processing stage.
+    /// @param[in] list Compile-time list of extension buffers to attach to bitstream
+    /// @return Future object with decoded data
+    template <typename... BuffersT>
+    std::shared_ptr<future<std::shared_ptr<frame_surface>>> process(
+        static_ext_buffer_list<BuffersT...> &list) {
+        static_assert(decoder_process_list::template accepts<BuffersT...>::value,
+                      "Invalid buffer type");
+        return process_impl(list);
+    }
+
+    /// @brief Retrieve decoder statistic
+    /// @return Decoder statistic
+    std::shared_ptr<decode_stat> getStat() {
+        std::shared_ptr<decode_stat> out = std::make_shared<decode_stat>();
+        decode_stat *dec_stat            = out.get();
+        [[maybe_unused]] detail::c_api_invoker e(detail::default_checker,
+                                MFXVideoDECODE_GetDecodeStat,
+                                session_,
+                                dec_stat->get_raw());
+        return out;
+    }
+
+    /// @brief Get video params
+    /// @return params
+    decoder_video_param getParams() {
+        return params_;
+    }
+
+protected:
+    /// @brief Decodes frame
+    /// @tparam List Class with the list of extension buffers
+    /// @param[out] out_surface Future object with decoded data.
+    /// @param[in] list List of extension buffers to attach to bitstream.
+    /// @return Ok or warning
+    template <typename List>
+    status decode_frame_impl(std::shared_ptr<frame_surface> out_surface, List &list) {
         mfxSyncPoint syncp;
         mfxFrameSurface1 *surf = NULL;
 
@@ -421,10 +525,11 @@ public:
     }
 
     /// @brief Decodes frame
+    /// @tparam List Class with the list of extension buffers
     /// @param[in] list List of extension buffers to attach to bitstream
     /// @return Future object with decoded data
-    std::shared_ptr<future<std::shared_ptr<frame_surface>>> process(
-        decoder_process_list list = {}) {
+    template <typename List>
+    std::shared_ptr<future<std::shared_ptr<frame_surface>>> process_impl(List &list) {
         std::shared_ptr<frame_surface> surface = std::make_shared<frame_surface>();
         std::shared_ptr<future_surface_t> f;
 
@@ -433,7 +538,7 @@ public:
         if (state_ != state::Done) {
             try {
                 status schedule_status;
-                schedule_status     = decode_frame(surface, list);
+                schedule_status     = decode_frame_impl(surface, list);
                 f                   = std::make_shared<future_surface_t>(surface);
                 op.schedule_status_ = schedule_status;
             }
@@ -451,25 +556,7 @@ public:
         f->add_operation(op);
         return f;
     }
-    /// @brief Retrieve decoder statistic
-    /// @return Decoder statistic
-    std::shared_ptr<decode_stat> getStat() {
-        std::shared_ptr<decode_stat> out = std::make_shared<decode_stat>();
-        decode_stat *dec_stat            = out.get();
-        [[maybe_unused]] detail::c_api_invoker e(detail::default_checker,
-                                MFXVideoDECODE_GetDecodeStat,
-                                session_,
-                                dec_stat->get_raw());
-        return out;
-    }
 
-    /// @brief Get video params
-    /// @return params
-    decoder_video_param getParams() {
-        return params_;
-    }
-
-protected:
     /// @brief Bitstream keeper
     bitstream_as_src bits_;
     /// @brief Bitstream reader
@@ -536,34 +623,120 @@ public:
     status encode_frame(std::shared_ptr<frame_surface> in_surface,
                         std::shared_ptr<bitstream_as_dst> bs,
                         encoder_process_list list = {}) {
+        return encode_frame_impl(in_surface, bs, list);
+    }
+
+    /// @brief Encodes frame
+    /// @tparam BuffersT Extension buffer classes allowed for the encoder's processing stage.
+    /// @param[in] in_surface Object with the data to encode.
+    /// @param[out] bs Future object with bitstream portion.
+    /// @param[in] list Compile-time list of extension buffers to use
+    /// @return Ok or warning
+    template <typename... BuffersT>
+    status encode_frame(std::shared_ptr<frame_surface> in_surface,
+                        std::shared_ptr<bitstream_as_dst> bs,
+                        static_ext_buffer_list<BuffersT...> &list) {
+        static_assert(encoder_process_list::template accepts<BuffersT...>::value,
+                      "Invalid buffer type");
+        return encode_frame_impl(in_surface, bs, list);
+    }
+
+    /// @brief Encodes frame by using provided source reader to get data to encode
+    /// @param[out] bs Future object with bitstream portion.
+    /// @param[in] list List of extension buffers to use
+    /// @return Ok or warning
+    status encode_frame(std::shared_ptr<bitstream_as_dst> bs, encoder_process_list list = {}) {
+        return encode_frame_impl(bs, list);
+    }
+
+    /// @brief Encodes frame by using provided source reader to get data to encode
+    /// @tparam BuffersT Extension buffer classes allowed for the encoder's processing stage.
+    /// @param[out] bs Future object with bitstream portion.
+    /// @param[in] list Compile-time list of extension buffers to use
+    /// @return Ok or warning
+    template <typename... BuffersT>
+    status encode_frame(std::shared_ptr<bitstream_as_dst> bs,
+                        static_ext_buffer_list<BuffersT...> &list) {
+        static_assert(encoder_process_list::template accepts<BuffersT...>::value,
+                      "Invalid buffer type");
+        return encode_frame_impl(bs, list);
+    }
+
+    /// @brief Encode frame. Function returns the future object with the bitstream which will hold processed data. User
+    /// needs to sync up the future object before accessing.
+    /// This function expected to work in the chain and uses provided future object to get the data to process.
+    /// @param[in] in_future Future object with the surface from the previous operation.
+    /// @param[in] list List of extension buffers to use
+    /// @return Future object with the bitstream.
+    std::shared_ptr<future_bitstream_t> process(std::shared_ptr<future_surface_t> in_future,
+                                                encoder_process_list list = {}) {
+        return process_impl(in_future, list);
+    }
+
+    /// @brief Encode frame. Function returns the future object with the bitstream which will hold processed data. User
+    /// needs to sync up the future object before accessing.
+    /// This function expected to work in the chain and uses provided future object to get the data to process.
+    /// @tparam BuffersT Extension buffer classes allowed for the encoder's processing stage.
+    /// @param[in] in_future Future object with the surface from the previous operation.
+    /// @param[in] list Compile-time list of extension buffers to use
+    /// @return Future object with the bitstream.
+    template <typename... BuffersT>
+    std::shared_ptr<future_bitstream_t> process(std::shared_ptr<future_surface_t> in_future,
+                                                static_ext_buffer_list<BuffersT...> &list) {
+        static_assert(encoder_process_list::template accepts<BuffersT...>::value,
+                      "Invalid buffer type");
+        return process_impl(in_future, list);
+    }
+
+    /// @brief Retrieve encoder statistic
+    /// @return Encoder statistic
+    std::shared_ptr<encode_stat> getStat() {
+        std::shared_ptr<encode_stat> out = std::make_shared<encode_stat>();
+        encode_stat *enc_stat            = out.get();
+        detail::c_api_invoker e(detail::default_checker,
+                                MFXVideoENCODE_GetEncodeStat,
+                                session_,
+                                enc_stat->get_raw());
+        return out;
+    }
+
+protected:
+    /// @brief Encodes frame
+    /// @tparam List Class with the list of extension buffers
+    /// @param[in] in_surface Object with the data to encode.
+    /// @param[out] bs Future object with bitstream portion.
+    /// @param[in] list List of extension buffers to use
+    /// @return Ok or warning
+    template <typename List>
+    status encode_frame_impl(std::shared_ptr<frame_surface> in_surface,
+                             std::shared_ptr<bitstream_as_dst> bs,
+                             List &list) {
         mfxSyncPoint sp;
         mfxFrameSurface1 *surf = in_surface.get() ? in_surface.get()->get_raw_ptr() : nullptr;
-        std::shared_ptr<mfxEncodeCtrl> ctrl = nullptr;
-        bool alocated_ctrl                  = false;
+        mfxEncodeCtrl local_ctrl = {};
+        mfxEncodeCtrl *ctrl      = nullptr;
 
         if (nullptr == surf) {
             state_ = state::Draining;
         }
-        if(list.get_size() && list.has_buffer<0>()) {
-            ctrl.reset(list.get_buffer<mfxEncodeCtrl, 0>(), [](mfxEncodeCtrl *p) { p = nullptr; });
-            std::cout << "enc ctrl from the list" << std::endl;
-        } else {
-            ctrl = std::make_shared<mfxEncodeCtrl>();
-            *ctrl = {0};
-            alocated_ctrl = true;
+        else {
+            in_surface->flush_mapping();
+        }
+        if (list.get_size() && list.template has_buffer<0>()) {
+            ctrl = list.template get_buffer<mfxEncodeCtrl, 0>();
         }
-        
+
         // Asumption: Encoder will copy-in all extension buffers.
         if (auto [buffers, size] = list.get_raw_ext_buffers(); size) {
-            ctrl->ExtParam = buffers;
-            ctrl->NumExtParam = (mfxU16)size;
-        } else {
-            if (alocated_ctrl) {
-                ctrl.reset();
-            } else {
-                ctrl->ExtParam = 0;
-                ctrl->NumExtParam = 0;
+            if (!ctrl) {
+                ctrl = &local_ctrl;
             }
+            ctrl->ExtParam    = buffers;
+            ctrl->NumExtParam = (mfxU16)size;
+        }
+        else if (ctrl) {
+            ctrl->ExtParam    = 0;
+            ctrl->NumExtParam = 0;
         }
         detail::c_api_invoker e({ [](mfxStatus s) {
                                     switch (s) {
@@ -580,7 +753,7 @@ public:
                                 } },
                                 MFXVideoENCODE_EncodeFrameAsync,
                                 session_,
-                                ctrl.get(),
+                                ctrl,
                                 surf,
                                 (*bs.get())(),
                                 &sp);
@@ -595,10 +768,12 @@ public:
     }
 
     /// @brief Encodes frame by using provided source reader to get data to encode
+    /// @tparam List Class with the list of extension buffers
     /// @param[out] bs Future object with bitstream portion.
     /// @param[in] list List of extension buffers to use
     /// @return Ok or warning
-    status encode_frame(std::shared_ptr<bitstream_as_dst> bs, encoder_process_list list = {}) {
+    template <typename List>
+    status encode_frame_impl(std::shared_ptr<bitstream_as_dst> bs, List &list) {
         status sts;
         if (!rdr_)
             throw base_exception("NULL reader ptr", MFX_ERR_NULL_PTR);
@@ -613,7 +788,7 @@ public:
                     input_surface.reset();
             }
 
-            sts = encode_frame(input_surface, bs, list);
+            sts = encode_frame_impl(input_surface, bs, list);
 
             switch (sts) {
                 case status::Ok:
@@ -638,11 +813,13 @@ public:
     /// @brief Encode frame. Function returns the future object with the bitstream which will hold processed data. User
     /// needs to sync up the future object before accessing.
     /// This function expected to work in the chain and uses provided future object to get the data to process.
+    /// @tparam List Class with the list of extension buffers
     /// @param[in] in_future Future object with the surface from the previous operation.
     /// @param[in] list List of extension buffers to use
     /// @return Future object with the bitstream.
-    std::shared_ptr<future_bitstream_t> process(std::shared_ptr<future_surface_t> in_future,
-                                                encoder_process_list list = {}) {
+    template <typename List>
+    std::shared_ptr<future_bitstream_t> process_impl(std::shared_ptr<future_surface_t> in_future,
+                                                     List &list) {
         std::shared_ptr<bitstream_as_dst> bits;
         std::shared_ptr<future_bitstream_t> f_out = std::make_shared<future_bitstream_t>(nullptr);
         operation_status op(component_, this);
@@ -661,7 +838,7 @@ public:
                         status schedule_status;
 
                         bits            = std::make_shared<bitstream_as_dst>();
-                        schedule_status = encode_frame(in_surface, bits, list);
+                        schedule_status = encode_frame_impl(in_surface, bits, list);
                         f_out           = std::make_shared<future_bitstream_t>(bits);
                         f_out.reset(new future_bitstream_t(bits));
                         op.schedule_status_ = schedule_status;
@@ -683,19 +860,6 @@ public:
         return f_out;
     }
 
-    /// @brief Retrieve encoder statistic
-    /// @return Encoder statistic
-    std::shared_ptr<encode_stat> getStat() {
-        std::shared_ptr<encode_stat> out = std::make_shared<encode_stat>();
-        encode_stat *enc_stat            = out.get();
-        detail::c_api_invoker e(detail::default_checker,
-                                MFXVideoENCODE_GetEncodeStat,
-                                session_,
-                                enc_stat->get_raw());
-        return out;
-    }
-
-protected:
     /// @brief Raw freames reader
     frame_source_reader *rdr_;
 };
@@ -762,6 +926,16 @@ public:
         return init_sts;
     }
 
+    /// @brief Initializes session with given parameters and extention buffers.
+    /// @tparam BuffersT Extension buffer classes allowed for the VPP's initialization stage.
+    /// @param[in] par Pointer to the parameters.
+    /// @param[in] list Compile-time list of extention buffers.
+    /// @return Initialization status
+    template <typename... BuffersT>
+    status Init(vpp_video_param *par, static_ext_buffer_list<BuffersT...> &list) {
+        return session::Init(par, list);
+    }
+
     /// @brief Temporal method to sync rhe surface's data.
     /// @todo remove during migration to 2.1
     /// @param[in] sp Synchronization point handle.
@@ -788,6 +962,9 @@ public:
         if (nullptr == surf) {
             state_ = state::Draining;
         }
+        else {
+            in_surface->flush_mapping();
+        }
         alloc_output(out_surface);
         detail::c_api_invoker e({ [](mfxStatus s) {
                                     switch (s) {
@@ -74,7 +74,8 @@ public:
     /// @param[out] frame data storage
     /// @return True if data was read
     virtual bool get_data(std::shared_ptr<frame_surface> frame) {
-        auto data = frame->map_data(memory_access::write);
+        frame_surface_mapping mapping(frame, memory_access::write);
+        auto data = mapping.data();
 
         /// @todo verify buffer availability
 
@@ -108,12 +109,12 @@ public:
                 auto B = data.get_plane_ptrs_1_BGRA();
 
                 read_blob(B, pitch, width_ * 4, heigth_);
+                break;
             }
             default:
                 throw base_exception("raw_frame_file_reader unsupported format",
                                      MFX_ERR_NOT_IMPLEMENTED);
         }
-        frame->unmap();
         return !eof_;
     }
 
@@ -181,7 +182,8 @@ public:
     /// @param[out] frame data storage
     /// @return True if data was read
     virtual bool get_data(std::shared_ptr<frame_surface> frame) {
-        auto data = frame->map_data(memory_access::write);
+        frame_surface_mapping mapping(frame, memory_access::write);
+        auto data = mapping.data();
 
         /// @todo verify buffer avialability
         uint32_t pitch = 0;
@@ -214,12 +216,12 @@ public:
                 auto B = data.get_plane_ptrs_1_BGRA();
 
                 read_blob(B, pitch, width_ * 4, heigth_);
+                break;
             }
             default:
                 throw base_exception("raw_frame_file_reader_by_name unsupported format",
                                      MFX_ERR_NOT_IMPLEMENTED);
         }
-        frame->unmap();
         return !eof_;
     }
 
@@ -0,0 +1,69 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include <gtest/gtest.h>
+
+#include "vpl/preview/vpl.hpp"
+
+namespace vpl = oneapi::vpl;
+
+TEST(PreviewStaticExtBufferList, RawArrayHoldsAttachedBuffers) {
+    vpl::ExtCodingOption2 co2;
+    vpl::ExtCodingOption3 co3;
+    vpl::static_ext_buffer_list<vpl::ExtCodingOption2, vpl::ExtCodingOption3> list(&co2, &co3);
+
+    EXPECT_EQ(list.get_size(), 2u);
+    auto [buffers, size] = list.get_raw_ext_buffers();
+    ASSERT_EQ(size, 2u);
+    EXPECT_EQ(buffers[0], co2.get_base_ptr());
+    EXPECT_EQ(buffers[1], co3.get_base_ptr());
+    EXPECT_EQ(list.get<vpl::ExtCodingOption3>(), &co3);
+}
+
+TEST(PreviewStaticExtBufferList, RawArrayIsBuiltOnce) {
+    vpl::ExtCodingOption2 co2;
+    vpl::static_ext_buffer_list<vpl::ExtCodingOption2> list(&co2);
+
+    auto first  = list.get_raw_ext_buffers();
+    auto second = list.get_raw_ext_buffers();
+    EXPECT_EQ(first.first, second.first);
+    EXPECT_EQ(first.second, second.second);
+}
+
+TEST(PreviewStaticExtBufferList, EncodeCtrlIsExcludedFromRawArray) {
+    vpl::EncodeCtrl ctrl;
+    vpl::ExtCodingOption2 co2;
+    vpl::static_ext_buffer_list<vpl::EncodeCtrl, vpl::ExtCodingOption2> list(&ctrl, &co2);
+
+    static_assert(decltype(list)::raw_size == 1);
+    static_assert(decltype(list)::has_buffer<0>());
+    static_assert(!decltype(list)::has_buffer<MFX_EXTBUFF_CODING_OPTION3>());
+
+    EXPECT_EQ(list.get_size(), 2u);
+    auto [buffers, size] = list.get_raw_ext_buffers();
+    ASSERT_EQ(size, 1u);
+    EXPECT_EQ(buffers[0], co2.get_base_ptr());
+    EXPECT_EQ((list.get_buffer<mfxEncodeCtrl, 0>()), ctrl.get_ptr());
+    EXPECT_EQ((list.get_buffer<mfxExtCodingOption3, MFX_EXTBUFF_CODING_OPTION3>()), nullptr);
+}
+
+TEST(PreviewStaticExtBufferList, EmptyListHasNoRawArray) {
+    vpl::static_ext_buffer_list<> list;
+
+    EXPECT_EQ(list.get_size(), 0u);
+    auto [buffers, size] = list.get_raw_ext_buffers();
+    EXPECT_EQ(buffers, nullptr);
+    EXPECT_EQ(size, 0u);
+}
+
+TEST(PreviewStaticExtBufferList, StageListsAcceptOnlyAllowedBuffers) {
+    static_assert(
+        vpl::encoder_process_list::accepts<vpl::EncodeCtrl, vpl::ExtCodingOption2>::value);
+    static_assert(!vpl::encoder_process_list::accepts<vpl::ExtCodingOption>::value);
+    static_assert(vpl::decoder_process_list::accepts<vpl::ExtDecodeErrorReport>::value);
+    static_assert(!vpl::decoder_process_list::accepts<vpl::ExtCodingOption2>::value);
+    SUCCEED();
+}
@@ -0,0 +1,257 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+#include "src/unit_api.h"
+
+#include "vpl/preview/vpl.hpp"
+
+namespace vpl = oneapi::vpl;
+
+// The stub runtime doesn't allocate surfaces, so surfaces used by these tests carry a
+// frame interface which counts calls coming from the frame_surface class.
+struct TestSurfaceContext {
+    mfxU32 refCounter = 0;
+    mfxU32 mapCalls   = 0;
+    mfxU32 unmapCalls = 0;
+    mfxU32 syncCalls  = 0;
+    mfxU32 lockCount  = 0;
+};
+
+static TestSurfaceContext *GetContext(mfxFrameSurface1 *surface) {
+    return reinterpret_cast<TestSurfaceContext *>(surface->FrameInterface->Context);
+}
+
+static mfxStatus TestAddRef(mfxFrameSurface1 *surface) {
+    GetContext(surface)->refCounter++;
+    return MFX_ERR_NONE;
+}
+
+static mfxStatus TestRelease(mfxFrameSurface1 *surface) {
+    GetContext(surface)->refCounter--;
+    return MFX_ERR_NONE;
+}
+
+static mfxStatus TestGetRefCounter(mfxFrameSurface1 *surface, mfxU32 *counter) {
+    *counter = GetContext(surface)->refCounter;
+    return MFX_ERR_NONE;
+}
+
+static mfxStatus TestMap(mfxFrameSurface1 *surface, mfxU32 flags) {
+    (void)flags;
+    GetContext(surface)->mapCalls++;
+    GetContext(surface)->lockCount++;
+    return MFX_ERR_NONE;
+}
+
+static mfxStatus TestUnmap(mfxFrameSurface1 *surface) {
+    TestSurfaceContext *ctx = GetContext(surface);
+    if (ctx->lockCount == 0)
+        return MFX_ERR_UNSUPPORTED;
+    ctx->unmapCalls++;
+    ctx->lockCount--;
+    return MFX_ERR_NONE;
+}
+
+static mfxStatus TestSynchronize(mfxFrameSurface1 *surface, mfxU32 wait) {
+    (void)wait;
+    GetContext(surface)->syncCalls++;
+    return MFX_ERR_NONE;
+}
+
+class PreviewFrameSurface : public ::testing::Test {
+protected:
+    void SetUp() override {
+        SKIP_IF_DISP_STUB_DISABLED();
+
+        iface_               = {};
+        iface_.Context       = &ctx_;
+        iface_.AddRef        = TestAddRef;
+        iface_.Release       = TestRelease;
+        iface_.GetRefCounter = TestGetRefCounter;
+        iface_.Map           = TestMap;
+        iface_.Unmap         = TestUnmap;
+        iface_.Synchronize   = TestSynchronize;
+
+        surface_                = {};
+        surface_.FrameInterface = &iface_;
+        surface_.Data.MemType   = MFX_MEMTYPE_SYSTEM_MEMORY;
+    }
+
+    TestSurfaceContext ctx_;
+    mfxFrameSurfaceInterface iface_;
+    mfxFrameSurface1 surface_;
+};
+
+TEST_F(PreviewFrameSurface, RegularMappingCallsRuntimeEachTime) {
+    auto surface = std::make_shared<vpl::frame_surface>(&surface_);
+
+    for (int i = 0; i < 3; i++) {
+        surface->map_data(vpl::memory_access::read);
+        surface->unmap();
+    }
+    EXPECT_EQ(ctx_.mapCalls, 3u);
+    EXPECT_EQ(ctx_.unmapCalls, 3u);
+    EXPECT_EQ(ctx_.lockCount, 0u);
+}
+
+TEST_F(PreviewFrameSurface, PersistentMappingSkipsRedundantCalls) {
+    auto surface = std::make_shared<vpl::frame_surface>(&surface_);
+    surface->set_persistent_mapping(true);
+
+    for (int i = 0; i < 3; i++) {
+        surface->map_data(vpl::memory_access::read_write);
+        surface->unmap();
+        surface->map_data(vpl::memory_access::read);
+        surface->unmap();
+    }
+    EXPECT_EQ(ctx_.mapCalls, 1u);
+    EXPECT_EQ(ctx_.unmapCalls, 0u);
+    EXPECT_EQ(surface->get_mapped_flags(), (mfxU32)MFX_MAP_READ_WRITE);
+
+    surface->flush_mapping();
+    EXPECT_EQ(ctx_.unmapCalls, 1u);
+    EXPECT_EQ(ctx_.lockCount, 0u);
+}
+
+TEST_F(PreviewFrameSurface, PersistentMappingRemapsForWiderAccess) {
+    auto surface = std::make_shared<vpl::frame_surface>(&surface_);
+    surface->set_persistent_mapping(true);
+
+    surface->map_data(vpl::memory_access::read);
+    surface->unmap();
+    surface->map_data(vpl::memory_access::write);
+    surface->unmap();
+
+    EXPECT_EQ(ctx_.mapCalls, 2u);
+    EXPECT_EQ(ctx_.unmapCalls, 1u);
+    EXPECT_EQ(ctx_.lockCount, 1u);
+}
+
+TEST_F(PreviewFrameSurface, PersistentMappingRequiresExclusiveOwnership) {
+    auto surface = std::make_shared<vpl::frame_surface>(&surface_);
+    surface->set_persistent_mapping(true);
+
+    surface->map_data(vpl::memory_access::read);
+    surface->unmap();
+    EXPECT_EQ(ctx_.lockCount, 1u);
+
+    // runtime takes the surface
+    TestAddRef(&surface_);
+    surface->map_data(vpl::memory_access::read);
+    EXPECT_EQ(ctx_.mapCalls, 2u);
+    surface->unmap();
+    EXPECT_EQ(ctx_.lockCount, 0u);
+    TestRelease(&surface_);
+}
+
+TEST_F(PreviewFrameSurface, MappingMadeBeforePersistentModeIsReleased) {
+    auto surface = std::make_shared<vpl::frame_surface>(&surface_);
+
+    surface->map_data(vpl::memory_access::read);
+    surface->set_persistent_mapping(true);
+    surface->unmap();
+    EXPECT_EQ(ctx_.unmapCalls, 1u);
+    EXPECT_EQ(ctx_.lockCount, 0u);
+
+    // the next mapping is kept
+    surface->map_data(vpl::memory_access::read);
+    surface->unmap();
+    EXPECT_EQ(surface->get_mapped_flags(), (mfxU32)MFX_MAP_READ);
+    EXPECT_EQ(ctx_.lockCount, 1u);
+}
+
+TEST_F(PreviewFrameSurface, PersistentMappingIsNotKeptForVideoMemory) {
+    surface_.Data.MemType = MFX_MEMTYPE_VIDEO_MEMORY_DECODER_TARGET;
+    auto surface          = std::make_shared<vpl::frame_surface>(&surface_);
+    surface->set_persistent_mapping(true);
+
+    surface->map_data(vpl::memory_access::read);
+    surface->unmap();
+    surface->map_data(vpl::memory_access::read);
+    surface->unmap();
+
+    EXPECT_EQ(ctx_.mapCalls, 2u);
+    EXPECT_EQ(ctx_.unmapCalls, 2u);
+}
+
+TEST_F(PreviewFrameSurface, PersistentMappingIsReleasedWithSurface) {
+    {
+        auto surface = std::make_shared<vpl::frame_surface>(&surface_);
+        surface->set_persistent_mapping(true);
+        surface->map_data(vpl::memory_access::write);
+        surface->unmap();
+        EXPECT_EQ(ctx_.lockCount, 1u);
+    }
+    EXPECT_EQ(ctx_.lockCount, 0u);
+    EXPECT_EQ(ctx_.refCounter, 0u);
+}
+
+TEST_F(PreviewFrameSurface, CopyDoesNotInheritPersistentMapping) {
+    auto surface = std::make_shared<vpl::frame_surface>(&surface_);
+    surface->set_persistent_mapping(true);
+    surface->map_data(vpl::memory_access::read);
+    surface->unmap();
+
+    // the copy maps the surface on its own every time
+    auto copy = std::make_shared<vpl::frame_surface>(*surface);
+    EXPECT_FALSE(copy->is_persistent_mapping());
+    EXPECT_EQ(copy->get_mapped_flags(), 0u);
+    copy->map_data(vpl::memory_access::read);
+    copy->unmap();
+    EXPECT_EQ(ctx_.mapCalls, 2u);
+    EXPECT_EQ(ctx_.lockCount, 1u);
+
+    // the surface is shared now, so the original releases its mapping on the next unmap
+    surface->unmap();
+    EXPECT_EQ(surface->get_mapped_flags(), 0u);
+    EXPECT_EQ(ctx_.lockCount, 0u);
+
+    vpl::frame_surface assigned;
+    assigned.set_persistent_mapping(true);
+    assigned = *surface;
+    EXPECT_FALSE(assigned.is_persistent_mapping());
+    EXPECT_TRUE(surface->is_persistent_mapping());
+}
+
+TEST_F(PreviewFrameSurface, ScopedMappingUnmapsOnDestruction) {
+    auto surface = std::make_shared<vpl::frame_surface>(&surface_);
+    {
+        vpl::frame_surface_mapping mapping(surface, vpl::memory_access::read);
+        EXPECT_EQ(ctx_.mapCalls, 1u);
+        EXPECT_EQ(ctx_.lockCount, 1u);
+        EXPECT_EQ(mapping.surface(), surface);
+    }
+    EXPECT_EQ(ctx_.unmapCalls, 1u);
+    EXPECT_EQ(ctx_.lockCount, 0u);
+}
+
+TEST_F(PreviewFrameSurface, MapAllSynchronizesBeforeMapping) {
+    TestSurfaceContext ctx2;
+    mfxFrameSurfaceInterface iface2 = iface_;
+    iface2.Context                  = &ctx2;
+    mfxFrameSurface1 surface2       = surface_;
+    surface2.FrameInterface         = &iface2;
+
+    std::vector<std::shared_ptr<vpl::frame_surface>> surfaces = {
+        std::make_shared<vpl::frame_surface>(&surface_),
+        std::make_shared<vpl::frame_surface>(&surface2)
+    };
+    {
+        auto mappings = vpl::map_all(surfaces, vpl::memory_access::read);
+        ASSERT_EQ(mappings.size(), 2u);
+        EXPECT_EQ(ctx_.syncCalls, 1u);
+        EXPECT_EQ(ctx2.syncCalls, 1u);
+        EXPECT_EQ(ctx_.lockCount, 1u);
+        EXPECT_EQ(ctx2.lockCount, 1u);
+    }
+    EXPECT_EQ(ctx_.lockCount, 0u);
+    EXPECT_EQ(ctx2.lockCount, 0u);
+}
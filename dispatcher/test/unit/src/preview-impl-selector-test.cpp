@@ -0,0 +1,157 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "src/unit_api.h"
+
+#include "vpl/preview/vpl.hpp"
+
+namespace vpl = oneapi::vpl;
+
+static vpl::property_list StubProperties() {
+    return vpl::property_list{ vpl::dprops::vendor_id(0x8086),
+                               vpl::dprops::vendor_impl_id(0xFFFF) };
+}
+
+// Accepts any implementation, but doesn't provide the cache key.
+class UncachedSelector : public vpl::implementation_selector {
+public:
+    UncachedSelector() : vpl::implementation_selector(), props_(StubProperties()) {}
+
+    std::vector<std::pair<std::string, vpl::detail::variant>> get_properties() const override {
+        return props_.get_properties();
+    }
+
+protected:
+    bool operator()(std::shared_ptr<vpl::base_implementation_capabilities>) const override {
+        return true;
+    }
+
+    vpl::property_list props_;
+};
+
+// Variant of the given type with the unused bytes of the value set.
+class DirtyVariant : public vpl::detail::variant {
+public:
+    DirtyVariant(mfxVariantType type, uint32_t value, uint64_t garbage) {
+        v_.Type     = type;
+        v_.Data.U64 = garbage;
+        v_.Data.U32 = value;
+    }
+};
+
+static vpl::detail::variant MakeDirtyVariant(mfxVariantType type,
+                                             uint32_t value,
+                                             uint64_t garbage) {
+    DirtyVariant v(type, value, garbage);
+    return static_cast<const vpl::detail::variant &>(v);
+}
+
+// Default selector with the given properties and the cache key exposed.
+class KeyedSelector : public vpl::implementation_selector {
+public:
+    explicit KeyedSelector(std::vector<std::pair<std::string, vpl::detail::variant>> props)
+            : vpl::implementation_selector(),
+              props_(props) {}
+
+    std::vector<std::pair<std::string, vpl::detail::variant>> get_properties() const override {
+        return props_;
+    }
+
+    std::string key() const {
+        return properties_key();
+    }
+
+protected:
+    bool operator()(std::shared_ptr<vpl::base_implementation_capabilities>) const override {
+        return true;
+    }
+
+    std::vector<std::pair<std::string, vpl::detail::variant>> props_;
+};
+
+class PreviewImplSelector : public ::testing::Test {
+protected:
+    void SetUp() override {
+        SKIP_IF_DISP_STUB_DISABLED();
+        vpl::implementation_cache::instance().invalidate();
+    }
+
+    void TearDown() override {
+        vpl::implementation_cache::instance().invalidate();
+    }
+};
+
+TEST_F(PreviewImplSelector, SelectorsWithSamePropertiesShareLoader) {
+    vpl::default_selector<vpl::property_list> sel1(StubProperties());
+    vpl::default_selector<vpl::property_list> sel2(StubProperties());
+
+    auto [loader1, session1] = sel1.session();
+    auto [loader2, session2] = sel2.session();
+
+    EXPECT_EQ(loader1.get(), loader2.get());
+    EXPECT_EQ(vpl::implementation_cache::instance().size(), 1u);
+    EXPECT_NE(session1, session2);
+
+    EXPECT_EQ(MFXClose(session1), MFX_ERR_NONE);
+    EXPECT_EQ(MFXClose(session2), MFX_ERR_NONE);
+}
+
+TEST_F(PreviewImplSelector, InvalidateForcesNewSearch) {
+    vpl::default_selector<vpl::property_list> sel(StubProperties());
+
+    auto [loader1, session1] = sel.session();
+    sel.invalidate();
+    EXPECT_EQ(vpl::implementation_cache::instance().size(), 0u);
+    auto [loader2, session2] = sel.session();
+
+    EXPECT_NE(loader1.get(), loader2.get());
+
+    EXPECT_EQ(MFXClose(session1), MFX_ERR_NONE);
+    EXPECT_EQ(MFXClose(session2), MFX_ERR_NONE);
+}
+
+TEST_F(PreviewImplSelector, LoaderOutlivesCacheEntry) {
+    vpl::default_selector<vpl::property_list> sel(StubProperties());
+
+    auto [loader, session] = sel.session();
+    vpl::implementation_cache::instance().invalidate();
+
+    // the session still owns the loader
+    EXPECT_EQ(loader.use_count(), 1);
+    EXPECT_EQ(MFXClose(session), MFX_ERR_NONE);
+}
+
+TEST_F(PreviewImplSelector, SelectorWithoutKeyIsNotCached) {
+    UncachedSelector sel;
+
+    auto [loader1, session1] = sel.session();
+    auto [loader2, session2] = sel.session();
+
+    EXPECT_NE(loader1.get(), loader2.get());
+    EXPECT_EQ(vpl::implementation_cache::instance().size(), 0u);
+
+    EXPECT_EQ(MFXClose(session1), MFX_ERR_NONE);
+    EXPECT_EQ(MFXClose(session2), MFX_ERR_NONE);
+}
+
+TEST_F(PreviewImplSelector, KeyIgnoresUnusedBytesOfProperties) {
+    const std::string path = "mfxImplDescription.VendorID";
+
+    KeyedSelector sel1({ { path, MakeDirtyVariant(MFX_VARIANT_TYPE_U32, 0x8086, 0) } });
+    KeyedSelector sel2({ { path, MakeDirtyVariant(MFX_VARIANT_TYPE_U32, 0x8086, ~0ull) } });
+    KeyedSelector sel3({ { path, MakeDirtyVariant(MFX_VARIANT_TYPE_U32, 0x8087, 0) } });
+
+    EXPECT_FALSE(sel1.key().empty());
+    EXPECT_EQ(sel1.key(), sel2.key());
+    EXPECT_NE(sel1.key(), sel3.key());
+}
@@ -0,0 +1,293 @@
+//==============================================================================
+// Copyright Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+//==============================================================================
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "async_completion.hpp"
+namespace vpl = oneapi::vpl;
+
+namespace {
+
+/// @brief Single background thread which tracks all awaited operations of the process.
+class completion_thread {
+public:
+    /// @brief Returns the process wide instance. The instance is never destroyed, it is stopped
+    /// by the atexit hook before the interpreter finalizes.
+    static completion_thread &instance() {
+        static completion_thread *thread = new completion_thread();
+        return *thread;
+    }
+
+    /// @brief Adds operation to track. Must be called with the GIL held.
+    void submit(async_poll_t poll, async_result_t result, py::object loop, py::object future) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!started_) {
+            started_ = true;
+            stop_    = false;
+            py::module::import("atexit").attr("register")(py::cpp_function([]() {
+                completion_thread::instance().stop();
+            }));
+            thread_ = std::thread(&completion_thread::run, this);
+        }
+        pending_.push_back(
+            { std::move(poll), std::move(result), std::move(loop), std::move(future), {} });
+        lock.unlock();
+        cv_.notify_one();
+    }
+
+    /// @brief Stops the thread and drops operations which are still in flight. Must be called
+    /// with the GIL held.
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!started_)
+                return;
+            stop_ = true;
+        }
+        cv_.notify_one();
+        {
+            // the thread might wait for the GIL to deliver last results
+            py::gil_scoped_release release;
+            thread_.join();
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_.clear();
+        active_.clear();
+        started_ = false;
+    }
+
+private:
+    /// @brief Tracked operation.
+    struct operation {
+        /// Status check.
+        async_poll_t poll;
+        /// Result producer.
+        async_result_t result;
+        /// Event loop to deliver the result to.
+        py::object loop;
+        /// Future to complete.
+        py::object future;
+        /// Error description, empty if operation succeeded.
+        std::string error;
+    };
+
+    /// Bounds of the time the thread waits for the oldest operation when nothing is ready.
+    static constexpr std::chrono::milliseconds min_interval = std::chrono::milliseconds(1);
+    static constexpr std::chrono::milliseconds max_interval = std::chrono::milliseconds(16);
+
+    completion_thread() : started_(false), stop_(false) {}
+
+    /// @brief Checks the operation and reports whether it is finished.
+    static bool is_finished(operation &op, std::chrono::milliseconds timeout) {
+        try {
+            switch (op.poll(timeout)) {
+                case vpl::async_op_status::timeout:
+                    return false;
+                case vpl::async_op_status::ready:
+                case vpl::async_op_status::cancelled:
+                    return true;
+                case vpl::async_op_status::aborted:
+                    op.error = "Asynchronous operation aborted";
+                    return true;
+                default:
+                    op.error = "Asynchronous operation failed";
+                    return true;
+            }
+        }
+        catch (std::exception &e) {
+            op.error = e.what();
+        }
+        return true;
+    }
+
+    void run() {
+        std::vector<operation> finished;
+        std::chrono::milliseconds interval = min_interval;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                if (active_.empty()) {
+                    cv_.wait(lock, [this] {
+                        return stop_ || !pending_.empty();
+                    });
+                }
+                if (stop_)
+                    break;
+                std::move(pending_.begin(), pending_.end(), std::back_inserter(active_));
+                pending_.clear();
+            }
+
+            // Poll all outstanding operations without blocking; if nothing is ready, let the
+            // runtime block on the oldest one for the current interval instead of spinning.
+            for (size_t i = 0; i < active_.size();) {
+                if (is_finished(active_[i], std::chrono::milliseconds(0))) {
+                    finished.push_back(std::move(active_[i]));
+                    active_.erase(active_.begin() + i);
+                }
+                else {
+                    i++;
+                }
+            }
+            if (finished.empty() && !active_.empty()) {
+                auto deadline = std::chrono::steady_clock::now() + interval;
+                if (is_finished(active_.front(), interval)) {
+                    finished.push_back(std::move(active_.front()));
+                    active_.erase(active_.begin());
+                }
+                else {
+                    // The runtime may return before the timeout expires, the rest of the interval
+                    // is waited out unless a new operation comes. The interval grows while
+                    // nothing completes.
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    cv_.wait_until(lock, deadline, [this] {
+                        return stop_ || !pending_.empty();
+                    });
+                    interval = std::min(interval * 2, max_interval);
+                }
+            }
+
+            if (!finished.empty()) {
+                interval = min_interval;
+                py::gil_scoped_acquire acquire;
+                deliver(finished);
+                finished.clear();
+            }
+        }
+    }
+
+    /// @brief Posts results to the event loops. Must be called with the GIL held.
+    static void deliver(std::vector<operation> &finished) {
+        static py::object *complete = new py::object(py::cpp_function(
+            [](py::object future, py::object value, py::object error) {
+                if (future.attr("done")().cast<bool>())
+                    return;
+                if (!error.is_none())
+                    future.attr("set_exception")(error);
+                else
+                    future.attr("set_result")(value);
+            }));
+
+        for (auto &op : finished) {
+            try {
+                py::object value = py::none();
+                py::object error = py::none();
+                if (op.error.empty())
+                    value = op.result();
+                else
+                    error = py::module::import("builtins").attr("RuntimeError")(op.error);
+                op.loop.attr("call_soon_threadsafe")(*complete, op.future, value, error);
+            }
+            catch (py::error_already_set &) {
+                // event loop is closed, nobody waits for this result anymore
+            }
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::thread thread_;
+    /// Operations submitted since the last pass.
+    std::vector<operation> pending_;
+    /// Operations tracked by the thread.
+    std::vector<operation> active_;
+    bool started_;
+    bool stop_;
+};
+
+/// @brief Completes @p future with the outcome of @p awaitable once it is done.
+void chain_future(py::object awaitable, py::object future) {
+    py::module::import("asyncio")
+        .attr("ensure_future")(awaitable)
+        .attr("add_done_callback")(py::cpp_function([future](py::object done) {
+            if (future.attr("done")().cast<bool>())
+                return;
+            if (done.attr("cancelled")().cast<bool>()) {
+                future.attr("cancel")();
+                return;
+            }
+            py::object error = done.attr("exception")();
+            if (!error.is_none())
+                future.attr("set_exception")(error);
+            else
+                future.attr("set_result")(done.attr("result")());
+        }));
+}
+
+/// @brief Repeats the attempt on the event loop until it starts the operation. Called by the event
+/// loop with the GIL held.
+void retry_attempt(std::shared_ptr<async_attempt_t> attempt,
+                   double delay,
+                   py::object loop,
+                   py::object future) {
+    if (future.attr("done")().cast<bool>())
+        return; // cancelled by the awaiting coroutine
+
+    py::object awaitable;
+    try {
+        awaitable = (*attempt)();
+    }
+    catch (py::error_already_set &e) {
+        future.attr("set_exception")(e.value());
+        return;
+    }
+    catch (std::exception &e) {
+        future.attr("set_exception")(
+            py::module::import("builtins").attr("RuntimeError")(std::string(e.what())));
+        return;
+    }
+
+    if (awaitable.is_none()) {
+        loop.attr("call_later")(delay, py::cpp_function([attempt, delay, loop, future]() {
+                                    retry_attempt(attempt, delay, loop, future);
+                                }));
+        return;
+    }
+    chain_future(awaitable, future);
+}
+
+} // namespace
+
+py::object make_retry_awaitable(async_attempt_t attempt, std::chrono::milliseconds delay) {
+    py::object awaitable = attempt();
+    if (!awaitable.is_none())
+        return awaitable;
+
+    py::object loop   = py::module::import("asyncio").attr("get_running_loop")();
+    py::object future = loop.attr("create_future")();
+    double seconds    = std::chrono::duration<double>(delay).count();
+    loop.attr("call_later")(
+        seconds,
+        py::cpp_function([attempt = std::make_shared<async_attempt_t>(std::move(attempt)),
+                          seconds,
+                          loop,
+                          future]() {
+            retry_attempt(attempt, seconds, loop, future);
+        }));
+    return future;
+}
+
+py::object make_awaitable(async_poll_t poll, async_result_t result) {
+    py::object loop   = py::module::import("asyncio").attr("get_running_loop")();
+    py::object future = loop.attr("create_future")();
+    completion_thread::instance().submit(std::move(poll), std::move(result), loop, future);
+    return future;
+}
+
+py::object make_stop_awaitable() {
+    py::object loop   = py::module::import("asyncio").attr("get_running_loop")();
+    py::object future = loop.attr("create_future")();
+    future.attr("set_exception")(py::module::import("builtins").attr("StopAsyncIteration")());
+    return future;
+}
@@ -0,0 +1,44 @@
+//==============================================================================
+// Copyright Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+//==============================================================================
+#pragma once
+
+#include <chrono>
+#include <functional>
+
+#include "vpl/preview/defs.hpp"
+#include "vpl_python.hpp"
+
+/// Non blocking check of the asynchronous operation. Called by the completion thread without
+/// the GIL; the argument is the maximum time to block inside the runtime.
+using async_poll_t = std::function<oneapi::vpl::async_op_status(std::chrono::milliseconds)>;
+/// Produces the result of the completed operation. Called with the GIL held.
+using async_result_t = std::function<py::object()>;
+/// Starts the asynchronous operation and returns its awaitable, or None if the operation can't
+/// be started yet. Called on the event loop thread with the GIL held.
+using async_attempt_t = std::function<py::object()>;
+
+/// @brief Creates asyncio future on the running event loop which is completed by the shared
+/// completion thread once @p poll reports that the operation is finished. The completion thread
+/// polls all outstanding operations in one pass and delivers the finished ones to the event loop
+/// through call_soon_threadsafe, so no Python thread is blocked in SyncOperation.
+/// @param[in] poll Operation status check.
+/// @param[in] result Result producer.
+/// @return Awaitable future object.
+py::object make_awaitable(async_poll_t poll, async_result_t result);
+
+/// @brief Returns the awaitable produced by @p attempt. While the attempt returns None it is
+/// repeated by the running event loop after @p delay through call_later, and the returned future
+/// is completed with the outcome of the awaitable produced at last. Exceptions of the repeated
+/// attempts are set to the future.
+/// @param[in] attempt Operation start.
+/// @param[in] delay Time between the attempts.
+/// @return Awaitable future object.
+py::object make_retry_awaitable(async_attempt_t attempt, std::chrono::milliseconds delay);
+
+/// @brief Creates asyncio future on the running event loop which is already finished with
+/// StopAsyncIteration exception. Used by the asynchronous iterators to signal end of stream.
+/// @return Awaitable future object.
+py::object make_stop_awaitable();
@@ -4,6 +4,7 @@
 // SPDX-License-Identifier: MIT
 //==============================================================================
 #include "vpl/preview/bitstream.hpp"
+#include "async_completion.hpp"
 #include "vpl_python.hpp"
 namespace vpl = oneapi::vpl;
 
@@ -150,6 +151,7 @@ void init_bitstream(const py::module &m) {
             .def(py::init<vpl::codec_format_fourcc, uint32_t>())
             .def("wait",
                  &vpl::bitstream_as_dst::wait,
+                 py::call_guard<py::gil_scoped_release>(),
                  "Indefinitely waits for operation completion.")
             .def(
                 "wait_for",
@@ -157,5 +159,18 @@ void init_bitstream(const py::module &m) {
                     std::chrono::duration<int, std::milli> waitduration(milliseconds);
                     return (unsigned int)(s.wait_for(waitduration));
                 },
-                "Waits for the operation completion. Waits for the result to become available. Blocks until specified timeout_duration has elapsed or the result becomes available, whichever comes first. Returns value identifying the state of the result.");
+                py::call_guard<py::gil_scoped_release>(),
+                "Waits for the operation completion. Waits for the result to become available. Blocks until specified timeout_duration has elapsed or the result becomes available, whichever comes first. Returns value identifying the state of the result.")
+            .def(
+                "wait_async",
+                [](std::shared_ptr<vpl::bitstream_as_dst> s) {
+                    return make_awaitable(
+                        [s](std::chrono::milliseconds timeout) {
+                            return s->wait_for(timeout);
+                        },
+                        [s]() {
+                            return py::cast(s);
+                        });
+                },
+                "Returns awaitable which completes with this bitstream once the operation is finished. Must be called from the running asyncio event loop.");
 }
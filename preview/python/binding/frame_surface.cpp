@@ -4,6 +4,7 @@
 // SPDX-License-Identifier: MIT
 //==============================================================================
 #include "vpl/preview/frame_surface.hpp"
+#include "async_completion.hpp"
 #include "vpl_python.hpp"
 namespace vpl = oneapi::vpl;
 
@@ -14,22 +15,64 @@ void init_frame_surface(const py::module &m) {
             "inject",
             &vpl::frame_surface::inject,
             "Inject mfxFrameSurface1 object to take care of it. This is temporal method until VPL RT will support all functions for the internal memory allocation")
-        .def("wait", &vpl::frame_surface::wait, "Indefinitely wait for operation completion.")
+        .def("wait",
+             &vpl::frame_surface::wait,
+             py::call_guard<py::gil_scoped_release>(),
+             "Indefinitely wait for operation completion.")
         .def(
             "wait_for",
             [](vpl::frame_surface &s, int milliseconds) {
                 std::chrono::duration<int, std::milli> waitduration(milliseconds);
                 return s.wait_for(waitduration);
             },
+            py::call_guard<py::gil_scoped_release>(),
             "Waits for the operation completion. Waits for the result to become available. Blocks until specified timeout_duration has elapsed or the result becomes available, whichever comes first. Returns value identifying the state of the result.")
+        .def(
+            "wait_async",
+            [](std::shared_ptr<vpl::frame_surface> s) {
+                return make_awaitable(
+                    [s](std::chrono::milliseconds timeout) {
+                        return s->wait_for(timeout);
+                    },
+                    [s]() {
+                        return py::cast(s);
+                    });
+            },
+            "Returns awaitable which completes with this surface once the operation is finished. Must be called from the running asyncio event loop.")
         .def_property_readonly("frame_info",
                                &vpl::frame_surface::get_frame_info,
                                "Provide frame information.")
         .def_property_readonly("frame_data",
                                &vpl::frame_surface::get_frame_data,
                                "Provide frame data information.")
-        .def("map", &vpl::frame_surface::map, "Maps data to the system memory.")
-        .def("unmap", &vpl::frame_surface::unmap, "Unmaps data to the system memory.")
+        .def("map",
+             &vpl::frame_surface::map,
+             py::call_guard<py::gil_scoped_release>(),
+             "Maps data to the system memory.")
+        .def("unmap",
+             &vpl::frame_surface::unmap,
+             py::call_guard<py::gil_scoped_release>(),
+             "Unmaps data to the system memory.")
+        .def(
+            "planes",
+            [](vpl::frame_surface &s, vpl::memory_access access) {
+                auto mapped = [&]() {
+                    py::gil_scoped_release release;
+                    return s.map(access);
+                }();
+                // image_plane objects are the buffer protocol views of the mapped memory
+                return py::cast(mapped.second).attr("get_planes")(mapped.first);
+            },
+            py::arg("access") = vpl::memory_access::read,
+            py::keep_alive<0, 1>(),
+            "Maps data to the system memory and returns list of zero-copy plane views. Views are valid until unmap call.")
+        .def_property("persistent_mapping",
+                      &vpl::frame_surface::is_persistent_mapping,
+                      &vpl::frame_surface::set_persistent_mapping,
+                      "Keep system memory surface mapped between map and unmap calls.")
+        .def("flush_mapping",
+             &vpl::frame_surface::flush_mapping,
+             "Releases the mapping kept by the persistently mapped surface.")
         .def_property_readonly("native_handle",
                                &vpl::frame_surface::get_native_handle,
                                "native surface handle of the surface.")
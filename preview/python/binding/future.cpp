@@ -4,7 +4,48 @@
 // SPDX-License-Identifier: MIT
 //==============================================================================
 #include "vpl/preview/future.hpp"
+#include "async_completion.hpp"
 #include "vpl_python.hpp"
 namespace vpl = oneapi::vpl;
 
-void init_future(const py::module &m) {}
\ No newline at end of file
+template <typename Future>
+void init_future_template(const py::module &m, const char *typestr) {
+    py::class_<Future, std::shared_ptr<Future>>(m, typestr)
+        .def("wait",
+             &Future::wait,
+             py::call_guard<py::gil_scoped_release>(),
+             "Indefinitely waits for operation completion.")
+        .def(
+            "wait_for",
+            [](Future &f, int milliseconds) {
+                std::chrono::duration<int, std::milli> waitduration(milliseconds);
+                return f.wait_for(waitduration);
+            },
+            py::call_guard<py::gil_scoped_release>(),
+            "Waits for the operation completion. Waits for the result to become available. Blocks until specified timeout_duration has elapsed or the result becomes available, whichever comes first. Returns value identifying the state of the result.")
+        .def(
+            "wait_async",
+            [](std::shared_ptr<Future> f) {
+                return make_awaitable(
+                    [f](std::chrono::milliseconds timeout) {
+                        return f->wait_for(timeout);
+                    },
+                    [f]() {
+                        return py::cast(f->get());
+                    });
+            },
+            "Returns awaitable which completes with the synchronized data. Must be called from the running asyncio event loop.")
+        .def("get",
+             &Future::get,
+             py::call_guard<py::gil_scoped_release>(),
+             "Provides syncronized data. Waits indefinitely for the synchronization.")
+        .def("had_fatal", &Future::had_fatal, "Check if fatal error happened.")
+        .def_property_readonly("last_schedule_status",
+                               &Future::get_last_schedule_status,
+                               "Last operation scheduling status.");
+}
+
+void init_future(const py::module &m) {
+    init_future_template<vpl::future_surface_t>(m, "future_surface");
+    init_future_template<vpl::future_bitstream_t>(m, "future_bitstream");
+}
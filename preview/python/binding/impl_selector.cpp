@@ -29,7 +29,16 @@ void init_impl_selector(const py::module &m) {
                 list.push_back(*prop);
             }
             return new vpl::default_selector<vpl::property_list>(list);
-        }));
+        }))
+        .def("invalidate",
+             &vpl::implementation_selector::invalidate,
+             "Drops implementation remembered for this selector.")
+        .def_static(
+            "invalidate_all",
+            []() {
+                vpl::implementation_cache::instance().invalidate();
+            },
+            "Drops all remembered implementations.");
 
     py::class_<vpl::cpu_selector, vpl::implementation_selector, std::shared_ptr<vpl::cpu_selector>>(
         m,
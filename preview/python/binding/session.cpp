@@ -4,6 +4,7 @@
 // SPDX-License-Identifier: MIT
 //==============================================================================
 #include "vpl/preview/session.hpp"
+#include "async_completion.hpp"
 #include "vpl_python.hpp"
 namespace vpl = oneapi::vpl;
 
@@ -20,8 +21,14 @@ public:
                 "Verify",
                 &Class::Verify,
                 "Verifies that implementation supports such capabilities. On output, corrected capabilities are returned.")
-            .def("Init", &Class::Init, "Initializes the session by using provided parameters.")
-            .def("Reset", &Class::Reset, "Resets the session by using provided parameters.")
+            .def("Init",
+                 static_cast<vpl::status (Class::*)(VideoParams *, InitList)>(&Class::Init),
+                 py::call_guard<py::gil_scoped_release>(),
+                 "Initializes the session by using provided parameters.")
+            .def("Reset",
+                 static_cast<vpl::status (Class::*)(VideoParams *, ResetList)>(&Class::Reset),
+                 py::call_guard<py::gil_scoped_release>(),
+                 "Resets the session by using provided parameters.")
             .def("working_params", &Class::working_params, "Retrieves current session parameters.")
             .def_property_readonly("component_domain",
                                    &Class::get_component_domain,
@@ -38,17 +45,117 @@ public:
     }
 };
 
+/// @brief Iterator over the decoded frames of the session. Supports both synchronous and
+/// asynchronous iteration protocols.
+template <typename Session>
+class frame_iterator {
+public:
+    explicit frame_iterator(std::shared_ptr<Session> session) : session_(session), eos_(false) {}
+
+    /// @brief Schedules decoding of the next frame. Doesn't need the GIL.
+    /// @param[out] surface Surface which is not synchronized yet or nullptr if end of stream is
+    /// reached.
+    /// @return False if the device is busy and the call has to be repeated later.
+    bool try_schedule_next(std::shared_ptr<vpl::frame_surface> &surface) {
+        surface = nullptr;
+        while (!eos_) {
+            std::shared_ptr<vpl::frame_surface> next = std::make_shared<vpl::frame_surface>();
+            switch (session_->decode_frame(next)) {
+                case vpl::status::Ok:
+                    // frames are usually mapped several times to get planes
+                    next->set_persistent_mapping(true);
+                    surface = next;
+                    return true;
+                case vpl::status::NotEnoughData:
+                    break;
+                case vpl::status::DeviceBusy:
+                    return false;
+                default:
+                    eos_ = true;
+                    break;
+            }
+        }
+        return true;
+    }
+
+    /// @brief Schedules decoding of the next frame, retrying while the device is busy. Doesn't
+    /// need the GIL.
+    /// @return Surface which is not synchronized yet or nullptr if end of stream is reached.
+    std::shared_ptr<vpl::frame_surface> schedule_next() {
+        std::shared_ptr<vpl::frame_surface> surface;
+        while (!try_schedule_next(surface)) {
+        }
+        return surface;
+    }
+
+protected:
+    std::shared_ptr<Session> session_;
+    bool eos_;
+};
+
 template <typename Reader>
 class decode_session_template {
 public:
-    using Base    = vpl::session<vpl::decoder_video_param,
-                              vpl::decoder_init_reset_list,
-                              vpl::decoder_init_reset_list>;
-    using Class   = vpl::decode_session<Reader>;
-    using PyClass = py::class_<Class, Base, std::shared_ptr<Class>>;
+    using Base     = vpl::session<vpl::decoder_video_param,
+                               vpl::decoder_init_reset_list,
+                               vpl::decoder_init_reset_list>;
+    using Class    = vpl::decode_session<Reader>;
+    using PyClass  = py::class_<Class, Base, std::shared_ptr<Class>>;
+    using Iterator = frame_iterator<Class>;
     PyClass pyclass;
     decode_session_template(const py::module &m, const std::string &typestr)
             : pyclass(m, typestr.c_str()) {
+        py::class_<Iterator, std::shared_ptr<Iterator>>(m, (typestr + "_frame_iterator").c_str())
+            .def("__iter__",
+                 [](Iterator *self) -> Iterator & {
+                     return *self;
+                 })
+            .def("__next__",
+                 [](Iterator *self) {
+                     std::shared_ptr<vpl::frame_surface> frame;
+                     {
+                         py::gil_scoped_release release;
+                         frame = self->schedule_next();
+                         if (frame)
+                             frame->wait();
+                     }
+                     if (!frame) {
+                         throw py::stop_iteration();
+                     }
+                     return frame;
+                 })
+            .def("__aiter__",
+                 [](Iterator *self) -> Iterator & {
+                     return *self;
+                 })
+            .def("__anext__", [](std::shared_ptr<Iterator> self) {
+                // the busy device is polled by the event loop, so the other coroutines keep
+                // running meanwhile
+                return make_retry_awaitable(
+                    [self]() -> py::object {
+                        std::shared_ptr<vpl::frame_surface> frame;
+                        bool scheduled;
+                        {
+                            py::gil_scoped_release release;
+                            scheduled = self->try_schedule_next(frame);
+                        }
+                        if (!scheduled) {
+                            return py::none();
+                        }
+                        if (!frame) {
+                            return make_stop_awaitable();
+                        }
+                        return make_awaitable(
+                            [frame](std::chrono::milliseconds timeout) {
+                                return frame->wait_for(timeout);
+                            },
+                            [frame]() {
+                                return py::cast(frame);
+                            });
+                    },
+                    std::chrono::milliseconds(1));
+            });
+
         pyclass
             .def(py::init<vpl::implementation_selector &,
                           const vpl::decoder_video_param &,
@@ -57,9 +164,24 @@ public:
             .def(
                 "init_by_header",
                 &Class::init_by_header,
+                py::call_guard<py::gil_scoped_release>(),
                 "Initialize the session by using bitream portion. This step can be omitted if the codec ID is known or we don't need to get SSP or PPS data from the bitstream.")
-            .def("decode_frame", &Class::decode_frame, "Decodes frame")
-            .def("process", &Class::process, "Decodes frame")
+            .def("decode_frame",
+                 static_cast<vpl::status (Class::*)(std::shared_ptr<vpl::frame_surface>,
+                                                    vpl::decoder_process_list)>(&Class::decode_frame),
+                 py::call_guard<py::gil_scoped_release>(),
+                 "Decodes frame")
+            .def("process",
+                 static_cast<std::shared_ptr<vpl::future_surface_t> (Class::*)(
+                     vpl::decoder_process_list)>(&Class::process),
+                 py::call_guard<py::gil_scoped_release>(),
+                 "Decodes frame")
+            .def(
+                "frames",
+                [](std::shared_ptr<Class> self) {
+                    return std::make_shared<Iterator>(self);
+                },
+                "Returns iterator over decoded frames. Use it with for or async for statements.")
             .def_property_readonly("Stat", &Class::getStat, "Retrieve decoder statistic")
             .def_property_readonly("Params", &Class::getParams, "Get video params")
             .def("__iter__",
@@ -67,35 +189,44 @@ public:
                      return *self;
                  })
             .def("__next__", [](Class *self) {
-                bool is_stillgoing = true;
-                while (is_stillgoing == true) {
-                    std::shared_ptr<vpl::frame_surface> dec_surface_out =
-                        std::make_shared<vpl::frame_surface>();
-                    vpl::status ret = self->decode_frame(dec_surface_out);
-                    vpl::async_op_status st;
-                    switch (ret) {
-                        case vpl::status::Ok:
-                            do {
-                                std::chrono::duration<int, std::milli> waitduration(100);
-                                st = dec_surface_out->wait_for(waitduration);
-                                if (vpl::async_op_status::ready == st) {
-                                    return dec_surface_out;
-                                }
-                            } while (st == vpl::async_op_status::timeout);
-                            break;
-                        case vpl::status::EndOfStreamReached:
-                            is_stillgoing = false;
-                            break;
-                        case vpl::status::NotEnoughData:
-                            break;
-                        case vpl::status::DeviceBusy:
-                            break;
-                        default:
-                            is_stillgoing = false;
-                            break;
+                std::shared_ptr<vpl::frame_surface> frame;
+                {
+                    // Decoding and synchronization don't touch Python objects, so let other
+                    // Python threads run while this session waits for the runtime.
+                    py::gil_scoped_release release;
+                    bool is_stillgoing = true;
+                    while (is_stillgoing == true && !frame) {
+                        std::shared_ptr<vpl::frame_surface> dec_surface_out =
+                            std::make_shared<vpl::frame_surface>();
+                        vpl::status ret = self->decode_frame(dec_surface_out);
+                        vpl::async_op_status st;
+                        switch (ret) {
+                            case vpl::status::Ok:
+                                do {
+                                    std::chrono::duration<int, std::milli> waitduration(100);
+                                    st = dec_surface_out->wait_for(waitduration);
+                                    if (vpl::async_op_status::ready == st) {
+                                        frame = dec_surface_out;
+                                    }
+                                } while (st == vpl::async_op_status::timeout);
+                                break;
+                            case vpl::status::EndOfStreamReached:
+                                is_stillgoing = false;
+                                break;
+                            case vpl::status::NotEnoughData:
+                                break;
+                            case vpl::status::DeviceBusy:
+                                break;
+                            default:
+                                is_stillgoing = false;
+                                break;
+                        }
                     }
                 }
-                throw py::stop_iteration();
+                if (!frame) {
+                    throw py::stop_iteration();
+                }
+                return frame;
             });
     }
 };
@@ -122,17 +253,24 @@ void init_session(const py::module &m) {
              "Allocate and return shared pointer to the surface")
         //.def("sync", &vpl::encode_session::sync)
         .def("encode_frame",
-             py::overload_cast<std::shared_ptr<vpl::frame_surface>,
-                               std::shared_ptr<vpl::bitstream_as_dst>,
-                               vpl::encoder_process_list>(&vpl::encode_session::encode_frame),
+             static_cast<vpl::status (vpl::encode_session::*)(std::shared_ptr<vpl::frame_surface>,
+                                                              std::shared_ptr<vpl::bitstream_as_dst>,
+                                                              vpl::encoder_process_list)>(
+                 &vpl::encode_session::encode_frame),
+             py::call_guard<py::gil_scoped_release>(),
              "Encodes frame")
         .def("encode_frame",
-             py::overload_cast<std::shared_ptr<vpl::bitstream_as_dst>, vpl::encoder_process_list>(
+             static_cast<vpl::status (vpl::encode_session::*)(std::shared_ptr<vpl::bitstream_as_dst>,
+                                                              vpl::encoder_process_list)>(
                  &vpl::encode_session::encode_frame),
+             py::call_guard<py::gil_scoped_release>(),
              "Encodes frame by using provided source reader to get data to encode")
         .def(
             "process",
-            &vpl::encode_session::process,
+            static_cast<std::shared_ptr<vpl::future_bitstream_t> (vpl::encode_session::*)(
+                std::shared_ptr<vpl::future_surface_t>,
+                vpl::encoder_process_list)>(&vpl::encode_session::process),
+            py::call_guard<py::gil_scoped_release>(),
             "Encode frame. Function returns the future object with the bitstream which will hold processed data. User needs to sync up the future object before accessing.")
         .def_property_readonly("Stat", &vpl::encode_session::getStat, "Retrieve encoder statistic")
         .def("__iter__",
@@ -141,23 +279,32 @@ void init_session(const py::module &m) {
              })
         .def("__next__", [](vpl::encode_session *self) -> std::shared_ptr<vpl::bitstream_as_dst> {
             std::shared_ptr<vpl::bitstream_as_dst> bits = std::make_shared<vpl::bitstream_as_dst>();
-            while (true) {
-                vpl::status wrn = vpl::status::Ok;
-                wrn             = self->encode_frame(bits);
-                switch (wrn) {
-                    case vpl::status::Ok: {
-                        std::chrono::duration<int, std::milli> waitduration(100);
-                        bits->wait_for(waitduration);
-                        return bits;
-                    } break;
-                    case vpl::status::EndOfStreamReached:
-                        throw py::stop_iteration();
-                    case vpl::status::DeviceBusy:
-                        continue;
-                    default:
-                        throw py::stop_iteration();
+            bool have_data                              = false;
+            {
+                py::gil_scoped_release release;
+                bool is_stillgoing = true;
+                while (is_stillgoing == true) {
+                    vpl::status wrn = vpl::status::Ok;
+                    wrn             = self->encode_frame(bits);
+                    switch (wrn) {
+                        case vpl::status::Ok: {
+                            std::chrono::duration<int, std::milli> waitduration(100);
+                            bits->wait_for(waitduration);
+                            have_data     = true;
+                            is_stillgoing = false;
+                        } break;
+                        case vpl::status::DeviceBusy:
+                            continue;
+                        default:
+                            is_stillgoing = false;
+                            break;
+                    }
                 }
             }
+            if (!have_data) {
+                throw py::stop_iteration();
+            }
+            return bits;
         });
 
     session_template<vpl::vpp_video_param, vpl::vpp_init_reset_list, vpl::vpp_init_reset_list>(
@@ -177,7 +324,10 @@ void init_session(const py::module &m) {
              &vpl::vpp_session::alloc_output,
              "Allocate internal raw surface and attach it to the output surface")
         .def("Init",
-             &vpl::vpp_session::Init,
+             static_cast<vpl::status (vpl::vpp_session::*)(vpl::vpp_video_param *,
+                                                           vpl::vpp_init_reset_list)>(
+                 &vpl::vpp_session::Init),
+             py::call_guard<py::gil_scoped_release>(),
              "Initializes session with given parameters and extention buffers.")
         //.def("sync", &vpl::vpp_session::sync)
         .def(
@@ -185,15 +335,18 @@ void init_session(const py::module &m) {
             py::overload_cast<std::shared_ptr<vpl::frame_surface>,
                               std::shared_ptr<vpl::frame_surface> &>(
                 &vpl::vpp_session::process_frame),
+            py::call_guard<py::gil_scoped_release>(),
             "Process frame. Function returns the surface which will hold processed data. User need to sync up the surface data before accessing.")
         .def(
             "process_frame",
             py::overload_cast<std::shared_ptr<vpl::frame_surface> &>(
                 &vpl::vpp_session::process_frame),
+            py::call_guard<py::gil_scoped_release>(),
             "Process frame. Function returns the surface which will hold processed data. User need to sync up the surface data before accessing.")
         .def(
             "process",
             &vpl::vpp_session::process,
+            py::call_guard<py::gil_scoped_release>(),
             "Process frame. Function returns the future object with the surface which will hold processed data. User need to sync up the future object before accessing.")
         .def_property_readonly("Stat", &vpl::vpp_session::getStat, "Retrieve vpp statistic")
         .def("__iter__",
@@ -203,31 +356,37 @@ void init_session(const py::module &m) {
         .def("__next__", [](vpl::vpp_session *self) -> std::shared_ptr<vpl::frame_surface> {
             std::shared_ptr<vpl::frame_surface> proc_surface_out =
                 std::make_shared<vpl::frame_surface>();
-            oneapi::vpl::status wrn = oneapi::vpl::status::Ok;
-            bool is_stillgoing      = true;
-            while (is_stillgoing == true) {
-                wrn = self->process_frame(proc_surface_out);
-                switch (wrn) {
-                    case oneapi::vpl::status::Ok: {
-                        oneapi::vpl::async_op_status st;
-                        do {
-                            std::chrono::duration<int, std::milli> waitduration(100);
-                            st = proc_surface_out->wait_for(waitduration);
-                            if (oneapi::vpl::async_op_status::ready == st) {
-                                return proc_surface_out;
-                            }
-                        } while (st == oneapi::vpl::async_op_status::timeout);
-                    } break;
-                    case oneapi::vpl::status::NotEnoughBuffer:
-                        break;
-                    case oneapi::vpl::status::NotEnoughData:
-                        throw py::stop_iteration();
-                    case oneapi::vpl::status::DeviceBusy:
-                        break;
-                    default:
-                        throw py::stop_iteration();
+            bool have_data = false;
+            {
+                py::gil_scoped_release release;
+                oneapi::vpl::status wrn = oneapi::vpl::status::Ok;
+                bool is_stillgoing      = true;
+                while (is_stillgoing == true && !have_data) {
+                    wrn = self->process_frame(proc_surface_out);
+                    switch (wrn) {
+                        case oneapi::vpl::status::Ok: {
+                            oneapi::vpl::async_op_status st;
+                            do {
+                                std::chrono::duration<int, std::milli> waitduration(100);
+                                st = proc_surface_out->wait_for(waitduration);
+                                if (oneapi::vpl::async_op_status::ready == st) {
+                                    have_data = true;
+                                }
+                            } while (st == oneapi::vpl::async_op_status::timeout);
+                        } break;
+                        case oneapi::vpl::status::NotEnoughBuffer:
+                            break;
+                        case oneapi::vpl::status::DeviceBusy:
+                            break;
+                        default:
+                            is_stillgoing = false;
+                            break;
+                    }
                 }
             }
-            throw py::stop_iteration();
+            if (!have_data) {
+                throw py::stop_iteration();
+            }
+            return proc_surface_out;
         });
 }
\ No newline at end of file
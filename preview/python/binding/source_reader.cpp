@@ -3,69 +3,148 @@
 //
 // SPDX-License-Identifier: MIT
 //==============================================================================
+#if !defined(_WIN32)
+    #include <errno.h>
+    #include <unistd.h>
+#endif
+
+#include <algorithm>
+
 #include "vpl/preview/source_reader.hpp"
 #include "vpl_python.hpp"
 namespace vpl = oneapi::vpl;
 
-#if !defined(WIN32) && !defined(memcpy_s)
-    // memcpy_s proxy to allow use safe version where supported
-    #define memcpy_s(dest, destsz, src, count) memcpy(dest, src, count)
-#endif
-
-// Buffer that writes to Python instead of C++
-class pythonibuf : public std::streambuf {
-private:
-    py::object pyreadinto;
-    size_t readinto(char *s, size_t n) {
-        py::bytes wrapper(s, n);
-        py::object bytes_read = pyreadinto(wrapper);
-        if (bytes_read.is_none()) {
-            return 0;
+/// @brief Bitstream reader which takes data from the Python binary stream object.
+/// Data is stored straight into the bitstream buffer: real files are read through their file
+/// descriptor without touching the interpreter, other streams get @c readinto called with a
+/// writable memoryview of the bitstream buffer.
+class python_bitstream_reader : public vpl::bitstream_source_reader {
+public:
+    /// @brief Constructs reader with given Python stream object
+    /// @param[in] pystream Binary stream object with @c readinto method or real file object.
+    /// @param[in] buffer_size Maximum number of bytes to request from the stream in one call.
+    explicit python_bitstream_reader(py::object pystream, size_t buffer_size = 1 << 20)
+            : vpl::bitstream_source_reader(),
+              pystream_(pystream),
+              buffer_size_(buffer_size ? buffer_size : 1 << 20),
+              fd_(-1),
+              offset_(0),
+              eof_(false) {
+#if !defined(_WIN32)
+        // Streams with a seekable file descriptor are read with pread starting at the
+        // logical position of the Python object, so data it already buffered isn't lost.
+        try {
+            if (py::hasattr(pystream, "fileno") && py::hasattr(pystream, "seekable") &&
+                pystream.attr("seekable")().cast<bool>()) {
+                int fd  = pystream.attr("fileno")().cast<int>();
+                offset_ = pystream.attr("tell")().cast<int64_t>();
+                fd_     = dup(fd);
+            }
+        }
+        catch (py::error_already_set &) {
+            // io.BytesIO and friends: no file descriptor behind the stream
+            fd_ = -1;
         }
-        else {
-            return bytes_read.cast<size_t>();
+#endif
+        if (fd_ < 0) {
+            pyreadinto_ = pystream.attr("readinto");
         }
     }
 
-    std::array<char, 1024> data;
-
-    bool reload() {
-        size_t count = readinto(&data[0], data.size());
-        setg(&data[0], &data[0], &data[count]);
-        return count;
+    /// @brief Default dtor
+    virtual ~python_bitstream_reader() {
+#if !defined(_WIN32)
+        if (fd_ >= 0)
+            close(fd_);
+#endif
     }
 
-    std::streamsize xsgetn(char *s, std::streamsize n) {
-        std::streamsize bytes_read = 0;
-        while (n) {
-            char *cptr = gptr();
-            char *eptr = egptr();
-            if (cptr == eptr && !reload()) {
-                return bytes_read;
-            }
-            std::streamsize len = eptr - cptr;
-            if (len > n) {
-                len = n;
+    /// @brief Read and store portion of data into the @p bitstream object
+    /// @param[out] bits data storage
+    /// @return True if data was read
+    bool get_data(vpl::bitstream_as_src *bits) {
+        auto lambda = [&](uint8_t *ptr, uint32_t max, bool &eos) {
+            size_t count = (fd_ >= 0) ? read_fd(ptr, max) : read_stream(ptr, max);
+            if (count < max) {
+                eof_ = true;
+                eos  = true;
             }
-            memcpy_s(s, n, cptr, len);
-            gbump(static_cast<int>(len));
-            n -= len;
-            bytes_read += len;
-        }
-        return bytes_read;
+            return (uint32_t)count;
+        };
+        bits->pull_in(lambda);
+        return true;
     }
 
-    int_type underflow() {
-        return (gptr() == egptr() && !reload()) ? traits_type::eof() : *gptr();
+    /// @brief Checks and retrieve end of stream status
+    /// @return True if EOS reached
+    bool is_EOS() const {
+        return eof_;
     }
 
-    int_type uflow() {
-        return (gptr() == egptr() && !reload()) ? traits_type::eof() : *gptr();
+    /// @brief Checks whether data is read through the file descriptor
+    /// @return True if Python interpreter isn't involved in the reading
+    bool is_direct() const {
+        return fd_ >= 0;
     }
 
-public:
-    explicit pythonibuf(py::object pyistream, size_t buffer_size = 1024)
-            : pyreadinto(pyistream.attr("readinto")) {}
+protected:
+    /// @brief Read data through the file descriptor. Doesn't need the GIL.
+    /// @param[in] ptr Pointer to the buffer to store the data
+    /// @param[in] max Size of the buffer
+    /// @return Number of bytes read
+    size_t read_fd(uint8_t *ptr, size_t max) {
+        size_t total = 0;
+#if !defined(_WIN32)
+        while (total < max) {
+            ssize_t count = pread(fd_, ptr + total, max - total, offset_);
+            if (count < 0 && errno == EINTR)
+                continue;
+            if (count <= 0)
+                break;
+            total += count;
+            offset_ += count;
+        }
+#endif
+        return total;
+    }
+
+    /// @brief Read data by calling @c readinto of the Python stream.
+    /// @param[in] ptr Pointer to the buffer to store the data
+    /// @param[in] max Size of the buffer
+    /// @return Number of bytes read
+    size_t read_stream(uint8_t *ptr, size_t max) {
+        // Reads are issued from native code which may run with the GIL released.
+        py::gil_scoped_acquire acquire;
+        size_t total = 0;
+        while (total < max) {
+            size_t chunk = std::min(max - total, buffer_size_);
+            py::memoryview view =
+                py::memoryview::from_memory(ptr + total, static_cast<py::ssize_t>(chunk), false);
+            py::object bytes_read = pyreadinto_(view);
+            // the stream must not keep access to the bitstream buffer
+            view.attr("release")();
+            if (bytes_read.is_none())
+                break;
+            size_t count = bytes_read.cast<size_t>();
+            if (count == 0)
+                break;
+            total += count;
+        }
+        return total;
+    }
+
+    /// Python stream object.
+    py::object pystream_;
+    /// Bound @c readinto method of the stream.
+    py::object pyreadinto_;
+    /// Maximum size of the single readinto request.
+    size_t buffer_size_;
+    /// Duplicated file descriptor of the stream or -1.
+    int fd_;
+    /// Read position in the file.
+    int64_t offset_;
+    /// End of stream flag.
+    bool eof_;
 };
 
 void init_source_reader(const py::module &m) {
@@ -132,4 +211,12 @@ void init_source_reader(const py::module &m) {
         .def_property_readonly("data",
                                &vpl::bitstream_file_reader_name::get_data,
                                "Read and store portion of data into the @p bitstream object");
+
+    py::class_<python_bitstream_reader,
+               vpl::bitstream_source_reader,
+               std::shared_ptr<python_bitstream_reader>>(m, "bitstream_stream_reader")
+        .def(py::init<py::object, size_t>(), py::arg("stream"), py::arg("buffer_size") = 1 << 20)
+        .def_property_readonly("is_direct",
+                               &python_bitstream_reader::is_direct,
+                               "True if stream is read through its file descriptor.");
 }
\ No newline at end of file
@@ -0,0 +1,108 @@
+# pylint: disable=import-error,invalid-name
+# ==============================================================================
+#  Copyright Intel Corporation
+#
+#  SPDX-License-Identifier: MIT
+# ==============================================================================
+"""
+Test frame iterators and asyncio integration
+"""
+import unittest
+import asyncio
+import os
+import pyvpl
+
+# Folder this script is in
+SCRIPT_PATH = os.path.realpath(
+    os.path.join(os.getcwd(), os.path.dirname(__file__)))
+
+# Folder content is in
+CONTENT_PATH = os.path.join(SCRIPT_PATH, '..', '..', '..', 'examples',
+                            'content')
+HEVC_CLIP = os.path.join(CONTENT_PATH, 'cars_128x96.h265')
+
+
+def create_decoder(source):
+    """Create HEVC decoder reading from the source"""
+    opts = pyvpl.properties()
+    opts.impl = pyvpl.implementation_type.sw
+    opts.api_version = (2, 5)
+    opts.decoder.codec_id = [pyvpl.codec_format_fourcc.hevc]
+    sel_default = pyvpl.default_selector(opts)
+
+    params = pyvpl.decoder_video_param()
+    params.IOPattern = pyvpl.io_pattern.out_system_memory
+    params.CodecId = pyvpl.codec_format_fourcc.hevc
+    decoder = pyvpl.decode_session(sel_default, params, source)
+    decoder.init_by_header(pyvpl.decoder_init_header_list(),
+                           pyvpl.decoder_init_reset_list())
+    return decoder
+
+
+async def count_frames_async():
+    """Decode the clip with async for statement"""
+    frame_count = 0
+    with pyvpl.bitstream_file_reader_name(HEVC_CLIP) as source:
+        decoder = create_decoder(source)
+        async for frame in decoder.frames():
+            planes = frame.planes(pyvpl.memory_access.read)
+            if frame_count == 0:
+                assert memoryview(planes[0]).nbytes > 0
+            frame_count += 1
+            frame.unmap()
+            frame = None
+    return frame_count
+
+
+class TestAsync(unittest.TestCase):
+    """
+    Test frames() iterator and awaitable waits
+    """
+    def test_frames(self):
+        """Synchronous iteration over decoded frames"""
+        frame_count = 0
+        with pyvpl.bitstream_file_reader_name(HEVC_CLIP) as source:
+            decoder = create_decoder(source)
+            for frame in decoder.frames():
+                planes = frame.planes(pyvpl.memory_access.read)
+                # Y plane view points straight to the surface memory
+                view = memoryview(planes[0])
+                self.assertEqual(view.shape, (128, 96))
+                view.release()
+                frame.unmap()
+                frame_count += 1
+                frame = None
+        self.assertEqual(frame_count, 60)
+
+    def test_async_frames(self):
+        """Asynchronous iteration over decoded frames"""
+        self.assertEqual(asyncio.run(count_frames_async()), 60)
+
+    def test_concurrent_sessions(self):
+        """Several sessions are awaited from one event loop"""
+        async def run_all():
+            return await asyncio.gather(count_frames_async(),
+                                        count_frames_async(),
+                                        count_frames_async())
+
+        self.assertEqual(asyncio.run(run_all()), [60, 60, 60])
+
+    def test_wait_async(self):
+        """Surface returned by decode_frame can be awaited"""
+        async def decode_first():
+            with pyvpl.bitstream_file_reader_name(HEVC_CLIP) as source:
+                decoder = create_decoder(source)
+                while True:
+                    surface = pyvpl.frame_surface()
+                    status = decoder.decode_frame(surface,
+                                                  pyvpl.decoder_process_list())
+                    if status == pyvpl.status.Ok:
+                        return await surface.wait_async()
+
+        frame = asyncio.run(decode_first())
+        self.assertIsNotNone(frame)
+        frame = None
+
+
+if __name__ == '__main__':
+    unittest.main()
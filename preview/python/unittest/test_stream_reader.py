@@ -0,0 +1,76 @@
+# pylint: disable=import-error,invalid-name
+# ==============================================================================
+#  Copyright Intel Corporation
+#
+#  SPDX-License-Identifier: MIT
+# ==============================================================================
+"""
+Test decoding from Python stream objects
+"""
+import unittest
+import io
+import os
+import pyvpl
+
+# Folder this script is in
+SCRIPT_PATH = os.path.realpath(
+    os.path.join(os.getcwd(), os.path.dirname(__file__)))
+
+# Folder content is in
+CONTENT_PATH = os.path.join(SCRIPT_PATH, '..', '..', '..', 'examples',
+                            'content')
+HEVC_CLIP = os.path.join(CONTENT_PATH, 'cars_128x96.h265')
+
+
+def count_frames(source):
+    """Decode whole stream provided by the source and return frame count"""
+    opts = pyvpl.properties()
+    opts.impl = pyvpl.implementation_type.sw
+    opts.api_version = (2, 5)
+    opts.decoder.codec_id = [pyvpl.codec_format_fourcc.hevc]
+    sel_default = pyvpl.default_selector(opts)
+
+    params = pyvpl.decoder_video_param()
+    params.IOPattern = pyvpl.io_pattern.out_system_memory
+    params.CodecId = pyvpl.codec_format_fourcc.hevc
+    decoder = pyvpl.decode_session(sel_default, params, source)
+    decoder.init_by_header(pyvpl.decoder_init_header_list(),
+                           pyvpl.decoder_init_reset_list())
+    frame_count = 0
+    for frame in decoder:
+        frame_count += 1
+        frame = None
+    return frame_count
+
+
+class TestStreamReader(unittest.TestCase):
+    """
+    Test bitstream_stream_reader
+    """
+    def test_file_object(self):
+        """Real files are read through the file descriptor"""
+        with open(HEVC_CLIP, "rb") as f:
+            source = pyvpl.bitstream_stream_reader(f)
+            self.assertTrue(source.is_direct)
+            self.assertEqual(count_frames(source), 60)
+
+    def test_buffered_file_position(self):
+        """Reading starts at the current position of the file object"""
+        with open(HEVC_CLIP, "rb") as f:
+            source = pyvpl.bitstream_stream_reader(f)
+            self.assertEqual(count_frames(source), 60)
+            # the file object itself isn't advanced
+            self.assertEqual(f.tell(), 0)
+
+    def test_memory_stream(self):
+        """Streams without file descriptor are read with readinto"""
+        with open(HEVC_CLIP, "rb") as f:
+            stream = io.BytesIO(f.read())
+        source = pyvpl.bitstream_stream_reader(stream, buffer_size=4096)
+        self.assertFalse(source.is_direct)
+        self.assertEqual(count_frames(source), 60)
+        self.assertTrue(source.is_EOS())
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,89 @@
+# pylint: disable=import-error,invalid-name
+# ==============================================================================
+#  Copyright Intel Corporation
+#
+#  SPDX-License-Identifier: MIT
+# ==============================================================================
+"""
+Test concurrent sessions driven from Python threads
+"""
+import unittest
+import os
+import sys
+import threading
+import pyvpl
+
+# Folder this script is in
+SCRIPT_PATH = os.path.realpath(
+    os.path.join(os.getcwd(), os.path.dirname(__file__)))
+
+# Folder content is in
+CONTENT_PATH = os.path.join(SCRIPT_PATH, '..', '..', '..', 'examples',
+                            'content')
+HEVC_CLIP = os.path.join(CONTENT_PATH, 'cars_128x96.h265')
+
+THREAD_COUNT = 4
+
+
+def decode_clip(index, barrier, events, counts):
+    """Decode the clip and record the order frames were delivered in"""
+    opts = pyvpl.properties()
+    opts.impl = pyvpl.implementation_type.sw
+    opts.api_version = (2, 5)
+    opts.decoder.codec_id = [pyvpl.codec_format_fourcc.hevc]
+    sel_default = pyvpl.default_selector(opts)
+
+    with pyvpl.bitstream_file_reader_name(HEVC_CLIP) as source:
+        params = pyvpl.decoder_video_param()
+        params.IOPattern = pyvpl.io_pattern.out_system_memory
+        params.CodecId = pyvpl.codec_format_fourcc.hevc
+        decoder = pyvpl.decode_session(sel_default, params, source)
+        decoder.init_by_header(pyvpl.decoder_init_header_list(),
+                               pyvpl.decoder_init_reset_list())
+        barrier.wait()
+        for frame in decoder:
+            events.append(index)
+            counts[index] += 1
+            frame = None
+
+
+class TestThreading(unittest.TestCase):
+    """
+    Test that blocking calls don't hold the interpreter lock
+    """
+    def test_parallel_decode(self):
+        """Decode sessions running in threads make progress together"""
+        barrier = threading.Barrier(THREAD_COUNT)
+        events = []
+        counts = [0] * THREAD_COUNT
+        threads = [
+            threading.Thread(target=decode_clip,
+                             args=(i, barrier, events, counts))
+            for i in range(THREAD_COUNT)
+        ]
+
+        # With a huge switch interval the interpreter never preempts a
+        # thread, so the sessions can only interleave if the native calls
+        # release the GIL themselves.
+        switch_interval = sys.getswitchinterval()
+        sys.setswitchinterval(60)
+        try:
+            for thread in threads:
+                thread.start()
+            for thread in threads:
+                thread.join()
+        finally:
+            sys.setswitchinterval(switch_interval)
+
+        self.assertEqual(counts, [60] * THREAD_COUNT)
+        # every session delivered a frame before any other session finished
+        first = [events.index(i) for i in range(THREAD_COUNT)]
+        last = [
+            len(events) - 1 - events[::-1].index(i)
+            for i in range(THREAD_COUNT)
+        ]
+        self.assertLess(max(first), min(last))
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -7,6 +7,8 @@
 #ifndef _ABSTRACT_SPL_H__
 #define _ABSTRACT_SPL_H__
 
+#include <vector>
+
 #include "vm/strings_defs.h"
 #include "vpl/mfxstructures.h"
 
@@ -27,6 +29,10 @@ struct FrameSplitterInfo {
     mfxU8* Data; // including data of slices
     mfxU32 DataLength;
     mfxU64 TimeStamp;
+
+    mfxU64 SourceOffset; // position of the first byte of the frame in the input since Reset
+    mfxI32 PicOrderCnt; // output order of the frame within its coded video sequence
+    bool KeyFrame; // decoding can start at the frame (AVC IDR, HEVC IRAP, AV1 key frame)
 };
 
 class AbstractSplitter {
@@ -42,6 +48,12 @@ public:
     virtual mfxStatus PostProcessing(FrameSplitterInfo* frame, mfxU32 sliceNum) = 0;
 
     virtual void ResetCurrentState() = 0;
+
+    // Parameter sets in effect at the current position of the input, as NAL units with start
+    // codes. Placed in front of a key frame they make the stream decodable from that frame.
+    virtual void GetHeaders(std::vector<mfxU8>& headers) {
+        headers.clear();
+    }
 };
 
 #endif // _ABSTRACT_SPL_H__
@@ -0,0 +1,103 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#ifndef __ASYNC_FILE_WRITER_H__
+#define __ASYNC_FILE_WRITER_H__
+
+#include <stdio.h>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "vpl/mfxdefs.h"
+#include "vm/strings_defs.h"
+
+enum AsyncWriteSync {
+    ASYNC_WRITE_SYNC_NONE = 0, // leave flushing to the OS
+    ASYNC_WRITE_SYNC_CLOSE, // fdatasync once when the writer is stopped
+    ASYNC_WRITE_SYNC_ALWAYS, // fdatasync after every write
+};
+
+struct AsyncWriteParams {
+    mfxU32 BufferSize; // size of one pooled buffer, small payloads are coalesced up to it
+    mfxU32 NumBuffers; // buffers in the pool, bounds the data queued to the writer thread
+    AsyncWriteSync Sync;
+};
+
+// Writes data to a file on a separate thread.
+// Write copies the payload into pooled buffers, full buffers are queued to the writer
+// thread which writes them with one call each. The caller blocks only when all buffers
+// are queued. The first failure of the writer thread is returned by the next Write, Flush
+// or Stop call.
+class CAsyncFileWriter {
+public:
+    struct Statistics {
+        mfxU64 bytes; // bytes passed to Write
+        mfxU64 writes; // buffers written to the file
+        mfxU64 maxQueueDepth; // maximum number of buffers waiting for the writer thread
+        mfxU64 queueDepthSum; // sum of the queue depths seen by the submitted buffers
+        mfxU64 bufferWaits; // times Write waited for a free buffer
+        mfxF64 bufferWaitTime; // seconds
+        mfxF64 writeTime; // seconds spent in the file writes including fdatasync
+        mfxF64 maxWriteTime; // seconds
+    };
+
+    CAsyncFileWriter();
+    virtual ~CAsyncFileWriter();
+
+    static AsyncWriteParams GetDefaultParams();
+
+    // Starts writing to f, the file stays owned by the caller
+    mfxStatus Start(FILE* f, const AsyncWriteParams& params);
+    // Writes the queued data, waits for the writer thread and stops it
+    mfxStatus Stop();
+    bool IsStarted() const {
+        return m_thread.joinable();
+    }
+
+    mfxStatus Write(const mfxU8* data, mfxU32 size);
+    // Waits until all data passed to Write is written to the file
+    mfxStatus Flush();
+
+    Statistics GetStatistics() const;
+    void PrintStatistics(const msdk_char* prefix) const;
+
+private:
+    struct Buffer {
+        std::vector<mfxU8> data;
+        mfxU32 size;
+    };
+
+    void ThreadRoutine();
+    mfxStatus AcquireBuffer();
+    void SubmitBuffer();
+
+    FILE* m_file;
+    AsyncWriteParams m_params;
+    std::vector<std::unique_ptr<Buffer>> m_buffers;
+    std::deque<Buffer*> m_free;
+    std::deque<Buffer*> m_queue;
+    Buffer* m_current; // buffer filled by Write, owned by the caller thread
+    mfxU32 m_busy; // buffers taken by the writer thread
+
+    std::thread m_thread;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cvQueued; // signaled when a buffer is queued or on stop
+    std::condition_variable m_cvWritten; // signaled when a buffer is written
+    bool m_bStop;
+    mfxStatus m_status;
+
+    Statistics m_stat;
+
+private:
+    CAsyncFileWriter(const CAsyncFileWriter&);
+    void operator=(const CAsyncFileWriter&);
+};
+
+#endif //__ASYNC_FILE_WRITER_H__
@@ -0,0 +1,111 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#ifndef __AV1_SPL_H__
+#define __AV1_SPL_H__
+
+#include <vector>
+
+#include "abstract_splitter.h"
+
+namespace ProtectedLibrary {
+
+enum AV1_OBU_Type {
+    AV1_OBU_SEQUENCE_HEADER        = 1,
+    AV1_OBU_TEMPORAL_DELIMITER     = 2,
+    AV1_OBU_FRAME_HEADER           = 3,
+    AV1_OBU_TILE_GROUP             = 4,
+    AV1_OBU_METADATA               = 5,
+    AV1_OBU_FRAME                  = 6,
+    AV1_OBU_REDUNDANT_FRAME_HEADER = 7,
+    AV1_OBU_TILE_LIST              = 8,
+    AV1_OBU_PADDING                = 15
+};
+
+enum AV1StreamFormat {
+    AV1_FORMAT_UNKNOWN = 0,
+    // low overhead bitstream format (AV1 specification section 5), OBUs with obu_size
+    AV1_FORMAT_LOW_OVERHEAD,
+    // length delimited temporal units, frame units and OBUs (AV1 specification annex B)
+    AV1_FORMAT_ANNEXB
+};
+
+struct AV1ObuHeader {
+    mfxU8 obu_type;
+    mfxU8 obu_extension_flag;
+    mfxU8 obu_has_size_field;
+    mfxU8 temporal_id;
+    mfxU8 spatial_id;
+};
+
+// Reads leb128() at most size bytes long. Returns MFX_ERR_MORE_DATA if the value continues
+// after size bytes and MFX_ERR_UNDEFINED_BEHAVIOR if it is longer than 8 bytes or doesn't
+// fit 32 bits.
+mfxStatus ReadLeb128(const mfxU8* data, mfxU32 size, mfxU32& value, mfxU32& length);
+
+// Writes value as leb128() with the minimal number of bytes, returns the number of bytes
+mfxU32 WriteLeb128(mfxU8* data, mfxU32 value);
+
+// Reads obu_header(), headerSize is 1 or 2 bytes with the extension
+mfxStatus ReadObuHeader(const mfxU8* data, mfxU32 size, AV1ObuHeader& header, mfxU32& headerSize);
+
+// Returns true if the low overhead temporal unit is a random access point: it has a sequence
+// header and its first frame is a shown key frame
+bool IsAV1KeyFrame(const mfxU8* data, mfxU32 size);
+
+// Splits AV1 elementary streams into temporal units. Temporal units are returned in the
+// low overhead format the decoder expects, OBUs of annex B streams get obu_size fields.
+// The format is detected from the beginning of the stream unless it is given. Key frames
+// carry the sequence header, there are no separate headers to restart the stream with.
+class AV1_Spl : public AbstractSplitter {
+public:
+    explicit AV1_Spl(AV1StreamFormat format = AV1_FORMAT_UNKNOWN);
+
+    virtual ~AV1_Spl();
+
+    virtual mfxStatus Reset();
+
+    // Low overhead temporal units are returned in place, the frame data points into bs_in
+    // and stays valid until the bitstream is changed
+    virtual mfxStatus GetFrame(mfxBitstream* bs_in, FrameSplitterInfo** frame);
+
+    virtual mfxStatus PostProcessing(FrameSplitterInfo* frame, mfxU32 sliceNum);
+
+    virtual void ResetCurrentState();
+
+    AV1StreamFormat GetFormat() const {
+        return m_format;
+    }
+
+protected:
+    mfxStatus DetectFormat(const mfxBitstream* bs);
+
+    mfxStatus GetLowOverheadTemporalUnit(mfxBitstream* bs);
+    mfxStatus GetAnnexBTemporalUnit(mfxBitstream* bs);
+
+    // Appends the OBU with obu_size to the current frame
+    mfxStatus AppendObu(const mfxU8* obu, mfxU32 obuLength);
+
+    void SetFrame(mfxU8* data, mfxU32 size, const mfxBitstream* bs);
+
+    AV1StreamFormat m_initialFormat;
+    AV1StreamFormat m_format;
+
+    // bytes consumed from the input since Reset and temporal units returned
+    mfxU64 m_streamOffset;
+    mfxI32 m_frameOrder;
+
+    // bytes of the complete OBUs of the current low overhead temporal unit, the scan of
+    // the bitstream resumes after them when more data is read
+    mfxU32 m_scanned;
+
+    std::vector<mfxU8> m_currentFrame;
+    FrameSplitterInfo m_frame;
+};
+
+} // namespace ProtectedLibrary
+
+#endif // __AV1_SPL_H__
@@ -10,22 +10,18 @@
 #include "avc_structures.h"
 #include "vpl/mfxstructures.h"
 
-namespace ProtectedLibrary {
-
-#define AVCPeek1Bit(current_data, offset) ((current_data[0] >> (offset)) & 1)
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
 
-#define AVCDrop1Bit(current_data, offset) \
-    {                                     \
-        offset -= 1;                      \
-        if (offset < 0) {                 \
-            offset = 31;                  \
-            current_data += 1;            \
-        }                                 \
-    }
+namespace ProtectedLibrary {
 
 // NAL unit definitions
 enum { NAL_STORAGE_IDC_BITS = 0x60, NAL_UNITTYPE_BITS = 0x1f };
 
+// Reads RBSP data (NAL unit payload without emulation prevention bytes) in stream order.
+// Up to 64 bits are cached in a register and refilled in bulk. Reading past maxsize returns
+// zero bits, which end the header syntax loops or fail Exp-Golomb codes.
 class AVCBaseBitstream {
 public:
     AVCBaseBitstream();
@@ -34,16 +30,22 @@ public:
 
     // Reset the bitstream with new data pointer
     void Reset(mfxU8* const pb, mfxU32 maxsize);
-    void Reset(mfxU8* const pb, mfxI32 offset, mfxU32 maxsize);
 
+    // Reads 0 to 32 bits
     inline mfxU32 GetBits(mfxU32 nbits);
 
-    // Read one VLC mfxI32 or mfxU32 value from bitstream
-    mfxI32 GetVLCElement(bool bIsSigned);
+    // Read one VLC mfxI32 or mfxU32 value from bitstream, codes with more than 31 leading
+    // zeros throw AVC_exception
+    inline mfxI32 GetVLCElement(bool bIsSigned);
 
     // Reads one bit from the buffer.
     inline mfxU32 Get1Bit();
 
+    // Returns the next 0 to 32 bits without reading them
+    inline mfxU32 PeekBits(mfxU32 nbits);
+
+    inline void SkipBits(mfxU32 nbits);
+
     // Check amount of data
     bool More_RBSP_Data();
 
@@ -57,9 +59,15 @@ public:
     void AlignPointerRight(void);
 
 protected:
-    mfxU32* m_pbs; // pointer to the current position of the buffer.
-    mfxI32 m_bitOffset; // the bit position (0 to 31) in the dword pointed by m_pbs.
-    mfxU32* m_pbsBase; // pointer to the first byte of the buffer.
+    // Fills the cache with at least 57 bits
+    inline void Refill();
+    void RefillTail();
+    void SetBitPosition(mfxU32 position);
+
+    mfxU64 m_cache; // next bits of the buffer starting from the most significant bit.
+    mfxU32 m_cachedBits; // number of valid bits in m_cache.
+    mfxU32 m_byteOffset; // offset of the first byte not loaded into m_cache.
+    const mfxU8* m_pbsBase; // pointer to the first byte of the buffer.
     mfxU32 m_maxBsSize; // maximum buffer size in bytes.
 };
 
@@ -119,76 +127,108 @@ private:
 
 void SetDefaultScalingLists(AVCSeqParamSet* sps);
 
-extern const mfxU32 bits_data[];
-
-#define _avcGetBits(current_data, offset, nbits, data) \
-    {                                                  \
-        mfxU32 x;                                      \
-                                                       \
-        SAMPLE_ASSERT((nbits) > 0 && (nbits) <= 32);   \
-        SAMPLE_ASSERT(offset >= 0 && offset <= 31);    \
-                                                       \
-        offset -= (nbits);                             \
-                                                       \
-        if (offset >= 0) {                             \
-            x = current_data[0] >> (offset + 1);       \
-        }                                              \
-        else {                                         \
-            offset += 32;                              \
-                                                       \
-            x = current_data[1] >> (offset);           \
-            x >>= 1;                                   \
-            x += current_data[0] << (31 - offset);     \
-            current_data++;                            \
-        }                                              \
-                                                       \
-        SAMPLE_ASSERT(offset >= 0 && offset <= 31);    \
-                                                       \
-        (data) = x & bits_data[nbits];                 \
+// Number of zero bits above the most significant set bit, value must not be zero
+inline mfxU32 CountLeadingZeros(mfxU64 value) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    #if defined(_M_X64) || defined(_M_ARM64)
+    _BitScanReverse64(&index, value);
+    return 63 - index;
+    #else
+    if (value >> 32) {
+        _BitScanReverse(&index, (unsigned long)(value >> 32));
+        return 31 - index;
     }
+    _BitScanReverse(&index, (unsigned long)value);
+    return 63 - index;
+    #endif
+#else
+    return __builtin_clzll(value);
+#endif
+}
 
-#define avcGetBits1(current_data, offset, data)     \
-    {                                               \
-        data = ((current_data[0] >> (offset)) & 1); \
-        offset -= 1;                                \
-        if (offset < 0) {                           \
-            offset = 31;                            \
-            current_data += 1;                      \
-        }                                           \
+inline void AVCBaseBitstream::Refill() {
+    if (m_byteOffset + 8 > m_maxBsSize) {
+        RefillTail();
+        return;
     }
 
-#define avcUngetNBits(current_data, offset, nbits)  \
-    {                                               \
-        SAMPLE_ASSERT(offset >= 0 && offset <= 31); \
-                                                    \
-        offset += (nbits);                          \
-        if (offset > 31) {                          \
-            offset -= 32;                           \
-            current_data--;                         \
-        }                                           \
-                                                    \
-        SAMPLE_ASSERT(offset >= 0 && offset <= 31); \
-    }
+    // bytes are composed in stream order, which also works on big-endian hosts. The bits
+    // below m_cachedBits already in the cache are the same stream bits, so or-ing is safe.
+    const mfxU8* p = m_pbsBase + m_byteOffset;
+    mfxU64 bits    = ((mfxU64)p[0] << 56) | ((mfxU64)p[1] << 48) | ((mfxU64)p[2] << 40) |
+                  ((mfxU64)p[3] << 32) | ((mfxU64)p[4] << 24) | ((mfxU64)p[5] << 16) |
+                  ((mfxU64)p[6] << 8) | (mfxU64)p[7];
+    mfxU32 bytes = (64 - m_cachedBits) >> 3;
+
+    m_cache |= bits >> m_cachedBits;
+    m_byteOffset += bytes;
+    m_cachedBits += bytes * 8;
+}
 
-#define avcGetNBits(current_data, offset, nbits, data) \
-    _avcGetBits(current_data, offset, nbits, data);
+inline mfxU32 AVCBaseBitstream::PeekBits(mfxU32 nbits) {
+    SAMPLE_ASSERT(nbits <= 32);
+    if (m_cachedBits < nbits)
+        Refill();
+    // two shifts to support nbits equal to 0
+    return (mfxU32)((m_cache >> 1) >> (63 - nbits));
+}
 
-inline mfxU32 AVCBaseBitstream::GetBits(mfxU32 nbits) {
-    mfxU32 w, n = nbits;
+inline void AVCBaseBitstream::SkipBits(mfxU32 nbits) {
+    if (nbits >= m_cachedBits) {
+        SetBitPosition(BitsDecoded() + nbits);
+        return;
+    }
+    m_cache <<= nbits;
+    m_cachedBits -= nbits;
+}
 
-    avcGetNBits(m_pbs, m_bitOffset, n, w);
+inline mfxU32 AVCBaseBitstream::GetBits(mfxU32 nbits) {
+    mfxU32 w = PeekBits(nbits);
+    m_cache <<= nbits;
+    m_cachedBits -= nbits;
     return w;
 }
 
 inline mfxU32 AVCBaseBitstream::Get1Bit() {
-    mfxU32 w;
-    avcGetBits1(m_pbs, m_bitOffset, w);
-    return w;
+    return GetBits(1);
 
 } // AVCBitstream::Get1Bit()
 
+inline mfxI32 AVCBaseBitstream::GetVLCElement(bool bIsSigned) {
+    if (m_cachedBits < 32)
+        Refill();
+    // the cache keeps zero bits past the end of the data, so zero means more than 56 zeros
+    mfxU32 zeros = m_cache ? CountLeadingZeros(m_cache) : 64;
+    if (zeros > 31)
+        throw AVC_exception(MFX_ERR_UNDEFINED_BEHAVIOR);
+
+    // codeword is 2^zeros + info, value is codeword - 1
+    mfxU32 length = 2 * zeros + 1;
+    mfxU32 sval;
+    if (length <= m_cachedBits) {
+        sval = (mfxU32)(m_cache >> (64 - length)) - 1;
+        m_cache <<= length;
+        m_cachedBits -= length;
+    }
+    else {
+        SkipBits(zeros);
+        sval = GetBits(zeros + 1) - 1;
+    }
+
+    if (!bIsSigned)
+        return (mfxI32)sval;
+    if (sval & 1)
+        return (mfxI32)((sval + 1) >> 1);
+    return -((mfxI32)(sval >> 1));
+}
+
+inline mfxU32 AVCBaseBitstream::BitsDecoded() {
+    return m_byteOffset * 8 - m_cachedBits;
+}
+
 inline mfxU32 AVCBaseBitstream::BytesDecoded() {
-    return static_cast<mfxU32>((mfxU8*)m_pbs - (mfxU8*)m_pbsBase) + ((31 - m_bitOffset) >> 3);
+    return BitsDecoded() >> 3;
 }
 
 inline mfxU32 AVCBaseBitstream::BytesLeft() {
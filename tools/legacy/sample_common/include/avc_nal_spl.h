@@ -11,11 +11,12 @@
 
 namespace ProtectedLibrary {
 
-class BytesSwapper {
-public:
-    static void SwapMemory(mfxU8* pDestination, mfxU32& nDstSize, mfxU8* pSource, mfxU32 nSrcSize);
-};
-
+// Splits Annex B byte streams into NAL units. NAL units are returned as views into the
+// source bitstream: the data before source DataOffset must stay unchanged until the next
+// call. A NAL unit without the following start code stays in the source until more data is
+// appended after it or the source is flagged MFX_BITSTREAM_COMPLETE_FRAME or
+// MFX_BITSTREAM_EOS. An unfinished NAL unit longer than the suggested size is truncated to
+// it: its beginning is copied and returned instead of a view, the rest is dropped.
 class StartCodeIterator {
 public:
     StartCodeIterator();
@@ -30,13 +31,25 @@ public:
 
     mfxI32 GetNALUnit(mfxBitstream* source, mfxBitstream* destination);
 
-    mfxI32 EndOfStream(mfxBitstream* destination);
+    // Number of bytes dropped from the end of the last returned NAL unit
+    mfxU32 GetDroppedSize() const {
+        return m_droppedSize;
+    }
 
 private:
-    std::vector<mfxU8> m_prev;
     mfxU32 m_code;
     mfxU64 m_pts;
 
+    // the unfinished NAL unit starts at source DataOffset, m_scanned bytes after its start
+    // code are already searched for the next start code
+    mfxU32 m_startCodeSize;
+    mfxU32 m_scanned;
+
+    // beginning of the truncated NAL unit, the source is skipped up to the next start code
+    std::vector<mfxU8> m_truncated;
+    bool m_bTruncated;
+    mfxU32 m_droppedSize;
+
     mfxU8* m_pSource;
     mfxU32 m_nSourceSize;
 
@@ -45,6 +58,7 @@ private:
 
     mfxU32 m_suggestedSize;
 
+    mfxI32 GetTruncatedNALUnit(mfxBitstream* source, mfxBitstream* destination);
     mfxI32 FindStartCode(mfxU8*(&pb), mfxU32& size, mfxI32& startCodeSize);
 };
 
@@ -58,6 +72,8 @@ public:
     virtual void Release();
 
     virtual mfxI32 CheckNalUnitType(mfxBitstream* source);
+    // destination is a view into source, see StartCodeIterator. It is NULL if there is no
+    // complete NAL unit, the returned code is the AVC NAL unit type and can be zero.
     virtual mfxI32 GetNalUnits(mfxBitstream* source, mfxBitstream*& destination);
 
     virtual void Reset();
@@ -66,16 +82,32 @@ public:
         m_pStartCodeIter.SetSuggestedSize(size);
     }
 
+    // Position of the 00 00 01 start code of the last returned NAL unit, counted in bytes
+    // consumed from the sources since Reset
+    mfxU64 GetNalUnitOffset() const {
+        return m_nalUnitOffset;
+    }
+
 protected:
     StartCodeIterator m_pStartCodeIter;
 
     mfxBitstream m_bitstream;
+
+    mfxU64 m_streamOffset;
+    mfxU64 m_nalUnitOffset;
 };
 
-void SwapMemoryAndRemovePreventingBytes(mfxU8* pDestination,
-                                        mfxU32& nDstSize,
-                                        mfxU8* pSource,
-                                        mfxU32 nSrcSize);
+// Start code and emulation prevention scanning shared by the Annex B splitters
+
+// Moves pb past the next 00 00 01 start code and returns true. startCodeSize is 4 if
+// the start code is preceded by a zero byte and 3 otherwise. If there is no start code
+// followed by at least one byte, pb is moved to the zero bytes at the end of the data,
+// which can begin a start code completed by the next data (up to 3 bytes), and false is
+// returned. size is set to the number of bytes from pb to the end of the data.
+bool FindNextStartCode(mfxU8*(&pb), mfxU32& size, mfxI32& startCodeSize);
+
+// Copies nSrcSize bytes without emulation prevention bytes, returns the copied size
+mfxU32 RemovePreventingBytes(mfxU8* pDestination, const mfxU8* pSource, mfxU32 nSrcSize);
 
 } //namespace ProtectedLibrary
 
@@ -8,6 +8,7 @@
 #define _AVC_SPL_H__
 
 #include <list>
+#include <map>
 #include <memory>
 #include <vector>
 
@@ -75,6 +76,8 @@ public:
 
     void ResetCurrentState();
 
+    virtual void GetHeaders(std::vector<mfxU8>& headers);
+
 protected:
     std::unique_ptr<NALUnitSplitter> m_pNALSplitter;
 
@@ -91,8 +94,19 @@ protected:
 
     AVCFrameInfo* GetFreeFrame();
 
-    mfxU8* GetMemoryForSwapping(mfxU32 size);
+    // Keeps the parameter set NAL unit for GetHeaders, rank orders the sets by type
+    void KeepHeader(mfxU32 rank, mfxU32 id, const mfxBitstream* nalUnit);
+
+    // PicOrderCnt of the picture starting with the slice (8.2.1), the memory management
+    // operation 5 isn't parsed and doesn't reset the count
+    mfxI32 CalculatePicOrderCnt(AVCSlice* slice);
+
+    // Copies up to maxSize bytes of the NAL unit without emulation prevention bytes for the
+    // header parsers
+    mfxU8* ExtractRbsp(mfxBitstream* nalUnit, mfxU32 maxSize, mfxU32& rbspSize);
 
+    // grows the frame buffer up to MAX_BUFFER_SIZE to append size bytes
+    mfxStatus ReserveFrameData(mfxU32 size);
     mfxStatus AddNalUnit(mfxBitstream* nalUnit);
     mfxStatus AddSliceNalUnit(mfxBitstream* nalUnit, AVCSlice* pSlice);
     bool IsFieldOfOneFrame(AVCFrameInfo* frame,
@@ -108,10 +122,24 @@ protected:
 
     mfxBitstream* m_lastNalUnit;
 
-    enum { BUFFER_SIZE = 1024 * 1024 };
+    // stream positions of the NAL unit being added and of m_lastNalUnit
+    mfxU64 m_nalUnitOffset;
+    mfxU64 m_lastNalUnitOffset;
+
+    // state of the picture order count decoding
+    mfxI32 m_prevPicOrderCntMsb;
+    mfxI32 m_prevPicOrderCntLsb;
+    mfxI32 m_prevFrameNumOffset;
+    mfxI32 m_prevFrameNum;
+
+    std::map<mfxU32, std::vector<mfxU8>> m_headerNalUnits;
+
+    enum { BUFFER_SIZE = 1024 * 1024, MAX_BUFFER_SIZE = 64 * 1024 * 1024 };
+    // slice data isn't parsed, longer slice headers are parsed again from the whole NAL unit
+    enum { SLICE_HEADER_PREFIX_SIZE = 1024 };
 
     std::vector<mfxU8> m_currentFrame;
-    std::vector<mfxU8> m_swappingMemory;
+    std::vector<mfxU8> m_rbspMemory;
     std::list<AVCSlice> m_slicesStorage;
 
     std::vector<SliceSplitterInfo> m_slices;
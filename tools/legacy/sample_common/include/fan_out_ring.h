@@ -0,0 +1,359 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#ifndef __FAN_OUT_RING_H__
+#define __FAN_OUT_RING_H__
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <thread>
+
+#include "vpl/mfxdefs.h"
+
+#include "vm/atomic_defs.h"
+
+/** \brief Bounded ring handing every value of one producer to all consumers (SPMC).
+ *
+ * Every consumer reads the values in order with a cursor of its own. A slot keeps the mask of
+ * the consumers which haven't released its value yet, the consumer clearing the last bit
+ * disposes of the value and frees the slot. The producer waits for the slot pushed a lap ago
+ * to be free, so the slowest consumer throttles it. Waiting threads spin for a while and then
+ * sleep on the futex of the value they wait for.
+ *
+ * A consumer leaving early cancels itself, its values are released and later ones aren't
+ * handed to it. Init and Reset are not thread-safe, Reset of a single consumer must not run
+ * concurrently with Push. All other functions may be called concurrently by the producer and
+ * the consumers.
+ */
+template <class T>
+class msdkFanOutRing {
+public:
+    enum { MaxConsumers = 32, SpinCount = 1000 };
+
+    typedef std::function<void(T&)> Disposer;
+
+    struct Statistics {
+        mfxU32 Occupancy; // values not released by all consumers
+        mfxU32 MaxOccupancy;
+        mfxU64 Pushed;
+        mfxU64 ProducerStalls; // pushes which waited for a free slot
+        mfxU64 ConsumerSleeps; // waits of consumers which went to sleep
+    };
+
+    msdkFanOutRing()
+            : m_Slots(),
+              m_Cursors(),
+              m_Mask(0),
+              m_NumConsumers(0),
+              m_Dispose(),
+              m_Head(0),
+              m_Active(0),
+              m_ProducerSleepers(0),
+              m_ConsumerSleepers(0),
+              m_MaxOccupancy(0),
+              m_Pushed(0),
+              m_ProducerStalls(0),
+              m_ConsumerSleeps(0) {}
+
+    /** \brief The function allocates the slots, the capacity is rounded up to a power of two.
+     *
+     * The values released by all consumers are passed to dispose.
+     */
+    mfxStatus Init(mfxU32 capacity, mfxU32 numConsumers, Disposer dispose = Disposer()) {
+        if (!capacity || capacity > 0x80000000 || !numConsumers || numConsumers > MaxConsumers)
+            return MFX_ERR_UNSUPPORTED;
+
+        mfxU32 size = 1;
+        while (size < capacity)
+            size <<= 1;
+
+        m_Slots.reset(new Slot[size]);
+        m_Cursors.reset(new Cursor[numConsumers]);
+        m_Mask         = size - 1;
+        m_NumConsumers = numConsumers;
+        m_Dispose      = dispose;
+        Reset();
+        return MFX_ERR_NONE;
+    }
+
+    /** \brief The function drops all values without disposing of them and activates the
+     * cancelled consumers again.
+     */
+    void Reset() {
+        for (mfxU32 i = 0; i <= m_Mask; i++)
+            m_Slots[i].pending.store(0, std::memory_order_relaxed);
+        for (mfxU32 i = 0; i < m_NumConsumers; i++)
+            m_Cursors[i].position.store(0, std::memory_order_relaxed);
+        m_Head.store(0, std::memory_order_relaxed);
+        m_Active.store(m_NumConsumers == MaxConsumers ? ~0u : (1u << m_NumConsumers) - 1);
+    }
+
+    /** \brief The function releases the values of the consumer and activates it again if it
+     * was cancelled.
+     *
+     * The other consumers keep their values and cursors, they may run meanwhile.
+     */
+    void Reset(mfxU32 consumer) {
+        mfxU32 bit     = 1u << consumer;
+        Cursor& cursor = m_Cursors[consumer];
+        mfxU32 head    = m_Head.load();
+        for (mfxU32 position = cursor.position.load(std::memory_order_relaxed); position != head;
+             position++)
+            ReleaseSlot(m_Slots[position & m_Mask], bit);
+        cursor.position.store(head, std::memory_order_release);
+        m_Active.fetch_or(bit);
+    }
+
+    /** \brief The function hands the value to the active consumers.
+     *
+     * @return MFX_TASK_WORKING if no slot was freed within msec milliseconds, MFX_ERR_ABORTED if
+     * all consumers are cancelled. The value is not pushed then.
+     */
+    mfxStatus Push(const T& value, mfxU32 msec) {
+        mfxU32 head = m_Head.load(std::memory_order_relaxed);
+        Slot& slot  = m_Slots[head & m_Mask];
+
+        if (slot.pending.load(std::memory_order_acquire)) {
+            m_ProducerStalls.fetch_add(1, std::memory_order_relaxed);
+            bool bFree = Wait(
+                slot.pending,
+                [&slot]() {
+                    return !slot.pending.load(std::memory_order_acquire);
+                },
+                m_ProducerSleepers,
+                msec);
+            if (!bFree)
+                return MFX_TASK_WORKING;
+        }
+
+        mfxU32 consumers = m_Active.load();
+        if (!consumers)
+            return MFX_ERR_ABORTED;
+
+        slot.value = value;
+        slot.pending.store(consumers, std::memory_order_relaxed);
+        m_Head.store(head + 1);
+        if (m_ConsumerSleepers.load())
+            msdk_atomic_wake32(Address(m_Head));
+
+        // a consumer cancelled meanwhile may have missed the value, it is released for it
+        mfxU32 cancelled = consumers & ~m_Active.load();
+        if (cancelled)
+            ReleaseSlot(slot, cancelled);
+
+        mfxU32 occupancy = GetOccupancy();
+        if (occupancy > m_MaxOccupancy.load(std::memory_order_relaxed))
+            m_MaxOccupancy.store(occupancy, std::memory_order_relaxed);
+        m_Pushed.fetch_add(1, std::memory_order_relaxed);
+        return MFX_ERR_NONE;
+    }
+
+    /** \brief The function returns the oldest value the consumer hasn't released.
+     *
+     * The producer may peek too, the value stays in the slot until the consumer releases it.
+     * @return MFX_ERR_MORE_DATA if there is no such value or the consumer is cancelled.
+     */
+    mfxStatus Peek(mfxU32 consumer, T& value) const {
+        if (!IsActive(consumer))
+            return MFX_ERR_MORE_DATA;
+        mfxU32 position = m_Cursors[consumer].position.load(std::memory_order_acquire);
+        if (position == m_Head.load(std::memory_order_acquire))
+            return MFX_ERR_MORE_DATA;
+        value = m_Slots[position & m_Mask].value;
+        return MFX_ERR_NONE;
+    }
+
+    /** \brief The function waits for a value to peek.
+     *
+     * @return MFX_TASK_WORKING if no value was pushed within msec milliseconds,
+     * MFX_ERR_ABORTED if the consumer is cancelled.
+     */
+    mfxStatus Wait(mfxU32 consumer, mfxU32 msec) {
+        if (!IsActive(consumer))
+            return MFX_ERR_ABORTED;
+
+        const Cursor& cursor = m_Cursors[consumer];
+        auto ready           = [this, &cursor]() {
+            return cursor.position.load(std::memory_order_relaxed) !=
+                   m_Head.load(std::memory_order_acquire);
+        };
+        if (ready())
+            return MFX_ERR_NONE;
+        return Wait(m_Head, ready, m_ConsumerSleepers, msec, &m_ConsumerSleeps) ? MFX_ERR_NONE
+                                                                                : MFX_TASK_WORKING;
+    }
+
+    /** \brief The function releases the oldest value of the consumer.
+     *
+     * @return MFX_ERR_MORE_DATA if the consumer has no values.
+     */
+    mfxStatus Release(mfxU32 consumer) {
+        if (!IsActive(consumer))
+            return MFX_ERR_MORE_DATA;
+
+        Cursor& cursor  = m_Cursors[consumer];
+        mfxU32 position = cursor.position.load(std::memory_order_relaxed);
+        if (position == m_Head.load(std::memory_order_acquire))
+            return MFX_ERR_MORE_DATA;
+
+        cursor.position.store(position + 1, std::memory_order_release);
+        ReleaseSlot(m_Slots[position & m_Mask], 1u << consumer);
+        return MFX_ERR_NONE;
+    }
+
+    // Releases all values of the consumer, it gets no values since then
+    void Cancel(mfxU32 consumer) {
+        mfxU32 bit = 1u << consumer;
+        if (!(m_Active.fetch_and(~bit) & bit))
+            return;
+
+        // values pushed after the cancellation was seen by the producer don't wait for it
+        Cursor& cursor = m_Cursors[consumer];
+        mfxU32 head    = m_Head.load();
+        for (mfxU32 position = cursor.position.load(std::memory_order_relaxed); position != head;
+             position++)
+            ReleaseSlot(m_Slots[position & m_Mask], bit);
+        cursor.position.store(head, std::memory_order_release);
+    }
+
+    // Number of values the consumer hasn't released
+    mfxU32 GetLength(mfxU32 consumer) const {
+        if (!IsActive(consumer))
+            return 0;
+        return m_Head.load(std::memory_order_acquire) -
+               m_Cursors[consumer].position.load(std::memory_order_acquire);
+    }
+
+    mfxU32 GetCapacity() const {
+        return m_Mask + 1;
+    }
+
+    Statistics GetStatistics() const {
+        Statistics stat;
+        stat.Occupancy      = GetOccupancy();
+        stat.MaxOccupancy   = m_MaxOccupancy.load(std::memory_order_relaxed);
+        stat.Pushed         = m_Pushed.load(std::memory_order_relaxed);
+        stat.ProducerStalls = m_ProducerStalls.load(std::memory_order_relaxed);
+        stat.ConsumerSleeps = m_ConsumerSleeps.load(std::memory_order_relaxed);
+        return stat;
+    }
+
+private:
+    // the slots and the cursors are written by different threads, each takes a cache line
+    struct alignas(64) Slot {
+        Slot() : value(), pending(0) {}
+        T value;
+        std::atomic<mfxU32> pending; // mask of the consumers which haven't released the value
+    };
+
+    struct alignas(64) Cursor {
+        Cursor() : position(0) {}
+        std::atomic<mfxU32> position; // number of the values released by the consumer
+    };
+
+    static volatile mfxU32* Address(std::atomic<mfxU32>& word) {
+        return reinterpret_cast<volatile mfxU32*>(&word);
+    }
+
+    inline bool IsActive(mfxU32 consumer) const {
+        return (m_Active.load(std::memory_order_relaxed) >> consumer) & 1;
+    }
+
+    // Clears the bits of the consumers, the value is disposed of by whoever clears the last one.
+    // A bit may be cleared twice if the consumer is cancelled, the second time changes nothing.
+    void ReleaseSlot(Slot& slot, mfxU32 bits) {
+        T value;
+        mfxU32 pending = slot.pending.load(std::memory_order_acquire);
+        do {
+            if (!(pending & bits))
+                return;
+            // the producer may overwrite the slot as soon as the last bit is cleared
+            if (!(pending & ~bits))
+                value = slot.value;
+        } while (!slot.pending.compare_exchange_weak(pending, pending & ~bits));
+
+        if (pending & ~bits)
+            return;
+        if (m_Dispose)
+            m_Dispose(value);
+        if (m_ProducerSleepers.load())
+            msdk_atomic_wake32(Address(slot.pending));
+    }
+
+    // Spins and then sleeps on the futex of the word until the condition is met, the threads
+    // changing the word wake up the sleepers
+    template <class Condition>
+    static bool Wait(std::atomic<mfxU32>& word,
+                     Condition ready,
+                     std::atomic<mfxU32>& sleepers,
+                     mfxU32 msec,
+                     std::atomic<mfxU64>* pSleeps = NULL) {
+        for (mfxU32 i = 0; i < SpinCount; i++) {
+            if (ready())
+                return true;
+            if (i % 64 == 63)
+                std::this_thread::yield();
+        }
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(msec);
+        if (pSleeps)
+            pSleeps->fetch_add(1, std::memory_order_relaxed);
+        for (;;) {
+            mfxU32 observed = word.load();
+            if (ready())
+                return true;
+            auto now = std::chrono::steady_clock::now();
+            if (now >= deadline)
+                return false;
+
+            // the word is read again by the futex, a change after the check wakes up at once
+            sleepers.fetch_add(1);
+            if (!ready()) {
+                auto left =
+                    std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count();
+                msdk_atomic_wait32(Address(word), observed, (mfxU32)left + 1);
+            }
+            sleepers.fetch_sub(1);
+        }
+    }
+
+    mfxU32 GetOccupancy() const {
+        mfxU32 head      = m_Head.load(std::memory_order_acquire);
+        mfxU32 occupancy = 0;
+        mfxU32 active    = m_Active.load(std::memory_order_relaxed);
+        for (mfxU32 i = 0; i < m_NumConsumers; i++) {
+            if ((active >> i) & 1) {
+                mfxU32 length = head - m_Cursors[i].position.load(std::memory_order_relaxed);
+                if (length > occupancy)
+                    occupancy = length;
+            }
+        }
+        return occupancy;
+    }
+
+    std::unique_ptr<Slot[]> m_Slots;
+    std::unique_ptr<Cursor[]> m_Cursors;
+    mfxU32 m_Mask;
+    mfxU32 m_NumConsumers;
+    Disposer m_Dispose;
+
+    alignas(64) std::atomic<mfxU32> m_Head; // number of the pushed values
+    std::atomic<mfxU32> m_Active; // mask of the consumers which aren't cancelled
+    std::atomic<mfxU32> m_ProducerSleepers;
+    std::atomic<mfxU32> m_ConsumerSleepers;
+
+    std::atomic<mfxU32> m_MaxOccupancy;
+    std::atomic<mfxU64> m_Pushed;
+    std::atomic<mfxU64> m_ProducerStalls;
+    std::atomic<mfxU64> m_ConsumerSleeps;
+
+    msdkFanOutRing(const msdkFanOutRing&);
+    void operator=(const msdkFanOutRing&);
+};
+
+#endif // __FAN_OUT_RING_H__
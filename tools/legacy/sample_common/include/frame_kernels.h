@@ -0,0 +1,88 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#ifndef __FRAME_KERNELS_H__
+#define __FRAME_KERNELS_H__
+
+#include <stddef.h>
+#include "vpl/mfxdefs.h"
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+// Conversion kernels for raw frame data used by the YUV readers and writers, and
+// scanning kernels for the elementary stream splitters.
+// Every kernel has a scalar version and SSE4.2, AVX2 and AVX-512 versions on x86;
+// the best version supported by the CPU is selected at runtime.
+namespace FrameKernels {
+
+enum Isa { ISA_SCALAR = 0, ISA_SSE42, ISA_AVX2, ISA_AVX512, ISA_COUNT };
+
+struct KernelTable {
+    // uv[2 * i] = u[i], uv[2 * i + 1] = v[i] for i < count
+    void (*InterleaveUV)(const mfxU8* u, const mfxU8* v, mfxU8* uv, mfxU32 count);
+    // u[i] = uv[2 * i], v[i] = uv[2 * i + 1] for i < count
+    void (*DeinterleaveUV)(const mfxU8* uv, mfxU8* u, mfxU8* v, mfxU32 count);
+    // dst[i] = src[i] << shift, src and dst may be the same buffer
+    void (*ShiftLeft16)(const mfxU16* src, mfxU16* dst, mfxU32 count, mfxU32 shift);
+    // dst[i] = src[i] >> shift, src and dst may be the same buffer
+    void (*ShiftRight16)(const mfxU16* src, mfxU16* dst, mfxU32 count, mfxU32 shift);
+    // Packs 4:2:2 planar samples into Y210/Y216 layout (Y0 U Y1 V), every sample is
+    // shifted left by shift. count is the number of pixel pairs.
+    void (*PackY210)(const mfxU16* y,
+                     const mfxU16* u,
+                     const mfxU16* v,
+                     mfxU16* dst,
+                     mfxU32 count,
+                     mfxU32 shift);
+    // Packs 4:4:4 planar 10-bit samples into Y410 words with opaque alpha
+    void (*PackY410)(const mfxU16* y, const mfxU16* u, const mfxU16* v, mfxU32* dst, mfxU32 count);
+    // Swaps R and B channels of count 32-bit pixels (RGB4 <-> BGR4), src and dst may be the
+    // same buffer
+    void (*SwapRB32)(const mfxU8* src, mfxU8* dst, mfxU32 count);
+    // Returns the offset of the first 0x00 0x00 value sequence in data or size if there is
+    // none. Finds start codes (value 1) and emulation prevention bytes (value 3).
+    mfxU32 (*FindZeroZeroByte)(const mfxU8* data, mfxU32 size, mfxU8 value);
+};
+
+// Index of the lowest set bit, mask must not be zero
+inline mfxU32 LowestSetBit(mfxU64 mask) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    if ((mfxU32)mask) {
+        _BitScanForward(&index, (mfxU32)mask);
+        return (mfxU32)index;
+    }
+    _BitScanForward(&index, (mfxU32)(mask >> 32));
+    return (mfxU32)index + 32;
+#else
+    return (mfxU32)__builtin_ctzll(mask);
+#endif
+}
+
+// Returns kernels built for the instruction set or NULL if they aren't available in this build
+const KernelTable* GetKernels(Isa isa);
+
+// Returns true if kernels for the instruction set are built and supported by the CPU
+bool IsIsaSupported(Isa isa);
+
+// Returns the best instruction set supported by the CPU
+Isa GetBestIsa();
+
+// Returns kernels for the best instruction set, selected once per process
+const KernelTable& Kernels();
+
+const char* GetIsaName(Isa isa);
+
+// Per instruction set tables, defined in frame_kernels_<isa>.cpp
+const KernelTable* GetKernelsSSE42();
+const KernelTable* GetKernelsAVX2();
+const KernelTable* GetKernelsAVX512();
+
+} // namespace FrameKernels
+
+#endif //__FRAME_KERNELS_H__
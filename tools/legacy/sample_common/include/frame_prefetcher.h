@@ -0,0 +1,120 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#ifndef __FRAME_PREFETCHER_H__
+#define __FRAME_PREFETCHER_H__
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "sample_utils.h"
+#include "sysmem_allocator.h"
+
+// Reads raw frames ahead of the pipeline on a dedicated I/O thread.
+// The thread fills a bounded ring of system memory frames with the loader callback,
+// the pipeline takes frames from the ring either by copying them into its own surface
+// (LoadNextFrame) or by using the ring surface directly (AcquireFrame/ReleaseFrame).
+// A status other than MFX_ERR_NONE returned by the loader (MFX_ERR_MORE_DATA at the end
+// of the file) is queued after the frames read before it and returned to every
+// following request until the prefetcher is restarted.
+class CFramePrefetcher {
+public:
+    typedef std::function<mfxStatus(mfxFrameSurface1* pSurface)> LoadFunc;
+
+    struct Statistics {
+        mfxU64 frames; // frames passed to the pipeline
+        mfxU64 inputWaits; // requests which found the ring empty
+        mfxU64 ringFullWaits; // times the I/O thread waited for a free slot
+        mfxF64 inputWaitTime; // time the pipeline spent waiting for input, seconds
+        mfxF64 readTime; // time the I/O thread spent in the loader, seconds
+    };
+
+    CFramePrefetcher();
+    virtual ~CFramePrefetcher();
+
+    // Allocates depth frames described by info and starts the I/O thread
+    mfxStatus Start(const mfxFrameInfo& info, mfxU32 depth, LoadFunc load);
+    // Stops the I/O thread and drops the frames read ahead
+    void Stop();
+    bool IsStarted() const {
+        return m_thread.joinable();
+    }
+
+    // Waits for the next frame and copies it into pSurface, which must have the same
+    // format and size as the ring frames
+    mfxStatus LoadNextFrame(mfxFrameSurface1* pSurface);
+    // Waits for the next frame and returns the ring surface holding it. The surface stays
+    // valid until ReleaseFrame, other frames are read ahead meanwhile.
+    mfxStatus AcquireFrame(mfxFrameSurface1** ppSurface);
+    void ReleaseFrame();
+
+    Statistics GetStatistics() const;
+    void PrintStatistics(const msdk_char* prefix) const;
+
+private:
+    struct Slot {
+        mfxFrameSurface1 surface;
+        mfxStatus status;
+    };
+
+    void ThreadRoutine();
+    void FreeFrames();
+
+    SysMemFrameAllocator m_allocator;
+    mfxFrameAllocResponse m_response;
+    std::vector<Slot> m_ring;
+    LoadFunc m_load;
+
+    std::thread m_thread;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cvFilled; // signaled when a slot is filled
+    std::condition_variable m_cvFreed; // signaled when a slot is released or on stop
+    mfxU32 m_head; // oldest filled slot
+    mfxU32 m_filled; // number of filled slots
+    bool m_bAcquired; // the pipeline holds m_ring[m_head]
+    bool m_bStop;
+
+    Statistics m_stat;
+
+private:
+    CFramePrefetcher(const CFramePrefetcher&);
+    void operator=(const CFramePrefetcher&);
+};
+
+// YUV reader which reads frames ahead on a separate thread.
+// Behaves as CSmplYUVReader when the depth is 0 or several views are read (MVC).
+class CPrefetchYUVReader : public CSmplYUVReader {
+public:
+    CPrefetchYUVReader();
+    virtual ~CPrefetchYUVReader();
+
+    // Number of frames to read ahead, must be set before the first frame is loaded
+    void SetPrefetchDepth(mfxU32 depth) {
+        m_depth = depth;
+    }
+    mfxU32 GetPrefetchDepth() const {
+        return m_depth;
+    }
+
+    virtual void Close();
+    virtual mfxStatus SkipNframesFromBeginning(mfxU16 w, mfxU16 h, mfxU32 viewId, mfxU32 nframes);
+    virtual mfxStatus LoadNextFrame(mfxFrameSurface1* pSurface);
+    virtual void Reset();
+
+    const CFramePrefetcher& GetPrefetcher() const {
+        return m_prefetcher;
+    }
+
+protected:
+    CFramePrefetcher m_prefetcher;
+    mfxU32 m_depth;
+};
+
+#endif //__FRAME_PREFETCHER_H__
@@ -0,0 +1,43 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#ifndef __HEVC_BITSTREAM_H__
+#define __HEVC_BITSTREAM_H__
+
+#include "avc_bitstream.h"
+#include "hevc_structures.h"
+
+namespace ProtectedLibrary {
+
+// Parses HEVC parameter sets and slice segment headers from RBSP data, the data starts with
+// the two byte NAL unit header. Invalid values return MFX_ERR_UNDEFINED_BEHAVIOR, truncated
+// data throws AVC_exception like AVCHeadersBitstream.
+class HEVCHeadersBitstream : public AVCBaseBitstream {
+public:
+    HEVCHeadersBitstream();
+    HEVCHeadersBitstream(mfxU8* const pb, const mfxU32 maxsize);
+
+    mfxStatus GetNalUnitHeader(HEVCNalUnitHeader* nal);
+
+    mfxStatus GetVideoParamSet(HEVCVideoParamSet* vps);
+    mfxStatus GetSequenceParamSet(HEVCSeqParamSet* sps);
+    mfxStatus GetPictureParamSet(HEVCPicParamSet* pps);
+
+    // Reads first_slice_segment_in_pic_flag, no_output_of_prior_pics_flag and
+    // slice_pic_parameter_set_id, the NAL unit header must be read into hdr->nal
+    mfxStatus GetSliceHeaderPart1(HEVCSliceHeader* hdr);
+    // Reads the rest of the header up to slice_pic_order_cnt_lsb
+    mfxStatus GetSliceHeaderPart2(HEVCSliceHeader* hdr,
+                                  const HEVCPicParamSet* pps,
+                                  const HEVCSeqParamSet* sps);
+
+private:
+    void GetProfileTierLevel(HEVCSeqParamSet* sps, mfxU32 maxSubLayers);
+};
+
+} // namespace ProtectedLibrary
+
+#endif // __HEVC_BITSTREAM_H__
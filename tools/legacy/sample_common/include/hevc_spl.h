@@ -0,0 +1,113 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#ifndef __HEVC_SPL_H__
+#define __HEVC_SPL_H__
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "abstract_splitter.h"
+
+#include "avc_headers.h"
+#include "avc_nal_spl.h"
+#include "hevc_bitstream.h"
+
+namespace ProtectedLibrary {
+
+// Splits HEVC Annex B byte streams into access units (ITU-T H.265 7.4.2.4.4). Frames start
+// at the first random access point, RASL pictures which can't be decoded after it are
+// dropped. Slice data isn't parsed, slice HeaderLength covers the start code and the NAL
+// unit header only.
+class HEVC_Spl : public AbstractSplitter {
+public:
+    HEVC_Spl();
+
+    virtual ~HEVC_Spl();
+
+    virtual mfxStatus Reset();
+
+    virtual mfxStatus GetFrame(mfxBitstream* bs_in, FrameSplitterInfo** frame);
+
+    virtual mfxStatus PostProcessing(FrameSplitterInfo* frame, mfxU32 sliceNum);
+
+    virtual void ResetCurrentState();
+
+    virtual void GetHeaders(std::vector<mfxU8>& headers);
+
+    // Header of the first slice segment of the frame returned by GetFrame
+    const HEVCSliceHeader* GetPictureHeader() const {
+        return &m_picture;
+    }
+
+protected:
+    std::unique_ptr<NALUnitSplitter> m_pNALSplitter;
+
+    // Returns MFX_ERR_NONE if the NAL unit starts the next access unit, the current frame
+    // is complete then and the NAL unit is processed by the next GetFrame
+    mfxStatus ProcessNalUnit(mfxBitstream* nalUnit);
+    mfxStatus ProcessSlice(mfxBitstream* nalUnit, const HEVCSliceHeader& slice);
+    mfxStatus ProcessNonVclNalUnit(mfxBitstream* nalUnit, const HEVCNalUnitHeader& nal);
+
+    void DecodeHeader(mfxBitstream* nalUnit);
+    void KeepHeader(mfxU32 type, mfxU32 id, const mfxBitstream* nalUnit);
+    bool DecodeSliceHeader(mfxBitstream* nalUnit, const HEVCNalUnitHeader& nal, HEVCSliceHeader* hdr);
+
+    // Derives PicOrderCntVal of the first slice segment, returns false if the picture is
+    // skipped
+    bool StartPicture(HEVCSliceHeader* hdr);
+    bool IsNewPicture(const HEVCSliceHeader& slice) const;
+
+    // Copies up to maxSize bytes of the NAL unit without emulation prevention bytes
+    mfxU8* ExtractRbsp(mfxBitstream* nalUnit, mfxU32 maxSize, mfxU32& rbspSize);
+
+    mfxStatus ReserveFrameData(mfxU32 size);
+    mfxStatus AddNalUnit(mfxBitstream* nalUnit);
+    mfxStatus AddSliceNalUnit(mfxBitstream* nalUnit, const HEVCSliceHeader& slice);
+
+    HeaderSet<HEVCVideoParamSet> m_videoParams;
+    HeaderSet<HEVCSeqParamSet> m_seqParams;
+    HeaderSet<HEVCPicParamSet> m_picParams;
+
+    // parameter set NAL units with start codes for GetHeaders, ordered by type and id
+    std::map<mfxU32, std::vector<mfxU8>> m_headerNalUnits;
+
+    bool m_WaitForIRAP;
+    // the next picture starts a coded video sequence, a CRA picture has NoRaslOutputFlag
+    bool m_firstInSequence;
+    bool m_NoRaslOutputFlag;
+    // PicOrderCntVal of the previous TemporalId 0 picture (prevTid0Pic)
+    mfxI32 m_prevTid0Poc;
+
+    HEVCSliceHeader m_picture;
+    bool m_skipPicture;
+    mfxU8 m_lastSliceType;
+
+    // the NAL unit which starts the next access unit, a view into the source bitstream
+    mfxBitstream m_pendingNalUnit;
+    HEVCNalUnitHeader m_pendingNal;
+    HEVCSliceHeader m_pendingSlice;
+    bool m_hasPendingNalUnit;
+
+    // stream positions of the NAL unit being added and of the pending NAL unit
+    mfxU64 m_nalUnitOffset;
+    mfxU64 m_pendingNalUnitOffset;
+
+    enum { BUFFER_SIZE = 1024 * 1024, MAX_BUFFER_SIZE = 64 * 1024 * 1024 };
+    // the slice segment header is parsed up to slice_pic_order_cnt_lsb, which is shorter
+    enum { SLICE_HEADER_PREFIX_SIZE = 64 };
+
+    std::vector<mfxU8> m_currentFrame;
+    std::vector<mfxU8> m_rbspMemory;
+
+    std::vector<SliceSplitterInfo> m_slices;
+    FrameSplitterInfo m_frame;
+};
+
+} // namespace ProtectedLibrary
+
+#endif // __HEVC_SPL_H__
@@ -0,0 +1,174 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#ifndef __HEVC_STRUCTURES_H__
+#define __HEVC_STRUCTURES_H__
+
+#include "vpl/mfxstructures.h"
+
+namespace ProtectedLibrary {
+
+// NAL unit types, ITU-T H.265 Table 7-1
+enum HEVC_NAL_Unit_Type {
+    HEVC_NAL_UT_TRAIL_N        = 0,
+    HEVC_NAL_UT_TRAIL_R        = 1,
+    HEVC_NAL_UT_TSA_N          = 2,
+    HEVC_NAL_UT_TSA_R          = 3,
+    HEVC_NAL_UT_STSA_N         = 4,
+    HEVC_NAL_UT_STSA_R         = 5,
+    HEVC_NAL_UT_RADL_N         = 6,
+    HEVC_NAL_UT_RADL_R         = 7,
+    HEVC_NAL_UT_RASL_N         = 8,
+    HEVC_NAL_UT_RASL_R         = 9,
+    HEVC_NAL_UT_RSV_VCL_N14    = 14,
+    HEVC_NAL_UT_BLA_W_LP       = 16,
+    HEVC_NAL_UT_BLA_W_RADL     = 17,
+    HEVC_NAL_UT_BLA_N_LP       = 18,
+    HEVC_NAL_UT_IDR_W_RADL     = 19,
+    HEVC_NAL_UT_IDR_N_LP       = 20,
+    HEVC_NAL_UT_CRA            = 21,
+    HEVC_NAL_UT_RSV_IRAP_VCL23 = 23,
+    HEVC_NAL_UT_RSV_VCL31      = 31,
+    HEVC_NAL_UT_VPS            = 32,
+    HEVC_NAL_UT_SPS            = 33,
+    HEVC_NAL_UT_PPS            = 34,
+    HEVC_NAL_UT_AUD            = 35,
+    HEVC_NAL_UT_EOS            = 36,
+    HEVC_NAL_UT_EOB            = 37,
+    HEVC_NAL_UT_FD             = 38,
+    HEVC_NAL_UT_PREFIX_SEI     = 39,
+    HEVC_NAL_UT_SUFFIX_SEI     = 40,
+    HEVC_NAL_UT_RSV_NVCL41     = 41,
+    HEVC_NAL_UT_RSV_NVCL44     = 44,
+    HEVC_NAL_UT_UNSPEC48       = 48,
+    HEVC_NAL_UT_UNSPEC55       = 55
+};
+
+enum HEVCSliceType { HEVC_SLICE_B = 0, HEVC_SLICE_P = 1, HEVC_SLICE_I = 2 };
+
+enum {
+    HEVC_MAX_NUM_VPS         = 16,
+    HEVC_MAX_NUM_SPS         = 16,
+    HEVC_MAX_NUM_PPS         = 64,
+    HEVC_MAX_SUB_LAYERS      = 7,
+    HEVC_MAX_PIC_WIDTH_LUMA  = 16888,
+    HEVC_MAX_PIC_HEIGHT_LUMA = 16888
+};
+
+// Only the syntax elements up to the ones needed to parse slice segment headers are kept
+struct HEVCVideoParamSet {
+    mfxU8 vps_video_parameter_set_id;
+    mfxU8 vps_max_layers;
+    mfxU8 vps_max_sub_layers;
+    mfxU8 vps_temporal_id_nesting_flag;
+
+    mfxI32 GetID() const {
+        return vps_video_parameter_set_id;
+    }
+};
+
+struct HEVCSeqParamSet {
+    mfxU8 sps_video_parameter_set_id;
+    mfxU8 sps_max_sub_layers;
+    mfxU8 sps_seq_parameter_set_id;
+    mfxU8 general_profile_idc;
+    mfxU8 general_level_idc;
+    mfxU8 chroma_format_idc;
+    mfxU8 separate_colour_plane_flag;
+    mfxU32 pic_width_in_luma_samples;
+    mfxU32 pic_height_in_luma_samples;
+    mfxU8 bit_depth_luma;
+    mfxU8 bit_depth_chroma;
+    mfxU8 log2_max_pic_order_cnt_lsb;
+    mfxU8 log2_min_luma_coding_block_size;
+    mfxU8 log2_ctb_size;
+
+    // PicSizeInCtbsY
+    mfxU32 pic_size_in_ctbs;
+
+    mfxI32 GetID() const {
+        return sps_seq_parameter_set_id;
+    }
+};
+
+struct HEVCPicParamSet {
+    mfxU8 pps_pic_parameter_set_id;
+    mfxU8 pps_seq_parameter_set_id;
+    mfxU8 dependent_slice_segments_enabled_flag;
+    mfxU8 output_flag_present_flag;
+    mfxU8 num_extra_slice_header_bits;
+
+    mfxI32 GetID() const {
+        return pps_pic_parameter_set_id;
+    }
+};
+
+struct HEVCNalUnitHeader {
+    mfxU8 nal_unit_type;
+    mfxU8 nuh_layer_id;
+    mfxU8 nuh_temporal_id;
+};
+
+// Slice segment header up to slice_pic_order_cnt_lsb, a dependent slice segment keeps
+// the values of the preceding independent one
+struct HEVCSliceHeader {
+    HEVCNalUnitHeader nal;
+
+    mfxU8 first_slice_segment_in_pic_flag;
+    mfxU8 no_output_of_prior_pics_flag;
+    mfxU8 slice_pic_parameter_set_id;
+    mfxU8 dependent_slice_segment_flag;
+    mfxU32 slice_segment_address;
+    mfxU8 slice_type;
+    mfxU8 pic_output_flag;
+    mfxU8 colour_plane_id;
+    mfxU32 slice_pic_order_cnt_lsb;
+
+    // PicOrderCntVal, derived by the splitter
+    mfxI32 pic_order_cnt;
+};
+
+inline bool IsHEVCSlice(mfxU32 nalUnitType) {
+    return nalUnitType <= HEVC_NAL_UT_RSV_VCL31;
+}
+
+// Intra random access point, BLA, IDR or CRA
+inline bool IsHEVCIRAP(mfxU32 nalUnitType) {
+    return nalUnitType >= HEVC_NAL_UT_BLA_W_LP && nalUnitType <= HEVC_NAL_UT_RSV_IRAP_VCL23;
+}
+
+inline bool IsHEVCIDR(mfxU32 nalUnitType) {
+    return nalUnitType == HEVC_NAL_UT_IDR_W_RADL || nalUnitType == HEVC_NAL_UT_IDR_N_LP;
+}
+
+// Sub-layer non-reference pictures, TRAIL_N, TSA_N, ..., RSV_VCL_N14
+inline bool IsHEVCSubLayerNonReference(mfxU32 nalUnitType) {
+    return nalUnitType <= HEVC_NAL_UT_RSV_VCL_N14 && !(nalUnitType & 1);
+}
+
+// Size of an uncompressed picture, the splitters wait this long for the end of a NAL unit
+inline mfxU32 CalculateSuggestedSize(const HEVCSeqParamSet* sps) {
+    mfxU32 base_size = sps->pic_width_in_luma_samples * sps->pic_height_in_luma_samples;
+    mfxU32 size      = base_size;
+
+    switch (sps->chroma_format_idc) {
+        case 1: // YUV420
+            size = (base_size * 3) / 2;
+            break;
+        case 2: // YUV422
+            size = base_size + base_size;
+            break;
+        case 3: // YUV444
+            size = base_size + base_size + base_size;
+            break;
+    };
+
+    return sps->bit_depth_luma > 8 ? size * 2 : size;
+}
+
+} // namespace ProtectedLibrary
+
+#endif // __HEVC_STRUCTURES_H__
@@ -0,0 +1,55 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#ifndef __LATENCY_HISTOGRAM_H__
+#define __LATENCY_HISTOGRAM_H__
+
+#include <vector>
+
+#include "vpl/mfxdefs.h"
+
+// Fixed memory histogram of time measurements with a bounded relative error (HDR histogram).
+// Values are counted in nanoseconds. Values below 2^SubBucketBits have a counter each, every
+// next power of two range is split into 2^(SubBucketBits - 1) counters of the same width, so
+// a value is reported within 1/2^SubBucketBits of its size. Histograms of threads or
+// sessions are combined by Merge, an interval is taken by copying and resetting the histogram.
+class CLatencyHistogram {
+public:
+    enum {
+        SubBucketBits = 7, // 0.8% relative error
+        MaxValueBits  = 44, // about 4.8 hours, longer measurements are counted as the maximum
+    };
+
+    CLatencyHistogram();
+
+    void Record(mfxF64 seconds);
+    void Merge(const CLatencyHistogram& other);
+    void Reset();
+
+    mfxU64 GetCount() const {
+        return m_count;
+    }
+    // Exact extremes and mean of the measurements in seconds, 0 if there are none
+    mfxF64 GetMin() const;
+    mfxF64 GetMax() const;
+    mfxF64 GetMean() const;
+    // The value in seconds which the given percent of the measurements don't exceed,
+    // 0 if there are no measurements
+    mfxF64 GetPercentile(mfxF64 percent) const;
+
+private:
+    static mfxU32 GetIndex(mfxU64 value);
+    // middle of the values counted by the counter
+    static mfxU64 GetValue(mfxU32 index);
+
+    std::vector<mfxU64> m_counts;
+    mfxU64 m_count;
+    mfxU64 m_min; // nanoseconds
+    mfxU64 m_max;
+    mfxF64 m_sum; // seconds
+};
+
+#endif // __LATENCY_HISTOGRAM_H__
@@ -7,8 +7,12 @@
 #ifndef __MFX_BUFFERING_H__
 #define __MFX_BUFFERING_H__
 
+#include <stddef.h>
 #include <stdio.h>
+#include <atomic>
+#include <memory>
 #include <mutex>
+#include <thread>
 
 #include "vpl/mfxstructures.h"
 
@@ -18,8 +22,7 @@
 #include "vm/time_defs.h"
 
 struct msdkFrameSurface {
-    mfxFrameSurface1
-        frame; // NOTE: this _should_ be the first item (see CBuffering::FindUsedSurface())
+    mfxFrameSurface1 frame; // see CBuffering::FindUsedSurface()
     msdk_tick submit; // tick when frame was submitted for processing
     mfxU16 render_lock; // signifies that frame is locked for rendering
     msdkFrameSurface* prev;
@@ -29,7 +32,7 @@ struct msdkFrameSurface {
 struct msdkOutputSurface {
     msdkFrameSurface* surface;
     mfxSyncPoint syncp;
-    msdkOutputSurface* next;
+    std::atomic<msdkOutputSurface*> next; // link in msdkOutputSurfacesPool
 };
 
 /** \brief Debug purpose macro to terminate execution if buggy situation happenned.
@@ -55,16 +58,85 @@ struct msdkOutputSurface {
 
 class CBuffering;
 
+/** \brief Lock-free LIFO of the elements of an array (Treiber stack).
+ *
+ * The head holds the index of the top element and a tag changed by every push and pop, so a
+ * pop which was preempted while the element was popped and pushed back by other threads fails
+ * its compare-and-swap (ABA problem). The links are kept by the stack, the elements are not
+ * touched. Any number of threads may push and pop.
+ */
+template <class T>
+class msdkLockFreeStack {
+public:
+    msdkLockFreeStack() : m_Head(0), m_pElements(NULL), m_Links(), m_Count(0) {}
+
+    /** \brief The function attaches the stack to the array, the stack is empty then.
+     *
+     * @note Not thread-safe, only elements of the array can be pushed.
+     */
+    void Init(T* elements, mfxU32 count) {
+        m_pElements = elements;
+        m_Links.reset(count ? new std::atomic<mfxU32>[count] : NULL);
+        m_Count = count;
+        m_Head.store(0, std::memory_order_relaxed);
+    }
+
+    inline void Push(T* element) {
+        MSDK_SELF_CHECK(element >= m_pElements && element < m_pElements + m_Count);
+        mfxU32 index = (mfxU32)(element - m_pElements);
+        mfxU64 head  = m_Head.load(std::memory_order_relaxed);
+        do {
+            m_Links[index].store(Top(head), std::memory_order_relaxed);
+        } while (!m_Head.compare_exchange_weak(head,
+                                               Pack(index + 1, Tag(head) + 1),
+                                               std::memory_order_release,
+                                               std::memory_order_relaxed));
+    }
+
+    inline T* Pop() {
+        mfxU64 head = m_Head.load(std::memory_order_acquire);
+        for (;;) {
+            mfxU32 top = Top(head);
+            if (!top)
+                return NULL;
+            // the link may be stale if the element was popped meanwhile, the tag fails the swap
+            mfxU32 next = m_Links[top - 1].load(std::memory_order_relaxed);
+            if (m_Head.compare_exchange_weak(head,
+                                             Pack(next, Tag(head) + 1),
+                                             std::memory_order_acquire,
+                                             std::memory_order_acquire))
+                return &m_pElements[top - 1];
+        }
+    }
+
+private:
+    // index of the top element plus one, 0 if empty, in the low half and the tag in the high
+    static inline mfxU64 Pack(mfxU32 top, mfxU32 tag) {
+        return ((mfxU64)tag << 32) | top;
+    }
+    static inline mfxU32 Top(mfxU64 head) {
+        return (mfxU32)head;
+    }
+    static inline mfxU32 Tag(mfxU64 head) {
+        return (mfxU32)(head >> 32);
+    }
+
+    std::atomic<mfxU64> m_Head;
+    T* m_pElements;
+    std::unique_ptr<std::atomic<mfxU32>[]> m_Links; // index of the next element plus one
+    mfxU32 m_Count;
+
+    msdkLockFreeStack(const msdkLockFreeStack&);
+    void operator=(const msdkLockFreeStack&);
+};
+
 // LIFO list of frame surfaces
 class msdkFreeSurfacesPool {
     friend class CBuffering;
 
 public:
-    msdkFreeSurfacesPool(std::mutex& mutex) : m_pSurfaces(NULL), m_rMutex(mutex) {}
+    msdkFreeSurfacesPool() : m_Surfaces() {}
 
-    ~msdkFreeSurfacesPool() {
-        m_pSurfaces = NULL;
-    }
     /** \brief The function adds free surface to the free surfaces array.
      *
      * @note That's caller responsibility to pass valid surface.
@@ -72,46 +144,21 @@ public:
      * will be actually used we have good chance to avoid actual allocation of the surface memory.
      */
     inline void AddSurface(msdkFrameSurface* surface) {
-        std::lock_guard<std::mutex> lock(m_rMutex);
-        AddSurfaceUnsafe(surface);
+        MSDK_SELF_CHECK(surface);
+        MSDK_SELF_CHECK(!surface->prev);
+        MSDK_SELF_CHECK(!surface->next);
+        m_Surfaces.Push(surface);
     }
     /** \brief The function gets the next free surface from the free surfaces array.
      *
      * @note Surface is detached from the free surfaces array.
      */
     inline msdkFrameSurface* GetSurface() {
-        std::lock_guard<std::mutex> lock(m_rMutex);
-        return GetSurfaceUnsafe();
-    }
-
-private:
-    inline void AddSurfaceUnsafe(msdkFrameSurface* surface) {
-        msdkFrameSurface* head;
-
-        MSDK_SELF_CHECK(surface);
-        MSDK_SELF_CHECK(!surface->prev);
-        MSDK_SELF_CHECK(!surface->next);
-
-        head              = m_pSurfaces;
-        m_pSurfaces       = surface;
-        m_pSurfaces->next = head;
-    }
-    inline msdkFrameSurface* GetSurfaceUnsafe() {
-        msdkFrameSurface* surface = NULL;
-
-        if (m_pSurfaces) {
-            surface       = m_pSurfaces;
-            m_pSurfaces   = m_pSurfaces->next;
-            surface->prev = surface->next = NULL;
-            MSDK_SELF_CHECK(!surface->prev);
-            MSDK_SELF_CHECK(!surface->next);
-        }
-        return surface;
+        return m_Surfaces.Pop();
     }
 
 protected:
-    msdkFrameSurface* m_pSurfaces;
-    std::mutex& m_rMutex;
+    msdkLockFreeStack<msdkFrameSurface> m_Surfaces;
 
 private:
     msdkFreeSurfacesPool(const msdkFreeSurfacesPool&);
@@ -123,10 +170,7 @@ class msdkUsedSurfacesPool {
     friend class CBuffering;
 
 public:
-    msdkUsedSurfacesPool(std::mutex& mutex)
-            : m_pSurfacesHead(NULL),
-              m_pSurfacesTail(NULL),
-              m_rMutex(mutex) {}
+    msdkUsedSurfacesPool() : m_pSurfacesHead(NULL), m_pSurfacesTail(NULL), m_Mutex() {}
 
     ~msdkUsedSurfacesPool() {
         m_pSurfacesHead = NULL;
@@ -142,7 +186,7 @@ public:
      * head.
      */
     inline void AddSurface(msdkFrameSurface* surface) {
-        std::lock_guard<std::mutex> lock(m_rMutex);
+        std::lock_guard<std::mutex> lock(m_Mutex);
         AddSurfaceUnsafe(surface);
     }
 
@@ -152,7 +196,7 @@ public:
      */
 
     inline void DetachSurface(msdkFrameSurface* surface) {
-        std::lock_guard<std::mutex> lock(m_rMutex);
+        std::lock_guard<std::mutex> lock(m_Mutex);
         DetachSurfaceUnsafe(surface);
     }
 
@@ -201,79 +245,105 @@ private:
 protected:
     msdkFrameSurface* m_pSurfacesHead; // oldest surface
     msdkFrameSurface* m_pSurfacesTail; // youngest surface
-    std::mutex& m_rMutex;
+    // the list is used by the decoding thread only, the lock isn't contended
+    std::mutex m_Mutex;
 
 private:
     msdkUsedSurfacesPool(const msdkUsedSurfacesPool&);
     void operator=(const msdkUsedSurfacesPool&);
 };
 
-// FIFO list of surfaces
+/** \brief Lock-free FIFO list of output surfaces.
+ *
+ * Intrusive multiple producers single consumer queue: a producer swaps the tail and links the
+ * previous tail to its surface, the consumer follows the links from the head. An empty queue
+ * holds the stub surface. Any number of threads may add surfaces, one thread at a time may get
+ * them.
+ */
 class msdkOutputSurfacesPool {
     friend class CBuffering;
 
 public:
-    msdkOutputSurfacesPool(std::mutex& mutex)
-            : m_pSurfacesHead(NULL),
-              m_pSurfacesTail(NULL),
+    msdkOutputSurfacesPool()
+            : m_pSurfacesHead(&m_Stub),
+              m_pSurfacesTail(&m_Stub),
               m_SurfacesCount(0),
-              m_rMutex(mutex) {}
-
-    ~msdkOutputSurfacesPool() {
-        m_pSurfacesHead = NULL;
-        m_pSurfacesTail = NULL;
+              m_Stub() {
+        m_Stub.surface = NULL;
+        m_Stub.syncp   = NULL;
+        m_Stub.next.store(NULL, std::memory_order_relaxed);
     }
 
     inline void AddSurface(msdkOutputSurface* surface) {
-        std::lock_guard<std::mutex> lock(m_rMutex);
-        AddSurfaceUnsafe(surface);
+        MSDK_SELF_CHECK(surface);
+        Push(surface);
+        m_SurfacesCount.fetch_add(1, std::memory_order_release);
     }
+    /** \brief The function gets the oldest surface, NULL if the list is empty.
+     *
+     * @note A surface added by a thread preempted in the middle of AddSurface() blocks the
+     * surfaces added after it, the function waits for the thread then.
+     */
     inline msdkOutputSurface* GetSurface() {
-        std::lock_guard<std::mutex> lock(m_rMutex);
-        return GetSurfaceUnsafe();
+        if (!m_SurfacesCount.load(std::memory_order_acquire))
+            return NULL;
+
+        msdkOutputSurface* surface;
+        while (!(surface = TryGetSurface()))
+            std::this_thread::yield();
+        m_SurfacesCount.fetch_sub(1, std::memory_order_relaxed);
+        surface->next.store(NULL, std::memory_order_relaxed);
+        return surface;
     }
 
     inline mfxU32 GetSurfaceCount() {
-        return m_SurfacesCount;
+        return m_SurfacesCount.load(std::memory_order_acquire);
     }
 
 private:
-    inline void AddSurfaceUnsafe(msdkOutputSurface* surface) {
-        MSDK_SELF_CHECK(surface);
-        MSDK_SELF_CHECK(!surface->next);
-        surface->next = NULL;
-
-        if (m_pSurfacesTail) {
-            m_pSurfacesTail->next = surface;
-            m_pSurfacesTail       = m_pSurfacesTail->next;
+    inline void Push(msdkOutputSurface* surface) {
+        surface->next.store(NULL, std::memory_order_relaxed);
+        msdkOutputSurface* prev = m_pSurfacesTail.exchange(surface, std::memory_order_acq_rel);
+        prev->next.store(surface, std::memory_order_release);
+    }
+    // NULL if the list is empty or the next surface isn't linked yet
+    inline msdkOutputSurface* TryGetSurface() {
+        msdkOutputSurface* head = m_pSurfacesHead;
+        msdkOutputSurface* next = head->next.load(std::memory_order_acquire);
+        if (head == &m_Stub) {
+            if (!next)
+                return NULL;
+            m_pSurfacesHead = head = next;
+            next                   = next->next.load(std::memory_order_acquire);
         }
-        else {
-            m_pSurfacesHead = m_pSurfacesTail = surface;
+        if (next) {
+            m_pSurfacesHead = next;
+            return head;
         }
-        ++m_SurfacesCount;
-    }
-    inline msdkOutputSurface* GetSurfaceUnsafe() {
-        msdkOutputSurface* surface = NULL;
-
-        if (m_pSurfacesHead) {
-            surface         = m_pSurfacesHead;
-            m_pSurfacesHead = m_pSurfacesHead->next;
-            if (!m_pSurfacesHead) {
-                // there was only one surface in the array...
-                m_pSurfacesTail = NULL;
-            }
-            --m_SurfacesCount;
-            surface->next = NULL;
-            MSDK_SELF_CHECK(!surface->next);
+        // the head is the last surface, it's taken once the stub is linked after it
+        if (head != m_pSurfacesTail.load(std::memory_order_acquire))
+            return NULL;
+        Push(&m_Stub);
+        next = head->next.load(std::memory_order_acquire);
+        if (next) {
+            m_pSurfacesHead = next;
+            return head;
         }
-        return surface;
+        return NULL;
+    }
+    // not thread-safe, the surfaces in the list are dropped
+    inline void Reset() {
+        m_Stub.next.store(NULL, std::memory_order_relaxed);
+        m_pSurfacesHead = &m_Stub;
+        m_pSurfacesTail.store(&m_Stub, std::memory_order_relaxed);
+        m_SurfacesCount.store(0, std::memory_order_relaxed);
     }
 
 protected:
-    msdkOutputSurface* m_pSurfacesHead; // oldest surface
-    msdkOutputSurface* m_pSurfacesTail; // youngest surface
-    mfxU32 m_SurfacesCount;
-    std::mutex& m_rMutex;
+    msdkOutputSurface* m_pSurfacesHead; // oldest surface or the stub, used by the consumer only
+    std::atomic<msdkOutputSurface*> m_pSurfacesTail; // youngest surface or the stub
+    std::atomic<mfxU32> m_SurfacesCount; // surfaces added completely
+    msdkOutputSurface m_Stub;
 
 private:
     msdkOutputSurfacesPool(const msdkOutputSurfacesPool&);
@@ -290,7 +360,6 @@ public:
 protected: // functions
     mfxStatus AllocBuffers(mfxU32 SurfaceNumber);
     mfxStatus AllocVppBuffers(mfxU32 VppSurfaceNumber);
-    void AllocOutputBuffer();
     void FreeBuffers();
     void ResetBuffers();
     void ResetVppBuffers();
@@ -308,41 +377,21 @@ protected: // functions
      * @note This function will not detach the surface from the array, perform this explicitly.
      */
     inline msdkFrameSurface* FindUsedSurface(mfxFrameSurface1* frame) {
-        return (msdkFrameSurface*)(frame);
+        // the surfaces given to the library are members of msdkFrameSurface
+        return (msdkFrameSurface*)((mfxU8*)frame - offsetof(msdkFrameSurface, frame));
     }
 
-    inline void AddFreeOutputSurfaceUnsafe(msdkOutputSurface* surface) {
-        msdkOutputSurface* head = m_pFreeOutputSurfaces;
-
-        MSDK_SELF_CHECK(surface);
-        MSDK_SELF_CHECK(!surface->next);
-        m_pFreeOutputSurfaces       = surface;
-        m_pFreeOutputSurfaces->next = head;
-    }
     inline void AddFreeOutputSurface(msdkOutputSurface* surface) {
-        std::lock_guard<std::mutex> lock(m_Mutex);
-        AddFreeOutputSurfaceUnsafe(surface);
-    }
-
-    inline msdkOutputSurface* GetFreeOutputSurfaceUnsafe(std::unique_lock<std::mutex>& lock) {
-        msdkOutputSurface* surface = NULL;
-
-        if (!m_pFreeOutputSurfaces) {
-            lock.unlock();
-            AllocOutputBuffer();
-            lock.lock();
-        }
-        if (m_pFreeOutputSurfaces) {
-            surface               = m_pFreeOutputSurfaces;
-            m_pFreeOutputSurfaces = m_pFreeOutputSurfaces->next;
-            surface->next         = NULL;
-            MSDK_SELF_CHECK(!surface->next);
-        }
-        return surface;
+        MSDK_SELF_CHECK(surface);
+        m_FreeOutputSurfaces.Push(surface);
     }
+    /** \brief The function gets a free output surface, NULL if all are in use.
+     *
+     * @note An output surface holds a locked frame surface, so there are no more output surfaces
+     * in use than the frame surfaces they are allocated for.
+     */
     inline msdkOutputSurface* GetFreeOutputSurface() {
-        std::unique_lock<std::mutex> lock(m_Mutex);
-        return GetFreeOutputSurfaceUnsafe(lock);
+        return m_FreeOutputSurfaces.Pop();
     }
 
     /** \brief Function returns surface data to the corresponding buffers.
@@ -365,7 +414,7 @@ protected: // variables
     mfxU32 m_OutputSurfacesNumber;
     msdkFrameSurface* m_pSurfaces;
     msdkFrameSurface* m_pVppSurfaces;
-    std::mutex m_Mutex;
+    msdkOutputSurface* m_pOutputSurfaces;
 
     // LIFO list of frame surfaces
     msdkFreeSurfacesPool m_FreeSurfacesPool;
@@ -376,7 +425,7 @@ protected: // variables
     msdkUsedSurfacesPool m_UsedVppSurfacesPool;
 
     // LIFO list of output surfaces
-    msdkOutputSurface* m_pFreeOutputSurfaces;
+    msdkLockFreeStack<msdkOutputSurface> m_FreeOutputSurfaces;
 
     // FIFO list of surfaces
     msdkOutputSurfacesPool m_OutputSurfacesPool;
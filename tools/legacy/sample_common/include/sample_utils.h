@@ -41,10 +41,13 @@
 #include "sample_types.h"
 
 #include "abstract_splitter.h"
+#include "async_file_writer.h"
+#include "av1_spl.h"
 #include "avc_bitstream.h"
 #include "avc_headers.h"
 #include "avc_nal_spl.h"
 #include "avc_spl.h"
+#include "hevc_spl.h"
 #include "vpl_implementation_loader.h"
 
 #include "vpl/mfxsurfacepool.h"
@@ -683,6 +686,20 @@ private:
     std::vector<mfxU8> m_data;
 };
 
+// Raw frame plane as it is stored in the file: rows of RowSize bytes follow each other
+// in the file and are placed Pitch bytes apart in memory
+struct FramePlane {
+    mfxU8* Data;
+    mfxU32 RowSize;
+    mfxU32 Rows;
+    mfxU32 Pitch;
+};
+
+// Read/write all planes of the frame at the current file position. Contiguous planes are
+// transferred with one call, pitched ones with vectored I/O where the file supports it.
+mfxStatus ReadFramePlanes(FILE* f, const FramePlane* planes, mfxU32 count);
+mfxStatus WriteFramePlanes(FILE* f, const FramePlane* planes, mfxU32 count);
+
 class CSmplYUVReader {
 public:
     typedef std::list<msdk_string>::iterator ls_iterator;
@@ -696,13 +713,27 @@ public:
     virtual mfxStatus SkipNframesFromBeginning(mfxU16 w, mfxU16 h, mfxU32 viewId, mfxU32 nframes);
     virtual mfxStatus LoadNextFrame(mfxFrameSurface1* pSurface);
     virtual void Reset();
+    // Read frames bypassing the page cache (O_DIRECT), must be called before Init.
+    // Falls back to regular reads if the file system doesn't support it.
+    void EnableDirectIO(bool enable) {
+        m_bDirectIO = enable;
+    }
     mfxU32 m_ColorFormat; // color format of input YUV data, YUV420 or NV12
 
 protected:
+    mfxStatus ReadPlanes(mfxU32 vid, const FramePlane* planes, mfxU32 count);
+
     std::vector<FILE*> m_files;
+    // O_DIRECT descriptors of the input files, -1 if not available
+    std::vector<int> m_directFiles;
+    // staging buffer for the aligned direct reads
+    std::vector<mfxU8> m_directBuffer;
+    // temporary storage for the planes which need conversion
+    std::vector<mfxU8> m_convertBuffer;
 
     bool shouldShift10BitsHigh;
     bool m_bInited;
+    bool m_bDirectIO;
 };
 
 class CSmplBitstreamWriter {
@@ -717,13 +748,32 @@ public:
                                      bool isCompleteFrame = true);
     virtual mfxStatus Reset();
     virtual void Close();
+    // Waits until the frames are written to the file, returns the error of the
+    // asynchronous writes if any
+    virtual mfxStatus Flush();
+    // Write the file on a separate thread, must be called before Init
+    void EnableAsyncWrite(const AsyncWriteParams& params) {
+        m_bAsyncWrite = true;
+        m_asyncParams = params;
+    }
+    bool IsAsyncWrite() const {
+        return m_bAsyncWrite;
+    }
+    const CAsyncFileWriter& GetAsyncWriter() const {
+        return m_asyncWriter;
+    }
     mfxU32 m_nProcessedFramesNum;
     bool m_bSkipWriting;
 
 protected:
+    mfxStatus WriteData(const mfxU8* data, mfxU32 size);
+
     FILE* m_fSource;
     bool m_bInited;
     msdk_string m_sFile;
+    CAsyncFileWriter m_asyncWriter;
+    AsyncWriteParams m_asyncParams;
+    bool m_bAsyncWrite;
 };
 
 class CSmplYUVWriter {
@@ -742,7 +792,11 @@ public:
     }
 
 protected:
+    FILE* GetDestFile(mfxU32 vid);
+
     FILE *m_fDest, **m_fDestMVC;
+    // temporary storage for the planes which need conversion
+    std::vector<mfxU8> m_convertBuffer;
     bool m_bInited, m_bIsMultiView;
     mfxU32 m_numCreatedFiles;
     msdk_string m_sFile;
@@ -754,30 +808,60 @@ public:
     CSmplBitstreamReader();
     virtual ~CSmplBitstreamReader();
 
+    // Position and type of the frame returned by the last ReadNextFrame
+    struct FrameInfo {
+        mfxU64 Offset; // file position of the frame
+        mfxI32 PicOrderCnt; // output order within the coded video sequence
+        bool KeyFrame; // decoding can start at the frame
+    };
+
     //resets position to file begin
     virtual void Reset();
     virtual void Close();
     virtual mfxStatus Init(const msdk_char* strFileName);
     virtual mfxStatus ReadNextFrame(mfxBitstream* pBS);
 
+    // Frame readers return the frame information for the stream index, the plain reader
+    // doesn't know frame boundaries and returns MFX_ERR_UNSUPPORTED
+    virtual mfxStatus GetFrameInfo(FrameInfo& info) const;
+    // Parameter sets the stream needs in front of the next key frame, see
+    // AbstractSplitter::GetHeaders
+    virtual void GetHeaders(std::vector<mfxU8>& headers);
+    // Continues reading at the file position of a key frame, the headers are read first
+    virtual mfxStatus Seek(mfxU64 offset, const std::vector<mfxU8>& headers);
+
 protected:
+    // Makes at least minTail bytes available after the data, the data is moved to the
+    // beginning of the buffer only when the free tail is short
+    static void CompactBitstream(mfxBitstream* pBS, mfxU32 minTail);
+
     FILE* m_fSource;
     bool m_bInited;
+    // headers given to Seek which are not read yet
+    std::vector<mfxU8> m_seekHeaders;
 };
 
-class CH264FrameReader : public CSmplBitstreamReader {
+// Returns complete frames of elementary streams assembled by the splitter of the codec,
+// MFX_CODEC_AVC, MFX_CODEC_HEVC or MFX_CODEC_AV1
+class CSplitterFrameReader : public CSmplBitstreamReader {
 public:
-    CH264FrameReader();
-    virtual ~CH264FrameReader();
+    explicit CSplitterFrameReader(mfxU32 codecId);
+    virtual ~CSplitterFrameReader();
 
-    /** Free resources.*/
-    virtual void Close();
+    virtual void Reset();
     virtual mfxStatus Init(const msdk_char* strFileName);
+    // returns MFX_ERR_NOT_ENOUGH_BUFFER if the frame does not fit, the frame is returned by
+    // the next call after the bitstream is extended
     virtual mfxStatus ReadNextFrame(mfxBitstream* pBS);
 
+    virtual mfxStatus GetFrameInfo(FrameInfo& info) const;
+    virtual void GetHeaders(std::vector<mfxU8>& headers);
+    virtual mfxStatus Seek(mfxU64 offset, const std::vector<mfxU8>& headers);
+
 private:
     mfxBitstream* m_processedBS;
-    // input bit stream
+    // input bit stream, the splitter returns NAL units and frames pointing into it and
+    // keeps an unfinished NAL unit in it until the rest is read
     mfxBitstreamWrapper m_originalBS;
 
     mfxStatus PrepareNextFrame(mfxBitstream* in, mfxBitstream** out);
@@ -785,11 +869,31 @@ private:
     // is stream ended
     bool m_isEndOfStream;
 
+    mfxU32 m_codecId;
     std::unique_ptr<AbstractSplitter> m_pNALSplitter;
     FrameSplitterInfo* m_frame;
-    mfxU8* m_plainBuffer;
-    mfxU32 m_plainBufferSize;
     mfxBitstream m_outBS;
+
+    // the splitter counts positions from the seek offset, the headers come first
+    mfxU64 m_seekOffset;
+    mfxU64 m_seekHeadersSize;
+    FrameInfo m_frameInfo;
+};
+
+class CH264FrameReader : public CSplitterFrameReader {
+public:
+    CH264FrameReader() : CSplitterFrameReader(MFX_CODEC_AVC) {}
+};
+
+class CH265FrameReader : public CSplitterFrameReader {
+public:
+    CH265FrameReader() : CSplitterFrameReader(MFX_CODEC_HEVC) {}
+};
+
+// AV1 streams without a container, in the low overhead or the annex B format
+class CAV1FrameReader : public CSplitterFrameReader {
+public:
+    CAV1FrameReader() : CSplitterFrameReader(MFX_CODEC_AV1) {}
 };
 
 //provides output bistream with at least 1 frame, reports about error
@@ -797,10 +901,26 @@ class CJPEGFrameReader : public CSmplBitstreamReader {
     enum JPEGMarker { SOI = 0xD8FF, EOI = 0xD9FF };
 
 public:
+    CJPEGFrameReader();
+    virtual void Reset();
+    virtual mfxStatus Init(const msdk_char* strFileName);
     virtual mfxStatus ReadNextFrame(mfxBitstream* pBS);
+    // JPEG streams aren't indexed
+    virtual mfxStatus Seek(mfxU64 offset, const std::vector<mfxU8>& headers);
 
 protected:
-    mfxU32 FindMarker(mfxBitstream* pBS, mfxU32 startOffset, JPEGMarker marker);
+    static mfxU32 FindMarker(const mfxU8* data, mfxU32 size, mfxU32 startOffset, JPEGMarker marker);
+
+    // The marker search resumes where the previous refill stopped. Positions count the bytes
+    // the bitstream data has held, so they survive the data moves and buffer extensions.
+    mfxU64 m_nFrameStart; // SOI of the frame being read, or (mfxU64)-1
+    mfxU64 m_nFrameEnd; // end of the EOI of the frame, 0 if not found yet
+    mfxU64 m_nScanPos; // next position to check for a marker
+    // Position of the first byte of the data and its length when the last call returned. The
+    // caller consumes the data from the front, so the bytes it took are the difference between
+    // the lengths.
+    mfxU64 m_nDataStart;
+    mfxU32 m_nDataLength;
 };
 
 //appends output bistream with exactly 1 frame, reports about error
@@ -809,8 +929,14 @@ public:
     CIVFFrameReader();
     virtual void Reset();
     virtual mfxStatus Init(const msdk_char* strFileName);
+    // returns MFX_ERR_NOT_ENOUGH_BUFFER if the frame does not fit, the frame is read by
+    // the next call after the bitstream is extended
     virtual mfxStatus ReadNextFrame(mfxBitstream* pBS);
 
+    virtual mfxStatus GetFrameInfo(FrameInfo& info) const;
+    // the offset is the position of the frame header, key frames don't need headers
+    virtual mfxStatus Seek(mfxU64 offset, const std::vector<mfxU8>& headers);
+
 protected:
     /*bytes 0-3    signature: 'DKIF'
     bytes 4-5    version (should be 0)
@@ -836,6 +962,13 @@ protected:
         mfxU32 unused;
     } m_hdr;
     mfxStatus ReadHeader();
+
+    bool m_bFrameHeaderRead; // the frame header is read, the frame data is not
+    mfxU32 m_nFrameSize;
+
+    mfxU64 m_nFrameOffset; // position of the header of the frame being read
+    mfxU32 m_nFrameCount; // frames read since Reset or Seek
+    FrameInfo m_frameInfo;
 };
 
 // writes bitstream to duplicate-file & supports joining
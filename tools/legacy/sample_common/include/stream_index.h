@@ -0,0 +1,76 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#ifndef __STREAM_INDEX_H__
+#define __STREAM_INDEX_H__
+
+#include <memory>
+#include <vector>
+
+#include "sample_utils.h"
+
+struct StreamIndexEntry {
+    mfxU64 Offset; // file position of the frame, see CSmplBitstreamReader::FrameInfo
+    mfxU32 Order; // presentation order of the frame in the stream
+    mfxU32 Headers; // header set read in front of the frame when decoding starts at it
+    bool KeyFrame;
+};
+
+// Frame index of an elementary stream or an IVF file, frames are in decoding order. The
+// index is built by a single pass of the frame reader of the codec and kept next to the
+// stream in a compact binary file, so later runs can seek without scanning the stream.
+class CStreamIndex {
+public:
+    CStreamIndex();
+
+    // Loads the index file of the stream, the index is built and saved if the file is
+    // missing or was made for another codec or stream size
+    mfxStatus Init(const msdk_char* strFileName, mfxU32 codecId);
+
+    mfxStatus Build(const msdk_char* strFileName, mfxU32 codecId);
+    mfxStatus Load(const msdk_char* strIndexFileName);
+    mfxStatus Save(const msdk_char* strIndexFileName) const;
+
+    static msdk_tstring GetIndexFileName(const msdk_char* strFileName);
+
+    // The frame reader the index is built with, IVF files are read frame by frame and AV1
+    // elementary streams by the splitter
+    static mfxStatus CreateFrameReader(const msdk_char* strFileName,
+                                       mfxU32 codecId,
+                                       std::unique_ptr<CSmplBitstreamReader>& reader);
+
+    // The key frame decoding starts at to output the frame with the given presentation
+    // order, the first frame if no key frame precedes it. NULL if there is no such frame.
+    const StreamIndexEntry* FindKeyFrame(mfxU32 order) const;
+
+    // Splits the stream into at most numChunks runs of frames of about the same length and
+    // returns the first frame of every run. A run starts at a key frame presented after all
+    // frames decoded before it and before all frames decoded after it, so the runs decode
+    // independently and present consecutive frames.
+    std::vector<mfxU32> GetChunkStarts(mfxU32 numChunks) const;
+
+    // Moves the frame reader of the stream to the entry
+    mfxStatus Seek(CSmplBitstreamReader& reader, const StreamIndexEntry& entry) const;
+
+    mfxU32 GetCodecId() const {
+        return m_codecId;
+    }
+    const std::vector<StreamIndexEntry>& GetEntries() const {
+        return m_entries;
+    }
+    const std::vector<mfxU8>& GetHeaders(mfxU32 id) const {
+        return m_headers[id];
+    }
+
+protected:
+    mfxU32 m_codecId;
+    mfxU64 m_streamSize;
+    std::vector<StreamIndexEntry> m_entries;
+    // distinct header sets in the order of the first use
+    std::vector<std::vector<mfxU8>> m_headers;
+};
+
+#endif // __STREAM_INDEX_H__
@@ -8,6 +8,8 @@
 #define __SYSMEM_ALLOCATOR_H__
 
 #include <stdlib.h>
+#include <list>
+#include <map>
 #include <vector>
 #include "base_allocator.h"
 
@@ -22,9 +24,33 @@ struct sFrame {
     mfxFrameInfo info;
 };
 
+enum SysMemHugePages {
+    SYSMEM_HUGEPAGES_OFF,
+    // transparent huge pages requested with madvise
+    SYSMEM_HUGEPAGES_THP,
+    // pages of the MAP_HUGETLB pool, transparent huge pages if the pool is exhausted
+    SYSMEM_HUGEPAGES_HUGETLB
+};
+
 struct SysMemAllocatorParams : mfxAllocatorParams {
-    SysMemAllocatorParams() : mfxAllocatorParams(), pBufferAllocator(NULL) {}
+    SysMemAllocatorParams()
+            : mfxAllocatorParams(),
+              pBufferAllocator(NULL),
+              bUseArena(false),
+              HugePages(SYSMEM_HUGEPAGES_OFF),
+              bPrefault(false),
+              NumaNode(-1) {}
     MFXBufferAllocator* pBufferAllocator;
+    // frames of an allocation request are carved out of one slab instead of a buffer
+    // allocation per frame, the buffer allocator isn't used for frames then
+    bool bUseArena;
+    // page size of the slabs, huge pages are used on Linux only
+    SysMemHugePages HugePages;
+    // slab pages are faulted in at allocation instead of at the first access to a frame
+    bool bPrefault;
+    // NUMA node the slab pages are taken from, negative for the node of the thread touching
+    // them first. Frames are placed by slabs only, a node enables bUseArena.
+    mfxI32 NumaNode;
 };
 
 class SysMemFrameAllocator : public BaseFrameAllocator {
@@ -47,9 +73,37 @@ protected:
                                   mfxU16 memType,
                                   mfxMemId* midOut);
 
+    // Page aligned memory block, slabs released by all of their frames are kept for reuse
+    // until a request doesn't fit in any of them or the allocator is closed
+    struct Slab {
+        mfxU8* ptr;
+        size_t size;
+        mfxU32 numFrames; // frames carved out of the slab and not released yet
+    };
+
+    struct SlabFrame {
+        Slab* slab;
+        mfxU32 capacity; // bytes available for the planes of the frame
+    };
+
+    mfxStatus AllocSlabFrames(const mfxFrameInfo& info,
+                              mfxU32 nbytes,
+                              mfxU32 numFrames,
+                              mfxMemId* mids);
+    void ReleaseSlabFrame(mfxMemId mid);
+    Slab* AllocSlab(size_t size);
+    void FreeSlabs();
+
     MFXBufferAllocator* m_pBufferAllocator;
     bool m_bOwnBufferAllocator;
 
+    bool m_bUseArena;
+    SysMemHugePages m_HugePages;
+    bool m_bPrefault;
+    mfxI32 m_NumaNode;
+    std::list<Slab> m_slabs;
+    std::map<mfxMemId, SlabFrame> m_slabFrames;
+
     std::vector<mfxFrameAllocResponse*> m_vResp;
 
     mfxMemId* GetMidHolder(mfxMemId mid);
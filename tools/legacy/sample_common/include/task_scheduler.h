@@ -0,0 +1,136 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#ifndef __TASK_SCHEDULER_H__
+#define __TASK_SCHEDULER_H__
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "sample_utils.h"
+
+// Runs resumable tasks on a fixed pool of worker threads.
+// A task does one step of its work per call and returns MFX_TASK_WORKING while it has more
+// to do, any other status completes it. Every worker takes tasks from the front of its own
+// queue and puts a task back to the end after its turn, an idle worker steals from the end
+// of the queues of the others. A turn is as many steps as the weight of the task, so tasks
+// sharing a worker progress in proportion to their weights.
+// A deferrable task may set the time its next step is due at, the task is kept aside until
+// then and the worker runs other tasks meanwhile.
+// Tasks blocking on other tasks may starve the pool, they are run by SubmitDedicated on
+// threads of their own. Completed tasks of both kinds are reported by WaitForCompletion.
+class CTaskScheduler {
+public:
+    typedef std::chrono::steady_clock Clock;
+    typedef std::function<mfxStatus()> Task;
+    // resumeAt is the default time point when the task is called and is due at once if left so
+    typedef std::function<mfxStatus(Clock::time_point& resumeAt)> DeferrableTask;
+
+    struct Statistics {
+        mfxU64 steps; // calls of the pooled tasks
+        mfxU64 turns; // times a pooled task was taken from a queue
+        mfxU64 steals; // turns taken from the queue of another worker
+        mfxU64 sleeps; // times a worker found no task and waited
+        mfxU64 deferrals; // steps after which a task was kept aside until it was due
+    };
+
+    CTaskScheduler();
+    virtual ~CTaskScheduler();
+
+    // Starts numWorkers threads, as many as the CPUs if 0
+    mfxStatus Start(mfxU32 numWorkers);
+    // Waits until all tasks complete and stops the threads
+    void Stop();
+    bool IsStarted() const {
+        return !m_workers.empty();
+    }
+    mfxU32 GetNumWorkers() const {
+        return (mfxU32)m_workers.size();
+    }
+
+    // Queues the task to the pool, id is returned by WaitForCompletion and weight is
+    // the number of steps of a turn
+    mfxStatus Submit(mfxU32 id, const Task& task, mfxU32 weight = 1);
+    // Queues the task to the pool, a turn ends early when the task defers its next step
+    mfxStatus SubmitDeferrable(mfxU32 id, const DeferrableTask& task, mfxU32 weight = 1);
+    // Runs the task on a thread of its own until it completes, needs no Start
+    mfxStatus SubmitDedicated(mfxU32 id, const Task& task);
+
+    // Waits until a task completes and returns its id and status. Returns MFX_TASK_WORKING
+    // on timeout and MFX_ERR_NOT_FOUND if all tasks have been reported.
+    mfxStatus WaitForCompletion(mfxU32 msec, mfxU32* id, mfxStatus* result);
+
+    Statistics GetStatistics() const;
+    void PrintStatistics(const msdk_char* prefix) const;
+
+private:
+    struct Entry {
+        mfxU32 id;
+        DeferrableTask task;
+        mfxU32 weight;
+    };
+
+    struct Deferred {
+        Clock::time_point resumeAt;
+        mfxU32 index; // worker which ran the task last
+        Entry entry;
+    };
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Entry> queue;
+        std::thread thread;
+    };
+
+    void WorkerRoutine(mfxU32 index);
+    bool TakeTask(mfxU32 index, Entry& entry);
+    void Queue(mfxU32 index, Entry&& entry, bool bResumed);
+    void Complete(mfxU32 id, mfxStatus sts);
+    void Defer(mfxU32 index, Entry&& entry, Clock::time_point resumeAt);
+    void ResumeDueTasks();
+    bool IsTaskDue() const;
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::vector<std::thread> m_dedicated;
+    mfxU32 m_nextWorker;
+
+    // tasks waiting in the queues, idle workers sleep on m_cvQueued until there are any
+    std::atomic<mfxU32> m_queued;
+    std::atomic<mfxU32> m_idle;
+    std::mutex m_idleMutex;
+    std::condition_variable m_cvQueued;
+    bool m_bStop;
+
+    // deferred tasks ordered by the time they are due at, guarded by m_idleMutex. An idle
+    // worker sleeps until the first one is due, busy workers check it between their turns.
+    std::vector<Deferred> m_deferred;
+    std::atomic<mfxU32> m_numDeferred;
+
+    // completed tasks not reported yet and the number of tasks which are not completed
+    std::mutex m_doneMutex;
+    std::condition_variable m_cvDone;
+    std::deque<std::pair<mfxU32, mfxStatus>> m_done;
+    mfxU32 m_running;
+
+    std::atomic<mfxU64> m_steps;
+    std::atomic<mfxU64> m_turns;
+    std::atomic<mfxU64> m_steals;
+    std::atomic<mfxU64> m_sleeps;
+    std::atomic<mfxU64> m_deferrals;
+
+private:
+    CTaskScheduler(const CTaskScheduler&);
+    void operator=(const CTaskScheduler&);
+};
+
+#endif //__TASK_SCHEDULER_H__
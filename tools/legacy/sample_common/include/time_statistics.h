@@ -8,6 +8,7 @@
 
 #include <stdio.h>
 #include <vector>
+#include "latency_histogram.h"
 #include "math.h"
 #include "vm/strings_defs.h"
 #include "vm/time_defs.h"
@@ -40,7 +41,8 @@ public:
         mfxF64 delta = GetDeltaTime();
         totalTime += delta;
         totalTimeSquares += delta * delta;
-        // dump in ms:
+        m_histogram.Record(delta);
+        // dump in ms, the deltas are kept until the statistics are reset:
         if (m_bNeedDumping)
             m_time_deltas.push_back(delta * 1000);
 
@@ -79,14 +81,19 @@ public:
     inline void PrintStatistics(const msdk_char* prefix) {
         msdk_printf(
             MSDK_STRING(
-                "%s Total:%.3lfms(%llu smpls),Avg %.3lfms,StdDev:%.3lfms,Min:%.3lfms,Max:%.3lfms\n"),
+                "%s Total:%.3lfms(%llu smpls),Avg %.3lfms,StdDev:%.3lfms,Min:%.3lfms,Max:%.3lfms,"
+                "P50:%.3lfms,P90:%.3lfms,P99:%.3lfms,P99.9:%.3lfms\n"),
             prefix,
             (double)totalTime,
             (unsigned long long int)numMeasurements,
             (double)GetAvgTime(false),
             (double)GetTimeStdDev(false),
             (double)GetMinTime(false),
-            (double)GetMaxTime(false));
+            (double)GetMaxTime(false),
+            (double)GetPercentile(50, false),
+            (double)GetPercentile(90, false),
+            (double)GetPercentile(99, false),
+            (double)GetPercentile(99.9, false));
     }
 
     inline mfxU64 GetNumMeasurements() {
@@ -121,14 +128,24 @@ public:
         return inSeconds ? totalTime : totalTime * 1000;
     }
 
+    inline mfxF64 GetPercentile(mfxF64 percent, bool inSeconds = true) {
+        mfxF64 value = m_histogram.GetPercentile(percent);
+        return inSeconds ? value : value * 1000;
+    }
+
+    // Distribution of the measurements since the last reset
+    inline const CLatencyHistogram& GetHistogram() const {
+        return m_histogram;
+    }
+
     inline void ResetStatistics() {
         totalTime        = 0;
         totalTimeSquares = 0;
         minTime          = 1E100;
         maxTime          = -1;
         numMeasurements  = 0;
+        m_histogram.Reset();
         m_time_deltas.clear();
-        TurnOffDumping();
     }
 
 protected:
@@ -140,6 +157,7 @@ protected:
     mfxF64 minTime;
     mfxF64 maxTime;
     mfxU64 numMeasurements;
+    CLatencyHistogram m_histogram;
     std::vector<mfxF64> m_time_deltas;
     bool m_bNeedDumping;
 };
@@ -201,6 +219,10 @@ public:
         return 0;
     }
 
+    inline mfxF64 GetPercentile(mfxF64, bool) {
+        return 0;
+    }
+
     inline void ResetStatistics() {}
 
 protected:
@@ -21,4 +21,11 @@ mfxU32 msdk_atomic_inc32(volatile mfxU32* pVariable);
 /* Thread-safe 32-bit variable decrementing */
 mfxU32 msdk_atomic_dec32(volatile mfxU32* pVariable);
 
+/* Sleeps while the 32-bit variable holds the value, at most msec milliseconds (futex).
+   The thread may wake up spuriously, the caller checks the variable again. */
+void msdk_atomic_wait32(volatile mfxU32* pVariable, mfxU32 value, mfxU32 msec);
+
+/* Wakes up all threads sleeping on the 32-bit variable */
+void msdk_atomic_wake32(volatile mfxU32* pVariable);
+
 #endif // #ifndef __ATOMIC_DEFS_H__
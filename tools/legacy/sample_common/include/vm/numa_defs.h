@@ -0,0 +1,45 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#ifndef __NUMA_DEFS_H__
+#define __NUMA_DEFS_H__
+
+#include <stddef.h>
+#include <vector>
+
+#include "vm/strings_defs.h"
+#include "vpl/mfxdefs.h"
+
+// NUMA topology and placement of threads and memory. A system without NUMA support is
+// reported as a single node 0 holding all CPUs.
+
+mfxU32 msdk_numa_get_node_count();
+// CPUs of the node in ascending order
+mfxStatus msdk_numa_get_node_cpus(mfxU32 node, std::vector<mfxU32>& cpus);
+
+// Parses a CPU list like "0-7,16-23" as used by taskset and sysfs
+mfxStatus msdk_parse_cpu_list(const msdk_char* str, std::vector<mfxU32>& cpus);
+
+// Restricts the calling thread to the CPUs
+mfxStatus msdk_thread_set_affinity(const std::vector<mfxU32>& cpus);
+
+// Pages first touched by the calling thread are taken from the node when it has free
+// memory, a negative node restores the default local allocation
+mfxStatus msdk_numa_set_preferred_node(mfxI32 node);
+
+// Pages of the page aligned range are taken from the node when it has free memory, pages
+// already touched are moved there
+mfxStatus msdk_numa_bind_memory(void* ptr, size_t size, mfxU32 node);
+
+// Adds the bytes of the resident pages of the range to the entries of their nodes
+mfxStatus msdk_numa_get_memory_nodes(const void* ptr,
+                                     size_t size,
+                                     std::vector<mfxU64>& bytesPerNode);
+
+// Resident memory of the process per node
+mfxStatus msdk_numa_get_process_memory(std::vector<mfxU64>& bytesPerNode);
+
+#endif // __NUMA_DEFS_H__
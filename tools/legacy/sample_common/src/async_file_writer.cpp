@@ -0,0 +1,259 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include "async_file_writer.h"
+
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+
+#if defined(_WIN32) || defined(_WIN64)
+    #include <io.h>
+#else
+    #include <unistd.h>
+#endif
+
+namespace {
+
+typedef std::chrono::steady_clock WriterClock;
+
+mfxF64 SecondsSince(WriterClock::time_point start) {
+    return std::chrono::duration<mfxF64>(WriterClock::now() - start).count();
+}
+
+// Pushes written data from the stdio and OS caches to the storage
+bool SyncFile(FILE* f) {
+    if (fflush(f))
+        return false;
+#if defined(_WIN32) || defined(_WIN64)
+    return _commit(_fileno(f)) == 0;
+#elif defined(__APPLE__)
+    return fsync(fileno(f)) == 0;
+#else
+    return fdatasync(fileno(f)) == 0;
+#endif
+}
+
+} // namespace
+
+CAsyncFileWriter::CAsyncFileWriter()
+        : m_file(NULL),
+          m_params(GetDefaultParams()),
+          m_buffers(),
+          m_free(),
+          m_queue(),
+          m_current(NULL),
+          m_busy(0),
+          m_thread(),
+          m_mutex(),
+          m_cvQueued(),
+          m_cvWritten(),
+          m_bStop(false),
+          m_status(MFX_ERR_NONE),
+          m_stat() {}
+
+CAsyncFileWriter::~CAsyncFileWriter() {
+    Stop();
+}
+
+AsyncWriteParams CAsyncFileWriter::GetDefaultParams() {
+    AsyncWriteParams params = {};
+    params.BufferSize       = 1024 * 1024;
+    params.NumBuffers       = 8;
+    params.Sync             = ASYNC_WRITE_SYNC_NONE;
+    return params;
+}
+
+mfxStatus CAsyncFileWriter::Start(FILE* f, const AsyncWriteParams& params) {
+    if (IsStarted())
+        return MFX_ERR_UNDEFINED_BEHAVIOR;
+    if (!f)
+        return MFX_ERR_NULL_PTR;
+    if (!params.BufferSize || !params.NumBuffers)
+        return MFX_ERR_INVALID_VIDEO_PARAM;
+
+    if (m_buffers.size() != params.NumBuffers || m_params.BufferSize != params.BufferSize) {
+        m_buffers.clear();
+        for (mfxU32 i = 0; i < params.NumBuffers; i++) {
+            m_buffers.emplace_back(new Buffer);
+            m_buffers.back()->data.resize(params.BufferSize);
+        }
+    }
+
+    m_free.clear();
+    m_queue.clear();
+    for (auto& buffer : m_buffers) {
+        buffer->size = 0;
+        m_free.push_back(buffer.get());
+    }
+
+    m_file    = f;
+    m_params  = params;
+    m_current = NULL;
+    m_busy    = 0;
+    m_bStop   = false;
+    m_status  = MFX_ERR_NONE;
+    m_thread  = std::thread(&CAsyncFileWriter::ThreadRoutine, this);
+    return MFX_ERR_NONE;
+}
+
+mfxStatus CAsyncFileWriter::Stop() {
+    if (!IsStarted())
+        return m_status;
+
+    Flush();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_bStop = true;
+    }
+    m_cvQueued.notify_all();
+    m_thread.join();
+
+    if (m_params.Sync != ASYNC_WRITE_SYNC_NONE && MFX_ERR_NONE == m_status && !SyncFile(m_file))
+        m_status = MFX_ERR_UNDEFINED_BEHAVIOR;
+
+    m_file = NULL;
+    return m_status;
+}
+
+mfxStatus CAsyncFileWriter::AcquireBuffer() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_free.empty()) {
+        m_stat.bufferWaits++;
+        WriterClock::time_point start = WriterClock::now();
+        m_cvWritten.wait(lock, [&]() {
+            return !m_free.empty();
+        });
+        m_stat.bufferWaitTime += SecondsSince(start);
+    }
+    m_current = m_free.front();
+    m_free.pop_front();
+    return m_status;
+}
+
+void CAsyncFileWriter::SubmitBuffer() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.push_back(m_current);
+        m_stat.maxQueueDepth = std::max<mfxU64>(m_stat.maxQueueDepth, m_queue.size());
+        m_stat.queueDepthSum += m_queue.size();
+    }
+    m_current = NULL;
+    m_cvQueued.notify_one();
+}
+
+mfxStatus CAsyncFileWriter::Write(const mfxU8* data, mfxU32 size) {
+    if (!IsStarted())
+        return MFX_ERR_NOT_INITIALIZED;
+    if (size && !data)
+        return MFX_ERR_NULL_PTR;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (MFX_ERR_NONE != m_status)
+            return m_status;
+        m_stat.bytes += size;
+    }
+
+    while (size) {
+        if (!m_current) {
+            mfxStatus sts = AcquireBuffer();
+            if (MFX_ERR_NONE != sts)
+                return sts;
+        }
+
+        mfxU32 chunk = std::min(size, m_params.BufferSize - m_current->size);
+        memcpy(m_current->data.data() + m_current->size, data, chunk);
+        m_current->size += chunk;
+        data += chunk;
+        size -= chunk;
+
+        if (m_current->size == m_params.BufferSize)
+            SubmitBuffer();
+    }
+    return MFX_ERR_NONE;
+}
+
+mfxStatus CAsyncFileWriter::Flush() {
+    if (!IsStarted())
+        return m_status;
+
+    if (m_current) {
+        if (m_current->size) {
+            SubmitBuffer();
+        }
+        else {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_free.push_back(m_current);
+            m_current = NULL;
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cvWritten.wait(lock, [&]() {
+        return m_queue.empty() && !m_busy;
+    });
+    return m_status;
+}
+
+void CAsyncFileWriter::ThreadRoutine() {
+    for (;;) {
+        Buffer* buffer = NULL;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cvQueued.wait(lock, [&]() {
+                return m_bStop || !m_queue.empty();
+            });
+            if (m_queue.empty())
+                return;
+            buffer = m_queue.front();
+            m_queue.pop_front();
+            m_busy++;
+        }
+
+        WriterClock::time_point start = WriterClock::now();
+        // after a failure the data is dropped, the error is already reported to the caller
+        bool ok = MFX_ERR_NONE == m_status &&
+                  fwrite(buffer->data.data(), 1, buffer->size, m_file) == buffer->size;
+        if (ok && m_params.Sync == ASYNC_WRITE_SYNC_ALWAYS)
+            ok = SyncFile(m_file);
+        mfxF64 writeTime = SecondsSince(start);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!ok && MFX_ERR_NONE == m_status)
+                m_status = MFX_ERR_UNDEFINED_BEHAVIOR;
+            m_stat.writes++;
+            m_stat.writeTime += writeTime;
+            m_stat.maxWriteTime = std::max(m_stat.maxWriteTime, writeTime);
+            buffer->size        = 0;
+            m_free.push_back(buffer);
+            m_busy--;
+        }
+        m_cvWritten.notify_all();
+    }
+}
+
+CAsyncFileWriter::Statistics CAsyncFileWriter::GetStatistics() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stat;
+}
+
+void CAsyncFileWriter::PrintStatistics(const msdk_char* prefix) const {
+    Statistics stat = GetStatistics();
+    msdk_printf(
+        MSDK_STRING(
+            "%s Bytes:%llu,Writes:%llu,Queue depth avg:%.2lf max:%llu,Write latency avg:%.3lfms max:%.3lfms,Buffer waits:%llu(%.3lfms)\n"),
+        prefix,
+        (unsigned long long int)stat.bytes,
+        (unsigned long long int)stat.writes,
+        stat.writes ? (double)stat.queueDepthSum / stat.writes : 0.0,
+        (unsigned long long int)stat.maxQueueDepth,
+        stat.writes ? (double)stat.writeTime * 1000 / stat.writes : 0.0,
+        (double)stat.maxWriteTime * 1000,
+        (unsigned long long int)stat.bufferWaits,
+        (double)stat.bufferWaitTime * 1000);
+}
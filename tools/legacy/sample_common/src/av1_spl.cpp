@@ -0,0 +1,345 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include <string.h>
+
+#include "av1_spl.h"
+#include "sample_defs.h"
+
+namespace ProtectedLibrary {
+
+enum { AV1_MAX_LEB128_SIZE = 8, AV1_OBU_HAS_SIZE_FIELD_BIT = 0x02 };
+
+mfxStatus ReadLeb128(const mfxU8* data, mfxU32 size, mfxU32& value, mfxU32& length) {
+    mfxU64 result = 0;
+    for (mfxU32 i = 0; i < AV1_MAX_LEB128_SIZE; i++) {
+        if (i == size)
+            return MFX_ERR_MORE_DATA;
+
+        result |= (mfxU64)(data[i] & 0x7f) << (i * 7);
+        if (!(data[i] & 0x80)) {
+            if (result > 0xffffffff)
+                return MFX_ERR_UNDEFINED_BEHAVIOR;
+            value  = (mfxU32)result;
+            length = i + 1;
+            return MFX_ERR_NONE;
+        }
+    }
+    return MFX_ERR_UNDEFINED_BEHAVIOR;
+}
+
+mfxU32 WriteLeb128(mfxU8* data, mfxU32 value) {
+    mfxU32 length = 0;
+    do {
+        mfxU8 byte = value & 0x7f;
+        value >>= 7;
+        data[length++] = value ? (mfxU8)(byte | 0x80) : byte;
+    } while (value);
+    return length;
+}
+
+mfxStatus ReadObuHeader(const mfxU8* data, mfxU32 size, AV1ObuHeader& header, mfxU32& headerSize) {
+    if (!size)
+        return MFX_ERR_MORE_DATA;
+
+    // obu_forbidden_bit
+    if (data[0] & 0x80)
+        return MFX_ERR_UNDEFINED_BEHAVIOR;
+
+    header.obu_type           = (data[0] >> 3) & 0x0f;
+    header.obu_extension_flag = (data[0] >> 2) & 1;
+    header.obu_has_size_field = (data[0] >> 1) & 1;
+    header.temporal_id        = 0;
+    header.spatial_id         = 0;
+    headerSize                = 1;
+
+    if (header.obu_extension_flag) {
+        if (size < 2)
+            return MFX_ERR_MORE_DATA;
+        header.temporal_id = data[1] >> 5;
+        header.spatial_id  = (data[1] >> 3) & 3;
+        headerSize         = 2;
+    }
+    return MFX_ERR_NONE;
+}
+
+bool IsAV1KeyFrame(const mfxU8* data, mfxU32 size) {
+    bool sequenceHeader = false, reducedStillPicture = false;
+    for (mfxU32 offset = 0; offset < size;) {
+        AV1ObuHeader header;
+        mfxU32 headerSize = 0, obuSize = 0, length = 0;
+        if (ReadObuHeader(data + offset, size - offset, header, headerSize) != MFX_ERR_NONE ||
+            !header.obu_has_size_field ||
+            ReadLeb128(data + offset + headerSize, size - offset - headerSize, obuSize, length) !=
+                MFX_ERR_NONE)
+            return false;
+
+        const mfxU8* payload = data + offset + headerSize + length;
+        mfxU64 obuEnd        = (mfxU64)offset + headerSize + length + obuSize;
+        if (obuEnd > size)
+            return false;
+
+        if (obuSize && header.obu_type == AV1_OBU_SEQUENCE_HEADER) {
+            sequenceHeader = true;
+            // seq_profile, still_picture, reduced_still_picture_header
+            reducedStillPicture = (payload[0] >> 3) & 1;
+        }
+        else if (obuSize && (header.obu_type == AV1_OBU_FRAME_HEADER ||
+                             header.obu_type == AV1_OBU_FRAME)) {
+            if (!sequenceHeader)
+                return false;
+            if (reducedStillPicture)
+                return true;
+            // show_existing_frame is 0, frame_type is KEY_FRAME and show_frame is 1
+            return (payload[0] & 0xf0) == 0x10;
+        }
+        offset = (mfxU32)obuEnd;
+    }
+    return false;
+}
+
+AV1_Spl::AV1_Spl(AV1StreamFormat format)
+        : m_initialFormat(format),
+          m_format(format),
+          m_streamOffset(0),
+          m_frameOrder(0),
+          m_scanned(0),
+          m_currentFrame() {
+    memset(&m_frame, 0, sizeof(m_frame));
+}
+
+AV1_Spl::~AV1_Spl() {}
+
+mfxStatus AV1_Spl::Reset() {
+    m_format       = m_initialFormat;
+    m_streamOffset = 0;
+    m_frameOrder   = 0;
+    m_scanned      = 0;
+    return MFX_ERR_NONE;
+}
+
+void AV1_Spl::ResetCurrentState() {
+    m_frame.Data       = NULL;
+    m_frame.DataLength = 0;
+}
+
+mfxStatus AV1_Spl::PostProcessing(FrameSplitterInfo* frame, mfxU32 sliceNum) {
+    UNREFERENCED_PARAMETER(frame);
+    UNREFERENCED_PARAMETER(sliceNum);
+    return MFX_ERR_NONE;
+}
+
+void AV1_Spl::SetFrame(mfxU8* data, mfxU32 size, const mfxBitstream* bs) {
+    m_frame.Data       = data;
+    m_frame.DataLength = size;
+    m_frame.TimeStamp  = bs->TimeStamp;
+}
+
+mfxStatus AV1_Spl::DetectFormat(const mfxBitstream* bs) {
+    const mfxU8* data = bs->Data + bs->DataOffset;
+    mfxU32 size       = bs->DataLength;
+    if (!size)
+        return MFX_ERR_MORE_DATA;
+
+    // low overhead streams start with a temporal delimiter or a sequence header with obu_size
+    AV1ObuHeader header;
+    mfxU32 headerSize = 0, obuSize = 0, length = 0;
+    mfxStatus sts     = ReadObuHeader(data, size, header, headerSize);
+    if (sts == MFX_ERR_NONE && header.obu_has_size_field)
+        sts = ReadLeb128(data + headerSize, size - headerSize, obuSize, length);
+    if (sts == MFX_ERR_NONE && header.obu_has_size_field &&
+        ((header.obu_type == AV1_OBU_TEMPORAL_DELIMITER && !obuSize) ||
+         header.obu_type == AV1_OBU_SEQUENCE_HEADER)) {
+        m_format = AV1_FORMAT_LOW_OVERHEAD;
+        return MFX_ERR_NONE;
+    }
+    if (sts == MFX_ERR_MORE_DATA && !(bs->DataFlag & MFX_BITSTREAM_EOS))
+        return MFX_ERR_MORE_DATA;
+
+    // annex B streams start with temporal_unit_size, frame_unit_size and obu_length of the
+    // temporal delimiter
+    mfxU32 sizes[3] = {}, offset = 0;
+    for (mfxU32 i = 0; i < 3; i++) {
+        sts = ReadLeb128(data + offset, size - offset, sizes[i], length);
+        if (sts != MFX_ERR_NONE)
+            break;
+        offset += length;
+    }
+    if (sts == MFX_ERR_NONE)
+        sts = ReadObuHeader(data + offset, size - offset, header, headerSize);
+    if (sts == MFX_ERR_MORE_DATA && !(bs->DataFlag & MFX_BITSTREAM_EOS))
+        return MFX_ERR_MORE_DATA;
+
+    if (sts == MFX_ERR_NONE && sizes[1] <= sizes[0] && sizes[2] <= sizes[1] &&
+        sizes[2] >= headerSize && header.obu_type == AV1_OBU_TEMPORAL_DELIMITER) {
+        m_format = AV1_FORMAT_ANNEXB;
+        return MFX_ERR_NONE;
+    }
+    return MFX_ERR_UNSUPPORTED;
+}
+
+mfxStatus AV1_Spl::GetLowOverheadTemporalUnit(mfxBitstream* bs) {
+    mfxU8* data = bs->Data + bs->DataOffset;
+    mfxU32 size = bs->DataLength;
+
+    while (m_scanned < size) {
+        AV1ObuHeader header;
+        mfxU32 headerSize = 0, obuSize = 0, length = 0;
+        mfxStatus sts = ReadObuHeader(data + m_scanned, size - m_scanned, header, headerSize);
+        if (sts == MFX_ERR_NONE) {
+            // only containers can omit obu_size
+            if (!header.obu_has_size_field)
+                return MFX_ERR_UNDEFINED_BEHAVIOR;
+            sts = ReadLeb128(data + m_scanned + headerSize,
+                             size - m_scanned - headerSize,
+                             obuSize,
+                             length);
+        }
+        if (sts == MFX_ERR_MORE_DATA)
+            break;
+        if (sts != MFX_ERR_NONE)
+            return sts;
+
+        // a temporal delimiter starts the next temporal unit
+        if (header.obu_type == AV1_OBU_TEMPORAL_DELIMITER && m_scanned) {
+            SetFrame(data, m_scanned, bs);
+            bs->DataOffset += m_scanned;
+            bs->DataLength -= m_scanned;
+            m_scanned = 0;
+            return MFX_ERR_NONE;
+        }
+
+        mfxU64 obuEnd = (mfxU64)m_scanned + headerSize + length + obuSize;
+        if (obuEnd > size)
+            break;
+        m_scanned = (mfxU32)obuEnd;
+    }
+
+    if (!(bs->DataFlag & MFX_BITSTREAM_EOS))
+        return MFX_ERR_MORE_DATA;
+
+    // the last temporal unit, an incomplete OBU at the end of the stream is dropped
+    mfxU32 frameSize = m_scanned;
+    bs->DataOffset += bs->DataLength;
+    bs->DataLength = 0;
+    m_scanned      = 0;
+    if (!frameSize)
+        return MFX_ERR_MORE_DATA;
+
+    SetFrame(data, frameSize, bs);
+    return MFX_ERR_NONE;
+}
+
+mfxStatus AV1_Spl::AppendObu(const mfxU8* obu, mfxU32 obuLength) {
+    AV1ObuHeader header;
+    mfxU32 headerSize = 0;
+    mfxStatus sts     = ReadObuHeader(obu, obuLength, header, headerSize);
+    if (sts != MFX_ERR_NONE)
+        return MFX_ERR_UNDEFINED_BEHAVIOR;
+
+    if (header.obu_has_size_field) {
+        m_currentFrame.insert(m_currentFrame.end(), obu, obu + obuLength);
+        return MFX_ERR_NONE;
+    }
+
+    mfxU8 prefix[2 + AV1_MAX_LEB128_SIZE];
+    prefix[0] = (mfxU8)(obu[0] | AV1_OBU_HAS_SIZE_FIELD_BIT);
+    if (header.obu_extension_flag)
+        prefix[1] = obu[1];
+    mfxU32 prefixSize = headerSize + WriteLeb128(prefix + headerSize, obuLength - headerSize);
+
+    m_currentFrame.insert(m_currentFrame.end(), prefix, prefix + prefixSize);
+    m_currentFrame.insert(m_currentFrame.end(), obu + headerSize, obu + obuLength);
+    return MFX_ERR_NONE;
+}
+
+mfxStatus AV1_Spl::GetAnnexBTemporalUnit(mfxBitstream* bs) {
+    const mfxU8* data = bs->Data + bs->DataOffset;
+    mfxU32 size       = bs->DataLength;
+
+    mfxU32 unitSize = 0, length = 0;
+    mfxStatus sts   = ReadLeb128(data, size, unitSize, length);
+    if (sts == MFX_ERR_NONE && (mfxU64)length + unitSize > size)
+        sts = MFX_ERR_MORE_DATA;
+
+    if (sts == MFX_ERR_MORE_DATA) {
+        if (!(bs->DataFlag & MFX_BITSTREAM_EOS))
+            return MFX_ERR_MORE_DATA;
+
+        // the last temporal unit is incomplete
+        bs->DataOffset += bs->DataLength;
+        bs->DataLength = 0;
+        return MFX_ERR_MORE_DATA;
+    }
+    if (sts != MFX_ERR_NONE)
+        return sts;
+
+    m_currentFrame.clear();
+
+    const mfxU8* unit    = data + length;
+    const mfxU8* unitEnd = unit + unitSize;
+    while (unit < unitEnd) {
+        mfxU32 frameUnitSize = 0;
+        sts = ReadLeb128(unit, (mfxU32)(unitEnd - unit), frameUnitSize, length);
+        if (sts != MFX_ERR_NONE || (mfxU64)length + frameUnitSize > (mfxU64)(unitEnd - unit))
+            return MFX_ERR_UNDEFINED_BEHAVIOR;
+        unit += length;
+
+        const mfxU8* frameUnitEnd = unit + frameUnitSize;
+        while (unit < frameUnitEnd) {
+            mfxU32 obuLength = 0;
+            sts              = ReadLeb128(unit, (mfxU32)(frameUnitEnd - unit), obuLength, length);
+            if (sts != MFX_ERR_NONE ||
+                (mfxU64)length + obuLength > (mfxU64)(frameUnitEnd - unit))
+                return MFX_ERR_UNDEFINED_BEHAVIOR;
+            unit += length;
+
+            sts = AppendObu(unit, obuLength);
+            if (sts != MFX_ERR_NONE)
+                return sts;
+            unit += obuLength;
+        }
+    }
+
+    bs->DataOffset += (mfxU32)(unitEnd - data);
+    bs->DataLength -= (mfxU32)(unitEnd - data);
+
+    SetFrame(m_currentFrame.data(), (mfxU32)m_currentFrame.size(), bs);
+    return MFX_ERR_NONE;
+}
+
+mfxStatus AV1_Spl::GetFrame(mfxBitstream* bs_in, FrameSplitterInfo** frame) {
+    *frame = NULL;
+    if (!bs_in)
+        return MFX_ERR_MORE_DATA;
+
+    if (m_format == AV1_FORMAT_UNKNOWN) {
+        mfxStatus sts = DetectFormat(bs_in);
+        if (sts != MFX_ERR_NONE)
+            return sts;
+    }
+
+    // empty annex B temporal units are skipped
+    do {
+        mfxU32 offset        = bs_in->DataOffset;
+        m_frame.SourceOffset = m_streamOffset;
+
+        mfxStatus sts = m_format == AV1_FORMAT_ANNEXB ? GetAnnexBTemporalUnit(bs_in)
+                                                      : GetLowOverheadTemporalUnit(bs_in);
+        m_streamOffset += bs_in->DataOffset - offset;
+        if (sts != MFX_ERR_NONE)
+            return sts;
+    } while (!m_frame.DataLength);
+
+    // every temporal unit has one shown frame
+    m_frame.PicOrderCnt = m_frameOrder++;
+    m_frame.KeyFrame    = IsAV1KeyFrame(m_frame.Data, m_frame.DataLength);
+
+    *frame = &m_frame;
+    return MFX_ERR_NONE;
+}
+
+} // namespace ProtectedLibrary
@@ -10,27 +10,8 @@
 
 namespace ProtectedLibrary {
 
-mfxStatus DecodeExpGolombOne(mfxU32** ppBitStream,
-                             mfxI32* pBitOffset,
-                             mfxI32* pDst,
-                             mfxI32 isSigned);
-
 enum { SCLFLAT16 = 0, SCLDEFAULT = 1, SCLREDEFINED = 2 };
 
-const mfxU32 bits_data[] = {
-    (((mfxU32)0x01 << (0)) - 1),  (((mfxU32)0x01 << (1)) - 1),  (((mfxU32)0x01 << (2)) - 1),
-    (((mfxU32)0x01 << (3)) - 1),  (((mfxU32)0x01 << (4)) - 1),  (((mfxU32)0x01 << (5)) - 1),
-    (((mfxU32)0x01 << (6)) - 1),  (((mfxU32)0x01 << (7)) - 1),  (((mfxU32)0x01 << (8)) - 1),
-    (((mfxU32)0x01 << (9)) - 1),  (((mfxU32)0x01 << (10)) - 1), (((mfxU32)0x01 << (11)) - 1),
-    (((mfxU32)0x01 << (12)) - 1), (((mfxU32)0x01 << (13)) - 1), (((mfxU32)0x01 << (14)) - 1),
-    (((mfxU32)0x01 << (15)) - 1), (((mfxU32)0x01 << (16)) - 1), (((mfxU32)0x01 << (17)) - 1),
-    (((mfxU32)0x01 << (18)) - 1), (((mfxU32)0x01 << (19)) - 1), (((mfxU32)0x01 << (20)) - 1),
-    (((mfxU32)0x01 << (21)) - 1), (((mfxU32)0x01 << (22)) - 1), (((mfxU32)0x01 << (23)) - 1),
-    (((mfxU32)0x01 << (24)) - 1), (((mfxU32)0x01 << (25)) - 1), (((mfxU32)0x01 << (26)) - 1),
-    (((mfxU32)0x01 << (27)) - 1), (((mfxU32)0x01 << (28)) - 1), (((mfxU32)0x01 << (29)) - 1),
-    (((mfxU32)0x01 << (30)) - 1), (((mfxU32)0x01 << (31)) - 1), ((mfxU32)0xFFFFFFFF),
-};
-
 const mfxU8 default_intra_scaling_list4x4[16] = { 6,  13, 20, 28, 13, 20, 28, 32,
                                                   20, 28, 32, 37, 28, 32, 37, 42 };
 const mfxU8 default_inter_scaling_list4x4[16] = { 10, 14, 20, 24, 14, 20, 24, 27,
@@ -87,77 +68,6 @@ const mfxI32 hp_scan8x8[2][64] = {
       29, 14, 22, 37, 45, 53, 61, 30, 7, 15, 38, 46, 54, 62, 23, 31, 39, 47, 55, 63 }
 };
 
-#define avcSkipNBits(current_data, offset, nbits)    \
-    {                                                \
-        /* check error(s) */                         \
-        SAMPLE_ASSERT((nbits) > 0 && (nbits) <= 32); \
-        SAMPLE_ASSERT(offset >= 0 && offset <= 31);  \
-        /* decrease number of available bits */      \
-        offset -= (nbits);                           \
-        /* normalize bitstream pointer */            \
-        if (0 > offset) {                            \
-            offset += 32;                            \
-            current_data++;                          \
-        }                                            \
-        /* check error(s) again */                   \
-        SAMPLE_ASSERT(offset >= 0 && offset <= 31);  \
-    }
-
-#define avcGetBits8(current_data, offset, data) _avcGetBits(current_data, offset, 8, data);
-
-#define avcUngetNBits(current_data, offset, nbits)  \
-    {                                               \
-        SAMPLE_ASSERT(offset >= 0 && offset <= 31); \
-                                                    \
-        offset += (nbits);                          \
-        if (offset > 31) {                          \
-            offset -= 32;                           \
-            current_data--;                         \
-        }                                           \
-                                                    \
-        SAMPLE_ASSERT(offset >= 0 && offset <= 31); \
-    }
-
-#define avcUngetBits32(current_data, offset)    \
-    SAMPLE_ASSERT(offset >= 0 && offset <= 31); \
-    current_data--;
-
-#define avcAlignBSPointerRight(current_data, offset) \
-    {                                                \
-        if ((offset & 0x07) != 0x07) {               \
-            offset = (offset | 0x07) - 8;            \
-            if (offset == -1) {                      \
-                offset = 31;                         \
-                current_data++;                      \
-            }                                        \
-        }                                            \
-    }
-
-#define avcNextBits(current_data, bp, nbits, data)   \
-    {                                                \
-        mfxU32 x;                                    \
-                                                     \
-        SAMPLE_ASSERT((nbits) > 0 && (nbits) <= 32); \
-        SAMPLE_ASSERT(nbits >= 0 && nbits <= 31);    \
-                                                     \
-        mfxI32 offset = bp - (nbits);                \
-                                                     \
-        if (offset >= 0) {                           \
-            x = current_data[0] >> (offset + 1);     \
-        }                                            \
-        else {                                       \
-            offset += 32;                            \
-                                                     \
-            x = current_data[1] >> (offset);         \
-            x >>= 1;                                 \
-            x += current_data[0] << (31 - offset);   \
-        }                                            \
-                                                     \
-        SAMPLE_ASSERT(offset >= 0 && offset <= 31);  \
-                                                     \
-        (data) = x & bits_data[nbits];               \
-    }
-
 inline void FillFlatScalingList4x4(AVCScalingList4x4* scl) {
     for (mfxI32 i = 0; i < 16; i++)
         scl->ScalingListCoeffs[i] = 16;
@@ -189,52 +99,53 @@ AVCBaseBitstream::AVCBaseBitstream(mfxU8* const pb, const mfxU32 maxsize) {
 AVCBaseBitstream::~AVCBaseBitstream() {}
 
 void AVCBaseBitstream::Reset(mfxU8* const pb, const mfxU32 maxsize) {
-    m_pbs       = (mfxU32*)pb;
-    m_pbsBase   = (mfxU32*)pb;
-    m_bitOffset = 31;
-    m_maxBsSize = maxsize;
+    m_cache      = 0;
+    m_cachedBits = 0;
+    m_byteOffset = 0;
+    m_pbsBase    = pb;
+    m_maxBsSize  = maxsize;
 
 } // void Reset(mfxU8 * const pb, const mfxU32 maxsize)
 
-void AVCBaseBitstream::Reset(mfxU8* const pb, mfxI32 offset, const mfxU32 maxsize) {
-    m_pbs       = (mfxU32*)pb;
-    m_pbsBase   = (mfxU32*)pb;
-    m_bitOffset = offset;
-    m_maxBsSize = maxsize;
+void AVCBaseBitstream::RefillTail() {
+    // the last bytes of the buffer are loaded one by one, zeros are loaded past the end
+    while (m_cachedBits <= 56) {
+        if (m_byteOffset < m_maxBsSize)
+            m_cache |= (mfxU64)m_pbsBase[m_byteOffset] << (56 - m_cachedBits);
+        m_byteOffset++;
+        m_cachedBits += 8;
+    }
+}
 
-} // void Reset(mfxU8 * const pb, mfxI32 offset, const mfxU32 maxsize)
+void AVCBaseBitstream::SetBitPosition(mfxU32 position) {
+    m_cache      = 0;
+    m_cachedBits = 0;
+    m_byteOffset = position >> 3;
+    if (position & 7) {
+        Refill();
+        m_cache <<= position & 7;
+        m_cachedBits -= position & 7;
+    }
+}
 
 mfxStatus AVCBaseBitstream::GetNALUnitType(NAL_Unit_Type& uNALUnitType, mfxU8& uNALStorageIDC) {
-    mfxU32 code;
-    avcGetBits8(m_pbs, m_bitOffset, code);
+    mfxU32 code = GetBits(8);
 
     uNALStorageIDC = (mfxU8)((code & NAL_STORAGE_IDC_BITS) >> 5);
     uNALUnitType   = (NAL_Unit_Type)(code & NAL_UNITTYPE_BITS);
     return MFX_ERR_NONE;
 } // GetNALUnitType
 
-mfxI32 AVCBaseBitstream::GetVLCElement(bool bIsSigned) {
-    mfxI32 sval = 0;
-
-    mfxStatus ippRes = DecodeExpGolombOne(&m_pbs, &m_bitOffset, &sval, bIsSigned);
-
-    if (ippRes < MFX_ERR_NONE)
-        throw AVC_exception(MFX_ERR_UNDEFINED_BEHAVIOR);
-
-    return sval;
-}
-
 void AVCBaseBitstream::AlignPointerRight(void) {
-    avcAlignBSPointerRight(m_pbs, m_bitOffset);
+    SkipBits((8 - (BitsDecoded() & 7)) & 7);
 
 } // void AVCBitstream::AlignPointerRight(void)
 
 bool AVCBaseBitstream::More_RBSP_Data() {
-    mfxI32 code, tmp;
-    mfxU32* ptr_state = m_pbs;
-    mfxI32 bit_state  = m_bitOffset;
-
-    SAMPLE_ASSERT(m_bitOffset >= 0 && m_bitOffset <= 31);
+    mfxU32 code, tmp;
+    mfxU64 cache_state      = m_cache;
+    mfxU32 cached_state     = m_cachedBits;
+    mfxU32 byteOffset_state = m_byteOffset;
 
     mfxI32 remaining_bytes = (mfxI32)BytesLeft();
 
@@ -242,17 +153,18 @@ bool AVCBaseBitstream::More_RBSP_Data() {
         return false;
 
     // get top bit, it can be "rbsp stop" bit
-    avcGetNBits(m_pbs, m_bitOffset, 1, code);
+    Get1Bit();
 
     // get remain bits, which is less then byte
-    tmp = (m_bitOffset + 1) % 8;
+    tmp = (8 - (BitsDecoded() & 7)) & 7;
 
     if (tmp) {
-        avcGetNBits(m_pbs, m_bitOffset, tmp, code);
+        code = GetBits(tmp);
         if ((code << (8 - tmp)) & 0x7f) // most sig bit could be rbsp stop bit
         {
-            m_pbs       = ptr_state;
-            m_bitOffset = bit_state;
+            m_cache      = cache_state;
+            m_cachedBits = cached_state;
+            m_byteOffset = byteOffset_state;
             // there are more data
             return true;
         }
@@ -262,11 +174,12 @@ bool AVCBaseBitstream::More_RBSP_Data() {
 
     // run through remain bytes
     while (0 < remaining_bytes) {
-        avcGetBits8(m_pbs, m_bitOffset, code);
+        code = GetBits(8);
 
         if (code) {
-            m_pbs       = ptr_state;
-            m_bitOffset = bit_state;
+            m_cache      = cache_state;
+            m_cachedBits = cached_state;
+            m_byteOffset = byteOffset_state;
             // there are more data
             return true;
         }
@@ -1688,91 +1601,35 @@ void SetDefaultScalingLists(AVCSeqParamSet* sps) {
     }
 }
 
-mfxStatus DecodeExpGolombOne(mfxU32** ppBitStream,
-                             mfxI32* pBitOffset,
-                             mfxI32* pDst,
-                             mfxI32 isSigned) {
-    mfxU32 code;
-    mfxU32 info             = 0;
-    mfxI32 length           = 1; /* for first bit read above*/
-    mfxU32 thisChunksLength = 0;
-    mfxU32 sval;
-
-    /* Fast check for element = 0 */
-    avcGetNBits((*ppBitStream), (*pBitOffset), 1, code);
-    if (code) {
-        *pDst = 0;
-        return MFX_ERR_NONE;
-    }
-
-    avcGetNBits((*ppBitStream), (*pBitOffset), 8, code);
-    length += 8;
-
-    /* find nonzero byte */
-    while (code == 0) {
-        avcGetNBits((*ppBitStream), (*pBitOffset), 8, code);
-        length += 8;
-    }
-
-    /* find leading '1' */
-    while ((code & 0x80) == 0) {
-        code <<= 1;
-        thisChunksLength++;
-    }
-    length -= 8 - thisChunksLength;
-
-    avcUngetNBits((*ppBitStream), (*pBitOffset), 8 - (thisChunksLength + 1));
-
-    /* Get info portion of codeword */
-    if (length) {
-        avcGetNBits((*ppBitStream), (*pBitOffset), length, info);
-    }
-
-    sval = (1 << length) + info - 1;
-    if (isSigned) {
-        if (sval & 1)
-            *pDst = (mfxI32)((sval + 1) >> 1);
-        else
-            *pDst = -((mfxI32)(sval >> 1));
-    }
-    else
-        *pDst = (mfxI32)sval;
-
-    return MFX_ERR_NONE;
-}
-
 mfxI32 AVCHeadersBitstream::GetSEI(const HeaderSet<AVCSeqParamSet>& sps,
                                    mfxI32 current_sps,
                                    AVCSEIPayLoad* spl) {
     mfxU32 code;
     mfxI32 payloadType = 0;
 
-    avcNextBits(m_pbs, m_bitOffset, 8, code);
+    code = PeekBits(8);
     while (code == 0xFF) {
         /* fixed-pattern bit string using 8 bits written equal to 0xFF */
-        avcGetNBits(m_pbs, m_bitOffset, 8, code);
+        GetBits(8);
         payloadType += 255;
-        avcNextBits(m_pbs, m_bitOffset, 8, code);
+        code = PeekBits(8);
     }
 
-    mfxI32 last_payload_type_byte; //Ipp32u integer using 8 bits
-    avcGetNBits(m_pbs, m_bitOffset, 8, last_payload_type_byte);
+    mfxI32 last_payload_type_byte = GetBits(8); //Ipp32u integer using 8 bits
 
     payloadType += last_payload_type_byte;
 
     mfxI32 payloadSize = 0;
 
-    avcNextBits(m_pbs, m_bitOffset, 8, code);
+    code = PeekBits(8);
     while (code == 0xFF) {
         /* fixed-pattern bit string using 8 bits written equal to 0xFF */
-        avcGetNBits(m_pbs, m_bitOffset, 8, code);
+        GetBits(8);
         payloadSize += 255;
-        avcNextBits(m_pbs, m_bitOffset, 8, code);
+        code = PeekBits(8);
     }
 
-    mfxI32 last_payload_size_byte; //Ipp32u integer using 8 bits
-
-    avcGetNBits(m_pbs, m_bitOffset, 8, last_payload_size_byte);
+    mfxI32 last_payload_size_byte = GetBits(8); //Ipp32u integer using 8 bits
     payloadSize += last_payload_size_byte;
     spl->Reset();
     spl->payLoadSize = payloadSize;
@@ -1786,22 +1643,12 @@ mfxI32 AVCHeadersBitstream::GetSEI(const HeaderSet<AVCSeqParamSet>& sps,
         throw AVC_exception(MFX_ERR_UNDEFINED_BEHAVIOR);
     }
 
-    mfxU32* pbs;
-    mfxU32 bitOffsetU;
-    mfxI32 bitOffset;
-
-    pbs        = m_pbs;
-    bitOffsetU = m_bitOffset;
-    bitOffset  = bitOffsetU;
+    mfxU32 payloadPosition = BitsDecoded();
 
     mfxI32 ret = GetSEIPayload(sps, current_sps, spl);
 
-    for (mfxU32 i = 0; i < spl->payLoadSize; i++) {
-        avcSkipNBits(pbs, bitOffset, 8);
-    }
-
-    m_pbs       = pbs;
-    m_bitOffset = bitOffset;
+    // the payload parsers can stop anywhere, continue after the whole payload
+    SetBitPosition(payloadPosition + spl->payLoadSize * 8);
 
     return ret;
 }
@@ -1820,8 +1667,8 @@ mfxI32 AVCHeadersBitstream::GetSEIPayload(const HeaderSet<AVCSeqParamSet>& sps,
 mfxI32 AVCHeadersBitstream::reserved_sei_message(const HeaderSet<AVCSeqParamSet>&,
                                                  mfxI32 current_sps,
                                                  AVCSEIPayLoad* spl) {
-    for (mfxU32 i = 0; i < spl->payLoadSize; i++)
-        avcSkipNBits(m_pbs, m_bitOffset, 8) AlignPointerRight();
+    SkipBits(spl->payLoadSize * 8);
+    AlignPointerRight();
     return current_sps;
 }
 
@@ -5,8 +5,10 @@
   ############################################################################*/
 
 #include "avc_nal_spl.h"
+#include <string.h>
 #include <algorithm>
 #include "avc_structures.h"
+#include "frame_kernels.h"
 #include "sample_defs.h"
 
 namespace ProtectedLibrary {
@@ -36,23 +38,6 @@ inline bool IsVLCCode(mfxI32 iCode) {
            (NAL_UT_AUXILIARY == (iCode & AVC_NAL_UNITTYPE_BITS_MASK));
 }
 
-static mfxI32 FindStartCode(mfxU8*(&pb), mfxU32& nSize) {
-    // there is no data
-    if (nSize < 4)
-        return 0;
-
-    // find start code
-    while ((4 <= nSize) && ((0 != pb[0]) || (0 != pb[1]) || (1 != pb[2]))) {
-        pb += 1;
-        nSize -= 1;
-    }
-
-    if (4 <= nSize)
-        return ((pb[0] << 24) | (pb[1] << 16) | (pb[2] << 8) | (pb[3]));
-
-    return 0;
-}
-
 mfxStatus MoveBitstream(mfxBitstream* source, mfxI32 moveSize) {
     if (!source)
         return MFX_ERR_NULL_PTR;
@@ -72,6 +57,11 @@ mfxStatus MoveBitstream(mfxBitstream* source, mfxI32 moveSize) {
 StartCodeIterator::StartCodeIterator()
         : m_code(0),
           m_pts(MFX_TIME_STAMP_INVALID),
+          m_startCodeSize(0),
+          m_scanned(0),
+          m_truncated(),
+          m_bTruncated(false),
+          m_droppedSize(0),
           m_pSource(0),
           m_nSourceSize(0),
           m_pSourceBase(0),
@@ -81,9 +71,11 @@ StartCodeIterator::StartCodeIterator()
 }
 
 void StartCodeIterator::Reset() {
-    m_code = 0;
-    m_pts  = MFX_TIME_STAMP_INVALID;
-    m_prev.clear();
+    m_code          = 0;
+    m_pts           = MFX_TIME_STAMP_INVALID;
+    m_startCodeSize = 0;
+    m_scanned       = 0;
+    m_bTruncated    = false;
 }
 
 mfxI32 StartCodeIterator::Init(mfxBitstream* source) {
@@ -92,8 +84,14 @@ mfxI32 StartCodeIterator::Init(mfxBitstream* source) {
     m_pSourceBase = m_pSource = source->Data + source->DataOffset;
     m_nSourceBaseSize = m_nSourceSize = source->DataLength;
 
-    mfxI32 iCode = ProtectedLibrary::FindStartCode(m_pSource, m_nSourceSize);
-    return iCode;
+    mfxI32 startCodeSize = 0;
+    if (!FindNextStartCode(m_pSource, m_nSourceSize, startCodeSize))
+        return 0;
+
+    // the source is left at the 00 00 01 prefix, the code includes it as before
+    m_pSource -= 3;
+    m_nSourceSize += 3;
+    return (1 << 8) | m_pSource[3];
 }
 
 void StartCodeIterator::SetSuggestedSize(mfxU32 size) {
@@ -105,9 +103,6 @@ mfxI32 StartCodeIterator::CheckNalUnitType(mfxBitstream* source) {
     if (!source)
         return 0;
 
-    if (!m_code)
-        m_prev.clear();
-
     mfxU8* src  = source->Data + source->DataOffset;
     mfxU32 size = source->DataLength;
 
@@ -117,172 +112,139 @@ mfxI32 StartCodeIterator::CheckNalUnitType(mfxBitstream* source) {
 }
 
 mfxI32 StartCodeIterator::GetNALUnit(mfxBitstream* src, mfxBitstream* dst) {
-    if (!src)
-        return EndOfStream(dst);
-
-    if (!m_code)
-        m_prev.clear();
-
-    mfxU8* source = src->Data + src->DataOffset;
-    mfxU32 size   = src->DataLength;
-
-    if (!size)
+    // the data of an unfinished NAL unit isn't available without the source, the end of
+    // stream is signaled with MFX_BITSTREAM_EOS to complete it
+    if (!src) {
+        Reset();
         return 0;
+    }
 
-    mfxI32 startCodeSize = 0;
-
-    mfxI32 iCodeNext = FindStartCode(source, size, startCodeSize);
+    if (m_bTruncated)
+        return GetTruncatedNALUnit(src, dst);
 
-    if (m_prev.size()) {
-        if (!iCodeNext) {
-            size_t sz = source - (src->Data + src->DataOffset);
-            if (m_prev.size() + sz > m_suggestedSize) {
-                m_prev.clear();
-                sz = std::min<size_t>(sz, m_suggestedSize);
-            }
+    // the NAL unit header can be zero (HEVC TRAIL_N), a NAL unit is pending while its start
+    // code size is set
+    if (!m_startCodeSize) {
+        mfxU8* source        = src->Data + src->DataOffset;
+        mfxU32 size          = src->DataLength;
+        mfxI32 startCodeSize = 0;
 
-            m_prev.insert(m_prev.end(),
-                          src->Data + src->DataOffset,
-                          src->Data + src->DataOffset + sz);
-            MoveBitstream(src, (mfxI32)sz);
+        if (!FindNextStartCode(source, size, startCodeSize)) {
+            // keep the zeros which can begin a start code
+            MoveBitstream(src, (mfxI32)(source - (src->Data + src->DataOffset)));
             return 0;
         }
 
-        source -= startCodeSize;
-        m_prev.insert(m_prev.end(), src->Data + src->DataOffset, source);
-        MoveBitstream(src, (mfxI32)(source - (src->Data + src->DataOffset)));
-
-        dst->Data       = &(m_prev[0]);
-        dst->DataLength = (mfxU32)m_prev.size();
-        dst->DataOffset = 0;
-        dst->TimeStamp  = m_pts;
-        mfxI32 code     = m_code;
-        m_code          = 0;
-        m_pts           = MFX_TIME_STAMP_INVALID;
-        return code;
-    }
+        // move before start code
+        MoveBitstream(src, (mfxI32)(source - (src->Data + src->DataOffset) - startCodeSize));
 
-    if (!iCodeNext) {
-        MoveBitstream(src, (mfxI32)(source - (src->Data + src->DataOffset)));
-        return 0;
+        m_code          = source[0] & AVC_NAL_UNITTYPE_BITS_MASK;
+        m_pts           = src->TimeStamp;
+        m_startCodeSize = startCodeSize;
+        m_scanned       = 0;
+        m_droppedSize   = 0;
     }
 
-    m_pts  = src->TimeStamp;
-    m_code = iCodeNext;
-
-    // move before start code
-    MoveBitstream(src, (mfxI32)(source - (src->Data + src->DataOffset) - startCodeSize));
-
-    mfxI32 startCodeSize1 = 0;
-    iCodeNext             = FindStartCode(source, size, startCodeSize1);
-
-    MoveBitstream(src, startCodeSize);
+    mfxU8* nalUnit       = src->Data + src->DataOffset + m_startCodeSize;
+    mfxU8* source        = nalUnit + m_scanned;
+    mfxU32 size          = src->DataLength - m_startCodeSize - m_scanned;
+    mfxI32 startCodeSize = 0;
+    size_t nalSize       = 0;
 
-    if (!iCodeNext && (src->DataFlag & MFX_BITSTREAM_COMPLETE_FRAME)) {
-        iCodeNext      = 1;
-        startCodeSize1 = 0;
+    if (FindNextStartCode(source, size, startCodeSize)) {
+        nalSize = source - nalUnit - startCodeSize;
     }
-
-    if (!iCodeNext) {
-        if (m_prev.size()) // assertion: it should be
-            return 0;
-
-        size_t sz = source - (src->Data + src->DataOffset);
-        if (sz > m_suggestedSize) {
-            sz = m_suggestedSize;
+    else if (src->DataFlag & (MFX_BITSTREAM_COMPLETE_FRAME | MFX_BITSTREAM_EOS)) {
+        nalSize = source - nalUnit;
+    }
+    else {
+        // wait for more data, the search resumes at the possible start code
+        m_scanned = (mfxU32)(source - nalUnit);
+        if (m_scanned > m_suggestedSize) {
+            // keep the beginning of the NAL unit and drop the rest up to the next start code
+            m_truncated.assign(nalUnit, nalUnit + m_suggestedSize);
+            m_droppedSize = m_scanned - m_suggestedSize;
+            m_bTruncated  = true;
+            MoveBitstream(src, (mfxI32)(m_startCodeSize + m_scanned));
         }
-
-        m_prev.insert(m_prev.end(), src->Data + src->DataOffset, src->Data + src->DataOffset + sz);
-        MoveBitstream(src, (mfxI32)sz);
         return 0;
     }
 
-    // fill
-    size_t nal_size = source - (src->Data + src->DataOffset) - startCodeSize1;
-
-    dst->Data       = src->Data + src->DataOffset;
-    dst->DataLength = (mfxU32)nal_size;
+    dst->Data       = nalUnit;
+    dst->DataLength = (mfxU32)nalSize;
     dst->DataOffset = 0;
     dst->TimeStamp  = m_pts;
 
-    MoveBitstream(src, (mfxI32)nal_size);
+    MoveBitstream(src, (mfxI32)(m_startCodeSize + nalSize));
 
     mfxI32 code = m_code;
-    m_code      = 0;
-
-    m_pts = MFX_TIME_STAMP_INVALID;
+    Reset();
     return code;
 }
 
-mfxI32 StartCodeIterator::EndOfStream(mfxBitstream* dst) {
-    if (!m_code) {
-        m_prev.clear();
+mfxI32 StartCodeIterator::GetTruncatedNALUnit(mfxBitstream* src, mfxBitstream* dst) {
+    mfxU8* source        = src->Data + src->DataOffset;
+    mfxU32 size          = src->DataLength;
+    mfxI32 startCodeSize = 0;
+    bool complete        = true;
+
+    if (FindNextStartCode(source, size, startCodeSize))
+        source -= startCodeSize;
+    else if (src->DataFlag & (MFX_BITSTREAM_COMPLETE_FRAME | MFX_BITSTREAM_EOS))
+        source += size;
+    else
+        complete = false;
+
+    // the zeros which can begin a start code stay in the source
+    mfxU32 skipped = (mfxU32)(source - (src->Data + src->DataOffset));
+    m_droppedSize += skipped;
+    MoveBitstream(src, (mfxI32)skipped);
+    if (!complete)
         return 0;
-    }
 
-    if (m_prev.size()) {
-        dst->Data       = &(m_prev[0]);
-        dst->DataLength = (mfxU32)m_prev.size();
-        dst->DataOffset = 0;
-        dst->TimeStamp  = m_pts;
-        mfxI32 code     = m_code;
-        m_code          = 0;
-        m_pts           = MFX_TIME_STAMP_INVALID;
-        return code;
-    }
+    dst->Data       = m_truncated.data();
+    dst->DataLength = (mfxU32)m_truncated.size();
+    dst->DataOffset = 0;
+    dst->TimeStamp  = m_pts;
 
-    m_code = 0;
-    return 0;
+    mfxI32 code = m_code;
+    Reset();
+    return code;
 }
 
 mfxI32 StartCodeIterator::FindStartCode(mfxU8*(&pb), mfxU32& size, mfxI32& startCodeSize) {
-    mfxU32 zeroCount = 0;
+    if (!FindNextStartCode(pb, size, startCodeSize))
+        return 0;
+    return pb[0] & AVC_NAL_UNITTYPE_BITS_MASK;
+}
 
-    for (mfxU32 i = 0; i < (mfxU32)size; i++, pb++) {
-        switch (pb[0]) {
-            case 0x00:
-                zeroCount++;
-                break;
-            case 0x01:
-                if (zeroCount >= 2) {
-                    startCodeSize = std::min(zeroCount + 1, 4u);
-                    size -= i + 1;
-                    pb++; // remove 0x01 symbol
-                    zeroCount = 0;
-                    if (size >= 1) {
-                        return pb[0] & AVC_NAL_UNITTYPE_BITS_MASK;
-                    }
-                    else {
-                        pb -= startCodeSize;
-                        size += startCodeSize;
-                        startCodeSize = 0;
-                        return 0;
-                    }
-                }
-                zeroCount = 0;
-                break;
-            default:
-                zeroCount = 0;
-                break;
-        }
+bool FindNextStartCode(mfxU8*(&pb), mfxU32& size, mfxI32& startCodeSize) {
+    mfxU32 offset = FrameKernels::Kernels().FindZeroZeroByte(pb, size, 1);
+
+    if (offset < size) {
+        startCodeSize = (offset && !pb[offset - 1]) ? 4 : 3;
+        pb += offset + 3;
+        size -= offset + 3;
+        if (size >= 1)
+            return true;
+
+        // the NAL unit header is in the next data
+        pb -= startCodeSize;
+        size          = startCodeSize;
+        startCodeSize = 0;
+        return false;
     }
 
-    zeroCount = std::min(zeroCount, 3u);
-    pb -= zeroCount;
-    size += zeroCount;
-    zeroCount     = 0;
+    mfxU32 zeroCount = 0;
+    while (zeroCount < std::min(size, 3u) && !pb[size - 1 - zeroCount])
+        zeroCount++;
+    pb += size - zeroCount;
+    size          = zeroCount;
     startCodeSize = 0;
-    return 0;
+    return false;
 }
 
-void BytesSwapper::SwapMemory(mfxU8* pDestination,
-                              mfxU32& nDstSize,
-                              mfxU8* pSource,
-                              mfxU32 nSrcSize) {
-    SwapMemoryAndRemovePreventingBytes(pDestination, nDstSize, pSource, nSrcSize);
-}
-
-NALUnitSplitter::NALUnitSplitter() {
+NALUnitSplitter::NALUnitSplitter() : m_streamOffset(0), m_nalUnitOffset(0) {
     memset(&m_bitstream, 0, sizeof(m_bitstream));
 }
 
@@ -296,6 +258,8 @@ void NALUnitSplitter::Init() {
 
 void NALUnitSplitter::Reset() {
     m_pStartCodeIter.Reset();
+    m_streamOffset  = 0;
+    m_nalUnitOffset = 0;
 }
 
 void NALUnitSplitter::Release() {}
@@ -305,157 +269,38 @@ mfxI32 NALUnitSplitter::CheckNalUnitType(mfxBitstream* source) {
 }
 
 mfxI32 NALUnitSplitter::GetNalUnits(mfxBitstream* source, mfxBitstream*& destination) {
-    mfxI32 iCode = m_pStartCodeIter.GetNALUnit(source, &m_bitstream);
+    m_bitstream.Data = 0;
+    mfxU32 offset    = source ? source->DataOffset : 0;
+    mfxI32 iCode     = m_pStartCodeIter.GetNALUnit(source, &m_bitstream);
+    if (source)
+        m_streamOffset += source->DataOffset - offset;
 
-    if (iCode == 0) {
+    if (!m_bitstream.Data) {
         destination = 0;
         return 0;
     }
 
+    // the source is consumed up to the end of the NAL unit
+    m_nalUnitOffset =
+        m_streamOffset - m_bitstream.DataLength - m_pStartCodeIter.GetDroppedSize() - 3;
+
     destination = &m_bitstream;
     return iCode;
 }
 
-/* temporal class definition */
-class H264DwordPointer_ {
-public:
-    // Default constructor
-    H264DwordPointer_(void) {
-        m_pDest    = NULL;
-        m_nByteNum = 0;
-        m_iCur     = 0;
-    }
-
-    H264DwordPointer_ operator=(void* pDest) {
-        m_pDest    = (mfxU32*)pDest;
-        m_nByteNum = 0;
-        m_iCur     = 0;
-
-        return *this;
-    }
-
-    // Increment operator
-    H264DwordPointer_& operator++(void) {
-        if (4 == ++m_nByteNum) {
-            *m_pDest = m_iCur;
-            m_pDest += 1;
-            m_nByteNum = 0;
-            m_iCur     = 0;
-        }
-        else
-            m_iCur <<= 8;
-
-        return *this;
-    }
-
-    mfxU8 operator=(mfxU8 nByte) {
-        m_iCur = (m_iCur & ~0x0ff) | ((mfxU32)nByte);
-
-        return nByte;
-    }
-
-protected:
-    mfxU32* m_pDest; // pointer to destination buffer
-    mfxU32 m_nByteNum; // number of current byte in dword
-    mfxU32 m_iCur; // current dword
-};
-
-class H264SourcePointer_ {
-public:
-    // Default constructor
-    H264SourcePointer_(void) {
-        m_pSource       = NULL;
-        m_nRemovedBytes = 0;
-        m_nZeros        = 0;
-    }
-
-    H264SourcePointer_& operator=(mfxU8* pSource) {
-        m_pSource = (mfxU8*)pSource;
-
-        m_nZeros        = 0;
-        m_nRemovedBytes = 0;
-
-        return *this;
-    }
-
-    H264SourcePointer_& operator++(void) {
-        mfxU8 bCurByte = m_pSource[0];
-
-        if (0 == bCurByte)
-            m_nZeros += 1;
-        else {
-            if ((3 == bCurByte) && (2 <= m_nZeros))
-                m_nRemovedBytes += 1;
-            m_nZeros = 0;
-        }
-
-        m_pSource += 1;
-
-        return *this;
-    }
-
-    bool IsPrevent(void) {
-        if ((3 == m_pSource[0]) && (2 <= m_nZeros))
-            return true;
-        else
-            return false;
-    }
-
-    operator mfxU8(void) {
-        return m_pSource[0];
-    }
-
-    mfxU32 GetRemovedBytes(void) {
-        return m_nRemovedBytes;
-    }
-
-protected:
-    mfxU8* m_pSource; // pointer to destination buffer
-    mfxU32 m_nZeros; // number of preceding zeros
-    mfxU32 m_nRemovedBytes; // number of removed bytes
-};
-
-void SwapMemoryAndRemovePreventingBytes(mfxU8* pDestination,
-                                        mfxU32& nDstSize,
-                                        mfxU8* pSource,
-                                        mfxU32 nSrcSize) {
-    H264DwordPointer_ pDst;
-    H264SourcePointer_ pSrc;
-    size_t i;
-
-    // DwordPointer object is swapping written bytes
-    // H264SourcePointer_ removes preventing start-code bytes
-
-    // reset pointer(s)
-    pSrc = pSource;
-    pDst = pDestination;
-
-    // first two bytes
-    i = 0;
-    while (i < std::min(2u, nSrcSize)) {
-        pDst = (mfxU8)pSrc;
-        ++pDst;
-        ++pSrc;
-        ++i;
-    }
-
-    // do swapping
-    while (i < (mfxU32)nSrcSize) {
-        if (false == pSrc.IsPrevent()) {
-            pDst = (mfxU8)pSrc;
-            ++pDst;
-        }
-        ++pSrc;
-        ++i;
-    }
-
-    // write padding bytes
-    nDstSize = nSrcSize - pSrc.GetRemovedBytes();
-    while (nDstSize & 3) {
-        pDst = (mfxU8)(0);
-        ++nDstSize;
-        ++pDst;
+mfxU32 RemovePreventingBytes(mfxU8* pDestination, const mfxU8* pSource, mfxU32 nSrcSize) {
+    const FrameKernels::KernelTable& kernels = FrameKernels::Kernels();
+    mfxU32 nDstSize                          = 0;
+
+    // copy runs between 00 00 03 sequences, the zeros are kept and 03 is dropped
+    for (mfxU32 i = 0; i < nSrcSize;) {
+        mfxU32 run = kernels.FindZeroZeroByte(pSource + i, nSrcSize - i, 3);
+        run        = std::min(run + 2, nSrcSize - i);
+        memcpy(pDestination + nDstSize, pSource + i, run);
+        nDstSize += run;
+        i += run + 1;
     }
+    return nDstSize;
 }
 
 } // namespace ProtectedLibrary
@@ -22,7 +22,17 @@ void AVCFrameInfo::Reset() {
     m_index = 0;
 }
 
-AVC_Spl::AVC_Spl() : m_WaitForIDR(true), m_currentInfo(0), m_pLastSlice(0), m_lastNalUnit(0) {
+AVC_Spl::AVC_Spl()
+        : m_WaitForIDR(true),
+          m_currentInfo(0),
+          m_pLastSlice(0),
+          m_lastNalUnit(0),
+          m_nalUnitOffset(0),
+          m_lastNalUnitOffset(0),
+          m_prevPicOrderCntMsb(0),
+          m_prevPicOrderCntLsb(0),
+          m_prevFrameNumOffset(0),
+          m_prevFrameNum(0) {
     Init();
 }
 
@@ -66,14 +76,22 @@ mfxStatus AVC_Spl::Reset() {
     m_lastNalUnit = 0;
     m_pLastSlice  = 0;
     m_currentInfo = 0;
+
+    m_nalUnitOffset      = 0;
+    m_prevPicOrderCntMsb = 0;
+    m_prevPicOrderCntLsb = 0;
+    m_prevFrameNumOffset = 0;
+    m_prevFrameNum       = 0;
     return MFX_ERR_NONE;
 }
 
-mfxU8* AVC_Spl::GetMemoryForSwapping(mfxU32 size) {
-    if (m_swappingMemory.size() <= size + 8)
-        m_swappingMemory.resize(size + 8);
+mfxU8* AVC_Spl::ExtractRbsp(mfxBitstream* nalUnit, mfxU32 maxSize, mfxU32& rbspSize) {
+    mfxU32 size = std::min(nalUnit->DataLength, maxSize);
+    if (m_rbspMemory.size() < size + 1)
+        m_rbspMemory.resize(size + 1);
 
-    return &(m_swappingMemory[0]);
+    rbspSize = RemovePreventingBytes(&m_rbspMemory[0], nalUnit->Data + nalUnit->DataOffset, size);
+    return &m_rbspMemory[0];
 }
 
 mfxStatus AVC_Spl::DecodeHeader(mfxBitstream* nalUnit) {
@@ -82,15 +100,10 @@ mfxStatus AVC_Spl::DecodeHeader(mfxBitstream* nalUnit) {
     AVCHeadersBitstream bitStream;
 
     try {
-        mfxU32 swappingSize   = nalUnit->DataLength;
-        mfxU8* swappingMemory = GetMemoryForSwapping(swappingSize);
-
-        BytesSwapper::SwapMemory(swappingMemory,
-                                 swappingSize,
-                                 nalUnit->Data + nalUnit->DataOffset,
-                                 nalUnit->DataLength);
+        mfxU32 rbspSize = 0;
+        mfxU8* rbsp     = ExtractRbsp(nalUnit, nalUnit->DataLength, rbspSize);
 
-        bitStream.Reset(swappingMemory, swappingSize);
+        bitStream.Reset(rbsp, rbspSize);
 
         NAL_Unit_Type uNALUnitType;
         mfxU8 uNALStorageIDC = 0;
@@ -110,6 +123,7 @@ mfxStatus AVC_Spl::DecodeHeader(mfxBitstream* nalUnit) {
                     m_headers.m_SeqParams.GetHeader(sps.seq_parameter_set_id);
 
                     m_pNALSplitter->SetSuggestedSize(CalculateSuggestedSize(&sps));
+                    KeepHeader(0, sps.seq_parameter_set_id, nalUnit);
 
                     if (umcRes != MFX_ERR_NONE)
                         return umcRes;
@@ -124,6 +138,7 @@ mfxStatus AVC_Spl::DecodeHeader(mfxBitstream* nalUnit) {
 
                 if (umcRes == MFX_ERR_NONE) {
                     m_headers.m_SeqExParams.AddHeader(&sps_ex);
+                    KeepHeader(1, sps_ex.seq_parameter_set_id, nalUnit);
                 }
                 else
                     return umcRes;
@@ -152,6 +167,7 @@ mfxStatus AVC_Spl::DecodeHeader(mfxBitstream* nalUnit) {
                     umcRes = bitStream.GetPictureParamSetPart2(&pps, pRefsps);
                     if (MFX_ERR_NONE == umcRes) {
                         m_headers.m_PicParams.AddHeader(&pps);
+                        KeepHeader(3, pps.pic_parameter_set_id, nalUnit);
                     }
 
                     m_headers.m_SeqParams.SetCurrentID(pps.seq_parameter_set_id);
@@ -175,6 +191,7 @@ mfxStatus AVC_Spl::DecodeHeader(mfxBitstream* nalUnit) {
                     *sps_temp = sps;
 
                     m_headers.m_SeqParamsMvcExt.AddHeader(&spsMvcExt);
+                    KeepHeader(2, sps.seq_parameter_set_id, nalUnit);
                 }
             } break;
 
@@ -207,15 +224,10 @@ mfxStatus AVC_Spl::DecodeSEI(mfxBitstream* nalUnit) {
     AVCHeadersBitstream bitStream;
 
     try {
-        mfxU32 swappingSize   = nalUnit->DataLength;
-        mfxU8* swappingMemory = GetMemoryForSwapping(swappingSize);
-
-        BytesSwapper::SwapMemory(swappingMemory,
-                                 swappingSize,
-                                 nalUnit->Data + nalUnit->DataOffset,
-                                 nalUnit->DataLength);
+        mfxU32 rbspSize = 0;
+        mfxU8* rbsp     = ExtractRbsp(nalUnit, nalUnit->DataLength, rbspSize);
 
-        bitStream.Reset(swappingMemory, swappingSize);
+        bitStream.Reset(rbsp, rbspSize);
 
         NAL_Unit_Type uNALUnitType;
         mfxU8 uNALStorageIDC = 0;
@@ -246,15 +258,11 @@ AVCSlice* AVC_Spl::DecodeSliceHeader(mfxBitstream* nalUnit) {
     m_slicesStorage.push_back(AVCSlice());
     AVCSlice* pSlice = &m_slicesStorage.back();
 
-    mfxU32 swappingSize   = nalUnit->DataLength;
-    mfxU8* swappingMemory = GetMemoryForSwapping(swappingSize);
+    // only the beginning of the slice is needed for the header
+    mfxU32 rbspSize = 0;
+    mfxU8* rbsp     = ExtractRbsp(nalUnit, SLICE_HEADER_PREFIX_SIZE, rbspSize);
 
-    BytesSwapper::SwapMemory(swappingMemory,
-                             swappingSize,
-                             nalUnit->Data + nalUnit->DataOffset,
-                             nalUnit->DataLength);
-
-    mfxI32 pps_pid = pSlice->RetrievePicParamSetNumber(swappingMemory, swappingSize);
+    mfxI32 pps_pid = pSlice->RetrievePicParamSetNumber(rbsp, rbspSize);
     if (pps_pid == -1) {
         return 0;
     }
@@ -296,7 +304,14 @@ AVCSlice* AVC_Spl::DecodeSliceHeader(mfxBitstream* nalUnit) {
     pSlice->m_seqParamSetEx = m_headers.m_SeqExParams.GetHeader(seq_parameter_set_id);
     pSlice->m_dTime         = nalUnit->TimeStamp;
 
-    if (!pSlice->DecodeHeader(swappingMemory, swappingSize)) {
+    bool decoded = pSlice->DecodeHeader(rbsp, rbspSize);
+    if (nalUnit->DataLength > SLICE_HEADER_PREFIX_SIZE &&
+        (!decoded || pSlice->GetBitStream()->BitsDecoded() > rbspSize * 8)) {
+        // the header can continue after the prefix
+        rbsp    = ExtractRbsp(nalUnit, nalUnit->DataLength, rbspSize);
+        decoded = pSlice->DecodeHeader(rbsp, rbspSize);
+    }
+    if (!decoded) {
         return 0;
     }
 
@@ -313,10 +328,106 @@ AVCFrameInfo* AVC_Spl::GetFreeFrame() {
     return m_AUInfo.get();
 }
 
+void AVC_Spl::KeepHeader(mfxU32 rank, mfxU32 id, const mfxBitstream* nalUnit) {
+    static mfxU8 start_code_prefix[] = { 0, 0, 1 };
+
+    std::vector<mfxU8>& header = m_headerNalUnits[(rank << 16) | id];
+    header.assign(start_code_prefix, start_code_prefix + sizeof(start_code_prefix));
+    header.insert(header.end(),
+                  nalUnit->Data + nalUnit->DataOffset,
+                  nalUnit->Data + nalUnit->DataOffset + nalUnit->DataLength);
+}
+
+void AVC_Spl::GetHeaders(std::vector<mfxU8>& headers) {
+    headers.clear();
+    for (const auto& header : m_headerNalUnits)
+        headers.insert(headers.end(), header.second.begin(), header.second.end());
+}
+
+mfxI32 AVC_Spl::CalculatePicOrderCnt(AVCSlice* slice) {
+    const AVCSeqParamSet* sps = slice->m_seqParamSet;
+    const AVCSliceHeader* hdr = slice->GetSliceHeader();
+    if (!sps)
+        return 0;
+
+    bool idr   = hdr->nal_unit_type == NAL_UT_IDR_SLICE;
+    mfxI32 top = 0, bottom = 0;
+
+    if (sps->pic_order_cnt_type == 0) {
+        if (idr) {
+            m_prevPicOrderCntMsb = 0;
+            m_prevPicOrderCntLsb = 0;
+        }
+
+        mfxI32 maxLsb = (mfxI32)sps->MaxPicOrderCntLsb;
+        mfxI32 lsb    = hdr->pic_order_cnt_lsb;
+        mfxI32 msb    = m_prevPicOrderCntMsb;
+        if (lsb < m_prevPicOrderCntLsb && m_prevPicOrderCntLsb - lsb >= maxLsb / 2)
+            msb += maxLsb;
+        else if (lsb > m_prevPicOrderCntLsb && lsb - m_prevPicOrderCntLsb > maxLsb / 2)
+            msb -= maxLsb;
+
+        top    = msb + lsb;
+        bottom = hdr->field_pic_flag ? top : top + hdr->delta_pic_order_cnt_bottom;
+
+        if (hdr->nal_ref_idc) {
+            m_prevPicOrderCntMsb = msb;
+            m_prevPicOrderCntLsb = lsb;
+        }
+        return std::min(top, bottom);
+    }
+
+    mfxI32 maxFrameNum    = 1 << sps->log2_max_frame_num;
+    mfxI32 frameNumOffset = 0;
+    if (!idr)
+        frameNumOffset =
+            m_prevFrameNumOffset + (m_prevFrameNum > hdr->frame_num ? maxFrameNum : 0);
+
+    if (sps->pic_order_cnt_type == 1) {
+        mfxI32 cycle       = (mfxI32)sps->num_ref_frames_in_pic_order_cnt_cycle;
+        mfxI32 absFrameNum = cycle ? frameNumOffset + hdr->frame_num : 0;
+        if (!hdr->nal_ref_idc && absFrameNum > 0)
+            absFrameNum--;
+
+        mfxI32 expected = 0;
+        if (absFrameNum > 0) {
+            mfxI32 deltaPerCycle = 0;
+            for (mfxI32 i = 0; i < cycle; i++)
+                deltaPerCycle += sps->poffset_for_ref_frame[i];
+
+            expected = (absFrameNum - 1) / cycle * deltaPerCycle;
+            for (mfxI32 i = 0; i <= (absFrameNum - 1) % cycle; i++)
+                expected += sps->poffset_for_ref_frame[i];
+        }
+        if (!hdr->nal_ref_idc)
+            expected += sps->offset_for_non_ref_pic;
+
+        if (!hdr->field_pic_flag) {
+            top    = expected + hdr->delta_pic_order_cnt[0];
+            bottom = top + sps->offset_for_top_to_bottom_field + hdr->delta_pic_order_cnt[1];
+        }
+        else if (!hdr->bottom_field_flag) {
+            top = bottom = expected + hdr->delta_pic_order_cnt[0];
+        }
+        else {
+            top = bottom =
+                expected + sps->offset_for_top_to_bottom_field + hdr->delta_pic_order_cnt[0];
+        }
+    }
+    else if (!idr) {
+        top = bottom = 2 * (frameNumOffset + hdr->frame_num) - (hdr->nal_ref_idc ? 0 : 1);
+    }
+
+    m_prevFrameNumOffset = frameNumOffset;
+    m_prevFrameNum       = hdr->frame_num;
+    return std::min(top, bottom);
+}
+
 void AVC_Spl::ResetCurrentState() {
     m_frame.DataLength         = 0;
     m_frame.SliceNum           = 0;
     m_frame.FirstFieldSliceNum = 0;
+    m_frame.KeyFrame           = false;
     m_AUInfo->Reset();
     if (m_slicesStorage.size() > 1) {
         m_slicesStorage.erase(m_slicesStorage.begin(), --m_slicesStorage.end());
@@ -437,20 +548,40 @@ mfxStatus AVC_Spl::AddSlice(AVCSlice* pSlice) {
     return MFX_ERR_MORE_DATA;
 }
 
+mfxStatus AVC_Spl::ReserveFrameData(mfxU32 size) {
+    if (m_frame.DataLength + size < m_currentFrame.size())
+        return MFX_ERR_NONE;
+
+    if (m_frame.DataLength + size >= MAX_BUFFER_SIZE)
+        return MFX_ERR_NOT_ENOUGH_BUFFER;
+
+    size_t newSize = m_currentFrame.size();
+    while (newSize <= m_frame.DataLength + size)
+        newSize *= 2;
+    m_currentFrame.resize(std::min<size_t>(newSize, MAX_BUFFER_SIZE));
+    m_frame.Data = &m_currentFrame[0];
+
+    return MFX_ERR_NONE;
+}
+
 mfxStatus AVC_Spl::AddNalUnit(mfxBitstream* nalUnit) {
     static mfxU8 start_code_prefix[] = { 0, 0, 1 };
 
-    if (m_frame.DataLength + nalUnit->DataLength + sizeof(start_code_prefix) >= BUFFER_SIZE)
+    if (ReserveFrameData((mfxU32)(nalUnit->DataLength + sizeof(start_code_prefix))) !=
+        MFX_ERR_NONE)
         return MFX_ERR_NOT_ENOUGH_BUFFER;
 
+    if (!m_frame.DataLength)
+        m_frame.SourceOffset = m_nalUnitOffset;
+
     MSDK_MEMCPY_BUF(m_frame.Data,
                     m_frame.DataLength,
-                    BUFFER_SIZE,
+                    m_currentFrame.size(),
                     start_code_prefix,
                     sizeof(start_code_prefix));
     MSDK_MEMCPY_BUF(m_frame.Data,
                     m_frame.DataLength + sizeof(start_code_prefix),
-                    BUFFER_SIZE,
+                    m_currentFrame.size(),
                     nalUnit->Data + nalUnit->DataOffset,
                     nalUnit->DataLength);
 
@@ -464,20 +595,33 @@ mfxStatus AVC_Spl::AddSliceNalUnit(mfxBitstream* nalUnit, AVCSlice* slice) {
 
     mfxU32 sliceLength = (mfxU32)(nalUnit->DataLength + sizeof(start_code_prefix));
 
-    if (m_frame.DataLength + sliceLength >= BUFFER_SIZE)
+    if (ReserveFrameData(sliceLength) != MFX_ERR_NONE)
         return MFX_ERR_NOT_ENOUGH_BUFFER;
 
     MSDK_MEMCPY_BUF(m_frame.Data,
                     m_frame.DataLength,
-                    BUFFER_SIZE,
+                    m_currentFrame.size(),
                     start_code_prefix,
                     sizeof(start_code_prefix));
     MSDK_MEMCPY_BUF(m_frame.Data,
                     m_frame.DataLength + sizeof(start_code_prefix),
-                    BUFFER_SIZE,
+                    m_currentFrame.size(),
                     nalUnit->Data + nalUnit->DataOffset,
                     nalUnit->DataLength);
 
+    if (!m_frame.DataLength)
+        m_frame.SourceOffset = m_nalUnitOffset;
+
+    // the second field is a separate picture with its own order count
+    bool secondField = m_currentInfo->m_index && m_frame.SliceNum == m_frame.FirstFieldSliceNum;
+    if (!m_frame.SliceNum || secondField) {
+        mfxI32 picOrderCnt = CalculatePicOrderCnt(slice);
+        if (!m_frame.SliceNum) {
+            m_frame.PicOrderCnt = picOrderCnt;
+            m_frame.KeyFrame    = slice->GetSliceHeader()->nal_unit_type == NAL_UT_IDR_SLICE;
+        }
+    }
+
     if (!m_frame.SliceNum) {
         m_frame.TimeStamp = nalUnit->TimeStamp;
     }
@@ -542,7 +686,8 @@ mfxStatus AVC_Spl::ProcessNalUnit(mfxI32 nalType, mfxBitstream* nalUnit) {
                     AddSliceNalUnit(nalUnit, pSlice);
                 }
                 else {
-                    m_lastNalUnit = nalUnit;
+                    m_lastNalUnit       = nalUnit;
+                    m_lastNalUnitOffset = m_nalUnitOffset;
                 }
 
                 if (sts == MFX_ERR_NONE) {
@@ -598,6 +743,7 @@ mfxStatus AVC_Spl::GetFrame(mfxBitstream* bs_in, FrameSplitterInfo** frame) {
                 msdk_printf(MSDK_STRING("ERROR: m_lastNalUnit=NULL\n"));
                 return MFX_ERR_NULL_PTR;
             }
+            m_nalUnitOffset = m_lastNalUnitOffset;
             AddSliceNalUnit(m_lastNalUnit, pSlice);
             m_lastNalUnit = 0;
             if (sts == MFX_ERR_NONE)
@@ -606,14 +752,21 @@ mfxStatus AVC_Spl::GetFrame(mfxBitstream* bs_in, FrameSplitterInfo** frame) {
 
         mfxBitstream* destination = NULL;
         mfxI32 nalType            = m_pNALSplitter->GetNalUnits(bs_in, destination);
+        m_nalUnitOffset           = m_pNALSplitter->GetNalUnitOffset();
         mfxStatus sts             = ProcessNalUnit(nalType, destination);
 
-        if (sts == MFX_ERR_NONE || (!bs_in && m_frame.SliceNum)) {
+        // after the last NAL unit of the stream the current frame is complete
+        bool endOfStream = !bs_in || (!destination && (bs_in->DataFlag & MFX_BITSTREAM_EOS));
+        if (sts == MFX_ERR_NONE || (endOfStream && m_frame.SliceNum)) {
             m_currentInfo = 0;
             *frame        = &m_frame;
             return MFX_ERR_NONE;
         }
 
+        // the rest of the NAL unit isn't in the bitstream yet
+        if (!destination)
+            break;
+
     } while (bs_in && bs_in->DataLength > MINIMAL_DATA_SIZE);
 
     return MFX_ERR_MORE_DATA;
@@ -86,11 +86,16 @@ mfxStatus BaseFrameAllocator::ReallocFrame(mfxMemId midIn,
                                            const mfxFrameInfo* info,
                                            mfxU16 memType,
                                            mfxMemId* midOut) {
+    // the frame may be moved to memory taken by an allocation running at the same time
+    std::lock_guard<std::mutex> lock(mtx);
+
     return ReallocImpl(midIn, info, memType, midOut);
 }
 
 mfxStatus BaseFrameAllocator::AllocFrames(mfxFrameAllocRequest* request,
                                           mfxFrameAllocResponse* response) {
+    std::lock_guard<std::mutex> lock(mtx);
+
     if (0 == request || 0 == response || 0 == request->NumFrameSuggested)
         return MFX_ERR_MEMORY_ALLOC;
 
@@ -0,0 +1,212 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include "frame_kernels.h"
+
+#if defined(SAMPLE_FRAME_KERNELS_X86)
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+    #else
+        #include <cpuid.h>
+    #endif
+#endif
+
+namespace FrameKernels {
+
+namespace {
+
+void InterleaveUV_Scalar(const mfxU8* u, const mfxU8* v, mfxU8* uv, mfxU32 count) {
+    for (mfxU32 i = 0; i < count; i++) {
+        uv[2 * i]     = u[i];
+        uv[2 * i + 1] = v[i];
+    }
+}
+
+void DeinterleaveUV_Scalar(const mfxU8* uv, mfxU8* u, mfxU8* v, mfxU32 count) {
+    for (mfxU32 i = 0; i < count; i++) {
+        u[i] = uv[2 * i];
+        v[i] = uv[2 * i + 1];
+    }
+}
+
+void ShiftLeft16_Scalar(const mfxU16* src, mfxU16* dst, mfxU32 count, mfxU32 shift) {
+    for (mfxU32 i = 0; i < count; i++) {
+        dst[i] = (mfxU16)(src[i] << shift);
+    }
+}
+
+void ShiftRight16_Scalar(const mfxU16* src, mfxU16* dst, mfxU32 count, mfxU32 shift) {
+    for (mfxU32 i = 0; i < count; i++) {
+        dst[i] = src[i] >> shift;
+    }
+}
+
+void PackY210_Scalar(const mfxU16* y,
+                     const mfxU16* u,
+                     const mfxU16* v,
+                     mfxU16* dst,
+                     mfxU32 count,
+                     mfxU32 shift) {
+    for (mfxU32 i = 0; i < count; i++) {
+        dst[4 * i]     = (mfxU16)(y[2 * i] << shift);
+        dst[4 * i + 1] = (mfxU16)(u[i] << shift);
+        dst[4 * i + 2] = (mfxU16)(y[2 * i + 1] << shift);
+        dst[4 * i + 3] = (mfxU16)(v[i] << shift);
+    }
+}
+
+void PackY410_Scalar(const mfxU16* y, const mfxU16* u, const mfxU16* v, mfxU32* dst, mfxU32 count) {
+    for (mfxU32 i = 0; i < count; i++) {
+        dst[i] = (mfxU32)(u[i] & 0x3ff) | ((mfxU32)(y[i] & 0x3ff) << 10) |
+                 ((mfxU32)(v[i] & 0x3ff) << 20) | (3u << 30);
+    }
+}
+
+void SwapRB32_Scalar(const mfxU8* src, mfxU8* dst, mfxU32 count) {
+    for (mfxU32 i = 0; i < count; i++) {
+        mfxU8 r        = src[4 * i];
+        mfxU8 g        = src[4 * i + 1];
+        mfxU8 b        = src[4 * i + 2];
+        mfxU8 a        = src[4 * i + 3];
+        dst[4 * i]     = b;
+        dst[4 * i + 1] = g;
+        dst[4 * i + 2] = r;
+        dst[4 * i + 3] = a;
+    }
+}
+
+mfxU32 FindZeroZeroByte_Scalar(const mfxU8* data, mfxU32 size, mfxU8 value) {
+    for (mfxU32 i = 0; i + 2 < size; i++) {
+        if (data[i + 2] == value && !data[i + 1] && !data[i])
+            return i;
+    }
+    return size;
+}
+
+const KernelTable g_scalarKernels = {
+    InterleaveUV_Scalar, DeinterleaveUV_Scalar, ShiftLeft16_Scalar,       ShiftRight16_Scalar,
+    PackY210_Scalar,     PackY410_Scalar,       SwapRB32_Scalar,          FindZeroZeroByte_Scalar,
+};
+
+#if defined(SAMPLE_FRAME_KERNELS_X86)
+
+void CpuId(mfxU32 leaf, mfxU32 subleaf, mfxU32 regs[4]) {
+    #if defined(_MSC_VER)
+    int info[4];
+    __cpuidex(info, (int)leaf, (int)subleaf);
+    for (int i = 0; i < 4; i++)
+        regs[i] = (mfxU32)info[i];
+    #else
+    if (!__get_cpuid_count(leaf, subleaf, &regs[0], &regs[1], &regs[2], &regs[3]))
+        regs[0] = regs[1] = regs[2] = regs[3] = 0;
+    #endif
+}
+
+// State components enabled by the OS (XCR0)
+mfxU64 GetEnabledXState() {
+    #if defined(_MSC_VER)
+    return _xgetbv(0);
+    #else
+    mfxU32 eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((mfxU64)edx << 32) | eax;
+    #endif
+}
+
+Isa DetectIsa() {
+    mfxU32 regs[4];
+    CpuId(0, 0, regs);
+    mfxU32 maxLeaf = regs[0];
+    if (maxLeaf < 1)
+        return ISA_SCALAR;
+
+    CpuId(1, 0, regs);
+    bool sse42   = (regs[2] & (1u << 20)) != 0;
+    bool ssse3   = (regs[2] & (1u << 9)) != 0;
+    bool osxsave = (regs[2] & (1u << 27)) != 0;
+    if (!sse42 || !ssse3)
+        return ISA_SCALAR;
+    if (!osxsave || maxLeaf < 7)
+        return ISA_SSE42;
+
+    mfxU64 xcr0 = GetEnabledXState();
+    // XMM and YMM state
+    if ((xcr0 & 0x6) != 0x6)
+        return ISA_SSE42;
+
+    CpuId(7, 0, regs);
+    bool avx2     = (regs[1] & (1u << 5)) != 0;
+    bool avx512f  = (regs[1] & (1u << 16)) != 0;
+    bool avx512bw = (regs[1] & (1u << 30)) != 0;
+    if (!avx2)
+        return ISA_SSE42;
+    // opmask, upper ZMM0-15 and ZMM16-31 state
+    if (avx512f && avx512bw && (xcr0 & 0xe0) == 0xe0)
+        return ISA_AVX512;
+    return ISA_AVX2;
+}
+
+#else
+
+Isa DetectIsa() {
+    return ISA_SCALAR;
+}
+
+#endif // #if defined(SAMPLE_FRAME_KERNELS_X86)
+
+} // namespace
+
+const KernelTable* GetKernels(Isa isa) {
+    switch (isa) {
+        case ISA_SCALAR:
+            return &g_scalarKernels;
+        case ISA_SSE42:
+            return GetKernelsSSE42();
+        case ISA_AVX2:
+            return GetKernelsAVX2();
+        case ISA_AVX512:
+            return GetKernelsAVX512();
+        default:
+            return NULL;
+    }
+}
+
+Isa GetBestIsa() {
+    static const Isa isa = DetectIsa();
+    return isa;
+}
+
+bool IsIsaSupported(Isa isa) {
+    return isa < ISA_COUNT && isa <= GetBestIsa() && GetKernels(isa) != NULL;
+}
+
+const KernelTable& Kernels() {
+    static const KernelTable* kernels = []() {
+        for (int isa = GetBestIsa(); isa > ISA_SCALAR; isa--) {
+            if (GetKernels((Isa)isa))
+                return GetKernels((Isa)isa);
+        }
+        return &g_scalarKernels;
+    }();
+    return *kernels;
+}
+
+const char* GetIsaName(Isa isa) {
+    switch (isa) {
+        case ISA_SCALAR:
+            return "scalar";
+        case ISA_SSE42:
+            return "sse4.2";
+        case ISA_AVX2:
+            return "avx2";
+        case ISA_AVX512:
+            return "avx512";
+        default:
+            return "unknown";
+    }
+}
+
+} // namespace FrameKernels
@@ -0,0 +1,166 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include "frame_kernels.h"
+
+#if defined(SAMPLE_FRAME_KERNELS_X86)
+
+    #include <immintrin.h>
+
+namespace FrameKernels {
+
+namespace {
+
+void InterleaveUV_AVX2(const mfxU8* u, const mfxU8* v, mfxU8* uv, mfxU32 count) {
+    mfxU32 i = 0;
+    for (; i + 32 <= count; i += 32) {
+        __m256i vu = _mm256_loadu_si256((const __m256i*)(u + i));
+        __m256i vv = _mm256_loadu_si256((const __m256i*)(v + i));
+        // unpack works inside 128-bit lanes, lanes are reordered on store
+        __m256i lo = _mm256_unpacklo_epi8(vu, vv);
+        __m256i hi = _mm256_unpackhi_epi8(vu, vv);
+        _mm256_storeu_si256((__m256i*)(uv + 2 * i), _mm256_permute2x128_si256(lo, hi, 0x20));
+        _mm256_storeu_si256((__m256i*)(uv + 2 * i + 32), _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+    GetKernelsSSE42()->InterleaveUV(u + i, v + i, uv + 2 * i, count - i);
+}
+
+void DeinterleaveUV_AVX2(const mfxU8* uv, mfxU8* u, mfxU8* v, mfxU32 count) {
+    const __m256i mask = _mm256_set1_epi16(0x00ff);
+    mfxU32 i           = 0;
+    for (; i + 32 <= count; i += 32) {
+        __m256i a  = _mm256_loadu_si256((const __m256i*)(uv + 2 * i));
+        __m256i b  = _mm256_loadu_si256((const __m256i*)(uv + 2 * i + 32));
+        __m256i pu = _mm256_packus_epi16(_mm256_and_si256(a, mask), _mm256_and_si256(b, mask));
+        __m256i pv = _mm256_packus_epi16(_mm256_srli_epi16(a, 8), _mm256_srli_epi16(b, 8));
+        // pack works inside 128-bit lanes: a0 b0 a1 b1 -> a0 a1 b0 b1
+        _mm256_storeu_si256((__m256i*)(u + i), _mm256_permute4x64_epi64(pu, 0xd8));
+        _mm256_storeu_si256((__m256i*)(v + i), _mm256_permute4x64_epi64(pv, 0xd8));
+    }
+    GetKernelsSSE42()->DeinterleaveUV(uv + 2 * i, u + i, v + i, count - i);
+}
+
+void ShiftLeft16_AVX2(const mfxU16* src, mfxU16* dst, mfxU32 count, mfxU32 shift) {
+    const __m128i s = _mm_cvtsi32_si128((int)shift);
+    mfxU32 i        = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(src + i));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_sll_epi16(x, s));
+    }
+    GetKernelsSSE42()->ShiftLeft16(src + i, dst + i, count - i, shift);
+}
+
+void ShiftRight16_AVX2(const mfxU16* src, mfxU16* dst, mfxU32 count, mfxU32 shift) {
+    const __m128i s = _mm_cvtsi32_si128((int)shift);
+    mfxU32 i        = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(src + i));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_srl_epi16(x, s));
+    }
+    GetKernelsSSE42()->ShiftRight16(src + i, dst + i, count - i, shift);
+}
+
+void PackY210_AVX2(const mfxU16* y,
+                   const mfxU16* u,
+                   const mfxU16* v,
+                   mfxU16* dst,
+                   mfxU32 count,
+                   mfxU32 shift) {
+    const __m128i s = _mm_cvtsi32_si128((int)shift);
+    mfxU32 i        = 0;
+    // 16 pixel pairs per iteration
+    for (; i + 16 <= count; i += 16) {
+        __m256i vu   = _mm256_loadu_si256((const __m256i*)(u + i));
+        __m256i vv   = _mm256_loadu_si256((const __m256i*)(v + i));
+        __m256i y0   = _mm256_loadu_si256((const __m256i*)(y + 2 * i));
+        __m256i y1   = _mm256_loadu_si256((const __m256i*)(y + 2 * i + 16));
+        __m256i uvLo = _mm256_unpacklo_epi16(vu, vv);
+        __m256i uvHi = _mm256_unpackhi_epi16(vu, vv);
+        // chroma of pairs 0-7 and 8-15
+        __m256i uvA = _mm256_permute2x128_si256(uvLo, uvHi, 0x20);
+        __m256i uvB = _mm256_permute2x128_si256(uvLo, uvHi, 0x31);
+
+        __m256i p0 = _mm256_sll_epi16(_mm256_unpacklo_epi16(y0, uvA), s);
+        __m256i p1 = _mm256_sll_epi16(_mm256_unpackhi_epi16(y0, uvA), s);
+        __m256i p2 = _mm256_sll_epi16(_mm256_unpacklo_epi16(y1, uvB), s);
+        __m256i p3 = _mm256_sll_epi16(_mm256_unpackhi_epi16(y1, uvB), s);
+
+        mfxU16* out = dst + 4 * i;
+        _mm256_storeu_si256((__m256i*)(out), _mm256_permute2x128_si256(p0, p1, 0x20));
+        _mm256_storeu_si256((__m256i*)(out + 16), _mm256_permute2x128_si256(p0, p1, 0x31));
+        _mm256_storeu_si256((__m256i*)(out + 32), _mm256_permute2x128_si256(p2, p3, 0x20));
+        _mm256_storeu_si256((__m256i*)(out + 48), _mm256_permute2x128_si256(p2, p3, 0x31));
+    }
+    GetKernelsSSE42()->PackY210(y + 2 * i, u + i, v + i, dst + 4 * i, count - i, shift);
+}
+
+void PackY410_AVX2(const mfxU16* y, const mfxU16* u, const mfxU16* v, mfxU32* dst, mfxU32 count) {
+    const __m256i mask  = _mm256_set1_epi32(0x3ff);
+    const __m256i alpha = _mm256_set1_epi32((int)(3u << 30));
+    mfxU32 i            = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i vy =
+            _mm256_and_si256(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(y + i))), mask);
+        __m256i vu =
+            _mm256_and_si256(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(u + i))), mask);
+        __m256i vv =
+            _mm256_and_si256(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(v + i))), mask);
+        __m256i x = _mm256_or_si256(_mm256_or_si256(vu, _mm256_slli_epi32(vy, 10)),
+                                    _mm256_or_si256(_mm256_slli_epi32(vv, 20), alpha));
+        _mm256_storeu_si256((__m256i*)(dst + i), x);
+    }
+    GetKernelsSSE42()->PackY410(y + i, u + i, v + i, dst + i, count - i);
+}
+
+void SwapRB32_AVX2(const mfxU8* src, mfxU8* dst, mfxU32 count) {
+    const __m256i shuffle = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+                                             2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    mfxU32 i              = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(src + 4 * i));
+        _mm256_storeu_si256((__m256i*)(dst + 4 * i), _mm256_shuffle_epi8(x, shuffle));
+    }
+    GetKernelsSSE42()->SwapRB32(src + 4 * i, dst + 4 * i, count - i);
+}
+
+mfxU32 FindZeroZeroByte_AVX2(const mfxU8* data, mfxU32 size, mfxU8 value) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i last = _mm256_set1_epi8((char)value);
+    mfxU32 i           = 0;
+    for (; i + 34 <= size; i += 32) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(data + i));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(data + i + 1));
+        __m256i c = _mm256_loadu_si256((const __m256i*)(data + i + 2));
+        __m256i m =
+            _mm256_and_si256(_mm256_and_si256(_mm256_cmpeq_epi8(a, zero), _mm256_cmpeq_epi8(b, zero)),
+                             _mm256_cmpeq_epi8(c, last));
+        mfxU32 mask = (mfxU32)_mm256_movemask_epi8(m);
+        if (mask)
+            return i + LowestSetBit(mask);
+    }
+    return i + GetKernelsSSE42()->FindZeroZeroByte(data + i, size - i, value);
+}
+
+const KernelTable g_avx2Kernels = {
+    InterleaveUV_AVX2, DeinterleaveUV_AVX2, ShiftLeft16_AVX2,       ShiftRight16_AVX2,
+    PackY210_AVX2,     PackY410_AVX2,       SwapRB32_AVX2,          FindZeroZeroByte_AVX2,
+};
+
+} // namespace
+
+const KernelTable* GetKernelsAVX2() {
+    return &g_avx2Kernels;
+}
+
+} // namespace FrameKernels
+
+#else
+
+const FrameKernels::KernelTable* FrameKernels::GetKernelsAVX2() {
+    return NULL;
+}
+
+#endif // #if defined(SAMPLE_FRAME_KERNELS_X86)
@@ -0,0 +1,179 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include "frame_kernels.h"
+
+#if defined(SAMPLE_FRAME_KERNELS_X86)
+
+    #include <immintrin.h>
+
+    #if defined(__GNUC__) && !defined(__clang__)
+        // GCC reports the _mm512_undefined_* values used inside intrinsics as uninitialized
+        #pragma GCC diagnostic ignored "-Wuninitialized"
+        #pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+    #endif
+
+namespace FrameKernels {
+
+namespace {
+
+void InterleaveUV_AVX512(const mfxU8* u, const mfxU8* v, mfxU8* uv, mfxU32 count) {
+    // unpack works inside 128-bit lanes, lanes of both halves are merged back in order
+    const __m512i idxLo = _mm512_setr_epi64(0, 1, 8, 9, 2, 3, 10, 11);
+    const __m512i idxHi = _mm512_setr_epi64(4, 5, 12, 13, 6, 7, 14, 15);
+    mfxU32 i            = 0;
+    for (; i + 64 <= count; i += 64) {
+        __m512i vu = _mm512_loadu_si512((const void*)(u + i));
+        __m512i vv = _mm512_loadu_si512((const void*)(v + i));
+        __m512i lo = _mm512_unpacklo_epi8(vu, vv);
+        __m512i hi = _mm512_unpackhi_epi8(vu, vv);
+        _mm512_storeu_si512((void*)(uv + 2 * i), _mm512_permutex2var_epi64(lo, idxLo, hi));
+        _mm512_storeu_si512((void*)(uv + 2 * i + 64), _mm512_permutex2var_epi64(lo, idxHi, hi));
+    }
+    GetKernelsAVX2()->InterleaveUV(u + i, v + i, uv + 2 * i, count - i);
+}
+
+void DeinterleaveUV_AVX512(const mfxU8* uv, mfxU8* u, mfxU8* v, mfxU32 count) {
+    const __m512i mask = _mm512_set1_epi16(0x00ff);
+    // pack works inside 128-bit lanes: a0 b0 a1 b1 a2 b2 a3 b3 -> a0 a1 a2 a3 b0 b1 b2 b3
+    const __m512i idx = _mm512_setr_epi64(0, 2, 4, 6, 1, 3, 5, 7);
+    mfxU32 i          = 0;
+    for (; i + 64 <= count; i += 64) {
+        __m512i a  = _mm512_loadu_si512((const void*)(uv + 2 * i));
+        __m512i b  = _mm512_loadu_si512((const void*)(uv + 2 * i + 64));
+        __m512i pu = _mm512_packus_epi16(_mm512_and_si512(a, mask), _mm512_and_si512(b, mask));
+        __m512i pv = _mm512_packus_epi16(_mm512_srli_epi16(a, 8), _mm512_srli_epi16(b, 8));
+        _mm512_storeu_si512((void*)(u + i), _mm512_permutexvar_epi64(idx, pu));
+        _mm512_storeu_si512((void*)(v + i), _mm512_permutexvar_epi64(idx, pv));
+    }
+    GetKernelsAVX2()->DeinterleaveUV(uv + 2 * i, u + i, v + i, count - i);
+}
+
+void ShiftLeft16_AVX512(const mfxU16* src, mfxU16* dst, mfxU32 count, mfxU32 shift) {
+    const __m128i s = _mm_cvtsi32_si128((int)shift);
+    mfxU32 i        = 0;
+    for (; i + 32 <= count; i += 32) {
+        __m512i x = _mm512_loadu_si512((const void*)(src + i));
+        _mm512_storeu_si512((void*)(dst + i), _mm512_sll_epi16(x, s));
+    }
+    GetKernelsAVX2()->ShiftLeft16(src + i, dst + i, count - i, shift);
+}
+
+void ShiftRight16_AVX512(const mfxU16* src, mfxU16* dst, mfxU32 count, mfxU32 shift) {
+    const __m128i s = _mm_cvtsi32_si128((int)shift);
+    mfxU32 i        = 0;
+    for (; i + 32 <= count; i += 32) {
+        __m512i x = _mm512_loadu_si512((const void*)(src + i));
+        _mm512_storeu_si512((void*)(dst + i), _mm512_srl_epi16(x, s));
+    }
+    GetKernelsAVX2()->ShiftRight16(src + i, dst + i, count - i, shift);
+}
+
+void PackY210_AVX512(const mfxU16* y,
+                     const mfxU16* u,
+                     const mfxU16* v,
+                     mfxU16* dst,
+                     mfxU32 count,
+                     mfxU32 shift) {
+    // Word indices into {y[0..31], u[0..15], v[0..15]} for pixel pairs 0-7 and 8-15
+    mfxU16 order[2][32];
+    for (mfxU16 half = 0; half < 2; half++) {
+        for (mfxU16 n = 0; n < 8; n++) {
+            mfxU16 pair            = half * 8 + n;
+            order[half][4 * n]     = 2 * pair;
+            order[half][4 * n + 1] = 32 + pair;
+            order[half][4 * n + 2] = 2 * pair + 1;
+            order[half][4 * n + 3] = 48 + pair;
+        }
+    }
+    const __m512i idx0 = _mm512_loadu_si512((const void*)order[0]);
+    const __m512i idx1 = _mm512_loadu_si512((const void*)order[1]);
+    const __m128i s    = _mm_cvtsi32_si128((int)shift);
+
+    mfxU32 i = 0;
+    // 16 pixel pairs per iteration
+    for (; i + 16 <= count; i += 16) {
+        __m512i vy  = _mm512_loadu_si512((const void*)(y + 2 * i));
+        __m256i vu  = _mm256_loadu_si256((const __m256i*)(u + i));
+        __m256i vv  = _mm256_loadu_si256((const __m256i*)(v + i));
+        __m512i uv  = _mm512_inserti64x4(_mm512_castsi256_si512(vu), vv, 1);
+        mfxU16* out = dst + 4 * i;
+        _mm512_storeu_si512((void*)(out),
+                            _mm512_sll_epi16(_mm512_permutex2var_epi16(vy, idx0, uv), s));
+        _mm512_storeu_si512((void*)(out + 32),
+                            _mm512_sll_epi16(_mm512_permutex2var_epi16(vy, idx1, uv), s));
+    }
+    GetKernelsAVX2()->PackY210(y + 2 * i, u + i, v + i, dst + 4 * i, count - i, shift);
+}
+
+void PackY410_AVX512(const mfxU16* y, const mfxU16* u, const mfxU16* v, mfxU32* dst, mfxU32 count) {
+    const __m512i mask  = _mm512_set1_epi32(0x3ff);
+    const __m512i alpha = _mm512_set1_epi32((int)(3u << 30));
+    mfxU32 i            = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m512i vy = _mm512_and_si512(
+            _mm512_cvtepu16_epi32(_mm256_loadu_si256((const __m256i*)(y + i))),
+            mask);
+        __m512i vu = _mm512_and_si512(
+            _mm512_cvtepu16_epi32(_mm256_loadu_si256((const __m256i*)(u + i))),
+            mask);
+        __m512i vv = _mm512_and_si512(
+            _mm512_cvtepu16_epi32(_mm256_loadu_si256((const __m256i*)(v + i))),
+            mask);
+        __m512i x = _mm512_or_si512(_mm512_or_si512(vu, _mm512_slli_epi32(vy, 10)),
+                                    _mm512_or_si512(_mm512_slli_epi32(vv, 20), alpha));
+        _mm512_storeu_si512((void*)(dst + i), x);
+    }
+    GetKernelsAVX2()->PackY410(y + i, u + i, v + i, dst + i, count - i);
+}
+
+void SwapRB32_AVX512(const mfxU8* src, mfxU8* dst, mfxU32 count) {
+    const __m512i shuffle = _mm512_broadcast_i32x4(
+        _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15));
+    mfxU32 i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m512i x = _mm512_loadu_si512((const void*)(src + 4 * i));
+        _mm512_storeu_si512((void*)(dst + 4 * i), _mm512_shuffle_epi8(x, shuffle));
+    }
+    GetKernelsAVX2()->SwapRB32(src + 4 * i, dst + 4 * i, count - i);
+}
+
+mfxU32 FindZeroZeroByte_AVX512(const mfxU8* data, mfxU32 size, mfxU8 value) {
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i last = _mm512_set1_epi8((char)value);
+    mfxU32 i           = 0;
+    for (; i + 66 <= size; i += 64) {
+        __m512i a   = _mm512_loadu_si512((const void*)(data + i));
+        __m512i b   = _mm512_loadu_si512((const void*)(data + i + 1));
+        __m512i c   = _mm512_loadu_si512((const void*)(data + i + 2));
+        __mmask64 m = _mm512_cmpeq_epi8_mask(a, zero) & _mm512_cmpeq_epi8_mask(b, zero) &
+                      _mm512_cmpeq_epi8_mask(c, last);
+        if (m)
+            return i + LowestSetBit(m);
+    }
+    return i + GetKernelsAVX2()->FindZeroZeroByte(data + i, size - i, value);
+}
+
+const KernelTable g_avx512Kernels = {
+    InterleaveUV_AVX512, DeinterleaveUV_AVX512, ShiftLeft16_AVX512,       ShiftRight16_AVX512,
+    PackY210_AVX512,     PackY410_AVX512,       SwapRB32_AVX512,          FindZeroZeroByte_AVX512,
+};
+
+} // namespace
+
+const KernelTable* GetKernelsAVX512() {
+    return &g_avx512Kernels;
+}
+
+} // namespace FrameKernels
+
+#else
+
+const FrameKernels::KernelTable* FrameKernels::GetKernelsAVX512() {
+    return NULL;
+}
+
+#endif // #if defined(SAMPLE_FRAME_KERNELS_X86)
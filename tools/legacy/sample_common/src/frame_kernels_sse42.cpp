@@ -0,0 +1,152 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include "frame_kernels.h"
+
+#if defined(SAMPLE_FRAME_KERNELS_X86)
+
+    #include <nmmintrin.h>
+
+namespace FrameKernels {
+
+namespace {
+
+void InterleaveUV_SSE42(const mfxU8* u, const mfxU8* v, mfxU8* uv, mfxU32 count) {
+    mfxU32 i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i vu = _mm_loadu_si128((const __m128i*)(u + i));
+        __m128i vv = _mm_loadu_si128((const __m128i*)(v + i));
+        _mm_storeu_si128((__m128i*)(uv + 2 * i), _mm_unpacklo_epi8(vu, vv));
+        _mm_storeu_si128((__m128i*)(uv + 2 * i + 16), _mm_unpackhi_epi8(vu, vv));
+    }
+    GetKernels(ISA_SCALAR)->InterleaveUV(u + i, v + i, uv + 2 * i, count - i);
+}
+
+void DeinterleaveUV_SSE42(const mfxU8* uv, mfxU8* u, mfxU8* v, mfxU32 count) {
+    const __m128i mask = _mm_set1_epi16(0x00ff);
+    mfxU32 i           = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(uv + 2 * i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(uv + 2 * i + 16));
+        _mm_storeu_si128((__m128i*)(u + i),
+                         _mm_packus_epi16(_mm_and_si128(a, mask), _mm_and_si128(b, mask)));
+        _mm_storeu_si128((__m128i*)(v + i),
+                         _mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8)));
+    }
+    GetKernels(ISA_SCALAR)->DeinterleaveUV(uv + 2 * i, u + i, v + i, count - i);
+}
+
+void ShiftLeft16_SSE42(const mfxU16* src, mfxU16* dst, mfxU32 count, mfxU32 shift) {
+    const __m128i s = _mm_cvtsi32_si128((int)shift);
+    mfxU32 i        = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(src + i));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_sll_epi16(x, s));
+    }
+    GetKernels(ISA_SCALAR)->ShiftLeft16(src + i, dst + i, count - i, shift);
+}
+
+void ShiftRight16_SSE42(const mfxU16* src, mfxU16* dst, mfxU32 count, mfxU32 shift) {
+    const __m128i s = _mm_cvtsi32_si128((int)shift);
+    mfxU32 i        = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(src + i));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_srl_epi16(x, s));
+    }
+    GetKernels(ISA_SCALAR)->ShiftRight16(src + i, dst + i, count - i, shift);
+}
+
+void PackY210_SSE42(const mfxU16* y,
+                    const mfxU16* u,
+                    const mfxU16* v,
+                    mfxU16* dst,
+                    mfxU32 count,
+                    mfxU32 shift) {
+    const __m128i s = _mm_cvtsi32_si128((int)shift);
+    mfxU32 i        = 0;
+    // 8 pixel pairs per iteration
+    for (; i + 8 <= count; i += 8) {
+        __m128i vu   = _mm_loadu_si128((const __m128i*)(u + i));
+        __m128i vv   = _mm_loadu_si128((const __m128i*)(v + i));
+        __m128i y0   = _mm_loadu_si128((const __m128i*)(y + 2 * i));
+        __m128i y1   = _mm_loadu_si128((const __m128i*)(y + 2 * i + 8));
+        __m128i uvLo = _mm_unpacklo_epi16(vu, vv);
+        __m128i uvHi = _mm_unpackhi_epi16(vu, vv);
+        mfxU16* out  = dst + 4 * i;
+        _mm_storeu_si128((__m128i*)(out), _mm_sll_epi16(_mm_unpacklo_epi16(y0, uvLo), s));
+        _mm_storeu_si128((__m128i*)(out + 8), _mm_sll_epi16(_mm_unpackhi_epi16(y0, uvLo), s));
+        _mm_storeu_si128((__m128i*)(out + 16), _mm_sll_epi16(_mm_unpacklo_epi16(y1, uvHi), s));
+        _mm_storeu_si128((__m128i*)(out + 24), _mm_sll_epi16(_mm_unpackhi_epi16(y1, uvHi), s));
+    }
+    GetKernels(ISA_SCALAR)->PackY210(y + 2 * i, u + i, v + i, dst + 4 * i, count - i, shift);
+}
+
+void PackY410_SSE42(const mfxU16* y, const mfxU16* u, const mfxU16* v, mfxU32* dst, mfxU32 count) {
+    const __m128i mask  = _mm_set1_epi32(0x3ff);
+    const __m128i alpha = _mm_set1_epi32((int)(3u << 30));
+    mfxU32 i            = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i vy = _mm_and_si128(_mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i*)(y + i))),
+                                   mask);
+        __m128i vu = _mm_and_si128(_mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i*)(u + i))),
+                                   mask);
+        __m128i vv = _mm_and_si128(_mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i*)(v + i))),
+                                   mask);
+        __m128i x  = _mm_or_si128(_mm_or_si128(vu, _mm_slli_epi32(vy, 10)),
+                                 _mm_or_si128(_mm_slli_epi32(vv, 20), alpha));
+        _mm_storeu_si128((__m128i*)(dst + i), x);
+    }
+    GetKernels(ISA_SCALAR)->PackY410(y + i, u + i, v + i, dst + i, count - i);
+}
+
+void SwapRB32_SSE42(const mfxU8* src, mfxU8* dst, mfxU32 count) {
+    const __m128i shuffle = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    mfxU32 i              = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(src + 4 * i));
+        _mm_storeu_si128((__m128i*)(dst + 4 * i), _mm_shuffle_epi8(x, shuffle));
+    }
+    GetKernels(ISA_SCALAR)->SwapRB32(src + 4 * i, dst + 4 * i, count - i);
+}
+
+// SSE2 compares, the pattern starting at byte i ends at byte i + 2
+mfxU32 FindZeroZeroByte_SSE42(const mfxU8* data, mfxU32 size, mfxU8 value) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i last = _mm_set1_epi8((char)value);
+    mfxU32 i           = 0;
+    for (; i + 18 <= size; i += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(data + i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(data + i + 1));
+        __m128i c = _mm_loadu_si128((const __m128i*)(data + i + 2));
+        __m128i m = _mm_and_si128(_mm_and_si128(_mm_cmpeq_epi8(a, zero), _mm_cmpeq_epi8(b, zero)),
+                                  _mm_cmpeq_epi8(c, last));
+        mfxU32 mask = (mfxU32)_mm_movemask_epi8(m);
+        if (mask)
+            return i + LowestSetBit(mask);
+    }
+    return i + GetKernels(ISA_SCALAR)->FindZeroZeroByte(data + i, size - i, value);
+}
+
+const KernelTable g_sse42Kernels = {
+    InterleaveUV_SSE42, DeinterleaveUV_SSE42, ShiftLeft16_SSE42,       ShiftRight16_SSE42,
+    PackY210_SSE42,     PackY410_SSE42,       SwapRB32_SSE42,          FindZeroZeroByte_SSE42,
+};
+
+} // namespace
+
+const KernelTable* GetKernelsSSE42() {
+    return &g_sse42Kernels;
+}
+
+} // namespace FrameKernels
+
+#else
+
+const FrameKernels::KernelTable* FrameKernels::GetKernelsSSE42() {
+    return NULL;
+}
+
+#endif // #if defined(SAMPLE_FRAME_KERNELS_X86)
@@ -0,0 +1,377 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include "frame_prefetcher.h"
+
+#include "sample_defs.h"
+
+namespace {
+
+typedef std::chrono::steady_clock PrefetchClock;
+
+mfxF64 SecondsSince(PrefetchClock::time_point start) {
+    return std::chrono::duration<mfxF64>(PrefetchClock::now() - start).count();
+}
+
+// Fills planes of the whole Width x Height frame, returns the number of planes or 0 if the
+// format isn't supported
+mfxU32 GetFramePlanes(const mfxFrameInfo& info, const mfxFrameData& data, FramePlane* planes) {
+    const mfxU32 w     = info.Width;
+    const mfxU32 h     = info.Height;
+    const mfxU32 pitch = data.PitchLow + ((mfxU32)data.PitchHigh << 16);
+
+    // packed formats start from the lowest of the component pointers
+    mfxU8* packed = data.Y;
+    for (mfxU8* p : { data.U, data.V }) {
+        if (p && (!packed || p < packed))
+            packed = p;
+    }
+
+    switch (info.FourCC) {
+        case MFX_FOURCC_NV12:
+        case MFX_FOURCC_NV16:
+            planes[0] = { data.Y, w, h, pitch };
+            planes[1] = { data.UV, w, info.FourCC == MFX_FOURCC_NV12 ? h / 2 : h, pitch };
+            return 2;
+        case MFX_FOURCC_P010:
+#if (MFX_VERSION >= MFX_VERSION_NEXT)
+        case MFX_FOURCC_P016:
+#endif
+        case MFX_FOURCC_P210:
+            planes[0] = { data.Y, 2 * w, h, pitch };
+            planes[1] = { data.UV, 2 * w, info.FourCC == MFX_FOURCC_P210 ? h : h / 2, pitch };
+            return 2;
+        case MFX_FOURCC_YV12:
+        case MFX_FOURCC_I420:
+        case MFX_FOURCC_I422:
+            planes[0] = { data.Y, w, h, pitch };
+            planes[1] = { data.U, w / 2, info.FourCC == MFX_FOURCC_I422 ? h : h / 2, pitch / 2 };
+            planes[2] = { data.V, w / 2, planes[1].Rows, pitch / 2 };
+            return 3;
+        case MFX_FOURCC_I010:
+        case MFX_FOURCC_I210:
+            planes[0] = { data.Y, 2 * w, h, pitch };
+            planes[1] = { data.U, w, info.FourCC == MFX_FOURCC_I210 ? h : h / 2, pitch / 2 };
+            planes[2] = { data.V, w, planes[1].Rows, pitch / 2 };
+            return 3;
+        case MFX_FOURCC_YUY2:
+        case MFX_FOURCC_UYVY:
+            planes[0] = { packed, 2 * w, h, pitch };
+            return 1;
+        case MFX_FOURCC_RGB4:
+        case MFX_FOURCC_BGR4:
+        case MFX_FOURCC_A2RGB10:
+        case MFX_FOURCC_AYUV:
+        case MFX_FOURCC_Y210:
+#if (MFX_VERSION >= MFX_VERSION_NEXT)
+        case MFX_FOURCC_Y216:
+#endif
+        case MFX_FOURCC_Y410:
+            planes[0] = { packed, 4 * w, h, pitch };
+            return 1;
+#if (MFX_VERSION >= MFX_VERSION_NEXT)
+        case MFX_FOURCC_Y416:
+            planes[0] = { packed, 8 * w, h, pitch };
+            return 1;
+#endif
+        default:
+            return 0;
+    }
+}
+
+mfxStatus CopyFrameData(const mfxFrameSurface1& src, mfxFrameSurface1& dst) {
+    FramePlane srcPlanes[3], dstPlanes[3];
+    mfxU32 count = GetFramePlanes(src.Info, src.Data, srcPlanes);
+    if (!count || count != GetFramePlanes(dst.Info, dst.Data, dstPlanes))
+        return MFX_ERR_UNSUPPORTED;
+
+    for (mfxU32 i = 0; i < count; i++) {
+        const FramePlane& s = srcPlanes[i];
+        const FramePlane& d = dstPlanes[i];
+        MSDK_CHECK_POINTER(s.Data, MFX_ERR_NOT_INITIALIZED);
+        MSDK_CHECK_POINTER(d.Data, MFX_ERR_NOT_INITIALIZED);
+
+        if (s.Pitch == d.Pitch && s.Pitch == s.RowSize) {
+            MSDK_MEMCPY(d.Data, s.Data, (size_t)s.RowSize * s.Rows);
+            continue;
+        }
+        for (mfxU32 row = 0; row < s.Rows; row++)
+            MSDK_MEMCPY(d.Data + (size_t)row * d.Pitch, s.Data + (size_t)row * s.Pitch, s.RowSize);
+    }
+    return MFX_ERR_NONE;
+}
+
+} // namespace
+
+CFramePrefetcher::CFramePrefetcher()
+        : m_allocator(),
+          m_response(),
+          m_ring(),
+          m_load(),
+          m_thread(),
+          m_mutex(),
+          m_cvFilled(),
+          m_cvFreed(),
+          m_head(0),
+          m_filled(0),
+          m_bAcquired(false),
+          m_bStop(false),
+          m_stat() {}
+
+CFramePrefetcher::~CFramePrefetcher() {
+    Stop();
+    FreeFrames();
+    m_allocator.Close();
+}
+
+mfxStatus CFramePrefetcher::Start(const mfxFrameInfo& info, mfxU32 depth, LoadFunc load) {
+    if (IsStarted())
+        return MFX_ERR_UNDEFINED_BEHAVIOR;
+    if (!depth || !load)
+        return MFX_ERR_INVALID_VIDEO_PARAM;
+
+    FramePlane planes[3];
+    mfxFrameData probe = {};
+    if (!GetFramePlanes(info, probe, planes))
+        return MFX_ERR_UNSUPPORTED;
+
+    // frames are reused between restarts while the format stays the same
+    bool realloc = m_ring.size() != depth || m_ring.empty() ||
+                   m_ring[0].surface.Info.FourCC != info.FourCC ||
+                   m_ring[0].surface.Info.Width != info.Width ||
+                   m_ring[0].surface.Info.Height != info.Height;
+    if (realloc) {
+        FreeFrames();
+
+        mfxStatus sts = m_allocator.Init(NULL);
+        MSDK_CHECK_STATUS(sts, "m_allocator.Init failed");
+
+        mfxFrameAllocRequest request = {};
+        request.Info                 = info;
+        // system memory allocator has the same layout for both byte orders
+        if (request.Info.FourCC == MFX_FOURCC_BGR4)
+            request.Info.FourCC = MFX_FOURCC_RGB4;
+        request.NumFrameMin = request.NumFrameSuggested = (mfxU16)depth;
+        request.Type = MFX_MEMTYPE_SYSTEM_MEMORY | MFX_MEMTYPE_EXTERNAL_FRAME |
+                       MFX_MEMTYPE_FROM_VPPIN;
+
+        sts = m_allocator.AllocFrames(&request, &m_response);
+        MSDK_CHECK_STATUS(sts, "m_allocator.AllocFrames failed");
+
+        m_ring.resize(depth);
+        for (mfxU32 i = 0; i < depth; i++) {
+            Slot& slot                = m_ring[i];
+            slot.surface              = mfxFrameSurface1();
+            slot.surface.Info         = info;
+            slot.surface.Data.MemId   = m_response.mids[i];
+            slot.status               = MFX_ERR_NONE;
+            // ring frames stay locked while they are allocated
+            sts = m_allocator.LockFrame(slot.surface.Data.MemId, &slot.surface.Data);
+            if (MFX_ERR_NONE != sts) {
+                m_ring.resize(i);
+                FreeFrames();
+                MSDK_CHECK_STATUS(sts, "m_allocator.LockFrame failed");
+            }
+        }
+    }
+
+    for (Slot& slot : m_ring)
+        slot.status = MFX_ERR_NONE;
+    m_load      = load;
+    m_head      = 0;
+    m_filled    = 0;
+    m_bAcquired = false;
+    m_bStop     = false;
+    m_thread    = std::thread(&CFramePrefetcher::ThreadRoutine, this);
+    return MFX_ERR_NONE;
+}
+
+void CFramePrefetcher::Stop() {
+    if (!IsStarted())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_bStop = true;
+    }
+    m_cvFreed.notify_all();
+    m_thread.join();
+
+    m_head      = 0;
+    m_filled    = 0;
+    m_bAcquired = false;
+}
+
+void CFramePrefetcher::FreeFrames() {
+    for (Slot& slot : m_ring)
+        m_allocator.UnlockFrame(slot.surface.Data.MemId, &slot.surface.Data);
+    m_ring.clear();
+
+    if (m_response.mids) {
+        m_allocator.FreeFrames(&m_response);
+        m_response = mfxFrameAllocResponse();
+    }
+}
+
+void CFramePrefetcher::ThreadRoutine() {
+    const mfxU32 depth = (mfxU32)m_ring.size();
+
+    for (;;) {
+        Slot* slot = NULL;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (m_filled == depth && !m_bStop)
+                m_stat.ringFullWaits++;
+            m_cvFreed.wait(lock, [&]() {
+                return m_bStop || m_filled < depth;
+            });
+            if (m_bStop)
+                return;
+            // the slot after the filled ones isn't visible to the pipeline until published
+            slot = &m_ring[(m_head + m_filled) % depth];
+        }
+
+        PrefetchClock::time_point start = PrefetchClock::now();
+        mfxStatus sts                   = m_load(&slot->surface);
+        mfxF64 readTime                 = SecondsSince(start);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            slot->status = sts;
+            m_filled++;
+            m_stat.readTime += readTime;
+        }
+        m_cvFilled.notify_one();
+
+        // end of stream or error, it is reported once the pipeline reaches this slot
+        if (MFX_ERR_NONE != sts)
+            return;
+    }
+}
+
+mfxStatus CFramePrefetcher::AcquireFrame(mfxFrameSurface1** ppSurface) {
+    MSDK_CHECK_POINTER(ppSurface, MFX_ERR_NULL_PTR);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (!IsStarted())
+        return MFX_ERR_NOT_INITIALIZED;
+    if (m_bAcquired)
+        return MFX_ERR_UNDEFINED_BEHAVIOR;
+
+    if (!m_filled) {
+        m_stat.inputWaits++;
+        PrefetchClock::time_point start = PrefetchClock::now();
+        m_cvFilled.wait(lock, [&]() {
+            return m_filled > 0;
+        });
+        m_stat.inputWaitTime += SecondsSince(start);
+    }
+
+    Slot& slot = m_ring[m_head];
+    // the final status isn't consumed so that it is returned for the next requests too
+    if (MFX_ERR_NONE != slot.status)
+        return slot.status;
+
+    m_bAcquired = true;
+    *ppSurface  = &slot.surface;
+    return MFX_ERR_NONE;
+}
+
+void CFramePrefetcher::ReleaseFrame() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_bAcquired)
+            return;
+        m_bAcquired = false;
+        m_head      = (m_head + 1) % (mfxU32)m_ring.size();
+        m_filled--;
+        m_stat.frames++;
+    }
+    m_cvFreed.notify_one();
+}
+
+mfxStatus CFramePrefetcher::LoadNextFrame(mfxFrameSurface1* pSurface) {
+    MSDK_CHECK_POINTER(pSurface, MFX_ERR_NULL_PTR);
+    if (!IsStarted())
+        return MFX_ERR_NOT_INITIALIZED;
+
+    const mfxFrameInfo& info = m_ring[0].surface.Info;
+    if (pSurface->Info.FourCC != info.FourCC || pSurface->Info.Width != info.Width ||
+        pSurface->Info.Height != info.Height)
+        return MFX_ERR_INVALID_VIDEO_PARAM;
+
+    mfxFrameSurface1* pFrame = NULL;
+    mfxStatus sts            = AcquireFrame(&pFrame);
+    if (MFX_ERR_NONE != sts)
+        return sts;
+
+    sts = CopyFrameData(*pFrame, *pSurface);
+    ReleaseFrame();
+    return sts;
+}
+
+CFramePrefetcher::Statistics CFramePrefetcher::GetStatistics() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stat;
+}
+
+void CFramePrefetcher::PrintStatistics(const msdk_char* prefix) const {
+    Statistics stat = GetStatistics();
+    msdk_printf(
+        MSDK_STRING(
+            "%s Frames:%llu,Input waits:%llu(%.3lfms),Ring full waits:%llu,Read time:%.3lfms\n"),
+        prefix,
+        (unsigned long long int)stat.frames,
+        (unsigned long long int)stat.inputWaits,
+        (double)stat.inputWaitTime * 1000,
+        (unsigned long long int)stat.ringFullWaits,
+        (double)stat.readTime * 1000);
+}
+
+CPrefetchYUVReader::CPrefetchYUVReader() : CSmplYUVReader(), m_prefetcher(), m_depth(0) {}
+
+CPrefetchYUVReader::~CPrefetchYUVReader() {
+    m_prefetcher.Stop();
+}
+
+void CPrefetchYUVReader::Close() {
+    m_prefetcher.Stop();
+    CSmplYUVReader::Close();
+}
+
+mfxStatus CPrefetchYUVReader::SkipNframesFromBeginning(mfxU16 w,
+                                                       mfxU16 h,
+                                                       mfxU32 viewId,
+                                                       mfxU32 nframes) {
+    // the file position is changed, frames read ahead are not valid anymore
+    m_prefetcher.Stop();
+    return CSmplYUVReader::SkipNframesFromBeginning(w, h, viewId, nframes);
+}
+
+mfxStatus CPrefetchYUVReader::LoadNextFrame(mfxFrameSurface1* pSurface) {
+    if (!m_depth || m_files.size() != 1)
+        return CSmplYUVReader::LoadNextFrame(pSurface);
+
+    MSDK_CHECK_POINTER(pSurface, MFX_ERR_NULL_PTR);
+
+    if (!m_prefetcher.IsStarted()) {
+        mfxStatus sts = m_prefetcher.Start(pSurface->Info, m_depth, [this](mfxFrameSurface1* s) {
+            return CSmplYUVReader::LoadNextFrame(s);
+        });
+        if (MFX_ERR_NONE != sts) {
+            msdk_printf(MSDK_STRING("WARNING: input prefetch isn't available, reading frames "
+                                    "synchronously\n"));
+            m_depth = 0;
+            return CSmplYUVReader::LoadNextFrame(pSurface);
+        }
+    }
+
+    return m_prefetcher.LoadNextFrame(pSurface);
+}
+
+void CPrefetchYUVReader::Reset() {
+    m_prefetcher.Stop();
+    CSmplYUVReader::Reset();
+}
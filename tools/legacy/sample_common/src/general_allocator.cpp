@@ -50,8 +50,11 @@ mfxStatus GeneralAllocator::Init(mfxAllocatorParams* pParams) {
         MSDK_CHECK_STATUS(sts, "m_D3DAllocator.get failed");
     }
 
+    // system memory frames are allocated as configured by the application
+    SysMemAllocatorParams* sysMemAllocParams = dynamic_cast<SysMemAllocatorParams*>(pParams);
+
     m_SYSAllocator.reset(new SysMemFrameAllocator());
-    sts = m_SYSAllocator->Init(0);
+    sts = m_SYSAllocator->Init(sysMemAllocParams);
     MSDK_CHECK_STATUS(sts, "m_SYSAllocator.get failed");
 
     return sts;
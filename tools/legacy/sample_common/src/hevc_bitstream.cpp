@@ -0,0 +1,209 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include "hevc_bitstream.h"
+
+namespace ProtectedLibrary {
+
+// Ceil(Log2(value))
+static mfxU32 CeilLog2(mfxU32 value) {
+    mfxU32 bits = 0;
+    while ((1u << bits) < value && bits < 32)
+        bits++;
+    return bits;
+}
+
+HEVCHeadersBitstream::HEVCHeadersBitstream() : AVCBaseBitstream() {}
+
+HEVCHeadersBitstream::HEVCHeadersBitstream(mfxU8* const pb, const mfxU32 maxsize)
+        : AVCBaseBitstream(pb, maxsize) {}
+
+mfxStatus HEVCHeadersBitstream::GetNalUnitHeader(HEVCNalUnitHeader* nal) {
+    // forbidden_zero_bit
+    if (Get1Bit())
+        return MFX_ERR_UNDEFINED_BEHAVIOR;
+
+    nal->nal_unit_type = (mfxU8)GetBits(6);
+    nal->nuh_layer_id  = (mfxU8)GetBits(6);
+
+    mfxU32 temporal_id_plus1 = GetBits(3);
+    if (!temporal_id_plus1)
+        return MFX_ERR_UNDEFINED_BEHAVIOR;
+    nal->nuh_temporal_id = (mfxU8)(temporal_id_plus1 - 1);
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus HEVCHeadersBitstream::GetVideoParamSet(HEVCVideoParamSet* vps) {
+    vps->vps_video_parameter_set_id = (mfxU8)GetBits(4);
+    // vps_base_layer_internal_flag, vps_base_layer_available_flag
+    SkipBits(2);
+    vps->vps_max_layers               = (mfxU8)(GetBits(6) + 1);
+    vps->vps_max_sub_layers           = (mfxU8)(GetBits(3) + 1);
+    vps->vps_temporal_id_nesting_flag = (mfxU8)Get1Bit();
+
+    if (vps->vps_max_sub_layers > HEVC_MAX_SUB_LAYERS)
+        return MFX_ERR_UNDEFINED_BEHAVIOR;
+
+    // vps_reserved_0xffff_16bits
+    if (GetBits(16) != 0xffff)
+        return MFX_ERR_UNDEFINED_BEHAVIOR;
+
+    return MFX_ERR_NONE;
+}
+
+void HEVCHeadersBitstream::GetProfileTierLevel(HEVCSeqParamSet* sps, mfxU32 maxSubLayers) {
+    // general_profile_space, general_tier_flag
+    SkipBits(3);
+    sps->general_profile_idc = (mfxU8)GetBits(5);
+    // general_profile_compatibility_flag[32], general source and constraint flags
+    SkipBits(32);
+    SkipBits(48);
+    sps->general_level_idc = (mfxU8)GetBits(8);
+
+    mfxU32 profilePresent = 0, levelPresent = 0;
+    for (mfxU32 i = 0; i + 1 < maxSubLayers; i++) {
+        profilePresent |= Get1Bit() << i;
+        levelPresent |= Get1Bit() << i;
+    }
+    // reserved_zero_2bits up to 8 sub-layers
+    if (maxSubLayers > 1)
+        SkipBits(2 * (9 - maxSubLayers));
+
+    for (mfxU32 i = 0; i + 1 < maxSubLayers; i++) {
+        if (profilePresent & (1 << i))
+            SkipBits(88);
+        if (levelPresent & (1 << i))
+            SkipBits(8);
+    }
+}
+
+mfxStatus HEVCHeadersBitstream::GetSequenceParamSet(HEVCSeqParamSet* sps) {
+    sps->sps_video_parameter_set_id = (mfxU8)GetBits(4);
+    sps->sps_max_sub_layers         = (mfxU8)(GetBits(3) + 1);
+    if (sps->sps_max_sub_layers > HEVC_MAX_SUB_LAYERS)
+        return MFX_ERR_UNDEFINED_BEHAVIOR;
+
+    // sps_temporal_id_nesting_flag
+    Get1Bit();
+    GetProfileTierLevel(sps, sps->sps_max_sub_layers);
+
+    mfxU32 id = (mfxU32)GetVLCElement(false);
+    if (id >= HEVC_MAX_NUM_SPS)
+        return MFX_ERR_UNDEFINED_BEHAVIOR;
+    sps->sps_seq_parameter_set_id = (mfxU8)id;
+
+    mfxU32 chroma_format_idc = (mfxU32)GetVLCElement(false);
+    if (chroma_format_idc > 3)
+        return MFX_ERR_UNDEFINED_BEHAVIOR;
+    sps->chroma_format_idc          = (mfxU8)chroma_format_idc;
+    sps->separate_colour_plane_flag = chroma_format_idc == 3 ? (mfxU8)Get1Bit() : 0;
+
+    sps->pic_width_in_luma_samples  = (mfxU32)GetVLCElement(false);
+    sps->pic_height_in_luma_samples = (mfxU32)GetVLCElement(false);
+    if (!sps->pic_width_in_luma_samples || !sps->pic_height_in_luma_samples ||
+        sps->pic_width_in_luma_samples > HEVC_MAX_PIC_WIDTH_LUMA ||
+        sps->pic_height_in_luma_samples > HEVC_MAX_PIC_HEIGHT_LUMA)
+        return MFX_ERR_UNDEFINED_BEHAVIOR;
+
+    // conformance_window_flag, conf_win_*_offset
+    if (Get1Bit()) {
+        for (mfxU32 i = 0; i < 4; i++)
+            GetVLCElement(false);
+    }
+
+    mfxU32 bit_depth_luma_minus8   = (mfxU32)GetVLCElement(false);
+    mfxU32 bit_depth_chroma_minus8 = (mfxU32)GetVLCElement(false);
+    mfxU32 log2_max_poc_lsb_minus4 = (mfxU32)GetVLCElement(false);
+    if (bit_depth_luma_minus8 > 8 || bit_depth_chroma_minus8 > 8 || log2_max_poc_lsb_minus4 > 12)
+        return MFX_ERR_UNDEFINED_BEHAVIOR;
+    sps->bit_depth_luma             = (mfxU8)(bit_depth_luma_minus8 + 8);
+    sps->bit_depth_chroma           = (mfxU8)(bit_depth_chroma_minus8 + 8);
+    sps->log2_max_pic_order_cnt_lsb = (mfxU8)(log2_max_poc_lsb_minus4 + 4);
+
+    // sps_max_dec_pic_buffering_minus1, sps_max_num_reorder_pics, sps_max_latency_increase_plus1
+    mfxU32 sub_layer_ordering_info_present_flag = Get1Bit();
+    mfxU32 orderingInfoCount = sub_layer_ordering_info_present_flag ? sps->sps_max_sub_layers : 1;
+    for (mfxU32 i = 0; i < 3 * orderingInfoCount; i++)
+        GetVLCElement(false);
+
+    mfxU32 log2_min_cb_size_minus3  = (mfxU32)GetVLCElement(false);
+    mfxU32 log2_diff_max_min_cb_size = (mfxU32)GetVLCElement(false);
+    if (log2_min_cb_size_minus3 > 3 || log2_min_cb_size_minus3 + log2_diff_max_min_cb_size > 3)
+        return MFX_ERR_UNDEFINED_BEHAVIOR;
+    sps->log2_min_luma_coding_block_size = (mfxU8)(log2_min_cb_size_minus3 + 3);
+    sps->log2_ctb_size = (mfxU8)(sps->log2_min_luma_coding_block_size + log2_diff_max_min_cb_size);
+
+    mfxU32 ctbSize        = 1 << sps->log2_ctb_size;
+    sps->pic_size_in_ctbs = ((sps->pic_width_in_luma_samples + ctbSize - 1) >> sps->log2_ctb_size) *
+                            ((sps->pic_height_in_luma_samples + ctbSize - 1) >> sps->log2_ctb_size);
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus HEVCHeadersBitstream::GetPictureParamSet(HEVCPicParamSet* pps) {
+    mfxU32 id    = (mfxU32)GetVLCElement(false);
+    mfxU32 spsId = (mfxU32)GetVLCElement(false);
+    if (id >= HEVC_MAX_NUM_PPS || spsId >= HEVC_MAX_NUM_SPS)
+        return MFX_ERR_UNDEFINED_BEHAVIOR;
+
+    pps->pps_pic_parameter_set_id              = (mfxU8)id;
+    pps->pps_seq_parameter_set_id              = (mfxU8)spsId;
+    pps->dependent_slice_segments_enabled_flag = (mfxU8)Get1Bit();
+    pps->output_flag_present_flag              = (mfxU8)Get1Bit();
+    pps->num_extra_slice_header_bits           = (mfxU8)GetBits(3);
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus HEVCHeadersBitstream::GetSliceHeaderPart1(HEVCSliceHeader* hdr) {
+    hdr->first_slice_segment_in_pic_flag = (mfxU8)Get1Bit();
+    hdr->no_output_of_prior_pics_flag    = IsHEVCIRAP(hdr->nal.nal_unit_type) ? (mfxU8)Get1Bit() : 0;
+
+    mfxU32 id = (mfxU32)GetVLCElement(false);
+    if (id >= HEVC_MAX_NUM_PPS)
+        return MFX_ERR_UNDEFINED_BEHAVIOR;
+    hdr->slice_pic_parameter_set_id = (mfxU8)id;
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus HEVCHeadersBitstream::GetSliceHeaderPart2(HEVCSliceHeader* hdr,
+                                                    const HEVCPicParamSet* pps,
+                                                    const HEVCSeqParamSet* sps) {
+    hdr->dependent_slice_segment_flag = 0;
+    hdr->slice_segment_address        = 0;
+
+    if (!hdr->first_slice_segment_in_pic_flag) {
+        if (pps->dependent_slice_segments_enabled_flag)
+            hdr->dependent_slice_segment_flag = (mfxU8)Get1Bit();
+
+        hdr->slice_segment_address = GetBits(CeilLog2(sps->pic_size_in_ctbs));
+        if (hdr->slice_segment_address >= sps->pic_size_in_ctbs)
+            return MFX_ERR_UNDEFINED_BEHAVIOR;
+    }
+
+    if (hdr->dependent_slice_segment_flag)
+        return MFX_ERR_NONE;
+
+    // slice_reserved_flag
+    SkipBits(pps->num_extra_slice_header_bits);
+
+    mfxU32 slice_type = (mfxU32)GetVLCElement(false);
+    if (slice_type > HEVC_SLICE_I)
+        return MFX_ERR_UNDEFINED_BEHAVIOR;
+    hdr->slice_type = (mfxU8)slice_type;
+
+    hdr->pic_output_flag = pps->output_flag_present_flag ? (mfxU8)Get1Bit() : 1;
+    hdr->colour_plane_id = sps->separate_colour_plane_flag ? (mfxU8)GetBits(2) : 0;
+
+    hdr->slice_pic_order_cnt_lsb =
+        IsHEVCIDR(hdr->nal.nal_unit_type) ? 0 : GetBits(sps->log2_max_pic_order_cnt_lsb);
+
+    return MFX_ERR_NONE;
+}
+
+} // namespace ProtectedLibrary
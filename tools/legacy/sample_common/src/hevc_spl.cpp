@@ -0,0 +1,450 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include <algorithm>
+
+#include "hevc_spl.h"
+#include "sample_defs.h"
+
+namespace ProtectedLibrary {
+
+static const mfxU8 start_code_prefix[] = { 0, 0, 1 };
+
+enum { HEVC_NAL_UNIT_HEADER_SIZE = 2 };
+
+HEVC_Spl::HEVC_Spl()
+        : m_WaitForIRAP(true),
+          m_firstInSequence(true),
+          m_NoRaslOutputFlag(true),
+          m_prevTid0Poc(0),
+          m_skipPicture(false),
+          m_lastSliceType(HEVC_SLICE_I),
+          m_hasPendingNalUnit(false),
+          m_nalUnitOffset(0),
+          m_pendingNalUnitOffset(0) {
+    m_pNALSplitter.reset(new NALUnitSplitter());
+    m_pNALSplitter->Init();
+
+    memset(&m_picture, 0, sizeof(m_picture));
+    memset(&m_pendingNalUnit, 0, sizeof(m_pendingNalUnit));
+    memset(&m_pendingNal, 0, sizeof(m_pendingNal));
+    memset(&m_pendingSlice, 0, sizeof(m_pendingSlice));
+
+    m_currentFrame.resize(BUFFER_SIZE);
+    m_slices.resize(128);
+
+    memset(&m_frame, 0, sizeof(m_frame));
+    m_frame.Data  = &m_currentFrame[0];
+    m_frame.Slice = &m_slices[0];
+}
+
+HEVC_Spl::~HEVC_Spl() {}
+
+mfxStatus HEVC_Spl::Reset() {
+    m_pNALSplitter->Reset();
+    m_WaitForIRAP       = true;
+    m_firstInSequence   = true;
+    m_NoRaslOutputFlag  = true;
+    m_prevTid0Poc       = 0;
+    m_skipPicture       = false;
+    m_hasPendingNalUnit = false;
+    m_nalUnitOffset     = 0;
+    return MFX_ERR_NONE;
+}
+
+void HEVC_Spl::ResetCurrentState() {
+    m_frame.DataLength         = 0;
+    m_frame.SliceNum           = 0;
+    m_frame.FirstFieldSliceNum = 0;
+    m_frame.KeyFrame           = false;
+}
+
+void HEVC_Spl::KeepHeader(mfxU32 type, mfxU32 id, const mfxBitstream* nalUnit) {
+    // VPS, SPS and PPS types are ascending, the map keeps the order of activation
+    std::vector<mfxU8>& header = m_headerNalUnits[(type << 16) | id];
+    header.assign(start_code_prefix, start_code_prefix + sizeof(start_code_prefix));
+    header.insert(header.end(),
+                  nalUnit->Data + nalUnit->DataOffset,
+                  nalUnit->Data + nalUnit->DataOffset + nalUnit->DataLength);
+}
+
+void HEVC_Spl::GetHeaders(std::vector<mfxU8>& headers) {
+    headers.clear();
+    for (const auto& header : m_headerNalUnits)
+        headers.insert(headers.end(), header.second.begin(), header.second.end());
+}
+
+mfxU8* HEVC_Spl::ExtractRbsp(mfxBitstream* nalUnit, mfxU32 maxSize, mfxU32& rbspSize) {
+    mfxU32 size = std::min(nalUnit->DataLength, maxSize);
+    if (m_rbspMemory.size() < size + 1)
+        m_rbspMemory.resize(size + 1);
+
+    rbspSize = RemovePreventingBytes(&m_rbspMemory[0], nalUnit->Data + nalUnit->DataOffset, size);
+    return &m_rbspMemory[0];
+}
+
+void HEVC_Spl::DecodeHeader(mfxBitstream* nalUnit) {
+    try {
+        mfxU32 rbspSize = 0;
+        mfxU8* rbsp     = ExtractRbsp(nalUnit, nalUnit->DataLength, rbspSize);
+
+        HEVCHeadersBitstream bitStream(rbsp, rbspSize);
+        HEVCNalUnitHeader nal;
+        if (bitStream.GetNalUnitHeader(&nal) != MFX_ERR_NONE)
+            return;
+
+        switch (nal.nal_unit_type) {
+            case HEVC_NAL_UT_VPS: {
+                HEVCVideoParamSet vps;
+                if (bitStream.GetVideoParamSet(&vps) == MFX_ERR_NONE) {
+                    m_videoParams.AddHeader(&vps);
+                    KeepHeader(nal.nal_unit_type, vps.vps_video_parameter_set_id, nalUnit);
+                }
+            } break;
+
+            case HEVC_NAL_UT_SPS: {
+                HEVCSeqParamSet sps;
+                if (bitStream.GetSequenceParamSet(&sps) == MFX_ERR_NONE) {
+                    m_seqParams.AddHeader(&sps);
+                    m_pNALSplitter->SetSuggestedSize(CalculateSuggestedSize(&sps));
+                    KeepHeader(nal.nal_unit_type, sps.sps_seq_parameter_set_id, nalUnit);
+                }
+            } break;
+
+            case HEVC_NAL_UT_PPS: {
+                HEVCPicParamSet pps;
+                if (bitStream.GetPictureParamSet(&pps) == MFX_ERR_NONE) {
+                    m_picParams.AddHeader(&pps);
+                    KeepHeader(nal.nal_unit_type, pps.pps_pic_parameter_set_id, nalUnit);
+                }
+            } break;
+
+            default:
+                break;
+        }
+    }
+    catch (const AVC_exception&) {
+        // the parameter set is ignored, slices referring to it are dropped
+    }
+}
+
+bool HEVC_Spl::DecodeSliceHeader(mfxBitstream* nalUnit,
+                                 const HEVCNalUnitHeader& nal,
+                                 HEVCSliceHeader* hdr) {
+    // only the beginning of the slice is needed for the header
+    mfxU32 rbspSize = 0;
+    mfxU8* rbsp     = ExtractRbsp(nalUnit, SLICE_HEADER_PREFIX_SIZE, rbspSize);
+
+    memset(hdr, 0, sizeof(*hdr));
+    hdr->nal = nal;
+
+    try {
+        HEVCHeadersBitstream bitStream(rbsp, rbspSize);
+        bitStream.SkipBits(HEVC_NAL_UNIT_HEADER_SIZE * 8);
+
+        if (bitStream.GetSliceHeaderPart1(hdr) != MFX_ERR_NONE)
+            return false;
+
+        const HEVCPicParamSet* pps = m_picParams.GetHeader(hdr->slice_pic_parameter_set_id);
+        if (!pps)
+            return false;
+        const HEVCSeqParamSet* sps = m_seqParams.GetHeader(pps->pps_seq_parameter_set_id);
+        if (!sps)
+            return false;
+
+        return bitStream.GetSliceHeaderPart2(hdr, pps, sps) == MFX_ERR_NONE;
+    }
+    catch (const AVC_exception&) {
+        return false;
+    }
+}
+
+bool HEVC_Spl::IsNewPicture(const HEVCSliceHeader& slice) const {
+    if (slice.first_slice_segment_in_pic_flag)
+        return true;
+
+    // the first slice segment is lost, all VCL NAL units of a picture have the same type
+    // and picture order count
+    if (slice.nal.nal_unit_type != m_picture.nal.nal_unit_type)
+        return true;
+
+    return !slice.dependent_slice_segment_flag &&
+           slice.slice_pic_order_cnt_lsb != m_picture.slice_pic_order_cnt_lsb;
+}
+
+bool HEVC_Spl::StartPicture(HEVCSliceHeader* hdr) {
+    mfxU32 type = hdr->nal.nal_unit_type;
+
+    if (m_WaitForIRAP && !IsHEVCIRAP(type))
+        return false;
+
+    const HEVCPicParamSet* pps = m_picParams.GetHeader(hdr->slice_pic_parameter_set_id);
+    const HEVCSeqParamSet* sps = m_seqParams.GetHeader(pps->pps_seq_parameter_set_id);
+
+    // 8.3.1, IDR and BLA pictures and the first CRA picture of a coded video sequence
+    // reset the most significant part
+    if (IsHEVCIRAP(type))
+        m_NoRaslOutputFlag = type != HEVC_NAL_UT_CRA || m_firstInSequence;
+
+    mfxI32 maxLsb = 1 << sps->log2_max_pic_order_cnt_lsb;
+    mfxI32 lsb    = (mfxI32)hdr->slice_pic_order_cnt_lsb;
+    mfxI32 msb    = 0;
+    if (!IsHEVCIRAP(type) || !m_NoRaslOutputFlag) {
+        mfxI32 prevLsb = m_prevTid0Poc & (maxLsb - 1);
+        mfxI32 prevMsb = m_prevTid0Poc - prevLsb;
+
+        if (lsb < prevLsb && prevLsb - lsb >= maxLsb / 2)
+            msb = prevMsb + maxLsb;
+        else if (lsb > prevLsb && lsb - prevLsb > maxLsb / 2)
+            msb = prevMsb - maxLsb;
+        else
+            msb = prevMsb;
+    }
+    hdr->pic_order_cnt = msb + lsb;
+
+    bool isLeading = type >= HEVC_NAL_UT_RADL_N && type <= HEVC_NAL_UT_RASL_R;
+    if (!hdr->nal.nuh_temporal_id && !isLeading && !IsHEVCSubLayerNonReference(type))
+        m_prevTid0Poc = hdr->pic_order_cnt;
+
+    m_WaitForIRAP     = false;
+    m_firstInSequence = false;
+
+    // RASL pictures refer to pictures before the random access point
+    bool isRasl = type == HEVC_NAL_UT_RASL_N || type == HEVC_NAL_UT_RASL_R;
+    return !(isRasl && m_NoRaslOutputFlag);
+}
+
+mfxStatus HEVC_Spl::ReserveFrameData(mfxU32 size) {
+    if (m_frame.DataLength + size < m_currentFrame.size())
+        return MFX_ERR_NONE;
+
+    if (m_frame.DataLength + size >= MAX_BUFFER_SIZE)
+        return MFX_ERR_NOT_ENOUGH_BUFFER;
+
+    size_t newSize = m_currentFrame.size();
+    while (newSize <= m_frame.DataLength + size)
+        newSize *= 2;
+    m_currentFrame.resize(std::min<size_t>(newSize, MAX_BUFFER_SIZE));
+    m_frame.Data = &m_currentFrame[0];
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus HEVC_Spl::AddNalUnit(mfxBitstream* nalUnit) {
+    mfxU32 length = (mfxU32)(nalUnit->DataLength + sizeof(start_code_prefix));
+    if (ReserveFrameData(length) != MFX_ERR_NONE)
+        return MFX_ERR_NOT_ENOUGH_BUFFER;
+
+    if (!m_frame.DataLength)
+        m_frame.SourceOffset = m_nalUnitOffset;
+
+    MSDK_MEMCPY_BUF(m_frame.Data,
+                    m_frame.DataLength,
+                    m_currentFrame.size(),
+                    start_code_prefix,
+                    sizeof(start_code_prefix));
+    MSDK_MEMCPY_BUF(m_frame.Data,
+                    m_frame.DataLength + sizeof(start_code_prefix),
+                    m_currentFrame.size(),
+                    nalUnit->Data + nalUnit->DataOffset,
+                    nalUnit->DataLength);
+
+    m_frame.DataLength += length;
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus HEVC_Spl::AddSliceNalUnit(mfxBitstream* nalUnit, const HEVCSliceHeader& slice) {
+    mfxU32 offset = m_frame.DataLength;
+    if (AddNalUnit(nalUnit) != MFX_ERR_NONE)
+        return MFX_ERR_NOT_ENOUGH_BUFFER;
+
+    if (!m_frame.SliceNum) {
+        m_frame.TimeStamp   = nalUnit->TimeStamp;
+        m_frame.PicOrderCnt = m_picture.pic_order_cnt;
+        m_frame.KeyFrame    = IsHEVCIRAP(m_picture.nal.nal_unit_type);
+    }
+
+    m_frame.SliceNum++;
+    m_frame.FirstFieldSliceNum = m_frame.SliceNum;
+
+    if (m_slices.size() <= m_frame.SliceNum) {
+        m_slices.resize(m_frame.SliceNum + 10);
+        m_frame.Slice = &m_slices[0];
+    }
+
+    SliceSplitterInfo& newSlice = m_slices[m_frame.SliceNum - 1];
+    newSlice.DataOffset         = offset;
+    newSlice.DataLength         = m_frame.DataLength - offset;
+    newSlice.HeaderLength       = sizeof(start_code_prefix) + HEVC_NAL_UNIT_HEADER_SIZE;
+    newSlice.SliceType          = slice.slice_type == HEVC_SLICE_I   ? TYPE_I
+                                  : slice.slice_type == HEVC_SLICE_P ? TYPE_P
+                                                                     : TYPE_B;
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus HEVC_Spl::ProcessSlice(mfxBitstream* nalUnit, const HEVCSliceHeader& slice) {
+    bool newPicture = (!m_frame.SliceNum && !m_skipPicture) || IsNewPicture(slice);
+
+    if (newPicture) {
+        if (m_frame.SliceNum) {
+            m_pendingNalUnit       = *nalUnit;
+            m_pendingSlice         = slice;
+            m_pendingNal           = slice.nal;
+            m_pendingNalUnitOffset = m_nalUnitOffset;
+            m_hasPendingNalUnit    = true;
+            return MFX_ERR_NONE;
+        }
+
+        m_picture     = slice;
+        m_skipPicture = !StartPicture(&m_picture);
+    }
+
+    if (m_skipPicture)
+        return MFX_ERR_MORE_DATA;
+
+    // dependent slice segments don't repeat slice_type
+    mfxU8 sliceType = slice.dependent_slice_segment_flag ? m_lastSliceType : slice.slice_type;
+    m_lastSliceType = sliceType;
+
+    HEVCSliceHeader segment = slice;
+    segment.slice_type      = sliceType;
+    if (AddSliceNalUnit(nalUnit, segment) != MFX_ERR_NONE)
+        return MFX_ERR_NOT_ENOUGH_BUFFER;
+
+    return MFX_ERR_MORE_DATA;
+}
+
+mfxStatus HEVC_Spl::ProcessNonVclNalUnit(mfxBitstream* nalUnit, const HEVCNalUnitHeader& nal) {
+    mfxU32 type = nal.nal_unit_type;
+
+    // 7.4.2.4.4, these NAL units after the last slice of a picture start the next one
+    bool startsAccessUnit = (type >= HEVC_NAL_UT_VPS && type <= HEVC_NAL_UT_AUD) ||
+                            type == HEVC_NAL_UT_PREFIX_SEI ||
+                            (type >= HEVC_NAL_UT_RSV_NVCL41 && type <= HEVC_NAL_UT_RSV_NVCL44) ||
+                            (type >= HEVC_NAL_UT_UNSPEC48 && type <= HEVC_NAL_UT_UNSPEC55);
+
+    if (startsAccessUnit && !nal.nuh_layer_id) {
+        if (m_frame.SliceNum) {
+            m_pendingNalUnit       = *nalUnit;
+            m_pendingNal           = nal;
+            m_pendingNalUnitOffset = m_nalUnitOffset;
+            m_hasPendingNalUnit    = true;
+            return MFX_ERR_NONE;
+        }
+        m_skipPicture = false;
+    }
+
+    switch (type) {
+        case HEVC_NAL_UT_VPS:
+        case HEVC_NAL_UT_SPS:
+        case HEVC_NAL_UT_PPS:
+            DecodeHeader(nalUnit);
+            AddNalUnit(nalUnit);
+            break;
+
+        case HEVC_NAL_UT_FD:
+            break;
+
+        case HEVC_NAL_UT_EOS:
+        case HEVC_NAL_UT_EOB:
+            // the next picture starts a new coded video sequence
+            m_firstInSequence = true;
+            AddNalUnit(nalUnit);
+            break;
+
+        default:
+            if (!m_skipPicture)
+                AddNalUnit(nalUnit);
+            break;
+    }
+
+    return MFX_ERR_MORE_DATA;
+}
+
+mfxStatus HEVC_Spl::ProcessNalUnit(mfxBitstream* nalUnit) {
+    if (nalUnit->DataLength < HEVC_NAL_UNIT_HEADER_SIZE)
+        return MFX_ERR_MORE_DATA;
+
+    HEVCNalUnitHeader nal;
+    {
+        HEVCHeadersBitstream bitStream(nalUnit->Data + nalUnit->DataOffset,
+                                       HEVC_NAL_UNIT_HEADER_SIZE);
+        if (bitStream.GetNalUnitHeader(&nal) != MFX_ERR_NONE)
+            return MFX_ERR_MORE_DATA;
+    }
+
+    if (!IsHEVCSlice(nal.nal_unit_type))
+        return ProcessNonVclNalUnit(nalUnit, nal);
+
+    // reserved VCL NAL unit types are ignored
+    if (nal.nal_unit_type > HEVC_NAL_UT_RSV_IRAP_VCL23)
+        return MFX_ERR_MORE_DATA;
+
+    // slices of other layers follow the base layer picture
+    if (nal.nuh_layer_id) {
+        if (m_frame.SliceNum && AddNalUnit(nalUnit) != MFX_ERR_NONE)
+            return MFX_ERR_NOT_ENOUGH_BUFFER;
+        return MFX_ERR_MORE_DATA;
+    }
+
+    HEVCSliceHeader slice;
+    if (!DecodeSliceHeader(nalUnit, nal, &slice))
+        return MFX_ERR_MORE_DATA;
+
+    return ProcessSlice(nalUnit, slice);
+}
+
+mfxStatus HEVC_Spl::GetFrame(mfxBitstream* bs_in, FrameSplitterInfo** frame) {
+    *frame = 0;
+
+    if (m_hasPendingNalUnit) {
+        m_hasPendingNalUnit = false;
+        m_nalUnitOffset     = m_pendingNalUnitOffset;
+        if (IsHEVCSlice(m_pendingNal.nal_unit_type)) {
+            if (ProcessSlice(&m_pendingNalUnit, m_pendingSlice) == MFX_ERR_NOT_ENOUGH_BUFFER)
+                return MFX_ERR_NOT_ENOUGH_BUFFER;
+        }
+        else {
+            ProcessNonVclNalUnit(&m_pendingNalUnit, m_pendingNal);
+        }
+    }
+
+    do {
+        mfxBitstream* destination = NULL;
+        m_pNALSplitter->GetNalUnits(bs_in, destination);
+        m_nalUnitOffset = m_pNALSplitter->GetNalUnitOffset();
+
+        mfxStatus sts = destination ? ProcessNalUnit(destination) : MFX_ERR_MORE_DATA;
+        // the slice doesn't fit into the frame buffer
+        if (sts == MFX_ERR_NOT_ENOUGH_BUFFER)
+            return sts;
+
+        // after the last NAL unit of the stream the current frame is complete
+        bool endOfStream = !bs_in || (!destination && (bs_in->DataFlag & MFX_BITSTREAM_EOS));
+        if (sts == MFX_ERR_NONE || (endOfStream && m_frame.SliceNum)) {
+            *frame = &m_frame;
+            return MFX_ERR_NONE;
+        }
+
+        // the rest of the NAL unit isn't in the bitstream yet
+        if (!destination)
+            break;
+        // with the end of stream flag the remaining bytes are the last NAL unit
+    } while (bs_in &&
+             (bs_in->DataLength > MINIMAL_DATA_SIZE || (bs_in->DataFlag & MFX_BITSTREAM_EOS)));
+
+    return MFX_ERR_MORE_DATA;
+}
+
+mfxStatus HEVC_Spl::PostProcessing(FrameSplitterInfo* frame, mfxU32 sliceNum) {
+    UNREFERENCED_PARAMETER(frame);
+    UNREFERENCED_PARAMETER(sliceNum);
+    return MFX_ERR_NONE;
+}
+
+} // namespace ProtectedLibrary
@@ -0,0 +1,103 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include "latency_histogram.h"
+
+#include <algorithm>
+
+#define HISTOGRAM_SUB_BUCKETS      (1u << CLatencyHistogram::SubBucketBits)
+#define HISTOGRAM_HALF_SUB_BUCKETS (HISTOGRAM_SUB_BUCKETS / 2)
+#define HISTOGRAM_MAX_VALUE        ((1ull << CLatencyHistogram::MaxValueBits) - 1)
+
+static mfxU32 HighestBit(mfxU64 value) {
+    mfxU32 bit = 0;
+    while (value >>= 1)
+        bit++;
+    return bit;
+}
+
+CLatencyHistogram::CLatencyHistogram()
+        : m_counts(GetIndex(HISTOGRAM_MAX_VALUE) + 1),
+          m_count(0),
+          m_min(0),
+          m_max(0),
+          m_sum(0) {}
+
+// values with the highest bit b >= SubBucketBits are counted with a step of 2^shift, where
+// shift = b - SubBucketBits + 1, the counters of a power of two range follow the previous ones
+mfxU32 CLatencyHistogram::GetIndex(mfxU64 value) {
+    if (value < HISTOGRAM_SUB_BUCKETS)
+        return (mfxU32)value;
+    mfxU32 shift = HighestBit(value) - SubBucketBits + 1;
+    return shift * HISTOGRAM_HALF_SUB_BUCKETS + (mfxU32)(value >> shift);
+}
+
+mfxU64 CLatencyHistogram::GetValue(mfxU32 index) {
+    if (index < HISTOGRAM_SUB_BUCKETS)
+        return index;
+    mfxU32 shift = index / HISTOGRAM_HALF_SUB_BUCKETS - 1;
+    mfxU64 first = (mfxU64)(index - shift * HISTOGRAM_HALF_SUB_BUCKETS) << shift;
+    return first + ((1ull << shift) >> 1);
+}
+
+void CLatencyHistogram::Record(mfxF64 seconds) {
+    mfxF64 ns    = seconds * 1e9;
+    mfxU64 value = ns <= 0 ? 0 : ns >= (mfxF64)HISTOGRAM_MAX_VALUE ? HISTOGRAM_MAX_VALUE
+                                                                   : (mfxU64)(ns + 0.5);
+
+    m_counts[GetIndex(value)]++;
+    m_min = m_count ? std::min(m_min, value) : value;
+    m_max = m_count ? std::max(m_max, value) : value;
+    m_sum += seconds;
+    m_count++;
+}
+
+void CLatencyHistogram::Merge(const CLatencyHistogram& other) {
+    if (!other.m_count)
+        return;
+    for (size_t i = 0; i < m_counts.size(); i++)
+        m_counts[i] += other.m_counts[i];
+    m_min = m_count ? std::min(m_min, other.m_min) : other.m_min;
+    m_max = m_count ? std::max(m_max, other.m_max) : other.m_max;
+    m_sum += other.m_sum;
+    m_count += other.m_count;
+}
+
+void CLatencyHistogram::Reset() {
+    std::fill(m_counts.begin(), m_counts.end(), 0);
+    m_count = 0;
+    m_min   = 0;
+    m_max   = 0;
+    m_sum   = 0;
+}
+
+mfxF64 CLatencyHistogram::GetMin() const {
+    return m_min * 1e-9;
+}
+
+mfxF64 CLatencyHistogram::GetMax() const {
+    return m_max * 1e-9;
+}
+
+mfxF64 CLatencyHistogram::GetMean() const {
+    return m_count ? m_sum / m_count : 0;
+}
+
+mfxF64 CLatencyHistogram::GetPercentile(mfxF64 percent) const {
+    if (!m_count)
+        return 0;
+
+    // the measurement with the rank is the first one not below the percentile
+    mfxF64 rank    = std::min(std::max(percent, 0.0), 100.0) / 100 * m_count;
+    mfxU64 needed  = std::max<mfxU64>((mfxU64)(rank + 0.5), 1);
+    mfxU64 counted = 0;
+    for (mfxU32 i = 0; i < m_counts.size(); i++) {
+        counted += m_counts[i];
+        if (counted >= needed)
+            return std::min(std::max(GetValue(i), m_min), m_max) * 1e-9;
+    }
+    return GetMax();
+}
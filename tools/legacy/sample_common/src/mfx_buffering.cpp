@@ -7,6 +7,7 @@
 #include "mfx_samples_config.h"
 
 #include <stdlib.h>
+#include <new>
 
 #include <mfx_buffering.h>
 
@@ -15,13 +16,14 @@ CBuffering::CBuffering()
           m_OutputSurfacesNumber(0),
           m_pSurfaces(NULL),
           m_pVppSurfaces(NULL),
-          m_FreeSurfacesPool(m_Mutex),
-          m_FreeVppSurfacesPool(m_Mutex),
-          m_UsedSurfacesPool(m_Mutex),
-          m_UsedVppSurfacesPool(m_Mutex),
-          m_pFreeOutputSurfaces(NULL),
-          m_OutputSurfacesPool(m_Mutex),
-          m_DeliveredSurfacesPool(m_Mutex) {}
+          m_pOutputSurfaces(NULL),
+          m_FreeSurfacesPool(),
+          m_FreeVppSurfacesPool(),
+          m_UsedSurfacesPool(),
+          m_UsedVppSurfacesPool(),
+          m_FreeOutputSurfaces(),
+          m_OutputSurfacesPool(),
+          m_DeliveredSurfacesPool() {}
 
 CBuffering::~CBuffering() {}
 
@@ -38,22 +40,14 @@ mfxStatus CBuffering::AllocBuffers(mfxU32 SurfaceNumber) {
     if (!m_pSurfaces)
         return MFX_ERR_MEMORY_ALLOC;
 
-    msdkOutputSurface* p    = NULL;
-    msdkOutputSurface* tail = NULL;
-
-    m_pFreeOutputSurfaces = (msdkOutputSurface*)calloc(1, sizeof(msdkOutputSurface));
-    if (!m_pFreeOutputSurfaces)
+    // an output surface per output frame surface, see GetFreeOutputSurface()
+    m_pOutputSurfaces = new (std::nothrow) msdkOutputSurface[m_OutputSurfacesNumber]();
+    if (!m_pOutputSurfaces)
         return MFX_ERR_MEMORY_ALLOC;
 
-    tail = m_pFreeOutputSurfaces;
-
-    for (mfxU32 i = 1; i < m_OutputSurfacesNumber; ++i) {
-        p = (msdkOutputSurface*)calloc(1, sizeof(msdkOutputSurface));
-        if (!p)
-            return MFX_ERR_MEMORY_ALLOC;
-        tail->next = p;
-        tail       = p;
-    }
+    m_FreeOutputSurfaces.Init(m_pOutputSurfaces, m_OutputSurfacesNumber);
+    for (mfxU32 i = m_OutputSurfacesNumber; i > 0; --i)
+        m_FreeOutputSurfaces.Push(&m_pOutputSurfaces[i - 1]);
 
     ResetBuffers();
     return MFX_ERR_NONE;
@@ -69,21 +63,6 @@ mfxStatus CBuffering::AllocVppBuffers(mfxU32 VppSurfaceNumber) {
     return MFX_ERR_NONE;
 }
 
-void CBuffering::AllocOutputBuffer() {
-    std::lock_guard<std::mutex> lock(m_Mutex);
-
-    m_pFreeOutputSurfaces = (msdkOutputSurface*)calloc(1, sizeof(msdkOutputSurface));
-}
-
-static void FreeList(msdkOutputSurface*& head) {
-    msdkOutputSurface* next;
-    while (head) {
-        next = head->next;
-        free(head);
-        head = next;
-    }
-}
-
 void CBuffering::FreeBuffers() {
     if (m_pSurfaces) {
         free(m_pSurfaces);
@@ -95,81 +74,77 @@ void CBuffering::FreeBuffers() {
         m_pVppSurfaces = NULL;
     }
 
-    FreeList(m_pFreeOutputSurfaces);
-    FreeList(m_OutputSurfacesPool.m_pSurfacesHead);
-    FreeList(m_DeliveredSurfacesPool.m_pSurfacesHead);
+    // output surfaces in the lists are elements of the array
+    m_OutputSurfacesPool.Reset();
+    m_DeliveredSurfacesPool.Reset();
+    m_FreeOutputSurfaces.Init(NULL, 0);
+    delete[] m_pOutputSurfaces;
+    m_pOutputSurfaces = NULL;
 
     m_UsedSurfacesPool.m_pSurfacesHead    = NULL;
     m_UsedSurfacesPool.m_pSurfacesTail    = NULL;
     m_UsedVppSurfacesPool.m_pSurfacesHead = NULL;
     m_UsedVppSurfacesPool.m_pSurfacesTail = NULL;
-    m_OutputSurfacesPool.m_pSurfacesHead  = NULL;
-    m_OutputSurfacesPool.m_pSurfacesTail  = NULL;
 
-    m_FreeSurfacesPool.m_pSurfaces    = NULL;
-    m_FreeVppSurfacesPool.m_pSurfaces = NULL;
+    m_FreeSurfacesPool.m_Surfaces.Init(NULL, 0);
+    m_FreeVppSurfacesPool.m_Surfaces.Init(NULL, 0);
+
+    // the next allocation may have a different number of surfaces
+    m_SurfacesNumber       = 0;
+    m_OutputSurfacesNumber = 0;
 }
 
 void CBuffering::ResetBuffers() {
     mfxU32 i;
-    msdkFrameSurface* pFreeSurf = m_FreeSurfacesPool.m_pSurfaces = m_pSurfaces;
+    msdkFrameSurface* pFreeSurf = m_pSurfaces;
 
-    for (i = 0; i < m_SurfacesNumber; ++i) {
-        if (i < (m_SurfacesNumber - 1)) {
-            pFreeSurf[i].next     = &(pFreeSurf[i + 1]);
-            pFreeSurf[i + 1].prev = &(pFreeSurf[i]);
-        }
+    // the first surface is on the top
+    m_FreeSurfacesPool.m_Surfaces.Init(pFreeSurf, m_SurfacesNumber);
+    for (i = m_SurfacesNumber; i > 0; --i) {
+        pFreeSurf[i - 1].prev = pFreeSurf[i - 1].next = NULL;
+        m_FreeSurfacesPool.AddSurface(&(pFreeSurf[i - 1]));
     }
 }
 
 void CBuffering::ResetVppBuffers() {
     mfxU32 i;
-    msdkFrameSurface* pFreeVppSurf = m_FreeVppSurfacesPool.m_pSurfaces = m_pVppSurfaces;
+    msdkFrameSurface* pFreeVppSurf = m_pVppSurfaces;
 
-    for (i = 0; i < m_OutputSurfacesNumber; ++i) {
-        if (i < (m_OutputSurfacesNumber - 1)) {
-            pFreeVppSurf[i].next     = &(pFreeVppSurf[i + 1]);
-            pFreeVppSurf[i + 1].prev = &(pFreeVppSurf[i]);
-        }
+    m_FreeVppSurfacesPool.m_Surfaces.Init(pFreeVppSurf, m_OutputSurfacesNumber);
+    for (i = m_OutputSurfacesNumber; i > 0; --i) {
+        pFreeVppSurf[i - 1].prev = pFreeVppSurf[i - 1].next = NULL;
+        m_FreeVppSurfacesPool.AddSurface(&(pFreeVppSurf[i - 1]));
     }
 }
 
 void CBuffering::SyncFrameSurfaces() {
-    std::lock_guard<std::mutex> lock(m_Mutex);
+    std::lock_guard<std::mutex> lock(m_UsedSurfacesPool.m_Mutex);
     msdkFrameSurface* next = NULL;
     msdkFrameSurface* cur  = m_UsedSurfacesPool.m_pSurfacesHead;
 
     while (cur) {
-        if (cur->frame.Data.Locked || cur->render_lock) {
-            // frame is still locked: just moving to the next one
-            cur = cur->next;
-        }
-        else {
+        next = cur->next;
+        if (!cur->frame.Data.Locked && !cur->render_lock) {
             // frame was unlocked: moving it to the free surfaces array
             m_UsedSurfacesPool.DetachSurfaceUnsafe(cur);
-            m_FreeSurfacesPool.AddSurfaceUnsafe(cur);
-
-            cur = next;
+            m_FreeSurfacesPool.AddSurface(cur);
         }
+        cur = next;
     }
 }
 
 void CBuffering::SyncVppFrameSurfaces() {
-    std::lock_guard<std::mutex> lock(m_Mutex);
+    std::lock_guard<std::mutex> lock(m_UsedVppSurfacesPool.m_Mutex);
     msdkFrameSurface* next = NULL;
     msdkFrameSurface* cur  = m_UsedVppSurfacesPool.m_pSurfacesHead;
 
     while (cur) {
-        if (cur->frame.Data.Locked || cur->render_lock) {
-            // frame is still locked: just moving to the next one
-            cur = cur->next;
-        }
-        else {
+        next = cur->next;
+        if (!cur->frame.Data.Locked && !cur->render_lock) {
             // frame was unlocked: moving it to the free surfaces array
             m_UsedVppSurfacesPool.DetachSurfaceUnsafe(cur);
-            m_FreeVppSurfacesPool.AddSurfaceUnsafe(cur);
-
-            cur = next;
+            m_FreeVppSurfacesPool.AddSurface(cur);
         }
+        cur = next;
     }
 }
@@ -11,6 +11,7 @@
 #include <iostream>
 #include <map>
 
+#include "frame_kernels.h"
 #include "sample_defs.h"
 #include "sample_utils.h"
 #include "time_statistics.h"
@@ -39,7 +40,13 @@
 
 #else
 
+    #include <errno.h>
+    #include <fcntl.h>
+    #include <limits.h>
     #include <link.h>
+    #include <sys/stat.h>
+    #include <sys/uio.h>
+    #include <unistd.h>
     #include <string>
 
     #if defined(__x86_64__)
@@ -101,11 +108,219 @@ mfxStatus GetFrameLength(mfxU16 width, mfxU16 height, mfxU32 ColorFormat, mfxU32
     return MFX_ERR_NONE;
 }
 
+namespace {
+
+// Plane list where contiguous planes are merged into a single row
+std::vector<FramePlane> NormalizePlanes(const FramePlane* planes, mfxU32 count) {
+    std::vector<FramePlane> result;
+    result.reserve(count);
+    for (mfxU32 i = 0; i < count; i++) {
+        FramePlane plane = planes[i];
+        if (!plane.RowSize || !plane.Rows)
+            continue;
+        if (plane.Pitch == plane.RowSize || plane.Rows == 1) {
+            plane.RowSize *= plane.Rows;
+            plane.Rows  = 1;
+            plane.Pitch = plane.RowSize;
+        }
+        result.push_back(plane);
+    }
+    return result;
+}
+
+mfxU64 GetPlanesSize(const std::vector<FramePlane>& planes) {
+    mfxU64 size = 0;
+    for (auto& plane : planes)
+        size += (mfxU64)plane.RowSize * plane.Rows;
+    return size;
+}
+
+// stdio based transfer, used for pipes and where vectored I/O isn't available
+bool TransferPlanesStdio(FILE* f, const std::vector<FramePlane>& planes, bool write) {
+    for (auto& plane : planes) {
+        for (mfxU32 row = 0; row < plane.Rows; row++) {
+            mfxU8* ptr = plane.Data + (size_t)row * plane.Pitch;
+            size_t n   = write ? fwrite(ptr, 1, plane.RowSize, f) : fread(ptr, 1, plane.RowSize, f);
+            if (n != plane.RowSize)
+                return false;
+        }
+    }
+    return true;
+}
+
+#if !defined(_WIN32) && !defined(_WIN64)
+
+    #if defined(IOV_MAX)
+const mfxU32 MAX_IOV = IOV_MAX;
+    #else
+const mfxU32 MAX_IOV = 1024;
+    #endif
+
+// Returns file offset if the stream is backed by a regular file, -1 otherwise
+off_t GetFileOffset(FILE* f) {
+    struct stat st;
+    if (fstat(fileno(f), &st) != 0 || !S_ISREG(st.st_mode))
+        return -1;
+    return ftello(f);
+}
+
+// Transfers rows of the planes with preadv/pwritev starting at the given offset, an iovec
+// per row. Returns number of bytes transferred.
+mfxU64 TransferPlanesVectored(int fd, off_t offset, const std::vector<FramePlane>& planes, bool write) {
+    std::vector<iovec> iov;
+    iov.reserve(MAX_IOV);
+
+    mfxU64 done  = 0;
+    size_t plane = 0;
+    mfxU32 row = 0, skip = 0; // current position: row of the plane and bytes done in that row
+    while (plane < planes.size()) {
+        iov.clear();
+        size_t p = plane;
+        mfxU32 r = row, s = skip;
+        while (iov.size() < MAX_IOV && p < planes.size()) {
+            iovec v;
+            v.iov_base = planes[p].Data + (size_t)r * planes[p].Pitch + s;
+            v.iov_len  = planes[p].RowSize - s;
+            iov.push_back(v);
+            s = 0;
+            if (++r == planes[p].Rows) {
+                r = 0;
+                p++;
+            }
+        }
+
+        ssize_t n = write ? pwritev(fd, iov.data(), (int)iov.size(), offset)
+                          : preadv(fd, iov.data(), (int)iov.size(), offset);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        offset += n;
+        done += n;
+
+        // advance over transferred bytes
+        while (n > 0) {
+            mfxU32 rest = planes[plane].RowSize - skip;
+            if ((size_t)n < rest) {
+                skip += (mfxU32)n;
+                break;
+            }
+            n -= rest;
+            skip = 0;
+            if (++row == planes[plane].Rows) {
+                row = 0;
+                plane++;
+            }
+        }
+    }
+    return done;
+}
+
+// Reads planes through the O_DIRECT descriptor: whole aligned range is read into the staging
+// buffer and rows are copied to the destination. Returns false if direct read isn't possible.
+bool ReadPlanesDirect(int fd,
+                      FILE* f,
+                      const std::vector<FramePlane>& planes,
+                      std::vector<mfxU8>& staging,
+                      mfxU64& done) {
+    const off_t align = 4096;
+
+    off_t pos = GetFileOffset(f);
+    if (pos < 0)
+        return false;
+
+    mfxU64 size  = GetPlanesSize(planes);
+    off_t start  = pos & ~(align - 1);
+    size_t len   = (size_t)((pos + size - start + align - 1) & ~(mfxU64)(align - 1));
+    staging.resize(len + align);
+    mfxU8* buffer = (mfxU8*)(((uintptr_t)staging.data() + align - 1) & ~(uintptr_t)(align - 1));
+
+    size_t got = 0;
+    while (got < len) {
+        ssize_t n = pread(fd, buffer + got, len - got, start + got);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0) {
+            if (got == 0)
+                return false; // file system doesn't support O_DIRECT
+            break;
+        }
+        if (n == 0)
+            break;
+        got += n;
+        // last block of the file might be read partially
+        if (n % align)
+            break;
+    }
+
+    mfxU64 available = got > (size_t)(pos - start) ? got - (pos - start) : 0;
+    mfxU8* src       = buffer + (pos - start);
+    done             = 0;
+    for (auto& plane : planes) {
+        for (mfxU32 row = 0; row < plane.Rows && done + plane.RowSize <= available; row++) {
+            MSDK_MEMCPY(plane.Data + (size_t)row * plane.Pitch, src + done, plane.RowSize);
+            done += plane.RowSize;
+        }
+    }
+    fseeko(f, pos + done, SEEK_SET);
+    return true;
+}
+
+#endif // #if !defined(_WIN32) && !defined(_WIN64)
+
+bool TransferPlanes(FILE* f, const std::vector<FramePlane>& planes, bool write) {
+#if !defined(_WIN32) && !defined(_WIN64)
+    if (write)
+        fflush(f);
+    off_t pos = GetFileOffset(f);
+    if (pos >= 0) {
+        mfxU64 size = GetPlanesSize(planes);
+        mfxU64 done = TransferPlanesVectored(fileno(f), pos, planes, write);
+        // keep the stream position in sync with the descriptor transfers
+        fseeko(f, pos + done, SEEK_SET);
+        return done == size;
+    }
+#endif
+    return TransferPlanesStdio(f, planes, write);
+}
+
+// Copies rows of 16-bit samples to the packed buffer shifting them to the lower bits
+void ShiftRowsLow(const mfxU8* src,
+                  mfxU32 pitch,
+                  mfxU32 samples,
+                  mfxU32 rows,
+                  mfxU32 shift,
+                  mfxU16* dst) {
+    const FrameKernels::KernelTable& kernels = FrameKernels::Kernels();
+    for (mfxU32 i = 0; i < rows; i++) {
+        kernels.ShiftRight16((const mfxU16*)(src + (size_t)i * pitch), dst, samples, shift);
+        dst += samples;
+    }
+}
+
+} // namespace
+
+mfxStatus ReadFramePlanes(FILE* f, const FramePlane* planes, mfxU32 count) {
+    MSDK_CHECK_POINTER(f, MFX_ERR_NULL_PTR);
+    return TransferPlanes(f, NormalizePlanes(planes, count), false) ? MFX_ERR_NONE
+                                                                    : MFX_ERR_MORE_DATA;
+}
+
+mfxStatus WriteFramePlanes(FILE* f, const FramePlane* planes, mfxU32 count) {
+    MSDK_CHECK_POINTER(f, MFX_ERR_NULL_PTR);
+    return TransferPlanes(f, NormalizePlanes(planes, count), true) ? MFX_ERR_NONE
+                                                                   : MFX_ERR_UNDEFINED_BEHAVIOR;
+}
+
 CSmplYUVReader::CSmplYUVReader()
         : m_ColorFormat(MFX_FOURCC_YV12),
           m_files(),
+          m_directFiles(),
+          m_directBuffer(),
+          m_convertBuffer(),
           shouldShift10BitsHigh(false),
-          m_bInited(false) {}
+          m_bInited(false),
+          m_bDirectIO(false) {}
 
 mfxStatus CSmplYUVReader::Init(std::list<msdk_string> inputs,
                                mfxU32 ColorFormat,
@@ -138,6 +353,12 @@ mfxStatus CSmplYUVReader::Init(std::list<msdk_string> inputs,
         auto& f = m_files.back();
         MSDK_FOPEN(f, (*it).c_str(), MSDK_STRING("rb"));
         MSDK_CHECK_POINTER(f, MFX_ERR_NULL_PTR);
+
+        m_directFiles.push_back(-1);
+#if defined(__linux__)
+        if (m_bDirectIO)
+            m_directFiles.back() = open((*it).c_str(), O_RDONLY | O_DIRECT);
+#endif
     }
 
     m_ColorFormat = ColorFormat;
@@ -156,6 +377,13 @@ void CSmplYUVReader::Close() {
         fclose(m_files[i]);
     }
     m_files.clear();
+#if !defined(_WIN32) && !defined(_WIN64)
+    for (mfxU32 i = 0; i < m_directFiles.size(); i++) {
+        if (m_directFiles[i] >= 0)
+            close(m_directFiles[i]);
+    }
+#endif
+    m_directFiles.clear();
     m_bInited = false;
 }
 
@@ -184,13 +412,27 @@ mfxStatus CSmplYUVReader::SkipNframesFromBeginning(mfxU16 w,
     return MFX_ERR_NONE;
 }
 
+mfxStatus CSmplYUVReader::ReadPlanes(mfxU32 vid, const FramePlane* planes, mfxU32 count) {
+#if !defined(_WIN32) && !defined(_WIN64)
+    if (m_directFiles[vid] >= 0) {
+        std::vector<FramePlane> list = NormalizePlanes(planes, count);
+        mfxU64 done                  = 0;
+        if (ReadPlanesDirect(m_directFiles[vid], m_files[vid], list, m_directBuffer, done))
+            return done == GetPlanesSize(list) ? MFX_ERR_NONE : MFX_ERR_MORE_DATA;
+        // O_DIRECT isn't supported for this file, don't try anymore
+        close(m_directFiles[vid]);
+        m_directFiles[vid] = -1;
+    }
+#endif
+    return ReadFramePlanes(m_files[vid], planes, count);
+}
+
 mfxStatus CSmplYUVReader::LoadNextFrame(mfxFrameSurface1* pSurface) {
     // check if reader is initialized
     MSDK_CHECK_ERROR(m_bInited, false, MFX_ERR_NOT_INITIALIZED);
     MSDK_CHECK_POINTER(pSurface, MFX_ERR_NULL_PTR);
 
-    mfxU32 nBytesRead;
-    mfxU16 w, h, i, pitch;
+    mfxU32 w, h, i, pitch;
     mfxU8 *ptr, *ptr2;
     mfxFrameInfo& pInfo = pSurface->Info;
     mfxFrameData& pData = pSurface->Data;
@@ -218,67 +460,55 @@ mfxStatus CSmplYUVReader::LoadNextFrame(mfxFrameSurface1* pSurface) {
                                 ? 2
                                 : 1;
 
+    // Planes of the frame in the order they are stored in the file
+    FramePlane planes[3] = {};
+    mfxU32 nPlanes       = 0;
+    // Planes which have to be shifted after reading and the shift size
+    FramePlane* shiftPlanes[2] = {};
+    mfxU32 shiftSizes[2]       = {};
+    mfxU32 shiftSamples[2]     = {};
+    mfxU32 nShiftPlanes        = 0;
+    // Chroma planes of I420/YV12 input which have to be interleaved into NV12 surface
+    bool interleaveChroma = false;
+
     if (MFX_FOURCC_YUY2 == pInfo.FourCC || MFX_FOURCC_UYVY == pInfo.FourCC ||
         MFX_FOURCC_RGB4 == pInfo.FourCC || MFX_FOURCC_BGR4 == pInfo.FourCC ||
         MFX_FOURCC_AYUV == pInfo.FourCC || MFX_FOURCC_A2RGB10 == pInfo.FourCC ||
         MFX_FOURCC_Y210 == pInfo.FourCC || MFX_FOURCC_Y410 == pInfo.FourCC ||
         MFX_FOURCC_Y216 == pInfo.FourCC) {
         //Packed format: Luminance and chrominance are on the same plane
+        pitch = pData.Pitch;
         switch (m_ColorFormat) {
             case MFX_FOURCC_A2RGB10:
             case MFX_FOURCC_AYUV:
             case MFX_FOURCC_RGB4:
             case MFX_FOURCC_BGR4:
-                pitch = pData.Pitch;
-                ptr   = std::min({ pData.R, pData.G, pData.B });
-                ptr   = ptr + pInfo.CropX * 4 + pInfo.CropY * pData.Pitch;
-
-                for (i = 0; i < h; i++) {
-                    nBytesRead = (mfxU32)fread(ptr + i * pitch, 1, 4 * w, m_files[vid]);
-
-                    if ((mfxU32)4 * w != nBytesRead) {
-                        return MFX_ERR_MORE_DATA;
-                    }
-                }
+                ptr                = std::min({ pData.R, pData.G, pData.B });
+                ptr                = ptr + pInfo.CropX * 4 + pInfo.CropY * pData.Pitch;
+                planes[nPlanes++]  = { ptr, 4 * w, h, pitch };
                 break;
             case MFX_FOURCC_YUY2:
             case MFX_FOURCC_UYVY:
-                pitch = pData.Pitch;
-                ptr   = m_ColorFormat == MFX_FOURCC_YUY2
+                ptr = m_ColorFormat == MFX_FOURCC_YUY2
                           ? pData.Y + pInfo.CropX * 2 + pInfo.CropY * pData.Pitch
                           : pData.U + pInfo.CropX + pInfo.CropY * pData.Pitch;
-
-                for (i = 0; i < h; i++) {
-                    nBytesRead = (mfxU32)fread(ptr + i * pitch, 2, w, m_files[vid]);
-
-                    if ((mfxU32)w != nBytesRead) {
-                        return MFX_ERR_MORE_DATA;
-                    }
-                }
+                planes[nPlanes++] = { ptr, 2 * w, h, pitch };
                 break;
             case MFX_FOURCC_Y210:
             case MFX_FOURCC_Y410:
             case MFX_FOURCC_Y216:
-                pitch = pData.Pitch;
-                ptr   = ((pInfo.FourCC == MFX_FOURCC_Y210 || pInfo.FourCC == MFX_FOURCC_Y216)
+                ptr = ((pInfo.FourCC == MFX_FOURCC_Y210 || pInfo.FourCC == MFX_FOURCC_Y216)
                            ? pData.Y
                            : (mfxU8*)pData.Y410) +
                       pInfo.CropX * 4 + pInfo.CropY * pData.Pitch;
-
-                for (i = 0; i < h; i++) {
-                    nBytesRead = (mfxU32)fread(ptr + i * pitch, 1, 4 * w, m_files[vid]);
-
-                    if ((mfxU32)4 * w != nBytesRead) {
-                        return MFX_ERR_MORE_DATA;
-                    }
-
-                    if ((MFX_FOURCC_Y210 == pInfo.FourCC || MFX_FOURCC_Y216 == pInfo.FourCC) &&
-                        shouldShift10BitsHigh) {
-                        mfxU16* shortPtr = (mfxU16*)(ptr + i * pitch);
-                        for (int idx = 0; idx < w * 2; idx++) {
-                            shortPtr[idx] <<= shiftSizeLuma;
-                        }
-                    }
+                planes[nPlanes++] = { ptr, 4 * w, h, pitch };
+
+                if ((MFX_FOURCC_Y210 == pInfo.FourCC || MFX_FOURCC_Y216 == pInfo.FourCC) &&
+                    shouldShift10BitsHigh) {
+                    shiftPlanes[nShiftPlanes]  = &planes[0];
+                    shiftSizes[nShiftPlanes]   = shiftSizeLuma;
+                    shiftSamples[nShiftPlanes] = w * 2;
+                    nShiftPlanes++;
                 }
                 break;
             default:
@@ -288,79 +518,40 @@ mfxStatus CSmplYUVReader::LoadNextFrame(mfxFrameSurface1* pSurface) {
     else if (MFX_FOURCC_NV12 == pInfo.FourCC || MFX_FOURCC_YV12 == pInfo.FourCC ||
              MFX_FOURCC_P010 == pInfo.FourCC || MFX_FOURCC_P210 == pInfo.FourCC ||
              MFX_FOURCC_P016 == pInfo.FourCC || MFX_FOURCC_I010 == pInfo.FourCC ||
-             MFX_FOURCC_P016 == pInfo.FourCC || MFX_FOURCC_I010 == pInfo.FourCC ||
              MFX_FOURCC_I420 == pInfo.FourCC) {
-        pitch = pData.Pitch;
-        ptr   = pData.Y + pInfo.CropX + pInfo.CropY * pData.Pitch;
-
-        // read luminance plane
-        for (i = 0; i < h; i++) {
-            nBytesRead = (mfxU32)fread(ptr + i * pitch, nBytesPerPixel, w, m_files[vid]);
-
-            if (w != nBytesRead) {
-                return MFX_ERR_MORE_DATA;
-            }
-
-            // Shifting data if required
-            if ((MFX_FOURCC_P010 == pInfo.FourCC || MFX_FOURCC_P210 == pInfo.FourCC ||
-                 MFX_FOURCC_P016 == pInfo.FourCC) &&
-                shouldShift10BitsHigh) {
-                mfxU16* shortPtr = (mfxU16*)(ptr + i * pitch);
-                for (int idx = 0; idx < w; idx++) {
-                    shortPtr[idx] <<= shiftSizeLuma;
-                }
-            }
-        }
-
-        // read chroma planes
+        bool shiftData = (MFX_FOURCC_P010 == pInfo.FourCC || MFX_FOURCC_P210 == pInfo.FourCC ||
+                          MFX_FOURCC_P016 == pInfo.FourCC) &&
+                         shouldShift10BitsHigh;
+
+        // luminance plane
+        pitch             = pData.Pitch;
+        ptr               = pData.Y + pInfo.CropX + pInfo.CropY * pData.Pitch;
+        planes[nPlanes++] = { ptr, nBytesPerPixel * w, h, pitch };
+        if (shiftData) {
+            shiftPlanes[nShiftPlanes]  = &planes[0];
+            shiftSizes[nShiftPlanes]   = shiftSizeLuma;
+            shiftSamples[nShiftPlanes] = w;
+            nShiftPlanes++;
+        }
+
+        // chroma planes
         switch (m_ColorFormat) // color format of data in the input file
         {
             case MFX_FOURCC_I420:
             case MFX_FOURCC_YV12:
                 switch (pInfo.FourCC) {
                     case MFX_FOURCC_NV12:
-                        mfxU32 j, dstOffset[2];
+                        // both chroma planes are read to the temporary buffer and interleaved
                         w /= 2;
                         h /= 2;
-                        ptr = pData.UV + pInfo.CropX + (pInfo.CropY / 2) * pitch;
-
-                        if (m_ColorFormat == MFX_FOURCC_I420) {
-                            dstOffset[0] = 0;
-                            dstOffset[1] = 1;
-                        }
-                        else {
-                            dstOffset[0] = 1;
-                            dstOffset[1] = 0;
-                        }
-
-                        // load first chroma plane: U (input == I420) or V (input == YV12)
                         try {
-                            std::vector<mfxU8> buf(w);
-                            for (i = 0; i < h; i++) {
-                                nBytesRead = (mfxU32)fread(&buf[0], 1, w, m_files[vid]);
-                                if (w != nBytesRead) {
-                                    return MFX_ERR_MORE_DATA;
-                                }
-                                for (j = 0; j < w; j++) {
-                                    ptr[i * pitch + j * 2 + dstOffset[0]] = buf[j];
-                                }
-                            }
-
-                            // load second chroma plane: V (input == I420) or U (input == YV12)
-                            for (i = 0; i < h; i++) {
-                                nBytesRead = (mfxU32)fread(&buf[0], 1, w, m_files[vid]);
-
-                                if (w != nBytesRead) {
-                                    return MFX_ERR_MORE_DATA;
-                                }
-                                for (j = 0; j < w; j++) {
-                                    ptr[i * pitch + j * 2 + dstOffset[1]] = buf[j];
-                                }
-                            }
+                            m_convertBuffer.resize(2 * w * h);
                         }
                         catch (...) {
                             return MFX_ERR_MEMORY_ALLOC;
                         }
+                        planes[nPlanes++] = { m_convertBuffer.data(), w, 2 * h, w };
+                        interleaveChroma  = true;
                         break;
                     case MFX_FOURCC_YV12:
                     case MFX_FOURCC_I420:
@@ -376,21 +567,8 @@ mfxStatus CSmplYUVReader::LoadNextFrame(mfxFrameSurface1* pSurface) {
                             ptr  = pData.V + (pInfo.CropX / 2) + (pInfo.CropY / 2) * pitch;
                             ptr2 = pData.U + (pInfo.CropX / 2) + (pInfo.CropY / 2) * pitch;
                         }
-
-                        for (i = 0; i < h; i++) {
-                            nBytesRead = (mfxU32)fread(ptr + i * pitch, 1, w, m_files[vid]);
-
-                            if (w != nBytesRead) {
-                                return MFX_ERR_MORE_DATA;
-                            }
-                        }
-                        for (i = 0; i < h; i++) {
-                            nBytesRead = (mfxU32)fread(ptr2 + i * pitch, 1, w, m_files[vid]);
-
-                            if (w != nBytesRead) {
-                                return MFX_ERR_MORE_DATA;
-                            }
-                        }
+                        planes[nPlanes++] = { ptr, w, h, pitch };
+                        planes[nPlanes++] = { ptr2, w, h, pitch };
                         break;
                     default:
                         return MFX_ERR_UNSUPPORTED;
@@ -401,23 +579,10 @@ mfxStatus CSmplYUVReader::LoadNextFrame(mfxFrameSurface1* pSurface) {
                 h /= 2;
                 pitch /= 2;
 
-                ptr  = pData.U + (pInfo.CropX / 2) + (pInfo.CropY / 2) * pitch;
-                ptr2 = pData.V + (pInfo.CropX / 2) + (pInfo.CropY / 2) * pitch;
-
-                for (i = 0; i < h; i++) {
-                    nBytesRead = (mfxU32)fread(ptr + i * pitch, 1, w, m_files[vid]);
-
-                    if (w != nBytesRead) {
-                        return MFX_ERR_MORE_DATA;
-                    }
-                }
-                for (i = 0; i < h; i++) {
-                    nBytesRead = (mfxU32)fread(ptr2 + i * pitch, 1, w, m_files[vid]);
-
-                    if (w != nBytesRead) {
-                        return MFX_ERR_MORE_DATA;
-                    }
-                }
+                ptr               = pData.U + (pInfo.CropX / 2) + (pInfo.CropY / 2) * pitch;
+                ptr2              = pData.V + (pInfo.CropX / 2) + (pInfo.CropY / 2) * pitch;
+                planes[nPlanes++] = { ptr, w, h, pitch };
+                planes[nPlanes++] = { ptr2, w, h, pitch };
                 break;
             case MFX_FOURCC_NV12:
             case MFX_FOURCC_P010:
@@ -426,31 +591,49 @@ mfxStatus CSmplYUVReader::LoadNextFrame(mfxFrameSurface1* pSurface) {
                 if (MFX_FOURCC_P210 != pInfo.FourCC) {
                     h /= 2;
                 }
-                ptr = pData.UV + pInfo.CropX + (pInfo.CropY / 2) * pitch;
-                for (i = 0; i < h; i++) {
-                    nBytesRead = (mfxU32)fread(ptr + i * pitch, nBytesPerPixel, w, m_files[vid]);
-
-                    if (w != nBytesRead) {
-                        return MFX_ERR_MORE_DATA;
-                    }
-
-                    // Shifting data if required
-                    if ((MFX_FOURCC_P010 == pInfo.FourCC || MFX_FOURCC_P210 == pInfo.FourCC ||
-                         MFX_FOURCC_P016 == pInfo.FourCC) &&
-                        shouldShift10BitsHigh) {
-                        mfxU16* shortPtr = (mfxU16*)(ptr + i * pitch);
-                        for (int idx = 0; idx < w; idx++) {
-                            shortPtr[idx] <<= shiftSizeChroma;
-                        }
-                    }
+                ptr               = pData.UV + pInfo.CropX + (pInfo.CropY / 2) * pitch;
+                planes[nPlanes++] = { ptr, nBytesPerPixel * w, h, pitch };
+                if (shiftData) {
+                    shiftPlanes[nShiftPlanes]  = &planes[nPlanes - 1];
+                    shiftSizes[nShiftPlanes]   = shiftSizeChroma;
+                    shiftSamples[nShiftPlanes] = w;
+                    nShiftPlanes++;
                 }
-
                 break;
             default:
                 return MFX_ERR_UNSUPPORTED;
         }
     }
 
+    mfxStatus sts = ReadPlanes(vid, planes, nPlanes);
+    if (sts != MFX_ERR_NONE)
+        return sts;
+
+    const FrameKernels::KernelTable& kernels = FrameKernels::Kernels();
+
+    // Shifting data if required
+    for (mfxU32 n = 0; n < nShiftPlanes; n++) {
+        FramePlane& plane = *shiftPlanes[n];
+        for (i = 0; i < plane.Rows; i++) {
+            mfxU16* shortPtr = (mfxU16*)(plane.Data + i * plane.Pitch);
+            kernels.ShiftLeft16(shortPtr, shortPtr, shiftSamples[n], shiftSizes[n]);
+        }
+    }
+
+    if (interleaveChroma) {
+        // first chroma plane: U (input == I420) or V (input == YV12)
+        const mfxU8* first  = m_convertBuffer.data();
+        const mfxU8* second = first + w * h;
+        const mfxU8* srcU   = m_ColorFormat == MFX_FOURCC_I420 ? first : second;
+        const mfxU8* srcV   = m_ColorFormat == MFX_FOURCC_I420 ? second : first;
+
+        pitch = pData.Pitch;
+        ptr   = pData.UV + pInfo.CropX + (pInfo.CropY / 2) * pitch;
+        for (i = 0; i < h; i++) {
+            kernels.InterleaveUV(srcU + i * w, srcV + i * w, ptr + i * pitch, w);
+        }
+    }
+
     return MFX_ERR_NONE;
 }
 
@@ -459,13 +642,21 @@ CSmplBitstreamWriter::CSmplBitstreamWriter()
           m_bSkipWriting(false),
           m_fSource(NULL),
           m_bInited(false),
-          m_sFile() {}
+          m_sFile(),
+          m_asyncWriter(),
+          m_asyncParams(CAsyncFileWriter::GetDefaultParams()),
+          m_bAsyncWrite(false) {}
 
 CSmplBitstreamWriter::~CSmplBitstreamWriter() {
     Close();
 }
 
 void CSmplBitstreamWriter::Close() {
+    // Close can't return the status, the pipelines call Flush before it to check it
+    if (m_asyncWriter.IsStarted() && MFX_ERR_NONE != m_asyncWriter.Stop()) {
+        msdk_printf(MSDK_STRING("ERROR: failed to write output file %s\n"), m_sFile.c_str());
+    }
+
     if (m_fSource) {
         fclose(m_fSource);
         m_fSource = NULL;
@@ -485,6 +676,11 @@ mfxStatus CSmplBitstreamWriter::Init(const msdk_char* strFileName) {
     MSDK_FOPEN(m_fSource, strFileName, MSDK_STRING("wb+"));
     MSDK_CHECK_POINTER(m_fSource, MFX_ERR_NULL_PTR);
 
+    if (m_bAsyncWrite) {
+        mfxStatus sts = m_asyncWriter.Start(m_fSource, m_asyncParams);
+        MSDK_CHECK_STATUS(sts, "m_asyncWriter.Start failed");
+    }
+
     m_sFile = msdk_string(strFileName);
     //set init state to true in case of success
     m_bInited = true;
@@ -499,6 +695,19 @@ mfxStatus CSmplBitstreamWriter::Reset() {
     return Init(m_sFile.c_str());
 }
 
+mfxStatus CSmplBitstreamWriter::Flush() {
+    return m_asyncWriter.IsStarted() ? m_asyncWriter.Flush() : MFX_ERR_NONE;
+}
+
+mfxStatus CSmplBitstreamWriter::WriteData(const mfxU8* data, mfxU32 size) {
+    if (m_asyncWriter.IsStarted())
+        return m_asyncWriter.Write(data, size);
+
+    mfxU32 nBytesWritten = (mfxU32)fwrite(data, 1, size, m_fSource);
+    MSDK_CHECK_NOT_EQUAL(nBytesWritten, size, MFX_ERR_UNDEFINED_BEHAVIOR);
+    return MFX_ERR_NONE;
+}
+
 mfxStatus CSmplBitstreamWriter::WriteNextFrame(mfxBitstream* pMfxBitstream,
                                                bool isPrint,
                                                bool isCompleteFrame) {
@@ -510,13 +719,12 @@ mfxStatus CSmplBitstreamWriter::WriteNextFrame(mfxBitstream* pMfxBitstream,
     MSDK_CHECK_POINTER(pMfxBitstream, MFX_ERR_NULL_PTR);
 
     if (isCompleteFrame && pMfxBitstream->DataLength) {
-        mfxU32 nBytesWritten = 0;
-
-        nBytesWritten = (mfxU32)fwrite(pMfxBitstream->Data + pMfxBitstream->DataOffset,
-                                       1,
-                                       pMfxBitstream->DataLength,
-                                       m_fSource);
-        MSDK_CHECK_NOT_EQUAL(nBytesWritten, pMfxBitstream->DataLength, MFX_ERR_UNDEFINED_BEHAVIOR);
+        // with asynchronous writing the data is copied and an error of the previous writes
+        // is returned here
+        mfxStatus sts =
+            WriteData(pMfxBitstream->Data + pMfxBitstream->DataOffset, pMfxBitstream->DataLength);
+        if (MFX_ERR_NONE != sts)
+            return sts;
 
         // mark that we don't need bit stream data any more
         pMfxBitstream->DataLength = 0;
@@ -611,11 +819,48 @@ void CSmplBitstreamReader::Close() {
     m_bInited = false;
 }
 
+// 64-bit file positions for the stream index
+static int SeekFile(FILE* f, mfxU64 offset) {
+#if defined(_WIN32) || defined(_WIN64)
+    return _fseeki64(f, (__int64)offset, SEEK_SET);
+#else
+    return fseeko(f, (off_t)offset, SEEK_SET);
+#endif
+}
+
+static mfxU64 TellFile(FILE* f) {
+#if defined(_WIN32) || defined(_WIN64)
+    return (mfxU64)_ftelli64(f);
+#else
+    return (mfxU64)ftello(f);
+#endif
+}
+
 void CSmplBitstreamReader::Reset() {
     if (!m_bInited)
         return;
 
     fseek(m_fSource, 0, SEEK_SET);
+    m_seekHeaders.clear();
+}
+
+mfxStatus CSmplBitstreamReader::GetFrameInfo(FrameInfo& info) const {
+    UNREFERENCED_PARAMETER(info);
+    return MFX_ERR_UNSUPPORTED;
+}
+
+void CSmplBitstreamReader::GetHeaders(std::vector<mfxU8>& headers) {
+    headers.clear();
+}
+
+mfxStatus CSmplBitstreamReader::Seek(mfxU64 offset, const std::vector<mfxU8>& headers) {
+    if (!m_bInited)
+        return MFX_ERR_NOT_INITIALIZED;
+
+    if (SeekFile(m_fSource, offset))
+        return MFX_ERR_ABORTED;
+    m_seekHeaders = headers;
+    return MFX_ERR_NONE;
 }
 
 mfxStatus CSmplBitstreamReader::Init(const msdk_char* strFileName) {
@@ -648,10 +893,26 @@ mfxStatus CSmplBitstreamReader::ReadNextFrame(mfxBitstream* pBS) {
     if (pBS->MaxLength == pBS->DataLength)
         return MFX_ERR_NOT_ENOUGH_BUFFER;
 
-    memmove(pBS->Data, pBS->Data + pBS->DataOffset, pBS->DataLength);
-    pBS->DataOffset = 0;
-    mfxU32 nBytesRead =
-        (mfxU32)fread(pBS->Data + pBS->DataLength, 1, pBS->MaxLength - pBS->DataLength, m_fSource);
+    // the headers given to Seek precede the data of the file
+    if (!m_seekHeaders.empty()) {
+        mfxU32 size = (mfxU32)m_seekHeaders.size();
+        if (size > pBS->MaxLength - pBS->DataLength)
+            return MFX_ERR_NOT_ENOUGH_BUFFER;
+
+        CompactBitstream(pBS, size);
+        MSDK_MEMCPY(pBS->Data + pBS->DataOffset + pBS->DataLength, m_seekHeaders.data(), size);
+        pBS->DataLength += size;
+        m_seekHeaders.clear();
+        if (pBS->MaxLength == pBS->DataOffset + pBS->DataLength)
+            return MFX_ERR_NONE;
+    }
+
+    // reading into a quarter of the buffer is cheaper than moving the data
+    CompactBitstream(pBS, std::max<mfxU32>(pBS->MaxLength / 4, 1));
+    mfxU32 nBytesRead = (mfxU32)fread(pBS->Data + pBS->DataOffset + pBS->DataLength,
+                                      1,
+                                      pBS->MaxLength - pBS->DataOffset - pBS->DataLength,
+                                      m_fSource);
 
     CHECK_SET_EOS(pBS);
 
@@ -664,38 +925,145 @@ mfxStatus CSmplBitstreamReader::ReadNextFrame(mfxBitstream* pBS) {
     return MFX_ERR_NONE;
 }
 
-mfxU32 CJPEGFrameReader::FindMarker(mfxBitstream* pBS,
+void CSmplBitstreamReader::CompactBitstream(mfxBitstream* pBS, mfxU32 minTail) {
+    if (!pBS->DataOffset || pBS->MaxLength - pBS->DataOffset - pBS->DataLength >= minTail)
+        return;
+
+    memmove(pBS->Data, pBS->Data + pBS->DataOffset, pBS->DataLength);
+    pBS->DataOffset = 0;
+}
+
+CJPEGFrameReader::CJPEGFrameReader()
+        : CSmplBitstreamReader(),
+          m_nFrameStart((mfxU64)-1),
+          m_nFrameEnd(0),
+          m_nScanPos(0),
+          m_nDataStart(0),
+          m_nDataLength(0) {}
+
+mfxStatus CJPEGFrameReader::Seek(mfxU64 offset, const std::vector<mfxU8>& headers) {
+    UNREFERENCED_PARAMETER(offset);
+    UNREFERENCED_PARAMETER(headers);
+    return MFX_ERR_UNSUPPORTED;
+}
+
+void CJPEGFrameReader::Reset() {
+    CSmplBitstreamReader::Reset();
+
+    m_nFrameStart = (mfxU64)-1;
+    m_nFrameEnd   = 0;
+    m_nScanPos    = 0;
+    m_nDataStart  = 0;
+    m_nDataLength = 0;
+}
+
+mfxStatus CJPEGFrameReader::Init(const msdk_char* strFileName) {
+    m_nFrameStart = (mfxU64)-1;
+    m_nFrameEnd   = 0;
+    m_nScanPos    = 0;
+    m_nDataStart  = 0;
+    m_nDataLength = 0;
+
+    return CSmplBitstreamReader::Init(strFileName);
+}
+
+mfxU32 CJPEGFrameReader::FindMarker(const mfxU8* data,
+                                    mfxU32 size,
                                     mfxU32 startOffset,
                                     CJPEGFrameReader::JPEGMarker marker) {
-    for (mfxU32 i = startOffset; i + sizeof(mfxU16) <= pBS->DataLength; i++) {
-        if (*(mfxU16*)(pBS->Data + i) == (mfxU16)marker) {
+    // a marker is 0xFF followed by the marker code
+    const mfxU8 code = (mfxU8)(marker >> 8);
+
+    for (mfxU32 i = startOffset; i + sizeof(mfxU16) <= size; i++) {
+        const mfxU8* prefix = (const mfxU8*)memchr(data + i, 0xFF, size - 1 - i);
+        if (!prefix)
+            break;
+
+        i = (mfxU32)(prefix - data);
+        if (data[i + 1] == code)
             return i;
-        }
     }
     return 0xFFFFFFFF;
 }
 
 mfxStatus CJPEGFrameReader::ReadNextFrame(mfxBitstream* pBS) {
-    mfxStatus sts    = MFX_ERR_NONE;
-    mfxU32 offsetSOI = 0xFFFFFFFF;
+    MSDK_CHECK_POINTER(pBS, MFX_ERR_NULL_PTR);
+
+    mfxStatus sts = MFX_ERR_NONE;
 
     pBS->DataFlag = MFX_BITSTREAM_COMPLETE_FRAME;
 
-    while ((offsetSOI = FindMarker(pBS, pBS->DataOffset, CJPEGFrameReader::SOI)) == 0xFFFFFFFF &&
-           sts == MFX_ERR_NONE) {
-        sts = CSmplBitstreamReader::ReadNextFrame(pBS);
+    // The data left by the last call is still there without the bytes the caller consumed.
+    // Data added by the caller gets positions past all data seen and is scanned from the start.
+    if (pBS->DataLength <= m_nDataLength) {
+        m_nDataStart += m_nDataLength - pBS->DataLength;
     }
+    else {
+        m_nDataStart += m_nDataLength;
+        m_nFrameStart = (mfxU64)-1;
+        m_nFrameEnd   = 0;
+        m_nScanPos    = m_nDataStart;
+    }
+
+    for (;;) {
+        const mfxU64 dataStart  = m_nDataStart;
+        const mfxU8* data       = pBS->Data + pBS->DataOffset;
+        const mfxU64 frameStart = m_nFrameStart;
+
+        // start over once the frame is consumed by the caller
+        if ((frameStart != (mfxU64)-1 ? frameStart : m_nScanPos) < dataStart) {
+            m_nFrameStart = (mfxU64)-1;
+            m_nFrameEnd   = 0;
+            m_nScanPos    = dataStart;
+        }
+
+        if (m_nFrameStart == (mfxU64)-1) {
+            mfxU32 offsetSOI = FindMarker(data,
+                                          pBS->DataLength,
+                                          (mfxU32)(m_nScanPos - dataStart),
+                                          CJPEGFrameReader::SOI);
+            if (offsetSOI != 0xFFFFFFFF) {
+                m_nFrameStart = dataStart + offsetSOI;
+                m_nScanPos    = m_nFrameStart + sizeof(mfxU16);
+            }
+        }
 
-    //--- Finding EOI of frame, to make sure that it is complete
-    while (FindMarker(pBS, offsetSOI, CJPEGFrameReader::EOI) == 0xFFFFFFFF && sts == MFX_ERR_NONE) {
-        sts = CSmplBitstreamReader::ReadNextFrame(pBS);
-    }
+        //--- Finding EOI of frame, to make sure that it is complete
+        if (m_nFrameStart != (mfxU64)-1 && !m_nFrameEnd) {
+            mfxU32 offsetEOI = FindMarker(data,
+                                          pBS->DataLength,
+                                          (mfxU32)(m_nScanPos - dataStart),
+                                          CJPEGFrameReader::EOI);
+            if (offsetEOI != 0xFFFFFFFF) {
+                m_nFrameEnd = dataStart + offsetEOI + sizeof(mfxU16);
+                m_nScanPos  = m_nFrameEnd;
+            }
+        }
 
-    return sts;
+        if (m_nFrameEnd) {
+            m_nDataLength = pBS->DataLength;
+            return MFX_ERR_NONE;
+        }
+
+        // the last byte may be the first half of a marker completed by the next read
+        if (pBS->DataLength)
+            m_nScanPos = std::max(m_nScanPos, dataStart + pBS->DataLength - 1);
+
+        // the reader appends to the data, its start keeps the position
+        sts           = CSmplBitstreamReader::ReadNextFrame(pBS);
+        m_nDataLength = pBS->DataLength;
+        if (MFX_ERR_NONE != sts)
+            return sts;
+    }
 }
 
 CIVFFrameReader::CIVFFrameReader() {
     MSDK_ZERO_MEMORY(m_hdr);
+    m_bFrameHeaderRead = false;
+    m_nFrameSize       = 0;
+    m_nFrameOffset     = 0;
+    m_nFrameCount      = 0;
+    m_frameInfo        = {};
 }
 
 #define READ_BYTES(pBuf, size)                                       \
@@ -723,14 +1091,58 @@ mfxStatus CIVFFrameReader::ReadHeader() {
 
 void CIVFFrameReader::Reset() {
     CSmplBitstreamReader::Reset();
-    std::ignore = ReadHeader();
+    m_bFrameHeaderRead = false;
+    m_nFrameCount      = 0;
+    std::ignore        = ReadHeader();
+}
+
+mfxStatus CIVFFrameReader::GetFrameInfo(FrameInfo& info) const {
+    info = m_frameInfo;
+    return MFX_ERR_NONE;
+}
+
+mfxStatus CIVFFrameReader::Seek(mfxU64 offset, const std::vector<mfxU8>& headers) {
+    if (!headers.empty())
+        return MFX_ERR_UNSUPPORTED;
+
+    mfxStatus sts = CSmplBitstreamReader::Seek(offset, headers);
+    if (sts != MFX_ERR_NONE)
+        return sts;
+    m_bFrameHeaderRead = false;
+    m_nFrameCount      = 0;
+    return MFX_ERR_NONE;
+}
+
+// Key frame flags of VP8 frames (RFC 6386 9.1), the VP9 uncompressed header and AV1
+// temporal units
+static bool IsIVFKeyFrame(mfxU32 fourCC, const mfxU8* data, mfxU32 size) {
+    if (!size)
+        return false;
+
+    switch (fourCC) {
+        case MFX_MAKEFOURCC('V', 'P', '8', '0'):
+            return !(data[0] & 1);
+        case MFX_MAKEFOURCC('V', 'P', '9', '0'): {
+            // frame_marker, profile_low_bit, profile_high_bit, reserved_zero for profile 3
+            mfxU32 profile = ((data[0] >> 4) & 1) << 1 | ((data[0] >> 5) & 1);
+            mfxU32 pos     = profile == 3 ? 5 : 4;
+            // show_existing_frame, frame_type
+            return !((data[0] >> (7 - pos)) & 1) && !((data[0] >> (6 - pos)) & 1);
+        }
+        case MFX_MAKEFOURCC('A', 'V', '0', '1'):
+            return ProtectedLibrary::IsAV1KeyFrame(data, size);
+        default:
+            return false;
+    }
 }
 
 mfxStatus CIVFFrameReader::Init(const msdk_char* strFileName) {
     mfxStatus sts = CSmplBitstreamReader::Init(strFileName);
     MSDK_CHECK_STATUS(sts, "CSmplBitstreamReader::Init failed");
 
-    sts = ReadHeader();
+    m_bFrameHeaderRead = false;
+    m_nFrameCount      = 0;
+    sts                = ReadHeader();
     MSDK_CHECK_STATUS(sts, "CIVFFrameReader::ReadHeader failed");
 
     // check header
@@ -748,34 +1160,46 @@ mfxStatus CIVFFrameReader::Init(const msdk_char* strFileName) {
 mfxStatus CIVFFrameReader::ReadNextFrame(mfxBitstream* pBS) {
     MSDK_CHECK_POINTER(pBS, MFX_ERR_NULL_PTR);
 
-    memmove(pBS->Data, pBS->Data + pBS->DataOffset, pBS->DataLength);
-    pBS->DataOffset = 0;
-    pBS->DataFlag   = MFX_BITSTREAM_COMPLETE_FRAME;
+    pBS->DataFlag = MFX_BITSTREAM_COMPLETE_FRAME;
 
     /*bytes pos-(pos+3)                       size of frame in bytes (not including the 12-byte header)
       bytes (pos+4)-(pos+11)                  64-bit presentation timestamp
       bytes (pos+12)-(pos+12+nBytesInFrame)   frame data
     */
 
-    mfxU32 nBytesInFrame = 0;
-    mfxU64 nTimeStamp    = 0;
+    // the header is kept if the previous call stopped on a short bitstream
+    if (!m_bFrameHeaderRead) {
+        mfxU64 nTimeStamp = 0;
+        m_nFrameOffset    = TellFile(m_fSource);
 
-    // read frame size
-    READ_BYTES(&nBytesInFrame, sizeof(nBytesInFrame));
-    CHECK_SET_EOS(pBS);
+        // read frame size
+        READ_BYTES(&m_nFrameSize, sizeof(m_nFrameSize));
+        CHECK_SET_EOS(pBS);
 
-    // read time stamp
-    READ_BYTES(&nTimeStamp, sizeof(nTimeStamp));
-    CHECK_SET_EOS(pBS);
+        // read time stamp
+        READ_BYTES(&nTimeStamp, sizeof(nTimeStamp));
+        CHECK_SET_EOS(pBS);
+
+        m_bFrameHeaderRead = true;
+    }
 
     //check if bitstream has enough space to hold the frame
-    if (nBytesInFrame > pBS->MaxLength - pBS->DataLength - pBS->DataOffset)
+    if (m_nFrameSize > pBS->MaxLength - pBS->DataLength)
         return MFX_ERR_NOT_ENOUGH_BUFFER;
 
+    CompactBitstream(pBS, m_nFrameSize);
+
     // read frame data
-    READ_BYTES(pBS->Data + pBS->DataOffset + pBS->DataLength, nBytesInFrame);
+    m_bFrameHeaderRead = false;
+    READ_BYTES(pBS->Data + pBS->DataOffset + pBS->DataLength, m_nFrameSize);
     CHECK_SET_EOS(pBS);
-    pBS->DataLength += nBytesInFrame;
+
+    m_frameInfo.Offset      = m_nFrameOffset;
+    m_frameInfo.PicOrderCnt = (mfxI32)m_nFrameCount++;
+    m_frameInfo.KeyFrame    = IsIVFKeyFrame(m_hdr.codec_FourCC,
+                                         pBS->Data + pBS->DataOffset + pBS->DataLength,
+                                         m_nFrameSize);
+    pBS->DataLength += m_nFrameSize;
 
     // it is application's responsibility to make sure the bitstream contains a single complete frame and nothing else
     // application has to provide input pBS with pBS->DataLength = 0
@@ -790,16 +1214,14 @@ CIVFFrameWriter::CIVFFrameWriter() {
 }
 
 mfxStatus CIVFFrameWriter::WriteStreamHeader() {
-    mfxU32 nBytesWritten = (mfxU32)fwrite(&m_streamHeader, 1, sizeof(m_streamHeader), m_fSource);
-    if (nBytesWritten != sizeof(m_streamHeader))
+    if (MFX_ERR_NONE != WriteData((const mfxU8*)&m_streamHeader, sizeof(m_streamHeader)))
         return MFX_ERR_MORE_BITSTREAM;
 
     return MFX_ERR_NONE;
 }
 
 mfxStatus CIVFFrameWriter::WriteFrameHeader() {
-    mfxU32 nBytesWritten = (mfxU32)fwrite(&m_frameHeader, 1, sizeof(m_frameHeader), m_fSource);
-    if (nBytesWritten != sizeof(m_frameHeader))
+    if (MFX_ERR_NONE != WriteData((const mfxU8*)&m_frameHeader, sizeof(m_frameHeader)))
         return MFX_ERR_MORE_BITSTREAM;
 
     return MFX_ERR_NONE;
@@ -807,6 +1229,8 @@ mfxStatus CIVFFrameWriter::WriteFrameHeader() {
 
 void CIVFFrameWriter::UpdateNumberOfFrames() {
     if (m_fSource) {
+        // the header is patched in place, queued frames must be in the file before seeking
+        Flush();
         fseek(m_fSource, 24, SEEK_SET);
         fwrite(&m_frameNum, 1, sizeof(mfxU32), m_fSource);
     }
@@ -871,6 +1295,7 @@ void CIVFFrameWriter::Close() {
 CSmplYUVWriter::CSmplYUVWriter()
         : m_fDest(NULL),
           m_fDestMVC(NULL),
+          m_convertBuffer(),
           m_bInited(false),
           m_bIsMultiView(false),
           m_numCreatedFiles(0),
@@ -1006,6 +1431,14 @@ mfxStatus GetChromaSize(const mfxFrameInfo& pInfo, mfxU32& ChromaW, mfxU32& Chro
     return MFX_ERR_NONE;
 }
 
+FILE* CSmplYUVWriter::GetDestFile(mfxU32 vid) {
+    if (!m_bIsMultiView)
+        return m_fDest;
+    if (!m_fDestMVC || vid >= m_numCreatedFiles)
+        return NULL;
+    return m_fDestMVC[vid];
+}
+
 mfxStatus CSmplYUVWriter::WriteNextFrame(mfxFrameSurface1* pSurface) {
     MSDK_CHECK_ERROR(m_bInited, false, MFX_ERR_NOT_INITIALIZED);
     MSDK_CHECK_POINTER(pSurface, MFX_ERR_NULL_PTR);
@@ -1013,151 +1446,124 @@ mfxStatus CSmplYUVWriter::WriteNextFrame(mfxFrameSurface1* pSurface) {
     mfxFrameInfo& pInfo = pSurface->Info;
     mfxFrameData& pData = pSurface->Data;
 
-    mfxU32 i;
     mfxU32 vid = pInfo.FrameId.ViewId;
 
     mfxU32 shiftSizeLuma   = 16 - pInfo.BitDepthLuma;
     mfxU32 shiftSizeChroma = 16 - pInfo.BitDepthChroma;
-    // Temporary buffer to convert MS to no-MS format
-    std::vector<mfxU16> tmp;
-
-    if (!m_bIsMultiView) {
-        MSDK_CHECK_POINTER(m_fDest, MFX_ERR_NULL_PTR);
-    }
-    else {
-        MSDK_CHECK_POINTER(m_fDestMVC, MFX_ERR_NULL_PTR);
-        MSDK_CHECK_POINTER(m_fDestMVC[vid], MFX_ERR_NULL_PTR);
-    }
 
-    FILE* dstFile = m_bIsMultiView ? m_fDestMVC[vid] : m_fDest;
+    FILE* dstFile = GetDestFile(vid);
+    MSDK_CHECK_POINTER(dstFile, MFX_ERR_NULL_PTR);
 
     mfxU32 ChromaW, ChromaH;
     if (MFX_ERR_NONE != GetChromaSize(pInfo, ChromaW, ChromaH))
         return MFX_ERR_UNSUPPORTED;
 
+    // Planes of the frame in the order they are written to the file
+    FramePlane planes[3] = {};
+    mfxU32 nPlanes       = 0;
+
+    mfxU32 cropW = pInfo.CropW;
+    mfxU32 cropH = pInfo.CropH;
+    mfxU32 pitch = pData.Pitch;
+
+    // Temporary buffer to convert MS to no-MS format
+    mfxU16* tmp = NULL;
+    if (pInfo.Shift) {
+        size_t samples = 0;
+        switch (pInfo.FourCC) {
+            case MFX_FOURCC_Y210:
+            case MFX_FOURCC_Y216:
+                samples = (size_t)cropW * 2 * cropH;
+                break;
+#if (MFX_VERSION >= MFX_VERSION_NEXT)
+            case MFX_FOURCC_Y416:
+                samples = (size_t)cropW * 4 * cropH;
+                break;
+            case MFX_FOURCC_P016:
+#endif
+            case MFX_FOURCC_P010:
+            case MFX_FOURCC_P210:
+                samples = (size_t)cropW * cropH + (size_t)ChromaW * ChromaH;
+                break;
+            default:
+                break;
+        }
+        if (samples) {
+            try {
+                m_convertBuffer.resize(samples * sizeof(mfxU16));
+            }
+            catch (...) {
+                return MFX_ERR_MEMORY_ALLOC;
+            }
+            tmp = (mfxU16*)m_convertBuffer.data();
+        }
+    }
+
     switch (pInfo.FourCC) {
         case MFX_FOURCC_YV12:
         case MFX_FOURCC_NV12:
         case MFX_FOURCC_I420:
         case MFX_FOURCC_I422:
         case MFX_FOURCC_NV16:
-            for (i = 0; i < pInfo.CropH; i++) {
-                MSDK_CHECK_NOT_EQUAL(
-                    fwrite(pData.Y + (pInfo.CropY * pData.Pitch + pInfo.CropX) + i * pData.Pitch,
-                           1,
-                           pInfo.CropW,
-                           dstFile),
-                    pInfo.CropW,
-                    MFX_ERR_UNDEFINED_BEHAVIOR);
-            }
+            planes[nPlanes++] = { pData.Y + (pInfo.CropY * pitch + pInfo.CropX), cropW, cropH, pitch };
             break;
         case MFX_FOURCC_Y210:
         case MFX_FOURCC_Y216: // Luma and chroma will be filled below
         {
-            for (i = 0; i < pInfo.CropH; i++) {
-                mfxU8* pBuffer = ((mfxU8*)pData.Y) + (pInfo.CropY * pData.Pitch + pInfo.CropX * 4) +
-                                 i * pData.Pitch;
-                if (pInfo.Shift) {
-                    // Bits will be shifted to the lower position
-                    tmp.resize(pInfo.CropW * 2);
-
-                    for (int idx = 0; idx < pInfo.CropW * 2; idx++) {
-                        tmp[idx] = ((mfxU16*)pBuffer)[idx] >> shiftSizeLuma;
-                    }
-
-                    MSDK_CHECK_NOT_EQUAL(
-                        fwrite(((const mfxU8*)tmp.data()), 4, pInfo.CropW, dstFile),
-                        pInfo.CropW,
-                        MFX_ERR_UNDEFINED_BEHAVIOR);
-                }
-                else {
-                    MSDK_CHECK_NOT_EQUAL(fwrite(pBuffer, 4, pInfo.CropW, dstFile),
-                                         pInfo.CropW,
-                                         MFX_ERR_UNDEFINED_BEHAVIOR);
-                }
+            mfxU8* pBuffer = ((mfxU8*)pData.Y) + (pInfo.CropY * pitch + pInfo.CropX * 4);
+            if (tmp) {
+                // Bits will be shifted to the lower position
+                ShiftRowsLow(pBuffer, pitch, cropW * 2, cropH, shiftSizeLuma, tmp);
+                planes[nPlanes++] = { (mfxU8*)tmp, 4 * cropW, cropH, 4 * cropW };
             }
-            return MFX_ERR_NONE;
+            else {
+                planes[nPlanes++] = { pBuffer, 4 * cropW, cropH, pitch };
+            }
+            return WriteFramePlanes(dstFile, planes, nPlanes);
         } break;
         case MFX_FOURCC_Y410: // Luma and chroma will be filled below
         {
-            mfxU8* pBuffer = (mfxU8*)pData.Y410;
-            for (i = 0; i < pInfo.CropH; i++) {
-                MSDK_CHECK_NOT_EQUAL(
-                    fwrite(
-                        pBuffer + (pInfo.CropY * pData.Pitch + pInfo.CropX * 4) + i * pData.Pitch,
-                        4,
-                        pInfo.CropW,
-                        dstFile),
-                    pInfo.CropW,
-                    MFX_ERR_UNDEFINED_BEHAVIOR);
-            }
-            return MFX_ERR_NONE;
+            mfxU8* pBuffer    = (mfxU8*)pData.Y410 + (pInfo.CropY * pitch + pInfo.CropX * 4);
+            planes[nPlanes++] = { pBuffer, 4 * cropW, cropH, pitch };
+            return WriteFramePlanes(dstFile, planes, nPlanes);
         } break;
 #if (MFX_VERSION >= MFX_VERSION_NEXT)
         case MFX_FOURCC_Y416: // Luma and chroma will be filled below
         {
-            for (i = 0; i < pInfo.CropH; i++) {
-                mfxU8* pBuffer = ((mfxU8*)pData.U) + (pInfo.CropY * pData.Pitch + pInfo.CropX * 8) +
-                                 i * pData.Pitch;
-                if (pInfo.Shift) {
-                    tmp.resize(pInfo.CropW * 4);
-
-                    for (int idx = 0; idx < pInfo.CropW * 4; idx++) {
-                        tmp[idx] = ((mfxU16*)pBuffer)[idx] >> shiftSizeLuma;
-                    }
-
-                    MSDK_CHECK_NOT_EQUAL(
-                        fwrite(((const mfxU8*)tmp.data()), 8, pInfo.CropW, dstFile),
-                        pInfo.CropW,
-                        MFX_ERR_UNDEFINED_BEHAVIOR);
-                }
-                else {
-                    MSDK_CHECK_NOT_EQUAL(fwrite(pBuffer, 8, pInfo.CropW, dstFile),
-                                         pInfo.CropW,
-                                         MFX_ERR_UNDEFINED_BEHAVIOR);
-                }
+            mfxU8* pBuffer = ((mfxU8*)pData.U) + (pInfo.CropY * pitch + pInfo.CropX * 8);
+            if (tmp) {
+                ShiftRowsLow(pBuffer, pitch, cropW * 4, cropH, shiftSizeLuma, tmp);
+                planes[nPlanes++] = { (mfxU8*)tmp, 8 * cropW, cropH, 8 * cropW };
             }
-            return MFX_ERR_NONE;
+            else {
+                planes[nPlanes++] = { pBuffer, 8 * cropW, cropH, pitch };
+            }
+            return WriteFramePlanes(dstFile, planes, nPlanes);
         } break;
 #endif
         case MFX_FOURCC_I010:
         case MFX_FOURCC_I210:
-            for (i = 0; i < pInfo.CropH; i++) {
-                mfxU16* shortPtr = (mfxU16*)(pData.Y + (pInfo.CropY * pData.Pitch + pInfo.CropX) +
-                                             i * pData.Pitch);
-                MSDK_CHECK_NOT_EQUAL(fwrite(shortPtr, 1, (mfxU32)pInfo.CropW * 2, dstFile),
-                                     (mfxU32)pInfo.CropW * 2,
-                                     MFX_ERR_UNDEFINED_BEHAVIOR);
-            }
+            planes[nPlanes++] = { pData.Y + (pInfo.CropY * pitch + pInfo.CropX),
+                                  cropW * 2,
+                                  cropH,
+                                  pitch };
             break;
         case MFX_FOURCC_P010:
 #if (MFX_VERSION >= MFX_VERSION_NEXT)
         case MFX_FOURCC_P016:
 #endif
         case MFX_FOURCC_P210: {
-            for (i = 0; i < pInfo.CropH; i++) {
-                mfxU16* shortPtr = (mfxU16*)(pData.Y + (pInfo.CropY * pData.Pitch + pInfo.CropX) +
-                                             i * pData.Pitch);
-                if (pInfo.Shift) {
-                    // Convert MS-P*1* to P*1* and write
-                    // Bits will be shifted to the lower position
-                    tmp.resize(pData.Pitch);
-
-                    for (int idx = 0; idx < pInfo.CropW; idx++) {
-                        tmp[idx] = shortPtr[idx] >> shiftSizeLuma;
-                    }
-
-                    MSDK_CHECK_NOT_EQUAL(fwrite(&tmp[0], 1, (mfxU32)pInfo.CropW * 2, dstFile),
-                                         (mfxU32)pInfo.CropW * 2,
-                                         MFX_ERR_UNDEFINED_BEHAVIOR);
-                }
-                else {
-                    MSDK_CHECK_NOT_EQUAL(fwrite(shortPtr, 1, (mfxU32)pInfo.CropW * 2, dstFile),
-                                         (mfxU32)pInfo.CropW * 2,
-                                         MFX_ERR_UNDEFINED_BEHAVIOR);
-                }
+            mfxU8* pBuffer = pData.Y + (pInfo.CropY * pitch + pInfo.CropX);
+            if (tmp) {
+                // Convert MS-P*1* to P*1* and write
+                // Bits will be shifted to the lower position
+                ShiftRowsLow(pBuffer, pitch, cropW, cropH, shiftSizeLuma, tmp);
+                planes[nPlanes++] = { (mfxU8*)tmp, cropW * 2, cropH, cropW * 2 };
+                tmp += (size_t)cropW * cropH;
+            }
+            else {
+                planes[nPlanes++] = { pBuffer, cropW * 2, cropH, pitch };
             }
-
             break;
         }
         case MFX_FOURCC_RGB4:
@@ -1170,97 +1576,54 @@ mfxStatus CSmplYUVWriter::WriteNextFrame(mfxFrameSurface1* pSurface) {
         default:
             return MFX_ERR_UNSUPPORTED;
     }
+
+    mfxStatus sts = MFX_ERR_NONE;
     switch (pInfo.FourCC) {
         case MFX_FOURCC_YV12: {
-            for (i = 0; i < ChromaH; i++) {
-                MSDK_CHECK_NOT_EQUAL(
-                    fwrite(pData.V + (pInfo.CropY * pData.Pitch / 2 + pInfo.CropX / 2) +
-                               i * pData.Pitch,
-                           1,
-                           ChromaW,
-                           dstFile),
-                    ChromaW,
-                    MFX_ERR_UNDEFINED_BEHAVIOR);
-            }
-            for (i = 0; i < ChromaH; i++) {
-                MSDK_CHECK_NOT_EQUAL(
-                    fwrite(pData.U + (pInfo.CropY * pData.Pitch / 2 + pInfo.CropX / 2) +
-                               i * pData.Pitch / 2,
-                           1,
-                           ChromaW,
-                           dstFile),
-                    ChromaW,
-                    MFX_ERR_UNDEFINED_BEHAVIOR);
-            }
+            // V plane rows are written with the luma pitch
+            planes[nPlanes++] = { pData.V + (pInfo.CropY * pitch / 2 + pInfo.CropX / 2),
+                                  ChromaW,
+                                  ChromaH,
+                                  pitch };
+            planes[nPlanes++] = { pData.U + (pInfo.CropY * pitch / 2 + pInfo.CropX / 2),
+                                  ChromaW,
+                                  ChromaH,
+                                  pitch / 2 };
             break;
         }
         case MFX_FOURCC_I420:
         case MFX_FOURCC_I422: {
-            for (i = 0; i < ChromaH; i++) {
-                MSDK_CHECK_NOT_EQUAL(
-                    fwrite(pData.U + (pInfo.CropY * pData.Pitch / 2 + pInfo.CropX / 2) +
-                               i * pData.Pitch / 2,
-                           1,
-                           ChromaW,
-                           dstFile),
-                    ChromaW,
-                    MFX_ERR_UNDEFINED_BEHAVIOR);
-            }
-            for (i = 0; i < ChromaH; i++) {
-                MSDK_CHECK_NOT_EQUAL(
-                    fwrite(pData.V + (pInfo.CropY * pData.Pitch / 2 + pInfo.CropX / 2) +
-                               i * pData.Pitch / 2,
-                           1,
-                           ChromaW,
-                           dstFile),
-                    ChromaW,
-                    MFX_ERR_UNDEFINED_BEHAVIOR);
-            }
+            planes[nPlanes++] = { pData.U + (pInfo.CropY * pitch / 2 + pInfo.CropX / 2),
+                                  ChromaW,
+                                  ChromaH,
+                                  pitch / 2 };
+            planes[nPlanes++] = { pData.V + (pInfo.CropY * pitch / 2 + pInfo.CropX / 2),
+                                  ChromaW,
+                                  ChromaH,
+                                  pitch / 2 };
             break;
         }
         case MFX_FOURCC_NV12: {
-            for (i = 0; i < ChromaH; i++) {
-                MSDK_CHECK_NOT_EQUAL(
-                    fwrite(pData.UV + (pInfo.CropY * pData.Pitch + pInfo.CropX) + i * pData.Pitch,
-                           1,
-                           ChromaW,
-                           dstFile),
-                    ChromaW,
-                    MFX_ERR_UNDEFINED_BEHAVIOR);
-            }
+            planes[nPlanes++] = { pData.UV + (pInfo.CropY * pitch + pInfo.CropX),
+                                  ChromaW,
+                                  ChromaH,
+                                  pitch };
             break;
         }
         case MFX_FOURCC_NV16: {
-            for (i = 0; i < ChromaH; i++) {
-                MSDK_CHECK_NOT_EQUAL(
-                    fwrite(
-                        pData.UV + (pInfo.CropY * pData.Pitch / 2 + pInfo.CropX) + i * pData.Pitch,
-                        1,
-                        ChromaW,
-                        dstFile),
-                    ChromaW,
-                    MFX_ERR_UNDEFINED_BEHAVIOR);
-            }
+            planes[nPlanes++] = { pData.UV + (pInfo.CropY * pitch / 2 + pInfo.CropX),
+                                  ChromaW,
+                                  ChromaH,
+                                  pitch };
             break;
         }
         case MFX_FOURCC_I010:
         case MFX_FOURCC_I210: {
-            mfxU16 chPitch = pData.Pitch / 2;
+            mfxU32 chPitch = pitch / 2;
             mfxU32 basePtr = (pInfo.CropY * chPitch + pInfo.CropX / 2);
 
-            for (i = 0; i < ChromaH; i++) {
-                MSDK_CHECK_NOT_EQUAL(fwrite(pData.U + basePtr + i * chPitch, 1, ChromaW, dstFile),
-                                     ChromaW,
-                                     MFX_ERR_UNDEFINED_BEHAVIOR);
-            }
-
-            basePtr = (pInfo.CropY * chPitch + pInfo.CropX / 2);
-
-            for (i = 0; i < ChromaH; i++) {
-                MSDK_CHECK_NOT_EQUAL(fwrite(pData.V + basePtr + i * chPitch, 1, ChromaW, dstFile),
-                                     ChromaW,
-                                     MFX_ERR_UNDEFINED_BEHAVIOR);
-            }
+            planes[nPlanes++] = { pData.U + basePtr, ChromaW, ChromaH, chPitch };
+            planes[nPlanes++] = { pData.V + basePtr, ChromaW, ChromaH, chPitch };
             break;
         }
         case MFX_FOURCC_P010:
@@ -1268,28 +1631,15 @@ mfxStatus CSmplYUVWriter::WriteNextFrame(mfxFrameSurface1* pSurface) {
         case MFX_FOURCC_P016:
 #endif
         case MFX_FOURCC_P210: {
-            for (i = 0; i < ChromaH; i++) {
-                mfxU16* shortPtr =
-                    (mfxU16*)(pData.UV + (pInfo.CropY * pData.Pitch + pInfo.CropX * 2) +
-                              i * pData.Pitch);
-                if (pInfo.Shift) {
-                    // Convert MS-P*1* to P*1* and write
-                    // Bits will be shifted to the lower position
-                    tmp.resize(pData.Pitch);
-
-                    for (mfxU32 idx = 0; idx < ChromaW; idx++) {
-                        tmp[idx] = shortPtr[idx] >> shiftSizeChroma;
-                    }
-
-                    MSDK_CHECK_NOT_EQUAL(fwrite(&tmp[0], 1, ChromaW * 2, dstFile),
-                                         (mfxU32)ChromaW * 2,
-                                         MFX_ERR_UNDEFINED_BEHAVIOR);
-                }
-                else {
-                    MSDK_CHECK_NOT_EQUAL(fwrite(shortPtr, 1, ChromaW * 2, dstFile),
-                                         ChromaW * 2,
-                                         MFX_ERR_UNDEFINED_BEHAVIOR);
-                }
+            mfxU8* pBuffer = pData.UV + (pInfo.CropY * pitch + pInfo.CropX * 2);
+            if (tmp) {
+                // Convert MS-P*1* to P*1* and write
+                // Bits will be shifted to the lower position
+                ShiftRowsLow(pBuffer, pitch, ChromaW, ChromaH, shiftSizeChroma, tmp);
+                planes[nPlanes++] = { (mfxU8*)tmp, ChromaW * 2, ChromaH, ChromaW * 2 };
+            }
+            else {
+                planes[nPlanes++] = { pBuffer, ChromaW * 2, ChromaH, pitch };
             }
             break;
         }
@@ -1300,22 +1650,19 @@ mfxStatus CSmplYUVWriter::WriteNextFrame(mfxFrameSurface1* pSurface) {
         case MFX_FOURCC_A2RGB10: {
             mfxU8* ptr;
             ptr = std::min({ pData.R, pData.G, pData.B });
-            ptr = ptr + pInfo.CropX + pInfo.CropY * pData.Pitch;
+            ptr = ptr + pInfo.CropX + pInfo.CropY * pitch;
 
-            for (i = 0; i < ChromaH; i++) {
-                MSDK_CHECK_NOT_EQUAL(fwrite(ptr + i * pData.Pitch, 1, 4 * ChromaW, dstFile),
-                                     4 * ChromaW,
-                                     MFX_ERR_UNDEFINED_BEHAVIOR);
-            }
+            planes[nPlanes++] = { ptr, 4 * ChromaW, ChromaH, pitch };
+            sts               = WriteFramePlanes(dstFile, planes, nPlanes);
             fflush(dstFile);
-            break;
+            return sts;
         }
 
         default:
             return MFX_ERR_UNSUPPORTED;
     }
 
-    return MFX_ERR_NONE;
+    return WriteFramePlanes(dstFile, planes, nPlanes);
 }
 
 mfxStatus CSmplYUVWriter::WriteNextFrameI420(mfxFrameSurface1* pSurface) {
@@ -1325,162 +1672,77 @@ mfxStatus CSmplYUVWriter::WriteNextFrameI420(mfxFrameSurface1* pSurface) {
     mfxFrameInfo& pInfo = pSurface->Info;
     mfxFrameData& pData = pSurface->Data;
 
-    mfxU32 i, j;
+    mfxU32 i;
     mfxU32 vid = pInfo.FrameId.ViewId;
 
-    if (!m_bIsMultiView) {
-        MSDK_CHECK_POINTER(m_fDest, MFX_ERR_NULL_PTR);
-    }
-    else {
-        MSDK_CHECK_POINTER(m_fDestMVC, MFX_ERR_NULL_PTR);
-        MSDK_CHECK_POINTER(m_fDestMVC[vid], MFX_ERR_NULL_PTR);
-    }
+    FILE* dstFile = GetDestFile(vid);
+    MSDK_CHECK_POINTER(dstFile, MFX_ERR_NULL_PTR);
 
     mfxU32 ChromaW, ChromaH;
     if (MFX_ERR_NONE != GetChromaSize(pInfo, ChromaW, ChromaH))
         return MFX_ERR_UNSUPPORTED;
 
-    // Write Y
-    switch (pInfo.FourCC) {
-        case MFX_FOURCC_YV12:
-        case MFX_FOURCC_NV12: {
-            for (i = 0; i < pInfo.CropH; i++) {
-                if (!m_bIsMultiView) {
-                    MSDK_CHECK_NOT_EQUAL(
-                        fwrite(
-                            pData.Y + (pInfo.CropY * pData.Pitch + pInfo.CropX) + i * pData.Pitch,
-                            1,
-                            pInfo.CropW,
-                            m_fDest),
-                        pInfo.CropW,
-                        MFX_ERR_UNDEFINED_BEHAVIOR);
-                }
-                else {
-                    MSDK_CHECK_NOT_EQUAL(
-                        fwrite(
-                            pData.Y + (pInfo.CropY * pData.Pitch + pInfo.CropX) + i * pData.Pitch,
-                            1,
-                            pInfo.CropW,
-                            m_fDestMVC[vid]),
-                        pInfo.CropW,
-                        MFX_ERR_UNDEFINED_BEHAVIOR);
-                }
-            }
-            break;
-        }
-        default: {
-            msdk_printf(MSDK_STRING("ERROR: I420 output is accessible only for NV12 and YV12.\n"));
-            return MFX_ERR_UNSUPPORTED;
-        }
+    if (pInfo.FourCC != MFX_FOURCC_YV12 && pInfo.FourCC != MFX_FOURCC_NV12) {
+        msdk_printf(MSDK_STRING("ERROR: I420 output is accessible only for NV12 and YV12.\n"));
+        return MFX_ERR_UNSUPPORTED;
     }
 
+    mfxU32 pitch = pData.Pitch;
+
+    // Write Y
+    FramePlane planes[3] = {};
+    mfxU32 nPlanes       = 0;
+    planes[nPlanes++]    = { pData.Y + (pInfo.CropY * pitch + pInfo.CropX),
+                          pInfo.CropW,
+                          pInfo.CropH,
+                          pitch };
+
     // Write U and V
     switch (pInfo.FourCC) {
         case MFX_FOURCC_YV12: {
-            for (i = 0; i < ChromaH; i++) {
-                if (!m_bIsMultiView) {
-                    MSDK_CHECK_NOT_EQUAL(
-                        fwrite(pData.U + (pInfo.CropY * pData.Pitch / 2 + pInfo.CropX / 2) +
-                                   i * pData.Pitch / 2,
-                               1,
-                               ChromaW,
-                               m_fDest),
-                        (mfxU32)pInfo.CropW / 2,
-                        MFX_ERR_UNDEFINED_BEHAVIOR);
-                }
-                else {
-                    MSDK_CHECK_NOT_EQUAL(
-                        fwrite(pData.U + (pInfo.CropY * pData.Pitch / 2 + pInfo.CropX / 2) +
-                                   i * pData.Pitch / 2,
-                               1,
-                               ChromaW,
-                               m_fDestMVC[vid]),
-                        (mfxU32)pInfo.CropW / 2,
-                        MFX_ERR_UNDEFINED_BEHAVIOR);
-                }
-            }
-            for (i = 0; i < ChromaH; i++) {
-                if (!m_bIsMultiView) {
-                    MSDK_CHECK_NOT_EQUAL(
-                        fwrite(pData.V + (pInfo.CropY * pData.Pitch / 2 + pInfo.CropX / 2) +
-                                   i * pData.Pitch / 2,
-                               1,
-                               ChromaW,
-                               m_fDest),
-                        (mfxU32)pInfo.CropW / 2,
-                        MFX_ERR_UNDEFINED_BEHAVIOR);
-                }
-                else {
-                    MSDK_CHECK_NOT_EQUAL(
-                        fwrite(pData.V + (pInfo.CropY * pData.Pitch / 2 + pInfo.CropX / 2) +
-                                   i * pData.Pitch / 2,
-                               1,
-                               ChromaW,
-                               m_fDestMVC[vid]),
-                        (mfxU32)pInfo.CropW / 2,
-                        MFX_ERR_UNDEFINED_BEHAVIOR);
-                }
-            }
+            planes[nPlanes++] = { pData.U + (pInfo.CropY * pitch / 2 + pInfo.CropX / 2),
+                                  ChromaW,
+                                  ChromaH,
+                                  pitch / 2 };
+            planes[nPlanes++] = { pData.V + (pInfo.CropY * pitch / 2 + pInfo.CropX / 2),
+                                  ChromaW,
+                                  ChromaH,
+                                  pitch / 2 };
             break;
         }
         case MFX_FOURCC_NV12: {
-            for (i = 0; i < ChromaH; i++) {
-                for (j = 0; j < ChromaW; j += 2) {
-                    if (!m_bIsMultiView) {
-                        MSDK_CHECK_NOT_EQUAL(
-                            fwrite(pData.UV + (pInfo.CropY * pData.Pitch / 2 + pInfo.CropX) +
-                                       i * pData.Pitch + j,
-                                   1,
-                                   1,
-                                   m_fDest),
-                            1,
-                            MFX_ERR_UNDEFINED_BEHAVIOR);
-                    }
-                    else {
-                        MSDK_CHECK_NOT_EQUAL(
-                            fwrite(pData.UV + (pInfo.CropY * pData.Pitch / 2 + pInfo.CropX) +
-                                       i * pData.Pitch + j,
-                                   1,
-                                   1,
-                                   m_fDestMVC[vid]),
-                            1,
-                            MFX_ERR_UNDEFINED_BEHAVIOR);
-                    }
-                }
+            // deinterleave chroma to the temporary buffer: U rows followed by V rows
+            mfxU32 uSize = (ChromaW + 1) / 2;
+            mfxU32 vSize = ChromaW / 2;
+            try {
+                m_convertBuffer.resize((size_t)(uSize + vSize) * ChromaH);
+            }
+            catch (...) {
+                return MFX_ERR_MEMORY_ALLOC;
             }
+            const FrameKernels::KernelTable& kernels = FrameKernels::Kernels();
+
+            mfxU8* pU = m_convertBuffer.data();
+            mfxU8* pV = pU + (size_t)uSize * ChromaH;
             for (i = 0; i < ChromaH; i++) {
-                for (j = 1; j < ChromaW; j += 2) {
-                    if (!m_bIsMultiView) {
-                        MSDK_CHECK_NOT_EQUAL(
-                            fwrite(pData.UV + (pInfo.CropY * pData.Pitch / 2 + pInfo.CropX) +
-                                       i * pData.Pitch + j,
-                                   1,
-                                   1,
-                                   m_fDest),
-                            1,
-                            MFX_ERR_UNDEFINED_BEHAVIOR);
-                    }
-                    else {
-                        MSDK_CHECK_NOT_EQUAL(
-                            fwrite(pData.UV + (pInfo.CropY * pData.Pitch / 2 + pInfo.CropX) +
-                                       i * pData.Pitch + j,
-                                   1,
-                                   1,
-                                   m_fDestMVC[vid]),
-                            1,
-                            MFX_ERR_UNDEFINED_BEHAVIOR);
-                    }
-                }
+                const mfxU8* src = pData.UV + (pInfo.CropY * pitch / 2 + pInfo.CropX) + i * pitch;
+                kernels.DeinterleaveUV(src, pU, pV, vSize);
+                if (uSize > vSize)
+                    pU[vSize] = src[2 * vSize];
+                pU += uSize;
+                pV += vSize;
             }
+            planes[nPlanes++] = { m_convertBuffer.data(),
+                                  (uSize + vSize) * ChromaH,
+                                  1,
+                                  (uSize + vSize) * ChromaH };
             break;
         }
-        default: {
-            msdk_printf(MSDK_STRING("ERROR: I420 output is accessible only for NV12 and YV12.\n"));
-            return MFX_ERR_UNSUPPORTED;
-        }
+        default:
+            break;
     }
 
-    return MFX_ERR_NONE;
+    return WriteFramePlanes(dstFile, planes, nPlanes);
 }
 
 void QPFile::Reader::ResetState() {
@@ -2462,32 +2724,81 @@ mfxI32 getMonitorType(msdk_char* str) {
     return MFX_MONITOR_MAXNUMBER;
 }
 
-CH264FrameReader::CH264FrameReader()
+CSplitterFrameReader::CSplitterFrameReader(mfxU32 codecId)
         : CSmplBitstreamReader(),
           m_processedBS(0),
           m_originalBS(),
           m_isEndOfStream(false),
+          m_codecId(codecId),
           m_pNALSplitter(),
           m_frame(0),
-          m_plainBuffer(0),
-          m_plainBufferSize(0),
-          m_outBS() {}
+          m_outBS(),
+          m_seekOffset(0),
+          m_seekHeadersSize(0),
+          m_frameInfo() {}
 
-CH264FrameReader::~CH264FrameReader() {}
+CSplitterFrameReader::~CSplitterFrameReader() {}
 
-void CH264FrameReader::Close() {
-    CSmplBitstreamReader::Close();
+void CSplitterFrameReader::Reset() {
+    CSmplBitstreamReader::Reset();
 
-    if (NULL != m_plainBuffer) {
-        free(m_plainBuffer);
-        m_plainBuffer     = NULL;
-        m_plainBufferSize = 0;
+    m_originalBS.DataOffset = 0;
+    m_originalBS.DataLength = 0;
+    m_originalBS.DataFlag   = 0;
+    m_isEndOfStream         = false;
+    m_processedBS           = NULL;
+    m_frame                 = NULL;
+    m_seekOffset            = 0;
+    m_seekHeadersSize       = 0;
+    if (m_pNALSplitter) {
+        m_pNALSplitter->Reset();
+        m_pNALSplitter->ResetCurrentState();
     }
 }
 
-mfxStatus CH264FrameReader::Init(const msdk_char* strFileName) {
+mfxStatus CSplitterFrameReader::GetFrameInfo(FrameInfo& info) const {
+    info = m_frameInfo;
+    return MFX_ERR_NONE;
+}
+
+void CSplitterFrameReader::GetHeaders(std::vector<mfxU8>& headers) {
+    if (m_pNALSplitter)
+        m_pNALSplitter->GetHeaders(headers);
+    else
+        headers.clear();
+}
+
+mfxStatus CSplitterFrameReader::Seek(mfxU64 offset, const std::vector<mfxU8>& headers) {
+    if (!m_pNALSplitter)
+        return MFX_ERR_NOT_INITIALIZED;
+
+    Reset();
+    mfxStatus sts = CSmplBitstreamReader::Seek(offset, headers);
+    if (sts != MFX_ERR_NONE)
+        return sts;
+
+    m_seekOffset      = offset;
+    m_seekHeadersSize = headers.size();
+    return MFX_ERR_NONE;
+}
+
+mfxStatus CSplitterFrameReader::Init(const msdk_char* strFileName) {
     mfxStatus sts = MFX_ERR_NONE;
 
+    switch (m_codecId) {
+        case MFX_CODEC_AVC:
+            m_pNALSplitter.reset(new ProtectedLibrary::AVC_Spl());
+            break;
+        case MFX_CODEC_HEVC:
+            m_pNALSplitter.reset(new ProtectedLibrary::HEVC_Spl());
+            break;
+        case MFX_CODEC_AV1:
+            m_pNALSplitter.reset(new ProtectedLibrary::AV1_Spl());
+            break;
+        default:
+            return MFX_ERR_UNSUPPORTED;
+    }
+
     sts = CSmplBitstreamReader::Init(strFileName);
     if (sts != MFX_ERR_NONE)
         return sts;
@@ -2496,19 +2807,27 @@ mfxStatus CH264FrameReader::Init(const msdk_char* strFileName) {
     m_processedBS   = NULL;
 
     m_originalBS.Extend(1024 * 1024);
+    m_originalBS.DataOffset = 0;
+    m_originalBS.DataLength = 0;
+    m_originalBS.DataFlag   = 0;
 
-    m_pNALSplitter.reset(new ProtectedLibrary::AVC_Spl());
-
-    m_frame           = 0;
-    m_plainBuffer     = 0;
-    m_plainBufferSize = 0;
+    m_frame = 0;
 
     return sts;
 }
 
-mfxStatus CH264FrameReader::ReadNextFrame(mfxBitstream* pBS) {
+mfxStatus CSplitterFrameReader::ReadNextFrame(mfxBitstream* pBS) {
     mfxStatus sts = MFX_ERR_NONE;
     pBS->DataFlag = MFX_BITSTREAM_COMPLETE_FRAME;
+
+    // the frame didn't fit the bitstream of the previous call
+    if (m_processedBS) {
+        sts = CopyBitstream2(pBS, m_processedBS);
+        if (sts == MFX_ERR_NONE)
+            m_processedBS = NULL;
+        return sts;
+    }
+
     //read bit stream from source
     while (!m_originalBS.DataLength) {
         sts = CSmplBitstreamReader::ReadNextFrame(&m_originalBS);
@@ -2521,16 +2840,27 @@ mfxStatus CH264FrameReader::ReadNextFrame(mfxBitstream* pBS) {
     }
 
     do {
-        sts = PrepareNextFrame(m_isEndOfStream ? NULL : &m_originalBS, &m_processedBS);
+        sts = PrepareNextFrame(&m_originalBS, &m_processedBS);
 
         if (sts == MFX_ERR_MORE_DATA) {
             if (m_isEndOfStream) {
                 break;
             }
 
+            // the splitter keeps an unfinished NAL unit in the bitstream, grow the bitstream
+            // when the NAL unit fills the larger part of it
+            if (m_originalBS.DataLength > m_originalBS.MaxLength / 2)
+                m_originalBS.Extend(m_originalBS.MaxLength * 2);
+
             sts = CSmplBitstreamReader::ReadNextFrame(&m_originalBS);
-            if (sts == MFX_ERR_MORE_DATA)
+            if (sts == MFX_ERR_MORE_DATA) {
+                // the splitter completes the last NAL unit and frame
                 m_isEndOfStream = true;
+                m_originalBS.DataFlag |= MFX_BITSTREAM_EOS;
+            }
+            // keep preparing the frame with the new data
+            if (sts == MFX_ERR_NONE)
+                sts = MFX_ERR_MORE_DATA;
             continue;
         }
         else if (MFX_ERR_NONE != sts)
@@ -2540,6 +2870,8 @@ mfxStatus CH264FrameReader::ReadNextFrame(mfxBitstream* pBS) {
 
     // get output stream
     if (NULL != m_processedBS) {
+        // the frame is kept until the bitstream is extended, the splitter isn't called
+        // before that
         mfxStatus copySts = CopyBitstream2(pBS, m_processedBS);
         if (copySts < MFX_ERR_NONE)
             return copySts;
@@ -2549,7 +2881,7 @@ mfxStatus CH264FrameReader::ReadNextFrame(mfxBitstream* pBS) {
     return sts;
 }
 
-mfxStatus CH264FrameReader::PrepareNextFrame(mfxBitstream* in, mfxBitstream** out) {
+mfxStatus CSplitterFrameReader::PrepareNextFrame(mfxBitstream* in, mfxBitstream** out) {
     mfxStatus sts = MFX_ERR_NONE;
 
     if (NULL == out)
@@ -2564,27 +2896,22 @@ mfxStatus CH264FrameReader::PrepareNextFrame(mfxBitstream* in, mfxBitstream** ou
             return sts;
     }
 
-    if (m_plainBufferSize < m_frame->DataLength) {
-        if (NULL != m_plainBuffer) {
-            free(m_plainBuffer);
-            m_plainBuffer     = NULL;
-            m_plainBufferSize = 0;
-        }
-        m_plainBuffer = (mfxU8*)malloc(m_frame->DataLength);
-        if (NULL == m_plainBuffer)
-            return MFX_ERR_MEMORY_ALLOC;
-        m_plainBufferSize = m_frame->DataLength;
-    }
-
-    MSDK_MEMCPY_BUF(m_plainBuffer, 0, m_plainBufferSize, m_frame->Data, m_frame->DataLength);
+    // the frame data stays valid until the next call of the splitter, ReadNextFrame copies
+    // it to the output bitstream before that
     m_outBS            = {};
-    m_outBS.Data       = m_plainBuffer;
+    m_outBS.Data       = m_frame->Data;
     m_outBS.DataOffset = 0;
     m_outBS.DataLength = m_frame->DataLength;
     m_outBS.MaxLength  = m_frame->DataLength;
     m_outBS.DataFlag   = MFX_BITSTREAM_COMPLETE_FRAME;
     m_outBS.TimeStamp  = m_frame->TimeStamp;
 
+    // the headers given to Seek aren't in the file
+    m_frameInfo.Offset =
+        m_seekOffset + std::max(m_frame->SourceOffset, m_seekHeadersSize) - m_seekHeadersSize;
+    m_frameInfo.PicOrderCnt = m_frame->PicOrderCnt;
+    m_frameInfo.KeyFrame    = m_frame->KeyFrame;
+
     m_pNALSplitter->ResetCurrentState();
     m_frame = NULL;
 
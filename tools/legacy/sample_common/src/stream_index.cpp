@@ -0,0 +1,360 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include "stream_index.h"
+
+#include <algorithm>
+#include <memory>
+#include <numeric>
+
+#include <string.h>
+
+#include "sample_defs.h"
+#include "vm/file_defs.h"
+
+/* Index file layout, all numbers except the version are leb128 coded:
+     'S' 'I' 'D' 'X', version byte
+     codec id, stream size
+     number of header sets, size and bytes of every set
+     number of frames, for every frame the offset delta to the previous frame, the presentation
+     order minus the decoding order (zigzag coded) and header set id << 1 | key frame flag */
+namespace {
+
+const mfxU8 INDEX_MAGIC[4] = { 'S', 'I', 'D', 'X' };
+const mfxU8 INDEX_VERSION  = 1;
+
+void PutNumber(std::vector<mfxU8>& out, mfxU64 value) {
+    do {
+        mfxU8 byte = value & 0x7f;
+        value >>= 7;
+        out.push_back(value ? (mfxU8)(byte | 0x80) : byte);
+    } while (value);
+}
+
+bool GetNumber(const std::vector<mfxU8>& in, size_t& pos, mfxU64& value) {
+    value = 0;
+    for (mfxU32 shift = 0; shift < 64 && pos < in.size(); shift += 7) {
+        mfxU8 byte = in[pos++];
+        value |= (mfxU64)(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+mfxU64 ZigZag(mfxI64 value) {
+    return ((mfxU64)value << 1) ^ (mfxU64)(value >> 63);
+}
+
+mfxI64 UnZigZag(mfxU64 value) {
+    return (mfxI64)(value >> 1) ^ -(mfxI64)(value & 1);
+}
+
+bool GetFileSize(const msdk_char* strFileName, mfxU64& size) {
+    FILE* f = NULL;
+    MSDK_FOPEN(f, strFileName, MSDK_STRING("rb"));
+    if (!f)
+        return false;
+
+#if defined(_WIN32) || defined(_WIN64)
+    bool ok = !_fseeki64(f, 0, SEEK_END);
+    size    = (mfxU64)_ftelli64(f);
+#else
+    bool ok = !fseeko(f, 0, SEEK_END);
+    size    = (mfxU64)ftello(f);
+#endif
+    fclose(f);
+    return ok;
+}
+
+bool IsIVFFile(const msdk_char* strFileName) {
+    FILE* f = NULL;
+    MSDK_FOPEN(f, strFileName, MSDK_STRING("rb"));
+    if (!f)
+        return false;
+
+    mfxU8 signature[4] = {};
+    bool ivf           = fread(signature, 1, sizeof(signature), f) == sizeof(signature) &&
+               !memcmp(signature, "DKIF", sizeof(signature));
+    fclose(f);
+    return ivf;
+}
+
+} // namespace
+
+CStreamIndex::CStreamIndex() : m_codecId(0), m_streamSize(0), m_entries(), m_headers() {}
+
+msdk_tstring CStreamIndex::GetIndexFileName(const msdk_char* strFileName) {
+    return msdk_tstring(strFileName) + MSDK_STRING(".idx");
+}
+
+mfxStatus CStreamIndex::CreateFrameReader(const msdk_char* strFileName,
+                                          mfxU32 codecId,
+                                          std::unique_ptr<CSmplBitstreamReader>& reader) {
+    switch (codecId) {
+        case MFX_CODEC_AVC:
+            reader.reset(new CH264FrameReader());
+            break;
+        case MFX_CODEC_HEVC:
+            reader.reset(new CH265FrameReader());
+            break;
+        case MFX_CODEC_VP9:
+            reader.reset(new CIVFFrameReader());
+            break;
+        case MFX_CODEC_AV1:
+            if (IsIVFFile(strFileName))
+                reader.reset(new CIVFFrameReader());
+            else
+                reader.reset(new CAV1FrameReader());
+            break;
+        default:
+            return MFX_ERR_UNSUPPORTED;
+    }
+    return reader->Init(strFileName);
+}
+
+mfxStatus CStreamIndex::Init(const msdk_char* strFileName, mfxU32 codecId) {
+    MSDK_CHECK_POINTER(strFileName, MFX_ERR_NULL_PTR);
+
+    mfxU64 streamSize = 0;
+    if (!GetFileSize(strFileName, streamSize))
+        return MFX_ERR_NOT_FOUND;
+
+    msdk_tstring indexFileName = GetIndexFileName(strFileName);
+    if (Load(indexFileName.c_str()) == MFX_ERR_NONE && m_codecId == codecId &&
+        m_streamSize == streamSize)
+        return MFX_ERR_NONE;
+
+    mfxStatus sts = Build(strFileName, codecId);
+    MSDK_CHECK_STATUS(sts, "CStreamIndex::Build failed");
+
+    // the index is built again by the next run if it can't be saved
+    if (Save(indexFileName.c_str()) != MFX_ERR_NONE)
+        msdk_printf(MSDK_STRING("WARNING: stream index file can't be written\n"));
+    return MFX_ERR_NONE;
+}
+
+mfxStatus CStreamIndex::Build(const msdk_char* strFileName, mfxU32 codecId) {
+    MSDK_CHECK_POINTER(strFileName, MFX_ERR_NULL_PTR);
+
+    m_codecId    = codecId;
+    m_streamSize = 0;
+    m_entries.clear();
+    m_headers.clear();
+
+    if (!GetFileSize(strFileName, m_streamSize))
+        return MFX_ERR_NOT_FOUND;
+
+    std::unique_ptr<CSmplBitstreamReader> reader;
+    mfxStatus sts = CreateFrameReader(strFileName, codecId, reader);
+    if (sts != MFX_ERR_NONE)
+        return sts;
+
+    mfxBitstreamWrapper bs(1024 * 1024);
+    std::vector<mfxU8> headers;
+    std::vector<mfxI32> picOrderCnts;
+
+    for (;;) {
+        // the parameter sets read before the frame
+        reader->GetHeaders(headers);
+
+        bs.DataOffset = 0;
+        bs.DataLength = 0;
+        sts           = reader->ReadNextFrame(&bs);
+        while (sts == MFX_ERR_NOT_ENOUGH_BUFFER) {
+            bs.Extend(bs.MaxLength * 2);
+            sts = reader->ReadNextFrame(&bs);
+        }
+        if (sts == MFX_ERR_MORE_DATA)
+            break;
+        if (sts != MFX_ERR_NONE)
+            return sts;
+
+        CSmplBitstreamReader::FrameInfo info = {};
+        sts                                  = reader->GetFrameInfo(info);
+        if (sts != MFX_ERR_NONE)
+            return sts;
+
+        if (m_headers.empty() || m_headers.back() != headers)
+            m_headers.push_back(headers);
+
+        StreamIndexEntry entry = {};
+        entry.Offset           = info.Offset;
+        entry.Headers          = (mfxU32)m_headers.size() - 1;
+        entry.KeyFrame         = info.KeyFrame;
+        m_entries.push_back(entry);
+        picOrderCnts.push_back(info.PicOrderCnt);
+    }
+
+    // the order count restarts at key frames, frames are presented sorted by the key frame
+    // segment they belong to and the order count within it
+    std::vector<mfxU32> segments(m_entries.size());
+    for (size_t i = 1; i < m_entries.size(); i++)
+        segments[i] = segments[i - 1] + (m_entries[i].KeyFrame ? 1 : 0);
+
+    std::vector<mfxU32> presentation(m_entries.size());
+    std::iota(presentation.begin(), presentation.end(), 0);
+    std::stable_sort(presentation.begin(), presentation.end(), [&](mfxU32 a, mfxU32 b) {
+        if (segments[a] != segments[b])
+            return segments[a] < segments[b];
+        return picOrderCnts[a] < picOrderCnts[b];
+    });
+    for (size_t i = 0; i < presentation.size(); i++)
+        m_entries[presentation[i]].Order = (mfxU32)i;
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus CStreamIndex::Save(const msdk_char* strIndexFileName) const {
+    MSDK_CHECK_POINTER(strIndexFileName, MFX_ERR_NULL_PTR);
+
+    std::vector<mfxU8> data(INDEX_MAGIC, INDEX_MAGIC + sizeof(INDEX_MAGIC));
+    data.push_back(INDEX_VERSION);
+    PutNumber(data, m_codecId);
+    PutNumber(data, m_streamSize);
+
+    PutNumber(data, m_headers.size());
+    for (const auto& headers : m_headers) {
+        PutNumber(data, headers.size());
+        data.insert(data.end(), headers.begin(), headers.end());
+    }
+
+    PutNumber(data, m_entries.size());
+    mfxU64 offset = 0;
+    for (size_t i = 0; i < m_entries.size(); i++) {
+        const StreamIndexEntry& entry = m_entries[i];
+        PutNumber(data, entry.Offset - offset);
+        PutNumber(data, ZigZag((mfxI64)entry.Order - (mfxI64)i));
+        PutNumber(data, (mfxU64)entry.Headers << 1 | (entry.KeyFrame ? 1 : 0));
+        offset = entry.Offset;
+    }
+
+    FILE* f = NULL;
+    MSDK_FOPEN(f, strIndexFileName, MSDK_STRING("wb"));
+    if (!f)
+        return MFX_ERR_NOT_FOUND;
+
+    bool written = fwrite(data.data(), 1, data.size(), f) == data.size();
+    written      = !fclose(f) && written;
+    return written ? MFX_ERR_NONE : MFX_ERR_ABORTED;
+}
+
+mfxStatus CStreamIndex::Load(const msdk_char* strIndexFileName) {
+    MSDK_CHECK_POINTER(strIndexFileName, MFX_ERR_NULL_PTR);
+
+    m_codecId    = 0;
+    m_streamSize = 0;
+    m_entries.clear();
+    m_headers.clear();
+
+    FILE* f = NULL;
+    MSDK_FOPEN(f, strIndexFileName, MSDK_STRING("rb"));
+    if (!f)
+        return MFX_ERR_NOT_FOUND;
+
+    std::vector<mfxU8> data;
+    mfxU8 chunk[64 * 1024];
+    for (size_t read; (read = fread(chunk, 1, sizeof(chunk), f)) != 0;)
+        data.insert(data.end(), chunk, chunk + read);
+    fclose(f);
+
+    if (data.size() <= sizeof(INDEX_MAGIC) ||
+        !std::equal(INDEX_MAGIC, INDEX_MAGIC + sizeof(INDEX_MAGIC), data.begin()) ||
+        data[sizeof(INDEX_MAGIC)] != INDEX_VERSION)
+        return MFX_ERR_UNSUPPORTED;
+
+    size_t pos     = sizeof(INDEX_MAGIC) + 1;
+    mfxU64 codecId = 0, count = 0;
+    if (!GetNumber(data, pos, codecId) || !GetNumber(data, pos, m_streamSize) ||
+        !GetNumber(data, pos, count) || count > data.size())
+        return MFX_ERR_UNDEFINED_BEHAVIOR;
+    m_codecId = (mfxU32)codecId;
+
+    m_headers.resize((size_t)count);
+    for (auto& headers : m_headers) {
+        mfxU64 size = 0;
+        if (!GetNumber(data, pos, size) || size > data.size() - pos)
+            return MFX_ERR_UNDEFINED_BEHAVIOR;
+        headers.assign(data.begin() + pos, data.begin() + pos + (size_t)size);
+        pos += (size_t)size;
+    }
+
+    if (!GetNumber(data, pos, count) || count > data.size())
+        return MFX_ERR_UNDEFINED_BEHAVIOR;
+
+    m_entries.resize((size_t)count);
+    mfxU64 offset = 0;
+    for (size_t i = 0; i < m_entries.size(); i++) {
+        mfxU64 delta = 0, order = 0, flags = 0;
+        if (!GetNumber(data, pos, delta) || !GetNumber(data, pos, order) ||
+            !GetNumber(data, pos, flags) || (flags >> 1) >= m_headers.size())
+            return MFX_ERR_UNDEFINED_BEHAVIOR;
+
+        offset += delta;
+        m_entries[i].Offset   = offset;
+        m_entries[i].Order    = (mfxU32)((mfxI64)i + UnZigZag(order));
+        m_entries[i].Headers  = (mfxU32)(flags >> 1);
+        m_entries[i].KeyFrame = (flags & 1) != 0;
+    }
+    return MFX_ERR_NONE;
+}
+
+const StreamIndexEntry* CStreamIndex::FindKeyFrame(mfxU32 order) const {
+    if (m_entries.empty())
+        return NULL;
+
+    // the frame is decoded after the key frames preceding it, leading pictures of a key
+    // frame are presented before it and are decoded from the previous key frame
+    auto frame = std::find_if(m_entries.begin(), m_entries.end(), [&](const StreamIndexEntry& e) {
+        return e.Order == order;
+    });
+    if (frame == m_entries.end())
+        return NULL;
+
+    for (auto it = frame + 1; it != m_entries.begin();) {
+        --it;
+        if (it->KeyFrame && it->Order <= order)
+            return &*it;
+    }
+    return &m_entries.front();
+}
+
+std::vector<mfxU32> CStreamIndex::GetChunkStarts(mfxU32 numChunks) const {
+    std::vector<mfxU32> starts;
+    if (m_entries.empty())
+        return starts;
+
+    // the orders are a permutation of the frame numbers, the frames before the split point
+    // are presented first if the largest of their orders is the last frame number
+    std::vector<mfxU32> splits;
+    mfxU32 maxOrder = m_entries[0].Order;
+    for (mfxU32 i = 1; i < (mfxU32)m_entries.size(); i++) {
+        if (m_entries[i].KeyFrame && m_entries[i].Order == i && maxOrder == i - 1)
+            splits.push_back(i);
+        maxOrder = std::max(maxOrder, m_entries[i].Order);
+    }
+
+    starts.push_back(0);
+    for (mfxU32 chunk = 1; chunk < numChunks; chunk++) {
+        mfxU32 target = (mfxU32)((mfxU64)m_entries.size() * chunk / numChunks);
+
+        // the split point nearest to the target after the start of the previous chunk
+        auto first = std::upper_bound(splits.begin(), splits.end(), starts.back());
+        auto it    = std::lower_bound(first, splits.end(), target);
+        if (it != first && (it == splits.end() || target - *(it - 1) <= *it - target))
+            --it;
+        if (it == splits.end())
+            break;
+        starts.push_back(*it);
+    }
+    return starts;
+}
+
+mfxStatus CStreamIndex::Seek(CSmplBitstreamReader& reader, const StreamIndexEntry& entry) const {
+    if (entry.Headers >= m_headers.size())
+        return MFX_ERR_INVALID_VIDEO_PARAM;
+    return reader.Seek(entry.Offset, m_headers[entry.Headers]);
+}
@@ -7,14 +7,97 @@
 #include "sysmem_allocator.h"
 #include <memory>
 #include "sample_utils.h"
+#include "vm/numa_defs.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+    #include <windows.h>
+#else
+    #include <sys/mman.h>
+#endif
 
 #define MSDK_ALIGN32(X) (((mfxU32)((X) + 31)) & (~(mfxU32)31))
 #define ID_BUFFER       MFX_MAKEFOURCC('B', 'U', 'F', 'F')
 #define ID_FRAME        MFX_MAKEFOURCC('F', 'R', 'M', 'E')
 
+// planes of the frames in a slab start at cache line boundaries
+#define SLAB_FRAME_ALIGNMENT 64
+#define SLAB_PAGE_SIZE       4096
+#define SLAB_HUGE_PAGE_SIZE  (2 * 1024 * 1024)
+
+static size_t AlignSize(size_t size, size_t alignment) {
+    return (size + alignment - 1) & ~(alignment - 1);
+}
+
+// Maps page aligned zeroed memory, the size is rounded up to the pages used
+static mfxU8* MapSlabMemory(size_t& size, SysMemHugePages hugePages) {
+#if defined(_WIN32) || defined(_WIN64)
+    // large pages need the lock memory privilege, the slabs use normal pages
+    (void)hugePages;
+    size = AlignSize(size, SLAB_PAGE_SIZE);
+    return (mfxU8*)VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+    #ifdef MAP_HUGETLB
+    if (hugePages == SYSMEM_HUGEPAGES_HUGETLB) {
+        size_t hugeSize = AlignSize(size, SLAB_HUGE_PAGE_SIZE);
+        void* ptr       = mmap(NULL,
+                               hugeSize,
+                               PROT_READ | PROT_WRITE,
+                               MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+                               -1,
+                               0);
+        if (ptr != MAP_FAILED) {
+            size = hugeSize;
+            return (mfxU8*)ptr;
+        }
+    }
+    #endif
+
+    if (hugePages == SYSMEM_HUGEPAGES_OFF) {
+        size      = AlignSize(size, SLAB_PAGE_SIZE);
+        void* ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        return ptr != MAP_FAILED ? (mfxU8*)ptr : NULL;
+    }
+
+    // transparent huge pages back only the huge page aligned part of the mapping, the
+    // mapping is made larger and trimmed to a huge page boundary
+    size          = AlignSize(size, SLAB_HUGE_PAGE_SIZE);
+    size_t mapped = size + SLAB_HUGE_PAGE_SIZE;
+    void* ptr     = mmap(NULL, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED)
+        return NULL;
+
+    mfxU8* begin   = (mfxU8*)ptr;
+    mfxU8* aligned = (mfxU8*)AlignSize((size_t)begin, SLAB_HUGE_PAGE_SIZE);
+    if (aligned != begin)
+        munmap(begin, aligned - begin);
+    if (aligned + size != begin + mapped)
+        munmap(aligned + size, begin + mapped - (aligned + size));
+    #ifdef MADV_HUGEPAGE
+    // the advice is a hint, the kernel may be configured without transparent huge pages
+    madvise(aligned, size, MADV_HUGEPAGE);
+    #endif
+    return aligned;
+#endif
+}
+
+static void UnmapSlabMemory(mfxU8* ptr, size_t size) {
+#if defined(_WIN32) || defined(_WIN64)
+    (void)size;
+    VirtualFree(ptr, 0, MEM_RELEASE);
+#else
+    munmap(ptr, size);
+#endif
+}
+
 SysMemFrameAllocator::SysMemFrameAllocator()
         : m_pBufferAllocator(0),
-          m_bOwnBufferAllocator(false) {}
+          m_bOwnBufferAllocator(false),
+          m_bUseArena(false),
+          m_HugePages(SYSMEM_HUGEPAGES_OFF),
+          m_bPrefault(false),
+          m_NumaNode(-1),
+          m_slabs(),
+          m_slabFrames() {}
 
 SysMemFrameAllocator::~SysMemFrameAllocator() {
     Close();
@@ -30,6 +113,10 @@ mfxStatus SysMemFrameAllocator::Init(mfxAllocatorParams* pParams) {
 
         m_pBufferAllocator    = pSysMemParams->pBufferAllocator;
         m_bOwnBufferAllocator = false;
+        m_bUseArena           = pSysMemParams->bUseArena || pSysMemParams->NumaNode >= 0;
+        m_HugePages           = pSysMemParams->HugePages;
+        m_bPrefault           = pSysMemParams->bPrefault;
+        m_NumaNode            = pSysMemParams->NumaNode;
     }
 
     // if buffer allocator wasn't passed from application create own
@@ -46,6 +133,7 @@ mfxStatus SysMemFrameAllocator::Init(mfxAllocatorParams* pParams) {
 
 mfxStatus SysMemFrameAllocator::Close() {
     mfxStatus sts = BaseFrameAllocator::Close();
+    FreeSlabs();
 
     if (m_bOwnBufferAllocator) {
         delete m_pBufferAllocator;
@@ -65,15 +153,23 @@ mfxStatus SysMemFrameAllocator::LockFrame(mfxMemId mid, mfxFrameData* ptr) {
     if (!mid && ptr->Y)
         return MFX_ERR_NONE;
 
-    sFrame* fs    = 0;
-    mfxStatus sts = m_pBufferAllocator->Lock(m_pBufferAllocator->pthis, mid, (mfxU8**)&fs);
+    sFrame* fs = 0;
+    if (m_bUseArena) {
+        // the frames of the slabs are always mapped
+        fs = (sFrame*)mid;
+        if (!fs || ID_FRAME != fs->id)
+            return MFX_ERR_INVALID_HANDLE;
+    }
+    else {
+        mfxStatus sts = m_pBufferAllocator->Lock(m_pBufferAllocator->pthis, mid, (mfxU8**)&fs);
 
-    if (MFX_ERR_NONE != sts)
-        return sts;
+        if (MFX_ERR_NONE != sts)
+            return sts;
 
-    if (ID_FRAME != fs->id) {
-        m_pBufferAllocator->Unlock(m_pBufferAllocator->pthis, mid);
-        return MFX_ERR_INVALID_HANDLE;
+        if (ID_FRAME != fs->id) {
+            m_pBufferAllocator->Unlock(m_pBufferAllocator->pthis, mid);
+            return MFX_ERR_INVALID_HANDLE;
+        }
     }
 
     mfxU16 Width2  = (mfxU16)MSDK_ALIGN32(fs->info.Width);
@@ -230,10 +326,12 @@ mfxStatus SysMemFrameAllocator::UnlockFrame(mfxMemId mid, mfxFrameData* ptr) {
     if (!mid && ptr->Y)
         return MFX_ERR_NONE;
 
-    mfxStatus sts = m_pBufferAllocator->Unlock(m_pBufferAllocator->pthis, mid);
+    if (!m_bUseArena) {
+        mfxStatus sts = m_pBufferAllocator->Unlock(m_pBufferAllocator->pthis, mid);
 
-    if (MFX_ERR_NONE != sts)
-        return sts;
+        if (MFX_ERR_NONE != sts)
+            return sts;
+    }
 
     if (NULL != ptr) {
         ptr->Pitch = 0;
@@ -361,6 +459,29 @@ mfxStatus SysMemFrameAllocator::ReallocImpl(mfxMemId mid,
     if (!pmid)
         return MFX_ERR_MEMORY_ALLOC;
 
+    if (m_bUseArena) {
+        auto it = m_slabFrames.find(*pmid);
+        if (it == m_slabFrames.end())
+            return MFX_ERR_INVALID_HANDLE;
+
+        // the frame keeps its place in the slab if the new size fits, otherwise it gets a slab
+        // of its own
+        if (nbytes <= it->second.capacity) {
+            ((sFrame*)*pmid)->info = *info;
+        }
+        else {
+            mfxMemId newMid = 0;
+            mfxStatus sts   = AllocSlabFrames(*info, nbytes, 1, &newMid);
+            if (MFX_ERR_NONE != sts)
+                return sts;
+            ReleaseSlabFrame(*pmid);
+            *pmid = newMid;
+        }
+
+        *midOut = *pmid;
+        return MFX_ERR_NONE;
+    }
+
     mfxStatus sts = m_pBufferAllocator->Free(m_pBufferAllocator->pthis, *pmid);
     if (MFX_ERR_NONE != sts)
         return sts;
@@ -400,6 +521,19 @@ mfxStatus SysMemFrameAllocator::AllocImpl(mfxFrameAllocRequest* request,
 
     auto mids = std::make_unique<mfxMemId[]>(request->NumFrameSuggested);
 
+    if (m_bUseArena) {
+        mfxStatus sts =
+            AllocSlabFrames(request->Info, nbytes, request->NumFrameSuggested, mids.get());
+        if (MFX_ERR_NONE != sts)
+            return sts;
+
+        response->NumFrameActual = request->NumFrameSuggested;
+        response->mids           = mids.release();
+
+        m_vResp.push_back(response);
+        return MFX_ERR_NONE;
+    }
+
     // allocate frames
     for (numAllocated = 0; numAllocated < request->NumFrameSuggested; numAllocated++) {
         mfxStatus sts = m_pBufferAllocator->Alloc(m_pBufferAllocator->pthis,
@@ -445,7 +579,11 @@ mfxStatus SysMemFrameAllocator::ReleaseResponse(mfxFrameAllocResponse* response)
 
     mfxStatus sts = MFX_ERR_NONE;
 
-    if (response->mids) {
+    if (response->mids && m_bUseArena) {
+        for (mfxU32 i = 0; i < response->NumFrameActual; i++)
+            ReleaseSlabFrame(response->mids[i]);
+    }
+    else if (response->mids) {
         for (mfxU32 i = 0; i < response->NumFrameActual; i++) {
             if (response->mids[i]) {
                 sts = m_pBufferAllocator->Free(m_pBufferAllocator->pthis, response->mids[i]);
@@ -462,6 +600,95 @@ mfxStatus SysMemFrameAllocator::ReleaseResponse(mfxFrameAllocResponse* response)
     return sts;
 }
 
+mfxStatus SysMemFrameAllocator::AllocSlabFrames(const mfxFrameInfo& info,
+                                                mfxU32 nbytes,
+                                                mfxU32 numFrames,
+                                                mfxMemId* mids) {
+    // the header of a frame is in front of its planes, within the padding of the previous
+    // frame for all but the first one
+    size_t headerSize = MSDK_ALIGN32(sizeof(sFrame));
+    size_t firstFrame = AlignSize(headerSize, SLAB_FRAME_ALIGNMENT);
+    size_t frameSize  = AlignSize(headerSize + nbytes, SLAB_FRAME_ALIGNMENT);
+
+    Slab* slab = AllocSlab(firstFrame + frameSize * numFrames);
+    if (!slab)
+        return MFX_ERR_MEMORY_ALLOC;
+
+    for (mfxU32 i = 0; i < numFrames; i++) {
+        sFrame* fs = (sFrame*)(slab->ptr + firstFrame + frameSize * i - headerSize);
+        fs->id     = ID_FRAME;
+        fs->info   = info;
+        mids[i]    = (mfxMemId)fs;
+
+        m_slabFrames[mids[i]] = { slab, (mfxU32)(frameSize - headerSize) };
+    }
+    slab->numFrames = numFrames;
+    return MFX_ERR_NONE;
+}
+
+void SysMemFrameAllocator::ReleaseSlabFrame(mfxMemId mid) {
+    auto it = m_slabFrames.find(mid);
+    if (it == m_slabFrames.end())
+        return;
+
+    // the slab is kept for the next allocation
+    it->second.slab->numFrames--;
+    m_slabFrames.erase(it);
+}
+
+SysMemFrameAllocator::Slab* SysMemFrameAllocator::AllocSlab(size_t size) {
+    // the smallest released slab the frames fit in, unless it's more than twice as large
+    Slab* reused = NULL;
+    for (Slab& slab : m_slabs) {
+        if (!slab.numFrames && slab.size >= size && slab.size <= 2 * size &&
+            (!reused || slab.size < reused->size))
+            reused = &slab;
+    }
+    if (reused)
+        return reused;
+
+    // released slabs which don't fit are unmapped, otherwise every change of the frame size
+    // would leave the memory of the previous one behind
+    for (auto it = m_slabs.begin(); it != m_slabs.end();) {
+        if (!it->numFrames) {
+            UnmapSlabMemory(it->ptr, it->size);
+            it = m_slabs.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+
+    Slab slab      = {};
+    slab.size      = size;
+    slab.ptr       = MapSlabMemory(slab.size, m_HugePages);
+    slab.numFrames = 0;
+    if (!slab.ptr)
+        return NULL;
+
+    // the policy is set before the pages are touched, it's a preference and doesn't fail
+    // when the node runs out of memory. Placement isn't supported everywhere, the pages
+    // are taken from the node of the first touch then.
+    if (m_NumaNode >= 0)
+        msdk_numa_bind_memory(slab.ptr, slab.size, (mfxU32)m_NumaNode);
+
+    if (m_bPrefault) {
+        // a write to every page, the page size of the mapping may be larger
+        for (size_t offset = 0; offset < slab.size; offset += SLAB_PAGE_SIZE)
+            ((volatile mfxU8*)slab.ptr)[offset] = 0;
+    }
+
+    m_slabs.push_back(slab);
+    return &m_slabs.back();
+}
+
+void SysMemFrameAllocator::FreeSlabs() {
+    for (Slab& slab : m_slabs)
+        UnmapSlabMemory(slab.ptr, slab.size);
+    m_slabs.clear();
+    m_slabFrames.clear();
+}
+
 SysMemBufferAllocator::SysMemBufferAllocator() {}
 
 SysMemBufferAllocator::~SysMemBufferAllocator() {}
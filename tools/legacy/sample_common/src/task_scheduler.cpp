@@ -0,0 +1,298 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include "task_scheduler.h"
+
+#include <algorithm>
+#include <chrono>
+
+CTaskScheduler::CTaskScheduler()
+        : m_workers(),
+          m_dedicated(),
+          m_nextWorker(0),
+          m_queued(0),
+          m_idle(0),
+          m_idleMutex(),
+          m_cvQueued(),
+          m_bStop(false),
+          m_deferred(),
+          m_numDeferred(0),
+          m_doneMutex(),
+          m_cvDone(),
+          m_done(),
+          m_running(0),
+          m_steps(0),
+          m_turns(0),
+          m_steals(0),
+          m_sleeps(0),
+          m_deferrals(0) {}
+
+namespace {
+
+// orders the deferred tasks into a heap with the one due first on top
+struct DueLater {
+    template <class T>
+    bool operator()(const T& left, const T& right) const {
+        return left.resumeAt > right.resumeAt;
+    }
+};
+
+} // namespace
+
+CTaskScheduler::~CTaskScheduler() {
+    Stop();
+}
+
+mfxStatus CTaskScheduler::Start(mfxU32 numWorkers) {
+    if (IsStarted())
+        return MFX_ERR_UNDEFINED_BEHAVIOR;
+    if (!numWorkers)
+        numWorkers = std::max(std::thread::hardware_concurrency(), 1u);
+
+    m_bStop      = false;
+    m_nextWorker = 0;
+    for (mfxU32 i = 0; i < numWorkers; i++)
+        m_workers.emplace_back(new Worker);
+    // the workers steal from each other, so all of them exist before the first one starts
+    for (mfxU32 i = 0; i < numWorkers; i++)
+        m_workers[i]->thread = std::thread(&CTaskScheduler::WorkerRoutine, this, i);
+    return MFX_ERR_NONE;
+}
+
+void CTaskScheduler::Stop() {
+    {
+        std::unique_lock<std::mutex> lock(m_doneMutex);
+        m_cvDone.wait(lock, [&]() {
+            return !m_running;
+        });
+        m_done.clear();
+    }
+
+    if (IsStarted()) {
+        {
+            std::lock_guard<std::mutex> lock(m_idleMutex);
+            m_bStop = true;
+        }
+        m_cvQueued.notify_all();
+        for (auto& worker : m_workers)
+            worker->thread.join();
+        m_workers.clear();
+    }
+
+    for (std::thread& thread : m_dedicated)
+        thread.join();
+    m_dedicated.clear();
+}
+
+mfxStatus CTaskScheduler::Submit(mfxU32 id, const Task& task, mfxU32 weight) {
+    if (!task)
+        return IsStarted() ? MFX_ERR_NULL_PTR : MFX_ERR_NOT_INITIALIZED;
+    return SubmitDeferrable(
+        id,
+        [task](Clock::time_point&) {
+            return task();
+        },
+        weight);
+}
+
+mfxStatus CTaskScheduler::SubmitDeferrable(mfxU32 id, const DeferrableTask& task, mfxU32 weight) {
+    if (!IsStarted())
+        return MFX_ERR_NOT_INITIALIZED;
+    if (!task)
+        return MFX_ERR_NULL_PTR;
+
+    mfxU32 index = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_doneMutex);
+        m_running++;
+        index = m_nextWorker++ % GetNumWorkers();
+    }
+    Queue(index, Entry{ id, task, std::max(weight, 1u) }, false);
+    return MFX_ERR_NONE;
+}
+
+mfxStatus CTaskScheduler::SubmitDedicated(mfxU32 id, const Task& task) {
+    if (!task)
+        return MFX_ERR_NULL_PTR;
+
+    {
+        std::lock_guard<std::mutex> lock(m_doneMutex);
+        m_running++;
+    }
+    m_dedicated.emplace_back([this, id, task]() {
+        mfxStatus sts = MFX_TASK_WORKING;
+        while (MFX_TASK_WORKING == sts)
+            sts = task();
+        Complete(id, sts);
+    });
+    return MFX_ERR_NONE;
+}
+
+mfxStatus CTaskScheduler::WaitForCompletion(mfxU32 msec, mfxU32* id, mfxStatus* result) {
+    if (!id || !result)
+        return MFX_ERR_NULL_PTR;
+
+    std::unique_lock<std::mutex> lock(m_doneMutex);
+    bool ready = m_cvDone.wait_for(lock, std::chrono::milliseconds(msec), [&]() {
+        return !m_done.empty() || !m_running;
+    });
+    if (!ready)
+        return MFX_TASK_WORKING;
+    if (m_done.empty())
+        return MFX_ERR_NOT_FOUND;
+
+    *id     = m_done.front().first;
+    *result = m_done.front().second;
+    m_done.pop_front();
+    return MFX_ERR_NONE;
+}
+
+void CTaskScheduler::Queue(mfxU32 index, Entry&& entry, bool bResumed) {
+    Worker& worker = *m_workers[index];
+    bool wake      = false;
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.queue.push_back(std::move(entry));
+        m_queued++;
+        // a task put back after its turn is taken by the same worker next, the idle workers
+        // are woken up only for the tasks it has no time for
+        wake = !bResumed || worker.queue.size() > 1;
+    }
+    if (wake && m_idle) {
+        std::lock_guard<std::mutex> lock(m_idleMutex);
+        m_cvQueued.notify_one();
+    }
+}
+
+bool CTaskScheduler::TakeTask(mfxU32 index, Entry& entry) {
+    for (size_t i = 0; i < m_workers.size(); i++) {
+        Worker& worker = *m_workers[(index + i) % m_workers.size()];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (worker.queue.empty())
+            continue;
+
+        // the owner takes the task waiting longest, a thief the one put back last
+        if (!i) {
+            entry = std::move(worker.queue.front());
+            worker.queue.pop_front();
+        }
+        else {
+            entry = std::move(worker.queue.back());
+            worker.queue.pop_back();
+            m_steals++;
+        }
+        m_queued--;
+        m_turns++;
+        return true;
+    }
+    return false;
+}
+
+void CTaskScheduler::WorkerRoutine(mfxU32 index) {
+    for (;;) {
+        if (m_numDeferred)
+            ResumeDueTasks();
+
+        Entry entry;
+        if (!TakeTask(index, entry)) {
+            std::unique_lock<std::mutex> lock(m_idleMutex);
+            if (m_bStop)
+                return;
+            m_idle++;
+            if (!m_queued && !IsTaskDue()) {
+                m_sleeps++;
+                auto ready = [&]() {
+                    return m_queued || m_bStop || IsTaskDue();
+                };
+                if (m_deferred.empty())
+                    m_cvQueued.wait(lock, ready);
+                else
+                    m_cvQueued.wait_until(lock, m_deferred.front().resumeAt, ready);
+            }
+            m_idle--;
+            continue;
+        }
+
+        mfxStatus sts = MFX_TASK_WORKING;
+        Clock::time_point resumeAt;
+        for (mfxU32 i = 0; i < entry.weight && MFX_TASK_WORKING == sts; i++) {
+            sts = entry.task(resumeAt);
+            m_steps++;
+            if (resumeAt != Clock::time_point() && resumeAt > Clock::now())
+                break;
+        }
+
+        if (MFX_TASK_WORKING != sts)
+            Complete(entry.id, sts);
+        else if (resumeAt != Clock::time_point() && resumeAt > Clock::now())
+            Defer(index, std::move(entry), resumeAt);
+        else
+            Queue(index, std::move(entry), true);
+    }
+}
+
+void CTaskScheduler::Defer(mfxU32 index, Entry&& entry, Clock::time_point resumeAt) {
+    m_deferrals++;
+    std::lock_guard<std::mutex> lock(m_idleMutex);
+    m_deferred.push_back(Deferred{ resumeAt, index, std::move(entry) });
+    std::push_heap(m_deferred.begin(), m_deferred.end(), DueLater());
+    m_numDeferred++;
+    // a sleeping worker may have to wake up earlier now
+    if (m_idle)
+        m_cvQueued.notify_one();
+}
+
+void CTaskScheduler::ResumeDueTasks() {
+    std::vector<Deferred> due;
+    {
+        std::lock_guard<std::mutex> lock(m_idleMutex);
+        while (IsTaskDue()) {
+            std::pop_heap(m_deferred.begin(), m_deferred.end(), DueLater());
+            due.push_back(std::move(m_deferred.back()));
+            m_deferred.pop_back();
+            m_numDeferred--;
+        }
+    }
+    // the queue wakes up the idle workers, so m_idleMutex is not held
+    for (Deferred& task : due)
+        Queue(task.index, std::move(task.entry), false);
+}
+
+bool CTaskScheduler::IsTaskDue() const {
+    return !m_deferred.empty() && m_deferred.front().resumeAt <= Clock::now();
+}
+
+void CTaskScheduler::Complete(mfxU32 id, mfxStatus sts) {
+    {
+        std::lock_guard<std::mutex> lock(m_doneMutex);
+        m_done.push_back(std::make_pair(id, sts));
+        m_running--;
+    }
+    m_cvDone.notify_all();
+}
+
+CTaskScheduler::Statistics CTaskScheduler::GetStatistics() const {
+    Statistics stat = {};
+    stat.steps      = m_steps;
+    stat.turns      = m_turns;
+    stat.steals     = m_steals;
+    stat.sleeps     = m_sleeps;
+    stat.deferrals  = m_deferrals;
+    return stat;
+}
+
+void CTaskScheduler::PrintStatistics(const msdk_char* prefix) const {
+    Statistics stat = GetStatistics();
+    msdk_printf(
+        MSDK_STRING("%s Workers:%u,Steps:%llu,Turns:%llu,Steals:%llu,Sleeps:%llu,Deferrals:%llu\n"),
+        prefix,
+        GetNumWorkers(),
+        (unsigned long long int)stat.steps,
+        (unsigned long long int)stat.turns,
+        (unsigned long long int)stat.steals,
+        (unsigned long long int)stat.sleeps,
+        (unsigned long long int)stat.deferrals);
+}
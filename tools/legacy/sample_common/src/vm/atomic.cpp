@@ -8,6 +8,9 @@
 
     #include "vm/atomic_defs.h"
 
+    #include <windows.h>
+    #pragma comment(lib, "Synchronization.lib")
+
     //#define _interlockedbittestandset      fake_set
     //#define _interlockedbittestandreset    fake_reset
     //#define _interlockedbittestandset64    fake_set64
@@ -40,4 +43,12 @@ mfxU32 msdk_atomic_dec32(volatile mfxU32* pVariable) {
     return _InterlockedDecrement((volatile long*)pVariable);
 }
 
+void msdk_atomic_wait32(volatile mfxU32* pVariable, mfxU32 value, mfxU32 msec) {
+    WaitOnAddress(pVariable, &value, sizeof(value), msec);
+}
+
+void msdk_atomic_wake32(volatile mfxU32* pVariable) {
+    WakeByAddressAll((PVOID)pVariable);
+}
+
 #endif // #if defined(_WIN32) || defined(_WIN64)
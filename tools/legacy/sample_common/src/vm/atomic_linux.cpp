@@ -8,6 +8,12 @@
 
     #include "vm/atomic_defs.h"
 
+    #include <limits.h>
+    #include <linux/futex.h>
+    #include <sys/syscall.h>
+    #include <time.h>
+    #include <unistd.h>
+
 static mfxU16 msdk_atomic_add16(volatile mfxU16* mem, mfxU16 val) {
     asm volatile("lock; xaddw %0,%1"
                  : "=r"(val), "=m"(*mem)
@@ -42,4 +48,15 @@ mfxU32 msdk_atomic_dec32(volatile mfxU32* pVariable) {
     return msdk_atomic_add32(pVariable, (mfxU32)-1) + 1;
 }
 
+void msdk_atomic_wait32(volatile mfxU32* pVariable, mfxU32 value, mfxU32 msec) {
+    struct timespec timeout;
+    timeout.tv_sec  = msec / 1000;
+    timeout.tv_nsec = (msec % 1000) * 1000000;
+    syscall(SYS_futex, pVariable, FUTEX_WAIT_PRIVATE, value, &timeout, NULL, 0);
+}
+
+void msdk_atomic_wake32(volatile mfxU32* pVariable) {
+    syscall(SYS_futex, pVariable, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
+
 #endif // #if !defined(_WIN32) && !defined(_WIN64)
@@ -0,0 +1,106 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include "mfx_samples_config.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+
+    #include <windows.h>
+    #include <stdlib.h>
+
+    #include "vm/numa_defs.h"
+
+// Placement is limited to the first processor group, memory placement is done by
+// VirtualAllocExNuma only, so the memory functions are not supported
+
+mfxU32 msdk_numa_get_node_count() {
+    ULONG highest = 0;
+    if (!GetNumaHighestNodeNumber(&highest))
+        return 1;
+    return (mfxU32)highest + 1;
+}
+
+mfxStatus msdk_numa_get_node_cpus(mfxU32 node, std::vector<mfxU32>& cpus) {
+    cpus.clear();
+    ULONGLONG mask = 0;
+    if (node > 0xff || !GetNumaNodeProcessorMask((UCHAR)node, &mask) || !mask)
+        return MFX_ERR_NOT_FOUND;
+    for (mfxU32 cpu = 0; cpu < 64; cpu++) {
+        if (mask & (1ull << cpu))
+            cpus.push_back(cpu);
+    }
+    return MFX_ERR_NONE;
+}
+
+mfxStatus msdk_parse_cpu_list(const msdk_char* str, std::vector<mfxU32>& cpus) {
+    cpus.clear();
+    if (!str)
+        return MFX_ERR_NULL_PTR;
+
+    const msdk_char* pos = str;
+    while (*pos && *pos != '\n') {
+        msdk_char* end;
+        long first = msdk_strtol(pos, &end, 10);
+        long last  = first;
+        if (end == pos || first < 0)
+            return MFX_ERR_UNSUPPORTED;
+        if (*end == '-') {
+            pos  = end + 1;
+            last = msdk_strtol(pos, &end, 10);
+            if (end == pos || last < first)
+                return MFX_ERR_UNSUPPORTED;
+        }
+        if (last >= 64)
+            return MFX_ERR_UNSUPPORTED;
+        for (long cpu = first; cpu <= last; cpu++)
+            cpus.push_back((mfxU32)cpu);
+
+        pos = end;
+        if (*pos == ',')
+            pos++;
+        else if (*pos && *pos != '\n')
+            return MFX_ERR_UNSUPPORTED;
+    }
+    return cpus.empty() ? MFX_ERR_UNSUPPORTED : MFX_ERR_NONE;
+}
+
+mfxStatus msdk_thread_set_affinity(const std::vector<mfxU32>& cpus) {
+    DWORD_PTR mask = 0;
+    for (mfxU32 cpu : cpus) {
+        if (cpu >= 8 * sizeof(mask))
+            return MFX_ERR_UNSUPPORTED;
+        mask |= (DWORD_PTR)1 << cpu;
+    }
+    return SetThreadAffinityMask(GetCurrentThread(), mask) ? MFX_ERR_NONE : MFX_ERR_UNSUPPORTED;
+}
+
+mfxStatus msdk_numa_set_preferred_node(mfxI32 node) {
+    // the ideal processor of a thread pinned to the node makes allocations local already
+    return node < 0 ? MFX_ERR_NONE : MFX_ERR_UNSUPPORTED;
+}
+
+mfxStatus msdk_numa_bind_memory(void* ptr, size_t size, mfxU32 node) {
+    (void)ptr;
+    (void)size;
+    (void)node;
+    return MFX_ERR_UNSUPPORTED;
+}
+
+mfxStatus msdk_numa_get_memory_nodes(const void* ptr,
+                                     size_t size,
+                                     std::vector<mfxU64>& bytesPerNode) {
+    (void)ptr;
+    (void)size;
+    (void)bytesPerNode;
+    return MFX_ERR_UNSUPPORTED;
+}
+
+mfxStatus msdk_numa_get_process_memory(std::vector<mfxU64>& bytesPerNode) {
+    (void)bytesPerNode;
+    return MFX_ERR_UNSUPPORTED;
+}
+
+#endif // #if defined(_WIN32) || defined(_WIN64)
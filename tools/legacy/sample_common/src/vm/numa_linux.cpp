@@ -0,0 +1,242 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#if !defined(_WIN32) && !defined(_WIN64)
+
+    #include <errno.h>
+    #include <stdint.h>
+    #include <pthread.h>
+    #include <sched.h>
+    #include <stdio.h>
+    #include <stdlib.h>
+    #include <string.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+    #include <algorithm>
+
+    #include "vm/numa_defs.h"
+
+    // memory policies of the kernel, numaif.h of libnuma isn't required
+    #define MSDK_MPOL_DEFAULT   0
+    #define MSDK_MPOL_PREFERRED 1
+    #define MSDK_MPOL_MF_MOVE   (1 << 1)
+
+    #define MSDK_NUMA_MAX_NODES 1024
+
+namespace {
+
+// the kernel reads maxnode - 1 bits of the mask
+struct NodeMask {
+    unsigned long bits[MSDK_NUMA_MAX_NODES / (8 * sizeof(unsigned long))];
+    unsigned long maxnode;
+
+    explicit NodeMask(mfxU32 node) : bits(), maxnode(MSDK_NUMA_MAX_NODES + 1) {
+        bits[node / (8 * sizeof(unsigned long))] = 1ul << (node % (8 * sizeof(unsigned long)));
+    }
+};
+
+mfxStatus ErrnoToStatus(int error) {
+    switch (error) {
+        case ENOSYS:
+        case EPERM:
+            return MFX_ERR_UNSUPPORTED;
+        case ENOMEM:
+            return MFX_ERR_MEMORY_ALLOC;
+        default:
+            return MFX_ERR_INVALID_VIDEO_PARAM;
+    }
+}
+
+// Reads the first line of a sysfs file
+bool ReadLine(const char* path, char* line, int size) {
+    FILE* file = fopen(path, "r");
+    if (!file)
+        return false;
+    bool read = fgets(line, size, file) != NULL;
+    fclose(file);
+    return read;
+}
+
+} // namespace
+
+mfxU32 msdk_numa_get_node_count() {
+    char line[256];
+    std::vector<mfxU32> nodes;
+    if (!ReadLine("/sys/devices/system/node/online", line, sizeof(line)) ||
+        msdk_parse_cpu_list(line, nodes) != MFX_ERR_NONE || nodes.empty())
+        return 1;
+    return nodes.back() + 1;
+}
+
+mfxStatus msdk_numa_get_node_cpus(mfxU32 node, std::vector<mfxU32>& cpus) {
+    cpus.clear();
+
+    char path[64];
+    char line[4096];
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%u/cpulist", node);
+    if (ReadLine(path, line, sizeof(line))) {
+        // memory only nodes have no CPUs
+        if (line[0] == '\n' || !line[0])
+            return MFX_ERR_NONE;
+        return msdk_parse_cpu_list(line, cpus);
+    }
+
+    // no NUMA support in the kernel, all CPUs are on node 0
+    if (node != 0 || msdk_numa_get_node_count() != 1)
+        return MFX_ERR_NOT_FOUND;
+    long count = sysconf(_SC_NPROCESSORS_CONF);
+    for (long cpu = 0; cpu < count; cpu++)
+        cpus.push_back((mfxU32)cpu);
+    return MFX_ERR_NONE;
+}
+
+mfxStatus msdk_parse_cpu_list(const msdk_char* str, std::vector<mfxU32>& cpus) {
+    cpus.clear();
+    if (!str)
+        return MFX_ERR_NULL_PTR;
+
+    const char* pos = str;
+    while (*pos && *pos != '\n') {
+        // strtoul takes signs and spaces
+        char* end;
+        if (*pos < '0' || *pos > '9')
+            return MFX_ERR_UNSUPPORTED;
+        unsigned long first = strtoul(pos, &end, 10);
+        unsigned long last  = first;
+        if (*end == '-') {
+            pos = end + 1;
+            if (*pos < '0' || *pos > '9')
+                return MFX_ERR_UNSUPPORTED;
+            last = strtoul(pos, &end, 10);
+            if (last < first)
+                return MFX_ERR_UNSUPPORTED;
+        }
+        if (last >= CPU_SETSIZE)
+            return MFX_ERR_UNSUPPORTED;
+        for (unsigned long cpu = first; cpu <= last; cpu++)
+            cpus.push_back((mfxU32)cpu);
+
+        pos = end;
+        if (*pos == ',')
+            pos++;
+        else if (*pos && *pos != '\n')
+            return MFX_ERR_UNSUPPORTED;
+    }
+    return cpus.empty() ? MFX_ERR_UNSUPPORTED : MFX_ERR_NONE;
+}
+
+mfxStatus msdk_thread_set_affinity(const std::vector<mfxU32>& cpus) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (mfxU32 cpu : cpus) {
+        if (cpu >= CPU_SETSIZE)
+            return MFX_ERR_UNSUPPORTED;
+        CPU_SET(cpu, &set);
+    }
+    int res = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    return res ? ErrnoToStatus(res) : MFX_ERR_NONE;
+}
+
+mfxStatus msdk_numa_set_preferred_node(mfxI32 node) {
+    if (node >= MSDK_NUMA_MAX_NODES)
+        return MFX_ERR_UNSUPPORTED;
+
+    long res;
+    if (node < 0) {
+        res = syscall(SYS_set_mempolicy, MSDK_MPOL_DEFAULT, NULL, 0);
+    }
+    else {
+        NodeMask mask((mfxU32)node);
+        res = syscall(SYS_set_mempolicy, MSDK_MPOL_PREFERRED, mask.bits, mask.maxnode);
+    }
+    return res ? ErrnoToStatus(errno) : MFX_ERR_NONE;
+}
+
+mfxStatus msdk_numa_bind_memory(void* ptr, size_t size, mfxU32 node) {
+    if (!ptr)
+        return MFX_ERR_NULL_PTR;
+    if (node >= MSDK_NUMA_MAX_NODES)
+        return MFX_ERR_UNSUPPORTED;
+
+    NodeMask mask(node);
+    long res = syscall(SYS_mbind,
+                       ptr,
+                       size,
+                       MSDK_MPOL_PREFERRED,
+                       mask.bits,
+                       mask.maxnode,
+                       MSDK_MPOL_MF_MOVE);
+    return res ? ErrnoToStatus(errno) : MFX_ERR_NONE;
+}
+
+mfxStatus msdk_numa_get_memory_nodes(const void* ptr,
+                                     size_t size,
+                                     std::vector<mfxU64>& bytesPerNode) {
+    if (!ptr)
+        return MFX_ERR_NULL_PTR;
+
+    const size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    const size_t batch    = 1024;
+    uintptr_t first       = (uintptr_t)ptr & ~(uintptr_t)(pageSize - 1);
+    size_t numPages       = ((uintptr_t)ptr + size - first + pageSize - 1) / pageSize;
+
+    // move_pages without target nodes only reports the node of every page
+    std::vector<void*> pages(batch);
+    std::vector<int> status(batch);
+    for (size_t done = 0; done < numPages; done += batch) {
+        size_t count = std::min(batch, numPages - done);
+        for (size_t i = 0; i < count; i++)
+            pages[i] = (void*)(first + (done + i) * pageSize);
+        if (syscall(SYS_move_pages, 0, count, pages.data(), NULL, status.data(), 0))
+            return ErrnoToStatus(errno);
+
+        for (size_t i = 0; i < count; i++) {
+            if (status[i] < 0)
+                continue; // not resident
+            if ((size_t)status[i] >= bytesPerNode.size())
+                bytesPerNode.resize(status[i] + 1);
+            bytesPerNode[status[i]] += pageSize;
+        }
+    }
+    return MFX_ERR_NONE;
+}
+
+mfxStatus msdk_numa_get_process_memory(std::vector<mfxU64>& bytesPerNode) {
+    bytesPerNode.clear();
+    FILE* file = fopen("/proc/self/numa_maps", "r");
+    if (!file)
+        return MFX_ERR_UNSUPPORTED;
+
+    // a line per mapping, "N<node>=<pages>" per node and the page size in the end
+    char* line      = NULL;
+    size_t capacity = 0;
+    std::vector<mfxU64> pages;
+    while (getline(&line, &capacity, file) > 0) {
+        pages.clear();
+        mfxU64 pageSize = 4096;
+        for (char* token = strtok(line, " \n"); token; token = strtok(NULL, " \n")) {
+            unsigned node;
+            unsigned long long value;
+            if (sscanf(token, "N%u=%llu", &node, &value) == 2 && node < MSDK_NUMA_MAX_NODES) {
+                if (node >= pages.size())
+                    pages.resize(node + 1);
+                pages[node] += value;
+            }
+            else if (sscanf(token, "kernelpagesize_kB=%llu", &value) == 1) {
+                pageSize = value * 1024;
+            }
+        }
+        if (pages.size() > bytesPerNode.size())
+            bytesPerNode.resize(pages.size());
+        for (size_t node = 0; node < pages.size(); node++)
+            bytesPerNode[node] += pages[node] * pageSize;
+    }
+    free(line);
+    fclose(file);
+    return MFX_ERR_NONE;
+}
+
+#endif // #if !defined(_WIN32) && !defined(_WIN64)
@@ -0,0 +1,59 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include <random>
+#include <vector>
+
+#include "avc_spl.h"
+#include "bench.h"
+#include "stream_builder.h"
+
+using namespace ProtectedLibrary;
+using namespace StreamBuilder;
+
+namespace {
+// keeps the decoded values alive
+volatile mfxU32 g_sink;
+} // namespace
+
+SAMPLE_BENCH(AvcHeaders) {
+    std::mt19937 rng(2021);
+
+    // header-like mix of short Exp-Golomb codes and flags
+    const mfxU32 count = 1024 * 1024;
+    std::geometric_distribution<mfxU32> value(0.3);
+    BitWriter writer;
+    for (mfxU32 i = 0; i < count; i++) {
+        writer.PutUE(value(rng));
+        writer.PutBits(i & 1, 1);
+    }
+    Bytes codes = writer.Finish();
+
+    runner.Run("GetVLCElement", codes.size(), [&]() {
+        AVCBaseBitstream bs(codes.data(), (mfxU32)codes.size());
+        mfxU32 sum = 0;
+        for (mfxU32 i = 0; i < count; i++) {
+            sum += bs.GetVLCElement(false);
+            sum += bs.Get1Bit();
+        }
+        g_sink = sum;
+    });
+
+    // one slice per macroblock row with short payloads, the splitter mostly parses headers
+    Stream avc = MakeAVCStream(120, 68, std::vector<mfxU32>(200, 68 * 16), 68, rng);
+
+    runner.Run("AVC_Spl/68 slices", avc.data.size(), [&]() {
+        mfxBitstream bs = {};
+        bs.Data         = avc.data.data();
+        bs.DataLength = bs.MaxLength = (mfxU32)avc.data.size();
+        bs.DataFlag                  = MFX_BITSTREAM_EOS;
+
+        AVC_Spl splitter;
+        FrameSplitterInfo* frame = NULL;
+        while (splitter.GetFrame(&bs, &frame) == MFX_ERR_NONE && frame)
+            splitter.ResetCurrentState();
+    });
+}
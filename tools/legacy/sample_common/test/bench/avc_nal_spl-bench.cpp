@@ -0,0 +1,34 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include <random>
+#include <vector>
+
+#include "avc_nal_spl.h"
+#include "bench.h"
+#include "stream_builder.h"
+
+using namespace ProtectedLibrary;
+using namespace StreamBuilder;
+
+// Start code and emulation prevention scanning of a 16MB stream with 64KB slices
+SAMPLE_BENCH(AvcNalSplitter) {
+    std::mt19937 rng(2021);
+    Stream avc = MakeAVCStream(120, 68, std::vector<mfxU32>(64, 256 * 1024), 4, rng);
+    Bytes out(avc.data.size() + 8);
+
+    runner.Run("FindNextStartCode", avc.data.size(), [&]() {
+        mfxU8* pb            = avc.data.data();
+        mfxU32 size          = (mfxU32)avc.data.size();
+        mfxI32 startCodeSize = 0;
+        while (FindNextStartCode(pb, size, startCodeSize)) {
+        }
+    });
+
+    runner.Run("RemovePreventingBytes", avc.data.size(), [&]() {
+        RemovePreventingBytes(out.data(), avc.data.data(), (mfxU32)avc.data.size());
+    });
+}
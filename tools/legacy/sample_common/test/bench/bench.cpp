@@ -0,0 +1,112 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <chrono>
+#include <utility>
+#include <vector>
+
+namespace {
+
+std::vector<std::pair<const char*, BenchGroupFn>>& GetGroups() {
+    static std::vector<std::pair<const char*, BenchGroupFn>> groups;
+    return groups;
+}
+
+void Usage() {
+    printf("Usage: sample_common_bench [-f filter] [-t seconds] [-l]\n");
+    printf("   -f filter   run only cases which names contain filter\n");
+    printf("   -t seconds  time to run every case (default 0.5)\n");
+    printf("   -l          list benchmark groups\n");
+}
+
+} // namespace
+
+BenchRegistrar::BenchRegistrar(const char* group, BenchGroupFn fn) {
+    GetGroups().push_back(std::make_pair(group, fn));
+}
+
+BenchRunner::BenchRunner(const std::string& filter, double seconds)
+        : m_filter(filter),
+          m_seconds(seconds) {}
+
+bool BenchRunner::Skip(const std::string& name) const {
+    return !m_filter.empty() && name.find(m_filter) == std::string::npos;
+}
+
+double BenchRunner::Measure(const std::function<void()>& body, double* cpuTime) const {
+    typedef std::chrono::steady_clock clock;
+
+    // warm up caches and lazy initialization
+    body();
+
+    size_t iterations = 0;
+    clock_t cpuStart  = ::clock();
+    auto start        = clock::now();
+    auto elapsed      = clock::duration::zero();
+    size_t batch      = 1;
+    while (std::chrono::duration<double>(elapsed).count() < m_seconds) {
+        for (size_t i = 0; i < batch; i++)
+            body();
+        iterations += batch;
+        elapsed = clock::now() - start;
+        if (batch < 1024)
+            batch *= 2;
+    }
+    if (cpuTime)
+        *cpuTime = (double)(::clock() - cpuStart) / CLOCKS_PER_SEC / iterations;
+    return std::chrono::duration<double>(elapsed).count() / iterations;
+}
+
+void BenchRunner::Run(const std::string& name, size_t bytes, const std::function<void()>& body) {
+    if (Skip(name))
+        return;
+    double t = Measure(body);
+    printf("%-48s %10.3f us %10.2f GB/s\n", name.c_str(), t * 1e6, bytes / t / 1e9);
+    fflush(stdout);
+}
+
+void BenchRunner::RunLatency(const std::string& name, const std::function<void()>& body) {
+    if (Skip(name))
+        return;
+    double cpu = 0;
+    double t   = Measure(body, &cpu);
+    printf("%-48s %10.3f us %10.3f us cpu\n", name.c_str(), t * 1e6, cpu * 1e6);
+    fflush(stdout);
+}
+
+int main(int argc, char* argv[]) {
+    std::string filter;
+    double seconds = 0.5;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-f") && i + 1 < argc) {
+            filter = argv[++i];
+        }
+        else if (!strcmp(argv[i], "-t") && i + 1 < argc) {
+            seconds = atof(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "-l")) {
+            for (auto& group : GetGroups())
+                printf("%s\n", group.first);
+            return 0;
+        }
+        else {
+            Usage();
+            return 1;
+        }
+    }
+
+    BenchRunner runner(filter, seconds);
+    for (auto& group : GetGroups())
+        group.second(runner);
+    return 0;
+}
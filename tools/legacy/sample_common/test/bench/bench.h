@@ -0,0 +1,49 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#ifndef __SAMPLE_COMMON_BENCH_H__
+#define __SAMPLE_COMMON_BENCH_H__
+
+#include <stddef.h>
+#include <functional>
+#include <string>
+
+// Minimal throughput benchmark harness for sample_common.
+// Every benchmark group registers itself with SAMPLE_BENCH and reports cases
+// through BenchRunner::Run, which repeats the body for the configured time and
+// prints the processed data rate.
+class BenchRunner {
+public:
+    BenchRunner(const std::string& filter, double seconds);
+
+    // Runs body repeatedly, bytes is the amount of data processed by one call
+    void Run(const std::string& name, size_t bytes, const std::function<void()>& body);
+
+    // Runs body repeatedly and reports the time of one call and the CPU time the process
+    // spent on it in all threads
+    void RunLatency(const std::string& name, const std::function<void()>& body);
+
+private:
+    bool Skip(const std::string& name) const;
+    // Returns average time of one call in seconds, cpuTime is set to the average CPU time
+    double Measure(const std::function<void()>& body, double* cpuTime = nullptr) const;
+
+    std::string m_filter;
+    double m_seconds;
+};
+
+typedef void (*BenchGroupFn)(BenchRunner& runner);
+
+struct BenchRegistrar {
+    BenchRegistrar(const char* group, BenchGroupFn fn);
+};
+
+#define SAMPLE_BENCH(group)                                         \
+    static void group##_Bench(BenchRunner& runner);                 \
+    static BenchRegistrar group##_registrar(#group, group##_Bench); \
+    static void group##_Bench(BenchRunner& runner)
+
+#endif //__SAMPLE_COMMON_BENCH_H__
@@ -0,0 +1,106 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include <stdio.h>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "sample_utils.h"
+#include "stream_builder.h"
+
+using namespace StreamBuilder;
+
+namespace {
+
+// Reads the whole file like sample_decode does: the bitstream starts at 1MB, grows when
+// the reader asks for it and every frame is consumed completely
+void ReadAllFrames(CSmplBitstreamReader& reader, const std::string& path) {
+    if (reader.Init(path.c_str()) != MFX_ERR_NONE)
+        return;
+
+    mfxBitstreamWrapper bs(1024 * 1024);
+    for (;;) {
+        mfxStatus sts = reader.ReadNextFrame(&bs);
+        if (MFX_ERR_NOT_ENOUGH_BUFFER == sts) {
+            bs.Extend(bs.MaxLength * 2);
+            continue;
+        }
+        if (MFX_ERR_NONE != sts || !bs.DataLength)
+            break;
+        bs.DataOffset += bs.DataLength;
+        bs.DataLength = 0;
+    }
+    reader.Close();
+}
+
+} // namespace
+
+// Multi-megabyte frames, the files stay in the page cache between iterations
+SAMPLE_BENCH(BitstreamReaders) {
+    const std::string path = "sample_common_bench_stream.bin";
+    std::mt19937 rng(2021);
+
+    Stream mjpeg = MakeMJPEGStream(std::vector<mfxU32>(8, 4 * 1024 * 1024), rng);
+    if (WriteStream(path.c_str(), mjpeg.data)) {
+        runner.Run("JPEGFrameReader/4MB", mjpeg.data.size(), [&]() {
+            CJPEGFrameReader reader;
+            ReadAllFrames(reader, path);
+        });
+    }
+
+    Stream avc = MakeAVCStream(120, 68, std::vector<mfxU32>(8, 2 * 1024 * 1024), 4, rng);
+    if (WriteStream(path.c_str(), avc.data)) {
+        runner.Run("H264FrameReader/2MB", avc.data.size(), [&]() {
+            CH264FrameReader reader;
+            ReadAllFrames(reader, path);
+        });
+    }
+
+    // 4K frames, the slices don't fit the initial reader buffer
+    Stream avc4k = MakeAVCStream(240, 135, std::vector<mfxU32>(8, 4 * 1024 * 1024), 4, rng);
+    if (WriteStream(path.c_str(), avc4k.data)) {
+        runner.Run("H264FrameReader/4K", avc4k.data.size(), [&]() {
+            CH264FrameReader reader;
+            ReadAllFrames(reader, path);
+        });
+    }
+
+    Stream hevc = MakeHEVCStream(std::vector<mfxU32>(8, 2 * 1024 * 1024), 4, rng);
+    if (WriteStream(path.c_str(), hevc.data)) {
+        runner.Run("H265FrameReader/2MB", hevc.data.size(), [&]() {
+            CH265FrameReader reader;
+            ReadAllFrames(reader, path);
+        });
+    }
+
+    Stream av1 = MakeAV1Stream(std::vector<mfxU32>(8, 4 * 1024 * 1024), false, rng);
+    if (WriteStream(path.c_str(), av1.data)) {
+        runner.Run("AV1FrameReader/4MB", av1.data.size(), [&]() {
+            CAV1FrameReader reader;
+            ReadAllFrames(reader, path);
+        });
+    }
+
+    Stream av1AnnexB = MakeAV1Stream(std::vector<mfxU32>(8, 4 * 1024 * 1024), true, rng);
+    if (WriteStream(path.c_str(), av1AnnexB.data)) {
+        runner.Run("AV1FrameReader/AnnexB/4MB", av1AnnexB.data.size(), [&]() {
+            CAV1FrameReader reader;
+            ReadAllFrames(reader, path);
+        });
+    }
+
+    Stream ivf = MakeIVFStream(std::vector<mfxU32>(8, 4 * 1024 * 1024), rng);
+    if (WriteStream(path.c_str(), ivf.data)) {
+        runner.Run("IVFFrameReader/4MB", ivf.data.size(), [&]() {
+            CIVFFrameReader reader;
+            ReadAllFrames(reader, path);
+        });
+    }
+
+    remove(path.c_str());
+}
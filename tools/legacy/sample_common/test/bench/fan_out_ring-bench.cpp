@@ -0,0 +1,119 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "bench.h"
+#include "fan_out_ring.h"
+
+namespace {
+
+const mfxU32 numConsumers = 4;
+const mfxU32 numFrames    = 10000;
+const mfxU32 depth        = 8;
+
+struct Frame {
+    void* surface;
+    void* syncp;
+};
+
+// 1 to N hand over of sample_multi_transcode: every encoding session reads all frames
+void HandOverRing() {
+    msdkFanOutRing<Frame> ring;
+    ring.Init(depth, numConsumers);
+
+    std::vector<std::thread> consumers;
+    for (mfxU32 consumer = 0; consumer < numConsumers; consumer++) {
+        consumers.emplace_back([&ring, consumer]() {
+            for (mfxU32 i = 0; i < numFrames; i++) {
+                Frame frame;
+                while (ring.Peek(consumer, frame) != MFX_ERR_NONE)
+                    ring.Wait(consumer, 1000);
+                ring.Release(consumer);
+            }
+        });
+    }
+    for (mfxU32 i = 0; i < numFrames; i++) {
+        Frame frame = { &ring, NULL };
+        ring.Push(frame, 1000);
+    }
+    for (std::thread& consumer : consumers)
+        consumer.join();
+}
+
+// The same with a list per consumer guarded by a mutex, as the buffers chained before
+class MutexBuffer {
+public:
+    void Add(const Frame& frame) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_released.wait(lock, [this]() {
+            return m_frames.size() < depth;
+        });
+        m_frames.push_back(frame);
+        lock.unlock();
+        m_inserted.notify_one();
+    }
+
+    void Get(Frame& frame) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_inserted.wait(lock, [this]() {
+            return !m_frames.empty();
+        });
+        frame = m_frames.front();
+    }
+
+    void Release(const Frame& frame) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (auto it = m_frames.begin(); it != m_frames.end(); it++) {
+            if (it->surface == frame.surface) {
+                m_frames.erase(it);
+                break;
+            }
+        }
+        lock.unlock();
+        m_released.notify_one();
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_inserted;
+    std::condition_variable m_released;
+    std::list<Frame> m_frames;
+};
+
+void HandOverMutex() {
+    std::vector<MutexBuffer> buffers(numConsumers);
+
+    std::vector<std::thread> consumers;
+    for (MutexBuffer& buffer : buffers) {
+        consumers.emplace_back([&buffer]() {
+            for (mfxU32 i = 0; i < numFrames; i++) {
+                Frame frame;
+                buffer.Get(frame);
+                buffer.Release(frame);
+            }
+        });
+    }
+    for (mfxU32 i = 0; i < numFrames; i++) {
+        Frame frame = { &buffers, NULL };
+        for (MutexBuffer& buffer : buffers)
+            buffer.Add(frame);
+    }
+    for (std::thread& consumer : consumers)
+        consumer.join();
+}
+
+} // namespace
+
+// Time to hand numFrames frames over to numConsumers threads
+SAMPLE_BENCH(FanOut) {
+    runner.RunLatency("HandOver10kTo4/Ring", HandOverRing);
+    runner.RunLatency("HandOver10kTo4/Mutex", HandOverMutex);
+}
@@ -0,0 +1,57 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "frame_kernels.h"
+
+using namespace FrameKernels;
+
+// Kernels process one 1920x1080 frame worth of samples per call
+SAMPLE_BENCH(FrameKernels) {
+    const mfxU32 pixels = 1920 * 1080;
+    const mfxU32 chroma = pixels / 4;
+
+    std::vector<mfxU8> u8(pixels * 4, 0x5a), v8(pixels * 4, 0xa5), out8(pixels * 4);
+    std::vector<mfxU16> y16(pixels, 0x155), u16(pixels, 0x2aa), v16(pixels, 0x3ff);
+    std::vector<mfxU16> out16(pixels * 2);
+    std::vector<mfxU32> out32(pixels);
+
+    for (int isa = ISA_SCALAR; isa < ISA_COUNT; isa++) {
+        if (!IsIsaSupported((Isa)isa))
+            continue;
+        const KernelTable& k = *GetKernels((Isa)isa);
+        std::string suffix   = std::string("/") + GetIsaName((Isa)isa);
+
+        runner.Run("InterleaveUV" + suffix, chroma * 4, [&]() {
+            k.InterleaveUV(u8.data(), v8.data(), out8.data(), chroma);
+        });
+        runner.Run("DeinterleaveUV" + suffix, chroma * 4, [&]() {
+            k.DeinterleaveUV(u8.data(), out8.data(), v8.data(), chroma);
+        });
+        runner.Run("ShiftLeft16" + suffix, pixels * 4, [&]() {
+            k.ShiftLeft16(y16.data(), out16.data(), pixels, 6);
+        });
+        runner.Run("ShiftRight16" + suffix, pixels * 4, [&]() {
+            k.ShiftRight16(y16.data(), out16.data(), pixels, 6);
+        });
+        runner.Run("PackY210" + suffix, pixels * 8, [&]() {
+            k.PackY210(y16.data(), u16.data(), v16.data(), out16.data(), pixels / 2, 6);
+        });
+        runner.Run("PackY410" + suffix, pixels * 10, [&]() {
+            k.PackY410(y16.data(), u16.data(), v16.data(), out32.data(), pixels);
+        });
+        runner.Run("SwapRB32" + suffix, pixels * 8, [&]() {
+            k.SwapRB32(u8.data(), out8.data(), pixels);
+        });
+        // no start code, the whole buffer is scanned
+        runner.Run("FindZeroZeroByte" + suffix, pixels * 4, [&]() {
+            k.FindZeroZeroByte(u8.data(), pixels * 4, 1);
+        });
+    }
+}
@@ -0,0 +1,141 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "bench.h"
+#include "mfx_buffering.h"
+
+namespace {
+
+const mfxU32 numSurfaces = 8;
+const mfxU32 numFrames   = 10000;
+
+class BenchBuffering : public CBuffering {
+public:
+    BenchBuffering() {
+        AllocBuffers(numSurfaces);
+    }
+    ~BenchBuffering() {
+        FreeBuffers();
+    }
+
+    // The decoding loop of sample_decode in the rendering mode: the decoding thread takes a free
+    // surface and an output surface and hands them over to the delivering thread, which returns
+    // them
+    void HandOver() {
+        std::atomic<bool> stop(false);
+        std::thread deliver([&]() {
+            while (!stop || m_DeliveredSurfacesPool.GetSurfaceCount()) {
+                msdkOutputSurface* output = m_DeliveredSurfacesPool.GetSurface();
+                if (output)
+                    ReturnSurfaceToBuffers(output);
+                else
+                    std::this_thread::yield();
+            }
+        });
+
+        for (mfxU32 i = 0; i < numFrames;) {
+            SyncFrameSurfaces();
+            msdkFrameSurface* surface = m_FreeSurfacesPool.GetSurface();
+            if (!surface) {
+                std::this_thread::yield();
+                continue;
+            }
+            m_UsedSurfacesPool.AddSurface(surface);
+            msdk_atomic_inc16(&surface->render_lock);
+
+            msdkOutputSurface* output = GetFreeOutputSurface();
+            output->surface           = surface;
+            output->syncp             = (mfxSyncPoint)surface;
+            m_DeliveredSurfacesPool.AddSurface(output);
+            i++;
+        }
+        stop = true;
+        deliver.join();
+    }
+};
+
+// The same hand over with the lists guarded by one mutex
+class MutexBuffering {
+public:
+    MutexBuffering() : m_surfaces(numSurfaces), m_free(), m_delivered(), m_mutex() {
+        for (Surface& surface : m_surfaces)
+            m_free.push_back(&surface);
+    }
+
+    void HandOver() {
+        std::atomic<bool> stop(false);
+        std::thread deliver([&]() {
+            for (;;) {
+                Surface* surface = NULL;
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    if (m_delivered.empty() && stop)
+                        break;
+                    if (!m_delivered.empty()) {
+                        surface = m_delivered.front();
+                        m_delivered.erase(m_delivered.begin());
+                    }
+                }
+                if (surface) {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_free.push_back(surface);
+                }
+                else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+
+        for (mfxU32 i = 0; i < numFrames;) {
+            Surface* surface = NULL;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (!m_free.empty()) {
+                    surface = m_free.back();
+                    m_free.pop_back();
+                }
+            }
+            if (!surface) {
+                std::this_thread::yield();
+                continue;
+            }
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_delivered.push_back(surface);
+            i++;
+        }
+        stop = true;
+        deliver.join();
+    }
+
+private:
+    struct Surface {
+        mfxU8 data[64];
+    };
+    std::vector<Surface> m_surfaces;
+    std::vector<Surface*> m_free;
+    std::vector<Surface*> m_delivered;
+    std::mutex m_mutex;
+};
+
+} // namespace
+
+// Time to pass numFrames surfaces from the decoding to the delivering thread and back
+SAMPLE_BENCH(Buffering) {
+    BenchBuffering lockFree;
+    runner.RunLatency("HandOver10k/LockFree", [&]() {
+        lockFree.HandOver();
+    });
+
+    MutexBuffering mutex;
+    runner.RunLatency("HandOver10k/Mutex", [&]() {
+        mutex.HandOver();
+    });
+}
@@ -0,0 +1,83 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include <string.h>
+#include <string>
+
+#include "bench.h"
+#include "sysmem_allocator.h"
+
+// Allocates a pool of 3840x2160 NV12 frames, writes every frame once and frees the pool,
+// the cost of a decoder surface pool set up on a resolution change
+SAMPLE_BENCH(SysMemAllocator) {
+    const mfxU16 numFrames = 8;
+    const mfxU32 frameSize = 3840 * 2160 * 3 / 2;
+
+    struct Mode {
+        const char* name;
+        bool bUseArena;
+        SysMemHugePages hugePages;
+        bool bPrefault;
+    };
+    const Mode modes[] = {
+        { "Buffers", false, SYSMEM_HUGEPAGES_OFF, false },
+        { "Arena", true, SYSMEM_HUGEPAGES_OFF, false },
+        { "Arena/THP", true, SYSMEM_HUGEPAGES_THP, false },
+        { "Arena/THP/Prefault", true, SYSMEM_HUGEPAGES_THP, true },
+        { "Arena/HugeTLB", true, SYSMEM_HUGEPAGES_HUGETLB, false },
+    };
+
+    for (const Mode& mode : modes) {
+        SysMemAllocatorParams params;
+        params.bUseArena = mode.bUseArena;
+        params.HugePages = mode.hugePages;
+        params.bPrefault = mode.bPrefault;
+
+        mfxFrameAllocRequest request = {};
+        request.Info.FourCC          = MFX_FOURCC_NV12;
+        request.Info.ChromaFormat    = MFX_CHROMAFORMAT_YUV420;
+        request.Info.Width           = 3840;
+        request.Info.Height          = 2160;
+        request.Type =
+            MFX_MEMTYPE_SYSTEM_MEMORY | MFX_MEMTYPE_INTERNAL_FRAME | MFX_MEMTYPE_FROM_VPPOUT;
+        request.NumFrameSuggested = numFrames;
+
+        // a new allocator every time, released slabs of the arena would be reused otherwise
+        runner.Run(std::string("AllocWriteFree/") + mode.name, numFrames * frameSize, [&]() {
+            SysMemFrameAllocator allocator;
+            allocator.Init(&params);
+            mfxFrameAllocResponse response = {};
+            if (allocator.AllocFrames(&request, &response) != MFX_ERR_NONE)
+                return;
+            for (mfxU32 i = 0; i < numFrames; i++) {
+                mfxFrameData data = {};
+                allocator.LockFrame(response.mids[i], &data);
+                memset(data.Y, 0x80, frameSize);
+                allocator.UnlockFrame(response.mids[i], &data);
+            }
+            allocator.FreeFrames(&response);
+        });
+
+        // the frames written again, the TLB reach decides
+        SysMemFrameAllocator allocator;
+        allocator.Init(&params);
+        mfxFrameAllocResponse response = {};
+        if (allocator.AllocFrames(&request, &response) != MFX_ERR_NONE)
+            continue;
+        mfxFrameData frames[numFrames] = {};
+        for (mfxU32 i = 0; i < numFrames; i++)
+            allocator.LockFrame(response.mids[i], &frames[i]);
+
+        runner.Run(std::string("Write/") + mode.name, numFrames * frameSize, [&]() {
+            for (mfxU32 i = 0; i < numFrames; i++)
+                memset(frames[i].Y, 0x10 + i, frameSize);
+        });
+
+        for (mfxU32 i = 0; i < numFrames; i++)
+            allocator.UnlockFrame(response.mids[i], &frames[i]);
+        allocator.FreeFrames(&response);
+    }
+}
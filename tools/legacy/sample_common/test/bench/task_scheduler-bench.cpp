@@ -0,0 +1,70 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include <vector>
+
+#include "bench.h"
+#include "task_scheduler.h"
+
+namespace {
+
+const mfxU32 numSessions = 256;
+const mfxU32 numFrames   = 32;
+const mfxU32 frameSize   = 176 * 144 * 3 / 2;
+
+// A light session of sample_multi_transcode, every step touches one QCIF frame
+class Session {
+public:
+    Session() : m_frame(frameSize, 1), m_frames(0), m_sum(0) {}
+
+    mfxStatus Step() {
+        for (mfxU8 pixel : m_frame)
+            m_sum += pixel;
+        m_frame[m_sum % frameSize]++;
+        return ++m_frames < numFrames ? MFX_TASK_WORKING : MFX_ERR_NONE;
+    }
+
+private:
+    std::vector<mfxU8> m_frame;
+    mfxU32 m_frames;
+    mfxU32 m_sum;
+};
+
+void Transcode(bool bPool) {
+    std::vector<Session> sessions(numSessions);
+
+    CTaskScheduler scheduler;
+    if (bPool)
+        scheduler.Start(0);
+    for (mfxU32 i = 0; i < numSessions; i++) {
+        Session* session = &sessions[i];
+        auto step        = [session]() {
+            return session->Step();
+        };
+        if (bPool)
+            scheduler.Submit(i, step);
+        else
+            scheduler.SubmitDedicated(i, step);
+    }
+
+    mfxU32 id        = 0;
+    mfxStatus result = MFX_ERR_NONE;
+    while (scheduler.WaitForCompletion(1000, &id, &result) != MFX_ERR_NOT_FOUND)
+        ;
+}
+
+} // namespace
+
+// Time to run numSessions sessions of numFrames frames by a pool of as many workers as the
+// CPUs and by a thread per session
+SAMPLE_BENCH(Scheduler) {
+    runner.RunLatency("Sessions256x32/Pool", []() {
+        Transcode(true);
+    });
+    runner.RunLatency("Sessions256x32/ThreadPerSession", []() {
+        Transcode(false);
+    });
+}
@@ -0,0 +1,504 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#ifndef __STREAM_BUILDER_H__
+#define __STREAM_BUILDER_H__
+
+#include <stdio.h>
+#include <random>
+#include <vector>
+
+#include "vpl/mfxcommon.h"
+
+// Synthetic elementary streams for the bitstream reader tests and benchmarks.
+// Only the syntax parsed by the readers and splitters is valid, payloads are random.
+namespace StreamBuilder {
+
+typedef std::vector<mfxU8> Bytes;
+
+struct Stream {
+    Bytes data;
+    // frames as the frame readers are expected to return them
+    std::vector<Bytes> frames;
+};
+
+class BitWriter {
+public:
+    BitWriter() : m_data(), m_cur(0), m_bits(0) {}
+
+    void PutBits(mfxU32 value, mfxU32 count) {
+        while (count--) {
+            m_cur = (mfxU8)((m_cur << 1) | ((value >> count) & 1));
+            if (++m_bits == 8) {
+                m_data.push_back(m_cur);
+                m_cur  = 0;
+                m_bits = 0;
+            }
+        }
+    }
+
+    // Exp-Golomb codes
+    void PutUE(mfxU32 value) {
+        mfxU64 code = (mfxU64)value + 1;
+        mfxU32 len  = 0;
+        while (code >> len)
+            len++;
+        PutBits(0, len - 1);
+        PutBits((mfxU32)code, len);
+    }
+
+    void PutSE(mfxI32 value) {
+        PutUE(value > 0 ? 2 * (mfxU32)value - 1 : 2 * (mfxU32)(-value));
+    }
+
+    // rbsp_trailing_bits
+    Bytes Finish() {
+        PutBits(1, 1);
+        while (m_bits)
+            PutBits(0, 1);
+        return m_data;
+    }
+
+private:
+    Bytes m_data;
+    mfxU8 m_cur;
+    mfxU32 m_bits;
+};
+
+// Appends start code, NAL unit header and the payload with emulation prevention bytes
+inline void AppendNalUnit(Bytes& out,
+                          mfxU32 startCodeSize,
+                          const Bytes& header,
+                          const Bytes& rbsp) {
+    out.insert(out.end(), startCodeSize - 1, 0);
+    out.push_back(1);
+    out.insert(out.end(), header.begin(), header.end());
+
+    mfxU32 zeros = 0;
+    for (mfxU8 b : header)
+        zeros = b ? 0 : zeros + 1;
+    for (mfxU8 b : rbsp) {
+        if (zeros >= 2 && b <= 3) {
+            out.push_back(3);
+            zeros = 0;
+        }
+        out.push_back(b);
+        zeros = b ? 0 : zeros + 1;
+    }
+}
+
+inline void AppendNalUnit(Bytes& out, mfxU32 startCodeSize, mfxU8 header, const Bytes& rbsp) {
+    AppendNalUnit(out, startCodeSize, Bytes(1, header), rbsp);
+}
+
+// IDR-only baseline AVC stream. Every frame has the given number of slices with
+// frameSizes[i] payload bytes in total. The H.264 frame reader returns frames with
+// 3-byte start codes and SPS/PPS in front of the first frame.
+inline Stream MakeAVCStream(mfxU32 widthMbs,
+                            mfxU32 heightMbs,
+                            const std::vector<mfxU32>& frameSizes,
+                            mfxU32 slices,
+                            std::mt19937& rng) {
+    const mfxU8 spsHeader = 0x67, ppsHeader = 0x68, idrHeader = 0x65;
+
+    BitWriter sps;
+    sps.PutBits(66, 8); // profile_idc
+    sps.PutBits(0, 8); // constraint flags
+    sps.PutBits(40, 8); // level_idc
+    sps.PutUE(0); // seq_parameter_set_id
+    sps.PutUE(0); // log2_max_frame_num_minus4
+    sps.PutUE(2); // pic_order_cnt_type
+    sps.PutUE(1); // max_num_ref_frames
+    sps.PutBits(0, 1); // gaps_in_frame_num_value_allowed_flag
+    sps.PutUE(widthMbs - 1);
+    sps.PutUE(heightMbs - 1);
+    sps.PutBits(1, 1); // frame_mbs_only_flag
+    sps.PutBits(1, 1); // direct_8x8_inference_flag
+    sps.PutBits(0, 1); // frame_cropping_flag
+    sps.PutBits(0, 1); // vui_parameters_present_flag
+
+    BitWriter pps;
+    pps.PutUE(0); // pic_parameter_set_id
+    pps.PutUE(0); // seq_parameter_set_id
+    pps.PutBits(0, 1); // entropy_coding_mode_flag
+    pps.PutBits(0, 1); // bottom_field_pic_order_in_frame_present_flag
+    pps.PutUE(0); // num_slice_groups_minus1
+    pps.PutUE(0); // num_ref_idx_l0_default_active_minus1
+    pps.PutUE(0); // num_ref_idx_l1_default_active_minus1
+    pps.PutBits(0, 1); // weighted_pred_flag
+    pps.PutBits(0, 2); // weighted_bipred_idc
+    pps.PutSE(0); // pic_init_qp_minus26
+    pps.PutSE(0); // pic_init_qs_minus26
+    pps.PutSE(0); // chroma_qp_index_offset
+    pps.PutBits(1, 1); // deblocking_filter_control_present_flag
+    pps.PutBits(0, 1); // constrained_intra_pred_flag
+    pps.PutBits(0, 1); // redundant_pic_cnt_present_flag
+
+    Stream stream;
+    Bytes spsRbsp = sps.Finish(), ppsRbsp = pps.Finish();
+    AppendNalUnit(stream.data, 4, spsHeader, spsRbsp);
+    AppendNalUnit(stream.data, 4, ppsHeader, ppsRbsp);
+
+    std::uniform_int_distribution<mfxU32> byte(0, 255);
+    for (size_t i = 0; i < frameSizes.size(); i++) {
+        Bytes frame;
+        if (!i) {
+            AppendNalUnit(frame, 3, spsHeader, spsRbsp);
+            AppendNalUnit(frame, 3, ppsHeader, ppsRbsp);
+        }
+
+        for (mfxU32 s = 0; s < slices; s++) {
+            BitWriter slice;
+            slice.PutUE(s * widthMbs * heightMbs / slices); // first_mb_in_slice
+            slice.PutUE(7); // slice_type, I
+            slice.PutUE(0); // pic_parameter_set_id
+            slice.PutBits(0, 4); // frame_num
+            slice.PutUE((mfxU32)i & 0xffff); // idr_pic_id
+            slice.PutBits(0, 1); // no_output_of_prior_pics_flag
+            slice.PutBits(0, 1); // long_term_reference_flag
+            slice.PutSE(0); // slice_qp_delta
+            slice.PutUE(1); // disable_deblocking_filter_idc
+            for (mfxU32 n = frameSizes[i] / slices; n; n--)
+                slice.PutBits(byte(rng), 8);
+
+            Bytes rbsp = slice.Finish();
+            AppendNalUnit(stream.data, 4, idrHeader, rbsp);
+            AppendNalUnit(frame, 3, idrHeader, rbsp);
+        }
+        stream.frames.push_back(frame);
+    }
+    return stream;
+}
+
+// HEVC stream with one VPS, SPS and PPS, 64x64 CTBs, 8 bit POC LSBs and three temporal
+// sub-layers. Frames are expected as the HEVC splitter returns them: NAL units with 3-byte
+// start codes grouped in access units, the stream uses 4-byte start codes.
+class HEVCStreamBuilder {
+public:
+    enum {
+        TRAIL_N    = 0,
+        TRAIL_R    = 1,
+        RADL_N     = 6,
+        RASL_N     = 8,
+        RASL_R     = 9,
+        BLA_W_LP   = 16,
+        IDR_W_RADL = 19,
+        IDR_N_LP   = 20,
+        CRA        = 21,
+        VPS        = 32,
+        SPS        = 33,
+        PPS        = 34,
+        AUD        = 35,
+        EOS        = 36,
+        PREFIX_SEI = 39,
+        SUFFIX_SEI = 40
+    };
+    enum { SLICE_B = 0, SLICE_P = 1, SLICE_I = 2 };
+
+    HEVCStreamBuilder(std::mt19937& rng, mfxU32 width = 1920, mfxU32 height = 1080)
+            : m_rng(rng),
+              m_ctbs(((width + 63) / 64) * ((height + 63) / 64)),
+              m_addressBits(0),
+              m_returned(true) {
+        while ((1u << m_addressBits) < m_ctbs)
+            m_addressBits++;
+
+        BitWriter vps;
+        vps.PutBits(0, 4); // vps_video_parameter_set_id
+        vps.PutBits(3, 2); // vps_base_layer_internal_flag, vps_base_layer_available_flag
+        vps.PutBits(0, 6); // vps_max_layers_minus1
+        vps.PutBits(2, 3); // vps_max_sub_layers_minus1
+        vps.PutBits(1, 1); // vps_temporal_id_nesting_flag
+        vps.PutBits(0xffff, 16); // vps_reserved_0xffff_16bits
+        vps.PutBits(0x12345678, 32); // not parsed
+        m_vps = vps.Finish();
+
+        BitWriter sps;
+        sps.PutBits(0, 4); // sps_video_parameter_set_id
+        sps.PutBits(2, 3); // sps_max_sub_layers_minus1
+        sps.PutBits(1, 1); // sps_temporal_id_nesting_flag
+        sps.PutBits(1, 8); // general_profile_space, general_tier_flag, general_profile_idc
+        sps.PutBits(0x60000000, 32); // general_profile_compatibility_flag
+        sps.PutBits(0x9000, 16); // general source and constraint flags
+        sps.PutBits(0, 32);
+        sps.PutBits(123, 8); // general_level_idc
+        sps.PutBits(0xc, 4); // sub_layer_profile_present_flag, sub_layer_level_present_flag
+        sps.PutBits(0, 12); // reserved_zero_2bits
+        sps.PutBits(0x10000000, 32); // sub-layer 0 profile
+        sps.PutBits(0, 32);
+        sps.PutBits(0, 24);
+        sps.PutBits(90, 8); // sub_layer_level_idc
+        sps.PutUE(0); // sps_seq_parameter_set_id
+        sps.PutUE(1); // chroma_format_idc
+        sps.PutUE(width); // pic_width_in_luma_samples
+        sps.PutUE(height); // pic_height_in_luma_samples
+        sps.PutBits(1, 1); // conformance_window_flag
+        for (mfxU32 i = 0; i < 4; i++)
+            sps.PutUE(0);
+        sps.PutUE(2); // bit_depth_luma_minus8
+        sps.PutUE(2); // bit_depth_chroma_minus8
+        sps.PutUE(4); // log2_max_pic_order_cnt_lsb_minus4
+        sps.PutBits(1, 1); // sps_sub_layer_ordering_info_present_flag
+        for (mfxU32 i = 0; i < 3; i++) {
+            sps.PutUE(4);
+            sps.PutUE(2);
+            sps.PutUE(0);
+        }
+        sps.PutUE(0); // log2_min_luma_coding_block_size_minus3
+        sps.PutUE(3); // log2_diff_max_min_luma_coding_block_size
+        sps.PutBits(0x5a5a5a5a, 32); // not parsed
+        m_sps = sps.Finish();
+
+        BitWriter pps;
+        pps.PutUE(0); // pps_pic_parameter_set_id
+        pps.PutUE(0); // pps_seq_parameter_set_id
+        pps.PutBits(1, 1); // dependent_slice_segments_enabled_flag
+        pps.PutBits(0, 1); // output_flag_present_flag
+        pps.PutBits(0, 3); // num_extra_slice_header_bits
+        pps.PutBits(0xa5a5, 16); // not parsed
+        m_pps = pps.Finish();
+    }
+
+    // Starts the next access unit, the splitter drops the access units which aren't returned
+    void NewFrame(bool returned = true) {
+        m_returned = returned;
+        if (m_returned)
+            stream.frames.emplace_back();
+    }
+
+    void ParameterSets() {
+        NalUnit(VPS, m_vps);
+        NalUnit(SPS, m_sps);
+        NalUnit(PPS, m_pps);
+    }
+
+    void NalUnit(mfxU32 type, const Bytes& rbsp, mfxU32 temporalId = 0) {
+        Bytes header = { (mfxU8)(type << 1), (mfxU8)(temporalId + 1) };
+        AppendNalUnit(stream.data, 4, header, rbsp);
+        if (m_returned)
+            AppendNalUnit(stream.frames.back(), 3, header, rbsp);
+    }
+
+    // Writes the slice segments of a picture, every second segment is dependent if
+    // dependentSegments is set. The segment sizes are slice header plus payload bytes.
+    void Picture(mfxU32 type,
+                 mfxU32 sliceType,
+                 mfxU32 pocLsb,
+                 mfxU32 segments,
+                 mfxU32 payloadSize,
+                 mfxU32 temporalId      = 0,
+                 bool dependentSegments = false,
+                 bool firstSegment      = true) {
+        std::uniform_int_distribution<mfxU32> byte(0, 255);
+        for (mfxU32 s = 0; s < segments; s++) {
+            bool dependent = dependentSegments && (s & 1);
+
+            BitWriter slice;
+            slice.PutBits(!s && firstSegment, 1); // first_slice_segment_in_pic_flag
+            if (type >= BLA_W_LP && type <= 23)
+                slice.PutBits(0, 1); // no_output_of_prior_pics_flag
+            slice.PutUE(0); // slice_pic_parameter_set_id
+            if (s || !firstSegment) {
+                slice.PutBits(dependent, 1); // dependent_slice_segment_flag
+                slice.PutBits(s * m_ctbs / segments + !firstSegment, m_addressBits);
+            }
+            if (!dependent) {
+                slice.PutUE(sliceType);
+                if (type != IDR_W_RADL && type != IDR_N_LP)
+                    slice.PutBits(pocLsb & 0xff, 8);
+            }
+            for (mfxU32 n = payloadSize; n; n--)
+                slice.PutBits(byte(m_rng), 8);
+
+            NalUnit(type, slice.Finish(), temporalId);
+        }
+    }
+
+    Stream stream;
+
+private:
+    std::mt19937& m_rng;
+    mfxU32 m_ctbs;
+    mfxU32 m_addressBits;
+    bool m_returned;
+    Bytes m_vps, m_sps, m_pps;
+};
+
+// HEVC stream of an IDR picture followed by P pictures, every picture has the given number
+// of slice segments with frameSizes[i] payload bytes in total
+inline Stream MakeHEVCStream(const std::vector<mfxU32>& frameSizes,
+                             mfxU32 slices,
+                             std::mt19937& rng) {
+    HEVCStreamBuilder builder(rng);
+    for (size_t i = 0; i < frameSizes.size(); i++) {
+        builder.NewFrame();
+        if (!i)
+            builder.ParameterSets();
+        builder.Picture(i ? HEVCStreamBuilder::TRAIL_R : HEVCStreamBuilder::IDR_W_RADL,
+                        i ? HEVCStreamBuilder::SLICE_P : HEVCStreamBuilder::SLICE_I,
+                        (mfxU32)i,
+                        slices,
+                        frameSizes[i] / slices);
+    }
+    return builder.stream;
+}
+
+inline void PutLeb128(Bytes& out, mfxU32 value) {
+    do {
+        mfxU8 byte = value & 0x7f;
+        value >>= 7;
+        out.push_back(value ? (mfxU8)(byte | 0x80) : byte);
+    } while (value);
+}
+
+// AV1 temporal units of a temporal delimiter, a sequence header in the first one and a
+// frame OBU with frameSizes[i] payload bytes. Some frames have OBU extensions, metadata OBUs
+// or a second frame unit. Annex B streams omit obu_size except for metadata OBUs, the
+// expected temporal units are in the low overhead format. With keyFrameInterval every
+// keyFrameInterval-th frame is a shown key frame with a sequence header, the others are shown
+// inter frames, the frame payloads must not be empty then.
+inline Stream MakeAV1Stream(const std::vector<mfxU32>& frameSizes,
+                            bool annexB,
+                            std::mt19937& rng,
+                            mfxU32 keyFrameInterval = 0) {
+    std::uniform_int_distribution<mfxU32> byte(0, 255);
+
+    struct Obu {
+        mfxU8 type;
+        mfxI32 extension; // -1 without the extension
+        bool hasSize; // in annex B streams
+        Bytes payload;
+    };
+
+    auto random = [&](mfxU32 size) {
+        Bytes data(size);
+        for (auto& b : data)
+            b = (mfxU8)byte(rng);
+        return data;
+    };
+
+    auto write = [](Bytes& out, const Obu& obu, bool hasSize) {
+        out.push_back((mfxU8)((obu.type << 3) | ((obu.extension >= 0) << 2) | (hasSize << 1)));
+        if (obu.extension >= 0)
+            out.push_back((mfxU8)obu.extension);
+        if (hasSize)
+            PutLeb128(out, (mfxU32)obu.payload.size());
+        out.insert(out.end(), obu.payload.begin(), obu.payload.end());
+    };
+
+    Stream stream;
+    for (size_t i = 0; i < frameSizes.size(); i++) {
+        std::vector<std::vector<Obu>> frameUnits(1);
+        frameUnits[0].push_back({ 2, -1, false, {} });
+        bool keyFrame = keyFrameInterval && i % keyFrameInterval == 0;
+        if (!i || keyFrame) {
+            Bytes sequenceHeader = random(12);
+            if (keyFrameInterval)
+                sequenceHeader[0] &= ~0x08; // reduced_still_picture_header
+            frameUnits[0].push_back({ 1, -1, false, sequenceHeader });
+        }
+        if (i % 5 == 4)
+            frameUnits[0].push_back({ 5, -1, true, random(300) });
+        mfxI32 extension = i % 3 == 2 ? (mfxI32)((i % 8) << 5 | 1 << 3) : -1;
+        Bytes payload    = random(frameSizes[i]);
+        // show_existing_frame, frame_type KEY_FRAME or INTER_FRAME, show_frame
+        if (keyFrameInterval)
+            payload[0] = keyFrame ? 0x10 : 0x30;
+        frameUnits[0].push_back({ 6, extension, false, payload });
+        if (i % 4 == 1)
+            frameUnits.push_back({ { 6, extension, false, random(frameSizes[i] / 2) } });
+
+        Bytes frame, unit;
+        for (auto& frameUnit : frameUnits) {
+            Bytes units;
+            for (auto& obu : frameUnit) {
+                write(frame, obu, true);
+
+                Bytes data;
+                write(data, obu, obu.hasSize);
+                PutLeb128(units, (mfxU32)data.size());
+                units.insert(units.end(), data.begin(), data.end());
+            }
+            PutLeb128(unit, (mfxU32)units.size());
+            unit.insert(unit.end(), units.begin(), units.end());
+        }
+
+        if (annexB)
+            PutLeb128(stream.data, (mfxU32)unit.size());
+        const Bytes& data = annexB ? unit : frame;
+        stream.data.insert(stream.data.end(), data.begin(), data.end());
+        stream.frames.push_back(frame);
+    }
+    return stream;
+}
+
+// Motion JPEG: SOI, random entropy coded data with stuffed 0xFF bytes, EOI
+inline Stream MakeMJPEGStream(const std::vector<mfxU32>& frameSizes, std::mt19937& rng) {
+    std::uniform_int_distribution<mfxU32> byte(0, 255);
+
+    Stream stream;
+    for (mfxU32 size : frameSizes) {
+        Bytes frame = { 0xFF, 0xD8 };
+        while (frame.size() + 2 < size) {
+            mfxU8 b = (mfxU8)byte(rng);
+            frame.push_back(b);
+            if (b == 0xFF)
+                frame.push_back(0);
+        }
+        frame.push_back(0xFF);
+        frame.push_back(0xD9);
+
+        stream.data.insert(stream.data.end(), frame.begin(), frame.end());
+        stream.frames.push_back(frame);
+    }
+    return stream;
+}
+
+// IVF container with random frame payloads
+inline Stream MakeIVFStream(const std::vector<mfxU32>& frameSizes, std::mt19937& rng) {
+    std::uniform_int_distribution<mfxU32> byte(0, 255);
+
+    auto put = [](Bytes& out, mfxU64 value, mfxU32 size) {
+        for (mfxU32 i = 0; i < size; i++)
+            out.push_back((mfxU8)(value >> (8 * i)));
+    };
+
+    Stream stream;
+    put(stream.data, MFX_MAKEFOURCC('D', 'K', 'I', 'F'), 4);
+    put(stream.data, 0, 2); // version
+    put(stream.data, 32, 2); // header size
+    put(stream.data, MFX_MAKEFOURCC('V', 'P', '9', '0'), 4);
+    put(stream.data, 64, 2); // width
+    put(stream.data, 64, 2); // height
+    put(stream.data, 30, 4); // frame rate
+    put(stream.data, 1, 4); // time scale
+    put(stream.data, frameSizes.size(), 4);
+    put(stream.data, 0, 4);
+
+    for (size_t i = 0; i < frameSizes.size(); i++) {
+        Bytes frame(frameSizes[i]);
+        for (auto& b : frame)
+            b = (mfxU8)byte(rng);
+
+        put(stream.data, frameSizes[i], 4);
+        put(stream.data, i, 8); // time stamp
+        stream.data.insert(stream.data.end(), frame.begin(), frame.end());
+        stream.frames.push_back(frame);
+    }
+    return stream;
+}
+
+inline bool WriteStream(const char* path, const Bytes& data) {
+    FILE* f = fopen(path, "wb");
+    if (!f)
+        return false;
+    bool ok = fwrite(data.data(), 1, data.size(), f) == data.size();
+    return !fclose(f) && ok;
+}
+
+} // namespace StreamBuilder
+
+#endif //__STREAM_BUILDER_H__
@@ -0,0 +1,164 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "sample_utils.h"
+
+namespace {
+
+std::vector<mfxU8> ReadFile(const std::string& path) {
+    std::vector<mfxU8> data;
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f)
+        return data;
+    mfxU8 chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0)
+        data.insert(data.end(), chunk, chunk + n);
+    fclose(f);
+    return data;
+}
+
+class AsyncFileWriterTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        path = ::testing::TempDir() + "async_file_writer_output.bin";
+    }
+
+    void TearDown() override {
+        remove(path.c_str());
+    }
+
+    // Frames of random sizes, some of them larger than the writer buffers
+    std::vector<std::vector<mfxU8>> MakeFrames(size_t count) {
+        std::uniform_int_distribution<mfxU32> size(0, 10000), value(0, 255);
+        std::vector<std::vector<mfxU8>> frames(count);
+        for (auto& frame : frames) {
+            frame.resize(size(rng));
+            for (auto& x : frame)
+                x = (mfxU8)value(rng);
+        }
+        return frames;
+    }
+
+    std::string path;
+    std::mt19937 rng{ 2021 };
+};
+
+} // namespace
+
+TEST_F(AsyncFileWriterTest, CoalescesFramesInOrder) {
+    for (AsyncWriteSync sync :
+         { ASYNC_WRITE_SYNC_NONE, ASYNC_WRITE_SYNC_CLOSE, ASYNC_WRITE_SYNC_ALWAYS }) {
+        auto frames = MakeFrames(200);
+        std::vector<mfxU8> expected;
+
+        AsyncWriteParams params = CAsyncFileWriter::GetDefaultParams();
+        params.BufferSize       = 4096;
+        params.NumBuffers       = 3;
+        params.Sync             = sync;
+
+        FILE* f = fopen(path.c_str(), "wb");
+        ASSERT_NE(f, nullptr);
+        CAsyncFileWriter writer;
+        ASSERT_EQ(writer.Start(f, params), MFX_ERR_NONE);
+        for (auto& frame : frames) {
+            ASSERT_EQ(writer.Write(frame.data(), (mfxU32)frame.size()), MFX_ERR_NONE);
+            expected.insert(expected.end(), frame.begin(), frame.end());
+        }
+        EXPECT_EQ(writer.Stop(), MFX_ERR_NONE);
+        fclose(f);
+
+        EXPECT_EQ(ReadFile(path), expected);
+
+        CAsyncFileWriter::Statistics stat = writer.GetStatistics();
+        EXPECT_EQ(stat.bytes, expected.size());
+        // every write except the last one is a full buffer
+        EXPECT_EQ(stat.writes, (expected.size() + params.BufferSize - 1) / params.BufferSize);
+        EXPECT_LE(stat.maxQueueDepth, params.NumBuffers);
+    }
+}
+
+TEST_F(AsyncFileWriterTest, ReportsWriteErrorOnNextCall) {
+    // the file is opened for reading, so the writer thread fails
+    FILE* f = fopen(path.c_str(), "wb");
+    ASSERT_NE(f, nullptr);
+    fclose(f);
+    f = fopen(path.c_str(), "rb");
+    ASSERT_NE(f, nullptr);
+
+    AsyncWriteParams params = CAsyncFileWriter::GetDefaultParams();
+    params.BufferSize       = 16;
+
+    CAsyncFileWriter writer;
+    ASSERT_EQ(writer.Start(f, params), MFX_ERR_NONE);
+    // the payload is smaller than a buffer, so it's only kept until Flush
+    mfxU8 data[8] = {};
+    EXPECT_EQ(writer.Write(data, sizeof(data)), MFX_ERR_NONE);
+    EXPECT_EQ(writer.Flush(), MFX_ERR_UNDEFINED_BEHAVIOR);
+    EXPECT_EQ(writer.Write(data, sizeof(data)), MFX_ERR_UNDEFINED_BEHAVIOR);
+    EXPECT_EQ(writer.Stop(), MFX_ERR_UNDEFINED_BEHAVIOR);
+    fclose(f);
+}
+
+TEST_F(AsyncFileWriterTest, BitstreamWriterMatchesSynchronous) {
+    auto frames = MakeFrames(50);
+    std::vector<mfxU8> outputs[2];
+
+    for (int async = 0; async < 2; async++) {
+        CSmplBitstreamWriter writer;
+        if (async)
+            writer.EnableAsyncWrite(CAsyncFileWriter::GetDefaultParams());
+        ASSERT_EQ(writer.Init(path.c_str()), MFX_ERR_NONE);
+
+        for (auto& frame : frames) {
+            mfxBitstream bs = {};
+            bs.Data         = frame.data();
+            bs.DataLength = bs.MaxLength = (mfxU32)frame.size();
+            ASSERT_EQ(writer.WriteNextFrame(&bs, false), MFX_ERR_NONE);
+            EXPECT_EQ(bs.DataLength, 0u);
+        }
+        EXPECT_EQ(writer.Flush(), MFX_ERR_NONE);
+        writer.Close();
+        outputs[async] = ReadFile(path);
+
+        if (async) {
+            EXPECT_EQ(writer.GetAsyncWriter().GetStatistics().bytes, outputs[async].size());
+        }
+    }
+    EXPECT_EQ(outputs[0], outputs[1]);
+}
+
+TEST_F(AsyncFileWriterTest, IVFWriterUpdatesFrameCount) {
+    auto frames = MakeFrames(10);
+
+    CIVFFrameWriter writer;
+    writer.EnableAsyncWrite(CAsyncFileWriter::GetDefaultParams());
+    ASSERT_EQ(writer.Init(path.c_str(), 64, 32, 30, 1), MFX_ERR_NONE);
+    size_t payload = 0;
+    for (auto& frame : frames) {
+        if (frame.empty())
+            continue;
+        mfxBitstream bs = {};
+        bs.Data         = frame.data();
+        bs.DataLength = bs.MaxLength = (mfxU32)frame.size();
+        ASSERT_EQ(writer.WriteNextFrame(&bs, false), MFX_ERR_NONE);
+        payload += frame.size();
+    }
+    mfxU64 count = writer.GetProcessedFrame();
+    writer.Close();
+
+    auto data = ReadFile(path);
+    ASSERT_EQ(data.size(), 32 + 12 * count + payload);
+    mfxU32 stored = data[24] | (data[25] << 8) | (data[26] << 16) | ((mfxU32)data[27] << 24);
+    EXPECT_EQ(stored, count);
+}
@@ -0,0 +1,176 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include <gtest/gtest.h>
+
+#include <string.h>
+#include <random>
+#include <vector>
+
+#include "av1_spl.h"
+#include "stream_builder.h"
+
+using namespace ProtectedLibrary;
+using namespace StreamBuilder;
+
+namespace {
+
+// Splits the whole stream at once, the bitstream is flagged with the end of stream
+std::vector<Bytes> SplitFrames(AV1_Spl& splitter, Bytes& data) {
+    mfxBitstream bs = {};
+    bs.Data         = data.data();
+    bs.DataLength = bs.MaxLength = (mfxU32)data.size();
+    bs.DataFlag                  = MFX_BITSTREAM_EOS;
+
+    std::vector<Bytes> frames;
+    FrameSplitterInfo* info = NULL;
+    while (splitter.GetFrame(&bs, &info) == MFX_ERR_NONE && info) {
+        frames.emplace_back(info->Data, info->Data + info->DataLength);
+        splitter.ResetCurrentState();
+    }
+    return frames;
+}
+
+std::vector<mfxU32> RandomSizes(std::mt19937& rng, mfxU32 count, mfxU32 maxSize) {
+    std::uniform_int_distribution<mfxU32> size(0, maxSize);
+    std::vector<mfxU32> sizes;
+    for (mfxU32 i = 0; i < count; i++)
+        sizes.push_back(size(rng));
+    return sizes;
+}
+
+} // namespace
+
+TEST(Av1SplTest, ReadsLeb128) {
+    mfxU8 data[8];
+    mfxU32 values[] = { 0, 1, 127, 128, 300, 16383, 16384, 0x12345678, 0xffffffff };
+    for (mfxU32 value : values) {
+        mfxU32 size = WriteLeb128(data, value);
+
+        mfxU32 result = 0, length = 0;
+        ASSERT_EQ(ReadLeb128(data, size, result, length), MFX_ERR_NONE) << value;
+        EXPECT_EQ(result, value);
+        EXPECT_EQ(length, size);
+        EXPECT_EQ(ReadLeb128(data, size - 1, result, length), MFX_ERR_MORE_DATA) << value;
+    }
+
+    // the value is longer than 8 bytes or doesn't fit 32 bits
+    mfxU32 result = 0, length = 0;
+    memset(data, 0x80, sizeof(data));
+    EXPECT_EQ(ReadLeb128(data, sizeof(data), result, length), MFX_ERR_UNDEFINED_BEHAVIOR);
+    mfxU8 large[] = { 0x80, 0x80, 0x80, 0x80, 0x10 };
+    EXPECT_EQ(ReadLeb128(large, sizeof(large), result, length), MFX_ERR_UNDEFINED_BEHAVIOR);
+}
+
+TEST(Av1SplTest, SplitsLowOverheadTemporalUnits) {
+    std::mt19937 rng(2021);
+    std::vector<mfxU32> sizes = RandomSizes(rng, 30, 20000);
+    sizes[3]                  = 0;
+    Stream stream             = MakeAV1Stream(sizes, false, rng);
+
+    AV1_Spl splitter;
+    Bytes data = stream.data;
+    EXPECT_EQ(SplitFrames(splitter, data), stream.frames);
+    EXPECT_EQ(splitter.GetFormat(), AV1_FORMAT_LOW_OVERHEAD);
+
+    // temporal units are returned in place
+    mfxBitstream bs = {};
+    bs.Data         = data.data();
+    bs.DataLength = bs.MaxLength = (mfxU32)data.size();
+    FrameSplitterInfo* info      = NULL;
+    splitter.Reset();
+    ASSERT_EQ(splitter.GetFrame(&bs, &info), MFX_ERR_NONE);
+    EXPECT_EQ(info->Data, data.data());
+    EXPECT_EQ(bs.DataOffset, info->DataLength);
+}
+
+TEST(Av1SplTest, ConvertsAnnexBTemporalUnits) {
+    std::mt19937 rng(2021);
+    std::vector<mfxU32> sizes = RandomSizes(rng, 30, 20000);
+    sizes[5]                  = 0;
+    Stream stream             = MakeAV1Stream(sizes, true, rng);
+
+    AV1_Spl splitter;
+    Bytes data = stream.data;
+    EXPECT_EQ(SplitFrames(splitter, data), stream.frames);
+    EXPECT_EQ(splitter.GetFormat(), AV1_FORMAT_ANNEXB);
+}
+
+TEST(Av1SplTest, DropsIncompleteLastTemporalUnit) {
+    std::mt19937 rng(2021);
+    for (bool annexB : { false, true }) {
+        Stream stream = MakeAV1Stream({ 100, 200, 300 }, annexB, rng);
+        stream.data.resize(stream.data.size() - 10);
+
+        AV1_Spl splitter;
+        std::vector<Bytes> frames = SplitFrames(splitter, stream.data);
+        ASSERT_EQ(frames.size(), annexB ? 2u : 3u) << annexB;
+        EXPECT_EQ(frames[0], stream.frames[0]);
+        EXPECT_EQ(frames[1], stream.frames[1]);
+        // the low overhead temporal unit ends with the last complete OBU
+        if (!annexB) {
+            EXPECT_LT(frames[2].size(), stream.frames[2].size());
+            EXPECT_TRUE(std::equal(frames[2].begin(), frames[2].end(), stream.frames[2].begin()));
+        }
+    }
+}
+
+TEST(Av1SplTest, RejectsUnknownFormat) {
+    Bytes data(64, 0xff);
+
+    AV1_Spl splitter;
+    mfxBitstream bs = {};
+    bs.Data         = data.data();
+    bs.DataLength = bs.MaxLength = (mfxU32)data.size();
+    FrameSplitterInfo* info      = NULL;
+    EXPECT_EQ(splitter.GetFrame(&bs, &info), MFX_ERR_UNSUPPORTED);
+    EXPECT_EQ(splitter.GetFormat(), AV1_FORMAT_UNKNOWN);
+}
+
+TEST(Av1SplTest, SplitsStreamFedInChunks) {
+    for (bool annexB : { false, true }) {
+        std::mt19937 rng(2021);
+        std::uniform_int_distribution<mfxU32> chunk(1, 5000);
+        Stream stream = MakeAV1Stream(RandomSizes(rng, 100, 20000), annexB, rng);
+
+        AV1_Spl splitter;
+        std::vector<mfxU8> buffer(64 * 1024);
+        mfxBitstream bs = {};
+        bs.Data         = buffer.data();
+        bs.MaxLength    = (mfxU32)buffer.size();
+
+        std::vector<Bytes> frames;
+        size_t read = 0;
+        for (;;) {
+            FrameSplitterInfo* info = NULL;
+            mfxStatus sts           = splitter.GetFrame(&bs, &info);
+            if (sts == MFX_ERR_NONE) {
+                frames.emplace_back(info->Data, info->Data + info->DataLength);
+                splitter.ResetCurrentState();
+                continue;
+            }
+            ASSERT_EQ(sts, MFX_ERR_MORE_DATA);
+            if (bs.DataFlag & MFX_BITSTREAM_EOS)
+                break;
+
+            // the splitter keeps the unfinished temporal unit at the beginning of the bitstream
+            memmove(bs.Data, bs.Data + bs.DataOffset, bs.DataLength);
+            bs.DataOffset = 0;
+            mfxU32 size   = std::min<mfxU32>({ chunk(rng),
+                                             bs.MaxLength - bs.DataLength,
+                                             (mfxU32)(stream.data.size() - read) });
+            memcpy(bs.Data + bs.DataLength, stream.data.data() + read, size);
+            bs.DataLength += size;
+            read += size;
+            if (read == stream.data.size())
+                bs.DataFlag |= MFX_BITSTREAM_EOS;
+        }
+
+        ASSERT_EQ(frames.size(), stream.frames.size()) << annexB;
+        for (size_t i = 0; i < frames.size(); i++)
+            EXPECT_EQ(frames[i], stream.frames[i]) << annexB << " frame " << i;
+    }
+}
@@ -0,0 +1,164 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+#include "avc_bitstream.h"
+#include "stream_builder.h"
+
+using namespace ProtectedLibrary;
+using namespace StreamBuilder;
+
+namespace {
+
+enum ElementType { ELEMENT_BITS, ELEMENT_UE, ELEMENT_SE };
+
+struct Element {
+    ElementType type;
+    mfxU32 size; // bits of ELEMENT_BITS
+    mfxU32 value;
+};
+
+// Random fixed-length and Exp-Golomb elements, short codes are more frequent like in headers
+std::vector<Element> RandomElements(size_t count, std::mt19937& rng) {
+    std::uniform_int_distribution<mfxU32> type(0, 2), size(0, 32), magnitude(0, 31);
+    std::vector<Element> elements(count);
+    for (auto& e : elements) {
+        e.type  = (ElementType)type(rng);
+        e.size  = e.type == ELEMENT_BITS ? size(rng) : 0;
+        e.value = rng();
+        if (e.type == ELEMENT_BITS)
+            e.value = e.size ? e.value >> (32 - e.size) : 0;
+        else
+            e.value >>= magnitude(rng);
+        if (e.value == 0xffffffff)
+            e.value--;
+        if (e.type == ELEMENT_SE)
+            e.value = (mfxU32)((mfxI32)e.value >> 1);
+    }
+    return elements;
+}
+
+Bytes Write(const std::vector<Element>& elements) {
+    BitWriter writer;
+    for (auto& e : elements) {
+        if (e.type == ELEMENT_BITS)
+            writer.PutBits(e.value, e.size);
+        else if (e.type == ELEMENT_UE)
+            writer.PutUE(e.value);
+        else
+            writer.PutSE((mfxI32)e.value);
+    }
+    return writer.Finish();
+}
+
+// Number of bits of the element in the bitstream
+mfxU32 ElementSize(const Element& e) {
+    if (e.type == ELEMENT_BITS)
+        return e.size;
+    mfxI32 v    = (mfxI32)e.value;
+    mfxU64 code = e.type == ELEMENT_UE ? (mfxU64)e.value + 1
+                  : v > 0              ? 2 * (mfxU64)v
+                                       : 2 * (mfxU64)(-(mfxI64)v) + 1;
+    mfxU32 length = 0;
+    while (code >> length)
+        length++;
+    return 2 * length - 1;
+}
+
+} // namespace
+
+TEST(AvcBitstreamTest, ReadsElementsWrittenByBitWriter) {
+    std::mt19937 rng(2021);
+
+    for (int iter = 0; iter < 200; iter++) {
+        std::vector<Element> elements = RandomElements(500, rng);
+        Bytes data                    = Write(elements);
+
+        AVCBaseBitstream bs(data.data(), (mfxU32)data.size());
+        mfxU32 position = 0;
+        for (size_t i = 0; i < elements.size(); i++) {
+            const Element& e = elements[i];
+            if (e.type == ELEMENT_BITS)
+                ASSERT_EQ(bs.GetBits(e.size), e.value) << "element " << i;
+            else if (e.type == ELEMENT_UE)
+                ASSERT_EQ((mfxU32)bs.GetVLCElement(false), e.value) << "element " << i;
+            else
+                ASSERT_EQ(bs.GetVLCElement(true), (mfxI32)e.value) << "element " << i;
+
+            position += ElementSize(e);
+            ASSERT_EQ(bs.BitsDecoded(), position) << "element " << i;
+        }
+
+        // rbsp_stop_one_bit and the alignment zeros
+        EXPECT_FALSE(bs.More_RBSP_Data());
+        EXPECT_EQ(bs.BytesDecoded(), data.size());
+    }
+}
+
+TEST(AvcBitstreamTest, ReadsZerosPastTheEnd) {
+    mfxU8 data[] = { 0xff, 0x81, 0xaa, 0x55, 0x12, 0x34, 0x56, 0x78, 0x9a, 0xff };
+    // the byte after maxsize is never read
+    AVCBaseBitstream bs(data, sizeof(data) - 1);
+
+    EXPECT_EQ(bs.GetBits(4), 0xfu);
+    EXPECT_EQ(bs.PeekBits(12), 0xf81u);
+    EXPECT_EQ(bs.GetBits(32), 0xf81aa551u);
+    EXPECT_EQ(bs.GetBits(32), 0x23456789u);
+    EXPECT_EQ(bs.GetBits(8), 0xa0u);
+    EXPECT_EQ(bs.BytesLeft(), 0u);
+    EXPECT_EQ(bs.GetBits(32), 0u);
+    EXPECT_EQ(bs.BitsDecoded(), 108u);
+    EXPECT_THROW(bs.GetVLCElement(false), AVC_exception);
+}
+
+TEST(AvcBitstreamTest, LimitsExpGolombCodesTo32Bits) {
+    // 31 leading zeros give the largest value
+    BitWriter longest;
+    longest.PutBits(3, 5);
+    longest.PutUE(0xfffffffe);
+    Bytes data = longest.Finish();
+
+    AVCBaseBitstream bs(data.data(), (mfxU32)data.size());
+    EXPECT_EQ(bs.GetBits(5), 3u);
+    EXPECT_EQ((mfxU32)bs.GetVLCElement(false), 0xfffffffeu);
+    EXPECT_EQ(bs.BitsDecoded(), 5u + 63);
+
+    // 32 leading zeros
+    Bytes tooLong = { 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0xff };
+    bs.Reset(tooLong.data(), (mfxU32)tooLong.size());
+    EXPECT_THROW(bs.GetVLCElement(false), AVC_exception);
+}
+
+TEST(AvcBitstreamTest, SkipsAndAlignsAcrossTheCache) {
+    std::mt19937 rng(2021);
+    Bytes data(4096);
+    for (auto& b : data)
+        b = (mfxU8)rng();
+
+    AVCBaseBitstream bs(data.data(), (mfxU32)data.size());
+    std::uniform_int_distribution<mfxU32> skip(0, 700);
+    mfxU32 position = 0;
+    while (position + 1000 < data.size() * 8) {
+        mfxU32 n = skip(rng);
+        bs.SkipBits(n);
+        position += n;
+        if (n & 1) {
+            bs.AlignPointerRight();
+            position = (position + 7) & ~7u;
+        }
+        ASSERT_EQ(bs.BitsDecoded(), position);
+
+        mfxU32 expected = 0;
+        for (mfxU32 i = 0; i < 24; i++)
+            expected = (expected << 1) | ((data[(position + i) / 8] >> (7 - (position + i) % 8)) & 1);
+        ASSERT_EQ(bs.GetBits(24), expected) << "position " << position;
+        position += 24;
+    }
+}
@@ -0,0 +1,299 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include <gtest/gtest.h>
+
+#include <string.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "avc_nal_spl.h"
+#include "stream_builder.h"
+
+using namespace ProtectedLibrary;
+using namespace StreamBuilder;
+
+namespace {
+
+// Byte-wise start code search the splitter used before the vectorized scanner.
+// On a miss it reported the input size plus the kept zeros, only pb is compared then.
+mfxI32 ReferenceFindStartCode(mfxU8*(&pb), mfxU32& size, mfxI32& startCodeSize) {
+    mfxU32 zeroCount = 0;
+
+    for (mfxU32 i = 0; i < (mfxU32)size; i++, pb++) {
+        switch (pb[0]) {
+            case 0x00:
+                zeroCount++;
+                break;
+            case 0x01:
+                if (zeroCount >= 2) {
+                    startCodeSize = std::min(zeroCount + 1, 4u);
+                    size -= i + 1;
+                    pb++;
+                    if (size >= 1)
+                        return pb[0] & 0x1f;
+                    pb -= startCodeSize;
+                    size += startCodeSize;
+                    startCodeSize = 0;
+                    return 0;
+                }
+                zeroCount = 0;
+                break;
+            default:
+                zeroCount = 0;
+                break;
+        }
+    }
+
+    zeroCount = std::min(zeroCount, 3u);
+    pb -= zeroCount;
+    size += zeroCount;
+    startCodeSize = 0;
+    return 0;
+}
+
+// Byte-wise emulation prevention removal
+Bytes ReferenceRemove(const Bytes& src) {
+    Bytes rbsp;
+    mfxU32 zeros = 0;
+    for (size_t i = 0; i < src.size(); i++) {
+        if (i >= 2 && src[i] == 3 && zeros >= 2) {
+            zeros = 0;
+            continue;
+        }
+        rbsp.push_back(src[i]);
+        zeros = src[i] ? 0 : zeros + 1;
+    }
+    return rbsp;
+}
+
+// Elementary stream like data with frequent start codes, prevention bytes and zero runs
+Bytes RandomStream(size_t size, std::mt19937& rng) {
+    std::uniform_int_distribution<unsigned> pick(0, 9), byte(0, 255);
+    Bytes data(size);
+    for (auto& x : data) {
+        unsigned p = pick(rng);
+        x          = p < 4 ? 0 : p == 4 ? 1 : p == 5 ? 3 : (mfxU8)byte(rng);
+    }
+    return data;
+}
+
+} // namespace
+
+TEST(AvcNalSplTest, FindStartCodeMatchesByteWiseSearch) {
+    std::mt19937 rng(2021);
+    std::uniform_int_distribution<mfxU32> length(0, 200);
+
+    for (int iter = 0; iter < 20000; iter++) {
+        Bytes data = RandomStream(length(rng), rng);
+        mfxU8* base = data.data();
+        mfxU32 size = (mfxU32)data.size();
+
+        // walk the buffer like GetNALUnit does
+        mfxU8 *pbRef = base, *pb = base;
+        mfxU32 sizeRef = size;
+        for (;;) {
+            mfxI32 scsRef = -1, scs = -1;
+            mfxI32 codeRef = ReferenceFindStartCode(pbRef, sizeRef, scsRef);
+            bool found     = FindNextStartCode(pb, size, scs);
+
+            ASSERT_EQ(pb, pbRef) << "iteration " << iter;
+            ASSERT_EQ(scs, scsRef) << "iteration " << iter;
+            ASSERT_EQ(found ? pb[0] & 0x1f : 0, codeRef) << "iteration " << iter;
+            ASSERT_EQ(size, (mfxU32)(data.size() - (pb - base))) << "iteration " << iter;
+            if (!found)
+                break;
+            ASSERT_EQ(size, sizeRef);
+        }
+    }
+}
+
+TEST(AvcNalSplTest, FindStartCodeKeepsPartialStartCodes) {
+    struct Case {
+        Bytes data;
+        bool found;
+        mfxU32 pos; // pb offset after the call
+        mfxI32 startCodeSize;
+    } cases[] = {
+        { {}, false, 0, 0 },
+        { { 0x12, 0, 0, 0, 0 }, false, 2, 0 },
+        { { 0x12, 0, 0 }, false, 1, 0 },
+        { { 0x12, 0, 0, 1 }, false, 1, 0 },
+        { { 0, 0, 0, 1 }, false, 0, 0 },
+        { { 0, 0, 1, 0x65 }, true, 3, 3 },
+        { { 0, 0, 0, 0, 1, 0x67 }, true, 5, 4 },
+        { { 0, 1, 0x65, 0, 0, 3 }, false, 6, 0 },
+    };
+
+    for (auto& c : cases) {
+        mfxU8* pb     = c.data.data();
+        mfxU32 size   = (mfxU32)c.data.size();
+        mfxI32 scSize = -1;
+        EXPECT_EQ(FindNextStartCode(pb, size, scSize), c.found);
+        EXPECT_EQ((mfxU32)(pb - c.data.data()), c.pos);
+        EXPECT_EQ(size, c.data.size() - c.pos);
+        EXPECT_EQ(scSize, c.startCodeSize);
+    }
+}
+
+TEST(AvcNalSplTest, InitReturnsFirstStartCode) {
+    Bytes data      = { 0x12, 0, 0, 0, 1, 0x67, 0x42 };
+    mfxBitstream bs = {};
+    bs.Data         = data.data();
+    bs.DataLength   = (mfxU32)data.size();
+
+    // the code includes the 00 00 01 prefix like the byte-wise search reported it
+    StartCodeIterator iterator;
+    EXPECT_EQ(iterator.Init(&bs), 0x167);
+
+    data          = { 0x12, 0, 0, 1 };
+    bs.Data       = data.data();
+    bs.DataLength = (mfxU32)data.size();
+    EXPECT_EQ(iterator.Init(&bs), 0);
+}
+
+TEST(AvcNalSplTest, RemovePreventingBytesMatchesByteWiseRemoval) {
+    std::mt19937 rng(2021);
+    std::uniform_int_distribution<mfxU32> length(0, 300);
+
+    for (int iter = 0; iter < 5000; iter++) {
+        Bytes src      = RandomStream(length(rng), rng);
+        Bytes expected = ReferenceRemove(src);
+
+        Bytes dst(src.size() + 8, 0xcc);
+        mfxU32 dstSize = RemovePreventingBytes(dst.data(), src.data(), (mfxU32)src.size());
+        ASSERT_EQ(dstSize, expected.size()) << "iteration " << iter;
+        dst.resize(dstSize);
+        ASSERT_EQ(dst, expected) << "iteration " << iter;
+    }
+}
+
+TEST(AvcNalSplTest, RemovePreventingBytesRestoresPayload) {
+    std::mt19937 rng(2021);
+    Bytes rbsp = RandomStream(100000, rng);
+
+    Bytes nal;
+    AppendNalUnit(nal, 3, 0x65, rbsp);
+    Bytes out(nal.size());
+    // skip the start code and the NAL unit header
+    mfxU32 size = RemovePreventingBytes(out.data(), nal.data() + 4, (mfxU32)nal.size() - 4);
+    out.resize(size);
+    EXPECT_EQ(out, rbsp);
+}
+
+TEST(AvcNalSplTest, NalUnitsAreViewsAcrossRefills) {
+    std::mt19937 rng(2021);
+    std::uniform_int_distribution<mfxU32> length(0, 5000), chunk(1, 3000), scSize(3, 4);
+
+    Bytes stream;
+    std::vector<Bytes> expected;
+    for (int i = 0; i < 300; i++) {
+        // the payload ends with rbsp_stop_one_bit like real NAL units
+        Bytes rbsp = RandomStream(length(rng), rng);
+        rbsp.push_back(0x80);
+        mfxU8 header = (mfxU8)(0x61 + i % 8);
+
+        size_t start = stream.size();
+        AppendNalUnit(stream, scSize(rng), header, rbsp);
+        size_t payload = std::find(stream.begin() + start, stream.end(), 1) - stream.begin() + 1;
+        expected.emplace_back(stream.begin() + payload, stream.end());
+    }
+
+    NALUnitSplitter splitter;
+    splitter.Init();
+    std::vector<mfxU8> buffer(8192);
+    mfxBitstream bs = {};
+    bs.Data         = buffer.data();
+    bs.MaxLength    = (mfxU32)buffer.size();
+
+    std::vector<Bytes> nalUnits;
+    size_t read = 0;
+    for (;;) {
+        mfxBitstream* nalUnit = NULL;
+        mfxI32 code           = splitter.GetNalUnits(&bs, nalUnit);
+        if (code) {
+            ASSERT_GE(nalUnit->Data, bs.Data);
+            ASSERT_LE(nalUnit->Data + nalUnit->DataLength, bs.Data + bs.DataOffset);
+            EXPECT_EQ(code, nalUnit->Data[0] & 0x1f);
+            nalUnits.emplace_back(nalUnit->Data, nalUnit->Data + nalUnit->DataLength);
+            continue;
+        }
+        if (bs.DataFlag & MFX_BITSTREAM_EOS)
+            break;
+
+        // append like the bitstream readers do, moving or growing the kept data
+        memmove(bs.Data, bs.Data + bs.DataOffset, bs.DataLength);
+        bs.DataOffset = 0;
+        if (bs.DataLength > bs.MaxLength / 2) {
+            buffer.resize(buffer.size() * 2);
+            bs.Data      = buffer.data();
+            bs.MaxLength = (mfxU32)buffer.size();
+        }
+        mfxU32 size = std::min<mfxU32>({ chunk(rng),
+                                         bs.MaxLength - bs.DataLength,
+                                         (mfxU32)(stream.size() - read) });
+        memcpy(bs.Data + bs.DataLength, stream.data() + read, size);
+        bs.DataLength += size;
+        read += size;
+        if (read == stream.size())
+            bs.DataFlag |= MFX_BITSTREAM_EOS;
+    }
+
+    ASSERT_EQ(nalUnits.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); i++)
+        EXPECT_EQ(nalUnits[i], expected[i]) << "NAL unit " << i;
+}
+
+TEST(AvcNalSplTest, TruncatesNalUnitsLongerThanSuggestedSize) {
+    // the first NAL unit doesn't fit into the suggested size of 10 KB
+    Bytes stream, large(30000, 0xab), small = { 0x11, 0x22, 0x80 };
+    AppendNalUnit(stream, 3, 0x65, large);
+    size_t secondOffset = stream.size();
+    AppendNalUnit(stream, 3, 0x61, small);
+
+    NALUnitSplitter splitter;
+    splitter.Init();
+    std::vector<mfxU8> buffer(16384);
+    mfxBitstream bs = {};
+    bs.Data         = buffer.data();
+    bs.MaxLength    = (mfxU32)buffer.size();
+
+    std::vector<Bytes> nalUnits;
+    std::vector<mfxU64> offsets;
+    size_t read = 0;
+    for (;;) {
+        mfxBitstream* nalUnit = NULL;
+        if (splitter.GetNalUnits(&bs, nalUnit)) {
+            nalUnits.emplace_back(nalUnit->Data, nalUnit->Data + nalUnit->DataLength);
+            offsets.push_back(splitter.GetNalUnitOffset());
+            continue;
+        }
+        if (bs.DataFlag & MFX_BITSTREAM_EOS)
+            break;
+
+        // the buffer never grows, the source can't keep the whole NAL unit
+        memmove(bs.Data, bs.Data + bs.DataOffset, bs.DataLength);
+        bs.DataOffset = 0;
+        mfxU32 size   = std::min<mfxU32>({ 1000u,
+                                         bs.MaxLength - bs.DataLength,
+                                         (mfxU32)(stream.size() - read) });
+        ASSERT_GT(size, 0u);
+        memcpy(bs.Data + bs.DataLength, stream.data() + read, size);
+        bs.DataLength += size;
+        read += size;
+        if (read == stream.size())
+            bs.DataFlag |= MFX_BITSTREAM_EOS;
+    }
+
+    ASSERT_EQ(nalUnits.size(), 2u);
+    ASSERT_EQ(nalUnits[0].size(), 10u * 1024);
+    EXPECT_EQ(nalUnits[0][0], 0x65);
+    EXPECT_TRUE(std::equal(nalUnits[0].begin() + 1, nalUnits[0].end(), large.begin()));
+    EXPECT_EQ(nalUnits[1], Bytes({ 0x61, 0x11, 0x22, 0x80 }));
+    EXPECT_EQ(offsets[0], 0u);
+    EXPECT_EQ(offsets[1], secondOffset);
+}
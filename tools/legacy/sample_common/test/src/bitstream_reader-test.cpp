@@ -0,0 +1,199 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "sample_utils.h"
+#include "stream_builder.h"
+
+using namespace StreamBuilder;
+
+namespace {
+
+class BitstreamReaderTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        path = ::testing::TempDir() + "bitstream_reader_input.bin";
+    }
+
+    void TearDown() override {
+        remove(path.c_str());
+    }
+
+    // Reads all frames, consuming each one like a decoder working on complete frames.
+    // The bitstream starts small and is doubled when the reader asks for a larger one.
+    std::vector<Bytes> ReadFrames(CSmplBitstreamReader& reader,
+                                  const std::vector<Bytes>& expected,
+                                  mfxU32 initialSize) {
+        std::vector<Bytes> frames;
+        mfxBitstreamWrapper bs(initialSize);
+
+        while (frames.size() < expected.size()) {
+            mfxStatus sts = reader.ReadNextFrame(&bs);
+            if (MFX_ERR_NOT_ENOUGH_BUFFER == sts) {
+                bs.Extend(bs.MaxLength * 2);
+                continue;
+            }
+            if (MFX_ERR_NONE != sts)
+                break;
+
+            mfxU32 size = std::min<mfxU32>(bs.DataLength, (mfxU32)expected[frames.size()].size());
+            frames.emplace_back(bs.Data + bs.DataOffset, bs.Data + bs.DataOffset + size);
+            bs.DataOffset += size;
+            bs.DataLength -= size;
+        }
+        return frames;
+    }
+
+    std::string path;
+    std::mt19937 rng{ 2021 };
+};
+
+} // namespace
+
+TEST_F(BitstreamReaderTest, JPEGReaderFindsFramesAcrossRefills) {
+    std::vector<mfxU32> sizes;
+    std::uniform_int_distribution<mfxU32> size(4, 50000);
+    for (int i = 0; i < 40; i++)
+        sizes.push_back(size(rng));
+    Stream stream = MakeMJPEGStream(sizes, rng);
+    ASSERT_TRUE(WriteStream(path.c_str(), stream.data));
+
+    CJPEGFrameReader reader;
+    ASSERT_EQ(reader.Init(path.c_str()), MFX_ERR_NONE);
+    EXPECT_EQ(ReadFrames(reader, stream.frames, 1000), stream.frames);
+}
+
+TEST_F(BitstreamReaderTest, JPEGReaderScansDataAddedByCaller) {
+    Stream stream = MakeMJPEGStream({ 3000, 2000 }, rng);
+    const Bytes& first  = stream.frames[0];
+    const Bytes& second = stream.frames[1];
+    mfxU32 half         = (mfxU32)second.size() / 2;
+    Bytes head(stream.data.begin(), stream.data.begin() + first.size() + half);
+    ASSERT_TRUE(WriteStream(path.c_str(), head));
+
+    CJPEGFrameReader reader;
+    ASSERT_EQ(reader.Init(path.c_str()), MFX_ERR_NONE);
+    mfxBitstreamWrapper bs(1 << 16);
+    ASSERT_EQ(reader.ReadNextFrame(&bs), MFX_ERR_NONE);
+    EXPECT_EQ(Bytes(bs.Data + bs.DataOffset, bs.Data + bs.DataOffset + first.size()), first);
+    bs.DataOffset += (mfxU32)first.size();
+    bs.DataLength -= (mfxU32)first.size();
+
+    // the file ends in the middle of the second frame, the caller appends the rest of it
+    EXPECT_EQ(reader.ReadNextFrame(&bs), MFX_ERR_MORE_DATA);
+    ASSERT_EQ(bs.DataLength, half);
+    memcpy(bs.Data + bs.DataOffset + bs.DataLength, second.data() + half, second.size() - half);
+    bs.DataLength = (mfxU32)second.size();
+
+    ASSERT_EQ(reader.ReadNextFrame(&bs), MFX_ERR_NONE);
+    EXPECT_EQ(Bytes(bs.Data + bs.DataOffset, bs.Data + bs.DataOffset + bs.DataLength), second);
+}
+
+TEST_F(BitstreamReaderTest, IVFReaderResumesAfterShortBitstream) {
+    std::vector<mfxU32> sizes;
+    std::uniform_int_distribution<mfxU32> size(0, 100000);
+    for (int i = 0; i < 40; i++)
+        sizes.push_back(size(rng));
+    Stream stream = MakeIVFStream(sizes, rng);
+    ASSERT_TRUE(WriteStream(path.c_str(), stream.data));
+
+    CIVFFrameReader reader;
+    ASSERT_EQ(reader.Init(path.c_str()), MFX_ERR_NONE);
+    EXPECT_EQ(ReadFrames(reader, stream.frames, 1000), stream.frames);
+
+    mfxBitstreamWrapper bs(1000);
+    EXPECT_EQ(reader.ReadNextFrame(&bs), MFX_ERR_MORE_DATA);
+}
+
+TEST_F(BitstreamReaderTest, H264ReaderSplitsLargeFrames) {
+    // the largest frames do not fit the initial splitter and reader buffers
+    std::vector<mfxU32> sizes = { 1000, 3 * 1024 * 1024, 200000, 1500000, 10, 700000 };
+    Stream stream             = MakeAVCStream(120, 68, sizes, 3, rng);
+    ASSERT_TRUE(WriteStream(path.c_str(), stream.data));
+
+    CH264FrameReader reader;
+    ASSERT_EQ(reader.Init(path.c_str()), MFX_ERR_NONE);
+
+    std::vector<Bytes> frames;
+    mfxBitstreamWrapper bs(4 * 1024 * 1024);
+    while (reader.ReadNextFrame(&bs) == MFX_ERR_NONE && bs.DataLength) {
+        frames.emplace_back(bs.Data + bs.DataOffset, bs.Data + bs.DataOffset + bs.DataLength);
+        bs.DataLength = 0;
+    }
+    ASSERT_EQ(frames.size(), stream.frames.size());
+    for (size_t i = 0; i < frames.size(); i++)
+        EXPECT_EQ(frames[i], stream.frames[i]) << "frame " << i;
+}
+
+TEST_F(BitstreamReaderTest, H264ReaderRestartsAfterReset) {
+    std::vector<mfxU32> sizes = { 5000, 600000, 20, 70000 };
+    Stream stream             = MakeAVCStream(240, 135, sizes, 4, rng);
+    ASSERT_TRUE(WriteStream(path.c_str(), stream.data));
+
+    CH264FrameReader reader;
+    ASSERT_EQ(reader.Init(path.c_str()), MFX_ERR_NONE);
+
+    for (int pass = 0; pass < 2; pass++) {
+        std::vector<Bytes> frames;
+        mfxBitstreamWrapper bs(1024 * 1024);
+        while (reader.ReadNextFrame(&bs) == MFX_ERR_NONE && bs.DataLength) {
+            frames.emplace_back(bs.Data + bs.DataOffset, bs.Data + bs.DataOffset + bs.DataLength);
+            bs.DataLength = 0;
+        }
+        EXPECT_EQ(frames, stream.frames) << "pass " << pass;
+        reader.Reset();
+    }
+}
+
+TEST_F(BitstreamReaderTest, H265ReaderReturnsAccessUnits) {
+    std::vector<mfxU32> sizes = { 1000, 3 * 1024 * 1024, 200000, 0, 1500000, 10, 700000 };
+    Stream stream             = MakeHEVCStream(sizes, 3, rng);
+    ASSERT_TRUE(WriteStream(path.c_str(), stream.data));
+
+    CH265FrameReader reader;
+    ASSERT_EQ(reader.Init(path.c_str()), MFX_ERR_NONE);
+
+    for (int pass = 0; pass < 2; pass++) {
+        std::vector<Bytes> frames;
+        mfxBitstreamWrapper bs(4 * 1024 * 1024);
+        while (reader.ReadNextFrame(&bs) == MFX_ERR_NONE && bs.DataLength) {
+            EXPECT_EQ(bs.DataFlag, MFX_BITSTREAM_COMPLETE_FRAME);
+            frames.emplace_back(bs.Data + bs.DataOffset, bs.Data + bs.DataOffset + bs.DataLength);
+            bs.DataLength = 0;
+        }
+        ASSERT_EQ(frames.size(), stream.frames.size()) << "pass " << pass;
+        for (size_t i = 0; i < frames.size(); i++)
+            EXPECT_EQ(frames[i], stream.frames[i]) << "pass " << pass << " frame " << i;
+        reader.Reset();
+    }
+}
+
+TEST_F(BitstreamReaderTest, AV1ReaderReturnsTemporalUnits) {
+    for (bool annexB : { false, true }) {
+        std::vector<mfxU32> sizes;
+        std::uniform_int_distribution<mfxU32> size(0, 100000);
+        for (int i = 0; i < 40; i++)
+            sizes.push_back(size(rng));
+        sizes.push_back(3 * 1024 * 1024);
+        Stream stream = MakeAV1Stream(sizes, annexB, rng);
+        ASSERT_TRUE(WriteStream(path.c_str(), stream.data));
+
+        // temporal units larger than the bitstream are returned after it is extended
+        CAV1FrameReader reader;
+        ASSERT_EQ(reader.Init(path.c_str()), MFX_ERR_NONE);
+        EXPECT_EQ(ReadFrames(reader, stream.frames, 1000), stream.frames) << annexB;
+
+        mfxBitstreamWrapper bs(1000);
+        EXPECT_EQ(reader.ReadNextFrame(&bs), MFX_ERR_MORE_DATA);
+    }
+}
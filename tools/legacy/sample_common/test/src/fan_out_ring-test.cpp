@@ -0,0 +1,264 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "fan_out_ring.h"
+
+namespace {
+
+class FanOutRingTest : public ::testing::Test {
+protected:
+    void InitRing(mfxU32 capacity, mfxU32 numConsumers) {
+        ASSERT_EQ(ring.Init(capacity,
+                            numConsumers,
+                            [this](int& value) {
+                                disposed.push_back(value);
+                            }),
+                  MFX_ERR_NONE);
+    }
+
+    int Peek(mfxU32 consumer) {
+        int value = -1;
+        EXPECT_EQ(ring.Peek(consumer, value), MFX_ERR_NONE) << "consumer " << consumer;
+        return value;
+    }
+
+    msdkFanOutRing<int> ring;
+    std::vector<int> disposed;
+};
+
+} // namespace
+
+TEST_F(FanOutRingTest, RejectsInvalidParameters) {
+    EXPECT_EQ(ring.Init(0, 1), MFX_ERR_UNSUPPORTED);
+    EXPECT_EQ(ring.Init(4, 0), MFX_ERR_UNSUPPORTED);
+    EXPECT_EQ(ring.Init(4, msdkFanOutRing<int>::MaxConsumers + 1), MFX_ERR_UNSUPPORTED);
+
+    EXPECT_EQ(ring.Init(5, msdkFanOutRing<int>::MaxConsumers), MFX_ERR_NONE);
+    EXPECT_EQ(ring.GetCapacity(), 8u);
+}
+
+TEST_F(FanOutRingTest, HandsEveryValueToEveryConsumer) {
+    InitRing(8, 3);
+    for (int i = 0; i < 3; i++)
+        ASSERT_EQ(ring.Push(i, 0), MFX_ERR_NONE);
+
+    for (mfxU32 consumer = 0; consumer < 3; consumer++) {
+        EXPECT_EQ(ring.GetLength(consumer), 3u);
+        EXPECT_EQ(Peek(consumer), 0);
+    }
+
+    // a value is disposed of when the last consumer releases it
+    EXPECT_EQ(ring.Release(0), MFX_ERR_NONE);
+    EXPECT_EQ(ring.Release(2), MFX_ERR_NONE);
+    EXPECT_TRUE(disposed.empty());
+    EXPECT_EQ(Peek(0), 1);
+    EXPECT_EQ(Peek(1), 0);
+    EXPECT_EQ(ring.Release(1), MFX_ERR_NONE);
+    EXPECT_EQ(disposed, std::vector<int>({ 0 }));
+
+    for (mfxU32 consumer = 0; consumer < 3; consumer++) {
+        EXPECT_EQ(ring.Release(consumer), MFX_ERR_NONE);
+        EXPECT_EQ(ring.Release(consumer), MFX_ERR_NONE);
+        int value = -1;
+        EXPECT_EQ(ring.Peek(consumer, value), MFX_ERR_MORE_DATA);
+        EXPECT_EQ(ring.Release(consumer), MFX_ERR_MORE_DATA);
+    }
+    EXPECT_EQ(disposed, std::vector<int>({ 0, 1, 2 }));
+
+    msdkFanOutRing<int>::Statistics stat = ring.GetStatistics();
+    EXPECT_EQ(stat.Pushed, 3u);
+    EXPECT_EQ(stat.Occupancy, 0u);
+    EXPECT_EQ(stat.MaxOccupancy, 3u);
+}
+
+TEST_F(FanOutRingTest, SlowestConsumerThrottlesProducer) {
+    InitRing(4, 2);
+    for (int i = 0; i < 4; i++)
+        ASSERT_EQ(ring.Push(i, 0), MFX_ERR_NONE);
+
+    for (int i = 0; i < 4; i++)
+        EXPECT_EQ(ring.Release(0), MFX_ERR_NONE);
+    EXPECT_EQ(ring.Push(4, 10), MFX_TASK_WORKING);
+    EXPECT_EQ(ring.GetStatistics().ProducerStalls, 1u);
+    EXPECT_EQ(ring.GetStatistics().Occupancy, 4u);
+
+    EXPECT_EQ(ring.Release(1), MFX_ERR_NONE);
+    EXPECT_EQ(ring.Push(4, 10), MFX_ERR_NONE);
+    EXPECT_EQ(Peek(0), 4);
+    EXPECT_EQ(Peek(1), 1);
+}
+
+TEST_F(FanOutRingTest, ReleasingConsumerWakesUpProducer) {
+    InitRing(2, 1);
+    ASSERT_EQ(ring.Push(0, 0), MFX_ERR_NONE);
+    ASSERT_EQ(ring.Push(1, 0), MFX_ERR_NONE);
+
+    std::thread consumer([this]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        ring.Release(0);
+    });
+    EXPECT_EQ(ring.Push(2, 10000), MFX_ERR_NONE);
+    consumer.join();
+    EXPECT_EQ(Peek(0), 1);
+}
+
+TEST_F(FanOutRingTest, ConsumerWaitsForValue) {
+    InitRing(4, 1);
+    EXPECT_EQ(ring.Wait(0, 10), MFX_TASK_WORKING);
+    EXPECT_EQ(ring.GetStatistics().ConsumerSleeps, 1u);
+
+    std::thread producer([this]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        ring.Push(7, 0);
+    });
+    EXPECT_EQ(ring.Wait(0, 10000), MFX_ERR_NONE);
+    producer.join();
+    EXPECT_EQ(Peek(0), 7);
+}
+
+TEST_F(FanOutRingTest, CancelReleasesValuesOfConsumer) {
+    InitRing(4, 2);
+    for (int i = 0; i < 4; i++)
+        ASSERT_EQ(ring.Push(i, 0), MFX_ERR_NONE);
+    EXPECT_EQ(ring.Release(1), MFX_ERR_NONE);
+
+    // the values stay until the other consumer releases them
+    ring.Cancel(1);
+    EXPECT_TRUE(disposed.empty());
+    EXPECT_EQ(ring.GetLength(1), 0u);
+    EXPECT_EQ(ring.Wait(1, 0), MFX_ERR_ABORTED);
+    int value = -1;
+    EXPECT_EQ(ring.Peek(1, value), MFX_ERR_MORE_DATA);
+
+    // the cancelled consumer doesn't hold the producer back
+    for (int i = 0; i < 3; i++)
+        EXPECT_EQ(ring.Release(0), MFX_ERR_NONE);
+    EXPECT_EQ(disposed, std::vector<int>({ 0, 1, 2 }));
+    for (int i = 4; i < 7; i++)
+        EXPECT_EQ(ring.Push(i, 0), MFX_ERR_NONE);
+    EXPECT_EQ(ring.GetLength(0), 4u);
+    EXPECT_EQ(ring.GetLength(1), 0u);
+
+    ring.Cancel(0);
+    EXPECT_EQ(disposed.size(), 7u);
+    EXPECT_EQ(ring.Push(7, 0), MFX_ERR_ABORTED);
+}
+
+TEST_F(FanOutRingTest, ResetActivatesConsumersAgain) {
+    InitRing(4, 2);
+    ASSERT_EQ(ring.Push(0, 0), MFX_ERR_NONE);
+    ring.Cancel(0);
+    ring.Reset();
+
+    for (mfxU32 consumer = 0; consumer < 2; consumer++)
+        EXPECT_EQ(ring.GetLength(consumer), 0u);
+    ASSERT_EQ(ring.Push(1, 0), MFX_ERR_NONE);
+    EXPECT_EQ(Peek(0), 1);
+    EXPECT_EQ(Peek(1), 1);
+}
+
+TEST_F(FanOutRingTest, ResetOfConsumerKeepsValuesOfOthers) {
+    InitRing(4, 2);
+    for (int i = 0; i < 3; i++)
+        ASSERT_EQ(ring.Push(i, 0), MFX_ERR_NONE);
+    EXPECT_EQ(ring.Release(1), MFX_ERR_NONE);
+
+    ring.Reset(0);
+    EXPECT_EQ(ring.GetLength(0), 0u);
+    EXPECT_EQ(ring.GetLength(1), 2u);
+    EXPECT_EQ(Peek(1), 1);
+
+    // the values are disposed of once the other consumer releases them too
+    EXPECT_EQ(disposed, std::vector<int>({ 0 }));
+    for (int i = 0; i < 2; i++)
+        EXPECT_EQ(ring.Release(1), MFX_ERR_NONE);
+    EXPECT_EQ(disposed, std::vector<int>({ 0, 1, 2 }));
+
+    // a cancelled consumer gets the values pushed after the reset
+    ring.Cancel(1);
+    ring.Reset(1);
+    ASSERT_EQ(ring.Push(3, 0), MFX_ERR_NONE);
+    EXPECT_EQ(Peek(0), 3);
+    EXPECT_EQ(Peek(1), 3);
+}
+
+TEST_F(FanOutRingTest, ConcurrentConsumersGetAllValuesInOrder) {
+    const mfxU32 numConsumers = 4;
+    const int numValues       = 20000;
+    std::atomic<int> numDisposed(0);
+    ASSERT_EQ(ring.Init(8,
+                        numConsumers,
+                        [&numDisposed](int&) {
+                            numDisposed++;
+                        }),
+              MFX_ERR_NONE);
+
+    std::vector<int> errors(numConsumers, 0);
+    std::vector<std::thread> consumers;
+    for (mfxU32 consumer = 0; consumer < numConsumers; consumer++) {
+        consumers.emplace_back([this, consumer, &errors]() {
+            for (int expected = 0; expected < numValues; expected++) {
+                int value = -1;
+                while (ring.Peek(consumer, value) != MFX_ERR_NONE)
+                    ring.Wait(consumer, 1000);
+                if (value != expected)
+                    errors[consumer]++;
+                ring.Release(consumer);
+            }
+        });
+    }
+
+    for (int i = 0; i < numValues; i++)
+        ASSERT_EQ(ring.Push(i, 10000), MFX_ERR_NONE);
+    for (std::thread& consumer : consumers)
+        consumer.join();
+
+    EXPECT_EQ(errors, std::vector<int>(numConsumers, 0));
+    EXPECT_EQ(numDisposed, numValues);
+    EXPECT_LE(ring.GetStatistics().MaxOccupancy, 8u);
+}
+
+TEST_F(FanOutRingTest, ConsumerCancelledConcurrentlyLeavesNothingBehind) {
+    const int numValues = 20000;
+    std::atomic<int> numDisposed(0);
+    ASSERT_EQ(ring.Init(4,
+                        2,
+                        [&numDisposed](int&) {
+                            numDisposed++;
+                        }),
+              MFX_ERR_NONE);
+
+    std::thread reader([this]() {
+        for (int i = 0; i < numValues; i++) {
+            int value;
+            while (ring.Peek(0, value) != MFX_ERR_NONE)
+                ring.Wait(0, 1000);
+            ring.Release(0);
+        }
+    });
+    std::thread leaver([this]() {
+        for (int i = 0; i < numValues / 2; i++) {
+            int value;
+            while (ring.Peek(1, value) != MFX_ERR_NONE)
+                ring.Wait(1, 1000);
+            ring.Release(1);
+        }
+        ring.Cancel(1);
+    });
+
+    for (int i = 0; i < numValues; i++)
+        ASSERT_EQ(ring.Push(i, 10000), MFX_ERR_NONE);
+    reader.join();
+    leaver.join();
+
+    EXPECT_EQ(numDisposed, numValues);
+}
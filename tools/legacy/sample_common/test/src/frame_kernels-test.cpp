@@ -0,0 +1,213 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "frame_kernels.h"
+
+using namespace FrameKernels;
+
+namespace {
+
+// Sizes around the vector widths of all implementations
+const mfxU32 kCounts[] = { 0, 1, 3, 4, 7, 8, 15, 16, 17, 31, 32, 33, 63, 64, 65, 127, 129, 1000 };
+// Misaligned start offsets
+const mfxU32 kOffsets[] = { 0, 1, 3 };
+
+template <typename T>
+std::vector<T> RandomData(size_t size, std::mt19937& rng) {
+    std::uniform_int_distribution<unsigned> dist(0, 0xffff);
+    std::vector<T> data(size);
+    for (auto& x : data)
+        x = (T)dist(rng);
+    return data;
+}
+
+class FrameKernelsTest : public ::testing::TestWithParam<Isa> {
+protected:
+    void SetUp() override {
+        if (!IsIsaSupported(GetParam()))
+            GTEST_SKIP() << GetIsaName(GetParam()) << " isn't supported";
+        ref = GetKernels(ISA_SCALAR);
+        dut = GetKernels(GetParam());
+    }
+
+    const KernelTable* ref = nullptr;
+    const KernelTable* dut = nullptr;
+    std::mt19937 rng{ 12345 };
+};
+
+} // namespace
+
+TEST_P(FrameKernelsTest, InterleaveUV) {
+    for (mfxU32 count : kCounts) {
+        for (mfxU32 off : kOffsets) {
+            auto u = RandomData<mfxU8>(count + off, rng);
+            auto v = RandomData<mfxU8>(count + off, rng);
+            std::vector<mfxU8> expected(2 * count + off), actual(2 * count + off);
+            ref->InterleaveUV(u.data() + off, v.data() + off, expected.data() + off, count);
+            dut->InterleaveUV(u.data() + off, v.data() + off, actual.data() + off, count);
+            EXPECT_EQ(expected, actual) << "count " << count << " offset " << off;
+        }
+    }
+}
+
+TEST_P(FrameKernelsTest, DeinterleaveUV) {
+    for (mfxU32 count : kCounts) {
+        for (mfxU32 off : kOffsets) {
+            auto uv = RandomData<mfxU8>(2 * count + off, rng);
+            std::vector<mfxU8> expU(count + off), expV(count + off), actU(count + off),
+                actV(count + off);
+            ref->DeinterleaveUV(uv.data() + off, expU.data() + off, expV.data() + off, count);
+            dut->DeinterleaveUV(uv.data() + off, actU.data() + off, actV.data() + off, count);
+            EXPECT_EQ(expU, actU) << "count " << count << " offset " << off;
+            EXPECT_EQ(expV, actV) << "count " << count << " offset " << off;
+        }
+    }
+}
+
+TEST_P(FrameKernelsTest, ShiftLeftAndRight) {
+    for (mfxU32 shift : { 0u, 4u, 6u }) {
+        for (mfxU32 count : kCounts) {
+            auto src = RandomData<mfxU16>(count + 1, rng);
+            std::vector<mfxU16> expected(count + 1), actual(count + 1);
+
+            ref->ShiftLeft16(src.data() + 1, expected.data() + 1, count, shift);
+            dut->ShiftLeft16(src.data() + 1, actual.data() + 1, count, shift);
+            EXPECT_EQ(expected, actual) << "left count " << count << " shift " << shift;
+
+            ref->ShiftRight16(src.data() + 1, expected.data() + 1, count, shift);
+            dut->ShiftRight16(src.data() + 1, actual.data() + 1, count, shift);
+            EXPECT_EQ(expected, actual) << "right count " << count << " shift " << shift;
+
+            // in place
+            std::vector<mfxU16> inplace = src;
+            dut->ShiftLeft16(inplace.data(), inplace.data(), count, shift);
+            ref->ShiftLeft16(src.data(), expected.data(), count, shift);
+            EXPECT_TRUE(std::equal(expected.begin(), expected.begin() + count, inplace.begin()));
+        }
+    }
+}
+
+TEST_P(FrameKernelsTest, PackY210) {
+    for (mfxU32 count : kCounts) {
+        auto y = RandomData<mfxU16>(2 * count, rng);
+        auto u = RandomData<mfxU16>(count, rng);
+        auto v = RandomData<mfxU16>(count, rng);
+        std::vector<mfxU16> expected(4 * count), actual(4 * count);
+        ref->PackY210(y.data(), u.data(), v.data(), expected.data(), count, 6);
+        dut->PackY210(y.data(), u.data(), v.data(), actual.data(), count, 6);
+        EXPECT_EQ(expected, actual) << "count " << count;
+    }
+}
+
+TEST_P(FrameKernelsTest, PackY410) {
+    for (mfxU32 count : kCounts) {
+        auto y = RandomData<mfxU16>(count, rng);
+        auto u = RandomData<mfxU16>(count, rng);
+        auto v = RandomData<mfxU16>(count, rng);
+        std::vector<mfxU32> expected(count), actual(count);
+        ref->PackY410(y.data(), u.data(), v.data(), expected.data(), count);
+        dut->PackY410(y.data(), u.data(), v.data(), actual.data(), count);
+        EXPECT_EQ(expected, actual) << "count " << count;
+    }
+}
+
+TEST_P(FrameKernelsTest, SwapRB32) {
+    for (mfxU32 count : kCounts) {
+        auto src = RandomData<mfxU8>(4 * count, rng);
+        std::vector<mfxU8> expected(4 * count), actual(4 * count);
+        ref->SwapRB32(src.data(), expected.data(), count);
+        dut->SwapRB32(src.data(), actual.data(), count);
+        EXPECT_EQ(expected, actual) << "count " << count;
+
+        // swapping twice restores the data
+        dut->SwapRB32(actual.data(), actual.data(), count);
+        EXPECT_EQ(src, actual) << "count " << count;
+    }
+}
+
+TEST_P(FrameKernelsTest, FindZeroZeroByte) {
+    // mostly zeros, start code and emulation prevention values, so matches are frequent
+    std::uniform_int_distribution<unsigned> pick(0, 7);
+    const mfxU8 values[8] = { 0, 0, 0, 1, 3, 2, 0x80, 0xff };
+    for (int iter = 0; iter < 200; iter++) {
+        for (mfxU32 count : kCounts) {
+            std::vector<mfxU8> data(count + 3);
+            for (auto& x : data)
+                x = values[pick(rng)];
+            for (mfxU32 off : kOffsets) {
+                for (mfxU8 value : { 1, 3 }) {
+                    EXPECT_EQ(ref->FindZeroZeroByte(data.data() + off, count, value),
+                              dut->FindZeroZeroByte(data.data() + off, count, value))
+                        << "count " << count << " offset " << off;
+                }
+            }
+        }
+    }
+
+    // a single match at every position of a large buffer, nothing after the end
+    std::vector<mfxU8> data(300, 0x55);
+    data.push_back(0);
+    data.push_back(0);
+    for (mfxU32 pos = 0; pos + 3 <= 300; pos++) {
+        data[pos] = data[pos + 1] = 0;
+        data[pos + 2]             = 1;
+        EXPECT_EQ(dut->FindZeroZeroByte(data.data(), 300, 1), pos);
+        EXPECT_EQ(dut->FindZeroZeroByte(data.data(), pos + 2, 1), pos + 2);
+        data[pos] = data[pos + 1] = data[pos + 2] = 0x55;
+    }
+}
+
+TEST(FrameKernels, ScalarReference) {
+    const KernelTable* k = GetKernels(ISA_SCALAR);
+    ASSERT_NE(k, nullptr);
+
+    mfxU16 y[2] = { 0x3ff, 0x001 }, u[1] = { 0x155 }, v[1] = { 0x2aa };
+    mfxU16 y210[4];
+    k->PackY210(y, u, v, y210, 1, 6);
+    EXPECT_EQ(y210[0], 0xffc0);
+    EXPECT_EQ(y210[1], 0x5540);
+    EXPECT_EQ(y210[2], 0x0040);
+    EXPECT_EQ(y210[3], 0xaa80);
+
+    mfxU32 y410;
+    k->PackY410(y, u, v, &y410, 1);
+    EXPECT_EQ(y410, 0x155u | (0x3ffu << 10) | (0x2aau << 20) | (3u << 30));
+
+    mfxU8 rgb[4] = { 1, 2, 3, 4 };
+    k->SwapRB32(rgb, rgb, 1);
+    EXPECT_EQ(rgb[0], 3);
+    EXPECT_EQ(rgb[2], 1);
+
+    mfxU8 es[] = { 0, 0, 3, 0, 0, 0, 1, 0, 0 };
+    EXPECT_EQ(k->FindZeroZeroByte(es, sizeof(es), 1), 4u);
+    EXPECT_EQ(k->FindZeroZeroByte(es, sizeof(es), 3), 0u);
+    EXPECT_EQ(k->FindZeroZeroByte(es + 1, sizeof(es) - 1, 3), sizeof(es) - 1);
+    EXPECT_EQ(k->FindZeroZeroByte(es, 2, 3), 2u);
+}
+
+TEST(FrameKernels, DispatchSelectsBestSupported) {
+    EXPECT_TRUE(IsIsaSupported(ISA_SCALAR));
+
+    // the best table is NULL if kernels aren't built for the CPU architecture
+    const KernelTable* best = GetKernels(GetBestIsa());
+    EXPECT_EQ(&Kernels(), best ? best : GetKernels(ISA_SCALAR));
+}
+
+INSTANTIATE_TEST_SUITE_P(AllIsa,
+                         FrameKernelsTest,
+                         ::testing::Values(ISA_SSE42, ISA_AVX2, ISA_AVX512),
+                         [](const ::testing::TestParamInfo<Isa>& info) {
+                             return std::string(info.param == ISA_SSE42  ? "SSE42"
+                                                : info.param == ISA_AVX2 ? "AVX2"
+                                                                         : "AVX512");
+                         });
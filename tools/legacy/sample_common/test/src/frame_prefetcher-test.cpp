@@ -0,0 +1,186 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "frame_prefetcher.h"
+
+namespace {
+
+const mfxU16 kWidth  = 64;
+const mfxU16 kHeight = 32;
+const mfxU32 kFrames = 7;
+
+mfxFrameInfo MakeInfo() {
+    mfxFrameInfo info = {};
+    info.FourCC       = MFX_FOURCC_NV12;
+    info.ChromaFormat = MFX_CHROMAFORMAT_YUV420;
+    info.Width = info.CropW = kWidth;
+    info.Height = info.CropH = kHeight;
+    return info;
+}
+
+// System memory NV12 surface owned by the test
+struct TestSurface {
+    TestSurface() : buffer((size_t)kWidth * kHeight * 3 / 2), surface() {
+        surface.Info           = MakeInfo();
+        surface.Data.Y         = buffer.data();
+        surface.Data.UV        = buffer.data() + kWidth * kHeight;
+        surface.Data.V         = surface.Data.UV + 1;
+        surface.Data.PitchLow  = kWidth;
+        surface.Data.PitchHigh = 0;
+    }
+    std::vector<mfxU8> buffer;
+    mfxFrameSurface1 surface;
+};
+
+class FramePrefetcherFile : public ::testing::Test {
+protected:
+    void SetUp() override {
+        path = ::testing::TempDir() + "frame_prefetcher_input.nv12";
+        FILE* f = fopen(path.c_str(), "wb");
+        ASSERT_NE(f, nullptr);
+        // every byte of a frame is derived from the frame number and the offset
+        for (mfxU32 n = 0; n < kFrames; n++) {
+            std::vector<mfxU8> frame((size_t)kWidth * kHeight * 3 / 2);
+            for (size_t i = 0; i < frame.size(); i++)
+                frame[i] = (mfxU8)(n * 31 + i * 7);
+            fwrite(frame.data(), 1, frame.size(), f);
+        }
+        fclose(f);
+    }
+
+    void TearDown() override {
+        remove(path.c_str());
+    }
+
+    std::list<msdk_string> Inputs() const {
+        return std::list<msdk_string>(1, msdk_string(path.begin(), path.end()));
+    }
+
+    std::string path;
+};
+
+} // namespace
+
+TEST_F(FramePrefetcherFile, MatchesSynchronousReader) {
+    for (mfxU32 depth : { 1u, 3u, 16u }) {
+        CSmplYUVReader reference;
+        CPrefetchYUVReader reader;
+        reader.SetPrefetchDepth(depth);
+        ASSERT_EQ(reference.Init(Inputs(), MFX_FOURCC_NV12), MFX_ERR_NONE);
+        ASSERT_EQ(reader.Init(Inputs(), MFX_FOURCC_NV12), MFX_ERR_NONE);
+
+        // two passes check that Reset restarts reading from the beginning
+        for (int pass = 0; pass < 2; pass++) {
+            for (mfxU32 n = 0; n < kFrames; n++) {
+                TestSurface expected, actual;
+                ASSERT_EQ(reference.LoadNextFrame(&expected.surface), MFX_ERR_NONE);
+                ASSERT_EQ(reader.LoadNextFrame(&actual.surface), MFX_ERR_NONE);
+                EXPECT_EQ(expected.buffer, actual.buffer) << "depth " << depth << " frame " << n;
+            }
+
+            // end of file is reported to every following request
+            TestSurface last;
+            EXPECT_EQ(reader.LoadNextFrame(&last.surface), MFX_ERR_MORE_DATA);
+            EXPECT_EQ(reader.LoadNextFrame(&last.surface), MFX_ERR_MORE_DATA);
+
+            reference.Reset();
+            reader.Reset();
+        }
+
+        EXPECT_EQ(reader.GetPrefetcher().GetStatistics().frames, 2 * kFrames);
+        reader.Close();
+    }
+}
+
+TEST_F(FramePrefetcherFile, SkipRestartsReadAhead) {
+    CPrefetchYUVReader reader;
+    reader.SetPrefetchDepth(4);
+    ASSERT_EQ(reader.Init(Inputs(), MFX_FOURCC_NV12), MFX_ERR_NONE);
+
+    TestSurface first;
+    ASSERT_EQ(reader.LoadNextFrame(&first.surface), MFX_ERR_NONE);
+    EXPECT_EQ(first.buffer[0], 0);
+
+    ASSERT_EQ(reader.SkipNframesFromBeginning(kWidth, kHeight, 0, 5), MFX_ERR_NONE);
+    TestSurface skipped;
+    ASSERT_EQ(reader.LoadNextFrame(&skipped.surface), MFX_ERR_NONE);
+    EXPECT_EQ(skipped.buffer[0], (mfxU8)(5 * 31));
+}
+
+TEST(FramePrefetcher, AcquireKeepsFrameUntilRelease) {
+    mfxU32 loaded = 0;
+    CFramePrefetcher prefetcher;
+    ASSERT_EQ(prefetcher.Start(MakeInfo(),
+                               2,
+                               [&](mfxFrameSurface1* s) {
+                                   if (loaded == 5)
+                                       return MFX_ERR_MORE_DATA;
+                                   s->Data.Y[0] = (mfxU8)loaded++;
+                                   return MFX_ERR_NONE;
+                               }),
+              MFX_ERR_NONE);
+
+    for (mfxU8 n = 0; n < 5; n++) {
+        mfxFrameSurface1* frame = nullptr;
+        ASSERT_EQ(prefetcher.AcquireFrame(&frame), MFX_ERR_NONE);
+        ASSERT_NE(frame, nullptr);
+        EXPECT_EQ(frame->Data.Y[0], n);
+        // the ring is smaller than the stream, the frame must not be overwritten meanwhile
+        EXPECT_EQ(prefetcher.AcquireFrame(&frame), MFX_ERR_UNDEFINED_BEHAVIOR);
+        prefetcher.ReleaseFrame();
+    }
+
+    mfxFrameSurface1* frame = nullptr;
+    EXPECT_EQ(prefetcher.AcquireFrame(&frame), MFX_ERR_MORE_DATA);
+    EXPECT_EQ(prefetcher.GetStatistics().frames, 5u);
+    prefetcher.Stop();
+    EXPECT_FALSE(prefetcher.IsStarted());
+}
+
+TEST(FramePrefetcher, PropagatesLoaderError) {
+    mfxU32 calls = 0;
+    CFramePrefetcher prefetcher;
+    ASSERT_EQ(prefetcher.Start(MakeInfo(),
+                               4,
+                               [&](mfxFrameSurface1*) {
+                                   return ++calls == 2 ? MFX_ERR_ABORTED : MFX_ERR_NONE;
+                               }),
+              MFX_ERR_NONE);
+
+    TestSurface dst;
+    EXPECT_EQ(prefetcher.LoadNextFrame(&dst.surface), MFX_ERR_NONE);
+    EXPECT_EQ(prefetcher.LoadNextFrame(&dst.surface), MFX_ERR_ABORTED);
+    EXPECT_EQ(prefetcher.LoadNextFrame(&dst.surface), MFX_ERR_ABORTED);
+    prefetcher.Stop();
+    // loader isn't called after the error
+    EXPECT_EQ(calls, 2u);
+}
+
+TEST(FramePrefetcher, RejectsMismatchedSurface) {
+    CFramePrefetcher prefetcher;
+    ASSERT_EQ(prefetcher.Start(MakeInfo(),
+                               1,
+                               [](mfxFrameSurface1*) {
+                                   return MFX_ERR_NONE;
+                               }),
+              MFX_ERR_NONE);
+
+    TestSurface dst;
+    dst.surface.Info.Width = kWidth * 2;
+    EXPECT_EQ(prefetcher.LoadNextFrame(&dst.surface), MFX_ERR_INVALID_VIDEO_PARAM);
+    EXPECT_EQ(prefetcher.Start(MakeInfo(),
+                               1,
+                               [](mfxFrameSurface1*) {
+                                   return MFX_ERR_NONE;
+                               }),
+              MFX_ERR_UNDEFINED_BEHAVIOR);
+}
@@ -0,0 +1,235 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+#include "hevc_spl.h"
+#include "stream_builder.h"
+
+using namespace ProtectedLibrary;
+using namespace StreamBuilder;
+
+namespace {
+
+typedef HEVCStreamBuilder B;
+
+struct Frame {
+    Bytes data;
+    std::vector<SliceSplitterInfo> slices;
+    mfxI32 poc;
+};
+
+// Splits the whole stream at once, the bitstream is flagged with the end of stream
+std::vector<Frame> SplitFrames(const Bytes& stream) {
+    Bytes data = stream;
+    mfxBitstream bs = {};
+    bs.Data         = data.data();
+    bs.DataLength = bs.MaxLength = (mfxU32)data.size();
+    bs.DataFlag                  = MFX_BITSTREAM_EOS;
+
+    std::vector<Frame> frames;
+    HEVC_Spl splitter;
+    FrameSplitterInfo* info = NULL;
+    while (splitter.GetFrame(&bs, &info) == MFX_ERR_NONE && info) {
+        Frame frame;
+        frame.data.assign(info->Data, info->Data + info->DataLength);
+        frame.slices.assign(info->Slice, info->Slice + info->SliceNum);
+        frame.poc = splitter.GetPictureHeader()->pic_order_cnt;
+        frames.push_back(frame);
+        splitter.ResetCurrentState();
+    }
+    return frames;
+}
+
+std::vector<Bytes> FrameData(const std::vector<Frame>& frames) {
+    std::vector<Bytes> data;
+    for (auto& frame : frames)
+        data.push_back(frame.data);
+    return data;
+}
+
+} // namespace
+
+TEST(HevcSplTest, SplitsAccessUnits) {
+    std::mt19937 rng(2021);
+    B builder(rng);
+    Bytes sei = { 0x05, 0x01, 0x00, 0x80 };
+
+    builder.NewFrame();
+    builder.NalUnit(B::AUD, { 0x10 });
+    builder.ParameterSets();
+    builder.NalUnit(B::PREFIX_SEI, sei);
+    builder.Picture(B::IDR_W_RADL, B::SLICE_I, 0, 4, 300, 0, true);
+    builder.NalUnit(B::SUFFIX_SEI, sei);
+
+    // TRAIL_N NAL unit headers start with a zero byte
+    builder.NewFrame();
+    builder.Picture(B::TRAIL_N, B::SLICE_B, 1, 3, 100, 1);
+
+    builder.NewFrame();
+    builder.NalUnit(B::AUD, { 0x30 });
+    builder.Picture(B::TRAIL_R, B::SLICE_P, 2, 1, 1000);
+
+    // parameter sets can be repeated in front of any picture
+    builder.NewFrame();
+    builder.ParameterSets();
+    builder.Picture(B::TRAIL_R, B::SLICE_P, 3, 2, 10, 0, true);
+    builder.NalUnit(B::EOS, {});
+
+    std::vector<Frame> frames = SplitFrames(builder.stream.data);
+    ASSERT_EQ(FrameData(frames), builder.stream.frames);
+
+    ASSERT_EQ(frames[0].slices.size(), 4u);
+    ASSERT_EQ(frames[1].slices.size(), 3u);
+    ASSERT_EQ(frames[2].slices.size(), 1u);
+    ASSERT_EQ(frames[3].slices.size(), 2u);
+    EXPECT_EQ(frames[0].slices[1].SliceType, TYPE_I);
+    EXPECT_EQ(frames[1].slices[2].SliceType, TYPE_B);
+    EXPECT_EQ(frames[3].slices[1].SliceType, TYPE_P);
+
+    // slices point to their NAL units with start codes
+    for (auto& frame : frames) {
+        for (auto& slice : frame.slices) {
+            ASSERT_LE(slice.DataOffset + slice.DataLength, frame.data.size());
+            const mfxU8* nal = &frame.data[slice.DataOffset];
+            EXPECT_EQ(nal[0] | nal[1] | (nal[2] ^ 1), 0);
+            EXPECT_LT(nal[3] >> 1, 32);
+        }
+    }
+}
+
+TEST(HevcSplTest, DerivesPicOrderCnt) {
+    std::mt19937 rng(2021);
+    B builder(rng);
+
+    builder.NewFrame();
+    builder.ParameterSets();
+    builder.Picture(B::IDR_N_LP, B::SLICE_I, 0, 1, 10);
+    // the POC LSBs wrap at 256, sub-layer non-reference and higher sub-layer pictures are
+    // not used as the previous picture
+    mfxU32 lsbs[] = { 100, 200, 40, 140, 250, 90, 10 };
+    mfxU32 types[] = { B::TRAIL_R, B::TRAIL_R, B::TRAIL_R, B::TRAIL_R,
+                       B::TRAIL_N, B::TRAIL_R, B::TRAIL_R };
+    mfxU32 tids[]  = { 0, 0, 0, 0, 0, 1, 0 };
+    for (size_t i = 0; i < sizeof(lsbs) / sizeof(lsbs[0]); i++) {
+        builder.NewFrame();
+        builder.Picture(types[i], B::SLICE_P, lsbs[i], 2, 10, tids[i]);
+    }
+    // IDR pictures restart the count
+    builder.NewFrame();
+    builder.Picture(B::IDR_W_RADL, B::SLICE_I, 0, 1, 10);
+    builder.NewFrame();
+    builder.Picture(B::TRAIL_R, B::SLICE_P, 255, 1, 10);
+
+    std::vector<Frame> frames = SplitFrames(builder.stream.data);
+    ASSERT_EQ(FrameData(frames), builder.stream.frames);
+
+    std::vector<mfxI32> pocs;
+    for (auto& frame : frames)
+        pocs.push_back(frame.poc);
+    EXPECT_EQ(pocs, std::vector<mfxI32>({ 0, 100, 200, 296, 396, 506, 346, 522, 0, -1 }));
+}
+
+TEST(HevcSplTest, StartsAtRandomAccessPoint) {
+    std::mt19937 rng(2021);
+    B builder(rng);
+
+    // pictures before the first random access point are dropped
+    builder.NewFrame(false);
+    builder.Picture(B::TRAIL_R, B::SLICE_P, 7, 2, 50);
+
+    builder.NewFrame();
+    builder.ParameterSets();
+    builder.Picture(B::CRA, B::SLICE_I, 16, 2, 50);
+    // leading pictures of the first CRA, RASL pictures refer to the dropped pictures
+    builder.NewFrame(false);
+    builder.Picture(B::RASL_N, B::SLICE_B, 14, 2, 50);
+    builder.NewFrame();
+    builder.Picture(B::RADL_N, B::SLICE_B, 15, 2, 50);
+    builder.NewFrame();
+    builder.Picture(B::TRAIL_R, B::SLICE_P, 20, 2, 50);
+
+    // RASL pictures of the following CRA pictures are decodable
+    builder.NewFrame();
+    builder.Picture(B::CRA, B::SLICE_I, 32, 1, 50);
+    builder.NewFrame();
+    builder.Picture(B::RASL_R, B::SLICE_B, 30, 1, 50);
+    builder.NalUnit(B::EOS, {});
+
+    // unless the CRA picture starts a coded video sequence after the end of sequence
+    builder.NewFrame();
+    builder.Picture(B::CRA, B::SLICE_I, 48, 1, 50);
+    builder.NewFrame(false);
+    builder.Picture(B::RASL_R, B::SLICE_B, 46, 3, 50);
+    builder.NewFrame();
+    builder.Picture(B::TRAIL_R, B::SLICE_P, 52, 1, 50);
+
+    std::vector<Frame> frames = SplitFrames(builder.stream.data);
+    EXPECT_EQ(FrameData(frames), builder.stream.frames);
+}
+
+TEST(HevcSplTest, SplitsPictureWithLostFirstSegment) {
+    std::mt19937 rng(2021);
+    B builder(rng);
+
+    builder.NewFrame();
+    builder.ParameterSets();
+    builder.Picture(B::IDR_W_RADL, B::SLICE_I, 0, 3, 40);
+    builder.NewFrame();
+    builder.Picture(B::TRAIL_R, B::SLICE_P, 1, 3, 40, 0, false, false);
+    builder.NewFrame();
+    builder.Picture(B::TRAIL_R, B::SLICE_P, 2, 3, 40, 0, false, false);
+
+    std::vector<Frame> frames = SplitFrames(builder.stream.data);
+    EXPECT_EQ(FrameData(frames), builder.stream.frames);
+}
+
+TEST(HevcSplTest, SplitsStreamFedInChunks) {
+    std::mt19937 rng(2021);
+    std::vector<mfxU32> sizes;
+    std::uniform_int_distribution<mfxU32> size(0, 20000), chunk(1, 5000);
+    for (int i = 0; i < 100; i++)
+        sizes.push_back(size(rng));
+    Stream stream = MakeHEVCStream(sizes, 3, rng);
+
+    HEVC_Spl splitter;
+    std::vector<mfxU8> buffer(64 * 1024);
+    mfxBitstream bs = {};
+    bs.Data         = buffer.data();
+    bs.MaxLength    = (mfxU32)buffer.size();
+
+    std::vector<Bytes> frames;
+    size_t read = 0;
+    for (;;) {
+        FrameSplitterInfo* info = NULL;
+        if (splitter.GetFrame(&bs, &info) == MFX_ERR_NONE && info) {
+            frames.emplace_back(info->Data, info->Data + info->DataLength);
+            splitter.ResetCurrentState();
+            continue;
+        }
+        if (bs.DataFlag & MFX_BITSTREAM_EOS)
+            break;
+
+        // the splitter keeps the unfinished NAL unit at the beginning of the bitstream
+        memmove(bs.Data, bs.Data + bs.DataOffset, bs.DataLength);
+        bs.DataOffset = 0;
+        mfxU32 size   = std::min<mfxU32>({ chunk(rng),
+                                         bs.MaxLength - bs.DataLength,
+                                         (mfxU32)(stream.data.size() - read) });
+        memcpy(bs.Data + bs.DataLength, stream.data.data() + read, size);
+        bs.DataLength += size;
+        read += size;
+        if (read == stream.data.size())
+            bs.DataFlag |= MFX_BITSTREAM_EOS;
+    }
+
+    ASSERT_EQ(frames.size(), stream.frames.size());
+    for (size_t i = 0; i < frames.size(); i++)
+        EXPECT_EQ(frames[i], stream.frames[i]) << "frame " << i;
+}
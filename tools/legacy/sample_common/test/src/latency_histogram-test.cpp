@@ -0,0 +1,132 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "latency_histogram.h"
+#include "time_statistics.h"
+
+namespace {
+
+// Exact percentile of the sorted values with the same rank rule as the histogram
+double ExactPercentile(const std::vector<double>& sorted, double percent) {
+    size_t rank = (size_t)(percent / 100 * sorted.size() + 0.5);
+    return sorted[std::max<size_t>(rank, 1) - 1];
+}
+
+void ExpectPercentilesNear(const CLatencyHistogram& histogram, std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    for (double percent : { 1.0, 10.0, 50.0, 90.0, 99.0, 99.9, 100.0 }) {
+        double exact = ExactPercentile(values, percent);
+        EXPECT_NEAR(histogram.GetPercentile(percent), exact, exact / 100) << "P" << percent;
+    }
+}
+
+} // namespace
+
+TEST(LatencyHistogram, IsEmptyInitially) {
+    CLatencyHistogram histogram;
+    EXPECT_EQ(histogram.GetCount(), 0u);
+    EXPECT_EQ(histogram.GetPercentile(50), 0);
+    EXPECT_EQ(histogram.GetMin(), 0);
+    EXPECT_EQ(histogram.GetMax(), 0);
+    EXPECT_EQ(histogram.GetMean(), 0);
+}
+
+TEST(LatencyHistogram, CountsSmallValuesExactly) {
+    CLatencyHistogram histogram;
+    for (int ns = 1; ns <= 100; ns++)
+        histogram.Record(ns * 1e-9);
+
+    EXPECT_EQ(histogram.GetCount(), 100u);
+    EXPECT_DOUBLE_EQ(histogram.GetPercentile(50), 50e-9);
+    EXPECT_DOUBLE_EQ(histogram.GetPercentile(99), 99e-9);
+    EXPECT_DOUBLE_EQ(histogram.GetMin(), 1e-9);
+    EXPECT_DOUBLE_EQ(histogram.GetMax(), 100e-9);
+    EXPECT_NEAR(histogram.GetMean(), 50.5e-9, 1e-15);
+}
+
+TEST(LatencyHistogram, KeepsRelativeErrorOnUniformValues) {
+    CLatencyHistogram histogram;
+    std::vector<double> values;
+    // 1 us to 100 ms
+    for (int i = 0; i < 100000; i++) {
+        double value = 1e-6 + i * 1e-6;
+        histogram.Record(value);
+        values.push_back(value);
+    }
+    ExpectPercentilesNear(histogram, values);
+}
+
+TEST(LatencyHistogram, KeepsRelativeErrorOnLongTail) {
+    CLatencyHistogram histogram;
+    std::vector<double> values;
+    // mostly frames of about 16 ms and rare stalls up to seconds
+    for (int i = 0; i < 20000; i++) {
+        double value = 0.016 + (i % 97) * 1e-5;
+        if (i % 500 == 0)
+            value = 0.1 * (1 + i / 500);
+        histogram.Record(value);
+        values.push_back(value);
+    }
+    ExpectPercentilesNear(histogram, values);
+    EXPECT_DOUBLE_EQ(histogram.GetMax(), *std::max_element(values.begin(), values.end()));
+}
+
+TEST(LatencyHistogram, ClampsOutOfRangeValues) {
+    CLatencyHistogram histogram;
+    histogram.Record(-1);
+    histogram.Record(1e6);
+    EXPECT_EQ(histogram.GetCount(), 2u);
+    EXPECT_EQ(histogram.GetMin(), 0);
+    EXPECT_NEAR(histogram.GetMax(),
+                ((1ull << CLatencyHistogram::MaxValueBits) - 1) * 1e-9,
+                1e-9);
+}
+
+TEST(LatencyHistogram, MergeMatchesRecordingIntoOne) {
+    CLatencyHistogram first, second, all;
+    for (int i = 0; i < 5000; i++) {
+        double value = (i * 7919 % 10007) * 1e-6;
+        (i % 3 ? first : second).Record(value);
+        all.Record(value);
+    }
+    first.Merge(second);
+
+    EXPECT_EQ(first.GetCount(), all.GetCount());
+    EXPECT_DOUBLE_EQ(first.GetMin(), all.GetMin());
+    EXPECT_DOUBLE_EQ(first.GetMax(), all.GetMax());
+    EXPECT_NEAR(first.GetMean(), all.GetMean(), 1e-12);
+    for (double percent : { 50.0, 90.0, 99.0, 99.9 })
+        EXPECT_DOUBLE_EQ(first.GetPercentile(percent), all.GetPercentile(percent)) << percent;
+}
+
+TEST(LatencyHistogram, ResetClearsMeasurements) {
+    CLatencyHistogram histogram;
+    histogram.Record(0.5);
+    histogram.Reset();
+    EXPECT_EQ(histogram.GetCount(), 0u);
+
+    histogram.Record(0.001);
+    EXPECT_EQ(histogram.GetCount(), 1u);
+    EXPECT_DOUBLE_EQ(histogram.GetPercentile(100), 0.001);
+    EXPECT_DOUBLE_EQ(histogram.GetMin(), 0.001);
+}
+
+TEST(TimeStatistics, ReportsPercentilesOfWindow) {
+    CTimeStatisticsReal stat;
+    stat.StartTimeMeasurement();
+    stat.StopTimeMeasurement();
+    EXPECT_EQ(stat.GetHistogram().GetCount(), 1u);
+    EXPECT_NEAR(stat.GetPercentile(100), stat.GetMaxTime(), stat.GetMaxTime() / 100 + 1e-9);
+
+    stat.ResetStatistics();
+    EXPECT_EQ(stat.GetHistogram().GetCount(), 0u);
+    EXPECT_EQ(stat.GetPercentile(50), 0);
+}
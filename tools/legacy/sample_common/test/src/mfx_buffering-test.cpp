@@ -0,0 +1,218 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "mfx_buffering.h"
+
+namespace {
+
+// CBuffering is used by deriving from it
+class TestBuffering : public CBuffering {
+public:
+    using CBuffering::AllocBuffers;
+    using CBuffering::FindUsedSurface;
+    using CBuffering::FreeBuffers;
+    using CBuffering::GetFreeOutputSurface;
+    using CBuffering::ReturnSurfaceToBuffers;
+    using CBuffering::SyncFrameSurfaces;
+    using CBuffering::m_DeliveredSurfacesPool;
+    using CBuffering::m_FreeSurfacesPool;
+    using CBuffering::m_UsedSurfacesPool;
+
+    ~TestBuffering() {
+        FreeBuffers();
+    }
+};
+
+struct StackElement {
+    std::atomic<int> owners;
+};
+
+} // namespace
+
+TEST(LockFreeStack, KeepsEveryElementOnceUnderContention) {
+    const mfxU32 numElements   = 8;
+    const mfxU32 numThreads    = 4;
+    const mfxU32 numIterations = 200000;
+
+    std::vector<StackElement> elements(numElements);
+    msdkLockFreeStack<StackElement> stack;
+    stack.Init(elements.data(), numElements);
+    for (StackElement& element : elements) {
+        element.owners = 0;
+        stack.Push(&element);
+    }
+
+    // an element popped twice without a push in between would have two owners
+    std::atomic<mfxU32> errors(0);
+    std::vector<std::thread> threads;
+    for (mfxU32 t = 0; t < numThreads; t++) {
+        threads.emplace_back([&]() {
+            for (mfxU32 i = 0; i < numIterations; i++) {
+                StackElement* element = stack.Pop();
+                if (!element)
+                    continue;
+                if (element->owners.fetch_add(1) != 0)
+                    errors++;
+                element->owners.fetch_sub(1);
+                stack.Push(element);
+            }
+        });
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+    EXPECT_EQ(errors, 0u);
+
+    std::set<StackElement*> popped;
+    while (StackElement* element = stack.Pop())
+        EXPECT_TRUE(popped.insert(element).second);
+    EXPECT_EQ(popped.size(), numElements);
+}
+
+TEST(OutputSurfacesPool, KeepsOrderOfEveryProducer) {
+    const mfxU32 numProducers = 3;
+    const mfxU32 numSurfaces  = 100000;
+
+    // the surface of an output encodes the producer and the syncp the sequence number
+    std::vector<msdkOutputSurface> outputs(numProducers * numSurfaces);
+    msdkOutputSurfacesPool pool;
+
+    std::vector<std::thread> producers;
+    for (mfxU32 p = 0; p < numProducers; p++) {
+        producers.emplace_back([&, p]() {
+            for (mfxU32 i = 0; i < numSurfaces; i++) {
+                msdkOutputSurface& output = outputs[p * numSurfaces + i];
+                output.surface            = (msdkFrameSurface*)(size_t)(p + 1);
+                output.syncp              = (mfxSyncPoint)(size_t)(i + 1);
+                pool.AddSurface(&output);
+            }
+        });
+    }
+
+    std::vector<size_t> next(numProducers, 1);
+    mfxU32 received = 0;
+    while (received < numProducers * numSurfaces) {
+        msdkOutputSurface* output = pool.GetSurface();
+        if (!output) {
+            std::this_thread::yield();
+            continue;
+        }
+        size_t p = (size_t)output->surface - 1;
+        ASSERT_LT(p, numProducers);
+        ASSERT_EQ((size_t)output->syncp, next[p]) << "producer " << p;
+        next[p]++;
+        received++;
+    }
+    for (std::thread& producer : producers)
+        producer.join();
+
+    EXPECT_EQ(pool.GetSurface(), nullptr);
+    EXPECT_EQ(pool.GetSurfaceCount(), 0u);
+}
+
+TEST(Buffering, ReturnsDeliveredSurfacesFromAnotherThread) {
+    const mfxU32 numSurfaces = 4;
+    const mfxU32 numFrames   = 100000;
+
+    TestBuffering buffering;
+    ASSERT_EQ(buffering.AllocBuffers(numSurfaces), MFX_ERR_NONE);
+
+    // the decoding thread hands the surfaces over to the delivering thread as sample_decode
+    // does in the rendering mode
+    std::atomic<bool> stop(false);
+    std::atomic<mfxU32> delivered(0);
+    std::thread deliver([&]() {
+        while (!stop || buffering.m_DeliveredSurfacesPool.GetSurfaceCount()) {
+            msdkOutputSurface* output = buffering.m_DeliveredSurfacesPool.GetSurface();
+            if (!output) {
+                std::this_thread::yield();
+                continue;
+            }
+            buffering.ReturnSurfaceToBuffers(output);
+            delivered++;
+        }
+    });
+
+    for (mfxU32 i = 0; i < numFrames; i++) {
+        buffering.SyncFrameSurfaces();
+        msdkFrameSurface* surface = buffering.m_FreeSurfacesPool.GetSurface();
+        if (!surface) {
+            std::this_thread::yield();
+            i--;
+            continue;
+        }
+        buffering.m_UsedSurfacesPool.AddSurface(surface);
+
+        msdkOutputSurface* output = buffering.GetFreeOutputSurface();
+        ASSERT_NE(output, nullptr) << "frame " << i;
+        msdk_atomic_inc16(&surface->render_lock);
+        output->surface = buffering.FindUsedSurface(&surface->frame);
+        output->syncp   = (mfxSyncPoint)(size_t)(i + 1);
+        buffering.m_DeliveredSurfacesPool.AddSurface(output);
+    }
+    stop = true;
+    deliver.join();
+    EXPECT_EQ(delivered, numFrames);
+
+    // all surfaces are back
+    buffering.SyncFrameSurfaces();
+    std::set<msdkFrameSurface*> surfaces;
+    while (msdkFrameSurface* surface = buffering.m_FreeSurfacesPool.GetSurface())
+        surfaces.insert(surface);
+    EXPECT_EQ(surfaces.size(), numSurfaces);
+    std::set<msdkOutputSurface*> outputs;
+    while (msdkOutputSurface* output = buffering.GetFreeOutputSurface())
+        outputs.insert(output);
+    EXPECT_EQ(outputs.size(), numSurfaces);
+}
+
+TEST(Buffering, ReallocatesOutputSurfacesForMoreSurfaces) {
+    // the decoder is reset with a stream which needs more surfaces
+    TestBuffering buffering;
+    ASSERT_EQ(buffering.AllocBuffers(2), MFX_ERR_NONE);
+    buffering.FreeBuffers();
+    ASSERT_EQ(buffering.AllocBuffers(6), MFX_ERR_NONE);
+
+    std::set<msdkFrameSurface*> surfaces;
+    while (msdkFrameSurface* surface = buffering.m_FreeSurfacesPool.GetSurface())
+        surfaces.insert(surface);
+    EXPECT_EQ(surfaces.size(), 6u);
+    std::set<msdkOutputSurface*> outputs;
+    while (msdkOutputSurface* output = buffering.GetFreeOutputSurface())
+        outputs.insert(output);
+    EXPECT_EQ(outputs.size(), 6u);
+}
+
+TEST(Buffering, SyncReleasesAllUnlockedSurfaces) {
+    TestBuffering buffering;
+    ASSERT_EQ(buffering.AllocBuffers(4), MFX_ERR_NONE);
+
+    std::vector<msdkFrameSurface*> used;
+    for (int i = 0; i < 4; i++) {
+        used.push_back(buffering.m_FreeSurfacesPool.GetSurface());
+        ASSERT_NE(used.back(), nullptr);
+        buffering.m_UsedSurfacesPool.AddSurface(used.back());
+    }
+    EXPECT_EQ(buffering.m_FreeSurfacesPool.GetSurface(), nullptr);
+
+    // the surface in the middle stays with the library
+    used[1]->frame.Data.Locked = 1;
+    buffering.SyncFrameSurfaces();
+    std::set<msdkFrameSurface*> released;
+    while (msdkFrameSurface* surface = buffering.m_FreeSurfacesPool.GetSurface())
+        released.insert(surface);
+    EXPECT_EQ(released, std::set<msdkFrameSurface*>({ used[0], used[2], used[3] }));
+
+    used[1]->frame.Data.Locked = 0;
+    buffering.SyncFrameSurfaces();
+    EXPECT_EQ(buffering.m_FreeSurfacesPool.GetSurface(), used[1]);
+}
@@ -0,0 +1,77 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include <gtest/gtest.h>
+
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#include "vm/numa_defs.h"
+
+TEST(Numa, ParsesCpuLists) {
+    std::vector<mfxU32> cpus;
+    EXPECT_EQ(msdk_parse_cpu_list(MSDK_STRING("0-3,8,10-11"), cpus), MFX_ERR_NONE);
+    EXPECT_EQ(cpus, std::vector<mfxU32>({ 0, 1, 2, 3, 8, 10, 11 }));
+
+    // sysfs lists end with a new line
+    EXPECT_EQ(msdk_parse_cpu_list(MSDK_STRING("5\n"), cpus), MFX_ERR_NONE);
+    EXPECT_EQ(cpus, std::vector<mfxU32>({ 5 }));
+
+    for (const msdk_char* str : { MSDK_STRING(""),
+                                  MSDK_STRING("3-1"),
+                                  MSDK_STRING("a"),
+                                  MSDK_STRING("1,,2"),
+                                  MSDK_STRING("-1"),
+                                  MSDK_STRING("1-"),
+                                  MSDK_STRING("1 2") }) {
+        EXPECT_EQ(msdk_parse_cpu_list(str, cpus), MFX_ERR_UNSUPPORTED) << str;
+    }
+}
+
+TEST(Numa, PinsThreadToCpusOfNode) {
+    mfxU32 numNodes = msdk_numa_get_node_count();
+    ASSERT_GE(numNodes, 1u);
+
+    std::vector<mfxU32> all;
+    for (mfxU32 node = 0; node < numNodes; node++) {
+        std::vector<mfxU32> cpus;
+        if (msdk_numa_get_node_cpus(node, cpus) == MFX_ERR_NONE)
+            all.insert(all.end(), cpus.begin(), cpus.end());
+    }
+    ASSERT_FALSE(all.empty());
+
+    // the calling thread of the test keeps its affinity
+    mfxStatus sts = MFX_ERR_NONE;
+    std::thread thread([&]() {
+        sts = msdk_thread_set_affinity({ all[0] });
+    });
+    thread.join();
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+}
+
+TEST(Numa, ReportsMemoryPerNode) {
+    const size_t size = 16 * 1024 * 1024;
+    std::vector<mfxU8> buffer(size);
+    memset(buffer.data(), 1, size);
+
+    std::vector<mfxU64> bytesPerNode;
+    mfxStatus sts = msdk_numa_get_memory_nodes(buffer.data(), size, bytesPerNode);
+    if (sts == MFX_ERR_UNSUPPORTED)
+        GTEST_SKIP() << "no NUMA support";
+    ASSERT_EQ(sts, MFX_ERR_NONE);
+    mfxU64 resident = 0;
+    for (mfxU64 bytes : bytesPerNode)
+        resident += bytes;
+    EXPECT_GE(resident, size);
+
+    // the process has the buffer and more
+    ASSERT_EQ(msdk_numa_get_process_memory(bytesPerNode), MFX_ERR_NONE);
+    mfxU64 total = 0;
+    for (mfxU64 bytes : bytesPerNode)
+        total += bytes;
+    EXPECT_GE(total, size);
+}
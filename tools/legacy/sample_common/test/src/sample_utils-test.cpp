@@ -0,0 +1,409 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+#include <algorithm>
+#include <list>
+#include <string>
+#include <vector>
+#if !defined(_WIN32) && !defined(_WIN64)
+    #include <unistd.h>
+#endif
+
+#include "sample_utils.h"
+
+namespace {
+
+const mfxU16 kWidth  = 48;
+const mfxU16 kHeight = 16;
+
+// Visible part of a plane of the surface
+struct PlaneLayout {
+    mfxU32 RowSize;
+    mfxU32 Rows;
+    mfxU32 Pitch;
+};
+
+// System memory surface of the given format with padded rows. Every plane has a buffer of
+// its own, so the padding of one plane can't hide a row written to the wrong place.
+class TestFrame {
+public:
+    explicit TestFrame(mfxU32 fourcc) : surface(), m_buffers(), m_layouts() {
+        mfxFrameInfo& info = surface.Info;
+        info.FourCC        = fourcc;
+        info.Width = info.CropW = kWidth;
+        info.Height = info.CropH = kHeight;
+        info.BitDepthLuma = info.BitDepthChroma = 8;
+
+        const mfxU32 w = kWidth, h = kHeight;
+        switch (fourcc) {
+            case MFX_FOURCC_NV12:
+                AddPlane(w, h);
+                AddPlane(w, h / 2, Pitch());
+                surface.Data.Y  = Plane(0);
+                surface.Data.UV = Plane(1);
+                surface.Data.V  = Plane(1) + 1;
+                break;
+            case MFX_FOURCC_I420:
+            case MFX_FOURCC_YV12:
+                AddPlane(w, h);
+                AddPlane(w / 2, h / 2, Pitch() / 2);
+                AddPlane(w / 2, h / 2, Pitch() / 2);
+                surface.Data.Y = Plane(0);
+                surface.Data.U = Plane(1);
+                surface.Data.V = Plane(2);
+                break;
+            case MFX_FOURCC_P010:
+            case MFX_FOURCC_P210:
+                info.BitDepthLuma = info.BitDepthChroma = 10;
+                AddPlane(2 * w, h);
+                AddPlane(2 * w, fourcc == MFX_FOURCC_P210 ? h : h / 2, Pitch());
+                surface.Data.Y  = Plane(0);
+                surface.Data.UV = Plane(1);
+                surface.Data.V  = Plane(1) + 2;
+                break;
+            case MFX_FOURCC_I010:
+                info.BitDepthLuma = info.BitDepthChroma = 10;
+                AddPlane(2 * w, h);
+                AddPlane(w, h / 2, Pitch() / 2);
+                AddPlane(w, h / 2, Pitch() / 2);
+                surface.Data.Y = Plane(0);
+                surface.Data.U = Plane(1);
+                surface.Data.V = Plane(2);
+                break;
+            case MFX_FOURCC_YUY2:
+                AddPlane(2 * w, h);
+                surface.Data.Y = Plane(0);
+                surface.Data.U = Plane(0) + 1;
+                surface.Data.V = Plane(0) + 3;
+                break;
+            case MFX_FOURCC_Y210:
+                info.BitDepthLuma = info.BitDepthChroma = 10;
+                AddPlane(4 * w, h);
+                surface.Data.Y = Plane(0);
+                surface.Data.U = Plane(0) + 2;
+                surface.Data.V = Plane(0) + 6;
+                break;
+            case MFX_FOURCC_Y410:
+                info.BitDepthLuma = info.BitDepthChroma = 10;
+                AddPlane(4 * w, h);
+                surface.Data.Y    = Plane(0);
+                surface.Data.Y410 = (mfxY410*)Plane(0);
+                surface.Data.V    = Plane(0);
+                break;
+            case MFX_FOURCC_RGB4:
+            case MFX_FOURCC_AYUV:
+            case MFX_FOURCC_A2RGB10:
+                AddPlane(4 * w, h);
+                surface.Data.B = Plane(0);
+                surface.Data.G = Plane(0) + 1;
+                surface.Data.R = Plane(0) + 2;
+                surface.Data.A = Plane(0) + 3;
+                break;
+            default:
+                ADD_FAILURE() << "unsupported format";
+                break;
+        }
+        surface.Data.Pitch = (mfxU16)Pitch();
+    }
+
+    // Fills the buffers including the padding
+    void Fill(mfxU32 seed) {
+        for (auto& buffer : m_buffers) {
+            for (size_t i = 0; i < buffer.size(); i++)
+                buffer[i] = (mfxU8)(seed + i * 13 + (i >> 8));
+            seed += 101;
+        }
+    }
+
+    // Clears the low bits of the 16-bit samples, so they survive shifting down and up
+    void ClearLowBits(mfxU32 shift) {
+        for (auto& buffer : m_buffers) {
+            mfxU16* samples = (mfxU16*)buffer.data();
+            for (size_t i = 0; i < buffer.size() / 2; i++)
+                samples[i] = (mfxU16)(samples[i] >> shift << shift);
+        }
+    }
+
+    // Size of the frame in the file
+    mfxU32 FileSize() const {
+        mfxU32 size = 0;
+        for (auto& layout : m_layouts)
+            size += layout.RowSize * layout.Rows;
+        return size;
+    }
+
+    // Compares the visible rows of the planes
+    void ExpectSameVisible(const TestFrame& other) const {
+        ASSERT_EQ(m_layouts.size(), other.m_layouts.size());
+        for (size_t n = 0; n < m_layouts.size(); n++) {
+            const PlaneLayout& layout = m_layouts[n];
+            for (mfxU32 row = 0; row < layout.Rows; row++) {
+                const mfxU8* a = m_buffers[n].data() + (size_t)row * layout.Pitch;
+                const mfxU8* b = other.m_buffers[n].data() + (size_t)row * layout.Pitch;
+                ASSERT_TRUE(std::equal(a, a + layout.RowSize, b))
+                    << "plane " << n << " row " << row;
+            }
+        }
+    }
+
+    mfxFrameSurface1 surface;
+
+private:
+    // luma rows are padded, chroma pitches are derived from it the way the samples expect
+    mfxU32 Pitch() const {
+        return m_layouts.empty() ? 0 : m_layouts[0].Pitch;
+    }
+
+    void AddPlane(mfxU32 rowSize, mfxU32 rows, mfxU32 pitch = 0) {
+        if (!pitch)
+            pitch = (rowSize + 32 + 15) & ~15u;
+        m_layouts.push_back({ rowSize, rows, pitch });
+        m_buffers.emplace_back((size_t)pitch * rows, 0);
+    }
+
+    mfxU8* Plane(size_t n) {
+        return m_buffers[n].data();
+    }
+
+    std::vector<std::vector<mfxU8>> m_buffers;
+    std::vector<PlaneLayout> m_layouts;
+};
+
+class SmplYUVFile : public ::testing::Test {
+protected:
+    void SetUp() override {
+        path = ::testing::TempDir() + "sample_utils_frames.yuv";
+    }
+
+    void TearDown() override {
+        remove(path.c_str());
+    }
+
+    std::list<msdk_string> Inputs() const {
+        return std::list<msdk_string>(1, msdk_string(path.begin(), path.end()));
+    }
+
+    long GetFileSize() const {
+        FILE* f = fopen(path.c_str(), "rb");
+        if (!f)
+            return -1;
+        fseek(f, 0, SEEK_END);
+        long size = ftell(f);
+        fclose(f);
+        return size;
+    }
+
+    // Writes the frames with CSmplYUVWriter and reads them back with CSmplYUVReader
+    void RoundTrip(mfxU32 fourcc, bool directIO = false) {
+        const mfxU32 numFrames = 3;
+        std::vector<TestFrame> written;
+
+        CSmplYUVWriter writer;
+        msdk_string name(path.begin(), path.end());
+        ASSERT_EQ(writer.Init(name.c_str(), 1), MFX_ERR_NONE);
+        for (mfxU32 n = 0; n < numFrames; n++) {
+            written.emplace_back(fourcc);
+            written.back().Fill(n * 7);
+            ASSERT_EQ(writer.WriteNextFrame(&written.back().surface), MFX_ERR_NONE);
+        }
+        writer.Close();
+        EXPECT_EQ(GetFileSize(), (long)(written[0].FileSize() * numFrames));
+
+        CSmplYUVReader reader;
+        reader.EnableDirectIO(directIO);
+        ASSERT_EQ(reader.Init(Inputs(), fourcc), MFX_ERR_NONE);
+        for (mfxU32 n = 0; n < numFrames; n++) {
+            TestFrame read(fourcc);
+            ASSERT_EQ(reader.LoadNextFrame(&read.surface), MFX_ERR_NONE) << "frame " << n;
+            written[n].ExpectSameVisible(read);
+        }
+        TestFrame last(fourcc);
+        EXPECT_EQ(reader.LoadNextFrame(&last.surface), MFX_ERR_MORE_DATA);
+    }
+
+    std::string path;
+};
+
+} // namespace
+
+TEST_F(SmplYUVFile, RoundTripsNV12) {
+    RoundTrip(MFX_FOURCC_NV12);
+}
+
+TEST_F(SmplYUVFile, RoundTripsI420) {
+    RoundTrip(MFX_FOURCC_I420);
+}
+
+TEST_F(SmplYUVFile, RoundTripsP010) {
+    RoundTrip(MFX_FOURCC_P010);
+}
+
+TEST_F(SmplYUVFile, RoundTripsP210) {
+    RoundTrip(MFX_FOURCC_P210);
+}
+
+TEST_F(SmplYUVFile, RoundTripsI010) {
+    RoundTrip(MFX_FOURCC_I010);
+}
+
+TEST_F(SmplYUVFile, RoundTripsYUY2) {
+    RoundTrip(MFX_FOURCC_YUY2);
+}
+
+TEST_F(SmplYUVFile, RoundTripsY210) {
+    RoundTrip(MFX_FOURCC_Y210);
+}
+
+TEST_F(SmplYUVFile, RoundTripsY410) {
+    RoundTrip(MFX_FOURCC_Y410);
+}
+
+TEST_F(SmplYUVFile, RoundTripsRGB4) {
+    RoundTrip(MFX_FOURCC_RGB4);
+}
+
+TEST_F(SmplYUVFile, RoundTripsAYUV) {
+    RoundTrip(MFX_FOURCC_AYUV);
+}
+
+TEST_F(SmplYUVFile, RoundTripsA2RGB10) {
+    RoundTrip(MFX_FOURCC_A2RGB10);
+}
+
+TEST_F(SmplYUVFile, RoundTripsWithDirectIO) {
+    // the reader falls back to regular reads where the file system rejects O_DIRECT
+    RoundTrip(MFX_FOURCC_NV12, true);
+    RoundTrip(MFX_FOURCC_I420, true);
+}
+
+// YV12 surfaces are written with the luma pitch for the V plane, so the file is produced
+// from a surface with U and V swapped by the I420 writer
+TEST_F(SmplYUVFile, ReadsYV12) {
+    TestFrame written(MFX_FOURCC_I420);
+    written.Fill(3);
+    std::swap(written.surface.Data.U, written.surface.Data.V);
+
+    CSmplYUVWriter writer;
+    msdk_string name(path.begin(), path.end());
+    ASSERT_EQ(writer.Init(name.c_str(), 1), MFX_ERR_NONE);
+    ASSERT_EQ(writer.WriteNextFrame(&written.surface), MFX_ERR_NONE);
+    writer.Close();
+
+    CSmplYUVReader reader;
+    ASSERT_EQ(reader.Init(Inputs(), MFX_FOURCC_YV12), MFX_ERR_NONE);
+    TestFrame read(MFX_FOURCC_YV12);
+    ASSERT_EQ(reader.LoadNextFrame(&read.surface), MFX_ERR_NONE);
+    written.ExpectSameVisible(read);
+}
+
+TEST_F(SmplYUVFile, ConvertsNV12ToI420AndBack) {
+    TestFrame written(MFX_FOURCC_NV12);
+    written.Fill(5);
+
+    CSmplYUVWriter writer;
+    msdk_string name(path.begin(), path.end());
+    ASSERT_EQ(writer.Init(name.c_str(), 1), MFX_ERR_NONE);
+    ASSERT_EQ(writer.WriteNextFrameI420(&written.surface), MFX_ERR_NONE);
+    writer.Close();
+    EXPECT_EQ(GetFileSize(), (long)written.FileSize());
+
+    // the I420 file is interleaved again into the NV12 surface
+    CSmplYUVReader reader;
+    ASSERT_EQ(reader.Init(Inputs(), MFX_FOURCC_I420), MFX_ERR_NONE);
+    TestFrame read(MFX_FOURCC_NV12);
+    ASSERT_EQ(reader.LoadNextFrame(&read.surface), MFX_ERR_NONE);
+    written.ExpectSameVisible(read);
+}
+
+TEST_F(SmplYUVFile, ShiftsMostSignificantBitsP010) {
+    TestFrame written(MFX_FOURCC_P010);
+    written.Fill(9);
+    written.ClearLowBits(6);
+    written.surface.Info.Shift = 1;
+
+    CSmplYUVWriter writer;
+    msdk_string name(path.begin(), path.end());
+    ASSERT_EQ(writer.Init(name.c_str(), 1), MFX_ERR_NONE);
+    ASSERT_EQ(writer.WriteNextFrame(&written.surface), MFX_ERR_NONE);
+    writer.Close();
+
+    // the file keeps the samples in the low bits
+    FILE* f = fopen(path.c_str(), "rb");
+    ASSERT_NE(f, nullptr);
+    mfxU16 sample = 0;
+    ASSERT_EQ(fread(&sample, sizeof(sample), 1, f), 1u);
+    fclose(f);
+    EXPECT_EQ(sample, written.surface.Data.Y16[0] >> 6);
+
+    CSmplYUVReader reader;
+    ASSERT_EQ(reader.Init(Inputs(), MFX_FOURCC_P010, true), MFX_ERR_NONE);
+    TestFrame read(MFX_FOURCC_P010);
+    ASSERT_EQ(reader.LoadNextFrame(&read.surface), MFX_ERR_NONE);
+    written.ExpectSameVisible(read);
+}
+
+TEST_F(SmplYUVFile, TransfersManyPitchedRows) {
+    // more rows than a single vectored call takes
+    const mfxU32 rows = 5000, rowSize = 3, pitch = 8;
+    std::vector<mfxU8> source((size_t)rows * pitch), target((size_t)rows * pitch, 0);
+    for (size_t i = 0; i < source.size(); i++)
+        source[i] = (mfxU8)(i * 7);
+
+    FILE* f = fopen(path.c_str(), "wb");
+    ASSERT_NE(f, nullptr);
+    FramePlane out[] = { { source.data(), rowSize, rows, pitch } };
+    EXPECT_EQ(WriteFramePlanes(f, out, 1), MFX_ERR_NONE);
+    fclose(f);
+    EXPECT_EQ(GetFileSize(), (long)(rows * rowSize));
+
+    f = fopen(path.c_str(), "rb");
+    ASSERT_NE(f, nullptr);
+    FramePlane in[] = { { target.data(), rowSize, rows, pitch } };
+    EXPECT_EQ(ReadFramePlanes(f, in, 1), MFX_ERR_NONE);
+    EXPECT_EQ(ReadFramePlanes(f, in, 1), MFX_ERR_MORE_DATA);
+    fclose(f);
+
+    for (mfxU32 row = 0; row < rows; row++) {
+        const mfxU8* a = &source[row * pitch];
+        ASSERT_TRUE(std::equal(a, a + rowSize, &target[row * pitch])) << "row " << row;
+    }
+}
+
+#if !defined(_WIN32) && !defined(_WIN64)
+TEST(SmplYUVPipe, TransfersPlanesThroughStdio) {
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    FILE* out = fdopen(fds[1], "wb");
+    FILE* in  = fdopen(fds[0], "rb");
+    ASSERT_NE(out, nullptr);
+    ASSERT_NE(in, nullptr);
+
+    // two pitched planes, small enough to fit into the pipe buffer
+    std::vector<mfxU8> source(64 * 16), target(64 * 16, 0);
+    for (size_t i = 0; i < source.size(); i++)
+        source[i] = (mfxU8)(i * 3 + 1);
+    FramePlane outPlanes[] = { { source.data(), 40, 8, 64 }, { source.data() + 512, 20, 8, 64 } };
+    FramePlane inPlanes[]  = { { target.data(), 40, 8, 64 }, { target.data() + 512, 20, 8, 64 } };
+
+    EXPECT_EQ(WriteFramePlanes(out, outPlanes, 2), MFX_ERR_NONE);
+    fclose(out);
+    EXPECT_EQ(ReadFramePlanes(in, inPlanes, 2), MFX_ERR_NONE);
+    EXPECT_EQ(ReadFramePlanes(in, inPlanes, 1), MFX_ERR_MORE_DATA);
+    fclose(in);
+
+    for (auto& plane : outPlanes) {
+        size_t offset = plane.Data - source.data();
+        for (mfxU32 row = 0; row < plane.Rows; row++) {
+            const mfxU8* a = source.data() + offset + row * plane.Pitch;
+            const mfxU8* b = target.data() + offset + row * plane.Pitch;
+            ASSERT_TRUE(std::equal(a, a + plane.RowSize, b));
+        }
+    }
+}
+#endif
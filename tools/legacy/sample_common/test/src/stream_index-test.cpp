@@ -0,0 +1,411 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "stream_builder.h"
+#include "stream_index.h"
+
+using namespace StreamBuilder;
+
+namespace {
+
+// Main profile AVC stream with POC type 0 and 4 bit POC LSBs, IDR pictures start periods
+// of 10 frames coded as I P B B P B B P B B with non-reference B pictures. SPS and PPS
+// precede every IDR picture.
+struct AVCGopStream {
+    Bytes data;
+    Bytes headers; // SPS and PPS with 3-byte start codes
+    std::vector<mfxU64> offsets; // start code of the first NAL unit of every frame
+    std::vector<mfxU32> order; // presentation order of every frame
+    std::vector<Bytes> slices; // the slice of every frame with a 3-byte start code
+};
+
+AVCGopStream MakeAVCGopStream(mfxU32 periods, std::mt19937& rng) {
+    const mfxU8 spsHeader = 0x67, ppsHeader = 0x68, idrHeader = 0x65, pHeader = 0x41,
+                bHeader = 0x01;
+
+    BitWriter sps;
+    sps.PutBits(77, 8); // profile_idc
+    sps.PutBits(0, 8); // constraint flags
+    sps.PutBits(40, 8); // level_idc
+    sps.PutUE(0); // seq_parameter_set_id
+    sps.PutUE(0); // log2_max_frame_num_minus4
+    sps.PutUE(0); // pic_order_cnt_type
+    sps.PutUE(0); // log2_max_pic_order_cnt_lsb_minus4
+    sps.PutUE(2); // max_num_ref_frames
+    sps.PutBits(0, 1); // gaps_in_frame_num_value_allowed_flag
+    sps.PutUE(119); // pic_width_in_mbs_minus1
+    sps.PutUE(67); // pic_height_in_map_units_minus1
+    sps.PutBits(1, 1); // frame_mbs_only_flag
+    sps.PutBits(1, 1); // direct_8x8_inference_flag
+    sps.PutBits(0, 1); // frame_cropping_flag
+    sps.PutBits(0, 1); // vui_parameters_present_flag
+
+    BitWriter pps;
+    pps.PutUE(0); // pic_parameter_set_id
+    pps.PutUE(0); // seq_parameter_set_id
+    pps.PutBits(0, 1); // entropy_coding_mode_flag
+    pps.PutBits(0, 1); // bottom_field_pic_order_in_frame_present_flag
+    pps.PutUE(0); // num_slice_groups_minus1
+    pps.PutUE(0); // num_ref_idx_l0_default_active_minus1
+    pps.PutUE(0); // num_ref_idx_l1_default_active_minus1
+    pps.PutBits(0, 1); // weighted_pred_flag
+    pps.PutBits(0, 2); // weighted_bipred_idc
+    pps.PutSE(0); // pic_init_qp_minus26
+    pps.PutSE(0); // pic_init_qs_minus26
+    pps.PutSE(0); // chroma_qp_index_offset
+    pps.PutBits(1, 1); // deblocking_filter_control_present_flag
+    pps.PutBits(0, 1); // constrained_intra_pred_flag
+    pps.PutBits(0, 1); // redundant_pic_cnt_present_flag
+
+    AVCGopStream stream;
+    Bytes spsRbsp = sps.Finish(), ppsRbsp = pps.Finish();
+    AppendNalUnit(stream.headers, 3, spsHeader, spsRbsp);
+    AppendNalUnit(stream.headers, 3, ppsHeader, ppsRbsp);
+
+    const mfxU32 decodeOrder[] = { 0, 3, 1, 2, 6, 4, 5, 9, 7, 8 };
+    std::uniform_int_distribution<mfxU32> byte(0, 255);
+    for (mfxU32 period = 0; period < periods; period++) {
+        AppendNalUnit(stream.data, 4, spsHeader, spsRbsp);
+        AppendNalUnit(stream.data, 4, ppsHeader, ppsRbsp);
+
+        // the first frame starts with the parameter sets, the others are appended to the
+        // last frame of the previous period
+        if (!period)
+            stream.offsets.push_back(1);
+
+        mfxU32 frameNum = 0;
+        for (mfxU32 display : decodeOrder) {
+            bool idr = !display, reference = idr || display % 3 == 0;
+
+            BitWriter slice;
+            slice.PutUE(0); // first_mb_in_slice
+            slice.PutUE(idr ? 7 : reference ? 5 : 6); // slice_type, I, P or B
+            slice.PutUE(0); // pic_parameter_set_id
+            slice.PutBits(frameNum & 0xf, 4); // frame_num
+            if (idr)
+                slice.PutUE(period); // idr_pic_id
+            slice.PutBits((2 * display) & 0xf, 4); // pic_order_cnt_lsb
+            if (!reference)
+                slice.PutBits(1, 1); // direct_spatial_mv_pred_flag
+            if (!idr) {
+                slice.PutBits(0, 1); // num_ref_idx_active_override_flag
+                slice.PutBits(0, 1); // ref_pic_list_modification_flag_l0
+            }
+            if (!reference)
+                slice.PutBits(0, 1); // ref_pic_list_modification_flag_l1
+            if (idr)
+                slice.PutBits(0, 2); // no_output_of_prior_pics_flag, long_term_reference_flag
+            else if (reference)
+                slice.PutBits(0, 1); // adaptive_ref_pic_marking_mode_flag
+            slice.PutSE(0); // slice_qp_delta
+            slice.PutUE(1); // disable_deblocking_filter_idc
+            for (mfxU32 n = 1000; n; n--)
+                slice.PutBits(byte(rng), 8);
+
+            Bytes rbsp   = slice.Finish();
+            mfxU8 header = idr ? idrHeader : reference ? pHeader : bHeader;
+            if (period || display)
+                stream.offsets.push_back(stream.data.size() + 1);
+            stream.order.push_back(period * 10 + display);
+            AppendNalUnit(stream.data, 4, header, rbsp);
+            stream.slices.emplace_back();
+            AppendNalUnit(stream.slices.back(), 3, header, rbsp);
+
+            if (reference)
+                frameNum++;
+        }
+    }
+    return stream;
+}
+
+class StreamIndexTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        path      = ::testing::TempDir() + "stream_index_input.bin";
+        indexPath = CStreamIndex::GetIndexFileName(path.c_str());
+    }
+
+    void TearDown() override {
+        remove(path.c_str());
+        remove(indexPath.c_str());
+    }
+
+    static Bytes ReadFrame(CSmplBitstreamReader& reader) {
+        mfxBitstreamWrapper bs(1000);
+        mfxStatus sts = reader.ReadNextFrame(&bs);
+        while (sts == MFX_ERR_NOT_ENOUGH_BUFFER) {
+            bs.Extend(bs.MaxLength * 2);
+            sts = reader.ReadNextFrame(&bs);
+        }
+        if (sts != MFX_ERR_NONE)
+            return Bytes();
+        return Bytes(bs.Data + bs.DataOffset, bs.Data + bs.DataOffset + bs.DataLength);
+    }
+
+    static Bytes Concat(const Bytes& a, const Bytes& b) {
+        Bytes result = a;
+        result.insert(result.end(), b.begin(), b.end());
+        return result;
+    }
+
+    std::string path;
+    std::string indexPath;
+    std::mt19937 rng{ 2021 };
+};
+
+} // namespace
+
+TEST_F(StreamIndexTest, OrdersAVCFramesByPicOrderCnt) {
+    AVCGopStream stream = MakeAVCGopStream(3, rng);
+    ASSERT_TRUE(WriteStream(path.c_str(), stream.data));
+
+    CStreamIndex index;
+    ASSERT_EQ(index.Build(path.c_str(), MFX_CODEC_AVC), MFX_ERR_NONE);
+
+    const std::vector<StreamIndexEntry>& entries = index.GetEntries();
+    ASSERT_EQ(entries.size(), stream.order.size());
+    for (size_t i = 0; i < entries.size(); i++) {
+        EXPECT_EQ(entries[i].Offset, stream.offsets[i]) << "frame " << i;
+        EXPECT_EQ(entries[i].Order, stream.order[i]) << "frame " << i;
+        EXPECT_EQ(entries[i].KeyFrame, i % 10 == 0) << "frame " << i;
+    }
+
+    // the frames of the second period are decoded from its IDR picture, the parameter sets
+    // read before it are given to the reader
+    const StreamIndexEntry* key = index.FindKeyFrame(17);
+    ASSERT_NE(key, nullptr);
+    EXPECT_EQ(key, &entries[10]);
+    EXPECT_EQ(index.GetHeaders(key->Headers), stream.headers);
+    EXPECT_EQ(index.FindKeyFrame(9), &entries[0]);
+    EXPECT_EQ(index.FindKeyFrame(30), nullptr);
+
+    CH264FrameReader reader;
+    ASSERT_EQ(reader.Init(path.c_str()), MFX_ERR_NONE);
+    ASSERT_EQ(index.Seek(reader, *key), MFX_ERR_NONE);
+    EXPECT_EQ(ReadFrame(reader), Concat(stream.headers, stream.slices[10]));
+    CSmplBitstreamReader::FrameInfo info = {};
+    ASSERT_EQ(reader.GetFrameInfo(info), MFX_ERR_NONE);
+    EXPECT_EQ(info.Offset, stream.offsets[10]);
+    EXPECT_TRUE(info.KeyFrame);
+
+    // the parameter sets of the next period are in front of its IDR picture
+    for (size_t i = 11; i < 19; i++)
+        EXPECT_EQ(ReadFrame(reader), stream.slices[i]) << "frame " << i;
+    EXPECT_EQ(ReadFrame(reader), Concat(stream.slices[19], stream.headers));
+    ASSERT_EQ(reader.GetFrameInfo(info), MFX_ERR_NONE);
+    EXPECT_EQ(info.Offset, stream.offsets[19]);
+}
+
+TEST_F(StreamIndexTest, SeeksHEVCStreamToIRAPPictures) {
+    // IDR with B pictures, CRA with leading RASL pictures
+    HEVCStreamBuilder builder(rng);
+    std::vector<mfxU64> offsets;
+    auto picture = [&](mfxU32 type, mfxU32 sliceType, mfxU32 poc, bool parameterSets = false) {
+        offsets.push_back(builder.stream.data.size() + 1);
+        builder.NewFrame();
+        if (parameterSets)
+            builder.ParameterSets();
+        builder.Picture(type, sliceType, poc, 2, 500);
+    };
+    picture(HEVCStreamBuilder::IDR_W_RADL, HEVCStreamBuilder::SLICE_I, 0, true);
+    picture(HEVCStreamBuilder::TRAIL_R, HEVCStreamBuilder::SLICE_P, 4);
+    picture(HEVCStreamBuilder::TRAIL_N, HEVCStreamBuilder::SLICE_B, 2);
+    picture(HEVCStreamBuilder::TRAIL_N, HEVCStreamBuilder::SLICE_B, 1);
+    picture(HEVCStreamBuilder::TRAIL_N, HEVCStreamBuilder::SLICE_B, 3);
+    picture(HEVCStreamBuilder::CRA, HEVCStreamBuilder::SLICE_I, 8, true);
+    picture(HEVCStreamBuilder::RASL_N, HEVCStreamBuilder::SLICE_B, 6);
+    picture(HEVCStreamBuilder::RASL_N, HEVCStreamBuilder::SLICE_B, 5);
+    picture(HEVCStreamBuilder::RASL_N, HEVCStreamBuilder::SLICE_B, 7);
+    picture(HEVCStreamBuilder::TRAIL_R, HEVCStreamBuilder::SLICE_P, 10);
+    picture(HEVCStreamBuilder::TRAIL_N, HEVCStreamBuilder::SLICE_B, 9);
+    Stream& stream = builder.stream;
+    ASSERT_TRUE(WriteStream(path.c_str(), stream.data));
+
+    CStreamIndex index;
+    ASSERT_EQ(index.Build(path.c_str(), MFX_CODEC_HEVC), MFX_ERR_NONE);
+
+    const mfxU32 order[]                         = { 0, 4, 2, 1, 3, 8, 6, 5, 7, 10, 9 };
+    const std::vector<StreamIndexEntry>& entries = index.GetEntries();
+    ASSERT_EQ(entries.size(), offsets.size());
+    for (size_t i = 0; i < entries.size(); i++) {
+        EXPECT_EQ(entries[i].Offset, offsets[i]) << "frame " << i;
+        EXPECT_EQ(entries[i].Order, order[i]) << "frame " << i;
+        EXPECT_EQ(entries[i].KeyFrame, i == 0 || i == 5) << "frame " << i;
+    }
+
+    // RASL pictures can't be decoded from the CRA picture
+    EXPECT_EQ(index.FindKeyFrame(6), &entries[0]);
+    EXPECT_EQ(index.FindKeyFrame(8), &entries[5]);
+    EXPECT_EQ(index.FindKeyFrame(9), &entries[5]);
+
+    // the reader starts a coded video sequence at the CRA picture and drops its RASL pictures
+    CH265FrameReader reader;
+    ASSERT_EQ(reader.Init(path.c_str()), MFX_ERR_NONE);
+    ASSERT_EQ(index.Seek(reader, entries[5]), MFX_ERR_NONE);
+    EXPECT_EQ(ReadFrame(reader), Concat(index.GetHeaders(entries[5].Headers), stream.frames[5]));
+    EXPECT_EQ(ReadFrame(reader), stream.frames[9]);
+    EXPECT_EQ(ReadFrame(reader), stream.frames[10]);
+
+    // seeking back to the start needs no headers
+    ASSERT_EQ(index.Seek(reader, entries[0]), MFX_ERR_NONE);
+    EXPECT_TRUE(index.GetHeaders(entries[0].Headers).empty());
+    EXPECT_EQ(ReadFrame(reader), stream.frames[0]);
+}
+
+TEST_F(StreamIndexTest, FindsAV1KeyFrames) {
+    for (bool annexB : { false, true }) {
+        std::vector<mfxU32> sizes;
+        std::uniform_int_distribution<mfxU32> size(1, 20000);
+        for (int i = 0; i < 40; i++)
+            sizes.push_back(size(rng));
+        Stream stream = MakeAV1Stream(sizes, annexB, rng, 8);
+        ASSERT_TRUE(WriteStream(path.c_str(), stream.data));
+
+        CStreamIndex index;
+        ASSERT_EQ(index.Build(path.c_str(), MFX_CODEC_AV1), MFX_ERR_NONE);
+        const std::vector<StreamIndexEntry>& entries = index.GetEntries();
+        ASSERT_EQ(entries.size(), sizes.size()) << annexB;
+        for (size_t i = 0; i < entries.size(); i++) {
+            EXPECT_EQ(entries[i].Order, i) << annexB << " frame " << i;
+            EXPECT_EQ(entries[i].KeyFrame, i % 8 == 0) << annexB << " frame " << i;
+            EXPECT_TRUE(index.GetHeaders(entries[i].Headers).empty());
+        }
+
+        const StreamIndexEntry* key = index.FindKeyFrame(21);
+        ASSERT_EQ(key, &entries[16]) << annexB;
+
+        CAV1FrameReader reader;
+        ASSERT_EQ(reader.Init(path.c_str()), MFX_ERR_NONE);
+        ASSERT_EQ(index.Seek(reader, *key), MFX_ERR_NONE);
+        for (size_t i = 16; i < 20; i++)
+            EXPECT_EQ(ReadFrame(reader), stream.frames[i]) << annexB << " frame " << i;
+    }
+}
+
+TEST_F(StreamIndexTest, FindsVP9KeyFramesInIVF) {
+    std::vector<mfxU32> sizes;
+    std::uniform_int_distribution<mfxU32> size(1, 20000);
+    for (int i = 0; i < 30; i++)
+        sizes.push_back(size(rng));
+    Stream stream = MakeIVFStream(sizes, rng);
+
+    // frame_marker, profile 0, show_existing_frame 0 and frame_type of the uncompressed header
+    std::vector<mfxU64> offsets;
+    mfxU64 offset = 32;
+    for (size_t i = 0; i < sizes.size(); i++) {
+        mfxU8 header              = i % 10 ? 0x84 : 0x80;
+        stream.data[offset + 12]  = header;
+        stream.frames[i][0]       = header;
+        offsets.push_back(offset);
+        offset += 12 + sizes[i];
+    }
+    ASSERT_TRUE(WriteStream(path.c_str(), stream.data));
+
+    CStreamIndex index;
+    ASSERT_EQ(index.Build(path.c_str(), MFX_CODEC_VP9), MFX_ERR_NONE);
+    const std::vector<StreamIndexEntry>& entries = index.GetEntries();
+    ASSERT_EQ(entries.size(), sizes.size());
+    for (size_t i = 0; i < entries.size(); i++) {
+        EXPECT_EQ(entries[i].Offset, offsets[i]) << "frame " << i;
+        EXPECT_EQ(entries[i].KeyFrame, i % 10 == 0) << "frame " << i;
+    }
+
+    CIVFFrameReader reader;
+    ASSERT_EQ(reader.Init(path.c_str()), MFX_ERR_NONE);
+    ASSERT_EQ(index.Seek(reader, *index.FindKeyFrame(25)), MFX_ERR_NONE);
+    for (size_t i = 20; i < sizes.size(); i++)
+        EXPECT_EQ(ReadFrame(reader), stream.frames[i]) << "frame " << i;
+}
+
+TEST_F(StreamIndexTest, SplitsStreamIntoClosedGOPChunks) {
+    AVCGopStream stream = MakeAVCGopStream(5, rng);
+    ASSERT_TRUE(WriteStream(path.c_str(), stream.data));
+
+    CStreamIndex index;
+    ASSERT_EQ(index.Build(path.c_str(), MFX_CODEC_AVC), MFX_ERR_NONE);
+    EXPECT_EQ(index.GetChunkStarts(1), std::vector<mfxU32>({ 0 }));
+    EXPECT_EQ(index.GetChunkStarts(2), std::vector<mfxU32>({ 0, 20 }));
+    EXPECT_EQ(index.GetChunkStarts(3), std::vector<mfxU32>({ 0, 20, 30 }));
+    // there are no more chunks than IDR periods
+    EXPECT_EQ(index.GetChunkStarts(8), std::vector<mfxU32>({ 0, 10, 20, 30, 40 }));
+
+    // a CRA picture with leading pictures doesn't start a chunk
+    HEVCStreamBuilder builder(rng);
+    auto picture = [&](mfxU32 type, mfxU32 sliceType, mfxU32 poc) {
+        builder.NewFrame();
+        if (type == HEVCStreamBuilder::IDR_W_RADL)
+            builder.ParameterSets();
+        builder.Picture(type, sliceType, poc, 2, 500);
+    };
+    picture(HEVCStreamBuilder::IDR_W_RADL, HEVCStreamBuilder::SLICE_I, 0);
+    picture(HEVCStreamBuilder::TRAIL_R, HEVCStreamBuilder::SLICE_P, 2);
+    picture(HEVCStreamBuilder::TRAIL_N, HEVCStreamBuilder::SLICE_B, 1);
+    picture(HEVCStreamBuilder::CRA, HEVCStreamBuilder::SLICE_I, 4);
+    picture(HEVCStreamBuilder::RASL_N, HEVCStreamBuilder::SLICE_B, 3);
+    picture(HEVCStreamBuilder::TRAIL_R, HEVCStreamBuilder::SLICE_P, 5);
+    picture(HEVCStreamBuilder::IDR_W_RADL, HEVCStreamBuilder::SLICE_I, 0);
+    picture(HEVCStreamBuilder::TRAIL_R, HEVCStreamBuilder::SLICE_P, 1);
+    ASSERT_TRUE(WriteStream(path.c_str(), builder.stream.data));
+
+    ASSERT_EQ(index.Build(path.c_str(), MFX_CODEC_HEVC), MFX_ERR_NONE);
+    ASSERT_EQ(index.GetEntries().size(), 8u);
+    EXPECT_EQ(index.GetChunkStarts(2), std::vector<mfxU32>({ 0, 6 }));
+    EXPECT_EQ(index.GetChunkStarts(4), std::vector<mfxU32>({ 0, 6 }));
+}
+
+TEST_F(StreamIndexTest, KeepsIndexNextToStream) {
+    AVCGopStream stream = MakeAVCGopStream(2, rng);
+    ASSERT_TRUE(WriteStream(path.c_str(), stream.data));
+
+    CStreamIndex built;
+    ASSERT_EQ(built.Init(path.c_str(), MFX_CODEC_AVC), MFX_ERR_NONE);
+
+    CStreamIndex loaded;
+    ASSERT_EQ(loaded.Load(indexPath.c_str()), MFX_ERR_NONE);
+    EXPECT_EQ(loaded.GetCodecId(), (mfxU32)MFX_CODEC_AVC);
+    ASSERT_EQ(loaded.GetEntries().size(), built.GetEntries().size());
+    for (size_t i = 0; i < built.GetEntries().size(); i++) {
+        const StreamIndexEntry &a = built.GetEntries()[i], &b = loaded.GetEntries()[i];
+        EXPECT_EQ(a.Offset, b.Offset) << "frame " << i;
+        EXPECT_EQ(a.Order, b.Order) << "frame " << i;
+        EXPECT_EQ(a.Headers, b.Headers) << "frame " << i;
+        EXPECT_EQ(a.KeyFrame, b.KeyFrame) << "frame " << i;
+        EXPECT_EQ(built.GetHeaders(a.Headers), loaded.GetHeaders(b.Headers)) << "frame " << i;
+    }
+
+    // the index of another stream in the same file is rebuilt
+    stream = MakeAVCGopStream(3, rng);
+    ASSERT_TRUE(WriteStream(path.c_str(), stream.data));
+    CStreamIndex rebuilt;
+    ASSERT_EQ(rebuilt.Init(path.c_str(), MFX_CODEC_AVC), MFX_ERR_NONE);
+    EXPECT_EQ(rebuilt.GetEntries().size(), 30u);
+    ASSERT_EQ(loaded.Load(indexPath.c_str()), MFX_ERR_NONE);
+    EXPECT_EQ(loaded.GetEntries().size(), 30u);
+
+    // truncated index files are rejected
+    Bytes truncated = { 'S', 'I', 'D', 'X', 1, 5 };
+    ASSERT_TRUE(WriteStream(indexPath.c_str(), truncated));
+    EXPECT_NE(loaded.Load(indexPath.c_str()), MFX_ERR_NONE);
+    EXPECT_TRUE(loaded.GetEntries().empty());
+}
+
+TEST_F(StreamIndexTest, RejectsJPEGSeek) {
+    Stream stream = MakeMJPEGStream({ 100, 200 }, rng);
+    ASSERT_TRUE(WriteStream(path.c_str(), stream.data));
+
+    CJPEGFrameReader reader;
+    ASSERT_EQ(reader.Init(path.c_str()), MFX_ERR_NONE);
+    EXPECT_EQ(reader.Seek(0, Bytes()), MFX_ERR_UNSUPPORTED);
+    CSmplBitstreamReader::FrameInfo info = {};
+    EXPECT_EQ(reader.GetFrameInfo(info), MFX_ERR_UNSUPPORTED);
+}
@@ -0,0 +1,295 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include <gtest/gtest.h>
+
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#include "sysmem_allocator.h"
+#include "vm/numa_defs.h"
+
+namespace {
+
+mfxFrameAllocRequest MakeRequest(mfxU32 fourcc, mfxU16 width, mfxU16 height, mfxU16 numFrames) {
+    mfxFrameAllocRequest request = {};
+    request.Info.FourCC          = fourcc;
+    request.Info.ChromaFormat    = MFX_CHROMAFORMAT_YUV420;
+    request.Info.Width           = width;
+    request.Info.Height          = height;
+    request.Info.CropW           = width;
+    request.Info.CropH           = height;
+    request.Type =
+        MFX_MEMTYPE_SYSTEM_MEMORY | MFX_MEMTYPE_INTERNAL_FRAME | MFX_MEMTYPE_FROM_VPPOUT;
+    request.NumFrameSuggested = numFrames;
+    request.NumFrameMin       = numFrames;
+    return request;
+}
+
+class SysMemArenaTest : public ::testing::Test {
+protected:
+    void InitAllocator(SysMemHugePages hugePages = SYSMEM_HUGEPAGES_OFF,
+                       bool bPrefault            = false) {
+        params.bUseArena = true;
+        params.HugePages = hugePages;
+        params.bPrefault = bPrefault;
+        ASSERT_EQ(allocator.Init(&params), MFX_ERR_NONE);
+    }
+
+    mfxFrameData Lock(mfxMemId mid) {
+        mfxFrameData data = {};
+        EXPECT_EQ(allocator.LockFrame(mid, &data), MFX_ERR_NONE);
+        return data;
+    }
+
+    // Fills the luma plane of every frame with its number and checks that no frame was
+    // overwritten by the next one
+    void CheckFramesDontOverlap(const mfxFrameAllocResponse& response, mfxU32 lumaSize) {
+        for (mfxU32 i = 0; i < response.NumFrameActual; i++) {
+            mfxFrameData data = Lock(response.mids[i]);
+            memset(data.Y, (int)i + 1, lumaSize);
+            EXPECT_EQ(allocator.UnlockFrame(response.mids[i], &data), MFX_ERR_NONE);
+        }
+        for (mfxU32 i = 0; i < response.NumFrameActual; i++) {
+            mfxFrameData data = Lock(response.mids[i]);
+            EXPECT_EQ(data.Y[0], i + 1) << "frame " << i;
+            EXPECT_EQ(data.Y[lumaSize - 1], i + 1) << "frame " << i;
+            EXPECT_EQ(allocator.UnlockFrame(response.mids[i], &data), MFX_ERR_NONE);
+        }
+    }
+
+    SysMemAllocatorParams params;
+    SysMemFrameAllocator allocator;
+};
+
+} // namespace
+
+TEST_F(SysMemArenaTest, CarvesAlignedFramesOutOfOneSlab) {
+    InitAllocator();
+
+    mfxFrameAllocRequest request   = MakeRequest(MFX_FOURCC_NV12, 1920, 1088, 6);
+    mfxFrameAllocResponse response = {};
+    ASSERT_EQ(allocator.AllocFrames(&request, &response), MFX_ERR_NONE);
+    ASSERT_EQ(response.NumFrameActual, 6);
+
+    std::vector<mfxU8*> planes;
+    for (mfxU32 i = 0; i < response.NumFrameActual; i++) {
+        mfxFrameData data = Lock(response.mids[i]);
+        EXPECT_EQ((size_t)data.Y % 64, 0u) << "frame " << i;
+        EXPECT_EQ(data.UV, data.Y + 1920 * 1088) << "frame " << i;
+        EXPECT_EQ(data.Pitch, 1920) << "frame " << i;
+        planes.push_back(data.Y);
+        EXPECT_EQ(allocator.UnlockFrame(response.mids[i], &data), MFX_ERR_NONE);
+    }
+
+    // the frames follow each other with the same stride
+    mfxU32 frameSize = 1920 * 1088 * 3 / 2;
+    for (size_t i = 1; i < planes.size(); i++) {
+        EXPECT_GE(planes[i] - planes[i - 1], (ptrdiff_t)frameSize) << "frame " << i;
+        EXPECT_EQ(planes[i] - planes[i - 1], planes[1] - planes[0]) << "frame " << i;
+    }
+    CheckFramesDontOverlap(response, frameSize);
+
+    EXPECT_EQ(allocator.FreeFrames(&response), MFX_ERR_NONE);
+}
+
+TEST_F(SysMemArenaTest, MatchesLayoutOfBufferAllocations) {
+    InitAllocator();
+    SysMemFrameAllocator buffers;
+    ASSERT_EQ(buffers.Init(NULL), MFX_ERR_NONE);
+
+    for (mfxU32 fourcc : { MFX_FOURCC_NV12,
+                           MFX_FOURCC_I420,
+                           MFX_FOURCC_YV12,
+                           MFX_FOURCC_P010,
+                           MFX_FOURCC_YUY2,
+                           MFX_FOURCC_RGB4,
+                           MFX_FOURCC_Y410 }) {
+        mfxFrameAllocRequest request = MakeRequest(fourcc, 720, 480, 2);
+        mfxFrameAllocResponse arena = {}, buffer = {};
+        ASSERT_EQ(allocator.AllocFrames(&request, &arena), MFX_ERR_NONE);
+        ASSERT_EQ(buffers.AllocFrames(&request, &buffer), MFX_ERR_NONE);
+
+        mfxFrameData a = Lock(arena.mids[1]), b = {};
+        ASSERT_EQ(buffers.LockFrame(buffer.mids[1], &b), MFX_ERR_NONE);
+        EXPECT_EQ(a.PitchLow, b.PitchLow) << fourcc;
+        EXPECT_EQ(a.PitchHigh, b.PitchHigh) << fourcc;
+        EXPECT_EQ(a.U - a.Y, b.U - b.Y) << fourcc;
+        EXPECT_EQ(a.V - a.Y, b.V - b.Y) << fourcc;
+        EXPECT_EQ(allocator.UnlockFrame(arena.mids[1], &a), MFX_ERR_NONE);
+        EXPECT_EQ(buffers.UnlockFrame(buffer.mids[1], &b), MFX_ERR_NONE);
+
+        EXPECT_EQ(allocator.FreeFrames(&arena), MFX_ERR_NONE);
+        EXPECT_EQ(buffers.FreeFrames(&buffer), MFX_ERR_NONE);
+    }
+}
+
+TEST_F(SysMemArenaTest, ReallocatesInPlaceWhenFrameFits) {
+    InitAllocator();
+
+    mfxFrameAllocRequest request   = MakeRequest(MFX_FOURCC_NV12, 1920, 1088, 3);
+    mfxFrameAllocResponse response = {};
+    ASSERT_EQ(allocator.AllocFrames(&request, &response), MFX_ERR_NONE);
+
+    mfxFrameInfo info = request.Info;
+    info.Width        = 1280;
+    info.Height       = 720;
+    mfxMemId mid      = NULL;
+    ASSERT_EQ(allocator.ReallocFrame(response.mids[1], &info, request.Type, &mid), MFX_ERR_NONE);
+    EXPECT_EQ(mid, response.mids[1]);
+    mfxFrameData data = Lock(mid);
+    EXPECT_EQ(data.Pitch, 1280);
+    EXPECT_EQ(allocator.UnlockFrame(mid, &data), MFX_ERR_NONE);
+
+    // a larger frame moves out of the slab
+    mfxMemId inSlab = mid;
+    info.Width      = 3840;
+    info.Height     = 2160;
+    ASSERT_EQ(allocator.ReallocFrame(response.mids[1], &info, request.Type, &mid), MFX_ERR_NONE);
+    EXPECT_NE(mid, inSlab);
+    EXPECT_EQ(mid, response.mids[1]);
+    data = Lock(mid);
+    EXPECT_EQ(data.Pitch, 3840);
+    memset(data.Y, 0x80, 3840 * 2160 * 3 / 2);
+    EXPECT_EQ(allocator.UnlockFrame(mid, &data), MFX_ERR_NONE);
+
+    data = Lock(response.mids[2]);
+    EXPECT_EQ(data.Pitch, 1920);
+    EXPECT_EQ(allocator.UnlockFrame(response.mids[2], &data), MFX_ERR_NONE);
+
+    EXPECT_EQ(allocator.FreeFrames(&response), MFX_ERR_NONE);
+}
+
+TEST_F(SysMemArenaTest, ReallocatesWhileOtherFramesAreAllocated) {
+    InitAllocator();
+
+    mfxFrameAllocRequest request   = MakeRequest(MFX_FOURCC_NV12, 64, 16, 2);
+    mfxFrameAllocResponse response = {};
+    ASSERT_EQ(allocator.AllocFrames(&request, &response), MFX_ERR_NONE);
+
+    // the growing frame moves to new slabs while another thread allocates and frees frames,
+    // both change the slabs of the allocator
+    std::thread realloc([&]() {
+        mfxFrameInfo info = request.Info;
+        for (int i = 0; i < 1000; i++) {
+            info.Width    = (mfxU16)(64 + 64 * i);
+            mfxMemId mid  = NULL;
+            mfxStatus sts = allocator.ReallocFrame(response.mids[0], &info, request.Type, &mid);
+            ASSERT_EQ(sts, MFX_ERR_NONE);
+        }
+    });
+    for (int i = 0; i < 1000; i++) {
+        mfxFrameAllocRequest other   = MakeRequest(MFX_FOURCC_NV12, 640, 480, 2);
+        mfxFrameAllocResponse frames = {};
+        ASSERT_EQ(allocator.AllocFrames(&other, &frames), MFX_ERR_NONE);
+        ASSERT_EQ(allocator.FreeFrames(&frames), MFX_ERR_NONE);
+    }
+    realloc.join();
+
+    CheckFramesDontOverlap(response, 64 * 16);
+    EXPECT_EQ(allocator.FreeFrames(&response), MFX_ERR_NONE);
+}
+
+TEST_F(SysMemArenaTest, ReusesReleasedSlabs) {
+    InitAllocator();
+
+    mfxFrameAllocRequest request   = MakeRequest(MFX_FOURCC_NV12, 1920, 1088, 4);
+    mfxFrameAllocResponse response = {};
+    ASSERT_EQ(allocator.AllocFrames(&request, &response), MFX_ERR_NONE);
+    mfxMemId first = response.mids[0];
+    ASSERT_EQ(allocator.FreeFrames(&response), MFX_ERR_NONE);
+
+    // a smaller request fits in the released slab
+    request = MakeRequest(MFX_FOURCC_NV12, 1920, 1080, 4);
+    ASSERT_EQ(allocator.AllocFrames(&request, &response), MFX_ERR_NONE);
+    EXPECT_EQ(response.mids[0], first);
+    ASSERT_EQ(allocator.FreeFrames(&response), MFX_ERR_NONE);
+
+    // a much smaller one gets a slab of its own
+    request = MakeRequest(MFX_FOURCC_NV12, 640, 480, 4);
+    ASSERT_EQ(allocator.AllocFrames(&request, &response), MFX_ERR_NONE);
+    EXPECT_NE(response.mids[0], first);
+    CheckFramesDontOverlap(response, 640 * 480);
+    ASSERT_EQ(allocator.FreeFrames(&response), MFX_ERR_NONE);
+}
+
+TEST_F(SysMemArenaTest, UnmapsReleasedSlabsThatDontFit) {
+    // exposes the size of the mapped slabs
+    class SlabAllocator : public SysMemFrameAllocator {
+    public:
+        size_t MappedSize() const {
+            size_t size = 0;
+            for (const Slab& slab : m_slabs)
+                size += slab.size;
+            return size;
+        }
+    } slabAllocator;
+    params.bUseArena = true;
+    ASSERT_EQ(slabAllocator.Init(&params), MFX_ERR_NONE);
+
+    // the sizes alternate between requests that don't fit in each other's slabs, only the
+    // slab in use stays mapped
+    mfxFrameAllocResponse response = {};
+    size_t largeSlab                = 0;
+    for (int i = 0; i < 10; i++) {
+        mfxFrameAllocRequest request = (i % 2) ? MakeRequest(MFX_FOURCC_NV12, 640, 480, 4)
+                                               : MakeRequest(MFX_FOURCC_NV12, 1920, 1088, 4);
+        ASSERT_EQ(slabAllocator.AllocFrames(&request, &response), MFX_ERR_NONE);
+        if (!i)
+            largeSlab = slabAllocator.MappedSize();
+        EXPECT_LE(slabAllocator.MappedSize(), largeSlab) << "request " << i;
+        ASSERT_EQ(slabAllocator.FreeFrames(&response), MFX_ERR_NONE);
+    }
+}
+
+TEST_F(SysMemArenaTest, FallsBackFromHugePages) {
+    // the system may have no huge pages reserved or transparent huge pages disabled
+    for (SysMemHugePages hugePages : { SYSMEM_HUGEPAGES_THP, SYSMEM_HUGEPAGES_HUGETLB }) {
+        SysMemFrameAllocator allocator;
+        params.bUseArena = true;
+        params.HugePages = hugePages;
+        params.bPrefault = true;
+        ASSERT_EQ(allocator.Init(&params), MFX_ERR_NONE);
+
+        mfxFrameAllocRequest request   = MakeRequest(MFX_FOURCC_NV12, 3840, 2160, 3);
+        mfxFrameAllocResponse response = {};
+        ASSERT_EQ(allocator.AllocFrames(&request, &response), MFX_ERR_NONE) << hugePages;
+
+        for (mfxU32 i = 0; i < response.NumFrameActual; i++) {
+            mfxFrameData data = {};
+            ASSERT_EQ(allocator.LockFrame(response.mids[i], &data), MFX_ERR_NONE);
+            EXPECT_EQ((size_t)data.Y % 64, 0u) << hugePages;
+            memset(data.Y, 0x10, 3840 * 2160 * 3 / 2);
+            EXPECT_EQ(allocator.UnlockFrame(response.mids[i], &data), MFX_ERR_NONE);
+        }
+        EXPECT_EQ(allocator.FreeFrames(&response), MFX_ERR_NONE);
+    }
+}
+
+TEST_F(SysMemArenaTest, PlacesSlabsOnNumaNode) {
+    params.NumaNode = 0;
+    ASSERT_EQ(allocator.Init(&params), MFX_ERR_NONE);
+
+    mfxFrameAllocRequest request   = MakeRequest(MFX_FOURCC_NV12, 1920, 1088, 2);
+    mfxFrameAllocResponse response = {};
+    ASSERT_EQ(allocator.AllocFrames(&request, &response), MFX_ERR_NONE);
+
+    mfxU32 frameSize  = 1920 * 1088 * 3 / 2;
+    mfxFrameData data = Lock(response.mids[0]);
+    memset(data.Y, 0x80, frameSize);
+
+    std::vector<mfxU64> bytesPerNode;
+    mfxStatus sts = msdk_numa_get_memory_nodes(data.Y, frameSize, bytesPerNode);
+    EXPECT_EQ(allocator.UnlockFrame(response.mids[0], &data), MFX_ERR_NONE);
+    if (sts != MFX_ERR_UNSUPPORTED) {
+        ASSERT_EQ(sts, MFX_ERR_NONE);
+        ASSERT_FALSE(bytesPerNode.empty());
+        EXPECT_GE(bytesPerNode[0], frameSize);
+    }
+
+    EXPECT_EQ(allocator.FreeFrames(&response), MFX_ERR_NONE);
+}
@@ -0,0 +1,282 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "task_scheduler.h"
+
+namespace {
+
+// Collects the completions until all tasks are reported
+std::map<mfxU32, mfxStatus> WaitForAll(CTaskScheduler& scheduler) {
+    std::map<mfxU32, mfxStatus> results;
+    mfxU32 id        = 0;
+    mfxStatus result = MFX_ERR_NONE;
+    for (;;) {
+        mfxStatus sts = scheduler.WaitForCompletion(10000, &id, &result);
+        if (MFX_ERR_NONE != sts) {
+            EXPECT_EQ(sts, MFX_ERR_NOT_FOUND);
+            return results;
+        }
+        EXPECT_EQ(results.count(id), 0u) << "task " << id << " is reported twice";
+        results[id] = result;
+    }
+}
+
+} // namespace
+
+TEST(TaskScheduler, RejectsTasksBeforeStart) {
+    CTaskScheduler scheduler;
+    EXPECT_EQ(scheduler.Submit(0,
+                               []() {
+                                   return MFX_ERR_NONE;
+                               }),
+              MFX_ERR_NOT_INITIALIZED);
+
+    ASSERT_EQ(scheduler.Start(2), MFX_ERR_NONE);
+    EXPECT_EQ(scheduler.Start(2), MFX_ERR_UNDEFINED_BEHAVIOR);
+    EXPECT_EQ(scheduler.Submit(0, CTaskScheduler::Task()), MFX_ERR_NULL_PTR);
+    EXPECT_EQ(scheduler.GetNumWorkers(), 2u);
+
+    mfxU32 id        = 0;
+    mfxStatus result = MFX_ERR_NONE;
+    EXPECT_EQ(scheduler.WaitForCompletion(0, &id, &result), MFX_ERR_NOT_FOUND);
+}
+
+TEST(TaskScheduler, RunsTasksStepByStepToCompletion) {
+    const mfxU32 numTasks = 16;
+    std::vector<std::atomic<mfxU32>> steps(numTasks);
+
+    CTaskScheduler scheduler;
+    ASSERT_EQ(scheduler.Start(4), MFX_ERR_NONE);
+    for (mfxU32 i = 0; i < numTasks; i++) {
+        steps[i] = 0;
+        ASSERT_EQ(scheduler.Submit(i,
+                                   [&steps, i]() {
+                                       if (++steps[i] < 10 + i)
+                                           return MFX_TASK_WORKING;
+                                       return i % 2 ? MFX_ERR_ABORTED : MFX_ERR_NONE;
+                                   }),
+                  MFX_ERR_NONE);
+    }
+
+    std::map<mfxU32, mfxStatus> results = WaitForAll(scheduler);
+    ASSERT_EQ(results.size(), numTasks);
+    for (mfxU32 i = 0; i < numTasks; i++) {
+        EXPECT_EQ(steps[i], 10 + i) << "task " << i;
+        EXPECT_EQ(results[i], i % 2 ? MFX_ERR_ABORTED : MFX_ERR_NONE) << "task " << i;
+    }
+
+    CTaskScheduler::Statistics stat = scheduler.GetStatistics();
+    EXPECT_EQ(stat.steps, (mfxU64)numTasks * 10 + numTasks * (numTasks - 1) / 2);
+    EXPECT_EQ(stat.turns, stat.steps);
+}
+
+TEST(TaskScheduler, SharesWorkerInProportionToWeights) {
+    std::atomic<bool> go(false);
+    std::vector<mfxU32> trace;
+
+    // the tasks don't record steps until both are queued
+    auto MakeTask = [&go, &trace](mfxU32 id, mfxU32 numSteps) {
+        return [&go, &trace, id, numSteps]() {
+            if (!go) {
+                std::this_thread::yield();
+                return MFX_TASK_WORKING;
+            }
+            trace.push_back(id);
+            size_t done = 0;
+            for (mfxU32 step : trace)
+                done += step == id;
+            return done < numSteps ? MFX_TASK_WORKING : MFX_ERR_NONE;
+        };
+    };
+
+    CTaskScheduler scheduler;
+    ASSERT_EQ(scheduler.Start(1), MFX_ERR_NONE);
+    ASSERT_EQ(scheduler.Submit(0, MakeTask(0, 30), 3), MFX_ERR_NONE);
+    ASSERT_EQ(scheduler.Submit(1, MakeTask(1, 10), 1), MFX_ERR_NONE);
+    go = true;
+    EXPECT_EQ(WaitForAll(scheduler).size(), 2u);
+
+    // the heavier task does three steps for every step of the other one
+    ASSERT_EQ(trace.size(), 40u);
+    mfxU32 heavySteps = 0, lightSteps = 0;
+    for (size_t i = 0; i < trace.size() && lightSteps < 5; i++) {
+        heavySteps += trace[i] == 0;
+        lightSteps += trace[i] == 1;
+    }
+    EXPECT_NEAR(heavySteps, 15, 3);
+}
+
+TEST(TaskScheduler, ReportsFailureWithoutWaitingForOtherTasks) {
+    std::atomic<bool> stop(false);
+
+    CTaskScheduler scheduler;
+    ASSERT_EQ(scheduler.Start(2), MFX_ERR_NONE);
+    for (mfxU32 i = 0; i < 4; i++) {
+        ASSERT_EQ(scheduler.Submit(i,
+                                   [&stop]() {
+                                       std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                                       return stop ? MFX_ERR_NONE : MFX_TASK_WORKING;
+                                   }),
+                  MFX_ERR_NONE);
+    }
+    ASSERT_EQ(scheduler.Submit(4,
+                               []() {
+                                   return MFX_ERR_DEVICE_FAILED;
+                               }),
+              MFX_ERR_NONE);
+
+    mfxU32 id        = 0;
+    mfxStatus result = MFX_ERR_NONE;
+    auto start       = std::chrono::steady_clock::now();
+    ASSERT_EQ(scheduler.WaitForCompletion(10000, &id, &result), MFX_ERR_NONE);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+    EXPECT_EQ(id, 4u);
+    EXPECT_EQ(result, MFX_ERR_DEVICE_FAILED);
+
+    EXPECT_EQ(scheduler.WaitForCompletion(10, &id, &result), MFX_TASK_WORKING);
+    stop = true;
+    EXPECT_EQ(WaitForAll(scheduler).size(), 4u);
+}
+
+TEST(TaskScheduler, IdleWorkerStealsTasks) {
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+
+    CTaskScheduler scheduler;
+    ASSERT_EQ(scheduler.Start(2), MFX_ERR_NONE);
+    // the tasks are queued to the workers in turn, the second worker gets the short ones and
+    // takes over a long one after them
+    for (mfxU32 i = 0; i < 4; i++) {
+        bool isLong  = !(i % 2);
+        mfxU32 steps = 0;
+
+        CTaskScheduler::Task task = [&mutex, &threads, isLong, steps]() mutable {
+            if (!isLong)
+                return MFX_ERR_NONE;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                threads.insert(std::this_thread::get_id());
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            return ++steps < 100 ? MFX_TASK_WORKING : MFX_ERR_NONE;
+        };
+        ASSERT_EQ(scheduler.Submit(i, task), MFX_ERR_NONE);
+    }
+
+    EXPECT_EQ(WaitForAll(scheduler).size(), 4u);
+    EXPECT_GE(scheduler.GetStatistics().steals, 1u);
+    EXPECT_EQ(threads.size(), 2u);
+}
+
+TEST(TaskScheduler, RunsDedicatedTasksConcurrently) {
+    std::atomic<mfxU32> arrived(0);
+
+    // the tasks wait for each other inside one step, so they can't share a worker
+    CTaskScheduler scheduler;
+    ASSERT_EQ(scheduler.Start(1), MFX_ERR_NONE);
+    for (mfxU32 i = 0; i < 2; i++) {
+        ASSERT_EQ(scheduler.SubmitDedicated(i,
+                                            [&arrived]() {
+                                                arrived++;
+                                                while (arrived < 2)
+                                                    std::this_thread::yield();
+                                                return MFX_ERR_NONE;
+                                            }),
+                  MFX_ERR_NONE);
+    }
+    ASSERT_EQ(scheduler.Submit(2,
+                               []() {
+                                   return MFX_WRN_VALUE_NOT_CHANGED;
+                               }),
+              MFX_ERR_NONE);
+
+    std::map<mfxU32, mfxStatus> results = WaitForAll(scheduler);
+    ASSERT_EQ(results.size(), 3u);
+    EXPECT_EQ(results[0], MFX_ERR_NONE);
+    EXPECT_EQ(results[1], MFX_ERR_NONE);
+    EXPECT_EQ(results[2], MFX_WRN_VALUE_NOT_CHANGED);
+    scheduler.Stop();
+    EXPECT_FALSE(scheduler.IsStarted());
+}
+
+TEST(TaskScheduler, RunsOtherTasksWhileTaskIsDeferred) {
+    typedef CTaskScheduler::Clock Clock;
+    const mfxU32 numSteps = 5;
+    const auto interval   = std::chrono::milliseconds(20);
+    std::vector<Clock::time_point> stepTimes;
+    std::atomic<bool> bDeferredDone(false);
+    std::atomic<mfxU32> otherSteps(0);
+
+    // the task paced by its deadlines leaves the only worker to the other one meanwhile
+    CTaskScheduler scheduler;
+    ASSERT_EQ(scheduler.Start(1), MFX_ERR_NONE);
+    ASSERT_EQ(scheduler.SubmitDeferrable(0,
+                                         [&](Clock::time_point& resumeAt) {
+                                             stepTimes.push_back(Clock::now());
+                                             if (stepTimes.size() == numSteps) {
+                                                 bDeferredDone = true;
+                                                 return MFX_ERR_NONE;
+                                             }
+                                             resumeAt = stepTimes.back() + interval;
+                                             return MFX_TASK_WORKING;
+                                         },
+                                         4),
+              MFX_ERR_NONE);
+    ASSERT_EQ(scheduler.Submit(1,
+                               [&]() {
+                                   otherSteps++;
+                                   std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                                   return bDeferredDone ? MFX_ERR_NONE : MFX_TASK_WORKING;
+                               }),
+              MFX_ERR_NONE);
+
+    std::map<mfxU32, mfxStatus> results = WaitForAll(scheduler);
+    ASSERT_EQ(results.size(), 2u);
+    EXPECT_EQ(results[0], MFX_ERR_NONE);
+    EXPECT_EQ(results[1], MFX_ERR_NONE);
+    ASSERT_EQ(stepTimes.size(), numSteps);
+    for (mfxU32 i = 1; i < numSteps; i++)
+        EXPECT_GE(stepTimes[i] - stepTimes[i - 1], interval) << "step " << i;
+    EXPECT_GT(otherSteps, numSteps);
+    EXPECT_EQ(scheduler.GetStatistics().deferrals, numSteps - 1);
+}
+
+TEST(TaskScheduler, IdleWorkerWakesUpForDeferredTask) {
+    typedef CTaskScheduler::Clock Clock;
+    Clock::time_point resumeAt;
+    Clock::time_point resumedAt;
+
+    CTaskScheduler scheduler;
+    ASSERT_EQ(scheduler.Start(2), MFX_ERR_NONE);
+    ASSERT_EQ(scheduler.SubmitDeferrable(0,
+                                         [&](Clock::time_point& next) {
+                                             if (resumeAt == Clock::time_point()) {
+                                                 resumeAt = Clock::now() +
+                                                            std::chrono::milliseconds(30);
+                                                 next = resumeAt;
+                                                 return MFX_TASK_WORKING;
+                                             }
+                                             resumedAt = Clock::now();
+                                             return MFX_ERR_NONE;
+                                         }),
+              MFX_ERR_NONE);
+
+    std::map<mfxU32, mfxStatus> results = WaitForAll(scheduler);
+    ASSERT_EQ(results.size(), 1u);
+    EXPECT_EQ(results[0], MFX_ERR_NONE);
+    EXPECT_GE(resumedAt, resumeAt);
+    EXPECT_LT(resumedAt - resumeAt, std::chrono::seconds(1));
+}
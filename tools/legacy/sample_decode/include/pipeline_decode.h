@@ -86,6 +86,7 @@ struct sInputParams {
     mfxU32 fourcc;
     mfxU16 chromaType;
     mfxU32 nFrames;
+    mfxU32 nSeekFrame; // presentation order of the first frame, snapped to its key frame
     mfxU16 eDeinterlace;
     mfxU16 ScalingMode;
     bool outI420;
@@ -18,6 +18,7 @@
 #include <ctime>
 #include <thread>
 #include "pipeline_decode.h"
+#include "stream_index.h"
 #include "sysmem_allocator.h"
 
 #if defined(_WIN32) || defined(_WIN64)
@@ -142,6 +143,11 @@ mfxStatus CDecodingPipeline::Init(sInputParams* pParams) {
                 m_bIsCompleteFrame = true;
                 m_bPrintLatency    = pParams->bCalLat;
                 break;
+            case MFX_CODEC_HEVC:
+                m_FileReader.reset(new CH265FrameReader());
+                m_bIsCompleteFrame = true;
+                m_bPrintLatency    = pParams->bCalLat;
+                break;
             case MFX_CODEC_JPEG:
                 m_FileReader.reset(new CJPEGFrameReader());
                 m_bIsCompleteFrame = true;
@@ -155,7 +161,7 @@ mfxStatus CDecodingPipeline::Init(sInputParams* pParams) {
                 m_bPrintLatency    = pParams->bCalLat;
                 break;
             default:
-                return MFX_ERR_UNSUPPORTED; // latency mode is supported only for H.264 and JPEG codecs
+                return MFX_ERR_UNSUPPORTED; // latency mode is supported only for H.264, H.265, JPEG and IVF streams
         }
     }
     else {
@@ -223,11 +229,33 @@ mfxStatus CDecodingPipeline::Init(sInputParams* pParams) {
     totalBytesProcessed = 0;
     sts                 = m_FileReader->Init(pParams->strSrcFile);
     if (sts == MFX_ERR_UNSUPPORTED && pParams->videoType == MFX_CODEC_AV1) {
-        m_FileReader.reset(new CSmplBitstreamReader());
-        msdk_printf(MSDK_STRING("WARNING: Stream is not IVF, default reader\n"));
+        // AV1 streams without a container are read by temporal units
+        m_FileReader.reset(new CAV1FrameReader());
+        m_bIsCompleteFrame = true;
+        msdk_printf(MSDK_STRING("WARNING: Stream is not IVF, reading AV1 temporal units\n"));
+        sts = m_FileReader->Init(pParams->strSrcFile);
     }
     MSDK_CHECK_STATUS(sts, "m_FileReader->Init failed");
 
+    // the stream index is built by the first run and kept next to the input file
+    if (pParams->nSeekFrame) {
+        CStreamIndex index;
+        sts = index.Init(pParams->strSrcFile, pParams->videoType);
+        MSDK_CHECK_STATUS(sts, "CStreamIndex::Init failed");
+
+        const StreamIndexEntry* keyFrame = index.FindKeyFrame(pParams->nSeekFrame);
+        if (!keyFrame) {
+            msdk_printf(MSDK_STRING("ERROR: the stream has %u frames\n"),
+                        (mfxU32)index.GetEntries().size());
+            return MFX_ERR_NOT_FOUND;
+        }
+        sts = index.Seek(*m_FileReader, *keyFrame);
+        MSDK_CHECK_STATUS(sts, "CStreamIndex::Seek failed");
+        msdk_printf(MSDK_STRING("Seeking to key frame %u for frame %u\n"),
+                    keyFrame->Order,
+                    pParams->nSeekFrame);
+    }
+
     mfxInitParamlWrap initPar;
     auto threadsPar = initPar.AddExtBuffer<mfxExtThreadsParam>();
     MSDK_CHECK_POINTER(threadsPar, MFX_ERR_MEMORY_ALLOC);
@@ -606,9 +634,10 @@ mfxStatus CDecodingPipeline::InitMfxParams(sInputParams* pParams) {
             if (m_mfxBS.MaxLength == m_mfxBS.DataLength) {
                 m_mfxBS.Extend(m_mfxBS.MaxLength * 2);
             }
-            // read a portion of data
-            totalBytesProcessed += m_mfxBS.DataOffset;
-            sts = m_FileReader->ReadNextFrame(&m_mfxBS);
+            // read a portion of data, the reader moves the data only when the buffer tail is short
+            mfxU32 dataOffset = m_mfxBS.DataOffset;
+            sts               = m_FileReader->ReadNextFrame(&m_mfxBS);
+            totalBytesProcessed += dataOffset - m_mfxBS.DataOffset;
             MSDK_CHECK_STATUS(sts, "m_FileReader->ReadNextFrame failed");
 
             continue;
@@ -1285,8 +1314,10 @@ mfxStatus CDecodingPipeline::CreateAllocator() {
 void CDecodingPipeline::DeleteFrames() {
     FreeBuffers();
 
-    m_pCurrentFreeSurface = NULL;
-    MSDK_SAFE_FREE(m_pCurrentFreeOutputSurface);
+    // the output surfaces are elements of the array freed by FreeBuffers
+    m_pCurrentFreeSurface       = NULL;
+    m_pCurrentFreeOutputSurface = NULL;
+    m_pCurrentOutputSurface     = NULL;
 
     m_pCurrentFreeVppSurface = NULL;
 
@@ -1590,6 +1621,11 @@ mfxStatus CDecodingPipeline::RunDecoding() {
             ((MFX_ERR_MORE_DATA == sts) || (m_bIsCompleteFrame && !pBitstream->DataLength))) {
             CAutoTimer timer_fread(m_tick_fread);
             sts = m_FileReader->ReadNextFrame(pBitstream); // read more data to input bit stream
+            // frame readers keep a frame which doesn't fit until the bitstream is extended
+            while (MFX_ERR_NOT_ENOUGH_BUFFER == sts) {
+                m_mfxBS.Extend(m_mfxBS.MaxLength * 2);
+                sts = m_FileReader->ReadNextFrame(pBitstream);
+            }
 
             if (MFX_ERR_MORE_DATA == sts) {
                 sts = MFX_ERR_NONE;
@@ -148,15 +148,19 @@ void PrintHelp(msdk_char* strAppName, const msdk_char* strErrorMessage) {
         MSDK_STRING("   [-window x y w h]         - set render window position and size\n"));
 #endif
     msdk_printf(MSDK_STRING(
-        "   [-low_latency]            - configures decoder for low latency mode (supported only for H.264 and JPEG codec)\n"));
+        "   [-low_latency]            - configures decoder for low latency mode (supported only for H.264, H.265 and JPEG codec)\n"));
     msdk_printf(MSDK_STRING(
-        "   [-calc_latency]           - calculates latency during decoding and prints log (supported only for H.264 and JPEG codec)\n"));
+        "   [-calc_latency]           - calculates latency during decoding and prints log (supported only for H.264, H.265 and JPEG codec)\n"));
     msdk_printf(MSDK_STRING(
         "   [-async]                  - depth of asynchronous pipeline. default value is 4. must be between 1 and 20\n"));
     msdk_printf(MSDK_STRING("   [-gpucopy::<on,off>] Enable or disable GPU copy mode\n"));
     msdk_printf(MSDK_STRING(
         "   [-robust:soft]            - GPU hang recovery by inserting an IDR frame\n"));
     msdk_printf(MSDK_STRING("   [-timeout]                - timeout in seconds\n"));
+    msdk_printf(MSDK_STRING(
+        "   [-seek|-ss frame]         - start decoding at the key frame preceding the frame, the stream index\n"));
+    msdk_printf(MSDK_STRING(
+        "                               is kept in <input>.idx (H.264, H.265, AV1 and IVF streams)\n"));
     msdk_printf(
         MSDK_STRING("   [-dec_postproc force/auto] - resize after decoder using direct pipe\n"));
     msdk_printf(
@@ -349,7 +353,7 @@ mfxStatus ParseInputString(msdk_char* strInput[], mfxU8 nArgNum, sInputParams* p
                 default: {
                     PrintHelp(strInput[0],
                               MSDK_STRING(
-                                  "-low_latency mode is suppoted only for H.264 and JPEG codecs"));
+                                  "-low_latency mode is suppoted only for H.264, H.265 and JPEG codecs"));
                     return MFX_ERR_UNSUPPORTED;
                 }
             }
@@ -383,7 +387,7 @@ mfxStatus ParseInputString(msdk_char* strInput[], mfxU8 nArgNum, sInputParams* p
                 default: {
                     PrintHelp(strInput[0],
                               MSDK_STRING(
-                                  "-calc_latency mode is suppoted only for H.264 and JPEG codecs"));
+                                  "-calc_latency mode is suppoted only for H.264, H.265 and JPEG codecs"));
                     return MFX_ERR_UNSUPPORTED;
                 }
             }
@@ -673,6 +677,17 @@ mfxStatus ParseInputString(msdk_char* strInput[], mfxU8 nArgNum, sInputParams* p
                 return MFX_ERR_UNSUPPORTED;
             }
         }
+        else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-seek")) ||
+                 0 == msdk_strcmp(strInput[i], MSDK_STRING("-ss"))) {
+            if (i + 1 >= nArgNum) {
+                PrintHelp(strInput[0], MSDK_STRING("Not enough parameters for -seek key"));
+                return MFX_ERR_UNSUPPORTED;
+            }
+            if (MFX_ERR_NONE != msdk_opt_read(strInput[++i], pParams->nSeekFrame)) {
+                PrintHelp(strInput[0], MSDK_STRING("seek frame is invalid"));
+                return MFX_ERR_UNSUPPORTED;
+            }
+        }
         else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-jpeg_rgb"))) {
             if (MFX_CODEC_JPEG == pParams->videoType) {
                 pParams->chromaType = MFX_JPEG_COLORFORMAT_RGB;
@@ -15,6 +15,7 @@
 #endif
 
 #include "base_allocator.h"
+#include "frame_prefetcher.h"
 #include "sample_utils.h"
 #include "time_statistics.h"
 
@@ -179,6 +180,10 @@ struct sInputParams {
 
     mfxU32 nTimeout;
     mfxU16 nPerfOpt; // size of pre-load buffer which used for loop encode
+    mfxU32 nPrefetchDepth; // number of input frames read ahead on a separate thread
+    bool bDirectIO; // read input frames bypassing the page cache
+    bool bAsyncWrite; // write output files on a separate thread
+    AsyncWriteSync AsyncWriteSyncMode;
     mfxU16 nMaxFPS; // limits overall fps
 
     mfxU32 nSyncOpTimeout; // SyncOperation timeout in msec
@@ -269,6 +274,8 @@ struct sTask {
     mfxEncodeCtrlWrap encCtrl;
     bool bUseHWLib;
     mfxSyncPoint EncSyncP;
+    // EncSyncP is done, the bitstream waits for the tasks before it to be written
+    bool bCompleted;
     std::list<mfxSyncPoint> DependentVppTasks;
     void* pWriter;
     mfxU32 codecID;
@@ -303,8 +310,15 @@ public:
     }
     virtual void Close();
     virtual void SetGpuHangRecoveryFlag();
+    // with partial output the bitstream blocks are taken by SynchronizeFirstTask only
+    virtual void SetPartialOutputFlag();
     virtual void ClearTasks();
 
+    // number of tasks completed while a task submitted before them was still in execution
+    mfxU32 GetOutOfOrderTasks() const {
+        return m_nOutOfOrderTasks;
+    }
+
     msdk_tick firstOut_total;
     msdk_tick firstOut_start;
     msdk_tick lastOut_total;
@@ -314,14 +328,20 @@ protected:
     sTask* m_pTasks;
     mfxU32 m_nPoolSize;
     mfxU32 m_nTaskBufferStart;
+    // the pool has twice as many tasks as the encoder may have in execution, the rest keep
+    // the bitstreams of the tasks completed out of order
+    mfxU32 m_nMaxInExecution;
+    mfxU32 m_nOutOfOrderTasks;
 
     bool m_bGpuHangRecovery;
+    bool m_bPartialOutput;
 
     MFXVideoSession* m_pmfxSession;
 
     CTimeStatistics m_statOverall;
     CTimeStatistics m_statFile;
     virtual mfxU32 GetFreeTaskIndex();
+    virtual void PollTasks();
 };
 
 /* This class implements a pipeline with 2 mfx components: vpp (video preprocessing) and encode */
@@ -357,7 +377,7 @@ public:
 
 protected:
     std::pair<CSmplBitstreamWriter*, CSmplBitstreamWriter*> m_FileWriters;
-    CSmplYUVReader m_FileReader;
+    CPrefetchYUVReader m_FileReader;
     CEncTaskPool m_TaskPool;
     QPFile::Reader m_QPFileReader;
 
@@ -419,6 +439,9 @@ protected:
     bool m_bSingleTexture;
     bool m_bPartialOutput;
 
+    bool m_bAsyncWrite;
+    AsyncWriteParams m_asyncWriteParams;
+
     CTimeStatisticsReal m_statOverall;
     CTimeStatisticsReal m_statFile;
 
@@ -429,6 +452,7 @@ protected:
 
     virtual mfxStatus InitFileWriters(sInputParams* pParams);
     virtual void FreeFileWriters();
+    virtual mfxStatus FlushFileWriters();
     virtual mfxStatus InitFileWriter(CSmplBitstreamWriter** ppWriter, const msdk_char* filename);
     virtual mfxStatus InitFileWriter(CSmplBitstreamWriter** ppWriter,
                                      const msdk_char* filename,
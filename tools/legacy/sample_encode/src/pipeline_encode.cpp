@@ -83,7 +83,10 @@ CEncTaskPool::CEncTaskPool()
     m_pmfxSession      = NULL;
     m_nTaskBufferStart = 0;
     m_nPoolSize        = 0;
+    m_nMaxInExecution  = 0;
+    m_nOutOfOrderTasks = 0;
     m_bGpuHangRecovery = false;
+    m_bPartialOutput   = false;
 }
 
 CEncTaskPool::~CEncTaskPool() {
@@ -95,6 +98,7 @@ sTask::sTask()
           encCtrl(),
           bUseHWLib(),
           EncSyncP(0),
+          bCompleted(false),
           DependentVppTasks(),
           pWriter(NULL),
           codecID(0) {}
@@ -115,8 +119,10 @@ mfxStatus CEncTaskPool::Init(MFXVideoSession* pmfxSession,
     if (pOtherWriter && (0 != nPoolSize % 2))
         return MFX_ERR_UNDEFINED_BEHAVIOR;
 
-    m_pmfxSession = pmfxSession;
-    m_nPoolSize   = nPoolSize;
+    m_pmfxSession      = pmfxSession;
+    m_nPoolSize        = nPoolSize * 2;
+    m_nMaxInExecution  = nPoolSize;
+    m_nOutOfOrderTasks = 0;
 
     m_pTasks = new sTask[m_nPoolSize];
     MSDK_CHECK_POINTER(m_pTasks, MFX_ERR_MEMORY_ALLOC);
@@ -153,8 +159,10 @@ mfxStatus CEncTaskPool::SynchronizeFirstTask(mfxU32 syncOpTimeout) {
     if (NULL != m_pTasks[m_nTaskBufferStart].EncSyncP) {
         int iteration = 0;
         do {
-            sts =
-                m_pmfxSession->SyncOperation(m_pTasks[m_nTaskBufferStart].EncSyncP, syncOpTimeout);
+            sts = m_pTasks[m_nTaskBufferStart].bCompleted
+                      ? MFX_ERR_NONE
+                      : m_pmfxSession->SyncOperation(m_pTasks[m_nTaskBufferStart].EncSyncP,
+                                                     syncOpTimeout);
 
             msdk_tick stop = time_get_tick();
 
@@ -237,17 +245,22 @@ mfxStatus CEncTaskPool::SynchronizeFirstTask(mfxU32 syncOpTimeout) {
 }
 
 mfxU32 CEncTaskPool::GetFreeTaskIndex() {
-    mfxU32 off = 0;
+    mfxU32 off            = 0;
+    mfxU32 numInExecution = 0;
 
     if (m_pTasks) {
         for (off = 0; off < m_nPoolSize; off++) {
-            if (NULL == m_pTasks[(m_nTaskBufferStart + off) % m_nPoolSize].EncSyncP) {
+            sTask& task = m_pTasks[(m_nTaskBufferStart + off) % m_nPoolSize];
+            if (NULL == task.EncSyncP) {
                 break;
             }
+            if (!task.bCompleted)
+                numInExecution++;
         }
     }
 
-    if (off >= m_nPoolSize)
+    // the completed tasks waiting to be written don't hold the encoder back
+    if (off >= m_nPoolSize || numInExecution >= m_nMaxInExecution)
         return m_nPoolSize;
 
     return (m_nTaskBufferStart + off) % m_nPoolSize;
@@ -259,6 +272,12 @@ mfxStatus CEncTaskPool::GetFreeTask(sTask** ppTask) {
 
     mfxU32 index = GetFreeTaskIndex();
 
+    if (index >= m_nPoolSize) {
+        // a task may have completed before the first one and let a new one in
+        PollTasks();
+        index = GetFreeTaskIndex();
+    }
+
     if (index >= m_nPoolSize) {
         return MFX_ERR_NOT_FOUND;
     }
@@ -269,6 +288,38 @@ mfxStatus CEncTaskPool::GetFreeTask(sTask** ppTask) {
     return MFX_ERR_NONE;
 }
 
+// Marks the tasks in execution which are completed without waiting for them. The bitstreams
+// are written by SynchronizeFirstTask in the order of the tasks, it also handles the errors
+// and the partial output, so the tasks returning anything but MFX_ERR_NONE are left to it.
+void CEncTaskPool::PollTasks() {
+    // a synchronization returns the next block of the partial output, the blocks of the tasks
+    // after the first one would be lost
+    if (m_bPartialOutput)
+        return;
+
+    bool bPreviousInExecution = false;
+
+    for (mfxU32 off = 0; off < m_nPoolSize; off++) {
+        sTask& task = m_pTasks[(m_nTaskBufferStart + off) % m_nPoolSize];
+        if (NULL == task.EncSyncP) {
+            break;
+        }
+        if (task.bCompleted)
+            continue;
+
+        if (MFX_ERR_NONE != m_pmfxSession->SyncOperation(task.EncSyncP, 0)) {
+            bPreviousInExecution = true;
+            continue;
+        }
+
+        // the VPP tasks the encoding depends on are completed as well
+        task.bCompleted = true;
+        task.DependentVppTasks.clear();
+        if (bPreviousInExecution)
+            m_nOutOfOrderTasks++;
+    }
+}
+
 void CEncTaskPool::Close() {
     if (m_pTasks) {
         for (mfxU32 i = 0; i < m_nPoolSize; i++) {
@@ -281,12 +332,18 @@ void CEncTaskPool::Close() {
     m_pmfxSession      = NULL;
     m_nTaskBufferStart = 0;
     m_nPoolSize        = 0;
+    m_nMaxInExecution  = 0;
+    m_bPartialOutput   = false;
 }
 
 void CEncTaskPool::SetGpuHangRecoveryFlag() {
     m_bGpuHangRecovery = true;
 }
 
+void CEncTaskPool::SetPartialOutputFlag() {
+    m_bPartialOutput = true;
+}
+
 void CEncTaskPool::ClearTasks() {
     for (size_t i = 0; i < m_nPoolSize; i++) {
         m_pTasks[i].Reset();
@@ -325,7 +382,8 @@ mfxStatus sTask::WriteBitstream(bool isCompleteFrame) {
 
 mfxStatus sTask::Reset() {
     // mark sync point as free
-    EncSyncP = NULL;
+    EncSyncP   = NULL;
+    bCompleted = false;
 
     // prepare bit stream
     mfxBS.DataOffset = 0;
@@ -1251,6 +1309,8 @@ CEncodingPipeline::CEncodingPipeline()
           m_bIsFieldSplitting(false),
           m_bSingleTexture(false),
           m_bPartialOutput(false),
+          m_bAsyncWrite(false),
+          m_asyncWriteParams(CAsyncFileWriter::GetDefaultParams()),
           m_statOverall(),
           m_statFile(),
           m_fpsLimiter() {
@@ -1272,6 +1332,8 @@ mfxStatus CEncodingPipeline::InitIVFFileWriter(CIVFFrameWriter** ppWriter,
     MSDK_SAFE_DELETE(*ppWriter);
     *ppWriter = new CIVFFrameWriter;
     MSDK_CHECK_POINTER(*ppWriter, MFX_ERR_MEMORY_ALLOC);
+    if (m_bAsyncWrite)
+        (*ppWriter)->EnableAsyncWrite(m_asyncWriteParams);
     mfxStatus sts = MFX_ERR_NONE;
 
     if (no_outfile) {
@@ -1294,6 +1356,8 @@ mfxStatus CEncodingPipeline::InitFileWriter(CSmplBitstreamWriter** ppWriter,
     MSDK_SAFE_DELETE(*ppWriter);
     *ppWriter = new CSmplBitstreamWriter;
     MSDK_CHECK_POINTER(*ppWriter, MFX_ERR_MEMORY_ALLOC);
+    if (m_bAsyncWrite)
+        (*ppWriter)->EnableAsyncWrite(m_asyncWriteParams);
     mfxStatus sts = (*ppWriter)->Init(filename);
     MSDK_CHECK_STATUS(sts, " failed");
 
@@ -1308,6 +1372,8 @@ mfxStatus CEncodingPipeline::InitFileWriter(CSmplBitstreamWriter** ppWriter,
     MSDK_SAFE_DELETE(*ppWriter);
     *ppWriter = new CSmplBitstreamWriter;
     MSDK_CHECK_POINTER(*ppWriter, MFX_ERR_MEMORY_ALLOC);
+    if (m_bAsyncWrite)
+        (*ppWriter)->EnableAsyncWrite(m_asyncWriteParams);
 
     mfxStatus sts = MFX_ERR_NONE;
 
@@ -1559,12 +1625,18 @@ mfxStatus CEncodingPipeline::Init(sInputParams* pParams) {
 
     // Preparing readers and writers
     if (!isV4L2InputEnabled) {
-        // prepare input file reader
+        // prepare input file reader, frames can't be read ahead when the file is accessed
+        // randomly (qpfile) or preloaded (perf_opt)
+        m_FileReader.SetPrefetchDepth(
+            (pParams->QPFileMode || pParams->nPerfOpt) ? 0 : pParams->nPrefetchDepth);
+        m_FileReader.EnableDirectIO(pParams->bDirectIO);
         sts = m_FileReader.Init(pParams->InputFiles, pParams->FileInputFourCC, readerShift);
         MSDK_CHECK_STATUS(sts, "m_FileReader.Init failed");
     }
 
-    sts = InitFileWriters(pParams);
+    m_bAsyncWrite           = pParams->bAsyncWrite;
+    m_asyncWriteParams.Sync = pParams->AsyncWriteSyncMode;
+    sts                     = InitFileWriters(pParams);
     MSDK_CHECK_STATUS(sts, "InitFileWriters failed");
 
     // set memory type
@@ -1709,6 +1781,9 @@ void CEncodingPipeline::Close() {
                                m_TaskPool.GetFileStatistics().GetDeltaTime();
         msdk_printf(MSDK_STRING("Encoding fps: %.0f\n"),
                     m_FileWriters.first->m_nProcessedFramesNum / ProcDeltaTime);
+        if (m_TaskPool.GetOutOfOrderTasks())
+            msdk_printf(MSDK_STRING("Frames completed out of order: %u\n"),
+                        m_TaskPool.GetOutOfOrderTasks());
 
         if (m_bPartialOutput) {
             const msdk_tick freq = time_get_frequency();
@@ -1720,6 +1795,11 @@ void CEncodingPipeline::Close() {
                         (1000.0 * m_TaskPool.lastOut_total) /
                             (freq * m_FileWriters.first->m_nProcessedFramesNum));
         }
+
+        if (m_FileReader.GetPrefetchDepth())
+            m_FileReader.GetPrefetcher().PrintStatistics(MSDK_STRING("Input prefetch:"));
+        if (m_FileWriters.first->IsAsyncWrite())
+            m_FileWriters.first->GetAsyncWriter().PrintStatistics(MSDK_STRING("Output writer:"));
     }
 
     std::for_each(m_UserDataUnregSEI.begin(), m_UserDataUnregSEI.end(), [](mfxPayload* payload) {
@@ -1768,6 +1848,19 @@ void CEncodingPipeline::FreeFileWriters() {
     MSDK_SAFE_DELETE(m_FileWriters.second);
 }
 
+mfxStatus CEncodingPipeline::FlushFileWriters() {
+    mfxStatus sts = MFX_ERR_NONE;
+    if (m_FileWriters.first) {
+        sts = m_FileWriters.first->Flush();
+        MSDK_CHECK_STATUS(sts, "m_FileWriters.first->Flush failed");
+    }
+    if (m_FileWriters.second && m_FileWriters.second != m_FileWriters.first) {
+        sts = m_FileWriters.second->Flush();
+        MSDK_CHECK_STATUS(sts, "m_FileWriters.second->Flush failed");
+    }
+    return sts;
+}
+
 mfxStatus CEncodingPipeline::FillBuffers() {
     if (m_nPerfOpt) {
         for (mfxU32 i = 0; i < m_nPerfOpt; i++) {
@@ -1867,6 +1960,8 @@ mfxStatus CEncodingPipeline::ResetMFXComponents(sInputParams* pParams) {
 
     if (m_bSoftRobustFlag)
         m_TaskPool.SetGpuHangRecoveryFlag();
+    if (pParams->PartialOutputMode)
+        m_TaskPool.SetPartialOutputFlag();
 
     sts = FillBuffers();
     MSDK_CHECK_STATUS(sts, "FillBuffers failed");
@@ -1952,8 +2047,10 @@ mfxStatus CEncodingPipeline::GetFreeTask(sTask** ppTask) {
         m_bFileWriterReset = false;
     }
 
+    // the first task may be completed already, then its bitstream is written without waiting
+    // and no task in execution is finished, so the tasks are synchronized until one is free
     sts = m_TaskPool.GetFreeTask(ppTask);
-    if (MFX_ERR_NOT_FOUND == sts) {
+    while (MFX_ERR_NOT_FOUND == sts) {
         sts = m_TaskPool.SynchronizeFirstTask(m_nSyncOpTimeout);
         if (MFX_ERR_NONE == sts) {
             m_fpsLimiter.Work();
@@ -1965,6 +2062,9 @@ mfxStatus CEncodingPipeline::GetFreeTask(sTask** ppTask) {
             sts          = MFX_ERR_NONE;
         }
         MSDK_CHECK_STATUS(sts, "m_TaskPool.SynchronizeFirstTask failed");
+        // the first task is still in execution after the timeout
+        if (MFX_ERR_NONE != sts)
+            return MFX_ERR_NOT_FOUND;
 
         // try again
         sts = m_TaskPool.GetFreeTask(ppTask);
@@ -2325,6 +2425,9 @@ mfxStatus CEncodingPipeline::Run() {
     MSDK_IGNORE_MFX_STS(sts, MFX_ERR_NOT_FOUND);
     // report any errors that occurred in asynchronous part
     MSDK_CHECK_STATUS(sts, "m_TaskPool.SynchronizeFirstTask failed");
+    // frames queued to the asynchronous writers reach the files only here
+    sts = FlushFileWriters();
+    MSDK_CHECK_STATUS(sts, "FlushFileWriters failed");
     m_statOverall.StopTimeMeasurement();
     return sts;
 }
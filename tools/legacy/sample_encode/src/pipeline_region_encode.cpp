@@ -29,13 +29,20 @@
 
 mfxStatus CResourcesPool::GetFreeTask(int resourceNum, sTask** ppTask) {
     // get a pointer to a free task (bit stream and sync point for encoder)
+    // the first tasks may be completed already and free no task in execution, the tasks are
+    // synchronized until one is free
     mfxStatus sts = m_resources[resourceNum].TaskPool.GetFreeTask(ppTask);
-    if (MFX_ERR_NOT_FOUND == sts) {
+    while (MFX_ERR_NOT_FOUND == sts) {
         // We should syncrhonize every first task in all task pools to write regions (slices) into destination in correct order
+        bool bInExecution = false;
         for (int i = 0; i < m_size; i++) {
             sts = m_resources[i].TaskPool.SynchronizeFirstTask(m_nSyncOpTimeout);
             MSDK_CHECK_STATUS(sts, "m_resources[i].TaskPool.SynchronizeFirstTask failed");
+            bInExecution |= (MFX_ERR_NONE != sts);
         }
+        // a first task is still in execution after the timeout
+        if (bInExecution)
+            return MFX_ERR_NOT_FOUND;
 
         // try again
         sts = m_resources[resourceNum].TaskPool.GetFreeTask(ppTask);
@@ -271,6 +271,14 @@ void PrintHelp(msdk_char* strAppName, const msdk_char* strErrorMessage, ...) {
         MSDK_STRING("   [-syncop_timeout]        - SyncOperation timeout in milliseconds\n"));
     msdk_printf(MSDK_STRING(
         "   [-perf_opt n]            - sets number of prefetched frames. In performance mode app preallocates buffer and loads first n frames\n"));
+    msdk_printf(MSDK_STRING(
+        "   [-prefetch n]            - read n input frames ahead on a separate thread (not used with -perf_opt and -qpfile)\n"));
+    msdk_printf(MSDK_STRING(
+        "   [-direct_io]             - read input files bypassing the page cache (O_DIRECT) where the file system supports it\n"));
+    msdk_printf(MSDK_STRING(
+        "   [-async_write]           - write output files on a separate thread, small frames are coalesced into large writes\n"));
+    msdk_printf(MSDK_STRING(
+        "   [-datasync:close|always] - with -async_write call fdatasync once on close or after every write\n"));
     msdk_printf(MSDK_STRING("   [-fps]                   - limits overall fps of pipeline\n"));
     msdk_printf(MSDK_STRING(
         "   [-uncut]                 - do not cut output file in looped mode (in case of -timeout option)\n"));
@@ -1207,6 +1215,26 @@ mfxStatus ParseInputString(msdk_char* strInput[], mfxU8 nArgNum, sInputParams* p
                 return MFX_ERR_UNSUPPORTED;
             }
         }
+        else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-async_write"))) {
+            pParams->bAsyncWrite = true;
+        }
+        else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-datasync:close"))) {
+            pParams->AsyncWriteSyncMode = ASYNC_WRITE_SYNC_CLOSE;
+        }
+        else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-datasync:always"))) {
+            pParams->AsyncWriteSyncMode = ASYNC_WRITE_SYNC_ALWAYS;
+        }
+        else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-prefetch"))) {
+            VAL_CHECK(i + 1 >= nArgNum, i, strInput[i]);
+
+            if (MFX_ERR_NONE != msdk_opt_read(strInput[++i], pParams->nPrefetchDepth)) {
+                PrintHelp(strInput[0], MSDK_STRING("prefetch is invalid"));
+                return MFX_ERR_UNSUPPORTED;
+            }
+        }
+        else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-direct_io"))) {
+            pParams->bDirectIO = true;
+        }
         else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-WeightedPred:default"))) {
             pParams->WeightedPred = MFX_WEIGHTED_PRED_DEFAULT;
         }
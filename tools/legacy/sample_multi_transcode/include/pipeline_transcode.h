@@ -12,7 +12,6 @@
 #include <chrono>
 #include <condition_variable>
 #include <ctime>
-#include <future>
 #include <list>
 #include <map>
 #include <memory>
@@ -20,11 +19,15 @@
 #include <vector>
 
 #include "base_allocator.h"
+#include "fan_out_ring.h"
+#include "frame_prefetcher.h"
 #include "mfx_multi_vpp.h"
 #include "rotate_plugin_api.h"
 #include "sample_defs.h"
 #include "sample_utils.h"
+#include "stream_index.h"
 #include "sysmem_allocator.h"
+#include "vm/numa_defs.h"
 
 #include "brc_routines.h"
 #include "hw_device.h"
@@ -272,6 +275,16 @@ struct __sInputParams {
     sPluginParams encoderPluginParams;
 
     mfxU32 nTimeout; // how long transcoding works in seconds
+    mfxU32 nPrefetchDepth; // number of raw input frames read ahead on a separate thread
+    mfxU32 nChunks; // number of chunks of the input transcoded by concurrent sessions
+    bool bSysMemArena; // carve system memory surfaces out of slabs, see SysMemAllocatorParams
+    SysMemHugePages SysMemHugePagesMode; // page size of the slabs
+    bool bSysMemPrefault; // touch every page of a slab when it is mapped
+    mfxI32 NumaNode; // node the session threads and system memory surfaces are placed on, -1 if any
+    bool bSchedulerPool; // run the sessions on a pool of worker threads instead of a thread each
+    mfxU32 nSchedulerWorkers; // threads of the pool, as many as the CPUs if 0
+    bool bAsyncWrite; // write the output file on a separate thread
+    AsyncWriteSync AsyncWriteSyncMode;
     mfxU32 nFPS; // limit transcoding to the number of frames per second
 
     mfxU32 statisticsWindowSize;
@@ -386,6 +399,14 @@ struct sInputParams : public __sInputParams {
 
     bool bDecoderPostProcessing;
     bool bROIasQPMAP;
+
+    // frames of the input transcoded by a session of a chunked input
+    std::shared_ptr<CStreamIndex> pChunkIndex;
+    mfxU32 nChunkFirstFrame;
+    mfxU32 nChunkFrames;
+
+    // CPUs the session thread runs on, the CPUs of NumaNode if empty
+    std::vector<mfxU32> NumaCpus;
 #ifdef ENABLE_MCTF
     sMCTFParam mctfParam;
 #endif
@@ -398,8 +419,10 @@ public:
     enum class EventName {
         UNDEF,
         BUSY,
-        SYNC
+        SYNC,
         //SURF_POOL
+        RING_OCCUPANCY,
+        RING_STALLS
     };
 
     enum class EventType { DurationStart, DurationEnd, FlowStart, FlowEnd, Counter };
@@ -556,6 +579,8 @@ struct ExtendedSurface {
 struct ExtendedBS {
     bool IsFree = true;
     mfxBitstreamWrapper Bitstream;
+    // the encoding task is in execution, reset when it's completed and the bitstream waits
+    // in the pool for the ones before it to be written
     mfxSyncPoint Syncp     = nullptr;
     PreEncAuxBuffer* pCtrl = nullptr;
 };
@@ -595,13 +620,16 @@ public:
         }
     }
 
+    // Prints the statistics of the window, the window is added to the session statistics
     inline void PrintStatistics(mfxU32 numPipelineid,
                                 mfxF64 target_framerate = -1 /*default stands for infinite*/) {
+        m_sessionHistogram.Merge(GetHistogram());
+
         // print timings in ms
         msdk_fprintf(
             ofile,
             MSDK_STRING(
-                "stat[%u.%llu]: %s=%d;Framerate=%.3f;Total=%.3lf;Samples=%lld;StdDev=%.3lf;Min=%.3lf;Max=%.3lf;Avg=%.3lf\n"),
+                "stat[%u.%llu]: %s=%d;Framerate=%.3f;Total=%.3lf;Samples=%lld;StdDev=%.3lf;Min=%.3lf;Max=%.3lf;Avg=%.3lf;P50=%.3lf;P90=%.3lf;P99=%.3lf;P99.9=%.3lf\n"),
             msdk_get_current_pid(),
             (unsigned long long int)rdtsc(),
             bufDir,
@@ -612,7 +640,11 @@ public:
             (double)GetTimeStdDev(false),
             (double)GetMinTime(false),
             (double)GetMaxTime(false),
-            (double)GetAvgTime(false));
+            (double)GetAvgTime(false),
+            (double)GetPercentile(50, false),
+            (double)GetPercentile(90, false),
+            (double)GetPercentile(99, false),
+            (double)GetPercentile(99.9, false));
         fflush(ofile);
 
         if (!DumpLogFileName.empty()) {
@@ -641,7 +673,15 @@ public:
         }
     }
 
+    // Distribution of all measurements of the session including the window not printed yet
+    inline CLatencyHistogram GetSessionHistogram() const {
+        CLatencyHistogram histogram = m_sessionHistogram;
+        histogram.Merge(GetHistogram());
+        return histogram;
+    }
+
 protected:
+    CLatencyHistogram m_sessionHistogram;
     msdk_tstring DumpLogFileName;
     FILE* ofile;
     msdk_char bufDir[MAX_PREF_LEN];
@@ -697,37 +737,48 @@ private:
 class CTranscodingPipeline;
 // thread safety buffer heterogeneous pipeline
 // only for join sessions
+// The buffer reads the surfaces of the source session from a ring as one of its consumers. In the
+// 1 to N mode without cascade scaling the buffers of all sinks share one ring, so a surface is
+// added once for all of them, otherwise every buffer has a ring of its own.
 class SafetySurfaceBuffer {
 public:
+    typedef msdkFanOutRing<ExtendedSurface> SurfaceRing;
+
+    // the ring holds a reference to the surface, the source waits while it is full
+    static const mfxU32 RingCapacity = 64;
+
     //this is used only for sanity check
     mfxU32 TargetID = 0;
 
-    struct SurfaceDescriptor {
-        SurfaceDescriptor() : ExtSurface(), Locked(false) {}
-        ExtendedSurface ExtSurface;
-        mfxU32 Locked;
-    };
-
     SafetySurfaceBuffer(SafetySurfaceBuffer* pNext);
+    SafetySurfaceBuffer(SafetySurfaceBuffer* pNext,
+                        std::shared_ptr<SurfaceRing> pRing,
+                        mfxU32 consumer);
     virtual ~SafetySurfaceBuffer();
 
+    static std::shared_ptr<SurfaceRing> CreateRing(mfxU32 numConsumers);
+
     mfxU32 GetLength();
-    mfxStatus WaitForSurfaceRelease(mfxU32 msec);
     mfxStatus WaitForSurfaceInsertion(mfxU32 msec);
-    void AddSurface(ExtendedSurface Surf);
+    // Adds the surface to the buffers sharing the ring
+    mfxStatus AddSurface(ExtendedSurface Surf);
     mfxStatus GetSurface(ExtendedSurface& Surf);
     mfxStatus ReleaseSurface(mfxFrameSurface1* pSurf);
     mfxStatus ReleaseSurfaceAll();
     void CancelBuffering();
 
+    bool SharesRing(const SafetySurfaceBuffer* pOther) const {
+        return pOther && pOther->m_pRing == m_pRing;
+    }
+    SurfaceRing::Statistics GetStatistics() const {
+        return m_pRing->GetStatistics();
+    }
+
     SafetySurfaceBuffer* m_pNext;
 
 protected:
-    std::mutex m_mutex;
-    std::list<SurfaceDescriptor> m_SList;
-    bool m_IsBufferingAllowed;
-    MSDKEvent* pRelEvent;
-    MSDKEvent* pInsEvent;
+    std::shared_ptr<SurfaceRing> m_pRing;
+    mfxU32 m_Consumer;
 
 private:
     DISALLOW_COPY_AND_ASSIGN(SafetySurfaceBuffer);
@@ -745,6 +796,8 @@ public:
     virtual mfxStatus ProcessOutputBitstream(mfxBitstreamWrapper* pBitstream);
     virtual mfxStatus ResetInput();
     virtual mfxStatus ResetOutput();
+    // Writes the buffered output and closes the output file
+    virtual mfxStatus CloseOutput();
     virtual bool IsNulOutput();
 
 protected:
@@ -758,6 +811,27 @@ private:
     DISALLOW_COPY_AND_ASSIGN(FileBitstreamProcessor);
 };
 
+// Reads a run of frames of the input starting at a key frame, the frame reader is moved to
+// the run by the stream index
+class ChunkBitstreamProcessor : public FileBitstreamProcessor {
+public:
+    ChunkBitstreamProcessor(std::shared_ptr<CStreamIndex> pIndex,
+                            mfxU32 nFirstFrame,
+                            mfxU32 nNumFrames);
+    virtual mfxStatus GetInputBitstream(mfxBitstreamWrapper** pBitstream) override;
+    virtual mfxStatus ResetInput() override;
+
+protected:
+    std::shared_ptr<CStreamIndex> m_pIndex;
+    mfxU32 m_nFirstFrame;
+    mfxU32 m_nNumFrames;
+    mfxU32 m_nReadFrames;
+    bool m_bSeekDone;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(ChunkBitstreamProcessor);
+};
+
 typedef std::vector<mfxFrameSurface1*> SurfPointersArray;
 typedef std::vector<PreEncAuxBuffer> PreEncAuxArray;
 typedef std::list<ExtendedBS*> BSList;
@@ -805,6 +879,19 @@ public:
     inline void SetPipelineID(mfxU32 id) {
         m_nID = id;
     }
+    mfxU32 GetOutOfOrderTasks() const {
+        return m_nOutOfOrderTasks;
+    }
+    mfxU32 GetOldestTaskWaits() const {
+        return m_nOldestTaskWaits;
+    }
+    // Frame latencies of the session gathered with -stat
+    CLatencyHistogram GetInputLatencies() const {
+        return inputStatistics.GetSessionHistogram();
+    }
+    CLatencyHistogram GetOutputLatencies() const {
+        return outputStatistics.GetSessionHistogram();
+    }
     void StopSession();
     mfxStatus CheckStopCondition();
     void SetSurfaceUtilizationSynchronizer(
@@ -812,6 +899,19 @@ public:
     mfxU16 GetNumFrameForAlloc() const;
     bool IsOverlayUsed();
     size_t GetRobustFlag();
+    // Run() of a session which decodes, processes and encodes its own stream may return after
+    // every encoded frame with MFX_TASK_WORKING, the next call resumes from that frame
+    bool IsStepByStepSupported() const {
+        return m_bDecodeEnable && m_bEncodeEnable && !m_pSurfaceUtilizationSynchronizer;
+    }
+    void SetStepByStep(bool bStepByStep) {
+        m_bStepByStep = bStepByStep;
+    }
+    // Microseconds the next step waits for to keep the -fps rate, the caller of a step returning
+    // MFX_TASK_WORKING holds the next one back instead of the pipeline sleeping in the step
+    mfxU32 GetStepDelay() const {
+        return m_TranscodeState.nStepDelay;
+    }
 
     msdk_string GetSessionText() {
         msdk_stringstream ss;
@@ -903,6 +1003,7 @@ protected:
 
     mfxStatus AllocateSufficientBuffer(mfxBitstreamWrapper* pBS);
     mfxStatus PutBS();
+    mfxStatus PutCompletedBS();
 
     mfxStatus DumpSurface2File(mfxFrameSurface1* pSurface);
     mfxStatus Surface2BS(ExtendedSurface* pSurf, mfxBitstreamWrapper* pBS, mfxU32 fourCC);
@@ -913,6 +1014,7 @@ protected:
     mfxStatus YUY2toBS(mfxFrameSurface1* pSurface, mfxBitstreamWrapper* pBS);
 
     void NoMoreFramesSignal();
+    void TraceSinkBuffers();
     mfxStatus AddLaStreams(mfxU16 width, mfxU16 height);
 
     void LockPreEncAuxBuffer(PreEncAuxBuffer* pBuff);
@@ -975,6 +1077,10 @@ protected:
 
     // transcoding pipeline specific
     BSList m_BSPool;
+    // encoding tasks completed before the ones submitted earlier and the times the session
+    // waited for the oldest task
+    mfxU32 m_nOutOfOrderTasks;
+    mfxU32 m_nOldestTaskWaits;
 
     mfxInitParamlWrap m_initPar;
 
@@ -1060,6 +1166,21 @@ protected:
 
     msdk_tick m_nReqFrameTime; // time required to transcode one frame
 
+    // locals of Transcode() kept between the steps
+    struct TranscodeState {
+        bool bResume; // the previous call returned after a frame
+        ExtendedSurface DecExtSurface;
+        ExtendedSurface VppExtSurface;
+        bool bNeedDecodedFrames;
+        bool bEndOfFile;
+        bool bLastCycle;
+        bool shouldReadNextFrame;
+        time_t start;
+        mfxU32 nStepDelay;
+    };
+    bool m_bStepByStep;
+    TranscodeState m_TranscodeState;
+
     mfxU32 statisticsWindowSize; // Sliding window size for Statistics
     mfxU32 m_nOutputFramesNum;
 
@@ -1126,22 +1247,51 @@ struct ThreadTranscodeContext {
     // Status of the finished session
     mfxStatus transcodingSts = MFX_ERR_NONE;
 
-    // Thread handle
-    std::future<void> handle;
+    // The session is between the steps of transcoding and the time it started
+    bool bRunning = false;
+    std::chrono::system_clock::time_point start_time;
 
-    void TranscodeRoutine() {
-        using namespace std::chrono;
-        MSDK_CHECK_POINTER_NO_RET(pPipeline);
-        transcodingSts = MFX_ERR_NONE;
+    // CPUs the thread is pinned to and the node its memory is taken from, any if empty or -1
+    std::vector<mfxU32> cpus;
+    mfxI32 numaNode = -1;
 
-        auto start_time = system_clock::now();
-        while (MFX_ERR_NONE == transcodingSts) {
-            transcodingSts = pPipeline->Run();
+    // Does a step of transcoding, the whole stream unless the pipeline runs step by step.
+    // Returns MFX_TASK_WORKING until the session is completed, then its status.
+    // With -fps the next step is due in GetStepDelay() microseconds.
+    mfxStatus TranscodeStep() {
+        using namespace std::chrono;
+        MSDK_CHECK_POINTER(pPipeline, MFX_ERR_NULL_PTR);
+        if (!bRunning) {
+            bRunning       = true;
+            transcodingSts = MFX_ERR_NONE;
+            start_time     = system_clock::now();
         }
-        working_time = duration_cast<duration<mfxF64>>(system_clock::now() - start_time).count();
 
+        mfxStatus sts = pPipeline->Run();
+        if (MFX_ERR_NONE == sts || MFX_TASK_WORKING == sts)
+            return MFX_TASK_WORKING;
+
+        bRunning       = false;
+        working_time   = duration_cast<duration<mfxF64>>(system_clock::now() - start_time).count();
+        transcodingSts = sts;
         MSDK_IGNORE_MFX_STS(transcodingSts, MFX_WRN_VALUE_NOT_CHANGED);
         numTransFrames = pPipeline->GetProcessFrames();
+        return transcodingSts;
+    }
+
+    // Transcodes the stream on the calling thread
+    void TranscodeRoutine() {
+        MSDK_CHECK_POINTER_NO_RET(pPipeline);
+
+        // buffers first touched by the session are local to the CPUs then, placement is a
+        // hint and the session runs anywhere if the system doesn't support it
+        if (!cpus.empty() && msdk_thread_set_affinity(cpus) != MFX_ERR_NONE)
+            msdk_printf(MSDK_STRING("WARNING: failed to pin the session thread to its CPUs\n"));
+        if (numaNode >= 0)
+            msdk_numa_set_preferred_node(numaNode);
+
+        while (MFX_TASK_WORKING == TranscodeStep())
+            ;
     }
 };
 } // namespace TranscodingSample
@@ -50,6 +50,8 @@ protected:
     mfxStatus CheckAndFixAdapterDependency(mfxU32 idxSession,
                                            CTranscodingPipeline* pParentPipeline);
     virtual mfxStatus VerifyCrossSessionsOptions();
+    virtual mfxStatus SplitInputsIntoChunks();
+    virtual mfxStatus JoinChunkOutputs();
     virtual mfxStatus CreateSafetyBuffers();
     CascadeScalerConfig& CreateCascadeScalerConfig();
     virtual void DoTranscoding();
@@ -65,6 +67,17 @@ protected:
     std::vector<std::unique_ptr<GeneralAllocator>> m_pAllocArray;
     // input parameters for each session
     std::vector<sInputParams> m_InputParamsArray;
+    // par file line of each session, the sessions of the chunks of an input share the line
+    std::vector<mfxU32> m_SessionLines;
+
+    struct ChunkedOutput {
+        std::vector<mfxU32> Sessions;
+        // the output file written by the first chunk and the files of the next chunks
+        std::vector<msdk_string> Files;
+    };
+    std::vector<ChunkedOutput> m_ChunkedOutputs;
+    // resident memory of the process per node after transcoding, empty without placement
+    std::vector<mfxU64> m_NumaMemoryUsage;
     // safety buffers
     // needed for heterogeneous pipeline
     std::vector<std::unique_ptr<SafetySurfaceBuffer>> m_pBufferArray;
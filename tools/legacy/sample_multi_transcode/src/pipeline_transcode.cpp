@@ -80,7 +80,11 @@ sInputParams::sInputParams()
           DumpLogFileName(),
           m_ROIData(),
           bDecoderPostProcessing(false),
-          bROIasQPMAP(false) {
+          bROIasQPMAP(false),
+          pChunkIndex(),
+          nChunkFirstFrame(0),
+          nChunkFrames(0),
+          NumaCpus() {
 #ifdef ENABLE_MCTF
     mctfParam.mode                  = VPP_FILTER_DISABLED;
     mctfParam.params.FilterStrength = 0;
@@ -101,6 +105,8 @@ sInputParams::sInputParams()
     dGfxIdx     = -1;
     adapterNum  = -1;
 
+    NumaNode = -1;
+
     MaxFrameNumber   = MFX_INFINITE;
     pVppCompDstRects = NULL;
     m_hwdev          = NULL;
@@ -146,6 +152,8 @@ CTranscodingPipeline::CTranscodingPipeline()
           m_DecSurfaceType(0),
           m_pPreEncAuxPool(),
           m_BSPool(),
+          m_nOutOfOrderTasks(0),
+          m_nOldestTaskWaits(0),
           m_initPar(),
           m_bForceStop(false),
           m_forceSyncAllSession(false),
@@ -199,6 +207,8 @@ CTranscodingPipeline::CTranscodingPipeline()
           m_MaxFramesForEncode(0),
           m_pBSProcessor(NULL),
           m_nReqFrameTime(0),
+          m_bStepByStep(false),
+          m_TranscodeState(),
           statisticsWindowSize(0),
           m_nOutputFramesNum(0),
           inputStatistics(),
@@ -927,12 +937,33 @@ void CTranscodingPipeline::NoMoreFramesSignal() {
     /*if 1_to_N mode */
     if (0 == m_nVPPCompEnable) {
         while (pNextBuffer->m_pNext) {
+            // the buffers sharing the ring got the surface already
+            if (!pNextBuffer->m_pNext->SharesRing(pNextBuffer))
+                pNextBuffer->m_pNext->AddSurface(surf);
             pNextBuffer = pNextBuffer->m_pNext;
-            pNextBuffer->AddSurface(surf);
         }
     }
 }
 
+// occupancy of the rings of the sinks and the times the decoder waited for a free slot
+void CTranscodingPipeline::TraceSinkBuffers() {
+    for (SafetySurfaceBuffer* pBuffer = m_pBuffer; pBuffer; pBuffer = pBuffer->m_pNext) {
+        // a shared ring is traced once
+        if (pBuffer->SharesRing(pBuffer->m_pNext))
+            continue;
+
+        SafetySurfaceBuffer::SurfaceRing::Statistics stat = pBuffer->GetStatistics();
+        m_ScalerConfig.Tracer->AddCounterEvent(SMTTracer::ThreadType::DEC,
+                                               pBuffer->TargetID,
+                                               SMTTracer::EventName::RING_OCCUPANCY,
+                                               stat.Occupancy);
+        m_ScalerConfig.Tracer->AddCounterEvent(SMTTracer::ThreadType::DEC,
+                                               pBuffer->TargetID,
+                                               SMTTracer::EventName::RING_STALLS,
+                                               stat.ProducerStalls);
+    }
+}
+
 void CTranscodingPipeline::StopSession() {
     std::lock_guard<std::mutex> guard(m_mStopSession);
     m_bForceStop = true;
@@ -995,7 +1026,8 @@ mfxStatus CTranscodingPipeline::Decode() {
 
         if (pNextBuffer->GetLength() == 0) {
             // add surfaces in queue for all sinks
-            pNextBuffer->AddSurface(PreEncExtSurface);
+            sts = pNextBuffer->AddSurface(PreEncExtSurface);
+            MSDK_CHECK_STATUS(sts, "AddSurface failed");
             m_nProcessedFramesNum++;
         }
         return MFX_ERR_NONE;
@@ -1225,23 +1257,33 @@ mfxStatus CTranscodingPipeline::Decode() {
                 if (buf[i]->TargetID != OutSurfaces[i].TargetID) {
                     return MFX_ERR_UNKNOWN;
                 }
-                buf[i]->AddSurface(OutSurfaces[i]);
+                sts = buf[i]->AddSurface(OutSurfaces[i]);
+                MSDK_CHECK_STATUS(sts, "AddSurface failed");
             }
 
             OutSurfaces.clear();
         }
         else {
-            pNextBuffer->AddSurface(PreEncExtSurface);
+            sts = pNextBuffer->AddSurface(PreEncExtSurface);
+            MSDK_CHECK_STATUS(sts, "AddSurface failed");
             /* one of key parts for N_to_1 mode:
             * decoded frame should be in one buffer only as we have only 1 (one!) sink
             * */
             if (0 == m_nVPPCompEnable) {
                 while (pNextBuffer->m_pNext) {
-                    pNextBuffer = pNextBuffer->m_pNext;
-                    pNextBuffer->AddSurface(PreEncExtSurface);
+                    SafetySurfaceBuffer* pPrevBuffer = pNextBuffer;
+                    pNextBuffer                      = pNextBuffer->m_pNext;
+                    // the buffers sharing the ring got the surface already
+                    if (!pNextBuffer->SharesRing(pPrevBuffer)) {
+                        sts = pNextBuffer->AddSurface(PreEncExtSurface);
+                        MSDK_CHECK_STATUS(sts, "AddSurface failed");
+                    }
                 }
             }
         }
+        if (0 == m_nVPPCompEnable) {
+            TraceSinkBuffers();
+        }
 
         if (m_MemoryModel != GENERAL_ALLOC && PreEncExtSurface.pSurface) {
             mfxStatus sts_release =
@@ -1576,9 +1618,9 @@ mfxStatus CTranscodingPipeline::Encode() {
         }
 
         if ((m_nVPPCompEnable != VppCompOnly) || (m_nVPPCompEnable == VppCompOnlyEncode)) {
-            if (m_BSPool.size() == m_AsyncDepth) {
-                sts = PutBS();
-                MSDK_CHECK_STATUS(sts, "PutBS failed");
+            if (m_BSPool.size() >= m_AsyncDepth) {
+                sts = PutCompletedBS();
+                MSDK_CHECK_STATUS(sts, "PutCompletedBS failed");
             }
             else {
                 continue;
@@ -1801,16 +1843,26 @@ void CTranscodingPipeline::SetEncCtrlRT(ExtendedSurface& extSurface, bool bInser
 }
 
 mfxStatus CTranscodingPipeline::Transcode() {
-    mfxStatus sts                 = MFX_ERR_NONE;
-    ExtendedSurface DecExtSurface = { 0 };
-    ExtendedSurface VppExtSurface = { 0 };
-    ExtendedBS* pBS               = NULL;
-    bool bNeedDecodedFrames       = true; // indicates if we need to decode frames
-    bool bEndOfFile               = false;
-    bool bLastCycle               = false;
-    bool shouldReadNextFrame      = true;
-
-    time_t start = time(0);
+    mfxStatus sts = MFX_ERR_NONE;
+    if (!m_TranscodeState.bResume) {
+        m_TranscodeState                     = TranscodeState();
+        m_TranscodeState.bNeedDecodedFrames  = true; // indicates if we need to decode frames
+        m_TranscodeState.shouldReadNextFrame = true;
+        m_TranscodeState.start               = time(0);
+    }
+    // an error leaves the state in the middle of the stream, the next call starts over
+    m_TranscodeState.bResume    = false;
+    m_TranscodeState.nStepDelay = 0;
+
+    ExtendedSurface& DecExtSurface = m_TranscodeState.DecExtSurface;
+    ExtendedSurface& VppExtSurface = m_TranscodeState.VppExtSurface;
+    ExtendedBS* pBS                = NULL;
+    bool& bNeedDecodedFrames       = m_TranscodeState.bNeedDecodedFrames;
+    bool& bEndOfFile               = m_TranscodeState.bEndOfFile;
+    bool& bLastCycle               = m_TranscodeState.bLastCycle;
+    bool& shouldReadNextFrame      = m_TranscodeState.shouldReadNextFrame;
+
+    time_t start = m_TranscodeState.start;
     while (MFX_ERR_NONE == sts) {
         msdk_tick nBeginTime = msdk_time_get_tick(); // microseconds.
 
@@ -2005,12 +2057,19 @@ mfxStatus CTranscodingPipeline::Transcode() {
 
         m_BSPool.back()->Syncp = VppExtSurface.Syncp;
 
-        if (m_BSPool.size() == m_AsyncDepth) {
-            sts = PutBS();
-            MSDK_CHECK_STATUS(sts, "PutBS failed");
+        if (m_BSPool.size() >= m_AsyncDepth) {
+            sts = PutCompletedBS();
+            MSDK_CHECK_STATUS(sts, "PutCompletedBS failed");
         }
 
         msdk_tick nFrameTime = msdk_time_get_tick() - nBeginTime;
+        if (m_bStepByStep) {
+            // the step runs on a pool worker, the scheduler resumes it when the frame time is over
+            if (nFrameTime < m_nReqFrameTime)
+                m_TranscodeState.nStepDelay = (mfxU32)(m_nReqFrameTime - nFrameTime);
+            m_TranscodeState.bResume = true;
+            return MFX_TASK_WORKING;
+        }
         if (nFrameTime < m_nReqFrameTime) {
             MSDK_USLEEP((mfxU32)(m_nReqFrameTime - nFrameTime));
         }
@@ -2079,6 +2138,52 @@ mfxStatus CTranscodingPipeline::PutBS() {
     return sts;
 } //mfxStatus CTranscodingPipeline::PutBS()
 
+// Completes the encoding tasks in any order and writes their bitstreams in order. The sync
+// points of all tasks in the pool are polled, the buffers of the completed tasks are returned at
+// once and the completed tasks at the head of the pool are written. The session waits for the
+// oldest task only while AsyncDepth tasks are in execution or the pool is full of completed
+// tasks waiting for it, so a slow frame doesn't hold back the frames encoded after it.
+mfxStatus CTranscodingPipeline::PutCompletedBS() {
+    mfxStatus sts         = MFX_ERR_NONE;
+    mfxU32 numInExecution = 0;
+    for (ExtendedBS* pBitstreamEx : m_BSPool) {
+        if (!pBitstreamEx->Syncp)
+            continue;
+
+        // errors are left to PutBS, which handles them when the task gets the oldest one
+        sts = m_pmfxSession->SyncOperation(pBitstreamEx->Syncp, 0);
+        if (MFX_ERR_NONE != sts) {
+            numInExecution++;
+            continue;
+        }
+
+        pBitstreamEx->Syncp = nullptr;
+        if (numInExecution)
+            m_nOutOfOrderTasks++;
+        if (m_pSurfaceUtilizationSynchronizer && m_MemoryModel != GENERAL_ALLOC) {
+            m_pSurfaceUtilizationSynchronizer->NotifyFreeCome();
+        }
+        UnPreEncAuxBuffer(pBitstreamEx->pCtrl);
+        pBitstreamEx->pCtrl = nullptr;
+    }
+
+    for (;;) {
+        while (m_BSPool.size() && !m_BSPool.front()->Syncp) {
+            sts = PutBS();
+            MSDK_CHECK_STATUS(sts, "PutBS failed");
+        }
+        if (m_BSPool.empty() ||
+            (numInExecution < m_AsyncDepth && m_BSPool.size() < m_AsyncDepth * 2))
+            break;
+
+        m_nOldestTaskWaits++;
+        sts = PutBS();
+        MSDK_CHECK_STATUS(sts, "PutBS failed");
+        numInExecution--;
+    }
+    return MFX_ERR_NONE;
+} // mfxStatus CTranscodingPipeline::PutCompletedBS()
+
 mfxStatus CTranscodingPipeline::DumpSurface2File(mfxFrameSurface1* pSurf) {
     mfxStatus sts = MFX_ERR_NONE;
 
@@ -3672,7 +3777,9 @@ mfxStatus CTranscodingPipeline::Init(sInputParams* pParams,
         statisticsWindowSize = m_MaxFramesForTranscode;
 
     if (m_bEncodeEnable) {
-        m_pBSStore.reset(new ExtendedBSStore(m_AsyncDepth));
+        // AsyncDepth tasks in execution and as many completed ones waiting for the first task,
+        // see PutCompletedBS
+        m_pBSStore.reset(new ExtendedBSStore(m_AsyncDepth * 2));
     }
 
     // Determine processing mode
@@ -4513,116 +4620,86 @@ void DecreaseReference(mfxFrameSurface1& surf) {
 }
 
 SafetySurfaceBuffer::SafetySurfaceBuffer(SafetySurfaceBuffer* pNext)
-        : m_pNext(pNext),
-          m_IsBufferingAllowed(true),
-          pInsEvent(nullptr) {
-    mfxStatus sts = MFX_ERR_NONE;
-    pRelEvent     = new MSDKEvent(sts, false, false);
-    MSDK_CHECK_POINTER_NO_RET(pRelEvent);
-
-    pInsEvent = new MSDKEvent(sts, false, false);
-    MSDK_CHECK_POINTER_NO_RET(pInsEvent);
-
-} // SafetySurfaceBuffer::SafetySurfaceBuffer
+        : SafetySurfaceBuffer(pNext, CreateRing(1), 0) {}
 
-SafetySurfaceBuffer::~SafetySurfaceBuffer() {
-    delete pRelEvent;
-    delete pInsEvent;
-} //SafetySurfaceBuffer::~SafetySurfaceBuffer()
+SafetySurfaceBuffer::SafetySurfaceBuffer(SafetySurfaceBuffer* pNext,
+                                         std::shared_ptr<SurfaceRing> pRing,
+                                         mfxU32 consumer)
+        : m_pNext(pNext),
+          m_pRing(pRing),
+          m_Consumer(consumer) {}
+
+SafetySurfaceBuffer::~SafetySurfaceBuffer() {}
+
+std::shared_ptr<SafetySurfaceBuffer::SurfaceRing> SafetySurfaceBuffer::CreateRing(
+    mfxU32 numConsumers) {
+    std::shared_ptr<SurfaceRing> pRing(new SurfaceRing);
+    // the last sink done with the surface drops the reference of the ring
+    mfxStatus sts = pRing->Init(RingCapacity, numConsumers, [](ExtendedSurface& Surf) {
+        if (Surf.pSurface)
+            DecreaseReference(*Surf.pSurface);
+    });
+    return sts == MFX_ERR_NONE ? pRing : nullptr;
+} // SafetySurfaceBuffer::CreateRing
 
 mfxU32 SafetySurfaceBuffer::GetLength() {
-    std::lock_guard<std::mutex> guard(m_mutex);
-    return (mfxU32)m_SList.size();
-}
-
-mfxStatus SafetySurfaceBuffer::WaitForSurfaceRelease(mfxU32 msec) {
-    return pRelEvent->TimedWait(msec);
+    return m_pRing->GetLength(m_Consumer);
 }
 
 mfxStatus SafetySurfaceBuffer::WaitForSurfaceInsertion(mfxU32 msec) {
-    return pInsEvent->TimedWait(msec);
+    return m_pRing->Wait(m_Consumer, msec);
 }
 
-void SafetySurfaceBuffer::AddSurface(ExtendedSurface Surf) {
-    bool isBufferingAllowed = false;
-
-    {
-        std::lock_guard<std::mutex> guard(m_mutex);
-
-        isBufferingAllowed = m_IsBufferingAllowed;
-        if (isBufferingAllowed) {
-            SurfaceDescriptor sDescriptor;
-            // Locked is used to signal when we can free surface
-            sDescriptor.Locked     = 1;
-            sDescriptor.ExtSurface = Surf;
-
-            if (Surf.pSurface) {
-                IncreaseReference(*Surf.pSurface);
-            }
-
-            m_SList.push_back(sDescriptor);
-        }
+mfxStatus SafetySurfaceBuffer::AddSurface(ExtendedSurface Surf) {
+    if (Surf.pSurface) {
+        IncreaseReference(*Surf.pSurface);
     }
 
-    if (isBufferingAllowed) {
-        pInsEvent->Signal();
+    mfxStatus sts = m_pRing->Push(Surf, MSDK_SURFACE_WAIT_INTERVAL);
+    if (sts != MFX_ERR_NONE && Surf.pSurface) {
+        DecreaseReference(*Surf.pSurface);
     }
 
+    // all sinks have cancelled buffering, the surface isn't needed
+    if (sts == MFX_ERR_ABORTED)
+        return MFX_ERR_NONE;
+    if (sts == MFX_TASK_WORKING) {
+        msdk_printf(MSDK_STRING("ERROR: timed out waiting for downstream components\n"));
+        return MFX_ERR_NOT_FOUND;
+    }
+    return sts;
 } // SafetySurfaceBuffer::AddSurface(mfxFrameSurface1 *pSurf)
 
 mfxStatus SafetySurfaceBuffer::GetSurface(ExtendedSurface& Surf) {
-    std::lock_guard<std::mutex> guard(m_mutex);
-
     // no ready surfaces
-    if (0 == m_SList.size()) {
+    if (m_pRing->Peek(m_Consumer, Surf) != MFX_ERR_NONE) {
         MSDK_ZERO_MEMORY(Surf)
         return MFX_ERR_MORE_SURFACE;
     }
 
-    SurfaceDescriptor sDescriptor = m_SList.front();
-
-    Surf = sDescriptor.ExtSurface;
-
     return MFX_ERR_NONE;
 
 } // SafetySurfaceBuffer::GetSurface()
 
 mfxStatus SafetySurfaceBuffer::ReleaseSurface(mfxFrameSurface1* pSurf) {
-    std::unique_lock<std::mutex> lock(m_mutex);
-
-    std::list<SurfaceDescriptor>::iterator it;
-    for (it = m_SList.begin(); it != m_SList.end(); it++) {
-        if (pSurf == it->ExtSurface.pSurface) {
-            it->Locked--;
-            if (it->ExtSurface.pSurface)
-                DecreaseReference(*it->ExtSurface.pSurface);
-            if (0 == it->Locked) {
-                m_SList.erase(it);
-                lock.unlock();
-
-                // event operation should be out of synced context
-                pRelEvent->Signal();
-            }
-
-            return MFX_ERR_NONE;
-        }
-    }
+    // GetSurface returns the oldest surface until it is released, so every caller releases the
+    // surface it got last and the surfaces are released in the order they were added
+    ExtendedSurface Surf;
+    if (m_pRing->Peek(m_Consumer, Surf) != MFX_ERR_NONE || Surf.pSurface != pSurf)
+        return MFX_ERR_UNKNOWN;
 
-    return MFX_ERR_UNKNOWN;
+    return m_pRing->Release(m_Consumer);
 } // mfxStatus SafetySurfaceBuffer::ReleaseSurface(mfxFrameSurface1* pSurf)
 
 mfxStatus SafetySurfaceBuffer::ReleaseSurfaceAll() {
-    std::lock_guard<std::mutex> guard(m_mutex);
-
-    m_SList.clear();
-    m_IsBufferingAllowed = true;
+    // the ring is shared with the other sinks, only the surfaces of this one are released
+    m_pRing->Reset(m_Consumer);
     return MFX_ERR_NONE;
 
 } // mfxStatus SafetySurfaceBuffer::ReleaseSurface(mfxFrameSurface1* pSurf)
 
 void SafetySurfaceBuffer::CancelBuffering() {
-    std::lock_guard<std::mutex> guard(m_mutex);
-    m_IsBufferingAllowed = false;
+    m_pRing->Cancel(m_Consumer);
 }
 
 FileBitstreamProcessor::FileBitstreamProcessor() {
@@ -4632,8 +4709,14 @@ FileBitstreamProcessor::FileBitstreamProcessor() {
 FileBitstreamProcessor::~FileBitstreamProcessor() {
     if (m_pFileReader.get())
         m_pFileReader->Close();
-    if (m_pFileWriter.get())
+    // stops the read ahead thread of the prefetching reader
+    if (m_pYUVFileReader.get())
+        m_pYUVFileReader->Close();
+    if (m_pFileWriter.get()) {
         m_pFileWriter->Close();
+        if (m_pFileWriter->IsAsyncWrite())
+            m_pFileWriter->GetAsyncWriter().PrintStatistics(MSDK_STRING("Output writer:"));
+    }
 }
 
 mfxStatus FileBitstreamProcessor::SetReader(std::unique_ptr<CSmplYUVReader>& reader) {
@@ -4660,6 +4743,11 @@ mfxStatus FileBitstreamProcessor::GetInputBitstream(mfxBitstreamWrapper** pBitst
         return MFX_ERR_UNSUPPORTED;
     }
     mfxStatus sts = m_pFileReader->ReadNextFrame(&m_Bitstream);
+    // frame readers keep a frame which doesn't fit until the bitstream is extended
+    while (MFX_ERR_NOT_ENOUGH_BUFFER == sts) {
+        m_Bitstream.Extend(m_Bitstream.MaxLength * 2);
+        sts = m_pFileReader->ReadNextFrame(&m_Bitstream);
+    }
     if (MFX_ERR_NONE == sts) {
         *pBitstream = &m_Bitstream;
         return sts;
@@ -4702,10 +4790,58 @@ mfxStatus FileBitstreamProcessor::ResetOutput() {
     return MFX_ERR_NONE;
 }
 
+mfxStatus FileBitstreamProcessor::CloseOutput() {
+    mfxStatus sts = MFX_ERR_NONE;
+    if (m_pFileWriter.get()) {
+        sts = m_pFileWriter->Flush();
+        m_pFileWriter->Close();
+    }
+    return sts;
+}
+
 bool FileBitstreamProcessor::IsNulOutput() {
     return !m_pFileWriter.get();
 }
 
+ChunkBitstreamProcessor::ChunkBitstreamProcessor(std::shared_ptr<CStreamIndex> pIndex,
+                                                 mfxU32 nFirstFrame,
+                                                 mfxU32 nNumFrames)
+        : FileBitstreamProcessor(),
+          m_pIndex(pIndex),
+          m_nFirstFrame(nFirstFrame),
+          m_nNumFrames(nNumFrames),
+          m_nReadFrames(0),
+          m_bSeekDone(false) {}
+
+mfxStatus ChunkBitstreamProcessor::GetInputBitstream(mfxBitstreamWrapper** pBitstream) {
+    if (!m_pFileReader.get() || !m_pIndex)
+        return MFX_ERR_UNSUPPORTED;
+
+    if (!m_bSeekDone) {
+        if (m_nFirstFrame >= m_pIndex->GetEntries().size())
+            return MFX_ERR_MORE_DATA;
+        // the parameter sets of the first frame are read in front of it
+        mfxStatus sts = m_pIndex->Seek(*m_pFileReader, m_pIndex->GetEntries()[m_nFirstFrame]);
+        MSDK_CHECK_STATUS(sts, "m_pIndex->Seek failed");
+        m_bSeekDone = true;
+    }
+
+    // the end of the chunk is the end of the stream for the decoder
+    if (m_nReadFrames == m_nNumFrames)
+        return MFX_ERR_MORE_DATA;
+
+    mfxStatus sts = FileBitstreamProcessor::GetInputBitstream(pBitstream);
+    if (MFX_ERR_NONE == sts)
+        m_nReadFrames++;
+    return sts;
+}
+
+mfxStatus ChunkBitstreamProcessor::ResetInput() {
+    m_nReadFrames = 0;
+    m_bSeekDone   = false;
+    return FileBitstreamProcessor::ResetInput();
+}
+
 void CTranscodingPipeline::ModifyParamsUsingPresets(sInputParams& params,
                                                     mfxF64 fps,
                                                     mfxU32 width,
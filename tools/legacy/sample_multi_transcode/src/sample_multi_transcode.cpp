@@ -10,6 +10,7 @@
 #endif
 
 #include "sample_multi_transcode.h"
+#include "task_scheduler.h"
 
 #if defined(LIBVA_WAYLAND_SUPPORT)
     #include "class_wayland.h"
@@ -19,7 +20,7 @@
     #error MFX_VERSION not defined
 #endif
 
-#include <future>
+#include <algorithm>
 #include <iomanip>
 #include <memory>
 
@@ -31,6 +32,9 @@ Launcher::Launcher()
           m_pThreadContextArray(),
           m_pAllocArray(),
           m_InputParamsArray(),
+          m_SessionLines(),
+          m_ChunkedOutputs(),
+          m_NumaMemoryUsage(),
           m_pBufferArray(),
           m_pExtBSProcArray(),
           m_pAllocParams(),
@@ -78,12 +82,20 @@ mfxStatus Launcher::Init(int argc, msdk_char* argv[]) {
     }
 
     // get parameters for each session from parser
-    mfxU32 id = DecoderTargetID;
     while (m_parser.GetNextSessionParams(InputParams)) {
-        InputParams.TargetID = id++;
+        m_SessionLines.push_back((mfxU32)m_InputParamsArray.size());
         m_InputParamsArray.push_back(InputParams);
     }
 
+    // chunked inputs are transcoded by a session per chunk
+    sts = SplitInputsIntoChunks();
+    MSDK_CHECK_STATUS(sts, "SplitInputsIntoChunks failed");
+
+    mfxU32 id = DecoderTargetID;
+    for (i = 0; i < m_InputParamsArray.size(); i++) {
+        m_InputParamsArray[i].TargetID = id++;
+    }
+
     m_CSConfig.Tracer = &m_Tracer;
 
     // check correctness of input parameters
@@ -321,11 +333,14 @@ mfxStatus Launcher::Init(int argc, msdk_char* argv[]) {
 #endif
     }
     if (m_pAllocParams.empty()) {
-        m_pAllocParams.push_back(std::make_shared<mfxAllocatorParams>());
-        hdls.push_back(NULL);
-
-        for (i = 1; i < m_InputParamsArray.size(); i++) {
-            m_pAllocParams.push_back(m_pAllocParams.back());
+        // system memory surfaces, the arena settings are per session
+        for (i = 0; i < m_InputParamsArray.size(); i++) {
+            auto pAllocParam       = std::make_shared<SysMemAllocatorParams>();
+            pAllocParam->bUseArena = m_InputParamsArray[i].bSysMemArena;
+            pAllocParam->HugePages = m_InputParamsArray[i].SysMemHugePagesMode;
+            pAllocParam->bPrefault = m_InputParamsArray[i].bSysMemPrefault;
+            pAllocParam->NumaNode  = m_InputParamsArray[i].NumaNode;
+            m_pAllocParams.push_back(pAllocParam);
             hdls.push_back(NULL);
         }
     }
@@ -354,6 +369,10 @@ mfxStatus Launcher::Init(int argc, msdk_char* argv[]) {
     // create sessions, allocators
     for (i = 0; i < m_InputParamsArray.size(); i++) {
         msdk_printf(MSDK_STRING("Session %d:\n"), (int)i);
+
+        // the buffers the session touches at initialization are taken from its node
+        msdk_numa_set_preferred_node(m_InputParamsArray[i].NumaNode);
+
         auto pAllocator = std::make_unique<GeneralAllocator>();
         sts             = pAllocator->Init(m_pAllocParams[i].get());
         MSDK_CHECK_STATUS(sts, "pAllocator->Init failed");
@@ -362,7 +381,15 @@ mfxStatus Launcher::Init(int argc, msdk_char* argv[]) {
 
         auto pThreadPipeline = std::make_unique<ThreadTranscodeContext>();
         // extend BS processing init
-        m_pExtBSProcArray.push_back(std::make_unique<FileBitstreamProcessor>());
+        if (m_InputParamsArray[i].pChunkIndex) {
+            m_pExtBSProcArray.push_back(
+                std::make_unique<ChunkBitstreamProcessor>(m_InputParamsArray[i].pChunkIndex,
+                                                          m_InputParamsArray[i].nChunkFirstFrame,
+                                                          m_InputParamsArray[i].nChunkFrames));
+        }
+        else {
+            m_pExtBSProcArray.push_back(std::make_unique<FileBitstreamProcessor>());
+        }
 
         pThreadPipeline->pPipeline.reset(CreatePipeline());
 
@@ -372,9 +399,30 @@ mfxStatus Launcher::Init(int argc, msdk_char* argv[]) {
 
         pThreadPipeline->pBSProcessor = m_pExtBSProcArray.back().get();
 
+        pThreadPipeline->numaNode = m_InputParamsArray[i].NumaNode;
+        pThreadPipeline->cpus     = m_InputParamsArray[i].NumaCpus;
+        if (pThreadPipeline->cpus.empty() && m_InputParamsArray[i].NumaNode >= 0) {
+            sts = msdk_numa_get_node_cpus(m_InputParamsArray[i].NumaNode, pThreadPipeline->cpus);
+            MSDK_CHECK_STATUS(sts, "msdk_numa_get_node_cpus failed");
+            if (pThreadPipeline->cpus.empty()) {
+                PrintError(MSDK_STRING("NUMA node %d has no CPUs, set them with -cpus\n"),
+                           m_InputParamsArray[i].NumaNode);
+                return MFX_ERR_UNSUPPORTED;
+            }
+        }
+
         std::unique_ptr<CSmplBitstreamReader> reader;
         std::unique_ptr<CSmplYUVReader> yuvreader;
-        if (m_InputParamsArray[i].DecodeId == MFX_CODEC_VP9 ||
+        if (m_InputParamsArray[i].pChunkIndex) {
+            // chunks are read frame by frame by the reader the stream index is built with
+            sts = CStreamIndex::CreateFrameReader(m_InputParamsArray[i].strSrcFile,
+                                                  m_InputParamsArray[i].DecodeId,
+                                                  reader);
+            MSDK_CHECK_STATUS(sts, "CStreamIndex::CreateFrameReader failed");
+            sts = m_pExtBSProcArray.back()->SetReader(reader);
+            MSDK_CHECK_STATUS(sts, "m_pExtBSProcArray.back()->SetReader failed");
+        }
+        else if (m_InputParamsArray[i].DecodeId == MFX_CODEC_VP9 ||
             m_InputParamsArray[i].DecodeId == MFX_CODEC_VP8 ||
             m_InputParamsArray[i].DecodeId == MFX_CODEC_AV1) {
             reader.reset(new CIVFFrameReader());
@@ -383,7 +431,11 @@ mfxStatus Launcher::Init(int argc, msdk_char* argv[]) {
                  m_InputParamsArray[i].DecodeId == MFX_CODEC_I420 ||
                  m_InputParamsArray[i].DecodeId == MFX_CODEC_NV12) {
             // YUV reader for RGB4 overlay and raw input
-            yuvreader.reset(new CSmplYUVReader());
+            CPrefetchYUVReader* prefetchReader = new CPrefetchYUVReader();
+            // the overlay is read once, there is nothing to read ahead
+            if (m_InputParamsArray[i].DecodeId != MFX_CODEC_RGB4)
+                prefetchReader->SetPrefetchDepth(m_InputParamsArray[i].nPrefetchDepth);
+            yuvreader.reset(prefetchReader);
         }
         else {
             reader.reset(new CSmplBitstreamReader());
@@ -392,8 +444,11 @@ mfxStatus Launcher::Init(int argc, msdk_char* argv[]) {
         if (reader.get()) {
             sts = reader->Init(m_InputParamsArray[i].strSrcFile);
             if (sts == MFX_ERR_UNSUPPORTED && m_InputParamsArray[i].DecodeId == MFX_CODEC_AV1) {
-                reader.reset(new CSmplBitstreamReader());
-                msdk_printf(MSDK_STRING("WARNING: Stream is not IVF, default reader\n"));
+                // AV1 streams without a container are read by temporal units
+                reader.reset(new CAV1FrameReader());
+                msdk_printf(
+                    MSDK_STRING("WARNING: Stream is not IVF, reading AV1 temporal units\n"));
+                sts = reader->Init(m_InputParamsArray[i].strSrcFile);
             }
             MSDK_CHECK_STATUS(sts, "reader->Init failed");
             sts = m_pExtBSProcArray.back()->SetReader(reader);
@@ -412,7 +467,12 @@ mfxStatus Launcher::Init(int argc, msdk_char* argv[]) {
                          m_InputParamsArray[i].strDstFile,
                          msdk_strlen(MSDK_STRING("null")))) {
             auto writer = std::make_unique<CSmplBitstreamWriter>();
-            sts         = writer->Init(m_InputParamsArray[i].strDstFile);
+            if (m_InputParamsArray[i].bAsyncWrite) {
+                AsyncWriteParams params = CAsyncFileWriter::GetDefaultParams();
+                params.Sync             = m_InputParamsArray[i].AsyncWriteSyncMode;
+                writer->EnableAsyncWrite(params);
+            }
+            sts = writer->Init(m_InputParamsArray[i].strDstFile);
 
             sts = m_pExtBSProcArray.back()->SetWriter(writer);
             MSDK_CHECK_STATUS(sts, "m_pExtBSProcArray.back()->SetWriter failed");
@@ -502,6 +562,7 @@ mfxStatus Launcher::Init(int argc, msdk_char* argv[]) {
 
         PrintInfo(i, &m_InputParamsArray[i], &ver);
     }
+    msdk_numa_set_preferred_node(-1);
 
     if (m_InputParamsArray[0].forceSyncAllSession == MFX_CODINGOPTION_ON) {
         auto maxNumFrameForAllocIter = std::max_element(
@@ -552,100 +613,129 @@ void Launcher::Run() {
         DoTranscoding();
     }
 
+    // the surfaces and buffers are still allocated
+    for (const auto& context : m_pThreadContextArray) {
+        if (context->numaNode >= 0 || !context->cpus.empty()) {
+            if (msdk_numa_get_process_memory(m_NumaMemoryUsage) != MFX_ERR_NONE)
+                m_NumaMemoryUsage.clear();
+            break;
+        }
+    }
+
     msdk_printf(MSDK_STRING("\nTranscoding finished\n"));
 
 } // mfxStatus Launcher::Init()
 
 void Launcher::DoTranscoding() {
-    auto RunTranscodeRoutine = [](ThreadTranscodeContext* context) {
-        context->handle = std::async(std::launch::async, [context]() {
-            context->TranscodeRoutine();
-        });
-    };
+    // The sessions which transcode their own streams run step by step on the pool, the ones
+    // exchanging frames through the safety buffers or placed on CPUs block in their steps
+    // and keep a thread of their own
+    CTaskScheduler scheduler;
+    if (m_InputParamsArray[0].bSchedulerPool) {
+        mfxStatus sts = scheduler.Start(m_InputParamsArray[0].nSchedulerWorkers);
+        MSDK_CHECK_STATUS_NO_RET(sts, "CTaskScheduler::Start failed, a thread per session is used");
+    }
 
-    bool isOverlayUsed = false;
-    for (const auto& context : m_pThreadContextArray) {
+    bool isOverlayUsed             = false;
+    mfxU32 aliveNonOverlaySessions = 0;
+    for (mfxU32 i = 0; i < m_pThreadContextArray.size(); i++) {
+        ThreadTranscodeContext* context = m_pThreadContextArray[i].get();
         MSDK_CHECK_POINTER_NO_RET(context);
-        RunTranscodeRoutine(context.get());
-
         MSDK_CHECK_POINTER_NO_RET(context->pPipeline);
-        isOverlayUsed = isOverlayUsed || context->pPipeline->IsOverlayUsed();
-    }
 
-    // Transcoding threads waiting cycle
-    bool aliveNonOverlaySessions = true;
-    while (aliveNonOverlaySessions) {
-        aliveNonOverlaySessions = false;
+        bool isOverlay = context->pPipeline->IsOverlayUsed();
+        isOverlayUsed  = isOverlayUsed || isOverlay;
+        if (!isOverlay)
+            aliveNonOverlaySessions++;
+
+        bool bPooled = scheduler.IsStarted() && !isOverlay &&
+                       context->pPipeline->IsStepByStepSupported() && context->cpus.empty() &&
+                       context->numaNode < 0;
+        context->pPipeline->SetStepByStep(bPooled);
+        if (bPooled) {
+            // a session of a higher priority transcodes more frames in its turn
+            mfxU32 weight = 1u << std::min<mfxU32>(m_InputParamsArray[i].priority,
+                                                    MFX_PRIORITY_HIGH);
+            scheduler.SubmitDeferrable(
+                i,
+                [context](CTaskScheduler::Clock::time_point& resumeAt) {
+                    mfxStatus sts = context->TranscodeStep();
+                    mfxU32 delay  = context->pPipeline->GetStepDelay();
+                    if (MFX_TASK_WORKING == sts && delay)
+                        resumeAt = CTaskScheduler::Clock::now() + std::chrono::microseconds(delay);
+                    return sts;
+                },
+                weight);
+        }
+        else {
+            scheduler.SubmitDedicated(i, [context]() {
+                context->TranscodeRoutine();
+                return context->transcodingSts;
+            });
+        }
+    }
 
-        for (size_t i = 0; i < m_pThreadContextArray.size(); ++i) {
-            if (!m_pThreadContextArray[i]->handle.valid())
-                continue;
-
-            //Payslip interval to check the state of working threads:
-            //such interval is usually a realtime, i.e. for 30 fps this would be 33ms,
-            //66ms typically mean either 1/fps or 2/fps payslip checks.
-            auto waitSts = m_pThreadContextArray[i]->handle.wait_for(std::chrono::milliseconds(66));
-            if (waitSts == std::future_status::ready) {
-                // Invoke get() of the handle just to reset the valid state.
-                // This allows to skip already processed sessions
-                m_pThreadContextArray[i]->handle.get();
-
-                // Session is completed, let's check for its status
-                if (m_pThreadContextArray[i]->transcodingSts < MFX_ERR_NONE) {
-                    // Stop all the sessions if an error happened in one
-                    // But do not stop in robust mode when gpu hang's happened
-                    if (m_pThreadContextArray[i]->transcodingSts != MFX_ERR_GPU_HANG ||
-                        !m_pThreadContextArray[i]->pPipeline->GetRobustFlag()) {
-                        msdk_stringstream ss;
-                        ss << MSDK_STRING("\n\n session ") << i << MSDK_STRING(" [")
-                           << m_pThreadContextArray[i]->pPipeline->GetSessionText()
-                           << MSDK_STRING("] failed with status ")
-                           << StatusToString(m_pThreadContextArray[i]->transcodingSts)
-                           << MSDK_STRING(" shutting down the application...") << std::endl
-                           << std::endl;
-                        msdk_printf(MSDK_STRING("%s"), ss.str().c_str());
-
-                        for (const auto& context : m_pThreadContextArray) {
-                            context->pPipeline->StopSession();
-                        }
-                    }
-                }
-                else if (m_pThreadContextArray[i]->transcodingSts > MFX_ERR_NONE) {
-                    msdk_stringstream ss;
-                    ss << MSDK_STRING("\n\n session ") << i << MSDK_STRING(" [")
-                       << m_pThreadContextArray[i]->pPipeline->GetSessionText()
-                       << MSDK_STRING("] returned warning status ")
-                       << StatusToString(m_pThreadContextArray[i]->transcodingSts) << std::endl
-                       << std::endl;
-                    msdk_printf(MSDK_STRING("%s"), ss.str().c_str());
-                }
-            }
-            else {
-                aliveNonOverlaySessions = aliveNonOverlaySessions ||
-                                          !m_pThreadContextArray[i]->pPipeline->IsOverlayUsed();
+    // Stop overlay sessions
+    // Note: Overlay sessions never stop themselves so they should be forcibly stopped
+    // after stopping of all non-overlay sessions
+    auto StopOverlaySessions = [this]() {
+        for (const auto& context : m_pThreadContextArray) {
+            if (context->pPipeline->IsOverlayUsed()) {
+                context->pPipeline->StopSession();
             }
         }
+    };
+    if (!aliveNonOverlaySessions && isOverlayUsed)
+        StopOverlaySessions();
+
+    // Transcoding sessions waiting cycle, the sessions are reported as they complete
+    for (;;) {
+        mfxU32 i         = 0;
+        mfxStatus result = MFX_ERR_NONE;
+        mfxStatus sts    = scheduler.WaitForCompletion(MSDK_WAIT_INTERVAL, &i, &result);
+        if (MFX_ERR_NOT_FOUND == sts)
+            break;
+        if (MFX_ERR_NONE != sts)
+            continue;
 
-        // Stop overlay sessions
-        // Note: Overlay sessions never stop themselves so they should be forcibly stopped
-        // after stopping of all non-overlay sessions
-        if (!aliveNonOverlaySessions && isOverlayUsed) {
-            // Sending stop message
-            for (const auto& context : m_pThreadContextArray) {
-                if (context->pPipeline->IsOverlayUsed()) {
+        // Session is completed, let's check for its status
+        if (m_pThreadContextArray[i]->transcodingSts < MFX_ERR_NONE) {
+            // Stop all the sessions if an error happened in one
+            // But do not stop in robust mode when gpu hang's happened
+            if (m_pThreadContextArray[i]->transcodingSts != MFX_ERR_GPU_HANG ||
+                !m_pThreadContextArray[i]->pPipeline->GetRobustFlag()) {
+                msdk_stringstream ss;
+                ss << MSDK_STRING("\n\n session ") << i << MSDK_STRING(" [")
+                   << m_pThreadContextArray[i]->pPipeline->GetSessionText()
+                   << MSDK_STRING("] failed with status ")
+                   << StatusToString(m_pThreadContextArray[i]->transcodingSts)
+                   << MSDK_STRING(" shutting down the application...") << std::endl
+                   << std::endl;
+                msdk_printf(MSDK_STRING("%s"), ss.str().c_str());
+
+                for (const auto& context : m_pThreadContextArray) {
                     context->pPipeline->StopSession();
                 }
             }
-
-            // Waiting for them to be stopped
-            for (const auto& context : m_pThreadContextArray) {
-                if (!context->handle.valid())
-                    continue;
-
-                context->handle.wait();
-            }
         }
+        else if (m_pThreadContextArray[i]->transcodingSts > MFX_ERR_NONE) {
+            msdk_stringstream ss;
+            ss << MSDK_STRING("\n\n session ") << i << MSDK_STRING(" [")
+               << m_pThreadContextArray[i]->pPipeline->GetSessionText()
+               << MSDK_STRING("] returned warning status ")
+               << StatusToString(m_pThreadContextArray[i]->transcodingSts) << std::endl
+               << std::endl;
+            msdk_printf(MSDK_STRING("%s"), ss.str().c_str());
+        }
+
+        if (!m_pThreadContextArray[i]->pPipeline->IsOverlayUsed() && !--aliveNonOverlaySessions &&
+            isOverlayUsed)
+            StopOverlaySessions();
     }
+
+    if (scheduler.IsStarted())
+        scheduler.PrintStatistics(MSDK_STRING("\nScheduler:"));
+    scheduler.Stop();
 }
 
 void Launcher::DoRobustTranscoding() {
@@ -681,9 +771,181 @@ void Launcher::DoRobustTranscoding() {
     }
 }
 
+mfxStatus Launcher::SplitInputsIntoChunks() {
+    std::vector<sInputParams> sessions;
+    std::vector<mfxU32> lines;
+
+    for (mfxU32 i = 0; i < m_InputParamsArray.size(); i++) {
+        const sInputParams& params = m_InputParamsArray[i];
+        if (params.nChunks <= 1) {
+            sessions.push_back(params);
+            lines.push_back(m_SessionLines[i]);
+            continue;
+        }
+
+        // the chunks start with key frames of the input and the outputs of the encoders are
+        // elementary streams starting with the sequence headers, so they can be concatenated
+        bool supportedInput = params.DecodeId == MFX_CODEC_AVC ||
+                              params.DecodeId == MFX_CODEC_HEVC ||
+                              params.DecodeId == MFX_CODEC_VP9 || params.DecodeId == MFX_CODEC_AV1;
+        bool supportedOutput = params.EncodeId == MFX_CODEC_AVC ||
+                               params.EncodeId == MFX_CODEC_HEVC ||
+                               params.EncodeId == MFX_CODEC_MPEG2;
+        if (params.eMode != Native || params.eModeExt != Native || !supportedInput ||
+            !supportedOutput || params.bIsMVC || params.MaxFrameNumber != MFX_INFINITE) {
+            PrintError(MSDK_STRING(
+                "-chunks is supported for sessions with own h264|h265|vp9|av1 input and h264|h265|mpeg2 output without -n\n"));
+            return MFX_ERR_UNSUPPORTED;
+        }
+
+        auto index    = std::make_shared<CStreamIndex>();
+        mfxStatus sts = index->Init(params.strSrcFile, params.DecodeId);
+        MSDK_CHECK_STATUS(sts, "index->Init failed");
+
+        std::vector<mfxU32> starts = index->GetChunkStarts(params.nChunks);
+        if (starts.empty()) {
+            PrintError(MSDK_STRING("no frames are found in %s\n"), params.strSrcFile);
+            return MFX_ERR_MORE_DATA;
+        }
+        if (starts.size() < params.nChunks) {
+            msdk_printf(
+                MSDK_STRING("WARNING: input of session %d has %d chunks starting with closed GOPs\n"),
+                (int)i,
+                (int)starts.size());
+        }
+        starts.push_back((mfxU32)index->GetEntries().size());
+
+        bool nullOutput = !msdk_strlen(params.strDstFile) ||
+                          !msdk_strncmp(MSDK_STRING("null"),
+                                        params.strDstFile,
+                                        msdk_strlen(MSDK_STRING("null")));
+        ChunkedOutput output;
+        for (mfxU32 chunk = 0; chunk + 1 < starts.size(); chunk++) {
+            sInputParams chunkParams     = params;
+            chunkParams.pChunkIndex      = index;
+            chunkParams.nChunkFirstFrame = starts[chunk];
+            chunkParams.nChunkFrames     = starts[chunk + 1] - starts[chunk];
+
+            // the first chunk is written to the output file, the next ones are appended to it
+            if (!nullOutput) {
+                msdk_stringstream name;
+                name << params.strDstFile;
+                if (chunk)
+                    name << MSDK_STRING(".chunk") << chunk;
+                if (name.str().size() >= MSDK_MAX_FILENAME_LEN) {
+                    PrintError(MSDK_STRING("output file name %s is too long\n"),
+                               name.str().c_str());
+                    return MFX_ERR_UNSUPPORTED;
+                }
+                msdk_strcopy(chunkParams.strDstFile, name.str().c_str());
+                output.Sessions.push_back((mfxU32)sessions.size());
+                output.Files.push_back(name.str());
+            }
+            sessions.push_back(chunkParams);
+            lines.push_back(m_SessionLines[i]);
+        }
+        if (!output.Files.empty())
+            m_ChunkedOutputs.push_back(output);
+
+        msdk_printf(MSDK_STRING("Input of session %d is split into %d chunks\n"),
+                    (int)i,
+                    (int)starts.size() - 1);
+    }
+
+    m_InputParamsArray = sessions;
+    m_SessionLines     = lines;
+    return MFX_ERR_NONE;
+}
+
+static mfxStatus AppendFile(FILE* pDstFile, const msdk_char* strFileName) {
+    FILE* pSrcFile = NULL;
+    MSDK_FOPEN(pSrcFile, strFileName, MSDK_STRING("rb"));
+    MSDK_CHECK_POINTER(pSrcFile, MFX_ERR_NOT_FOUND);
+
+    mfxStatus sts = MFX_ERR_NONE;
+    std::vector<mfxU8> buffer(1024 * 1024);
+    for (;;) {
+        size_t size = fread(buffer.data(), 1, buffer.size(), pSrcFile);
+        if (!size)
+            break;
+        if (fwrite(buffer.data(), 1, size, pDstFile) != size) {
+            sts = MFX_ERR_UNDEFINED_BEHAVIOR;
+            break;
+        }
+    }
+    if (ferror(pSrcFile))
+        sts = MFX_ERR_UNDEFINED_BEHAVIOR;
+
+    fclose(pSrcFile);
+    return sts;
+}
+
+mfxStatus Launcher::JoinChunkOutputs() {
+    mfxStatus sts = MFX_ERR_NONE;
+
+    for (const ChunkedOutput& output : m_ChunkedOutputs) {
+        // the chunk files are complete when the writers are closed
+        bool bCompleted = true;
+        for (mfxU32 i : output.Sessions) {
+            if (m_pExtBSProcArray[i]->CloseOutput() != MFX_ERR_NONE ||
+                m_pThreadContextArray[i]->transcodingSts < MFX_ERR_NONE)
+                bCompleted = false;
+        }
+        // the sessions report their errors
+        if (!bCompleted) {
+            msdk_printf(MSDK_STRING("WARNING: chunks of %s are not joined\n"),
+                        output.Files[0].c_str());
+            continue;
+        }
+
+        FILE* pDstFile = NULL;
+        MSDK_FOPEN(pDstFile, output.Files[0].c_str(), MSDK_STRING("ab"));
+        if (!pDstFile) {
+            msdk_printf(MSDK_STRING("ERROR: can't open %s\n"), output.Files[0].c_str());
+            sts = MFX_ERR_NOT_FOUND;
+            continue;
+        }
+        for (size_t chunk = 1; chunk < output.Files.size(); chunk++) {
+            mfxStatus appendSts = AppendFile(pDstFile, output.Files[chunk].c_str());
+            if (appendSts != MFX_ERR_NONE) {
+                msdk_printf(MSDK_STRING("ERROR: failed to append %s to %s\n"),
+                            output.Files[chunk].c_str(),
+                            output.Files[0].c_str());
+                sts = appendSts;
+                break;
+            }
+            msdk_remove(output.Files[chunk].c_str());
+        }
+        if (fclose(pDstFile) && sts == MFX_ERR_NONE)
+            sts = MFX_ERR_UNDEFINED_BEHAVIOR;
+
+        if (sts == MFX_ERR_NONE)
+            msdk_printf(MSDK_STRING("%d chunks are joined into %s\n"),
+                        (int)output.Files.size(),
+                        output.Files[0].c_str());
+    }
+    return sts;
+}
+
+static void PrintLatencies(msdk_stringstream& ss,
+                           const msdk_char* prefix,
+                           const CLatencyHistogram& latencies) {
+    ss << prefix << latencies.GetCount() << MSDK_STRING(" samples") << std::fixed
+       << std::setprecision(3) << MSDK_STRING(", Avg ") << latencies.GetMean() * 1000
+       << MSDK_STRING(", Min ") << latencies.GetMin() * 1000 << MSDK_STRING(", P50 ")
+       << latencies.GetPercentile(50) * 1000 << MSDK_STRING(", P90 ")
+       << latencies.GetPercentile(90) * 1000 << MSDK_STRING(", P99 ")
+       << latencies.GetPercentile(99) * 1000 << MSDK_STRING(", P99.9 ")
+       << latencies.GetPercentile(99.9) * 1000 << MSDK_STRING(", Max ")
+       << latencies.GetMax() * 1000 << std::endl;
+}
+
 mfxStatus Launcher::ProcessResult() {
     FILE* pPerfFile = m_parser.GetPerformanceFile();
 
+    // joining the chunks is a part of the transcoding time
+    mfxStatus JoinSts = JoinChunkOutputs();
+
     msdk_stringstream ssTranscodingTime;
     ssTranscodingTime << std::endl
                       << MSDK_STRING("Common transcoding time is ") << GetTime(m_StartTime)
@@ -696,7 +958,7 @@ mfxStatus Launcher::ProcessResult() {
         msdk_fprintf(pPerfFile, MSDK_STRING("%s"), ssTranscodingTime.str().c_str());
     }
 
-    mfxStatus FinalSts = MFX_ERR_NONE;
+    mfxStatus FinalSts = JoinSts;
     msdk_printf(MSDK_STRING(
         "-------------------------------------------------------------------------------\n"));
 
@@ -717,9 +979,15 @@ mfxStatus Launcher::ProcessResult() {
            << SessionStsStr << MSDK_STRING(" (") << StatusToString(transcodingSts)
            << MSDK_STRING(") ") << workTime << MSDK_STRING(" sec, ") << framesNum
            << MSDK_STRING(" frames, ") << std::fixed << std::setprecision(3) << framesNum / workTime
-           << MSDK_STRING(" fps") << std::endl
-           << m_parser.GetLine(i) << std::endl
-           << std::endl;
+           << MSDK_STRING(" fps") << std::endl;
+        // frames encoded while an earlier one was still in execution
+        const CTranscodingPipeline* pPipeline = m_pThreadContextArray[i]->pPipeline.get();
+        if (pPipeline->GetOutOfOrderTasks() || pPipeline->GetOldestTaskWaits()) {
+            ss << MSDK_STRING("    encoder: ") << pPipeline->GetOutOfOrderTasks()
+               << MSDK_STRING(" frames completed out of order, ") << pPipeline->GetOldestTaskWaits()
+               << MSDK_STRING(" waits for the oldest frame") << std::endl;
+        }
+        ss << m_parser.GetLine(m_SessionLines[i]) << std::endl << std::endl;
 
         msdk_printf(MSDK_STRING("%s"), ss.str().c_str());
         if (pPerfFile) {
@@ -729,6 +997,40 @@ mfxStatus Launcher::ProcessResult() {
     msdk_printf(MSDK_STRING(
         "-------------------------------------------------------------------------------\n"));
 
+    // frame latencies of all sessions, the sessions gather them with -stat only
+    CLatencyHistogram inputLatencies, outputLatencies;
+    for (mfxU32 i = 0; i < m_pThreadContextArray.size(); i++) {
+        inputLatencies.Merge(m_pThreadContextArray[i]->pPipeline->GetInputLatencies());
+        outputLatencies.Merge(m_pThreadContextArray[i]->pPipeline->GetOutputLatencies());
+    }
+    if (inputLatencies.GetCount() || outputLatencies.GetCount()) {
+        msdk_stringstream ss;
+        ss << MSDK_STRING("Frame latency of all sessions, ms:") << std::endl;
+        PrintLatencies(ss, MSDK_STRING("  Input:  "), inputLatencies);
+        PrintLatencies(ss, MSDK_STRING("  Output: "), outputLatencies);
+
+        msdk_printf(MSDK_STRING("%s"), ss.str().c_str());
+        if (pPerfFile) {
+            msdk_fprintf(pPerfFile, MSDK_STRING("%s"), ss.str().c_str());
+        }
+    }
+
+    if (!m_NumaMemoryUsage.empty()) {
+        msdk_stringstream ss;
+        ss << MSDK_STRING("Memory usage per NUMA node:");
+        for (size_t node = 0; node < m_NumaMemoryUsage.size(); node++) {
+            ss << MSDK_STRING(" node ") << node << MSDK_STRING(" ") << std::fixed
+               << std::setprecision(1) << m_NumaMemoryUsage[node] / (1024.0 * 1024.0)
+               << MSDK_STRING(" MB");
+        }
+        ss << std::endl;
+
+        msdk_printf(MSDK_STRING("%s"), ss.str().c_str());
+        if (pPerfFile) {
+            msdk_fprintf(pPerfFile, MSDK_STRING("%s"), ss.str().c_str());
+        }
+    }
+
     msdk_stringstream ssTest;
     ssTest << std::endl
            << MSDK_STRING("The test ")
@@ -1061,10 +1363,28 @@ mfxStatus Launcher::CreateSafetyBuffers() {
     SafetySurfaceBuffer* pBuffer     = NULL;
     SafetySurfaceBuffer* pPrevBuffer = NULL;
 
+    // In the 1 to N case the sinks read the frames of the decoder from one ring unless the
+    // cascade scaler gives every sink frames of its own
+    std::shared_ptr<SafetySurfaceBuffer::SurfaceRing> pSharedRing;
+    mfxU32 numSinks     = 0;
+    bool bCascadeScaler = false;
+    for (const sInputParams& params : m_InputParamsArray) {
+        if (Source == params.eMode) {
+            numSinks++;
+            bCascadeScaler |= params.CascadeScaler;
+        }
+    }
+    if (numSinks && Native == m_InputParamsArray[0].eModeExt && !bCascadeScaler &&
+        numSinks <= SafetySurfaceBuffer::SurfaceRing::MaxConsumers) {
+        pSharedRing = SafetySurfaceBuffer::CreateRing(numSinks);
+    }
+    mfxU32 consumer = 0;
+
     for (mfxU32 i = 0; i < m_InputParamsArray.size(); i++) {
         /* this is for 1 to N case*/
         if ((Source == m_InputParamsArray[i].eMode) && (Native == m_InputParamsArray[0].eModeExt)) {
-            pBuffer           = new SafetySurfaceBuffer(pPrevBuffer);
+            pBuffer = pSharedRing ? new SafetySurfaceBuffer(pPrevBuffer, pSharedRing, consumer++)
+                                  : new SafetySurfaceBuffer(pPrevBuffer);
             pBuffer->TargetID = m_InputParamsArray[i].TargetID;
             pPrevBuffer       = pBuffer;
             m_pBufferArray.push_back((std::unique_ptr<SafetySurfaceBuffer>(pBuffer)));
@@ -1505,6 +1825,12 @@ void SMTTracer::WriteEventName(std::ofstream& trace_file, const Event ev) {
     if (ev.EvType == EventType::FlowStart || ev.EvType == EventType::FlowEnd) {
         trace_file << "link";
     }
+    else if (ev.EvType == EventType::Counter && ev.Name == EventName::RING_OCCUPANCY) {
+        trace_file << "ring" << ev.ThID;
+    }
+    else if (ev.EvType == EventType::Counter && ev.Name == EventName::RING_STALLS) {
+        trace_file << "ring_stalls" << ev.ThID;
+    }
     else if (ev.EvType == EventType::Counter) {
         switch (ev.ThType) {
             case ThreadType::DEC:
@@ -1571,7 +1897,17 @@ void SMTTracer::WriteEventInOutIDs(std::ofstream& trace_file, const Event ev) {
 }
 
 void SMTTracer::WriteEventCounter(std::ofstream& trace_file, const Event ev) {
-    trace_file << "\"args\":{\"free surfaces\":" << ev.InID << "}";
+    switch (ev.Name) {
+        case EventName::RING_OCCUPANCY:
+            trace_file << "\"args\":{\"frames\":" << ev.InID << "}";
+            break;
+        case EventName::RING_STALLS:
+            trace_file << "\"args\":{\"stalls\":" << ev.InID << "}";
+            break;
+        default:
+            trace_file << "\"args\":{\"free surfaces\":" << ev.InID << "}";
+            break;
+    }
 }
 
 void SMTTracer::WriteEventCategory(std::ofstream& trace_file) {
@@ -124,12 +124,43 @@ void TranscodingSample::PrintHelp() {
     msdk_printf(MSDK_STRING("                 Set input file and decoder type\n"));
     msdk_printf(MSDK_STRING("  -i::i420|nv12 <file-name>\n"));
     msdk_printf(MSDK_STRING("                 Set raw input file and color format\n"));
+    msdk_printf(MSDK_STRING("  -prefetch <frames>\n"));
+    msdk_printf(MSDK_STRING(
+        "                 Read the given number of raw input frames ahead on a separate thread\n"));
+    msdk_printf(MSDK_STRING("  -chunks <N>\n"));
+    msdk_printf(MSDK_STRING(
+        "                 Split the h264|h265|vp9|av1 input at closed GOP key frames into N chunks transcoded by concurrent sessions,\n"));
+    msdk_printf(MSDK_STRING(
+        "                 the h264|h265|mpeg2 outputs of the chunks are joined into the output file. -join makes the sessions joined\n"));
+    msdk_printf(MSDK_STRING("  -sysmem_arena  Allocate system memory surfaces of a session out of large slabs\n"));
+    msdk_printf(MSDK_STRING("  -hugepages:thp|hugetlb\n"));
+    msdk_printf(MSDK_STRING(
+        "                 Back the slabs by transparent huge pages or by reserved huge pages, implies -sysmem_arena\n"));
+    msdk_printf(MSDK_STRING(
+        "  -prefault      Touch the pages of the slabs at allocation so the first frames don't fault, implies -sysmem_arena\n"));
+    msdk_printf(MSDK_STRING("  -numa_node <node>\n"));
+    msdk_printf(MSDK_STRING(
+        "                 Run the session on the CPUs of the NUMA node and take its system memory surfaces and buffers from the node,\n"));
+    msdk_printf(MSDK_STRING(
+        "                 implies -sysmem_arena. Memory usage per node is reported in the end\n"));
+    msdk_printf(MSDK_STRING("  -cpus <list>   Run the session on the CPUs of the list like 0-7,16-23\n"));
+    msdk_printf(MSDK_STRING("  -scheduler:threads|pool\n"));
+    msdk_printf(MSDK_STRING(
+        "                 Run every session on a thread of its own (default) or the sessions transcoding their own streams frame by frame\n"));
+    msdk_printf(MSDK_STRING(
+        "                 on a pool of worker threads, -priority sets the share of the pool. Set in the first session\n"));
+    msdk_printf(MSDK_STRING(
+        "  -workers <N>   Number of worker threads of the pool, the number of CPUs by default\n"));
     msdk_printf(MSDK_STRING(
         "  -i::rgb4_frame Set input rgb4 file for compositon. File should contain just one single frame (-vpp_comp_src_h and -vpp_comp_src_w should be specified as well).\n"));
     msdk_printf(MSDK_STRING("  -o::h265|h264|mpeg2|mvc|jpeg|vp9|av1|raw <file-name>|null\n"));
     msdk_printf(MSDK_STRING("                Set output file and encoder type\n"));
     msdk_printf(MSDK_STRING(
         "                \'null\' keyword as file-name disables output file writing \n"));
+    msdk_printf(MSDK_STRING("  -async_write  Write the output file on a separate thread\n"));
+    msdk_printf(MSDK_STRING("  -datasync:close|always\n"));
+    msdk_printf(MSDK_STRING(
+        "                With -async_write, flush the output file to the storage once on close or after every write\n"));
     msdk_printf(MSDK_STRING("  -sw|-hw|-hw_d3d11|-hw_d3d9\n"));
     msdk_printf(MSDK_STRING("                SDK implementation to use: \n"));
     msdk_printf(MSDK_STRING(
@@ -223,6 +254,8 @@ void TranscodingSample::PrintHelp() {
         "  -join         Join session with other session(s), by default sessions are not joined\n"));
     msdk_printf(MSDK_STRING(
         "  -priority     Use priority for join sessions. 0 - Low, 1 - Normal, 2 - High. Normal by default\n"));
+    msdk_printf(MSDK_STRING(
+        "                With -scheduler:pool the session transcodes 1, 2 or 4 frames in its turn on a worker\n"));
     msdk_printf(MSDK_STRING("  -threads num  Number of session internal threads to create\n"));
     msdk_printf(
         MSDK_STRING("  -n            Number of frames to transcode\n") MSDK_STRING(
@@ -2479,6 +2512,84 @@ mfxStatus CmdProcessor::ParseParamsForOneSession(mfxU32 argc, msdk_char* argv[])
             }
             skipped += 2;
         }
+        else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-prefetch"))) {
+            VAL_CHECK(i + 1 == argc, i, argv[i]);
+            i++;
+            if (MFX_ERR_NONE != msdk_opt_read(argv[i], InputParams.nPrefetchDepth)) {
+                PrintError(MSDK_STRING("-prefetch %s is invalid"), argv[i]);
+                return MFX_ERR_UNSUPPORTED;
+            }
+        }
+        else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-chunks"))) {
+            VAL_CHECK(i + 1 == argc, i, argv[i]);
+            i++;
+            if (MFX_ERR_NONE != msdk_opt_read(argv[i], InputParams.nChunks) ||
+                !InputParams.nChunks) {
+                PrintError(MSDK_STRING("-chunks %s is invalid"), argv[i]);
+                return MFX_ERR_UNSUPPORTED;
+            }
+        }
+        else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-sysmem_arena"))) {
+            InputParams.bSysMemArena = true;
+        }
+        else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-hugepages:thp"))) {
+            InputParams.bSysMemArena        = true;
+            InputParams.SysMemHugePagesMode = SYSMEM_HUGEPAGES_THP;
+        }
+        else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-hugepages:hugetlb"))) {
+            InputParams.bSysMemArena        = true;
+            InputParams.SysMemHugePagesMode = SYSMEM_HUGEPAGES_HUGETLB;
+        }
+        else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-prefault"))) {
+            InputParams.bSysMemArena    = true;
+            InputParams.bSysMemPrefault = true;
+        }
+        else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-numa_node"))) {
+            VAL_CHECK(i + 1 == argc, i, argv[i]);
+            i++;
+            if (MFX_ERR_NONE != msdk_opt_read(argv[i], InputParams.NumaNode) ||
+                InputParams.NumaNode < 0 ||
+                (mfxU32)InputParams.NumaNode >= msdk_numa_get_node_count()) {
+                PrintError(MSDK_STRING("-numa_node %s is invalid, the system has %u nodes"),
+                           argv[i],
+                           msdk_numa_get_node_count());
+                return MFX_ERR_UNSUPPORTED;
+            }
+            InputParams.bSysMemArena = true;
+        }
+        else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-cpus"))) {
+            VAL_CHECK(i + 1 == argc, i, argv[i]);
+            i++;
+            if (MFX_ERR_NONE != msdk_parse_cpu_list(argv[i], InputParams.NumaCpus)) {
+                PrintError(MSDK_STRING("-cpus %s is invalid"), argv[i]);
+                return MFX_ERR_UNSUPPORTED;
+            }
+        }
+        else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-scheduler:threads"))) {
+            InputParams.bSchedulerPool = false;
+        }
+        else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-scheduler:pool"))) {
+            InputParams.bSchedulerPool = true;
+        }
+        else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-workers"))) {
+            VAL_CHECK(i + 1 == argc, i, argv[i]);
+            i++;
+            if (MFX_ERR_NONE != msdk_opt_read(argv[i], InputParams.nSchedulerWorkers) ||
+                !InputParams.nSchedulerWorkers) {
+                PrintError(MSDK_STRING("-workers \"%s\" is invalid"), argv[i]);
+                return MFX_ERR_UNSUPPORTED;
+            }
+            InputParams.bSchedulerPool = true;
+        }
+        else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-async_write"))) {
+            InputParams.bAsyncWrite = true;
+        }
+        else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-datasync:close"))) {
+            InputParams.AsyncWriteSyncMode = ASYNC_WRITE_SYNC_CLOSE;
+        }
+        else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-datasync:always"))) {
+            InputParams.AsyncWriteSyncMode = ASYNC_WRITE_SYNC_ALWAYS;
+        }
         else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-dump"))) {
             VAL_CHECK(i + 1 == argc, i, argv[i]);
             i++;
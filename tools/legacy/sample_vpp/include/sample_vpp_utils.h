@@ -47,6 +47,7 @@
     #include "vpl/mfxvideo.h"
 
     #include "base_allocator.h"
+    #include "frame_prefetcher.h"
     #include "sample_vpp_config.h"
     #include "sample_vpp_roi.h"
 
@@ -204,6 +205,7 @@ struct sInputParams {
     bool bPerf;
     mfxU32 numFrames;
     mfxU16 numRepeat;
+    mfxU32 prefetchDepth; // number of input frames read ahead on a separate thread
     bool isOutput;
     bool ptsCheck;
     bool ptsJump;
@@ -260,6 +262,7 @@ struct sInputParams {
         bPartialAccel       = 0;
         numFrames           = 0;
         numRepeat           = 0;
+        prefetchDepth       = 0;
         isOutput            = false;
         ptsCheck            = false;
         ptsJump             = false;
@@ -360,8 +363,17 @@ public:
 
     mfxStatus LoadNextFrame(mfxFrameData* pData, mfxFrameInfo* pInfo);
 
+    // Number of frames GetNextInputFrame reads ahead on a separate thread, 0 - read on demand
+    void SetPrefetchDepth(mfxU32 depth) {
+        m_prefetchDepth = depth;
+    }
+    const CFramePrefetcher& GetPrefetcher() const {
+        return m_prefetcher;
+    }
+
 private:
     mfxStatus GetPreAllocFrame(mfxFrameSurfaceWrap** pSurface);
+    mfxStatus ReadFrame(mfxFrameData* pData, mfxFrameInfo* pInfo);
 
     FILE* m_fSrc;
     std::list<mfxFrameSurfaceWrap>::iterator m_it;
@@ -371,6 +383,9 @@ private:
 
     PTSMaker* m_pPTSMaker;
     mfxU32 m_initFcc;
+
+    CFramePrefetcher m_prefetcher;
+    mfxU32 m_prefetchDepth;
 };
 
 class CRawVideoWriter {
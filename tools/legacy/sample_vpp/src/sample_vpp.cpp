@@ -443,6 +443,11 @@ int main(int argc, msdk_char* argv[])
         sts = yuvReaders[VPP_IN].Init(Params.strSrcFile, ptsMaker.get(), Params.fccSource);
         MSDK_CHECK_STATUS(sts, "yuvReaders[VPP_IN].Init failed");
     }
+    // frames read ahead can't follow the input format changes made by -reset_start
+    if (!Params.bPerf && Params.resetFrmNums.empty()) {
+        for (int i = 0; i < Resources.numSrcFiles; i++)
+            yuvReaders[i].SetPrefetchDepth(Params.prefetchDepth);
+    }
     ownToMfxFrameInfo(&(Params.frameInfoOut[0]), &realFrameInfoOut);
 
     if (!Params.strDstFiles.empty()) {
@@ -909,6 +914,10 @@ int main(int argc, msdk_char* argv[])
     msdk_printf(MSDK_STRING("Total frames %d \n"), nFrames);
     msdk_printf(MSDK_STRING("Total time %.2f sec \n"), statTimer.GetTotalTime());
     msdk_printf(MSDK_STRING("Frames per second %.3f fps \n"), nFrames / statTimer.GetTotalTime());
+    if (Params.prefetchDepth && !Params.bPerf && Params.resetFrmNums.empty()) {
+        for (int i = 0; i < Resources.numSrcFiles; i++)
+            yuvReaders[i].GetPrefetcher().PrintStatistics(MSDK_STRING("Input prefetch:"));
+    }
 
     PutPerformanceToFile(Params, nFrames / statTimer.GetTotalTime());
 
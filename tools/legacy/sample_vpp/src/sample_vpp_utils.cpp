@@ -846,7 +846,9 @@ CRawVideoReader::CRawVideoReader()
           m_isPerfMode(false),
           m_Repeat(0),
           m_pPTSMaker(NULL),
-          m_initFcc(0) {}
+          m_initFcc(0),
+          m_prefetcher(),
+          m_prefetchDepth(0) {}
 
 mfxStatus CRawVideoReader::Init(const msdk_char* strFileName, PTSMaker* pPTSMaker, mfxU32 fcc) {
     Close();
@@ -866,6 +868,8 @@ CRawVideoReader::~CRawVideoReader() {
 }
 
 void CRawVideoReader::Close() {
+    // the read ahead thread uses the file
+    m_prefetcher.Stop();
     if (m_fSrc != 0) {
         fclose(m_fSrc);
         m_fSrc = 0;
@@ -1310,7 +1314,7 @@ mfxStatus CRawVideoReader::GetNextInputFrame(sMemoryAllocator* pAllocator,
                                                   pCurSurf->Data.MemId,
                                                   &pCurSurf->Data);
             MFX_CHECK_STS(sts);
-            sts = LoadNextFrame(&pCurSurf->Data, pInfo);
+            sts = ReadFrame(&pCurSurf->Data, pInfo);
             MFX_CHECK_STS(sts);
             sts = pAllocator->pMfxAllocator->Unlock(pAllocator->pMfxAllocator->pthis,
                                                     pCurSurf->Data.MemId,
@@ -1318,7 +1322,7 @@ mfxStatus CRawVideoReader::GetNextInputFrame(sMemoryAllocator* pAllocator,
             MFX_CHECK_STS(sts);
         }
         else {
-            sts = LoadNextFrame(&pCurSurf->Data, pInfo);
+            sts = ReadFrame(&pCurSurf->Data, pInfo);
             MFX_CHECK_STS(sts);
         }
     }
@@ -1335,6 +1339,32 @@ mfxStatus CRawVideoReader::GetNextInputFrame(sMemoryAllocator* pAllocator,
     return MFX_ERR_NONE;
 }
 
+mfxStatus CRawVideoReader::ReadFrame(mfxFrameData* pData, mfxFrameInfo* pInfo) {
+    if (!m_prefetchDepth)
+        return LoadNextFrame(pData, pInfo);
+
+    MSDK_CHECK_POINTER(pData, MFX_ERR_NOT_INITIALIZED);
+    MSDK_CHECK_POINTER(pInfo, MFX_ERR_NOT_INITIALIZED);
+
+    if (!m_prefetcher.IsStarted()) {
+        mfxStatus sts = m_prefetcher.Start(*pInfo, m_prefetchDepth, [this](mfxFrameSurface1* s) {
+            return LoadNextFrame(&s->Data, &s->Info);
+        });
+        if (MFX_ERR_NONE != sts) {
+            msdk_printf(MSDK_STRING("[WARNING] Input prefetch isn't available, reading frames "
+                                    "synchronously\n"));
+            m_prefetchDepth = 0;
+            return LoadNextFrame(pData, pInfo);
+        }
+    }
+
+    // the frame is copied into the surface given by the caller
+    mfxFrameSurface1 surface = {};
+    surface.Info             = *pInfo;
+    surface.Data             = *pData;
+    return m_prefetcher.LoadNextFrame(&surface);
+}
+
 mfxStatus CRawVideoReader::GetPreAllocFrame(mfxFrameSurfaceWrap** pSurface) {
     if (m_it == m_SurfacesList.end()) {
         m_Repeat--;